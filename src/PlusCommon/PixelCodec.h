@@ -8,6 +8,7 @@ See License.txt for details.
 #define __PixelCodec_h
 
 #include "PlusConfigure.h"
+#include "PixelCodecKernels.h"
 
 #include <iomanip>
 
@@ -142,6 +143,69 @@ public:
     }
   }
 
+  //----------------------------------------------------------------------------
+  static inline unsigned int MakeFourCC(char a, char b, char c, char d)
+  {
+    return static_cast<unsigned int>(static_cast<unsigned char>(a))
+           | (static_cast<unsigned int>(static_cast<unsigned char>(b)) << 8)
+           | (static_cast<unsigned int>(static_cast<unsigned char>(c)) << 16)
+           | (static_cast<unsigned int>(static_cast<unsigned char>(d)) << 24);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the FourCC code that identifies the pixel encoding, 0 if the encoding is unknown */
+  static unsigned int GetFourCC(PixelEncoding encoding)
+  {
+    switch (encoding)
+    {
+      case PixelEncoding_YUY2:
+        return static_cast<unsigned int>(VTK_BI_YUY2);
+      case PixelEncoding_RGB24:
+        return MakeFourCC('R', 'G', 'B', '3');
+      case PixelEncoding_BGR24:
+        return MakeFourCC('B', 'G', 'R', '3');
+      case PixelEncoding_RGBA32:
+        return MakeFourCC('R', 'G', 'B', 'A');
+      case PixelEncoding_MJPG:
+        return MakeFourCC('M', 'J', 'P', 'G');
+      default:
+        return 0;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the pixel encoding from a FourCC code, PixelEncoding_ERROR if the code is unknown */
+  static PixelEncoding GetPixelEncodingFromFourCC(unsigned int fourCC)
+  {
+    const PixelEncoding encodings[] = { PixelEncoding_YUY2, PixelEncoding_RGB24, PixelEncoding_BGR24, PixelEncoding_RGBA32, PixelEncoding_MJPG };
+    for (unsigned int i = 0; i < sizeof(encodings) / sizeof(encodings[0]); ++i)
+    {
+      if (GetFourCC(encodings[i]) == fourCC)
+      {
+        return encodings[i];
+      }
+    }
+    return PixelEncoding_ERROR;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Get the number of bytes per pixel of an uncompressed pixel encoding, 0 for compressed or unknown encodings */
+  static unsigned int GetNumberOfBytesPerPixel(PixelEncoding encoding)
+  {
+    switch (encoding)
+    {
+      case PixelEncoding_YUY2:
+        return 2;
+      case PixelEncoding_RGB24:
+      case PixelEncoding_BGR24:
+        return 3;
+      case PixelEncoding_RGBA32:
+        return 4;
+      default:
+        return 0;
+    }
+  }
+
   //----------------------------------------------------------------------------
   static inline PlusStatus ConvertToGray(int inputCompression, int width, int height, unsigned char* s, unsigned char* d)
   {
@@ -288,8 +352,16 @@ public:
   Convert from RGB24 to grayscale
   Note that this method computes the intensity (simple averaging of the RGB components).
   This is not equivalent with the perceived luminance of color images (e.g., 0.21R + 0.72G + 0.07B or 0.30R + 0.59G + 0.11B)
+  The conversion is vectorized if the processor supports it, see PixelCodecKernels.
   */
   static inline void Rgb24ToGray(int width, int height, unsigned char* s, unsigned char* d)
+  {
+    PixelCodecKernels::Rgb24ToGray(width, height, s, d);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Scalar reference implementation of Rgb24ToGray */
+  static inline void Rgb24ToGrayScalar(int width, int height, const unsigned char* s, unsigned char* d)
   {
     int totalLen = width * height;
     for (int i = 0; i < totalLen; i++)
@@ -305,8 +377,16 @@ public:
   Convert from RGBA32 to grayscale
   Note that this method computes the intensity (simple averaging of the RGB components).
   This is not equivalent with the perceived luminance of color images (e.g., 0.21R + 0.72G + 0.07B or 0.30R + 0.59G + 0.11B)
+  The conversion is vectorized if the processor supports it, see PixelCodecKernels.
   */
   static inline void Rgba32ToGray(int width, int height, unsigned char* s, unsigned char* d)
+  {
+    PixelCodecKernels::Rgba32ToGray(width, height, s, d);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Scalar reference implementation of Rgba32ToGray */
+  static inline void Rgba32ToGrayScalar(int width, int height, const unsigned char* s, unsigned char* d)
   {
     int totalLen = width * height;
     for (int i = 0; i < totalLen; i++)
@@ -376,8 +456,17 @@ public:
   YUY2 conversion to RGB24.
   YUY2 coding is typically used for webcams
   source: http://sundararajana.blogspot.ca/2007/12/yuy2-to-rgb24-conversion.html
+  The conversion is vectorized if the processor supports it, see PixelCodecKernels.
   */
   static PlusStatus Yuv422pToBmp24(ComponentOrdering outputOrdering, int width, int height, unsigned char* s, unsigned char* d)
+  {
+    PixelCodecKernels::Yuv422pToBmp24(outputOrdering == ComponentOrder_BGR, width, height, s, d);
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Scalar reference implementation of Yuv422pToBmp24 */
+  static PlusStatus Yuv422pToBmp24Scalar(ComponentOrdering outputOrdering, int width, int height, const unsigned char* s, unsigned char* d)
   {
     unsigned char* p_dest;
     unsigned char y1, u, y2, v;
@@ -471,8 +560,16 @@ public:
   YUY2 conversion to grayscale.
   YUY2 coding is typically used for webcams
   source: http://sundararajana.blogspot.ca/2007/12/yuy2-to-rgb24-conversion.html
+  The conversion is vectorized if the processor supports it, see PixelCodecKernels.
   */
   static void Yuv422pToGray(int width, int height, unsigned char* s, unsigned char* d)
+  {
+    PixelCodecKernels::Yuv422pToGray(width, height, s, d);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Scalar reference implementation of Yuv422pToGray */
+  static void Yuv422pToGrayScalar(int width, int height, const unsigned char* s, unsigned char* d)
   {
     int i;
     unsigned char* p_dest;
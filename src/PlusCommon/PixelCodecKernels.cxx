@@ -0,0 +1,806 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PixelCodec.h"
+#include "PixelCodecKernels.h"
+#include "PlusWorkerPool.h"
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <functional>
+#include <mutex>
+
+#if defined(_M_X64) || defined(__x86_64__) || defined(_M_IX86) || defined(__i386__)
+  #define PLUS_PIXELCODEC_X86
+  #include <immintrin.h>
+  #ifdef _MSC_VER
+    #include <intrin.h>
+  #endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+  #define PLUS_PIXELCODEC_NEON
+  #include <arm_neon.h>
+#endif
+
+// GCC and Clang only allow using the intrinsics in functions that are compiled for the instruction set
+#if defined(PLUS_PIXELCODEC_X86) && (defined(__GNUC__) || defined(__clang__))
+  #define PLUS_TARGET_SSE2 __attribute__((target("sse2")))
+  #define PLUS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+  #define PLUS_TARGET_SSE2
+  #define PLUS_TARGET_AVX2
+#endif
+
+/*
+All implementations use the same integer math as the scalar reference implementations in PixelCodec,
+rearranged so that all intermediate values fit into 16-bit lanes:
+
+  ICCIRY(y)      = sign(k) * (|k| + ((37 * |k| * 19153) >> 22)), where k = y - 16 (exact for |k| < 240)
+  ICCIRUV(c-128) = sign(x) * ((|x| * 9363) >> 16), where x = (c - 128) * 8 (exact for |x| <= 1024)
+  R = Y + V + ((26345 * V + 32768) >> 16)
+  G = Y - V + ((-22544 * U + 18744 * V + 32768) >> 16)
+  B = Y + 2 * U + ((-14943 * U + 32768) >> 16)
+  n / 3 = (n * 43691) >> 17 (exact for n <= 765)
+*/
+
+namespace
+{
+  const int INSTRUCTION_SET_UNDEFINED = -1;
+
+  std::atomic<int> ActiveInstructionSet(INSTRUCTION_SET_UNDEFINED);
+
+  // Smaller frames are not split, because the synchronization would take longer than the conversion
+  const int MINIMUM_NUMBER_OF_PIXELS_PER_BAND = 64 * 1024;
+
+  //----------------------------------------------------------------------------
+  bool IsCpuFeatureSupported(PixelCodecKernels::InstructionSet instructionSet)
+  {
+    switch (instructionSet)
+    {
+      case PixelCodecKernels::InstructionSet_Scalar:
+        return true;
+#if defined(PLUS_PIXELCODEC_X86)
+#  if defined(_MSC_VER)
+      case PixelCodecKernels::InstructionSet_SSE2:
+      {
+        int cpuInfo[4] = { 0 };
+        __cpuid(cpuInfo, 1);
+        return (cpuInfo[3] & (1 << 26)) != 0;
+      }
+      case PixelCodecKernels::InstructionSet_AVX2:
+      {
+        int cpuInfo[4] = { 0 };
+        __cpuid(cpuInfo, 0);
+        if (cpuInfo[0] < 7)
+        {
+          return false;
+        }
+        __cpuid(cpuInfo, 1);
+        const bool osUsesXsave = (cpuInfo[2] & (1 << 27)) != 0;
+        const bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+        // The operating system has to save the AVX registers on context switch
+        if (!osUsesXsave || !avx || (_xgetbv(0) & 6) != 6)
+        {
+          return false;
+        }
+        __cpuidex(cpuInfo, 7, 0);
+        return (cpuInfo[1] & (1 << 5)) != 0;
+      }
+#  else
+      case PixelCodecKernels::InstructionSet_SSE2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("sse2") != 0;
+      case PixelCodecKernels::InstructionSet_AVX2:
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("avx2") != 0;
+#  endif
+#elif defined(PLUS_PIXELCODEC_NEON)
+      case PixelCodecKernels::InstructionSet_NEON:
+        // NEON is mandatory on 64-bit ARM processors
+        return true;
+#endif
+      default:
+        return false;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  PixelCodecKernels::InstructionSet DetectBestInstructionSet()
+  {
+    const PixelCodecKernels::InstructionSet candidates[] =
+    {
+      PixelCodecKernels::InstructionSet_AVX2,
+      PixelCodecKernels::InstructionSet_SSE2,
+      PixelCodecKernels::InstructionSet_NEON
+    };
+    for (size_t i = 0; i < sizeof(candidates) / sizeof(candidates[0]); ++i)
+    {
+      if (IsCpuFeatureSupported(candidates[i]))
+      {
+        return candidates[i];
+      }
+    }
+    return PixelCodecKernels::InstructionSet_Scalar;
+  }
+
+  // Number of YUY2 pixel pairs in a frame, computed the same way as in the scalar implementations
+  inline int GetNumberOfYuy2PixelPairs(int width, int height)
+  {
+    return height * (width / 2);
+  }
+
+#if defined(PLUS_PIXELCODEC_X86)
+
+  //============== SSE2 ==================
+
+  //----------------------------------------------------------------------------
+  /*! Converts 8 YUY2 pixels (16 bytes) to RGB, the components are returned as signed 16-bit values clamped to [0, 255] */
+  PLUS_TARGET_SSE2 inline void Yuy2ToRgbSse2(__m128i yuy2, __m128i& r, __m128i& g, __m128i& b)
+  {
+    const __m128i y = _mm_and_si128(yuy2, _mm_set1_epi16(0x00FF));
+    const __m128i uv = _mm_srli_epi16(yuy2, 8);
+
+    // ICCIRY
+    const __m128i k = _mm_sub_epi16(y, _mm_set1_epi16(16));
+    __m128i sign = _mm_srai_epi16(k, 15);
+    __m128i magnitude = _mm_sub_epi16(_mm_xor_si128(k, sign), sign);
+    magnitude = _mm_add_epi16(magnitude, _mm_srli_epi16(_mm_mulhi_epu16(_mm_mullo_epi16(magnitude, _mm_set1_epi16(37)), _mm_set1_epi16(19153)), 6));
+    const __m128i luma = _mm_sub_epi16(_mm_xor_si128(magnitude, sign), sign);
+
+    // ICCIRUV, the result contains interleaved U and V values
+    const __m128i x = _mm_slli_epi16(_mm_sub_epi16(uv, _mm_set1_epi16(128)), 3);
+    sign = _mm_srai_epi16(x, 15);
+    magnitude = _mm_mulhi_epu16(_mm_sub_epi16(_mm_xor_si128(x, sign), sign), _mm_set1_epi16(9363));
+    const __m128i chroma = _mm_sub_epi16(_mm_xor_si128(magnitude, sign), sign);
+
+    // Chroma terms of the pixel pairs, (U, V) coefficient pairs are multiplied and summed by madd
+    const __m128i round = _mm_set1_epi32(32768);
+    const __m128i u = _mm_srai_epi32(_mm_slli_epi32(chroma, 16), 16);
+    const __m128i v = _mm_srai_epi32(chroma, 16);
+    const __m128i rv = _mm_add_epi32(v, _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(chroma, _mm_set1_epi32(26345 << 16)), round), 16));
+    const __m128i gc = _mm_sub_epi32(_mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(chroma, _mm_set1_epi32((18744 << 16) | (-22544 & 0xFFFF))), round), 16), v);
+    const __m128i bu = _mm_add_epi32(_mm_slli_epi32(u, 1), _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(chroma, _mm_set1_epi32(-14943 & 0xFFFF)), round), 16));
+
+    // Both pixels of a pair use the same chroma terms
+    const __m128i rvgc = _mm_packs_epi32(rv, gc);
+    const __m128i bubu = _mm_packs_epi32(bu, bu);
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+    r = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(luma, _mm_unpacklo_epi16(rvgc, rvgc)), zero), max);
+    g = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(luma, _mm_unpackhi_epi16(rvgc, rvgc)), zero), max);
+    b = _mm_min_epi16(_mm_max_epi16(_mm_add_epi16(luma, _mm_unpacklo_epi16(bubu, bubu)), zero), max);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Computes (r+g+b)/3 of unsigned 16-bit values, the sum must not exceed 765 */
+  PLUS_TARGET_SSE2 inline __m128i AverageOfThreeSse2(__m128i r, __m128i g, __m128i b)
+  {
+    const __m128i sum = _mm_add_epi16(_mm_add_epi16(r, g), b);
+    return _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16(static_cast<short>(43691))), 1);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_SSE2 void Rgba32ToGraySse2(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPixels = width * height;
+    const __m128i byteMask = _mm_set1_epi32(0xFF);
+    int i = 0;
+    for (; i + 8 <= numberOfPixels; i += 8)
+    {
+      __m128i sums[2];
+      for (int half = 0; half < 2; ++half)
+      {
+        const __m128i rgba = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s + i * 4 + half * 16));
+        sums[half] = _mm_add_epi32(_mm_add_epi32(_mm_and_si128(rgba, byteMask), _mm_and_si128(_mm_srli_epi32(rgba, 8), byteMask)),
+                                   _mm_and_si128(_mm_srli_epi32(rgba, 16), byteMask));
+      }
+      const __m128i sum = _mm_packs_epi32(sums[0], sums[1]);
+      const __m128i gray = _mm_srli_epi16(_mm_mulhi_epu16(sum, _mm_set1_epi16(static_cast<short>(43691))), 1);
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(d + i), _mm_packus_epi16(gray, gray));
+    }
+    PixelCodec::Rgba32ToGrayScalar(numberOfPixels - i, 1, s + i * 4, d + i);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_SSE2 void Yuv422pToGraySse2(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPairs = GetNumberOfYuy2PixelPairs(width, height);
+    int pair = 0;
+    for (; pair + 8 <= numberOfPairs; pair += 8)
+    {
+      __m128i r, g, b;
+      Yuy2ToRgbSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pair * 4)), r, g, b);
+      const __m128i gray0 = AverageOfThreeSse2(r, g, b);
+      Yuy2ToRgbSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pair * 4 + 16)), r, g, b);
+      const __m128i gray1 = AverageOfThreeSse2(r, g, b);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d + pair * 2), _mm_packus_epi16(gray0, gray1));
+    }
+    PixelCodec::Yuv422pToGrayScalar((numberOfPairs - pair) * 2, 1, s + pair * 4, d + pair * 2);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_SSE2 void Yuv422pToBmp24Sse2(bool bgrOrder, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPairs = GetNumberOfYuy2PixelPairs(width, height);
+    // SSE2 has no byte shuffle, so the components are interleaved by scalar stores
+    unsigned char components[3][16];
+    unsigned char* first = components[bgrOrder ? 2 : 0];
+    unsigned char* last = components[bgrOrder ? 0 : 2];
+    int pair = 0;
+    for (; pair + 8 <= numberOfPairs; pair += 8)
+    {
+      __m128i r0, g0, b0, r1, g1, b1;
+      Yuy2ToRgbSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pair * 4)), r0, g0, b0);
+      Yuy2ToRgbSse2(_mm_loadu_si128(reinterpret_cast<const __m128i*>(s + pair * 4 + 16)), r1, g1, b1);
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(components[0]), _mm_packus_epi16(r0, r1));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(components[1]), _mm_packus_epi16(g0, g1));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(components[2]), _mm_packus_epi16(b0, b1));
+      unsigned char* p = d + pair * 6;
+      for (int j = 0; j < 16; ++j)
+      {
+        p[0] = first[j];
+        p[1] = components[1][j];
+        p[2] = last[j];
+        p += 3;
+      }
+    }
+    PixelCodec::Yuv422pToBmp24Scalar(bgrOrder ? PixelCodec::ComponentOrder_BGR : PixelCodec::ComponentOrder_RGB,
+                                     (numberOfPairs - pair) * 2, 1, s + pair * 4, d + pair * 6);
+  }
+
+  //============== AVX2 ==================
+
+  //----------------------------------------------------------------------------
+  /*! Converts 16 YUY2 pixels (32 bytes) to RGB, the components are returned as signed 16-bit values clamped to [0, 255] */
+  PLUS_TARGET_AVX2 inline void Yuy2ToRgbAvx2(__m256i yuy2, __m256i& r, __m256i& g, __m256i& b)
+  {
+    const __m256i y = _mm256_and_si256(yuy2, _mm256_set1_epi16(0x00FF));
+    const __m256i uv = _mm256_srli_epi16(yuy2, 8);
+
+    // ICCIRY
+    const __m256i k = _mm256_sub_epi16(y, _mm256_set1_epi16(16));
+    __m256i magnitude = _mm256_abs_epi16(k);
+    magnitude = _mm256_add_epi16(magnitude, _mm256_srli_epi16(_mm256_mulhi_epu16(_mm256_mullo_epi16(magnitude, _mm256_set1_epi16(37)), _mm256_set1_epi16(19153)), 6));
+    const __m256i luma = _mm256_sign_epi16(magnitude, k);
+
+    // ICCIRUV, the result contains interleaved U and V values
+    const __m256i x = _mm256_slli_epi16(_mm256_sub_epi16(uv, _mm256_set1_epi16(128)), 3);
+    const __m256i chroma = _mm256_sign_epi16(_mm256_mulhi_epu16(_mm256_abs_epi16(x), _mm256_set1_epi16(9363)), x);
+
+    // Chroma terms of the pixel pairs, (U, V) coefficient pairs are multiplied and summed by madd
+    const __m256i round = _mm256_set1_epi32(32768);
+    const __m256i u = _mm256_srai_epi32(_mm256_slli_epi32(chroma, 16), 16);
+    const __m256i v = _mm256_srai_epi32(chroma, 16);
+    const __m256i rv = _mm256_add_epi32(v, _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(chroma, _mm256_set1_epi32(26345 << 16)), round), 16));
+    const __m256i gc = _mm256_sub_epi32(_mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(chroma, _mm256_set1_epi32((18744 << 16) | (-22544 & 0xFFFF))), round), 16), v);
+    const __m256i bu = _mm256_add_epi32(_mm256_slli_epi32(u, 1), _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(chroma, _mm256_set1_epi32(-14943 & 0xFFFF)), round), 16));
+
+    // Both pixels of a pair use the same chroma terms (pack and unpack work within 128-bit lanes, which keeps the pixel order)
+    const __m256i rvgc = _mm256_packs_epi32(rv, gc);
+    const __m256i bubu = _mm256_packs_epi32(bu, bu);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i max = _mm256_set1_epi16(255);
+    r = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(luma, _mm256_unpacklo_epi16(rvgc, rvgc)), zero), max);
+    g = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(luma, _mm256_unpackhi_epi16(rvgc, rvgc)), zero), max);
+    b = _mm256_min_epi16(_mm256_max_epi16(_mm256_add_epi16(luma, _mm256_unpacklo_epi16(bubu, bubu)), zero), max);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Computes (r+g+b)/3 of unsigned 16-bit values, the sum must not exceed 765 */
+  PLUS_TARGET_AVX2 inline __m256i AverageOfThreeAvx2(__m256i r, __m256i g, __m256i b)
+  {
+    const __m256i sum = _mm256_add_epi16(_mm256_add_epi16(r, g), b);
+    return _mm256_srli_epi16(_mm256_mulhi_epu16(sum, _mm256_set1_epi16(static_cast<short>(43691))), 1);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_AVX2 void Rgb24ToGrayAvx2(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPixels = width * height;
+
+    // Byte shuffle masks that gather component c of 16 pixels from the k-th 16 bytes of the 48 input bytes
+    unsigned char masks[3][3][16];
+    for (int c = 0; c < 3; ++c)
+    {
+      for (int k = 0; k < 3; ++k)
+      {
+        for (int j = 0; j < 16; ++j)
+        {
+          const int offset = 3 * j + c - 16 * k;
+          masks[c][k][j] = (offset >= 0 && offset < 16) ? static_cast<unsigned char>(offset) : 0x80;
+        }
+      }
+    }
+    __m256i shuffle[3][3];
+    for (int c = 0; c < 3; ++c)
+    {
+      for (int k = 0; k < 3; ++k)
+      {
+        shuffle[c][k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(masks[c][k])));
+      }
+    }
+
+    const __m256i zero = _mm256_setzero_si256();
+    int i = 0;
+    for (; i + 32 <= numberOfPixels; i += 32)
+    {
+      // The lower lane contains pixels 0-15, the upper lane pixels 16-31
+      const unsigned char* p = s + i * 3;
+      __m256i input[3];
+      for (int k = 0; k < 3; ++k)
+      {
+        input[k] = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16 * k))),
+                                           _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 48 + 16 * k)), 1);
+      }
+      __m256i components[3];
+      for (int c = 0; c < 3; ++c)
+      {
+        components[c] = _mm256_or_si256(_mm256_or_si256(_mm256_shuffle_epi8(input[0], shuffle[c][0]), _mm256_shuffle_epi8(input[1], shuffle[c][1])),
+                                        _mm256_shuffle_epi8(input[2], shuffle[c][2]));
+      }
+      const __m256i low = AverageOfThreeAvx2(_mm256_unpacklo_epi8(components[0], zero), _mm256_unpacklo_epi8(components[1], zero), _mm256_unpacklo_epi8(components[2], zero));
+      const __m256i high = AverageOfThreeAvx2(_mm256_unpackhi_epi8(components[0], zero), _mm256_unpackhi_epi8(components[1], zero), _mm256_unpackhi_epi8(components[2], zero));
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + i), _mm256_packus_epi16(low, high));
+    }
+    PixelCodec::Rgb24ToGrayScalar(numberOfPixels - i, 1, s + i * 3, d + i);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_AVX2 void Rgba32ToGrayAvx2(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPixels = width * height;
+    const __m256i byteMask = _mm256_set1_epi32(0xFF);
+    int i = 0;
+    for (; i + 16 <= numberOfPixels; i += 16)
+    {
+      __m256i sums[2];
+      for (int half = 0; half < 2; ++half)
+      {
+        const __m256i rgba = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + i * 4 + half * 32));
+        sums[half] = _mm256_add_epi32(_mm256_add_epi32(_mm256_and_si256(rgba, byteMask), _mm256_and_si256(_mm256_srli_epi32(rgba, 8), byteMask)),
+                                      _mm256_and_si256(_mm256_srli_epi32(rgba, 16), byteMask));
+      }
+      // Pack works within 128-bit lanes, the permutation restores the pixel order
+      const __m256i sum = _mm256_permute4x64_epi64(_mm256_packs_epi32(sums[0], sums[1]), _MM_SHUFFLE(3, 1, 2, 0));
+      const __m256i gray = _mm256_srli_epi16(_mm256_mulhi_epu16(sum, _mm256_set1_epi16(static_cast<short>(43691))), 1);
+      const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(gray, gray), _MM_SHUFFLE(3, 1, 2, 0));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(d + i), _mm256_castsi256_si128(packed));
+    }
+    PixelCodec::Rgba32ToGrayScalar(numberOfPixels - i, 1, s + i * 4, d + i);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_AVX2 void Yuv422pToGrayAvx2(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPairs = GetNumberOfYuy2PixelPairs(width, height);
+    int pair = 0;
+    for (; pair + 16 <= numberOfPairs; pair += 16)
+    {
+      __m256i r, g, b;
+      Yuy2ToRgbAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pair * 4)), r, g, b);
+      const __m256i gray0 = AverageOfThreeAvx2(r, g, b);
+      Yuy2ToRgbAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pair * 4 + 32)), r, g, b);
+      const __m256i gray1 = AverageOfThreeAvx2(r, g, b);
+      // Pack works within 128-bit lanes, the permutation restores the pixel order
+      _mm256_storeu_si256(reinterpret_cast<__m256i*>(d + pair * 2), _mm256_permute4x64_epi64(_mm256_packus_epi16(gray0, gray1), _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    PixelCodec::Yuv422pToGrayScalar((numberOfPairs - pair) * 2, 1, s + pair * 4, d + pair * 2);
+  }
+
+  //----------------------------------------------------------------------------
+  PLUS_TARGET_AVX2 void Yuv422pToBmp24Avx2(bool bgrOrder, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPairs = GetNumberOfYuy2PixelPairs(width, height);
+
+    // Each 128-bit lane holds the first and second components of 8 pixels (first: bytes 0-7, second: bytes 8-15)
+    // and the third components of the same pixels (bytes 0-7). The shuffles produce the first 16 and the last 8 bytes
+    // of the 24 interleaved output bytes.
+    const char z = static_cast<char>(0x80);
+    const __m256i firstSecondLow = _mm256_setr_epi8(0, 8, z, 1, 9, z, 2, 10, z, 3, 11, z, 4, 12, z, 5,
+                                                    0, 8, z, 1, 9, z, 2, 10, z, 3, 11, z, 4, 12, z, 5);
+    const __m256i thirdLow = _mm256_setr_epi8(z, z, 0, z, z, 1, z, z, 2, z, z, 3, z, z, 4, z,
+                                              z, z, 0, z, z, 1, z, z, 2, z, z, 3, z, z, 4, z);
+    const __m256i firstSecondHigh = _mm256_setr_epi8(13, z, 6, 14, z, 7, 15, z, z, z, z, z, z, z, z, z,
+                                                     13, z, 6, 14, z, 7, 15, z, z, z, z, z, z, z, z, z);
+    const __m256i thirdHigh = _mm256_setr_epi8(z, 5, z, z, 6, z, z, 7, z, z, z, z, z, z, z, z,
+                                               z, 5, z, z, 6, z, z, 7, z, z, z, z, z, z, z, z);
+
+    int pair = 0;
+    for (; pair + 8 <= numberOfPairs; pair += 8)
+    {
+      __m256i r, g, b;
+      Yuy2ToRgbAvx2(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(s + pair * 4)), r, g, b);
+      const __m256i firstSecond = _mm256_packus_epi16(bgrOrder ? b : r, g);
+      const __m256i third = _mm256_packus_epi16(bgrOrder ? r : b, bgrOrder ? r : b);
+      const __m256i low = _mm256_or_si256(_mm256_shuffle_epi8(firstSecond, firstSecondLow), _mm256_shuffle_epi8(third, thirdLow));
+      const __m256i high = _mm256_or_si256(_mm256_shuffle_epi8(firstSecond, firstSecondHigh), _mm256_shuffle_epi8(third, thirdHigh));
+      unsigned char* p = d + pair * 6;
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p), _mm256_castsi256_si128(low));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(p + 16), _mm256_castsi256_si128(high));
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(p + 24), _mm256_extracti128_si256(low, 1));
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(p + 40), _mm256_extracti128_si256(high, 1));
+    }
+    PixelCodec::Yuv422pToBmp24Scalar(bgrOrder ? PixelCodec::ComponentOrder_BGR : PixelCodec::ComponentOrder_RGB,
+                                     (numberOfPairs - pair) * 2, 1, s + pair * 4, d + pair * 6);
+  }
+
+#endif // PLUS_PIXELCODEC_X86
+
+#if defined(PLUS_PIXELCODEC_NEON)
+
+  //============== NEON ==================
+
+  //----------------------------------------------------------------------------
+  /*! Computes ICCIRY of 8 luma values */
+  inline int16x8_t IccirYNeon(uint8x8_t y)
+  {
+    const int16x8_t k = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), vdupq_n_s16(16));
+    const uint16x8_t magnitude = vreinterpretq_u16_s16(vabsq_s16(k));
+    const uint16x8_t scaled = vmulq_n_u16(magnitude, 37);
+    const uint16x8_t quotient = vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(scaled), 19153), 16),
+                                             vshrn_n_u32(vmull_n_u16(vget_high_u16(scaled), 19153), 16));
+    const int16x8_t result = vreinterpretq_s16_u16(vaddq_u16(magnitude, vshrq_n_u16(quotient, 6)));
+    return vbslq_s16(vcltq_s16(k, vdupq_n_s16(0)), vnegq_s16(result), result);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Computes ICCIRUV(c-128) of 8 chroma values */
+  inline int16x8_t IccirUvNeon(uint8x8_t c)
+  {
+    const int16x8_t x = vshlq_n_s16(vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(c)), vdupq_n_s16(128)), 3);
+    const uint16x8_t magnitude = vreinterpretq_u16_s16(vabsq_s16(x));
+    const int16x8_t result = vreinterpretq_s16_u16(vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(magnitude), 9363), 16),
+                                                                vshrn_n_u32(vmull_n_u16(vget_high_u16(magnitude), 9363), 16)));
+    return vbslq_s16(vcltq_s16(x, vdupq_n_s16(0)), vnegq_s16(result), result);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Computes (a * coefficientA + b * coefficientB + 32768) >> 16 */
+  inline int16x8_t ChromaTermNeon(int16x8_t a, int coefficientA, int16x8_t b, int coefficientB)
+  {
+    const int32x4_t round = vdupq_n_s32(32768);
+    const int32x4_t low = vmlal_n_s16(vmlal_n_s16(round, vget_low_s16(a), coefficientA), vget_low_s16(b), coefficientB);
+    const int32x4_t high = vmlal_n_s16(vmlal_n_s16(round, vget_high_s16(a), coefficientA), vget_high_s16(b), coefficientB);
+    return vcombine_s16(vshrn_n_s32(low, 16), vshrn_n_s32(high, 16));
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Converts 8 YUY2 pixel pairs to RGB, separately for the first (even) and second (odd) pixels of the pairs */
+  inline void Yuy2ToRgbNeon(const uint8x8x4_t& yuy2, uint8x8_t rgbEven[3], uint8x8_t rgbOdd[3])
+  {
+    const int16x8_t lumaEven = IccirYNeon(yuy2.val[0]);
+    const int16x8_t lumaOdd = IccirYNeon(yuy2.val[2]);
+    const int16x8_t u = IccirUvNeon(yuy2.val[1]);
+    const int16x8_t v = IccirUvNeon(yuy2.val[3]);
+
+    const int16x8_t rv = vaddq_s16(v, ChromaTermNeon(u, 0, v, 26345));
+    const int16x8_t gc = vsubq_s16(ChromaTermNeon(u, -22544, v, 18744), v);
+    const int16x8_t bu = vaddq_s16(vshlq_n_s16(u, 1), ChromaTermNeon(u, -14943, v, 0));
+
+    rgbEven[0] = vqmovun_s16(vaddq_s16(lumaEven, rv));
+    rgbEven[1] = vqmovun_s16(vaddq_s16(lumaEven, gc));
+    rgbEven[2] = vqmovun_s16(vaddq_s16(lumaEven, bu));
+    rgbOdd[0] = vqmovun_s16(vaddq_s16(lumaOdd, rv));
+    rgbOdd[1] = vqmovun_s16(vaddq_s16(lumaOdd, gc));
+    rgbOdd[2] = vqmovun_s16(vaddq_s16(lumaOdd, bu));
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Computes (r+g+b)/3 of 8 pixels */
+  inline uint8x8_t AverageOfThreeNeon(uint8x8_t r, uint8x8_t g, uint8x8_t b)
+  {
+    const uint16x8_t sum = vaddw_u8(vaddl_u8(r, g), b);
+    const uint16x8_t quotient = vcombine_u16(vshrn_n_u32(vmull_n_u16(vget_low_u16(sum), 43691), 16),
+                                             vshrn_n_u32(vmull_n_u16(vget_high_u16(sum), 43691), 16));
+    return vmovn_u16(vshrq_n_u16(quotient, 1));
+  }
+
+  //----------------------------------------------------------------------------
+  void Rgb24ToGrayNeon(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPixels = width * height;
+    int i = 0;
+    for (; i + 16 <= numberOfPixels; i += 16)
+    {
+      const uint8x16x3_t rgb = vld3q_u8(s + i * 3);
+      vst1q_u8(d + i, vcombine_u8(AverageOfThreeNeon(vget_low_u8(rgb.val[0]), vget_low_u8(rgb.val[1]), vget_low_u8(rgb.val[2])),
+                                  AverageOfThreeNeon(vget_high_u8(rgb.val[0]), vget_high_u8(rgb.val[1]), vget_high_u8(rgb.val[2]))));
+    }
+    PixelCodec::Rgb24ToGrayScalar(numberOfPixels - i, 1, s + i * 3, d + i);
+  }
+
+  //----------------------------------------------------------------------------
+  void Rgba32ToGrayNeon(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPixels = width * height;
+    int i = 0;
+    for (; i + 16 <= numberOfPixels; i += 16)
+    {
+      const uint8x16x4_t rgba = vld4q_u8(s + i * 4);
+      vst1q_u8(d + i, vcombine_u8(AverageOfThreeNeon(vget_low_u8(rgba.val[0]), vget_low_u8(rgba.val[1]), vget_low_u8(rgba.val[2])),
+                                  AverageOfThreeNeon(vget_high_u8(rgba.val[0]), vget_high_u8(rgba.val[1]), vget_high_u8(rgba.val[2]))));
+    }
+    PixelCodec::Rgba32ToGrayScalar(numberOfPixels - i, 1, s + i * 4, d + i);
+  }
+
+  //----------------------------------------------------------------------------
+  void Yuv422pToGrayNeon(int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPairs = GetNumberOfYuy2PixelPairs(width, height);
+    int pair = 0;
+    for (; pair + 8 <= numberOfPairs; pair += 8)
+    {
+      uint8x8_t rgbEven[3];
+      uint8x8_t rgbOdd[3];
+      Yuy2ToRgbNeon(vld4_u8(s + pair * 4), rgbEven, rgbOdd);
+      uint8x8x2_t gray;
+      gray.val[0] = AverageOfThreeNeon(rgbEven[0], rgbEven[1], rgbEven[2]);
+      gray.val[1] = AverageOfThreeNeon(rgbOdd[0], rgbOdd[1], rgbOdd[2]);
+      vst2_u8(d + pair * 2, gray);
+    }
+    PixelCodec::Yuv422pToGrayScalar((numberOfPairs - pair) * 2, 1, s + pair * 4, d + pair * 2);
+  }
+
+  //----------------------------------------------------------------------------
+  void Yuv422pToBmp24Neon(bool bgrOrder, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    const int numberOfPairs = GetNumberOfYuy2PixelPairs(width, height);
+    const int firstComponent = bgrOrder ? 2 : 0;
+    int pair = 0;
+    for (; pair + 8 <= numberOfPairs; pair += 8)
+    {
+      uint8x8_t rgbEven[3];
+      uint8x8_t rgbOdd[3];
+      Yuy2ToRgbNeon(vld4_u8(s + pair * 4), rgbEven, rgbOdd);
+      uint8x16x3_t rgb;
+      for (int c = 0; c < 3; ++c)
+      {
+        const int component = (c == 1 ? 1 : (c == 0 ? firstComponent : 2 - firstComponent));
+        const uint8x8x2_t pixels = vzip_u8(rgbEven[component], rgbOdd[component]);
+        rgb.val[c] = vcombine_u8(pixels.val[0], pixels.val[1]);
+      }
+      vst3q_u8(d + pair * 6, rgb);
+    }
+    PixelCodec::Yuv422pToBmp24Scalar(bgrOrder ? PixelCodec::ComponentOrder_BGR : PixelCodec::ComponentOrder_RGB,
+                                     (numberOfPairs - pair) * 2, 1, s + pair * 4, d + pair * 6);
+  }
+
+#endif // PLUS_PIXELCODEC_NEON
+
+  //----------------------------------------------------------------------------
+  void Rgb24ToGrayRows(PixelCodecKernels::InstructionSet instructionSet, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    switch (instructionSet)
+    {
+#if defined(PLUS_PIXELCODEC_X86)
+      case PixelCodecKernels::InstructionSet_AVX2:
+        Rgb24ToGrayAvx2(width, height, s, d);
+        return;
+#elif defined(PLUS_PIXELCODEC_NEON)
+      case PixelCodecKernels::InstructionSet_NEON:
+        Rgb24ToGrayNeon(width, height, s, d);
+        return;
+#endif
+      default:
+        // SSE2 has no byte shuffle for separating the components, the scalar implementation is used
+        PixelCodec::Rgb24ToGrayScalar(width, height, s, d);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void Rgba32ToGrayRows(PixelCodecKernels::InstructionSet instructionSet, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    switch (instructionSet)
+    {
+#if defined(PLUS_PIXELCODEC_X86)
+      case PixelCodecKernels::InstructionSet_AVX2:
+        Rgba32ToGrayAvx2(width, height, s, d);
+        return;
+      case PixelCodecKernels::InstructionSet_SSE2:
+        Rgba32ToGraySse2(width, height, s, d);
+        return;
+#elif defined(PLUS_PIXELCODEC_NEON)
+      case PixelCodecKernels::InstructionSet_NEON:
+        Rgba32ToGrayNeon(width, height, s, d);
+        return;
+#endif
+      default:
+        PixelCodec::Rgba32ToGrayScalar(width, height, s, d);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void Yuv422pToGrayRows(PixelCodecKernels::InstructionSet instructionSet, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    switch (instructionSet)
+    {
+#if defined(PLUS_PIXELCODEC_X86)
+      case PixelCodecKernels::InstructionSet_AVX2:
+        Yuv422pToGrayAvx2(width, height, s, d);
+        return;
+      case PixelCodecKernels::InstructionSet_SSE2:
+        Yuv422pToGraySse2(width, height, s, d);
+        return;
+#elif defined(PLUS_PIXELCODEC_NEON)
+      case PixelCodecKernels::InstructionSet_NEON:
+        Yuv422pToGrayNeon(width, height, s, d);
+        return;
+#endif
+      default:
+        PixelCodec::Yuv422pToGrayScalar(width, height, s, d);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void Yuv422pToBmp24Rows(PixelCodecKernels::InstructionSet instructionSet, bool bgrOrder, int width, int height, const unsigned char* s, unsigned char* d)
+  {
+    switch (instructionSet)
+    {
+#if defined(PLUS_PIXELCODEC_X86)
+      case PixelCodecKernels::InstructionSet_AVX2:
+        Yuv422pToBmp24Avx2(bgrOrder, width, height, s, d);
+        return;
+      case PixelCodecKernels::InstructionSet_SSE2:
+        Yuv422pToBmp24Sse2(bgrOrder, width, height, s, d);
+        return;
+#elif defined(PLUS_PIXELCODEC_NEON)
+      case PixelCodecKernels::InstructionSet_NEON:
+        Yuv422pToBmp24Neon(bgrOrder, width, height, s, d);
+        return;
+#endif
+      default:
+        PixelCodec::Yuv422pToBmp24Scalar(bgrOrder ? PixelCodec::ComponentOrder_BGR : PixelCodec::ComponentOrder_RGB, width, height, s, d);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  WorkerPool& GetWorkerPool()
+  {
+    // Never destroyed, because joining the worker threads during static destruction may deadlock (e.g., when a DLL is unloaded)
+    static WorkerPool* pool = new WorkerPool;
+    return *pool;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Split the frame into row bands and convert them on the shared worker pool. The frame is converted on the calling thread
+    if it is too small to benefit from parallel conversion.
+  */
+  void ConvertInRowBands(int width, int height, const std::function<void(int firstRow, int numberOfRows)>& convertRows)
+  {
+    WorkerPool& pool = GetWorkerPool();
+    const int numberOfBands = std::min(std::min(pool.GetNumberOfThreads(), height), (width * height) / MINIMUM_NUMBER_OF_PIXELS_PER_BAND);
+    if (numberOfBands < 2)
+    {
+      convertRows(0, height);
+      return;
+    }
+    pool.Run(numberOfBands, [&](int band)
+    {
+      const int firstRow = static_cast<int>(static_cast<long long>(height) * band / numberOfBands);
+      const int endRow = static_cast<int>(static_cast<long long>(height) * (band + 1) / numberOfBands);
+      convertRows(firstRow, endRow - firstRow);
+    });
+  }
+}
+
+//----------------------------------------------------------------------------
+PixelCodecKernels::InstructionSet PixelCodecKernels::GetInstructionSet()
+{
+  int instructionSet = ActiveInstructionSet.load(std::memory_order_relaxed);
+  if (instructionSet == INSTRUCTION_SET_UNDEFINED)
+  {
+    instructionSet = DetectBestInstructionSet();
+    ActiveInstructionSet.store(instructionSet, std::memory_order_relaxed);
+  }
+  return static_cast<InstructionSet>(instructionSet);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PixelCodecKernels::SetInstructionSet(InstructionSet instructionSet)
+{
+  if (!IsInstructionSetSupported(instructionSet))
+  {
+    LOG_ERROR("Instruction set " << GetInstructionSetAsString(instructionSet) << " is not supported on this processor");
+    return PLUS_FAIL;
+  }
+  ActiveInstructionSet.store(instructionSet, std::memory_order_relaxed);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool PixelCodecKernels::IsInstructionSetSupported(InstructionSet instructionSet)
+{
+  return IsCpuFeatureSupported(instructionSet);
+}
+
+//----------------------------------------------------------------------------
+std::string PixelCodecKernels::GetInstructionSetAsString(InstructionSet instructionSet)
+{
+  switch (instructionSet)
+  {
+    case InstructionSet_Scalar:
+      return "Scalar";
+    case InstructionSet_SSE2:
+      return "SSE2";
+    case InstructionSet_AVX2:
+      return "AVX2";
+    case InstructionSet_NEON:
+      return "NEON";
+    default:
+      return "Unknown";
+  }
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PixelCodecKernels::SetNumberOfThreads(int numberOfThreads)
+{
+  return GetWorkerPool().SetNumberOfThreads(numberOfThreads);
+}
+
+//----------------------------------------------------------------------------
+int PixelCodecKernels::GetNumberOfThreads()
+{
+  return GetWorkerPool().GetNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus PixelCodecKernels::RequestNumberOfThreads(int numberOfThreads)
+{
+  static std::mutex requestMutex;
+  std::lock_guard<std::mutex> lock(requestMutex);
+  if (numberOfThreads <= GetNumberOfThreads())
+  {
+    return PLUS_SUCCESS;
+  }
+  LOG_INFO("Pixel conversion worker pool size is increased to " << numberOfThreads << " threads");
+  return SetNumberOfThreads(numberOfThreads);
+}
+
+//----------------------------------------------------------------------------
+void PixelCodecKernels::Rgb24ToGray(int width, int height, const unsigned char* s, unsigned char* d)
+{
+  const InstructionSet instructionSet = GetInstructionSet();
+  ConvertInRowBands(width, height, [ = ](int firstRow, int numberOfRows)
+  {
+    Rgb24ToGrayRows(instructionSet, width, numberOfRows, s + firstRow * width * 3, d + firstRow * width);
+  });
+}
+
+//----------------------------------------------------------------------------
+void PixelCodecKernels::Rgba32ToGray(int width, int height, const unsigned char* s, unsigned char* d)
+{
+  const InstructionSet instructionSet = GetInstructionSet();
+  ConvertInRowBands(width, height, [ = ](int firstRow, int numberOfRows)
+  {
+    Rgba32ToGrayRows(instructionSet, width, numberOfRows, s + firstRow * width * 4, d + firstRow * width);
+  });
+}
+
+//----------------------------------------------------------------------------
+void PixelCodecKernels::Yuv422pToGray(int width, int height, const unsigned char* s, unsigned char* d)
+{
+  // The YUY2 conversions process width/2 pixel pairs per row, the bands must start at the same pixel pairs
+  const InstructionSet instructionSet = GetInstructionSet();
+  ConvertInRowBands(width, height, [ = ](int firstRow, int numberOfRows)
+  {
+    const int firstPair = firstRow * (width / 2);
+    Yuv422pToGrayRows(instructionSet, width, numberOfRows, s + firstPair * 4, d + firstPair * 2);
+  });
+}
+
+//----------------------------------------------------------------------------
+void PixelCodecKernels::Yuv422pToBmp24(bool bgrOrder, int width, int height, const unsigned char* s, unsigned char* d)
+{
+  // The YUY2 conversions process width/2 pixel pairs per row, the bands must start at the same pixel pairs
+  const InstructionSet instructionSet = GetInstructionSet();
+  ConvertInRowBands(width, height, [ = ](int firstRow, int numberOfRows)
+  {
+    const int firstPair = firstRow * (width / 2);
+    Yuv422pToBmp24Rows(instructionSet, bgrOrder, width, numberOfRows, s + firstPair * 4, d + firstPair * 6);
+  });
+}
@@ -0,0 +1,80 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PixelCodecKernels_h
+#define __PixelCodecKernels_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusCommonExport.h"
+
+#include <string>
+
+/*!
+\class PixelCodecKernels
+\brief Vectorized implementations of the PixelCodec frame conversions
+
+The implementation is selected at runtime, based on the instruction sets that the CPU supports
+(SSE2 and AVX2 on x86 processors, NEON on 64-bit ARM processors). The output of all implementations
+is bit-exact with the scalar reference implementations of PixelCodec (e.g., PixelCodec::Rgb24ToGrayScalar).
+Large frames can be converted by multiple threads (see SetNumberOfThreads), the result does not depend on the number of threads.
+The functions are used by PixelCodec, they are not intended to be called directly.
+\ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport PixelCodecKernels
+{
+public:
+  enum InstructionSet
+  {
+    InstructionSet_Scalar,
+    InstructionSet_SSE2,
+    InstructionSet_AVX2,
+    InstructionSet_NEON
+  };
+
+  /*! Get the instruction set that is used by the conversions */
+  static InstructionSet GetInstructionSet();
+
+  /*!
+    Set the instruction set that is used by the conversions. By default the fastest instruction set
+    that the CPU supports is used. Mainly useful for testing and benchmarking.
+  */
+  static PlusStatus SetInstructionSet(InstructionSet instructionSet);
+
+  /*! Returns true if the CPU supports the instruction set */
+  static bool IsInstructionSetSupported(InstructionSet instructionSet);
+
+  static std::string GetInstructionSetAsString(InstructionSet instructionSet);
+
+  /*!
+    Set the number of threads of the worker pool that is shared by all conversions, including the calling thread.
+    Large frames are split into row bands that are converted in parallel. By default all conversions run on the calling thread.
+  */
+  static PlusStatus SetNumberOfThreads(int numberOfThreads);
+  static int GetNumberOfThreads();
+
+  /*!
+    Increase the number of threads of the shared worker pool to at least the requested number. Used by devices, which
+    request the number of threads that their frame rate and frame size require.
+  */
+  static PlusStatus RequestNumberOfThreads(int numberOfThreads);
+
+  /*! Convert from RGB24 (or BGR24) to grayscale, see PixelCodec::Rgb24ToGrayScalar */
+  static void Rgb24ToGray(int width, int height, const unsigned char* s, unsigned char* d);
+
+  /*! Convert from RGBA32 to grayscale, see PixelCodec::Rgba32ToGrayScalar */
+  static void Rgba32ToGray(int width, int height, const unsigned char* s, unsigned char* d);
+
+  /*! Convert from YUY2 to grayscale, see PixelCodec::Yuv422pToGrayScalar */
+  static void Yuv422pToGray(int width, int height, const unsigned char* s, unsigned char* d);
+
+  /*! Convert from YUY2 to RGB24 (or BGR24 if bgrOrder is true), see PixelCodec::Yuv422pToBmp24Scalar */
+  static void Yuv422pToBmp24(bool bgrOrder, int width, int height, const unsigned char* s, unsigned char* d);
+
+private:
+  PixelCodecKernels(); // prevent instantiation
+};
+
+#endif  //__PixelCodecKernels_h
@@ -0,0 +1,519 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusChunkedSequenceFile.h"
+#include "vtkPlusConfig.h"
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+#include <vtkIGSIOSequenceIO.h>
+#include <vtkIGSIOTrackedFrameList.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtksys/SystemTools.hxx>
+
+// STL includes
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <sstream>
+
+namespace
+{
+  const char FILE_SIGNATURE[] = "PLUS_CHUNKED_SEQUENCE";
+  const int FILE_VERSION = 1;
+  const char VERSION_FIELD_NAME[] = "Version";
+  const char CHUNK_FILE_EXTENSION_FIELD_NAME[] = "ChunkFileExtension";
+  const char CHUNK_FIELD_NAME[] = "Chunk";
+  const size_t COPY_BUFFER_SIZE = 1 << 20;
+  // Each chunk has a full sequence file header, a few seconds of frames make the header size negligible
+  const unsigned int DEFAULT_MINIMUM_NUMBER_OF_FRAMES_PER_CHUNK = 50;
+  // Chunks must be single files, formats with a separate pixel data file cannot be stored in a chunk
+  const char* SUPPORTED_CHUNK_FILE_EXTENSIONS[] = { ".nrrd", ".mha" };
+
+  //----------------------------------------------------------------------------
+  /*! Split a "name = value" header line */
+  bool ParseHeaderLine(const std::string& line, std::string& name, std::string& value)
+  {
+    std::string::size_type separator = line.find('=');
+    if (separator == std::string::npos)
+    {
+      return false;
+    }
+    name = igsioCommon::Trim(line.substr(0, separator));
+    value = igsioCommon::Trim(line.substr(separator + 1));
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+ChunkedSequenceFile::ChunkedSequenceFile()
+  : UseCompression(true)
+  , ImageOrientationInFile(US_IMG_ORIENT_XX)
+  , NumberOfChunks(0)
+  , MinimumNumberOfFramesPerChunk(DEFAULT_MINIMUM_NUMBER_OF_FRAMES_PER_CHUNK)
+{
+}
+
+//----------------------------------------------------------------------------
+ChunkedSequenceFile::~ChunkedSequenceFile()
+{
+  if (this->IsOpen())
+  {
+    this->Close();
+  }
+}
+
+//----------------------------------------------------------------------------
+std::string ChunkedSequenceFile::GetFileExtension()
+{
+  return ".seqchunks";
+}
+
+//----------------------------------------------------------------------------
+bool ChunkedSequenceFile::IsChunkedSequenceFile(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  std::string line;
+  return file.is_open() && std::getline(file, line) && line == FILE_SIGNATURE;
+}
+
+//----------------------------------------------------------------------------
+bool ChunkedSequenceFile::IsValidChunkFileExtension(const std::string& chunkFileExtension)
+{
+  for (unsigned int i = 0; i < sizeof(SUPPORTED_CHUNK_FILE_EXTENSIONS) / sizeof(SUPPORTED_CHUNK_FILE_EXTENSIONS[0]); ++i)
+  {
+    if (igsioCommon::IsEqualInsensitive(chunkFileExtension, SUPPORTED_CHUNK_FILE_EXTENSIONS[i]))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::ReadChunkLayout(const std::string& filename, std::vector<ChunkInfo>& chunks, std::string& chunkFileExtension)
+{
+  chunks.clear();
+  chunkFileExtension = ".nrrd";
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  std::string line;
+  if (!file.is_open() || !std::getline(file, line) || line != FILE_SIGNATURE)
+  {
+    LOG_ERROR("Cannot read chunked sequence file: " << filename);
+    return PLUS_FAIL;
+  }
+
+  const unsigned long long fileSize = vtksys::SystemTools::FileLength(filename);
+  while (std::getline(file, line))
+  {
+    if (file.eof())
+    {
+      // Lines are terminated by a newline, the recording was interrupted while the line was written
+      LOG_WARNING("Chunked sequence file " << filename << " is truncated after chunk " << chunks.size() << ". Only the complete chunks are read.");
+      break;
+    }
+    std::string name;
+    std::string value;
+    if (!ParseHeaderLine(line, name, value))
+    {
+      LOG_ERROR("Invalid line in chunked sequence file " << filename << ": " << line);
+      return PLUS_FAIL;
+    }
+
+    if (name == VERSION_FIELD_NAME)
+    {
+      int version = 0;
+      if (igsioCommon::StringToNumber<int>(value, version) != PLUS_SUCCESS || version < 1 || version > FILE_VERSION)
+      {
+        LOG_ERROR("Unsupported chunked sequence file version " << value << " in " << filename << ". Supported version: " << FILE_VERSION);
+        return PLUS_FAIL;
+      }
+    }
+    else if (name == CHUNK_FILE_EXTENSION_FIELD_NAME)
+    {
+      // The extension is used in a file name, so only known sequence file extensions are accepted
+      if (!IsValidChunkFileExtension(value))
+      {
+        LOG_ERROR("Unsupported chunk file extension " << value << " in chunked sequence file " << filename);
+        return PLUS_FAIL;
+      }
+      chunkFileExtension = value;
+    }
+    else if (name == CHUNK_FIELD_NAME)
+    {
+      std::istringstream chunkSizes(value);
+      ChunkInfo chunk;
+      if (!(chunkSizes >> chunk.NumberOfFrames >> chunk.NumberOfBytes))
+      {
+        LOG_ERROR("Invalid chunk description in chunked sequence file " << filename << ": " << line);
+        return PLUS_FAIL;
+      }
+      chunk.Offset = static_cast<unsigned long long>(file.tellg());
+      if (chunk.Offset + chunk.NumberOfBytes > fileSize)
+      {
+        // The recording was interrupted while the last chunk was appended
+        LOG_WARNING("Chunk " << chunks.size() << " of chunked sequence file " << filename << " is truncated. Only the complete chunks are read.");
+        break;
+      }
+      chunks.push_back(chunk);
+      file.seekg(static_cast<std::streamoff>(chunk.NumberOfBytes), std::ios::cur);
+    }
+    // Unknown fields are ignored, they may be added by later versions without breaking the format
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::Read(const std::string& filename, vtkIGSIOTrackedFrameList* frameList)
+{
+  std::vector<ChunkInfo> chunks;
+  std::string chunkFileExtension;
+  if (ReadChunkLayout(filename, chunks, chunkFileExtension) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  std::vector<char> chunkData;
+  for (std::vector<ChunkInfo>::size_type chunkIndex = 0; chunkIndex < chunks.size(); ++chunkIndex)
+  {
+    const ChunkInfo& chunk = chunks[chunkIndex];
+    chunkData.resize(static_cast<size_t>(chunk.NumberOfBytes));
+    file.seekg(static_cast<std::streamoff>(chunk.Offset), std::ios::beg);
+    if (chunk.NumberOfBytes > 0 && !file.read(&chunkData[0], chunkData.size()))
+    {
+      LOG_ERROR("Failed to read chunk " << chunkIndex << " of chunked sequence file " << filename);
+      return PLUS_FAIL;
+    }
+
+    // Sequence readers only read files, so the chunk is extracted to a temporary file
+    const std::string chunkFileName = GetExtractedChunkFileName(filename, chunkFileExtension);
+    {
+      std::ofstream chunkFile(chunkFileName.c_str(), std::ios::binary | std::ios::trunc);
+      if (!chunkFile.is_open() || (chunk.NumberOfBytes > 0 && !chunkFile.write(&chunkData[0], chunkData.size())))
+      {
+        LOG_ERROR("Failed to extract chunk " << chunkIndex << " of " << filename << " to " << chunkFileName);
+        return PLUS_FAIL;
+      }
+    }
+    vtkNew<vtkIGSIOTrackedFrameList> chunkFrameList;
+    PlusStatus status = vtkIGSIOSequenceIO::Read(chunkFileName, chunkFrameList.GetPointer());
+    vtksys::SystemTools::RemoveFile(chunkFileName);
+    if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read chunk " << chunkIndex << " of chunked sequence file " << filename);
+      return PLUS_FAIL;
+    }
+    if (chunkFrameList->GetNumberOfTrackedFrames() != chunk.NumberOfFrames)
+    {
+      LOG_ERROR("Chunk " << chunkIndex << " of " << filename << " contains " << chunkFrameList->GetNumberOfTrackedFrames() << " frames instead of " << chunk.NumberOfFrames);
+      return PLUS_FAIL;
+    }
+    if (frameList->AddTrackedFrameList(chunkFrameList.GetPointer()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frames of chunk " << chunkIndex << " of chunked sequence file " << filename);
+      return PLUS_FAIL;
+    }
+  }
+
+  LOG_DEBUG("Read " << chunks.size() << " chunks from " << filename);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::SetNumberOfThreads(int numberOfThreads)
+{
+  return this->Pool.SetNumberOfThreads(numberOfThreads);
+}
+
+//----------------------------------------------------------------------------
+int ChunkedSequenceFile::GetNumberOfThreads() const
+{
+  return this->Pool.GetNumberOfThreads();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::SetMinimumNumberOfFramesPerChunk(unsigned int numberOfFrames)
+{
+  if (numberOfFrames < 1)
+  {
+    LOG_ERROR("Invalid minimum number of frames per chunk: " << numberOfFrames << ". It must be at least 1.");
+    return PLUS_FAIL;
+  }
+  this->MinimumNumberOfFramesPerChunk = numberOfFrames;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+unsigned int ChunkedSequenceFile::GetMinimumNumberOfFramesPerChunk() const
+{
+  return this->MinimumNumberOfFramesPerChunk;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::Open(const std::string& filename, bool useCompression, const std::string& chunkFileExtension /*= ".nrrd"*/, US_IMAGE_ORIENTATION orientationInFile /*= US_IMG_ORIENT_XX*/)
+{
+  if (this->IsOpen())
+  {
+    this->Close();
+  }
+  if (!IsValidChunkFileExtension(chunkFileExtension))
+  {
+    LOG_ERROR("Unsupported chunk file extension " << chunkFileExtension << " for chunked sequence file: " << filename);
+    return PLUS_FAIL;
+  }
+
+  this->File.open(filename.c_str(), std::ios::binary | std::ios::trunc);
+  if (!this->File.is_open())
+  {
+    LOG_ERROR("Failed to create chunked sequence file: " << filename);
+    return PLUS_FAIL;
+  }
+  this->FileName = filename;
+  this->ChunkFileExtension = chunkFileExtension;
+  this->UseCompression = useCompression;
+  this->ImageOrientationInFile = orientationInFile;
+  this->NumberOfChunks = 0;
+  this->PendingChunks.clear();
+
+  this->File << FILE_SIGNATURE << "\n";
+  this->File << VERSION_FIELD_NAME << " = " << FILE_VERSION << "\n";
+  this->File << CHUNK_FILE_EXTENSION_FIELD_NAME << " = " << this->ChunkFileExtension << "\n";
+  if (!this->File)
+  {
+    LOG_ERROR("Failed to write the header of chunked sequence file: " << filename);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::WriteFrames(const std::vector<vtkIGSIOTrackedFrameList*>& frameLists)
+{
+  if (!this->IsOpen())
+  {
+    LOG_ERROR("Cannot write frames, the chunked sequence file is not open");
+    return PLUS_FAIL;
+  }
+
+  for (std::vector<vtkIGSIOTrackedFrameList*>::const_iterator it = frameLists.begin(); it != frameLists.end(); ++it)
+  {
+    if (this->PendingChunks.empty() || this->PendingChunks.back()->GetNumberOfTrackedFrames() >= this->MinimumNumberOfFramesPerChunk)
+    {
+      this->PendingChunks.push_back(vtkSmartPointer<vtkIGSIOTrackedFrameList>::New());
+    }
+    if (this->PendingChunks.back()->AddTrackedFrameList(*it) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frames to chunk " << this->NumberOfChunks + this->PendingChunks.size() - 1 << " of chunked sequence file " << this->FileName);
+      return PLUS_FAIL;
+    }
+  }
+
+  // The last chunk is kept until it has enough frames
+  size_t numberOfCompleteChunks = this->PendingChunks.size();
+  if (numberOfCompleteChunks > 0 && this->PendingChunks.back()->GetNumberOfTrackedFrames() < this->MinimumNumberOfFramesPerChunk)
+  {
+    numberOfCompleteChunks--;
+  }
+  if (numberOfCompleteChunks == 0)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  std::vector<vtkIGSIOTrackedFrameList*> chunkFrameLists;
+  for (size_t i = 0; i < numberOfCompleteChunks; ++i)
+  {
+    chunkFrameLists.push_back(this->PendingChunks[i]);
+  }
+  PlusStatus status = this->WriteChunks(chunkFrameLists);
+  this->PendingChunks.erase(this->PendingChunks.begin(), this->PendingChunks.begin() + numberOfCompleteChunks);
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::Flush()
+{
+  if (!this->IsOpen() || this->PendingChunks.empty())
+  {
+    return PLUS_SUCCESS;
+  }
+
+  std::vector<vtkIGSIOTrackedFrameList*> chunkFrameLists;
+  for (size_t i = 0; i < this->PendingChunks.size(); ++i)
+  {
+    chunkFrameLists.push_back(this->PendingChunks[i]);
+  }
+  PlusStatus status = this->WriteChunks(chunkFrameLists);
+  this->PendingChunks.clear();
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::WriteChunks(const std::vector<vtkIGSIOTrackedFrameList*>& frameLists)
+{
+  const int numberOfChunks = static_cast<int>(frameLists.size());
+  std::vector<std::string> chunkFileNames(numberOfChunks);
+  std::vector<PlusStatus> chunkStatus(numberOfChunks, PLUS_FAIL);
+  for (int i = 0; i < numberOfChunks; ++i)
+  {
+    chunkFileNames[i] = GetChunkFileName(this->FileName, this->NumberOfChunks + i, this->ChunkFileExtension);
+  }
+
+  // Compression is the expensive part, chunks are independent so they are written in parallel
+  this->Pool.Run(numberOfChunks, [&](int i)
+  {
+    US_IMAGE_ORIENTATION orientationInFile = this->ImageOrientationInFile;
+    if (orientationInFile == US_IMG_ORIENT_XX && frameLists[i]->GetNumberOfTrackedFrames() > 0)
+    {
+      orientationInFile = frameLists[i]->GetTrackedFrame(0)->GetImageData()->GetImageOrientation();
+    }
+    chunkStatus[i] = vtkIGSIOSequenceIO::Write(chunkFileNames[i], "", frameLists[i], orientationInFile, this->UseCompression);
+  });
+
+  // Chunks are appended in order, even if a later chunk is completed first
+  PlusStatus status = PLUS_SUCCESS;
+  for (int i = 0; i < numberOfChunks; ++i)
+  {
+    if (status == PLUS_SUCCESS)
+    {
+      if (chunkStatus[i] != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to write chunk " << this->NumberOfChunks << " of chunked sequence file " << this->FileName);
+        status = PLUS_FAIL;
+      }
+      else if (this->AppendChunk(chunkFileNames[i], frameLists[i]->GetNumberOfTrackedFrames()) != PLUS_SUCCESS)
+      {
+        status = PLUS_FAIL;
+      }
+    }
+    vtksys::SystemTools::RemoveFile(chunkFileNames[i]);
+  }
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::AppendChunk(const std::string& chunkFileName, unsigned int numberOfFrames)
+{
+  std::ifstream chunkFile(chunkFileName.c_str(), std::ios::binary | std::ios::ate);
+  if (!chunkFile.is_open())
+  {
+    LOG_ERROR("Failed to open chunk file: " << chunkFileName);
+    return PLUS_FAIL;
+  }
+  const unsigned long long numberOfBytes = static_cast<unsigned long long>(chunkFile.tellg());
+  chunkFile.seekg(0, std::ios::beg);
+
+  this->File << CHUNK_FIELD_NAME << " = " << numberOfFrames << " " << numberOfBytes << "\n";
+  std::vector<char> buffer(COPY_BUFFER_SIZE);
+  unsigned long long remainingBytes = numberOfBytes;
+  while (remainingBytes > 0 && this->File)
+  {
+    const size_t blockSize = static_cast<size_t>(std::min<unsigned long long>(remainingBytes, buffer.size()));
+    if (!chunkFile.read(&buffer[0], blockSize))
+    {
+      LOG_ERROR("Failed to read chunk file: " << chunkFileName);
+      return PLUS_FAIL;
+    }
+    this->File.write(&buffer[0], blockSize);
+    remainingBytes -= blockSize;
+  }
+  if (!this->File)
+  {
+    LOG_ERROR("Failed to append chunk " << this->NumberOfChunks << " to chunked sequence file " << this->FileName);
+    return PLUS_FAIL;
+  }
+
+  this->NumberOfChunks++;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ChunkedSequenceFile::Close(const std::string& filename /*= ""*/)
+{
+  if (!this->IsOpen())
+  {
+    return PLUS_SUCCESS;
+  }
+
+  PlusStatus status = this->Flush();
+  this->File.close();
+  if (this->File.fail())
+  {
+    LOG_ERROR("Failed to close chunked sequence file: " << this->FileName);
+    return PLUS_FAIL;
+  }
+  if (status != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write the last chunk of chunked sequence file: " << this->FileName);
+    return PLUS_FAIL;
+  }
+
+  if (!filename.empty() && filename != this->FileName)
+  {
+    if (!vtksys::SystemTools::RenameFile(this->FileName.c_str(), filename.c_str()))
+    {
+      LOG_ERROR("Failed to rename chunked sequence file " << this->FileName << " to " << filename);
+      return PLUS_FAIL;
+    }
+    this->FileName = filename;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void ChunkedSequenceFile::Discard()
+{
+  if (!this->IsOpen())
+  {
+    return;
+  }
+  this->File.close();
+  vtksys::SystemTools::RemoveFile(this->FileName);
+  this->NumberOfChunks = 0;
+  this->PendingChunks.clear();
+}
+
+//----------------------------------------------------------------------------
+bool ChunkedSequenceFile::IsOpen() const
+{
+  return this->File.is_open();
+}
+
+//----------------------------------------------------------------------------
+const std::string& ChunkedSequenceFile::GetFileName() const
+{
+  return this->FileName;
+}
+
+//----------------------------------------------------------------------------
+unsigned long ChunkedSequenceFile::GetNumberOfChunks() const
+{
+  return this->NumberOfChunks;
+}
+
+//----------------------------------------------------------------------------
+std::string ChunkedSequenceFile::GetChunkFileName(const std::string& filename, unsigned long chunkIndex, const std::string& chunkFileExtension)
+{
+  std::ostringstream chunkFileName;
+  chunkFileName << filename << ".chunk" << chunkIndex << chunkFileExtension;
+  return chunkFileName.str();
+}
+
+//----------------------------------------------------------------------------
+std::string ChunkedSequenceFile::GetExtractedChunkFileName(const std::string& filename, const std::string& chunkFileExtension)
+{
+  // A random key per process and a counter, so that concurrent readers in any process do not overwrite each other's chunks
+  static const unsigned int processKey = std::random_device()();
+  static std::atomic<unsigned long> extractedChunkCount(0);
+
+  std::ostringstream chunkFileName;
+  chunkFileName << vtksys::SystemTools::GetFilenameWithoutLastExtension(filename) << "_" << std::hex << processKey << std::dec
+                << "_" << extractedChunkCount++ << chunkFileExtension;
+  return vtkPlusConfig::GetInstance()->GetOutputPath(chunkFileName.str());
+}
@@ -0,0 +1,150 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusChunkedSequenceFile_h
+#define __PlusChunkedSequenceFile_h
+
+#include "PlusConfigure.h"
+#include "PlusWorkerPool.h"
+#include "igsioCommon.h"
+#include "vtkPlusCommonExport.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <fstream>
+#include <string>
+#include <vector>
+
+class vtkIGSIOTrackedFrameList;
+
+/*!
+\class ChunkedSequenceFile
+\brief Sequence file that is written as a series of independently compressed chunks
+
+Each chunk is a complete sequence file (by default a compressed NRRD file) that contains a batch of frames.
+Written frame lists are collected until a chunk has at least GetMinimumNumberOfFramesPerChunk() frames, so that
+the header of each chunk is written for many frames. Chunks are written in parallel on a worker pool and are appended
+to the file in the order they were submitted, so compression is no longer limited to a single thread. The file starts with a short text header:
+
+\verbatim
+PLUS_CHUNKED_SEQUENCE
+Version = 1
+ChunkFileExtension = .nrrd
+\endverbatim
+
+followed by the chunks, each of them preceded by a "Chunk = <numberOfFrames> <numberOfBytes>" line.
+Chunked sequence files are read by vtkPlusSequenceIO::Read like any other sequence file. If the recording
+was interrupted and the last chunk is incomplete then the complete chunks are read.
+
+\ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport ChunkedSequenceFile
+{
+public:
+  ChunkedSequenceFile();
+  /*! Closes the file, if it is still open */
+  ~ChunkedSequenceFile();
+
+  /*! Extension of chunked sequence files */
+  static std::string GetFileExtension();
+
+  /*! Returns true if the file starts with the chunked sequence file signature */
+  static bool IsChunkedSequenceFile(const std::string& filename);
+
+  /*! Returns true if chunks can be written as sequence files with the extension. Only single-file formats are supported. */
+  static bool IsValidChunkFileExtension(const std::string& chunkFileExtension);
+
+  /*!
+    Read all chunks of the file and append their frames to the frame list.
+    Chunks are extracted to uniquely named temporary files in the output directory.
+  */
+  static PlusStatus Read(const std::string& filename, vtkIGSIOTrackedFrameList* frameList);
+
+  /*! Position of a chunk in a chunked sequence file */
+  struct ChunkInfo
+  {
+    unsigned int NumberOfFrames;
+    /*! Position of the first byte of the chunk in the file */
+    unsigned long long Offset;
+    unsigned long long NumberOfBytes;
+  };
+
+  /*!
+    Find the complete chunks of the file without reading them. Chunks can then be read directly, for example
+    the frames of an uncompressed chunk by a SequenceFrameIndex.
+  */
+  static PlusStatus ReadChunkLayout(const std::string& filename, std::vector<ChunkInfo>& chunks, std::string& chunkFileExtension);
+
+  /*! Set the number of threads that compress chunks, including the thread that calls WriteChunks */
+  PlusStatus SetNumberOfThreads(int numberOfThreads);
+  int GetNumberOfThreads() const;
+
+  /*!
+    Set the number of frames that are collected before a chunk is written. Frame lists are not split, so a chunk
+    may contain more frames. If it is 1 then each written frame list is a chunk.
+  */
+  PlusStatus SetMinimumNumberOfFramesPerChunk(unsigned int numberOfFrames);
+  unsigned int GetMinimumNumberOfFramesPerChunk() const;
+
+  /*!
+    Create the file and write the header. Chunks are written as sequence files with the given extension.
+    Images are written in orientationInFile. If it is US_IMG_ORIENT_XX then each chunk is written in the
+    orientation of its first frame, so the images are not reoriented.
+  */
+  PlusStatus Open(const std::string& filename, bool useCompression, const std::string& chunkFileExtension = ".nrrd", US_IMAGE_ORIENTATION orientationInFile = US_IMG_ORIENT_XX);
+
+  /*!
+    Add the frames of the frame lists to the file. The frames are copied to the current chunk, and the chunks that have
+    enough frames are written in parallel and appended to the file in order. The frame lists may be reused after the call.
+  */
+  PlusStatus WriteFrames(const std::vector<vtkIGSIOTrackedFrameList*>& frameLists);
+
+  /*! Write the frames that are not written yet as a chunk, even if there are fewer than the minimum number of frames */
+  PlusStatus Flush();
+
+  /*! Write the remaining frames and close the file. If the file name is not empty then the file is renamed. */
+  PlusStatus Close(const std::string& filename = "");
+
+  /*! Close and delete the file, frames that are not written yet are dropped */
+  void Discard();
+
+  bool IsOpen() const;
+  const std::string& GetFileName() const;
+  /*! Number of chunks that are written to the file */
+  unsigned long GetNumberOfChunks() const;
+
+protected:
+  /*! Name of the temporary sequence file of a chunk, next to the chunked sequence file */
+  static std::string GetChunkFileName(const std::string& filename, unsigned long chunkIndex, const std::string& chunkFileExtension);
+
+  /*! Unique name of a temporary file in the output directory, to extract a chunk of the file for reading */
+  static std::string GetExtractedChunkFileName(const std::string& filename, const std::string& chunkFileExtension);
+
+  /*! Write each frame list as a chunk. Chunks are written in parallel and appended to the file in order. */
+  PlusStatus WriteChunks(const std::vector<vtkIGSIOTrackedFrameList*>& frameLists);
+
+  /*! Append the contents of the chunk file to the chunked sequence file */
+  PlusStatus AppendChunk(const std::string& chunkFileName, unsigned int numberOfFrames);
+
+  WorkerPool Pool;
+  std::ofstream File;
+  std::string FileName;
+  std::string ChunkFileExtension;
+  bool UseCompression;
+  US_IMAGE_ORIENTATION ImageOrientationInFile;
+  unsigned long NumberOfChunks;
+  unsigned int MinimumNumberOfFramesPerChunk;
+  /*! Frames that are not written yet. Only the last chunk may have fewer than MinimumNumberOfFramesPerChunk frames. */
+  std::vector<vtkSmartPointer<vtkIGSIOTrackedFrameList> > PendingChunks;
+
+private:
+  ChunkedSequenceFile(const ChunkedSequenceFile&);
+  void operator=(const ChunkedSequenceFile&);
+};
+
+#endif  //__PlusChunkedSequenceFile_h
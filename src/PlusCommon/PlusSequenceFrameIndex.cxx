@@ -0,0 +1,693 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusChunkedSequenceFile.h"
+#include "PlusSequenceFrameIndex.h"
+#include "vtkPlusSequenceIO.h"
+
+// IGSIO includes
+#include <vtkIGSIOTrackedFrameList.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtksys/SystemTools.hxx>
+
+// STL includes
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+  const char FILE_SIGNATURE[8] = { 'P', 'L', 'U', 'S', 'F', 'I', 'D', 'X' };
+  // Version 2 added the modification time and the header hash of the sequence file
+  const vtkTypeUInt32 FILE_VERSION = 2;
+  const std::streamsize HEADER_HASH_LENGTH = 4096;
+
+  typedef igsioFieldMapType::mapped_type::first_type FieldFlagsType;
+
+  //----------------------------------------------------------------------------
+  // Values are stored in the byte order of the host, the index is a cache that can be rebuilt at any time
+
+  template<typename T>
+  void WriteValue(std::ostream& stream, const T& value)
+  {
+    stream.write(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  template<typename T>
+  bool ReadValue(std::istream& stream, T& value)
+  {
+    return static_cast<bool>(stream.read(reinterpret_cast<char*>(&value), sizeof(T)));
+  }
+
+  void WriteString(std::ostream& stream, const std::string& value)
+  {
+    WriteValue(stream, static_cast<vtkTypeUInt32>(value.size()));
+    stream.write(value.data(), value.size());
+  }
+
+  bool ReadString(std::istream& stream, std::string& value)
+  {
+    vtkTypeUInt32 length = 0;
+    if (!ReadValue(stream, length))
+    {
+      return false;
+    }
+    value.resize(length);
+    return length == 0 || static_cast<bool>(stream.read(&value[0], length));
+  }
+
+  //----------------------------------------------------------------------------
+  /*! 64-bit FNV-1a hash of the first HEADER_HASH_LENGTH bytes of the file, which contain the header of the sequence file */
+  vtkTypeUInt64 ComputeHeaderHash(const std::string& filename)
+  {
+    std::ifstream file(filename.c_str(), std::ios::binary);
+    char buffer[HEADER_HASH_LENGTH];
+    file.read(buffer, HEADER_HASH_LENGTH);
+    vtkTypeUInt64 hash = 14695981039346656037ULL;
+    for (std::streamsize i = 0; i < file.gcount(); ++i)
+    {
+      hash = (hash ^ static_cast<unsigned char>(buffer[i])) * 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Parse the header of an NRRD or MetaImage sequence file that starts at the current position of the stream
+    and find where the pixel data starts. Returns false if the pixel data cannot be read directly.
+  */
+  bool FindPixelDataStart(std::istream& file, const std::string& sequenceFilename, std::string& pixelDataFilename, unsigned long long& pixelDataOffset)
+  {
+    std::string line;
+    if (!std::getline(file, line))
+    {
+      return false;
+    }
+    const std::string sequenceDirectory = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(sequenceFilename));
+    pixelDataFilename.clear();
+    pixelDataOffset = 0;
+
+    if (line.compare(0, 4, "NRRD") == 0)
+    {
+      // Header fields are "name: value" or "key:=value" lines, terminated by an empty line
+      while (std::getline(file, line))
+      {
+        line = igsioCommon::Trim(line);
+        if (line.empty())
+        {
+          break;
+        }
+        if (line[0] == '#' || line.find(":=") != std::string::npos)
+        {
+          if (line.compare(0, 27, "UltrasoundImageOrientation:") == 0 && igsioCommon::Trim(line.substr(line.find(":=") + 2)) != "MF")
+          {
+            // Frames are read in the orientation in which they are stored
+            return false;
+          }
+          continue;
+        }
+        std::string::size_type separator = line.find(':');
+        if (separator == std::string::npos)
+        {
+          return false;
+        }
+        const std::string name = igsioCommon::Trim(line.substr(0, separator));
+        const std::string value = igsioCommon::Trim(line.substr(separator + 1));
+        if (name == "encoding" && value != "raw")
+        {
+          return false;
+        }
+        if ((name == "line skip" || name == "lineskip" || name == "byte skip" || name == "byteskip") && value != "0")
+        {
+          return false;
+        }
+        if (name == "data file" || name == "datafile")
+        {
+          pixelDataFilename = value;
+        }
+      }
+      if (file.eof())
+      {
+        // No pixel data follows the header
+        return false;
+      }
+    }
+    else if (igsioCommon::Trim(line.substr(0, line.find('='))) == "ObjectType")
+    {
+      // MetaImage header fields are "Name = Value" lines, ElementDataFile is the last one
+      bool elementDataFileFound = false;
+      while (!elementDataFileFound && std::getline(file, line))
+      {
+        std::string::size_type separator = line.find('=');
+        if (separator == std::string::npos)
+        {
+          return false;
+        }
+        const std::string name = igsioCommon::Trim(line.substr(0, separator));
+        const std::string value = igsioCommon::Trim(line.substr(separator + 1));
+        if (name == "CompressedData" && value != "False")
+        {
+          return false;
+        }
+        if (name == "UltrasoundImageOrientation" && value != "MF")
+        {
+          return false;
+        }
+        if (name == "ElementDataFile")
+        {
+          elementDataFileFound = true;
+          if (value != "LOCAL")
+          {
+            pixelDataFilename = value;
+          }
+        }
+      }
+      if (!elementDataFileFound)
+      {
+        return false;
+      }
+    }
+    else
+    {
+      // Not a sequence file with a text header
+      return false;
+    }
+
+    if (pixelDataFilename.empty())
+    {
+      pixelDataFilename = vtksys::SystemTools::CollapseFullPath(sequenceFilename);
+      pixelDataOffset = static_cast<unsigned long long>(file.tellg());
+    }
+    else if (!vtksys::SystemTools::FileIsFullPath(pixelDataFilename))
+    {
+      pixelDataFilename = sequenceDirectory + "/" + pixelDataFilename;
+    }
+    return true;
+  }
+}
+
+//----------------------------------------------------------------------------
+SequenceFrameIndex::SequenceFrameIndex()
+  : HasImageData(false)
+  , ScalarType(VTK_VOID)
+  , NumberOfScalarComponents(0)
+  , ImageType(US_IMG_TYPE_XX)
+  , FrameSizeInBytes(0)
+  , SequenceFileSize(0)
+  , SequenceFileModifiedTime(0)
+  , SequenceFileHeaderHash(0)
+{
+  this->FrameSize[0] = this->FrameSize[1] = this->FrameSize[2] = 0;
+}
+
+//----------------------------------------------------------------------------
+std::string SequenceFrameIndex::GetFileExtension()
+{
+  return ".frameidx";
+}
+
+//----------------------------------------------------------------------------
+std::string SequenceFrameIndex::GetIndexFileName(const std::string& sequenceFilename)
+{
+  return sequenceFilename + GetFileExtension();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::Build(const std::string& sequenceFilename, vtkIGSIOTrackedFrameList* frameList)
+{
+  SequenceFrameIndex index;
+  if (index.AddFrames(frameList) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (index.LocatePixelData(sequenceFilename) != PLUS_SUCCESS)
+  {
+    LOG_INFO("Pixel data of " << sequenceFilename << " cannot be read directly, only timestamps and frame fields are indexed");
+  }
+  return index.Write(GetIndexFileName(sequenceFilename));
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::Build(const std::string& sequenceFilename)
+{
+  vtkNew<vtkIGSIOTrackedFrameList> frameList;
+  if (vtkPlusSequenceIO::Read(sequenceFilename, frameList.GetPointer()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read sequence file for indexing: " << sequenceFilename);
+    return PLUS_FAIL;
+  }
+  return Build(sequenceFilename, frameList.GetPointer());
+}
+
+//----------------------------------------------------------------------------
+void SequenceFrameIndex::Clear()
+{
+  this->Frames.clear();
+  this->HasImageData = false;
+  this->ScalarType = VTK_VOID;
+  this->NumberOfScalarComponents = 0;
+  this->ImageType = US_IMG_TYPE_XX;
+  this->FrameSizeInBytes = 0;
+  this->FrameSize[0] = this->FrameSize[1] = this->FrameSize[2] = 0;
+  this->PixelDataFileName.clear();
+  this->SequenceFileSize = 0;
+  this->SequenceFileModifiedTime = 0;
+  this->SequenceFileHeaderHash = 0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::AddFrames(vtkIGSIOTrackedFrameList* frameList)
+{
+  if (frameList == NULL)
+  {
+    LOG_ERROR("SequenceFrameIndex::AddFrames failed: invalid frame list");
+    return PLUS_FAIL;
+  }
+  for (unsigned int i = 0; i < frameList->GetNumberOfTrackedFrames(); ++i)
+  {
+    igsioTrackedFrame* frame = frameList->GetTrackedFrame(i);
+    if (this->Frames.empty() && frame->GetImageData()->IsImageValid())
+    {
+      this->HasImageData = true;
+      this->FrameSize = frame->GetFrameSize();
+      this->ScalarType = frame->GetImageData()->GetVTKScalarPixelType();
+      frame->GetImageData()->GetNumberOfScalarComponents(this->NumberOfScalarComponents);
+      this->ImageType = frame->GetImageData()->GetImageType();
+      this->FrameSizeInBytes = frame->GetImageData()->GetFrameSizeInBytes();
+    }
+    FrameEntry entry;
+    entry.Timestamp = frame->GetTimestamp();
+    entry.PixelDataOffset = 0;
+    entry.Fields = frame->GetFrameFields();
+    this->Frames.push_back(entry);
+  }
+  // Offsets of earlier frames are invalid if the data file grows, they are set again by LocatePixelData
+  this->PixelDataFileName.clear();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::LocatePixelData(const std::string& sequenceFilename)
+{
+  this->PixelDataFileName.clear();
+  this->SequenceFileSize = vtksys::SystemTools::FileLength(sequenceFilename);
+  this->SequenceFileModifiedTime = vtksys::SystemTools::ModifiedTime(sequenceFilename);
+  this->SequenceFileHeaderHash = ComputeHeaderHash(sequenceFilename);
+  if (!this->HasImageData)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  if (ChunkedSequenceFile::IsChunkedSequenceFile(sequenceFilename))
+  {
+    return this->LocateChunkedPixelData(sequenceFilename);
+  }
+
+  std::string pixelDataFilename;
+  unsigned long long pixelDataOffset = 0;
+  std::ifstream sequenceFile(sequenceFilename.c_str(), std::ios::binary);
+  if (!sequenceFile.is_open() || !FindPixelDataStart(sequenceFile, sequenceFilename, pixelDataFilename, pixelDataOffset))
+  {
+    LOG_DEBUG("Pixel data of " << sequenceFilename << " is not stored uncompressed in MF orientation");
+    return PLUS_FAIL;
+  }
+
+  // The data file must contain exactly the indexed frames, otherwise the header was not parsed as expected
+  const unsigned long long expectedFileSize = pixelDataOffset + this->Frames.size() * this->FrameSizeInBytes;
+  const unsigned long long pixelDataFileSize = vtksys::SystemTools::FileLength(pixelDataFilename);
+  if (pixelDataFileSize != expectedFileSize)
+  {
+    LOG_DEBUG("Size of pixel data file " << pixelDataFilename << " is " << pixelDataFileSize << " bytes instead of the expected " << expectedFileSize << " bytes");
+    return PLUS_FAIL;
+  }
+
+  for (std::vector<FrameEntry>::size_type i = 0; i < this->Frames.size(); ++i)
+  {
+    this->Frames[i].PixelDataOffset = pixelDataOffset + i * this->FrameSizeInBytes;
+  }
+  this->PixelDataFileName = pixelDataFilename;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::LocateChunkedPixelData(const std::string& sequenceFilename)
+{
+  std::vector<ChunkedSequenceFile::ChunkInfo> chunks;
+  std::string chunkFileExtension;
+  if (ChunkedSequenceFile::ReadChunkLayout(sequenceFilename, chunks, chunkFileExtension) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  // Each chunk is a complete sequence file, the frames of a chunk are stored after its header
+  const std::string fullSequenceFilename = vtksys::SystemTools::CollapseFullPath(sequenceFilename);
+  std::ifstream file(sequenceFilename.c_str(), std::ios::binary);
+  std::vector<FrameEntry>::size_type frameIndex = 0;
+  for (std::vector<ChunkedSequenceFile::ChunkInfo>::const_iterator chunk = chunks.begin(); chunk != chunks.end(); ++chunk)
+  {
+    std::string pixelDataFilename;
+    unsigned long long pixelDataOffset = 0;
+    file.clear();
+    file.seekg(static_cast<std::streamoff>(chunk->Offset), std::ios::beg);
+    if (!FindPixelDataStart(file, sequenceFilename, pixelDataFilename, pixelDataOffset) || pixelDataFilename != fullSequenceFilename)
+    {
+      LOG_DEBUG("Pixel data of the chunks of " << sequenceFilename << " is not stored uncompressed in MF orientation");
+      return PLUS_FAIL;
+    }
+    if (pixelDataOffset + chunk->NumberOfFrames * this->FrameSizeInBytes != chunk->Offset + chunk->NumberOfBytes
+        || frameIndex + chunk->NumberOfFrames > this->Frames.size())
+    {
+      LOG_DEBUG("Chunk at position " << chunk->Offset << " of " << sequenceFilename << " does not contain the indexed frames");
+      return PLUS_FAIL;
+    }
+    for (unsigned int i = 0; i < chunk->NumberOfFrames; ++i, ++frameIndex)
+    {
+      this->Frames[frameIndex].PixelDataOffset = pixelDataOffset + i * this->FrameSizeInBytes;
+    }
+  }
+  if (frameIndex != this->Frames.size())
+  {
+    LOG_DEBUG("Chunks of " << sequenceFilename << " contain " << frameIndex << " frames instead of the " << this->Frames.size() << " indexed frames");
+    return PLUS_FAIL;
+  }
+  this->PixelDataFileName = fullSequenceFilename;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::Write(const std::string& indexFilename) const
+{
+  const std::string indexDirectory = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(indexFilename));
+
+  // Written to a temporary file first, so readers never see a partial index
+  const std::string temporaryFileName = indexFilename + ".tmp";
+  {
+    std::ofstream file(temporaryFileName.c_str(), std::ios::binary | std::ios::trunc);
+    if (!file.is_open())
+    {
+      LOG_ERROR("Failed to create frame index file: " << temporaryFileName);
+      return PLUS_FAIL;
+    }
+    file.write(FILE_SIGNATURE, sizeof(FILE_SIGNATURE));
+    WriteValue(file, FILE_VERSION);
+    WriteValue(file, static_cast<vtkTypeUInt64>(this->SequenceFileSize));
+    WriteValue(file, static_cast<vtkTypeInt64>(this->SequenceFileModifiedTime));
+    WriteValue(file, static_cast<vtkTypeUInt64>(this->SequenceFileHeaderHash));
+
+    WriteValue(file, static_cast<vtkTypeUInt8>(this->HasImageData ? 1 : 0));
+    for (int i = 0; i < 3; ++i)
+    {
+      WriteValue(file, static_cast<vtkTypeUInt32>(this->FrameSize[i]));
+    }
+    WriteValue(file, static_cast<vtkTypeInt32>(this->ScalarType));
+    WriteValue(file, static_cast<vtkTypeUInt32>(this->NumberOfScalarComponents));
+    WriteValue(file, static_cast<vtkTypeInt32>(this->ImageType));
+    WriteValue(file, static_cast<vtkTypeUInt64>(this->FrameSizeInBytes));
+    WriteString(file, this->PixelDataFileName.empty() ? std::string() : vtksys::SystemTools::RelativePath(indexDirectory, this->PixelDataFileName));
+
+    WriteValue(file, static_cast<vtkTypeUInt64>(this->Frames.size()));
+    for (std::vector<FrameEntry>::const_iterator it = this->Frames.begin(); it != this->Frames.end(); ++it)
+    {
+      WriteValue(file, it->Timestamp);
+      WriteValue(file, static_cast<vtkTypeUInt64>(it->PixelDataOffset));
+      WriteValue(file, static_cast<vtkTypeUInt32>(it->Fields.size()));
+      for (igsioFieldMapType::const_iterator field = it->Fields.begin(); field != it->Fields.end(); ++field)
+      {
+        WriteString(file, field->first);
+        WriteValue(file, static_cast<vtkTypeUInt32>(field->second.first));
+        WriteString(file, field->second.second);
+      }
+    }
+    file.close();
+    if (file.fail())
+    {
+      LOG_ERROR("Failed to write frame index file: " << temporaryFileName);
+      return PLUS_FAIL;
+    }
+  }
+
+  vtksys::SystemTools::RemoveFile(indexFilename);
+  if (!vtksys::SystemTools::RenameFile(temporaryFileName.c_str(), indexFilename.c_str()))
+  {
+    LOG_ERROR("Failed to replace frame index file " << indexFilename << " by " << temporaryFileName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::Read(const std::string& indexFilename)
+{
+  this->Clear();
+  std::ifstream file(indexFilename.c_str(), std::ios::binary);
+  char signature[sizeof(FILE_SIGNATURE)] = { 0 };
+  vtkTypeUInt32 version = 0;
+  if (!file.is_open() || !file.read(signature, sizeof(signature)) || !std::equal(signature, signature + sizeof(signature), FILE_SIGNATURE))
+  {
+    LOG_ERROR("Cannot read frame index file: " << indexFilename);
+    return PLUS_FAIL;
+  }
+  if (!ReadValue(file, version) || version < 1 || version > FILE_VERSION)
+  {
+    LOG_ERROR("Unsupported frame index file version " << version << " in " << indexFilename << ". Supported version: " << FILE_VERSION);
+    return PLUS_FAIL;
+  }
+
+  vtkTypeUInt64 sequenceFileSize = 0;
+  // An index of version 1 has no modification time and header hash, so it is never valid for any sequence file
+  vtkTypeInt64 sequenceFileModifiedTime = 0;
+  vtkTypeUInt64 sequenceFileHeaderHash = 0;
+  vtkTypeUInt8 hasImageData = 0;
+  vtkTypeUInt32 frameSize[3] = { 0, 0, 0 };
+  vtkTypeInt32 scalarType = 0;
+  vtkTypeUInt32 numberOfScalarComponents = 0;
+  vtkTypeInt32 imageType = 0;
+  vtkTypeUInt64 frameSizeInBytes = 0;
+  std::string pixelDataFileName;
+  vtkTypeUInt64 numberOfFrames = 0;
+  bool valid = ReadValue(file, sequenceFileSize)
+               && (version < 2 || (ReadValue(file, sequenceFileModifiedTime) && ReadValue(file, sequenceFileHeaderHash)))
+               && ReadValue(file, hasImageData)
+               && ReadValue(file, frameSize[0]) && ReadValue(file, frameSize[1]) && ReadValue(file, frameSize[2])
+               && ReadValue(file, scalarType)
+               && ReadValue(file, numberOfScalarComponents)
+               && ReadValue(file, imageType)
+               && ReadValue(file, frameSizeInBytes)
+               && ReadString(file, pixelDataFileName)
+               && ReadValue(file, numberOfFrames);
+
+  for (vtkTypeUInt64 i = 0; valid && i < numberOfFrames; ++i)
+  {
+    FrameEntry entry;
+    vtkTypeUInt64 offset = 0;
+    vtkTypeUInt32 numberOfFields = 0;
+    valid = ReadValue(file, entry.Timestamp) && ReadValue(file, offset) && ReadValue(file, numberOfFields);
+    entry.PixelDataOffset = offset;
+    for (vtkTypeUInt32 fieldIndex = 0; valid && fieldIndex < numberOfFields; ++fieldIndex)
+    {
+      std::string name;
+      vtkTypeUInt32 flags = 0;
+      std::string value;
+      valid = ReadString(file, name) && ReadValue(file, flags) && ReadString(file, value);
+      entry.Fields[name] = std::make_pair(static_cast<FieldFlagsType>(flags), value);
+    }
+    if (valid)
+    {
+      this->Frames.push_back(entry);
+    }
+  }
+  if (!valid)
+  {
+    LOG_ERROR("Frame index file is truncated or corrupted: " << indexFilename);
+    this->Clear();
+    return PLUS_FAIL;
+  }
+
+  this->SequenceFileSize = sequenceFileSize;
+  this->SequenceFileModifiedTime = sequenceFileModifiedTime;
+  this->SequenceFileHeaderHash = sequenceFileHeaderHash;
+  this->HasImageData = (hasImageData != 0);
+  for (int i = 0; i < 3; ++i)
+  {
+    this->FrameSize[i] = frameSize[i];
+  }
+  this->ScalarType = scalarType;
+  this->NumberOfScalarComponents = numberOfScalarComponents;
+  this->ImageType = static_cast<US_IMAGE_TYPE>(imageType);
+  this->FrameSizeInBytes = frameSizeInBytes;
+  if (!pixelDataFileName.empty() && !vtksys::SystemTools::FileIsFullPath(pixelDataFileName))
+  {
+    pixelDataFileName = vtksys::SystemTools::CollapseFullPath(pixelDataFileName, vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(indexFilename)));
+  }
+  this->PixelDataFileName = pixelDataFileName;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool SequenceFrameIndex::IsValidFor(const std::string& sequenceFilename) const
+{
+  // The header hash is only computed if the cheaper checks pass
+  return vtksys::SystemTools::FileExists(sequenceFilename, true)
+         && vtksys::SystemTools::FileLength(sequenceFilename) == this->SequenceFileSize
+         && vtksys::SystemTools::ModifiedTime(sequenceFilename) == this->SequenceFileModifiedTime
+         && ComputeHeaderHash(sequenceFilename) == this->SequenceFileHeaderHash;
+}
+
+//----------------------------------------------------------------------------
+bool SequenceFrameIndex::IsPixelDataLocated() const
+{
+  return !this->HasImageData || !this->PixelDataFileName.empty();
+}
+
+//----------------------------------------------------------------------------
+unsigned int SequenceFrameIndex::GetNumberOfFrames() const
+{
+  return static_cast<unsigned int>(this->Frames.size());
+}
+
+//----------------------------------------------------------------------------
+double SequenceFrameIndex::GetTimestamp(unsigned int frameIndex) const
+{
+  return this->Frames[frameIndex].Timestamp;
+}
+
+//----------------------------------------------------------------------------
+const igsioFieldMapType& SequenceFrameIndex::GetFrameFields(unsigned int frameIndex) const
+{
+  return this->Frames[frameIndex].Fields;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::FindFrameIndex(double timestamp, unsigned int& frameIndex) const
+{
+  if (this->Frames.empty())
+  {
+    return PLUS_FAIL;
+  }
+  // First frame that is not earlier than the requested timestamp
+  std::vector<FrameEntry>::size_type lower = 0;
+  std::vector<FrameEntry>::size_type upper = this->Frames.size();
+  while (lower < upper)
+  {
+    std::vector<FrameEntry>::size_type middle = lower + (upper - lower) / 2;
+    if (this->Frames[middle].Timestamp < timestamp)
+    {
+      lower = middle + 1;
+    }
+    else
+    {
+      upper = middle;
+    }
+  }
+  if (lower == this->Frames.size() || (lower > 0 && timestamp - this->Frames[lower - 1].Timestamp < this->Frames[lower].Timestamp - timestamp))
+  {
+    lower--;
+  }
+  frameIndex = static_cast<unsigned int>(lower);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::ReadFrames(unsigned int firstFrameIndex, unsigned int numberOfFrames, vtkIGSIOTrackedFrameList* frameList) const
+{
+  if (frameList == NULL || static_cast<std::vector<FrameEntry>::size_type>(firstFrameIndex) + numberOfFrames > this->Frames.size())
+  {
+    LOG_ERROR("SequenceFrameIndex::ReadFrames failed: frames " << firstFrameIndex << "-" << firstFrameIndex + numberOfFrames << " are requested from an index of " << this->Frames.size() << " frames");
+    return PLUS_FAIL;
+  }
+
+  std::ifstream pixelDataFile;
+  if (this->OpenPixelDataFile(pixelDataFile) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  for (unsigned int frameIndex = firstFrameIndex; frameIndex < firstFrameIndex + numberOfFrames; ++frameIndex)
+  {
+    igsioTrackedFrame frame;
+    if (this->ReadFrame(pixelDataFile, frameIndex, frame) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (frameList->AddTrackedFrame(&frame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameIndex << " to the frame list");
+      return PLUS_FAIL;
+    }
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::ReadFrame(unsigned int frameIndex, igsioTrackedFrame& frame) const
+{
+  if (frameIndex >= this->Frames.size())
+  {
+    LOG_ERROR("SequenceFrameIndex::ReadFrame failed: frame " << frameIndex << " is requested from an index of " << this->Frames.size() << " frames");
+    return PLUS_FAIL;
+  }
+  // Each call uses its own stream, so frames can be read concurrently
+  std::ifstream pixelDataFile;
+  if (this->OpenPixelDataFile(pixelDataFile) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  return this->ReadFrame(pixelDataFile, frameIndex, frame);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::OpenPixelDataFile(std::ifstream& pixelDataFile) const
+{
+  if (!this->IsPixelDataLocated())
+  {
+    LOG_ERROR("SequenceFrameIndex: pixel data of the frames is not located, frames cannot be read through the index");
+    return PLUS_FAIL;
+  }
+  if (!this->HasImageData)
+  {
+    return PLUS_SUCCESS;
+  }
+  pixelDataFile.open(this->PixelDataFileName.c_str(), std::ios::binary);
+  if (!pixelDataFile.is_open())
+  {
+    LOG_ERROR("Failed to open pixel data file: " << this->PixelDataFileName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFrameIndex::ReadFrame(std::istream& pixelDataFile, unsigned int frameIndex, igsioTrackedFrame& frame) const
+{
+  const FrameEntry& entry = this->Frames[frameIndex];
+  for (igsioFieldMapType::const_iterator field = entry.Fields.begin(); field != entry.Fields.end(); ++field)
+  {
+    frame.SetFrameField(field->first, field->second.second, field->second.first);
+  }
+  frame.SetTimestamp(entry.Timestamp);
+
+  if (!this->HasImageData)
+  {
+    return PLUS_SUCCESS;
+  }
+  if (frame.GetImageData()->AllocateFrame(this->FrameSize, this->ScalarType, this->NumberOfScalarComponents) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to allocate frame " << frameIndex << " of " << this->PixelDataFileName);
+    return PLUS_FAIL;
+  }
+  frame.GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF);
+  frame.GetImageData()->SetImageType(this->ImageType);
+  // The stream may be reused after a failed read
+  pixelDataFile.clear();
+  pixelDataFile.seekg(static_cast<std::streamoff>(entry.PixelDataOffset), std::ios::beg);
+  if (!pixelDataFile.read(static_cast<char*>(frame.GetImageData()->GetScalarPointer()), static_cast<std::streamsize>(this->FrameSizeInBytes)))
+  {
+    LOG_ERROR("Failed to read pixel data of frame " << frameIndex << " from " << this->PixelDataFileName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
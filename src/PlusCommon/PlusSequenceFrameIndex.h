@@ -0,0 +1,128 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusSequenceFrameIndex_h
+#define __PlusSequenceFrameIndex_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusCommonExport.h"
+
+// IGSIO includes
+#include <igsioTrackedFrame.h>
+
+// STL includes
+#include <fstream>
+#include <string>
+#include <vector>
+
+class vtkIGSIOTrackedFrameList;
+
+/*!
+\class SequenceFrameIndex
+\brief Binary sidecar index of a sequence file for reading individual frames without loading the whole sequence
+
+The index stores the timestamp and the frame fields of each frame, and, if the pixel data of the sequence
+is not compressed, the byte offset of each frame in the file that contains the pixel data. Frames can then
+be looked up by index or timestamp and read by a single seek. In a chunked sequence file the pixel data of uncompressed
+chunks is located the same way. The index of a sequence file is stored next to
+it, with the GetFileExtension() extension appended to the sequence file name.
+
+The index is written by the capture device when the sequence file is finalized (if enabled) and can be
+built for any existing sequence file by Build. It records the size, the modification time and a hash of the
+header of the sequence file, so an index that does not belong to the current version of the file is not used.
+
+\ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport SequenceFrameIndex
+{
+public:
+  SequenceFrameIndex();
+
+  /*! Extension that is appended to the sequence file name to get the index file name */
+  static std::string GetFileExtension();
+
+  /*! Name of the index file of a sequence file */
+  static std::string GetIndexFileName(const std::string& sequenceFilename);
+
+  /*! Build the index of the frames and write it next to the sequence file. The frames must be the contents of the sequence file. */
+  static PlusStatus Build(const std::string& sequenceFilename, vtkIGSIOTrackedFrameList* frameList);
+
+  /*! Read the sequence file once and write its index next to it */
+  static PlusStatus Build(const std::string& sequenceFilename);
+
+  /*! Remove all frames from the index */
+  void Clear();
+
+  /*! Append the frames to the index. Image properties are taken from the first frame of the index. */
+  PlusStatus AddFrames(vtkIGSIOTrackedFrameList* frameList);
+
+  /*!
+    Find the pixel data of the indexed frames in the sequence file. Only the header of the file (or the headers of the chunks
+    of a chunked sequence file, see ChunkedSequenceFile) is parsed.
+    Returns PLUS_FAIL if the pixel data cannot be read directly (e.g., it is compressed), frame fields are still available then.
+  */
+  PlusStatus LocatePixelData(const std::string& sequenceFilename);
+
+  PlusStatus Write(const std::string& indexFilename) const;
+  PlusStatus Read(const std::string& indexFilename);
+
+  /*! Returns true if the index was built for the current contents of the sequence file */
+  bool IsValidFor(const std::string& sequenceFilename) const;
+
+  /*! Returns true if pixel data of the frames can be read directly */
+  bool IsPixelDataLocated() const;
+
+  unsigned int GetNumberOfFrames() const;
+  double GetTimestamp(unsigned int frameIndex) const;
+  const igsioFieldMapType& GetFrameFields(unsigned int frameIndex) const;
+
+  /*! Index of the frame that has the closest timestamp to the requested one. Frames must be ordered by timestamp. */
+  PlusStatus FindFrameIndex(double timestamp, unsigned int& frameIndex) const;
+
+  /*! Read frames from the pixel data file and append them to the frame list. Frame fields are taken from the index. */
+  PlusStatus ReadFrames(unsigned int firstFrameIndex, unsigned int numberOfFrames, vtkIGSIOTrackedFrameList* frameList) const;
+
+  /*! Read a single frame from the pixel data file. The file is opened for each call, so it may be called from multiple threads. */
+  PlusStatus ReadFrame(unsigned int frameIndex, igsioTrackedFrame& frame) const;
+
+  /*! Open the pixel data file, for reading many frames by the ReadFrame overload that takes the opened file */
+  PlusStatus OpenPixelDataFile(std::ifstream& pixelDataFile) const;
+
+  /*! Set the fields and read the image of a frame. The pixel data file is only accessed if the frames have image data. */
+  PlusStatus ReadFrame(std::istream& pixelDataFile, unsigned int frameIndex, igsioTrackedFrame& frame) const;
+
+protected:
+
+  /*! Find the pixel data of the indexed frames in the chunks of a chunked sequence file */
+  PlusStatus LocateChunkedPixelData(const std::string& sequenceFilename);
+
+  struct FrameEntry
+  {
+    double Timestamp;
+    /*! Position of the pixel data of the frame in PixelDataFileName */
+    unsigned long long PixelDataOffset;
+    igsioFieldMapType Fields;
+  };
+
+  std::vector<FrameEntry> Frames;
+
+  /*! Image properties, shared by all frames of a sequence */
+  bool HasImageData;
+  FrameSizeType FrameSize;
+  int ScalarType;
+  unsigned int NumberOfScalarComponents;
+  US_IMAGE_TYPE ImageType;
+  unsigned long long FrameSizeInBytes;
+
+  /*! Full path of the file that contains the pixel data. Empty if the pixel data is not located. */
+  std::string PixelDataFileName;
+  /*! Size, modification time and header hash of the indexed sequence file, to detect an index that belongs to a different version of the file */
+  unsigned long long SequenceFileSize;
+  long long SequenceFileModifiedTime;
+  unsigned long long SequenceFileHeaderHash;
+};
+
+#endif  //__PlusSequenceFrameIndex_h
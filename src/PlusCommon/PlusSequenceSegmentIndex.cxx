@@ -0,0 +1,269 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusSequenceSegmentIndex.h"
+#include "vtkPlusSequenceIO.h"
+
+// IGSIO includes
+#include <vtkIGSIOTrackedFrameList.h>
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtksys/SystemTools.hxx>
+
+// STL includes
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  const char FILE_SIGNATURE[] = "PLUS_SEGMENTED_SEQUENCE";
+  const int FILE_VERSION = 1;
+  const char VERSION_FIELD_NAME[] = "Version";
+  const char SEGMENT_FIELD_NAME[] = "Segment";
+}
+
+//----------------------------------------------------------------------------
+SequenceSegmentIndex::SequenceSegmentIndex()
+{
+}
+
+//----------------------------------------------------------------------------
+std::string SequenceSegmentIndex::GetFileExtension()
+{
+  return ".seqindex";
+}
+
+//----------------------------------------------------------------------------
+bool SequenceSegmentIndex::IsSequenceSegmentIndexFile(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::binary);
+  std::string line;
+  return file.is_open() && std::getline(file, line) && igsioCommon::Trim(line) == FILE_SIGNATURE;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceSegmentIndex::Read(const std::string& filename, vtkIGSIOTrackedFrameList* frameList)
+{
+  SequenceSegmentIndex index;
+  if (index.ReadIndexFile(filename) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  for (unsigned int segmentIndex = 0; segmentIndex < index.GetNumberOfSegments(); ++segmentIndex)
+  {
+    const std::string& segmentFilename = index.GetSegmentFileName(segmentIndex);
+    vtkNew<vtkIGSIOTrackedFrameList> segmentFrameList;
+    if (vtkPlusSequenceIO::Read(segmentFilename, segmentFrameList.GetPointer()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read segment " << segmentIndex << " of " << filename << ": " << segmentFilename);
+      return PLUS_FAIL;
+    }
+    if (segmentFrameList->GetNumberOfTrackedFrames() != index.GetSegmentNumberOfFrames(segmentIndex))
+    {
+      LOG_ERROR("Segment " << segmentFilename << " contains " << segmentFrameList->GetNumberOfTrackedFrames() << " frames instead of " << index.GetSegmentNumberOfFrames(segmentIndex));
+      return PLUS_FAIL;
+    }
+    if (frameList->AddTrackedFrameList(segmentFrameList.GetPointer()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frames of segment " << segmentFilename);
+      return PLUS_FAIL;
+    }
+  }
+
+  LOG_DEBUG("Read " << index.GetNumberOfSegments() << " segments from " << filename);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceSegmentIndex::ReadIndexFile(const std::string& filename)
+{
+  this->Initialize(filename);
+  std::ifstream file(filename.c_str());
+  std::string line;
+  if (!file.is_open() || !std::getline(file, line) || igsioCommon::Trim(line) != FILE_SIGNATURE)
+  {
+    LOG_ERROR("Cannot read segment index file: " << filename);
+    return PLUS_FAIL;
+  }
+
+  const std::string indexDirectory = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(filename));
+  while (std::getline(file, line))
+  {
+    line = igsioCommon::Trim(line);
+    if (line.empty())
+    {
+      continue;
+    }
+    std::string::size_type separator = line.find('=');
+    if (separator == std::string::npos)
+    {
+      LOG_ERROR("Invalid line in segment index file " << filename << ": " << line);
+      this->Segments.clear();
+      return PLUS_FAIL;
+    }
+    const std::string name = igsioCommon::Trim(line.substr(0, separator));
+    const std::string value = igsioCommon::Trim(line.substr(separator + 1));
+
+    if (name == VERSION_FIELD_NAME)
+    {
+      int version = 0;
+      if (igsioCommon::StringToNumber<int>(value, version) != PLUS_SUCCESS || version < 1 || version > FILE_VERSION)
+      {
+        LOG_ERROR("Unsupported segment index file version " << value << " in " << filename << ". Supported version: " << FILE_VERSION);
+        this->Segments.clear();
+        return PLUS_FAIL;
+      }
+    }
+    else if (name == SEGMENT_FIELD_NAME)
+    {
+      // The segment file path is the rest of the line, so it may contain spaces
+      std::istringstream segmentDescription(value);
+      Segment segment;
+      if (!(segmentDescription >> segment.NumberOfFrames) || !std::getline(segmentDescription, segment.FileName) || igsioCommon::Trim(segment.FileName).empty())
+      {
+        LOG_ERROR("Invalid segment description in segment index file " << filename << ": " << line);
+        this->Segments.clear();
+        return PLUS_FAIL;
+      }
+      segment.FileName = igsioCommon::Trim(segment.FileName);
+      if (!vtksys::SystemTools::FileIsFullPath(segment.FileName))
+      {
+        segment.FileName = indexDirectory + "/" + segment.FileName;
+      }
+      this->Segments.push_back(segment);
+    }
+    // Unknown fields are ignored, they may be added by later versions without breaking the format
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void SequenceSegmentIndex::Initialize(const std::string& filename)
+{
+  this->FileName = filename;
+  this->Segments.clear();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceSegmentIndex::AddSegment(const std::string& segmentFilename, unsigned int numberOfFrames)
+{
+  Segment segment;
+  segment.FileName = vtksys::SystemTools::CollapseFullPath(segmentFilename);
+  segment.NumberOfFrames = numberOfFrames;
+  this->Segments.push_back(segment);
+  return this->WriteIndexFile();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceSegmentIndex::Rename(const std::string& filename)
+{
+  if (filename == this->FileName)
+  {
+    return PLUS_SUCCESS;
+  }
+  const std::string previousFileName = this->FileName;
+  this->FileName = filename;
+  if (this->Segments.empty())
+  {
+    // The index file is not written yet
+    return PLUS_SUCCESS;
+  }
+  // Relative segment paths depend on the location of the index file, so it is written again
+  if (this->WriteIndexFile() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  vtksys::SystemTools::RemoveFile(previousFileName);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void SequenceSegmentIndex::Discard()
+{
+  for (std::vector<Segment>::iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
+  {
+    vtksys::SystemTools::RemoveFile(it->FileName);
+  }
+  if (!this->Segments.empty())
+  {
+    vtksys::SystemTools::RemoveFile(this->FileName);
+  }
+  this->Segments.clear();
+}
+
+//----------------------------------------------------------------------------
+const std::string& SequenceSegmentIndex::GetFileName() const
+{
+  return this->FileName;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SequenceSegmentIndex::GetNumberOfSegments() const
+{
+  return static_cast<unsigned int>(this->Segments.size());
+}
+
+//----------------------------------------------------------------------------
+const std::string& SequenceSegmentIndex::GetSegmentFileName(unsigned int segmentIndex) const
+{
+  return this->Segments[segmentIndex].FileName;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SequenceSegmentIndex::GetSegmentNumberOfFrames(unsigned int segmentIndex) const
+{
+  return this->Segments[segmentIndex].NumberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+unsigned long SequenceSegmentIndex::GetNumberOfFrames() const
+{
+  unsigned long numberOfFrames = 0;
+  for (std::vector<Segment>::const_iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
+  {
+    numberOfFrames += it->NumberOfFrames;
+  }
+  return numberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceSegmentIndex::WriteIndexFile() const
+{
+  const std::string indexDirectory = vtksys::SystemTools::GetFilenamePath(vtksys::SystemTools::CollapseFullPath(this->FileName));
+
+  // The complete index is written to a temporary file first, so a crash never leaves a partial index behind
+  const std::string temporaryFileName = this->FileName + ".tmp";
+  {
+    std::ofstream file(temporaryFileName.c_str(), std::ios::trunc);
+    if (!file.is_open())
+    {
+      LOG_ERROR("Failed to create segment index file: " << temporaryFileName);
+      return PLUS_FAIL;
+    }
+    file << FILE_SIGNATURE << "\n";
+    file << VERSION_FIELD_NAME << " = " << FILE_VERSION << "\n";
+    for (std::vector<Segment>::const_iterator it = this->Segments.begin(); it != this->Segments.end(); ++it)
+    {
+      file << SEGMENT_FIELD_NAME << " = " << it->NumberOfFrames << " " << vtksys::SystemTools::RelativePath(indexDirectory, it->FileName) << "\n";
+    }
+    file.close();
+    if (file.fail())
+    {
+      LOG_ERROR("Failed to write segment index file: " << temporaryFileName);
+      return PLUS_FAIL;
+    }
+  }
+
+  if (!vtksys::SystemTools::RenameFile(temporaryFileName.c_str(), this->FileName.c_str()))
+  {
+    LOG_ERROR("Failed to replace segment index file " << this->FileName << " by " << temporaryFileName);
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
@@ -0,0 +1,87 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusSequenceSegmentIndex_h
+#define __PlusSequenceSegmentIndex_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusCommonExport.h"
+
+// STL includes
+#include <string>
+#include <vector>
+
+class vtkIGSIOTrackedFrameList;
+
+/*!
+\class SequenceSegmentIndex
+\brief Index of segment files that together form one logical sequence
+
+Long recordings can be split into segment files that are finalized independently. The index file lists the
+finalized segments in recording order:
+
+\verbatim
+PLUS_SEGMENTED_SEQUENCE
+Version = 1
+Segment = <numberOfFrames> <segment file path, relative to the index file>
+\endverbatim
+
+The index file is rewritten (through a temporary file) each time a segment is added, so it always refers to
+complete segment files only. vtkPlusSequenceIO::Read reads an index file as a single sequence.
+
+\ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport SequenceSegmentIndex
+{
+public:
+  SequenceSegmentIndex();
+
+  /*! Extension of segment index files */
+  static std::string GetFileExtension();
+
+  /*! Returns true if the file starts with the segment index file signature */
+  static bool IsSequenceSegmentIndexFile(const std::string& filename);
+
+  /*! Read the frames of all segments listed in the index file and append them to the frame list */
+  static PlusStatus Read(const std::string& filename, vtkIGSIOTrackedFrameList* frameList);
+
+  /*! Read the list of segments from the index file, without reading the segment files */
+  PlusStatus ReadIndexFile(const std::string& filename);
+
+  /*! Start a new index without any segments. The index file is written when the first segment is added. */
+  void Initialize(const std::string& filename);
+
+  /*! Append a finalized segment file to the index and update the index file */
+  PlusStatus AddSegment(const std::string& segmentFilename, unsigned int numberOfFrames);
+
+  /*! Move the index file. Segment files keep their names, the index refers to them by relative path. */
+  PlusStatus Rename(const std::string& filename);
+
+  /*! Delete the index file and all segment files listed in it */
+  void Discard();
+
+  const std::string& GetFileName() const;
+  unsigned int GetNumberOfSegments() const;
+  /*! Full path of a segment file */
+  const std::string& GetSegmentFileName(unsigned int segmentIndex) const;
+  unsigned int GetSegmentNumberOfFrames(unsigned int segmentIndex) const;
+  unsigned long GetNumberOfFrames() const;
+
+protected:
+  PlusStatus WriteIndexFile() const;
+
+  struct Segment
+  {
+    /*! Full path of the segment file */
+    std::string FileName;
+    unsigned int NumberOfFrames;
+  };
+
+  std::string FileName;
+  std::vector<Segment> Segments;
+};
+
+#endif  //__PlusSequenceSegmentIndex_h
@@ -0,0 +1,153 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusWorkerPool.h"
+
+//----------------------------------------------------------------------------
+WorkerPool::WorkerPool()
+  : NumberOfThreads(1)
+  , StopRequested(false)
+  , JobId(0)
+  , JobOpen(false)
+  , JobTask(NULL)
+  , JobNumberOfTasks(0)
+  , NextTask(0)
+  , NumberOfCompletedTasks(0)
+  , NumberOfActiveWorkers(0)
+{
+}
+
+//----------------------------------------------------------------------------
+WorkerPool::~WorkerPool()
+{
+  std::lock_guard<std::mutex> jobLock(this->JobMutex);
+  this->StopWorkers();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus WorkerPool::SetNumberOfThreads(int numberOfThreads)
+{
+  if (numberOfThreads < 1)
+  {
+    LOG_ERROR("Invalid number of worker pool threads: " << numberOfThreads << ". It must be at least 1.");
+    return PLUS_FAIL;
+  }
+
+  std::lock_guard<std::mutex> jobLock(this->JobMutex);
+  if (numberOfThreads == this->NumberOfThreads)
+  {
+    return PLUS_SUCCESS;
+  }
+  this->StopWorkers();
+  this->StopRequested = false;
+  for (int i = 1; i < numberOfThreads; ++i)
+  {
+    this->Workers.push_back(std::thread(&WorkerPool::WorkerThreadMain, this));
+  }
+  this->NumberOfThreads = numberOfThreads;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int WorkerPool::GetNumberOfThreads() const
+{
+  return this->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+void WorkerPool::StopWorkers()
+{
+  {
+    std::lock_guard<std::mutex> stateLock(this->StateMutex);
+    this->StopRequested = true;
+  }
+  this->JobStartedCondition.notify_all();
+  for (std::vector<std::thread>::iterator it = this->Workers.begin(); it != this->Workers.end(); ++it)
+  {
+    it->join();
+  }
+  this->Workers.clear();
+  this->NumberOfThreads = 1;
+}
+
+//----------------------------------------------------------------------------
+void WorkerPool::Run(int numberOfTasks, const std::function<void(int)>& task)
+{
+  std::unique_lock<std::mutex> jobLock(this->JobMutex, std::try_to_lock);
+  if (!jobLock.owns_lock() || this->Workers.empty() || numberOfTasks < 2)
+  {
+    // Busy or nothing to share, run all tasks on the calling thread
+    for (int i = 0; i < numberOfTasks; ++i)
+    {
+      task(i);
+    }
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> stateLock(this->StateMutex);
+    this->JobTask = &task;
+    this->JobNumberOfTasks = numberOfTasks;
+    this->NextTask = 0;
+    this->NumberOfCompletedTasks = 0;
+    this->JobOpen = true;
+    this->JobId++;
+  }
+  this->JobStartedCondition.notify_all();
+
+  const int numberOfProcessedTasks = this->ProcessTasks();
+
+  std::unique_lock<std::mutex> stateLock(this->StateMutex);
+  this->NumberOfCompletedTasks += numberOfProcessedTasks;
+  while (this->NumberOfCompletedTasks < this->JobNumberOfTasks || this->NumberOfActiveWorkers > 0)
+  {
+    this->JobCompletedCondition.wait(stateLock);
+  }
+  // Workers that wake up later must not access the task, which is owned by the caller
+  this->JobOpen = false;
+  this->JobTask = NULL;
+}
+
+//----------------------------------------------------------------------------
+int WorkerPool::ProcessTasks()
+{
+  int numberOfProcessedTasks = 0;
+  for (int i = this->NextTask++; i < this->JobNumberOfTasks; i = this->NextTask++)
+  {
+    (*this->JobTask)(i);
+    numberOfProcessedTasks++;
+  }
+  return numberOfProcessedTasks;
+}
+
+//----------------------------------------------------------------------------
+void WorkerPool::WorkerThreadMain()
+{
+  unsigned long lastJobId = 0;
+  std::unique_lock<std::mutex> stateLock(this->StateMutex);
+  while (true)
+  {
+    while (!this->StopRequested && !(this->JobOpen && this->JobId != lastJobId))
+    {
+      this->JobStartedCondition.wait(stateLock);
+    }
+    if (this->StopRequested)
+    {
+      return;
+    }
+    lastJobId = this->JobId;
+    this->NumberOfActiveWorkers++;
+    stateLock.unlock();
+
+    const int numberOfProcessedTasks = this->ProcessTasks();
+
+    stateLock.lock();
+    this->NumberOfCompletedTasks += numberOfProcessedTasks;
+    this->NumberOfActiveWorkers--;
+    this->JobCompletedCondition.notify_all();
+  }
+}
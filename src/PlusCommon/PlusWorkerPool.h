@@ -0,0 +1,78 @@
+/*=Plus=header=begin======================================================
+Program: Plus
+Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusWorkerPool_h
+#define __PlusWorkerPool_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusCommonExport.h"
+
+// STL includes
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*!
+\class WorkerPool
+\brief Fixed set of worker threads that run the tasks of a job in parallel with the calling thread
+
+Run executes tasks 0..numberOfTasks-1 and returns when all of them are completed. The calling thread
+processes tasks as well, so a pool of N threads has N-1 worker threads. The pool runs one job at a time:
+if another thread is already running a job then the tasks are executed on the calling thread, so callers
+never wait for each other.
+\ingroup PlusLibCommon
+*/
+class vtkPlusCommonExport WorkerPool
+{
+public:
+  WorkerPool();
+  ~WorkerPool();
+
+  /*! Set the number of threads that run the tasks of a job, including the calling thread. Blocks until the running job is completed. */
+  PlusStatus SetNumberOfThreads(int numberOfThreads);
+  int GetNumberOfThreads() const;
+
+  /*! Execute task(i) for i = 0..numberOfTasks-1 and wait until all of them are completed */
+  void Run(int numberOfTasks, const std::function<void(int)>& task);
+
+protected:
+  void StopWorkers();
+  void WorkerThreadMain();
+
+  /*! Process tasks of the current job until none is left. Returns the number of processed tasks. */
+  int ProcessTasks();
+
+  /*! Held while a job is running or the workers are restarted */
+  std::mutex JobMutex;
+
+  /*! Protects the job state below */
+  std::mutex StateMutex;
+  std::condition_variable JobStartedCondition;
+  std::condition_variable JobCompletedCondition;
+
+  std::vector<std::thread> Workers;
+  std::atomic<int> NumberOfThreads;
+  bool StopRequested;
+
+  /*! Incremented for each job, so that workers only join a job once */
+  unsigned long JobId;
+  /*! True from the start of a job until all tasks are completed and all workers left it */
+  bool JobOpen;
+  const std::function<void(int)>* JobTask;
+  int JobNumberOfTasks;
+  std::atomic<int> NextTask;
+  int NumberOfCompletedTasks;
+  int NumberOfActiveWorkers;
+
+private:
+  WorkerPool(const WorkerPool&);
+  void operator=(const WorkerPool&);
+};
+
+#endif  //__PlusWorkerPool_h
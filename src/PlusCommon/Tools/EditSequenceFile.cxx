@@ -7,6 +7,7 @@ See License.txt for details.
 // Local includes
 #include "PlusConfigure.h"
 #include "PlusMath.h"
+#include "PlusSequenceFrameIndex.h"
 #include "igsioTrackedFrame.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkIGSIOTrackedFrameList.h"
@@ -38,6 +39,7 @@ enum OperationType
   CROP,
   REMOVE_IMAGE_DATA,
   DECIMATE,
+  BUILD_FRAME_INDEX,
   NO_OPERATION
 };
 
@@ -81,6 +83,47 @@ namespace
   const std::string FIELD_VALUE_FRAME_TRANSFORM = "{frame-transform}";
 }
 
+//----------------------------------------------------------------------------
+// Read the timestamps and frame fields of a sequence file. Images are only read if the file has no up-to-date frame index.
+PlusStatus ReadFrameFields(const std::string& inputFileName, vtkIGSIOTrackedFrameList* trackedFrameList)
+{
+  SequenceFrameIndex index;
+  if (vtkPlusSequenceIO::OpenFrameIndex(inputFileName, index, false) != PLUS_SUCCESS)
+  {
+    return vtkPlusSequenceIO::Read(inputFileName, trackedFrameList);
+  }
+  for (unsigned int frameIndex = 0; frameIndex < index.GetNumberOfFrames(); ++frameIndex)
+  {
+    igsioTrackedFrame frame;
+    const igsioFieldMapType& fields = index.GetFrameFields(frameIndex);
+    for (igsioFieldMapType::const_iterator field = fields.begin(); field != fields.end(); ++field)
+    {
+      frame.SetFrameField(field->first, field->second.second, field->second.first);
+    }
+    frame.SetTimestamp(index.GetTimestamp(frameIndex));
+    if (trackedFrameList->AddTrackedFrame(&frame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameIndex << " of sequence file " << inputFileName);
+      return PLUS_FAIL;
+    }
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+// Read a range of frames of a sequence file through its frame index, without reading the whole file.
+// Fails if the file has no up-to-date frame index that locates the pixel data of the frames.
+PlusStatus ReadIndexedFrameRange(const std::string& inputFileName, unsigned int firstFrameIndex, unsigned int lastFrameIndex, vtkIGSIOTrackedFrameList* trackedFrameList)
+{
+  SequenceFrameIndex index;
+  if (vtkPlusSequenceIO::OpenFrameIndex(inputFileName, index) != PLUS_SUCCESS
+      || lastFrameIndex >= index.GetNumberOfFrames() || firstFrameIndex > lastFrameIndex)
+  {
+    return PLUS_FAIL;
+  }
+  return index.ReadFrames(firstFrameIndex, lastFrameIndex - firstFrameIndex + 1, trackedFrameList);
+}
+
 // Fuse all fields in sequence files into the first sequence
 //----------------------------------------------------------------------------
 PlusStatus MixTrackedFrameLists(vtkIGSIOTrackedFrameList* trackedFrameList, std::vector<std::string> inputFileNames)
@@ -106,8 +149,9 @@ PlusStatus MixTrackedFrameLists(vtkIGSIOTrackedFrameList* trackedFrameList, std:
   for (unsigned int i = 1; i < inputFileNames.size(); i++)
   {
     LOG_INFO("Read input sequence file: " << inputFileNames[i]);
+    // Only the frame fields of the additional sequences are used
     vtkSmartPointer<vtkIGSIOTrackedFrameList> additionalTrackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
-    if (vtkPlusSequenceIO::Read(inputFileNames[i], additionalTrackedFrameList) != PLUS_SUCCESS)
+    if (ReadFrameFields(inputFileNames[i], additionalTrackedFrameList) != PLUS_SUCCESS)
     {
       LOG_ERROR("Couldn't read sequence file: " << inputFileNames[0]);
       return PLUS_FAIL;
@@ -340,6 +384,8 @@ int main(int argc, char** argv)
     std::cout << "  Requires --rect-origin and --rect-size. (e.g., --rect-size 56 78). Optional: --flip*." << std::endl;
 
     std::cout << "- REMOVE_IMAGE_DATA: Remove image data from a meta file that has both image and tracker data, and keep only the tracker data." << std::endl;
+    std::cout << "- BUILD_FRAME_INDEX: Write a frame index file next to each input sequence file, for reading frames without loading the whole sequence." << std::endl;
+    std::cout << "  The input files are not modified, no output file is written." << std::endl;
 
     return EXIT_SUCCESS;
   }
@@ -353,12 +399,6 @@ int main(int argc, char** argv)
     return EXIT_FAILURE;
   }
 
-  if (outputFileName.empty())
-  {
-    LOG_ERROR("Please set output file name!");
-    return EXIT_FAILURE;
-  }
-
   // Set operation
   if (strOperation.empty())
   {
@@ -432,12 +472,22 @@ int main(int argc, char** argv)
   {
     operation = REMOVE_IMAGE_DATA;
   }
+  else if (igsioCommon::IsEqualInsensitive(strOperation, "BUILD_FRAME_INDEX"))
+  {
+    operation = BUILD_FRAME_INDEX;
+  }
   else
   {
     LOG_ERROR("Invalid operation selected: " << strOperation);
     return EXIT_FAILURE;
   }
 
+  if (outputFileName.empty() && operation != BUILD_FRAME_INDEX)
+  {
+    LOG_ERROR("Please set output file name!");
+    return EXIT_FAILURE;
+  }
+
   // Convert strings transforms to vtkMatrix
   if (ConvertStringToMatrix(strFrameTransformStart, frameTransformStart) != PLUS_SUCCESS)
   {
@@ -462,14 +512,48 @@ int main(int argc, char** argv)
     inputFileNames.insert(inputFileNames.begin(), inputFileName);
   }
 
+  if (operation == BUILD_FRAME_INDEX)
+  {
+    // Each input file is indexed separately, they are not combined
+    for (std::vector<std::string>::iterator it = inputFileNames.begin(); it != inputFileNames.end(); ++it)
+    {
+      LOG_INFO("Build frame index of sequence file: " << *it);
+      if (SequenceFrameIndex::Build(*it) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Couldn't build frame index of sequence file: " << *it);
+        return EXIT_FAILURE;
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  if (firstFrameIndex < 0)
+  {
+    firstFrameIndex = 0;
+  }
+  if (lastFrameIndex < 0)
+  {
+    lastFrameIndex = 0;
+  }
+  const unsigned int firstFrameIndexUint = static_cast<unsigned int>(firstFrameIndex);
+  const unsigned int lastFrameIndexUint = static_cast<unsigned int>(lastFrameIndex);
+
   // Multiple input files are appended unless sequences are mixed
   PlusStatus status = PLUS_SUCCESS;
+  bool isTrimmedWhileReading = false;
   if (operation == MIX)
   {
     status = MixTrackedFrameLists(trackedFrameList, inputFileNames);
   }
+  else if (operation == TRIM && inputFileNames.size() == 1
+           && ReadIndexedFrameRange(inputFileNames[0], firstFrameIndexUint, lastFrameIndexUint, trackedFrameList) == PLUS_SUCCESS)
+  {
+    // Only the frames of the trimmed range are read from an indexed sequence file
+    isTrimmedWhileReading = true;
+  }
   else
   {
+    trackedFrameList->Clear();
     status = AppendTrackedFrameLists(trackedFrameList, inputFileNames, incrementTimestamps);
   }
   if (status == PLUS_FAIL)
@@ -491,17 +575,7 @@ int main(int argc, char** argv)
       break;
     case TRIM:
       {
-        if (firstFrameIndex < 0)
-        {
-          firstFrameIndex = 0;
-        }
-        if (lastFrameIndex < 0)
-        {
-          lastFrameIndex = 0;
-        }
-        unsigned int firstFrameIndexUint = static_cast<unsigned int>(firstFrameIndex);
-        unsigned int lastFrameIndexUint = static_cast<unsigned int>(lastFrameIndex);
-        if (TrimSequenceFile(trackedFrameList, firstFrameIndexUint, lastFrameIndexUint) != PLUS_SUCCESS)
+        if (!isTrimmedWhileReading && TrimSequenceFile(trackedFrameList, firstFrameIndexUint, lastFrameIndexUint) != PLUS_SUCCESS)
         {
           LOG_ERROR("Failed to trim sequence file");
           return EXIT_FAILURE;
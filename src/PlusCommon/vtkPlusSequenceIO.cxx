@@ -5,13 +5,36 @@
 =========================================================Plus=header=end*/
 
 #include "PlusConfigure.h"
+#include "PlusChunkedSequenceFile.h"
+#include "PlusSequenceFrameIndex.h"
+#include "PlusSequenceSegmentIndex.h"
 #include "vtkPlusSequenceIO.h"
 
 #include <vtkIGSIOSequenceIO.h>
+#include <vtkIGSIOTrackedFrameList.h>
 
 /// VTK includes
 #include <vtkNew.h>
 
+namespace
+{
+  //----------------------------------------------------------------------------
+  /*! If file is not found in the current directory then try to find it in the image directory, too */
+  igsioStatus FindSequenceFile(const std::string& trackedSequenceDataFileName, std::string& trackedSequenceDataFilePath)
+  {
+    trackedSequenceDataFilePath = trackedSequenceDataFileName;
+    if (!vtksys::SystemTools::FileExists(trackedSequenceDataFilePath.c_str(), true))
+    {
+      if (vtkPlusConfig::GetInstance()->FindImagePath(trackedSequenceDataFileName, trackedSequenceDataFilePath) == PLUS_FAIL)
+      {
+        LOG_ERROR("Cannot find sequence metafile: " << trackedSequenceDataFileName);
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
 //----------------------------------------------------------------------------
 igsioStatus vtkPlusSequenceIO::Write(const std::string& filename, vtkIGSIOTrackedFrameList* frameList, US_IMAGE_ORIENTATION orientationInFile/*=US_IMG_ORIENT_MF*/, bool useCompression/*=true*/, bool enableImageDataWrite/*=true*/)
 {
@@ -37,16 +60,120 @@ igsioStatus vtkPlusSequenceIO::Write(const std::string& filename, igsioTrackedFr
 //----------------------------------------------------------------------------
 igsioStatus vtkPlusSequenceIO::Read(const std::string& trackedSequenceDataFileName, vtkIGSIOTrackedFrameList* frameList)
 {
-  std::string trackedSequenceDataFilePath = trackedSequenceDataFileName;
+  std::string trackedSequenceDataFilePath;
+  if (FindSequenceFile(trackedSequenceDataFileName, trackedSequenceDataFilePath) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
 
-  // If file is not found in the current directory then try to find it in the image directory, too
-  if (!vtksys::SystemTools::FileExists(trackedSequenceDataFilePath.c_str(), true))
+  // Segmented recordings are read as one sequence through their index file
+  if (SequenceSegmentIndex::IsSequenceSegmentIndexFile(trackedSequenceDataFilePath))
+  {
+    return SequenceSegmentIndex::Read(trackedSequenceDataFilePath, frameList);
+  }
+  // Chunked sequence files are written by the capture device when compression runs on multiple threads
+  if (ChunkedSequenceFile::IsChunkedSequenceFile(trackedSequenceDataFilePath))
   {
-    if (vtkPlusConfig::GetInstance()->FindImagePath(trackedSequenceDataFileName, trackedSequenceDataFilePath) == PLUS_FAIL)
+    return ChunkedSequenceFile::Read(trackedSequenceDataFilePath, frameList);
+  }
+  return vtkIGSIOSequenceIO::Read(trackedSequenceDataFilePath, frameList);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkPlusSequenceIO::ReadFrames(const std::string& trackedSequenceDataFileName, unsigned int firstFrameIndex, unsigned int numberOfFrames, vtkIGSIOTrackedFrameList* frameList)
+{
+  std::string trackedSequenceDataFilePath;
+  if (FindSequenceFile(trackedSequenceDataFileName, trackedSequenceDataFilePath) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  // The index is built once if it is missing or outdated, later calls only read the requested frames
+  SequenceFrameIndex index;
+  if (OpenFrameIndex(trackedSequenceDataFilePath, index, false) != PLUS_SUCCESS)
+  {
+    LOG_INFO("Sequence file " << trackedSequenceDataFilePath << " has no up-to-date frame index, it is built now");
+    if (SequenceFrameIndex::Build(trackedSequenceDataFilePath) != PLUS_SUCCESS || OpenFrameIndex(trackedSequenceDataFilePath, index, false) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Cannot find sequence metafile: " << trackedSequenceDataFileName);
+      LOG_ERROR("Failed to build the frame index of sequence file " << trackedSequenceDataFilePath);
       return PLUS_FAIL;
     }
   }
-  return vtkIGSIOSequenceIO::Read(trackedSequenceDataFilePath, frameList);
+  if (!index.IsPixelDataLocated())
+  {
+    LOG_ERROR("Frames of sequence file " << trackedSequenceDataFilePath << " cannot be read individually, because the pixel data cannot be located (e.g., it is compressed). "
+              << "Read the whole sequence by vtkPlusSequenceIO::Read or save it without compression.");
+    return PLUS_FAIL;
+  }
+  return index.ReadFrames(firstFrameIndex, numberOfFrames, frameList);
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkPlusSequenceIO::OpenFrameIndex(const std::string& trackedSequenceDataFileName, SequenceFrameIndex& index, bool pixelDataRequired/*=true*/)
+{
+  index.Clear();
+  std::string trackedSequenceDataFilePath;
+  if (FindSequenceFile(trackedSequenceDataFileName, trackedSequenceDataFilePath) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  const std::string indexFilename = SequenceFrameIndex::GetIndexFileName(trackedSequenceDataFilePath);
+  if (!vtksys::SystemTools::FileExists(indexFilename, true))
+  {
+    LOG_DEBUG("Sequence file has no frame index: " << trackedSequenceDataFilePath);
+    return PLUS_FAIL;
+  }
+  if (index.Read(indexFilename) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (!index.IsValidFor(trackedSequenceDataFilePath) || (pixelDataRequired && !index.IsPixelDataLocated()))
+  {
+    LOG_DEBUG("Frame index " << indexFilename << " is outdated or does not locate the pixel data of the frames");
+    index.Clear();
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+igsioStatus vtkPlusSequenceIO::OpenFrameIndexes(const std::string& trackedSequenceDataFileName, std::vector<SequenceFrameIndex>& indexes, bool pixelDataRequired/*=true*/)
+{
+  indexes.clear();
+  std::string trackedSequenceDataFilePath;
+  if (FindSequenceFile(trackedSequenceDataFileName, trackedSequenceDataFilePath) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
+  if (!SequenceSegmentIndex::IsSequenceSegmentIndexFile(trackedSequenceDataFilePath))
+  {
+    indexes.resize(1);
+    if (OpenFrameIndex(trackedSequenceDataFilePath, indexes[0], pixelDataRequired) != PLUS_SUCCESS)
+    {
+      indexes.clear();
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  // Each segment file has its own frame index
+  SequenceSegmentIndex segmentIndex;
+  if (segmentIndex.ReadIndexFile(trackedSequenceDataFilePath) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  indexes.resize(segmentIndex.GetNumberOfSegments());
+  for (unsigned int i = 0; i < segmentIndex.GetNumberOfSegments(); ++i)
+  {
+    if (OpenFrameIndex(segmentIndex.GetSegmentFileName(i), indexes[i], pixelDataRequired) != PLUS_SUCCESS
+        || indexes[i].GetNumberOfFrames() != segmentIndex.GetSegmentNumberOfFrames(i))
+    {
+      LOG_DEBUG("Segment " << segmentIndex.GetSegmentFileName(i) << " of " << trackedSequenceDataFilePath << " has no up-to-date frame index");
+      indexes.clear();
+      return PLUS_FAIL;
+    }
+  }
+  return PLUS_SUCCESS;
 }
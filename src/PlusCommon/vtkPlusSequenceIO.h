@@ -9,6 +9,11 @@
 
 #include "igsioCommon.h"
 
+// STL includes
+#include <vector>
+
+class SequenceFrameIndex;
+
 /*!
   \class vtkPlusSequenceIO
   \brief Class to abstract away specific sequence file read/write details
@@ -26,6 +31,27 @@ public:
   /*! Read file contents into the object */
   static igsioStatus Read(const std::string& filename, vtkIGSIOTrackedFrameList* frameList);
 
+  /*!
+    Read a range of frames of a sequence file through its frame index (see SequenceFrameIndex) and append them to the frame list.
+    If the index is missing or outdated then it is built once by reading the whole sequence and it is written next to the file.
+    Fails if the pixel data of the frames cannot be read directly (e.g., it is compressed), as each call would read the whole sequence then.
+    The frame index is read on every call, use OpenFrameIndex to read several ranges of the same file.
+  */
+  static igsioStatus ReadFrames(const std::string& filename, unsigned int firstFrameIndex, unsigned int numberOfFrames, vtkIGSIOTrackedFrameList* frameList);
+
+  /*!
+    Read the frame index of a sequence file, for reading frames by SequenceFrameIndex::ReadFrames.
+    Fails if the sequence file has no frame index, or the index is outdated, or pixelDataRequired is set and
+    the index does not locate the pixel data of the frames.
+  */
+  static igsioStatus OpenFrameIndex(const std::string& filename, SequenceFrameIndex& index, bool pixelDataRequired = true);
+
+  /*!
+    Read the frame index of each file of a sequence: of each segment file of a segmented sequence (see SequenceSegmentIndex),
+    or of the sequence file itself. Fails if any of the indexes cannot be opened by OpenFrameIndex.
+  */
+  static igsioStatus OpenFrameIndexes(const std::string& filename, std::vector<SequenceFrameIndex>& indexes, bool pixelDataRequired = true);
+
 protected:
   vtkPlusSequenceIO();
   virtual ~vtkPlusSequenceIO();
@@ -245,6 +245,7 @@ vtkStandardNewMacro(vtkPlusMmfVideoSource);
 //----------------------------------------------------------------------------
 vtkPlusMmfVideoSource::vtkPlusMmfVideoSource()
   : FrameIndex(0)
+  , LastFrameTimeSec(-1.0)
   , Mutex(vtkSmartPointer<vtkIGSIORecursiveCriticalSection>::New())
 {
   this->MmfSourceReader = new MmfVideoSourceReader(this);
@@ -344,6 +345,7 @@ PlusStatus vtkPlusMmfVideoSource::InternalConnect()
   LOG_DEBUG_W("vtkPlusMmfVideoSource connected to device '" << GetActiveDeviceName() << "' at frame rate of " << frameRate << "Hz");
 
   this->FrameIndex = 0;
+  this->LastFrameTimeSec = -1.0;
 
   return PLUS_SUCCESS;
 }
@@ -646,51 +648,55 @@ PlusStatus vtkPlusMmfVideoSource::AddFrame(unsigned char* bufferData, DWORD buff
     return PLUS_FAIL;
   }
 
-  if (videoSource->GetImageType() == US_IMG_RGB_COLOR)
-  {
-    decodingStatus = PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
-  }
-  else
-  {
-    decodingStatus = PixelCodec::ConvertToGray(encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
-  }
-
-  if (decodingStatus != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Error while decoding the grabbed image");
-    return PLUS_FAIL;
-  }
-
   this->FrameIndex++;
-  vtkPlusDataSource* aSource(NULL);
-  if (this->GetFirstVideoSource(aSource) != PLUS_SUCCESS)
-  {
-    LOG_ERROR("Unable to retrieve the video source in the media foundation capture device.");
-    return PLUS_FAIL;
-  }
 
   const double maximumFrameTimeVariance = 0.2;  // to make sure we don't drop frames because of slight variance in acquisition rate, we allow up to 20% higher frame rate before we start dropping frames
-  double acquisitionRate = this->GetAcquisitionRate();
   double minimumTimeBetweenBetweenRecordedFramesSec = (1.0 - maximumFrameTimeVariance) / this->GetAcquisitionRate();
-  double lastFrameTimeSec = -1.0;
   double currentTime = vtkIGSIOAccurateTimer::GetSystemTime();
 
-  StreamBufferItem latestFrame;
-  if (aSource->GetNumberOfItems() > 2 && aSource->GetLatestStreamBufferItem(&latestFrame) == ITEM_OK)
+  // The time of the last frame is stored here instead of being read from the buffer, because reading the
+  // latest frame from the buffer would convert it from the native pixel encoding
+  double secondsSinceLastFrame = currentTime - this->LastFrameTimeSec;
+  if (this->LastFrameTimeSec > 0 && secondsSinceLastFrame < minimumTimeBetweenBetweenRecordedFramesSec)
+  {
+    // For some webcams, the requested acquistion rate may not be availiable (not supported, or error in configuration).
+    // In this case we can artificially limit frames to the requested acquisition rate by ignoring frames.
+
+    // The required time has not elapsed between frames.
+    // Do not need to record this frame.
+    return PLUS_SUCCESS;
+  }
+
+  PlusStatus status(PLUS_SUCCESS);
+  if (encoding != PixelCodec::PixelEncoding_MJPG)
+  {
+    // Uncompressed frames are stored as is and converted when they are read first
+    status = videoSource->AddNativeItem(bufferData, bufferSize, PixelCodec::GetFourCC(encoding), videoSource->GetInputImageOrientation(),
+                                        frameSize, videoSource->GetImageType(), this->FrameIndex, currentTime);
+  }
+  else
   {
-    lastFrameTimeSec = latestFrame.GetUnfilteredTimestamp(0.0);
-    double secondsSinceLastFrame = currentTime - lastFrameTimeSec;
-    if (lastFrameTimeSec > 0 && secondsSinceLastFrame < minimumTimeBetweenBetweenRecordedFramesSec)
+    if (videoSource->GetImageType() == US_IMG_RGB_COLOR)
     {
-      // For some webcams, the requested acquistion rate may not be availiable (not supported, or error in configuration).
-      // In this case we can artificially limit frames to the requested acquisition rate by ignoring frames.
+      decodingStatus = PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
+    }
+    else
+    {
+      decodingStatus = PixelCodec::ConvertToGray(encoding, frameSize[0], frameSize[1], bufferData, (unsigned char*)this->UncompressedVideoFrame.GetScalarPointer());
+    }
 
-      // The required time has not elapsed between frames.
-      // Do not need to record this frame.
-      return PLUS_SUCCESS;
+    if (decodingStatus != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Error while decoding the grabbed image");
+      return PLUS_FAIL;
     }
+
+    status = videoSource->AddItem(&this->UncompressedVideoFrame, this->FrameIndex, currentTime);
+  }
+  if (status == PLUS_SUCCESS)
+  {
+    this->LastFrameTimeSec = currentTime;
   }
-  PlusStatus status = aSource->AddItem(&this->UncompressedVideoFrame, this->FrameIndex, currentTime);
 
   this->Modified();
   return status;
@@ -97,6 +97,8 @@ protected:
   std::wstring GetCaptureDeviceName(unsigned int deviceId);
 
   int FrameIndex;
+  /*! Unfiltered timestamp of the last frame that was added to the buffer, used for limiting the acquisition rate */
+  double LastFrameTimeSec;
 
   vtkSmartPointer<vtkIGSIORecursiveCriticalSection> Mutex;
   igsioVideoFrame UncompressedVideoFrame;
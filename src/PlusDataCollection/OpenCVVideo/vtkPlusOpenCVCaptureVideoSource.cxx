@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PixelCodec.h"
 #include "vtkPlusOpenCVCaptureVideoSource.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
@@ -292,9 +293,6 @@ PlusStatus vtkPlusOpenCVCaptureVideoSource::InternalUpdate()
     cv::undistort(*this->Frame, *this->UndistortedFrame, *this->CameraMatrix, *this->DistortionCoefficients);
   }
 
-  // BGR -> RGB color
-  cv::cvtColor(*this->UndistortedFrame, *this->UndistortedFrame, cv::COLOR_BGR2RGB);
-
   vtkPlusDataSource* aSource(nullptr);
   if (this->GetFirstActiveOutputVideoSource(aSource) == PLUS_FAIL || aSource == nullptr)
   {
@@ -311,9 +309,17 @@ PlusStatus vtkPlusOpenCVCaptureVideoSource::InternalUpdate()
     aSource->SetInputFrameSize(this->UndistortedFrame->cols, this->UndistortedFrame->rows, 1);
   }
 
-  // Add the frame to the stream buffer
+  // Native frames are stored without row padding
+  if (!this->UndistortedFrame->isContinuous())
+  {
+    *this->UndistortedFrame = this->UndistortedFrame->clone();
+  }
+
+  // Add the BGR frame to the stream buffer as is, it is converted to RGB when it is read first
   FrameSizeType frameSize = { static_cast<unsigned int>(this->UndistortedFrame->cols), static_cast<unsigned int>(this->UndistortedFrame->rows), 1 };
-  if (aSource->AddItem(this->UndistortedFrame->data, aSource->GetInputImageOrientation(), frameSize, VTK_UNSIGNED_CHAR, 3, US_IMG_RGB_COLOR, 0, this->FrameNumber) == PLUS_FAIL)
+  const unsigned int frameSizeInBytes = static_cast<unsigned int>(this->UndistortedFrame->total() * this->UndistortedFrame->elemSize());
+  if (aSource->AddNativeItem(this->UndistortedFrame->data, frameSizeInBytes, PixelCodec::GetFourCC(PixelCodec::PixelEncoding_BGR24), aSource->GetInputImageOrientation(),
+                             frameSize, US_IMG_RGB_COLOR, this->FrameNumber) == PLUS_FAIL)
   {
     return PLUS_FAIL;
   }
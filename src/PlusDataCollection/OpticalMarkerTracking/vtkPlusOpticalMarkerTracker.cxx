@@ -348,7 +348,7 @@ PlusStatus vtkPlusOpticalMarkerTracker::InternalUpdate()
   if (this->InputChannels[0]->GetTrackedFrame(trackedFrame) != PLUS_SUCCESS)
   {
     LOG_ERROR("Error while getting latest tracked frame. Last recorded timestamp: " << std::fixed << this->LastProcessedInputDataTimestamp << ". Device ID: " << this->GetDeviceId());
-    this->LastProcessedInputDataTimestamp = vtkIGSIOAccurateTimer::GetSystemTime(); // forget about the past, try to add frames that are acquired from now on
+    this->LastProcessedInputDataTimestamp = this->GetClockTime(); // forget about the past, try to add frames that are acquired from now on
     return PLUS_FAIL;
   }
 
@@ -372,7 +372,7 @@ PlusStatus vtkPlusOpticalMarkerTracker::InternalUpdate()
   for (std::vector<TrackedTool>::iterator toolIt = begin(this->Internal->Tools); toolIt != end(this->Internal->Tools); ++toolIt)
   {
     bool toolInFrame = false;
-    const double unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    const double unfilteredTimestamp = this->GetClockTime();
     for (std::vector<aruco::Marker>::iterator markerIt = begin(this->Internal->Markers); markerIt != end(this->Internal->Markers); ++markerIt)
     {
       if (toolIt->MarkerId == markerIt->id)
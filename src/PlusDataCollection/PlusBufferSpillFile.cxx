@@ -0,0 +1,589 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusBufferSpillFile.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkPointData.h>
+#include <vtkStreamingVolumeFrame.h>
+#include <vtkUnsignedCharArray.h>
+
+// STL includes
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <fcntl.h>
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+  const size_t RECORD_ALIGNMENT_BYTES = 8;
+  const size_t CODEC_FOURCC_LENGTH = 8;
+
+  /*! Content of the payload of an item record */
+  enum SpillPayloadType
+  {
+    SPILL_PAYLOAD_NONE,
+    SPILL_PAYLOAD_PIXEL_DATA,
+    SPILL_PAYLOAD_NATIVE_FRAME,
+    SPILL_PAYLOAD_ENCODED_FRAME
+  };
+
+  /*! Fixed-size part of an item record, followed by the payload and the frame fields */
+  struct SpillRecordHeader
+  {
+    unsigned long long Uid;
+    unsigned long long FrameIndex;
+    double FilteredTimestamp;
+    double UnfilteredTimestamp;
+    double Matrix[16];
+    int Status;
+    int ValidTransformData;
+    int PixelType;
+    int NumberOfScalarComponents;
+    int ImageType;
+    int ImageOrientation;
+    int FrameSize[3];
+    int NumberOfFrameFields;
+    int PayloadType;
+    unsigned int NativeFrameFourCC;
+    int EncodedFrameType;
+    char CodecFourCC[CODEC_FOURCC_LENGTH];
+    unsigned long long PayloadSize;
+  };
+
+  /*! Each frame field is stored as this header, followed by the name and the value */
+  struct SpillFrameFieldHeader
+  {
+    unsigned int Flags;
+    unsigned int NameLength;
+    unsigned int ValueLength;
+  };
+
+  //----------------------------------------------------------------------------
+  size_t AlignRecordSize(size_t size)
+  {
+    return (size + RECORD_ALIGNMENT_BYTES - 1) / RECORD_ALIGNMENT_BYTES * RECORD_ALIGNMENT_BYTES;
+  }
+}
+
+//----------------------------------------------------------------------------
+BufferSpillFile::BufferSpillFile()
+  : SegmentSizeBytes(0)
+  , MaxSizeBytes(0)
+  , TotalSizeBytes(0)
+  , FirstSegmentNumber(0)
+{
+}
+
+//----------------------------------------------------------------------------
+BufferSpillFile::~BufferSpillFile()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus BufferSpillFile::Open(const std::string& directory, const std::string& fileNamePrefix, size_t segmentSizeBytes, size_t maxSizeBytes)
+{
+  this->Close();
+  std::lock_guard<std::mutex> appendLock(this->AppendMutex);
+  if (fileNamePrefix.empty() || segmentSizeBytes == 0)
+  {
+    LOG_ERROR("Invalid buffer spill file parameters (file name prefix: " << fileNamePrefix << ", segment size: " << segmentSizeBytes << " bytes)");
+    return PLUS_FAIL;
+  }
+  this->Directory = directory;
+  this->FileNamePrefix = fileNamePrefix;
+  this->SegmentSizeBytes = segmentSizeBytes;
+  this->MaxSizeBytes = std::max(maxSizeBytes, segmentSizeBytes);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void BufferSpillFile::Close()
+{
+  std::lock_guard<std::mutex> appendLock(this->AppendMutex);
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  while (!this->Segments.empty())
+  {
+    this->RemoveOldestSegment();
+  }
+  this->Index.clear();
+  this->FirstSegmentNumber = 0;
+  this->TotalSizeBytes = 0;
+  this->FileNamePrefix.clear();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus BufferSpillFile::AddSegment(size_t minimumSize)
+{
+  const unsigned long long segmentNumber = this->FirstSegmentNumber + this->Segments.size();
+  std::ostringstream fileName;
+  fileName << this->Directory << "/" << this->FileNamePrefix << "_" << segmentNumber << ".bin";
+
+  Segment segment;
+  segment.FileName = fileName.str();
+  segment.Size = std::max(this->SegmentSizeBytes, minimumSize);
+  segment.UsedSize = 0;
+  segment.Memory = NULL;
+
+#ifdef _WIN32
+  segment.FileHandle = CreateFileA(segment.FileName.c_str(), GENERIC_READ | GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_TEMPORARY, NULL);
+  if (segment.FileHandle == INVALID_HANDLE_VALUE)
+  {
+    LOG_ERROR("Failed to create buffer spill file: " << segment.FileName);
+    return PLUS_FAIL;
+  }
+  LARGE_INTEGER size;
+  size.QuadPart = static_cast<LONGLONG>(segment.Size);
+  segment.MappingHandle = CreateFileMappingA(segment.FileHandle, NULL, PAGE_READWRITE, size.HighPart, size.LowPart, NULL);
+  if (segment.MappingHandle != NULL)
+  {
+    segment.Memory = static_cast<unsigned char*>(MapViewOfFile(segment.MappingHandle, FILE_MAP_ALL_ACCESS, 0, 0, segment.Size));
+  }
+  if (segment.Memory == NULL)
+  {
+    LOG_ERROR("Failed to map buffer spill file: " << segment.FileName << " (" << segment.Size << " bytes)");
+    if (segment.MappingHandle != NULL)
+    {
+      CloseHandle(segment.MappingHandle);
+    }
+    CloseHandle(segment.FileHandle);
+    DeleteFileA(segment.FileName.c_str());
+    return PLUS_FAIL;
+  }
+#else
+  int fd = open(segment.FileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0600);
+  if (fd < 0)
+  {
+    LOG_ERROR("Failed to create buffer spill file: " << segment.FileName);
+    return PLUS_FAIL;
+  }
+  if (ftruncate(fd, static_cast<off_t>(segment.Size)) == 0)
+  {
+    void* memory = mmap(NULL, segment.Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (memory != MAP_FAILED)
+    {
+      segment.Memory = static_cast<unsigned char*>(memory);
+    }
+  }
+  // The mapping keeps the file open
+  close(fd);
+  if (segment.Memory == NULL)
+  {
+    LOG_ERROR("Failed to map buffer spill file: " << segment.FileName << " (" << segment.Size << " bytes)");
+    unlink(segment.FileName.c_str());
+    return PLUS_FAIL;
+  }
+#endif
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Segments.push_back(segment);
+  this->TotalSizeBytes += segment.Size;
+
+  // Keep the disk usage bounded, but never remove the segment that is being written
+  while (this->TotalSizeBytes > this->MaxSizeBytes && this->Segments.size() > 1)
+  {
+    this->RemoveOldestSegment();
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void BufferSpillFile::RemoveOldestSegment()
+{
+  Segment& segment = this->Segments.front();
+#ifdef _WIN32
+  UnmapViewOfFile(segment.Memory);
+  CloseHandle(segment.MappingHandle);
+  CloseHandle(segment.FileHandle);
+  DeleteFileA(segment.FileName.c_str());
+#else
+  munmap(segment.Memory, segment.Size);
+  unlink(segment.FileName.c_str());
+#endif
+  this->TotalSizeBytes -= segment.Size;
+  this->Segments.pop_front();
+
+  while (!this->Index.empty() && this->Index.front().SegmentNumber == this->FirstSegmentNumber)
+  {
+    this->Index.pop_front();
+  }
+  this->FirstSegmentNumber++;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus BufferSpillFile::AppendItem(StreamBufferItem* item, bool storeNativeFrame)
+{
+  std::lock_guard<std::mutex> appendLock(this->AppendMutex);
+  if (!this->IsOpen())
+  {
+    LOG_ERROR("Cannot store item in buffer spill file, the file is not open");
+    return PLUS_FAIL;
+  }
+  if (item->GetUid() <= this->GetLatestItemUid())
+  {
+    // Already stored
+    return PLUS_SUCCESS;
+  }
+
+  SpillRecordHeader header;
+  memset(&header, 0, sizeof(header));
+  header.Uid = item->GetUid();
+  header.FrameIndex = item->GetIndex();
+  header.FilteredTimestamp = item->GetFilteredTimestamp(0.0);   // 0.0 because timestamps are stored in local time
+  header.UnfilteredTimestamp = item->GetUnfilteredTimestamp(0.0);
+  header.Status = item->GetStatus();
+  header.ValidTransformData = item->HasValidTransformData() ? 1 : 0;
+  item->GetMatrix(header.Matrix);
+  header.PayloadType = SPILL_PAYLOAD_NONE;
+
+  const unsigned char* payload = NULL;
+  igsioVideoFrame& frame = item->GetFrame();
+  vtkImageData* image = frame.GetImage();
+  vtkStreamingVolumeFrame* encodedFrame = frame.IsFrameEncoded() ? frame.GetEncodedFrame() : NULL;
+  if (encodedFrame != NULL && encodedFrame->GetFrameData() != NULL)
+  {
+    vtkUnsignedCharArray* frameData = encodedFrame->GetFrameData();
+    int dimensions[3] = { 0, 0, 0 };
+    encodedFrame->GetDimensions(dimensions);
+    header.PayloadType = SPILL_PAYLOAD_ENCODED_FRAME;
+    header.EncodedFrameType = encodedFrame->GetFrameType();
+    strncpy(header.CodecFourCC, encodedFrame->GetCodecFourCC().c_str(), CODEC_FOURCC_LENGTH - 1);
+    header.NumberOfScalarComponents = static_cast<int>(encodedFrame->GetNumberOfComponents());
+    header.FrameSize[0] = dimensions[0];
+    header.FrameSize[1] = dimensions[1];
+    header.FrameSize[2] = dimensions[2];
+    header.PayloadSize = static_cast<unsigned long long>(frameData->GetNumberOfValues());
+    payload = frameData->GetPointer(0);
+  }
+  else if (image != NULL && image->GetPointData()->GetScalars() != NULL && (storeNativeFrame || item->HasValidVideoData()))
+  {
+    int dimensions[3] = { 0, 0, 0 };
+    image->GetDimensions(dimensions);
+    header.PixelType = image->GetScalarType();
+    header.NumberOfScalarComponents = image->GetNumberOfScalarComponents();
+    header.FrameSize[0] = dimensions[0];
+    header.FrameSize[1] = dimensions[1];
+    header.FrameSize[2] = dimensions[2];
+    if (storeNativeFrame)
+    {
+      // The native frame is usually smaller than the converted frame and storing it avoids the conversion
+      header.PayloadType = SPILL_PAYLOAD_NATIVE_FRAME;
+      header.NativeFrameFourCC = item->GetNativeFrameFourCC();
+      header.PayloadSize = item->GetNativeFrameSizeInBytes();
+      payload = item->GetNativeFrameData();
+    }
+    else
+    {
+      header.PayloadType = SPILL_PAYLOAD_PIXEL_DATA;
+      header.PayloadSize = static_cast<unsigned long long>(dimensions[0]) * dimensions[1] * dimensions[2] * header.NumberOfScalarComponents * image->GetScalarSize();
+      payload = static_cast<const unsigned char*>(image->GetScalarPointer());
+    }
+  }
+  if (header.PayloadType != SPILL_PAYLOAD_NONE)
+  {
+    header.ImageType = frame.GetImageType();
+    header.ImageOrientation = frame.GetImageOrientation();
+  }
+
+  const StreamBufferItem::FrameFieldContainer& frameFields = item->GetFrameFields();
+  header.NumberOfFrameFields = static_cast<int>(frameFields.size());
+  size_t recordSize = sizeof(SpillRecordHeader) + header.PayloadSize;
+  for (StreamBufferItem::FrameFieldContainer::const_iterator it = frameFields.begin(); it != frameFields.end(); ++it)
+  {
+    recordSize += sizeof(SpillFrameFieldHeader) + FrameFieldSchema::GetFieldName(it->Id).size() + it->Value.size();
+  }
+  recordSize = AlignRecordSize(recordSize);
+
+  if (this->Segments.empty() || this->Segments.back().Size - this->Segments.back().UsedSize < recordSize)
+  {
+    if (this->AddSegment(recordSize) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+
+  // Only appenders modify the segments, so the record can be written without blocking the readers
+  Segment& segment = this->Segments.back();
+  unsigned char* record = segment.Memory + segment.UsedSize;
+  memcpy(record, &header, sizeof(header));
+  unsigned char* writePtr = record + sizeof(header);
+  if (payload != NULL)
+  {
+    memcpy(writePtr, payload, header.PayloadSize);
+    writePtr += header.PayloadSize;
+  }
+  for (StreamBufferItem::FrameFieldContainer::const_iterator it = frameFields.begin(); it != frameFields.end(); ++it)
+  {
+    const std::string& fieldName = FrameFieldSchema::GetFieldName(it->Id);
+    SpillFrameFieldHeader fieldHeader;
+    fieldHeader.Flags = it->Flags;
+    fieldHeader.NameLength = static_cast<unsigned int>(fieldName.size());
+    fieldHeader.ValueLength = static_cast<unsigned int>(it->Value.size());
+    memcpy(writePtr, &fieldHeader, sizeof(fieldHeader));
+    writePtr += sizeof(fieldHeader);
+    memcpy(writePtr, fieldName.data(), fieldHeader.NameLength);
+    writePtr += fieldHeader.NameLength;
+    memcpy(writePtr, it->Value.data(), fieldHeader.ValueLength);
+    writePtr += fieldHeader.ValueLength;
+  }
+
+  IndexEntry entry;
+  entry.Uid = header.Uid;
+  entry.FrameIndex = item->GetIndex();
+  entry.FilteredTimestamp = header.FilteredTimestamp;
+  entry.SegmentNumber = this->FirstSegmentNumber + this->Segments.size() - 1;
+  entry.Offset = segment.UsedSize;
+  segment.UsedSize += recordSize;
+
+  // Publish the record
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Index.push_back(entry);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+const BufferSpillFile::IndexEntry* BufferSpillFile::FindIndexEntry(BufferItemUidType uid) const
+{
+  if (this->Index.empty() || uid < this->Index.front().Uid || uid > this->Index.back().Uid)
+  {
+    return NULL;
+  }
+  // UIDs are usually consecutive, so the position of the entry can be computed directly
+  size_t position = static_cast<size_t>(uid - this->Index.front().Uid);
+  if (position < this->Index.size() && this->Index[position].Uid == uid)
+  {
+    return &this->Index[position];
+  }
+  std::deque<IndexEntry>::const_iterator it = std::lower_bound(this->Index.begin(), this->Index.end(), uid,
+      [](const IndexEntry& entry, BufferItemUidType value) { return entry.Uid < value; });
+  if (it == this->Index.end() || it->Uid != uid)
+  {
+    return NULL;
+  }
+  return &(*it);
+}
+
+//----------------------------------------------------------------------------
+const unsigned char* BufferSpillFile::GetRecord(const IndexEntry* entry) const
+{
+  const Segment& segment = this->Segments[static_cast<size_t>(entry->SegmentNumber - this->FirstSegmentNumber)];
+  return segment.Memory + entry->Offset;
+}
+
+//----------------------------------------------------------------------------
+int BufferSpillFile::GetNumberOfItems() const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return static_cast<int>(this->Index.size());
+}
+
+//----------------------------------------------------------------------------
+int BufferSpillFile::GetNumberOfItemsBefore(BufferItemUidType uid) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  std::deque<IndexEntry>::const_iterator it = std::lower_bound(this->Index.begin(), this->Index.end(), uid,
+      [](const IndexEntry& entry, BufferItemUidType value) { return entry.Uid < value; });
+  return static_cast<int>(it - this->Index.begin());
+}
+
+//----------------------------------------------------------------------------
+bool BufferSpillFile::ContainsItem(BufferItemUidType uid) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->FindIndexEntry(uid) != NULL;
+}
+
+//----------------------------------------------------------------------------
+BufferItemUidType BufferSpillFile::GetLatestItemUid() const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->Index.empty() ? 0 : this->Index.back().Uid;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus BufferSpillFile::GetTimeStamp(BufferItemUidType uid, double& localTimestamp) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  const IndexEntry* entry = this->FindIndexEntry(uid);
+  if (entry == NULL)
+  {
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  localTimestamp = entry->FilteredTimestamp;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus BufferSpillFile::GetIndex(BufferItemUidType uid, unsigned long& index) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  const IndexEntry* entry = this->FindIndexEntry(uid);
+  if (entry == NULL)
+  {
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  index = entry->FrameIndex;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus BufferSpillFile::GetItemUidFromTime(double localTime, BufferItemUidType& uid) const
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  if (this->Index.empty() || localTime < this->Index.front().FilteredTimestamp)
+  {
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  std::deque<IndexEntry>::const_iterator it = std::lower_bound(this->Index.begin(), this->Index.end(), localTime,
+      [](const IndexEntry& entry, double value) { return entry.FilteredTimestamp < value; });
+  if (it == this->Index.end())
+  {
+    uid = this->Index.back().Uid;
+    return ITEM_OK;
+  }
+  if (it != this->Index.begin())
+  {
+    std::deque<IndexEntry>::const_iterator previous = it - 1;
+    if (localTime - previous->FilteredTimestamp < it->FilteredTimestamp - localTime)
+    {
+      it = previous;
+    }
+  }
+  uid = it->Uid;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkStreamingVolumeFrame> BufferSpillFile::ReadEncodedFrame(const IndexEntry* entry) const
+{
+  // Collect the stored frames back to the previous key frame, as an encoded frame can only be decoded together with them
+  std::vector<const IndexEntry*> entries;
+  while (entry != NULL)
+  {
+    SpillRecordHeader header;
+    memcpy(&header, this->GetRecord(entry), sizeof(header));
+    if (header.PayloadType != SPILL_PAYLOAD_ENCODED_FRAME)
+    {
+      break;
+    }
+    entries.push_back(entry);
+    if (header.EncodedFrameType == vtkStreamingVolumeFrame::IFrame || header.Uid == 0)
+    {
+      break;
+    }
+    entry = this->FindIndexEntry(header.Uid - 1);
+  }
+
+  vtkSmartPointer<vtkStreamingVolumeFrame> previousFrame;
+  for (std::vector<const IndexEntry*>::reverse_iterator it = entries.rbegin(); it != entries.rend(); ++it)
+  {
+    const unsigned char* record = this->GetRecord(*it);
+    SpillRecordHeader header;
+    memcpy(&header, record, sizeof(header));
+
+    vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    frameData->SetNumberOfValues(static_cast<vtkIdType>(header.PayloadSize));
+    if (header.PayloadSize > 0)
+    {
+      memcpy(frameData->GetPointer(0), record + sizeof(header), header.PayloadSize);
+    }
+    vtkSmartPointer<vtkStreamingVolumeFrame> encodedFrame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    encodedFrame->SetFrameData(frameData);
+    encodedFrame->SetFrameType(header.EncodedFrameType);
+    encodedFrame->SetCodecFourCC(std::string(header.CodecFourCC, strnlen(header.CodecFourCC, CODEC_FOURCC_LENGTH)));
+    encodedFrame->SetDimensions(header.FrameSize);
+    encodedFrame->SetNumberOfComponents(static_cast<unsigned int>(header.NumberOfScalarComponents));
+    encodedFrame->SetPreviousFrame(previousFrame);
+    previousFrame = encodedFrame;
+  }
+  return previousFrame;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus BufferSpillFile::ReadItem(BufferItemUidType uid, StreamBufferItem* item) const
+{
+  StreamBufferItem storedItem;
+  {
+    // The segment of the record must not be deleted while it is read
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    const IndexEntry* entry = this->FindIndexEntry(uid);
+    if (entry == NULL)
+    {
+      return ITEM_NOT_AVAILABLE_ANYMORE;
+    }
+    const unsigned char* record = this->GetRecord(entry);
+    SpillRecordHeader header;
+    memcpy(&header, record, sizeof(header));
+    const unsigned char* readPtr = record + sizeof(header);
+
+    storedItem.SetUid(header.Uid);
+    storedItem.SetIndex(static_cast<unsigned long>(header.FrameIndex));
+    storedItem.SetFilteredTimestamp(header.FilteredTimestamp);
+    storedItem.SetUnfilteredTimestamp(header.UnfilteredTimestamp);
+    storedItem.SetMatrix(header.Matrix);
+    storedItem.SetStatus(static_cast<ToolStatus>(header.Status));
+    storedItem.SetValidTransformData(header.ValidTransformData != 0);
+
+    igsioVideoFrame& frame = storedItem.GetFrame();
+    if (header.PayloadType == SPILL_PAYLOAD_PIXEL_DATA || header.PayloadType == SPILL_PAYLOAD_NATIVE_FRAME)
+    {
+      FrameSizeType frameSize = { static_cast<unsigned int>(header.FrameSize[0]), static_cast<unsigned int>(header.FrameSize[1]), static_cast<unsigned int>(header.FrameSize[2]) };
+      if (frame.AllocateFrame(frameSize, header.PixelType, header.NumberOfScalarComponents) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to allocate frame for item " << uid << " read from buffer spill file");
+        return ITEM_UNKNOWN_ERROR;
+      }
+      if (header.PayloadType == SPILL_PAYLOAD_PIXEL_DATA)
+      {
+        memcpy(frame.GetScalarPointer(), readPtr, header.PayloadSize);
+      }
+      else
+      {
+        storedItem.SetNativeFrame(readPtr, static_cast<unsigned int>(header.PayloadSize), header.NativeFrameFourCC);
+      }
+    }
+    else if (header.PayloadType == SPILL_PAYLOAD_ENCODED_FRAME)
+    {
+      frame.SetEncodedFrame(this->ReadEncodedFrame(entry));
+    }
+    if (header.PayloadType != SPILL_PAYLOAD_NONE)
+    {
+      frame.SetImageType(static_cast<US_IMAGE_TYPE>(header.ImageType));
+      frame.SetImageOrientation(static_cast<US_IMAGE_ORIENTATION>(header.ImageOrientation));
+    }
+    readPtr += header.PayloadSize;
+
+    for (int i = 0; i < header.NumberOfFrameFields; ++i)
+    {
+      SpillFrameFieldHeader fieldHeader;
+      memcpy(&fieldHeader, readPtr, sizeof(fieldHeader));
+      readPtr += sizeof(fieldHeader);
+      std::string name(reinterpret_cast<const char*>(readPtr), fieldHeader.NameLength);
+      readPtr += fieldHeader.NameLength;
+      std::string value(reinterpret_cast<const char*>(readPtr), fieldHeader.ValueLength);
+      readPtr += fieldHeader.ValueLength;
+      storedItem.SetFrameField(name, value, static_cast<igsioFrameFieldFlags>(fieldHeader.Flags));
+    }
+  }
+
+  if (item->DeepCopy(&storedItem) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to copy item " << uid << " read from buffer spill file");
+    return ITEM_UNKNOWN_ERROR;
+  }
+  return ITEM_OK;
+}
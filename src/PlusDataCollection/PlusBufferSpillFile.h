@@ -0,0 +1,155 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __BufferSpillFile_h
+#define __BufferSpillFile_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusStreamBufferItem.h"
+#include "vtkPlusTimestampedCircularBuffer.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+// STL includes
+#include <deque>
+#include <mutex>
+#include <string>
+
+class vtkStreamingVolumeFrame;
+
+/*!
+  \class BufferSpillFile
+  \brief Stores items that are removed from a circular buffer in memory-mapped segment files on disk
+
+  Items are appended to fixed-size segment files, each item is stored as a single record that contains the
+  timestamps, the transform, the frame fields and the frame payload. The payload is the uncompressed pixel data,
+  the native (not yet converted) pixel data or the encoded (compressed) frame data, whichever the item holds.
+  An index of the stored items is kept in memory, so items can be found by UID or timestamp without reading the files.
+  When the total size of the segment files exceeds the maximum size then the oldest segment is deleted.
+
+  Items can be appended and read from different threads. Appending is serialized, but a record is copied
+  into the file without blocking the readers; the item becomes visible to the readers when it is completely written.
+  Open and Close must not be called concurrently with other methods.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport BufferSpillFile
+{
+public:
+  BufferSpillFile();
+  ~BufferSpillFile();
+
+  /*!
+    Prepare for storing items. Segment files are created in the specified directory, their names start with the
+    specified prefix. A segment file is at least segmentSizeBytes large, segment files are deleted if their
+    total size is larger than maxSizeBytes.
+  */
+  PlusStatus Open(const std::string& directory, const std::string& fileNamePrefix, size_t segmentSizeBytes, size_t maxSizeBytes);
+
+  /*! Remove all items and delete the segment files */
+  void Close();
+
+  /*! Returns true if the object is ready for storing items */
+  bool IsOpen() const { return !this->FileNamePrefix.empty(); }
+
+  /*!
+    Store a copy of an item. Items must be appended in increasing UID and timestamp order, items that have
+    already been stored are skipped. If storeNativeFrame is true then the native frame of the item is stored
+    instead of the frame image, the native frame is then converted when the item is used after reading it.
+  */
+  PlusStatus AppendItem(StreamBufferItem* item, bool storeNativeFrame);
+
+  /*! Get the number of stored items */
+  int GetNumberOfItems() const;
+
+  /*! Get the number of stored items that have a lower UID than the specified UID */
+  int GetNumberOfItemsBefore(BufferItemUidType uid) const;
+
+  /*! Returns true if the item with the specified UID is stored */
+  bool ContainsItem(BufferItemUidType uid) const;
+
+  /*! Get the UID of the most recently stored item. Returns 0 if there are no stored items. */
+  BufferItemUidType GetLatestItemUid() const;
+
+  /*! Get the filtered timestamp of a stored item in local time */
+  ItemStatus GetTimeStamp(BufferItemUidType uid, double& localTimestamp) const;
+
+  /*! Get the frame index of a stored item */
+  ItemStatus GetIndex(BufferItemUidType uid, unsigned long& index) const;
+
+  /*!
+    Get the UID of the stored item that is the closest to the specified time (in local time).
+    Returns ITEM_NOT_AVAILABLE_ANYMORE if the time is before the oldest stored item or there are no stored items.
+  */
+  ItemStatus GetItemUidFromTime(double localTime, BufferItemUidType& uid) const;
+
+  /*!
+    Read a stored item. Encoded frames are linked to the stored frames back to the previous key frame,
+    so that they can be decoded.
+  */
+  ItemStatus ReadItem(BufferItemUidType uid, StreamBufferItem* item) const;
+
+private:
+  BufferSpillFile(const BufferSpillFile&);
+  BufferSpillFile& operator=(const BufferSpillFile&);
+
+  struct Segment
+  {
+    std::string FileName;
+    unsigned char* Memory;
+    size_t Size;
+    size_t UsedSize;
+#ifdef _WIN32
+    void* FileHandle;
+    void* MappingHandle;
+#endif
+  };
+
+  struct IndexEntry
+  {
+    BufferItemUidType Uid;
+    unsigned long FrameIndex;
+    double FilteredTimestamp;
+    unsigned long long SegmentNumber;
+    size_t Offset;
+  };
+
+  /*! Create and map a new segment file that has at least minimumSize bytes. AppendMutex must be locked. */
+  PlusStatus AddSegment(size_t minimumSize);
+
+  /*! Unmap and delete the oldest segment file and remove its items from the index. Mutex must be locked. */
+  void RemoveOldestSegment();
+
+  /*! Find the index entry of an item, returns NULL if the item is not stored. Mutex must be locked. */
+  const IndexEntry* FindIndexEntry(BufferItemUidType uid) const;
+
+  /*! Get the beginning of the record of a stored item. Mutex must be locked. */
+  const unsigned char* GetRecord(const IndexEntry* entry) const;
+
+  /*! Create the encoded frame of an item and the frames that it depends on. Mutex must be locked. */
+  vtkSmartPointer<vtkStreamingVolumeFrame> ReadEncodedFrame(const IndexEntry* entry) const;
+
+  std::string Directory;
+  std::string FileNamePrefix;
+  size_t SegmentSizeBytes;
+  size_t MaxSizeBytes;
+  size_t TotalSizeBytes;
+
+  std::deque<Segment> Segments;
+  /*! Segment number of the first element of Segments */
+  unsigned long long FirstSegmentNumber;
+
+  /*! Stored items in increasing UID order */
+  std::deque<IndexEntry> Index;
+
+  /*! Protects the index and the list of segments, held while a stored record is read */
+  mutable std::mutex Mutex;
+  /*! Serializes appending items, held while a record is written */
+  std::mutex AppendMutex;
+};
+
+#endif
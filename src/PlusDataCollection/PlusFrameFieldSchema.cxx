@@ -0,0 +1,134 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameFieldSchema.h"
+
+// STL includes
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+namespace
+{
+  const unsigned int NAMES_PER_BLOCK = 256;
+  const unsigned int MAXIMUM_NUMBER_OF_BLOCKS = 4096;
+
+  /*!
+    Names are stored in fixed-size blocks that are never moved or freed, so a name can be read without locking
+    once the number of names that includes it is published. Only adding names requires the mutex.
+  */
+  struct FieldTable
+  {
+    FieldTable() : NumberOfNames(0) {}
+
+    std::mutex Mutex;
+    std::unordered_map<std::string, FrameFieldId> Ids;
+    std::unique_ptr<std::string[]> NameBlocks[MAXIMUM_NUMBER_OF_BLOCKS];
+    std::atomic<unsigned int> NumberOfNames;
+  };
+
+  //----------------------------------------------------------------------------
+  FieldTable& GetFieldTable()
+  {
+    static FieldTable table;
+    return table;
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    IDs that the current thread has already looked up. IDs are never removed or changed, so the entries
+    remain valid and interned names can be looked up without locking the table.
+  */
+  std::unordered_map<std::string, FrameFieldId>& GetThreadFieldIds()
+  {
+    static thread_local std::unordered_map<std::string, FrameFieldId> threadFieldIds;
+    return threadFieldIds;
+  }
+}
+
+const FrameFieldId FrameFieldSchema::INVALID_FIELD_ID = std::numeric_limits<FrameFieldId>::max();
+
+//----------------------------------------------------------------------------
+FrameFieldId FrameFieldSchema::GetFieldId(const std::string& fieldName)
+{
+  std::unordered_map<std::string, FrameFieldId>& threadFieldIds = GetThreadFieldIds();
+  std::unordered_map<std::string, FrameFieldId>::const_iterator threadIt = threadFieldIds.find(fieldName);
+  if (threadIt != threadFieldIds.end())
+  {
+    return threadIt->second;
+  }
+
+  FieldTable& table = GetFieldTable();
+  std::lock_guard<std::mutex> lock(table.Mutex);
+  std::unordered_map<std::string, FrameFieldId>::const_iterator it = table.Ids.find(fieldName);
+  if (it != table.Ids.end())
+  {
+    threadFieldIds[fieldName] = it->second;
+    return it->second;
+  }
+  const unsigned int numberOfNames = table.NumberOfNames.load(std::memory_order_relaxed);
+  const unsigned int blockIndex = numberOfNames / NAMES_PER_BLOCK;
+  if (blockIndex >= MAXIMUM_NUMBER_OF_BLOCKS)
+  {
+    LOG_ERROR("Too many distinct frame field names, " << fieldName << " cannot be added");
+    return INVALID_FIELD_ID;
+  }
+  if (!table.NameBlocks[blockIndex])
+  {
+    table.NameBlocks[blockIndex].reset(new std::string[NAMES_PER_BLOCK]);
+  }
+  table.NameBlocks[blockIndex][numberOfNames % NAMES_PER_BLOCK] = fieldName;
+  const FrameFieldId fieldId = static_cast<FrameFieldId>(numberOfNames);
+  table.Ids[fieldName] = fieldId;
+  // Publish the name to the lock-free readers
+  table.NumberOfNames.store(numberOfNames + 1, std::memory_order_release);
+  threadFieldIds[fieldName] = fieldId;
+  return fieldId;
+}
+
+//----------------------------------------------------------------------------
+FrameFieldId FrameFieldSchema::FindFieldId(const std::string& fieldName)
+{
+  std::unordered_map<std::string, FrameFieldId>& threadFieldIds = GetThreadFieldIds();
+  std::unordered_map<std::string, FrameFieldId>::const_iterator threadIt = threadFieldIds.find(fieldName);
+  if (threadIt != threadFieldIds.end())
+  {
+    return threadIt->second;
+  }
+
+  // Names that are not interned yet are not cached, because another thread may add them later
+  FieldTable& table = GetFieldTable();
+  std::lock_guard<std::mutex> lock(table.Mutex);
+  std::unordered_map<std::string, FrameFieldId>::const_iterator it = table.Ids.find(fieldName);
+  if (it == table.Ids.end())
+  {
+    return INVALID_FIELD_ID;
+  }
+  threadFieldIds[fieldName] = it->second;
+  return it->second;
+}
+
+//----------------------------------------------------------------------------
+const std::string& FrameFieldSchema::GetFieldName(FrameFieldId fieldId)
+{
+  static const std::string emptyName;
+  FieldTable& table = GetFieldTable();
+  if (fieldId >= table.NumberOfNames.load(std::memory_order_acquire))
+  {
+    LOG_ERROR("Invalid frame field ID: " << fieldId);
+    return emptyName;
+  }
+  return table.NameBlocks[fieldId / NAMES_PER_BLOCK][fieldId % NAMES_PER_BLOCK];
+}
+
+//----------------------------------------------------------------------------
+unsigned int FrameFieldSchema::GetNumberOfFields()
+{
+  return GetFieldTable().NumberOfNames.load(std::memory_order_acquire);
+}
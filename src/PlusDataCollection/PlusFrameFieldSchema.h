@@ -0,0 +1,57 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __FrameFieldSchema_h
+#define __FrameFieldSchema_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+// STL includes
+#include <string>
+
+/*! Interned frame field name */
+typedef unsigned int FrameFieldId;
+
+/*!
+  \class FrameFieldSchema
+  \brief Table of interned frame field names
+
+  Each distinct frame field name (such as "ProbeToTrackerTransformStatus") is stored only once and
+  is identified by a small integer ID. Buffer items store the ID instead of the name, so adding and copying
+  frame fields does not allocate and copy the name strings.
+
+  IDs are never removed and are shared by all buffers, therefore items can be copied between buffers
+  without remapping the IDs. All methods are thread-safe. GetFieldName does not lock, so it can be called
+  from the acquisition threads while other threads add new names. Each thread caches the IDs that it has
+  looked up, so GetFieldId and FindFieldId only lock the table for names that are new to the thread.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport FrameFieldSchema
+{
+public:
+  /*! ID returned by FindFieldId if the name has not been interned */
+  static const FrameFieldId INVALID_FIELD_ID;
+
+  /*! Get the ID of a field name. The name is added to the table if it is not interned yet. */
+  static FrameFieldId GetFieldId(const std::string& fieldName);
+
+  /*! Get the ID of a field name without adding it to the table. Returns INVALID_FIELD_ID if the name is not interned. */
+  static FrameFieldId FindFieldId(const std::string& fieldName);
+
+  /*! Get the name of a field ID. The returned reference remains valid until the end of the process. */
+  static const std::string& GetFieldName(FrameFieldId fieldId);
+
+  /*! Get the number of interned field names */
+  static unsigned int GetNumberOfFields();
+
+private:
+  FrameFieldSchema();
+  FrameFieldSchema(const FrameFieldSchema&);
+  FrameFieldSchema& operator=(const FrameFieldSchema&);
+};
+
+#endif
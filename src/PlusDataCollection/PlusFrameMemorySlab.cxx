@@ -0,0 +1,165 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameMemorySlab.h"
+
+#ifdef _WIN32
+  #include <windows.h>
+#else
+  #include <sys/mman.h>
+  #include <unistd.h>
+#endif
+
+namespace
+{
+#ifndef _WIN32
+  // Default huge page size on x86 and ARM64 Linux, mappings from the huge page pool must be a multiple of it
+  const size_t HUGE_PAGE_SIZE_BYTES = 2 * 1024 * 1024;
+#endif
+
+  //----------------------------------------------------------------------------
+  size_t RoundUp(size_t size, size_t alignment)
+  {
+    return (size + alignment - 1) / alignment * alignment;
+  }
+}
+
+//----------------------------------------------------------------------------
+FrameMemorySlab::FrameMemorySlab()
+  : Memory(NULL)
+  , Size(0)
+  , HugePageBacked(false)
+{
+}
+
+//----------------------------------------------------------------------------
+FrameMemorySlab::~FrameMemorySlab()
+{
+  this->Free();
+}
+
+//----------------------------------------------------------------------------
+size_t FrameMemorySlab::GetPageSize()
+{
+#ifdef _WIN32
+  SYSTEM_INFO systemInfo;
+  GetSystemInfo(&systemInfo);
+  return systemInfo.dwPageSize;
+#else
+  long pageSize = sysconf(_SC_PAGESIZE);
+  return pageSize > 0 ? static_cast<size_t>(pageSize) : 4096;
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusStatus FrameMemorySlab::Allocate(size_t sizeInBytes, bool useHugePages)
+{
+  this->Free();
+  if (sizeInBytes == 0)
+  {
+    return PLUS_SUCCESS;
+  }
+
+#ifdef _WIN32
+  if (useHugePages)
+  {
+    // Large pages require the SeLockMemoryPrivilege, fall back to regular pages if they cannot be allocated
+    size_t largePageSize = GetLargePageMinimum();
+    if (largePageSize > 0)
+    {
+      size_t size = RoundUp(sizeInBytes, largePageSize);
+      void* memory = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+      if (memory != NULL)
+      {
+        this->Memory = static_cast<unsigned char*>(memory);
+        this->Size = size;
+        this->HugePageBacked = true;
+        return PLUS_SUCCESS;
+      }
+    }
+    LOG_DEBUG("Large pages are not available for frame memory slab, regular pages are used");
+  }
+  size_t size = RoundUp(sizeInBytes, GetPageSize());
+  void* memory = VirtualAlloc(NULL, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+  if (memory == NULL)
+  {
+    LOG_ERROR("Failed to allocate " << size << " bytes for frame memory slab");
+    return PLUS_FAIL;
+  }
+#else
+#ifdef MAP_HUGETLB
+  if (useHugePages)
+  {
+    // The huge page pool is often empty (vm.nr_hugepages=0), fall back to transparent huge pages then
+    size_t size = RoundUp(sizeInBytes, HUGE_PAGE_SIZE_BYTES);
+    void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (memory != MAP_FAILED)
+    {
+      this->Memory = static_cast<unsigned char*>(memory);
+      this->Size = size;
+      this->HugePageBacked = true;
+      return PLUS_SUCCESS;
+    }
+    LOG_DEBUG("Huge page pool is not available for frame memory slab, transparent huge pages are requested");
+  }
+#endif
+  size_t size = RoundUp(sizeInBytes, useHugePages ? HUGE_PAGE_SIZE_BYTES : GetPageSize());
+  void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+  {
+    LOG_ERROR("Failed to allocate " << size << " bytes for frame memory slab");
+    return PLUS_FAIL;
+  }
+#ifdef MADV_HUGEPAGE
+  if (useHugePages && madvise(memory, size, MADV_HUGEPAGE) != 0)
+  {
+    LOG_DEBUG("Transparent huge pages are not available for frame memory slab, regular pages are used");
+  }
+#endif
+#endif
+
+  this->Memory = static_cast<unsigned char*>(memory);
+  this->Size = size;
+  this->HugePageBacked = false;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void FrameMemorySlab::Free()
+{
+  if (this->Memory == NULL)
+  {
+    return;
+  }
+#ifdef _WIN32
+  VirtualFree(this->Memory, 0, MEM_RELEASE);
+#else
+  munmap(this->Memory, this->Size);
+#endif
+  this->Memory = NULL;
+  this->Size = 0;
+  this->HugePageBacked = false;
+}
+
+//----------------------------------------------------------------------------
+void FrameMemorySlab::Prefault()
+{
+  // Writing one byte per page is enough to map all pages
+  volatile unsigned char* memory = this->Memory;
+  const size_t pageSize = GetPageSize();
+  for (size_t offset = 0; offset < this->Size; offset += pageSize)
+  {
+    memory[offset] = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+bool FrameMemorySlab::Contains(const void* ptr) const
+{
+  const unsigned char* bytePtr = static_cast<const unsigned char*>(ptr);
+  return this->Memory != NULL && bytePtr >= this->Memory && bytePtr < this->Memory + this->Size;
+}
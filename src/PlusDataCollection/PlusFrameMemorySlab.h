@@ -0,0 +1,66 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __FrameMemorySlab_h
+#define __FrameMemorySlab_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusCommon.h"
+
+// STL includes
+#include <cstddef>
+
+/*!
+  \class FrameMemorySlab
+  \brief One contiguous, page-aligned memory block that stores the pixel data of all frames of a buffer.
+
+  The memory is allocated directly from the operating system (mmap or VirtualAlloc), so it is aligned
+  to the page size. If huge pages are requested then the slab is allocated from the huge page pool if
+  possible (MAP_HUGETLB, MEM_LARGE_PAGES), otherwise transparent huge pages are requested for the slab
+  (MADV_HUGEPAGE). If huge pages are not available then regular pages are used.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport FrameMemorySlab
+{
+public:
+  FrameMemorySlab();
+  ~FrameMemorySlab();
+
+  /*! Allocate a slab of at least sizeInBytes bytes. Previously allocated memory is released. */
+  PlusStatus Allocate(size_t sizeInBytes, bool useHugePages);
+
+  /*! Release the allocated memory */
+  void Free();
+
+  /*! Write each page of the slab, so that no page faults occur when the slab is written the first time during acquisition */
+  void Prefault();
+
+  /*! Get pointer to the beginning of the slab. Returns NULL if no memory is allocated. */
+  unsigned char* GetPointer() const { return this->Memory; }
+
+  /*! Get the allocated size in bytes (it is rounded up to a multiple of the page size) */
+  size_t GetSize() const { return this->Size; }
+
+  /*! Returns true if the slab is allocated from the huge page pool */
+  bool IsHugePageBacked() const { return this->HugePageBacked; }
+
+  /*! Returns true if the pointer points into the slab */
+  bool Contains(const void* ptr) const;
+
+  /*! Get the size of regular memory pages in bytes */
+  static size_t GetPageSize();
+
+private:
+  FrameMemorySlab(const FrameMemorySlab&);
+  FrameMemorySlab& operator=(const FrameMemorySlab&);
+
+  unsigned char* Memory;
+  size_t Size;
+  bool HugePageBacked;
+};
+
+#endif
@@ -0,0 +1,179 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusPeriodicScheduler.h"
+
+#if defined(__linux__)
+  #include <cerrno>
+  #include <time.h>
+#endif
+
+// STL includes
+#include <thread>
+
+//----------------------------------------------------------------------------
+PeriodicScheduler::PeriodicScheduler()
+  : Period(std::chrono::milliseconds(100))
+  , Policy(CATCH_UP_SKIP)
+  , NumberOfUpdates(0)
+  , NumberOfMissedDeadlines(0)
+{
+  this->ResetStatistics();
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::SetPeriodSec(double periodSec)
+{
+  if (periodSec <= 0)
+  {
+    LOG_ERROR("Invalid scheduling period: " << periodSec << " sec");
+    return;
+  }
+  this->Period = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(periodSec));
+}
+
+//----------------------------------------------------------------------------
+double PeriodicScheduler::GetPeriodSec() const
+{
+  return std::chrono::duration<double>(this->Period).count();
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::Start()
+{
+  this->NextDeadline = Clock::now() + this->Period;
+  this->LastMissedDeadline = Clock::time_point::min();
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::BeginUpdate()
+{
+  this->UpdateStartTime = Clock::now();
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::EndUpdate()
+{
+  const long long executionTimeUs = std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - this->UpdateStartTime).count();
+  int binIndex = 0;
+  while (binIndex < NUMBER_OF_HISTOGRAM_BINS - 1 && executionTimeUs >= (1LL << binIndex))
+  {
+    ++binIndex;
+  }
+  ++this->ExecutionTimeHistogram[binIndex];
+  ++this->NumberOfUpdates;
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::WaitForNextDeadline()
+{
+  const Clock::time_point now = Clock::now();
+  if (now < this->NextDeadline)
+  {
+    SleepUntil(this->NextDeadline);
+    this->NextDeadline += this->Period;
+    return;
+  }
+
+  // Overrun: all deadlines from the next one up to now are missed. With the BURST policy the earlier
+  // calls may have counted some of them already, only the deadlines after those are counted.
+  const unsigned long long missedTicks = static_cast<unsigned long long>((now - this->NextDeadline) / this->Period) + 1;
+  const Clock::time_point lastMissedDeadline = this->NextDeadline + this->Period * static_cast<Clock::rep>(missedTicks - 1);
+  if (this->LastMissedDeadline < this->NextDeadline)
+  {
+    this->NumberOfMissedDeadlines += missedTicks;
+  }
+  else if (lastMissedDeadline > this->LastMissedDeadline)
+  {
+    this->NumberOfMissedDeadlines += static_cast<unsigned long long>((lastMissedDeadline - this->LastMissedDeadline) / this->Period);
+  }
+  if (lastMissedDeadline > this->LastMissedDeadline)
+  {
+    this->LastMissedDeadline = lastMissedDeadline;
+  }
+
+  if (this->Policy == CATCH_UP_BURST && missedTicks <= static_cast<unsigned long long>(MAXIMUM_BURST_TICKS))
+  {
+    // Run the next update immediately, the schedule stays on the original grid
+    this->NextDeadline += this->Period;
+    return;
+  }
+
+  // Drop all missed ticks, none of them gets an update, continue at the next deadline of the grid
+  this->NextDeadline += this->Period * static_cast<Clock::rep>(missedTicks);
+  SleepUntil(this->NextDeadline);
+  this->NextDeadline += this->Period;
+}
+
+//----------------------------------------------------------------------------
+double PeriodicScheduler::GetTimeToNextDeadlineSec() const
+{
+  return std::chrono::duration<double>(this->NextDeadline - Clock::now()).count();
+}
+
+//----------------------------------------------------------------------------
+bool PeriodicScheduler::AdvanceIfDeadlineReached()
+{
+  const Clock::time_point now = Clock::now();
+  if (now < this->NextDeadline)
+  {
+    return false;
+  }
+  // Deadlines are not missed in event-driven mode, the update simply runs on the next tick
+  const Clock::rep passedTicks = static_cast<Clock::rep>((now - this->NextDeadline) / this->Period) + 1;
+  this->NextDeadline += this->Period * passedTicks;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::GetExecutionTimeHistogram(std::vector<unsigned long long>& binCounts) const
+{
+  binCounts.resize(NUMBER_OF_HISTOGRAM_BINS);
+  for (int i = 0; i < NUMBER_OF_HISTOGRAM_BINS; ++i)
+  {
+    binCounts[i] = this->ExecutionTimeHistogram[i];
+  }
+}
+
+//----------------------------------------------------------------------------
+double PeriodicScheduler::GetHistogramBinUpperLimitSec(int binIndex)
+{
+  if (binIndex < 0 || binIndex >= NUMBER_OF_HISTOGRAM_BINS - 1)
+  {
+    return -1.0;
+  }
+  return static_cast<double>(1LL << binIndex) * 1e-6;
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::ResetStatistics()
+{
+  this->NumberOfUpdates = 0;
+  this->NumberOfMissedDeadlines = 0;
+  for (int i = 0; i < NUMBER_OF_HISTOGRAM_BINS; ++i)
+  {
+    this->ExecutionTimeHistogram[i] = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+void PeriodicScheduler::SleepUntil(const Clock::time_point& deadline)
+{
+#if defined(__linux__)
+  // steady_clock is based on CLOCK_MONOTONIC, an absolute sleep does not accumulate wake-up latency
+  const long long deadlineNs = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline.time_since_epoch()).count();
+  timespec deadlineTimespec;
+  deadlineTimespec.tv_sec = static_cast<time_t>(deadlineNs / 1000000000LL);
+  deadlineTimespec.tv_nsec = static_cast<long>(deadlineNs % 1000000000LL);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadlineTimespec, NULL) == EINTR)
+  {
+    // interrupted by a signal, continue sleeping
+  }
+#else
+  std::this_thread::sleep_until(deadline);
+#endif
+}
@@ -0,0 +1,118 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PeriodicScheduler_h
+#define __PeriodicScheduler_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+// STL includes
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+/*!
+  \class PeriodicScheduler
+  \brief Runs a periodic task at absolute deadlines, so that the period error does not accumulate
+
+  Deadlines are on a fixed grid (start time + n * period), independently of how long each update takes.
+  If an update finishes after the next deadline then the deadline is missed (overrun). The catch-up policy
+  determines what happens then:
+  - SKIP: missed ticks are dropped, the next update is at the next deadline of the grid that is in the future
+  - BURST: missed ticks are executed back-to-back until the schedule is caught up. If the schedule is
+    too far behind (more than MAXIMUM_BURST_TICKS) then all missed ticks are dropped, as with SKIP.
+
+  Each missed deadline is counted once, also if it is passed again while the missed ticks are executed.
+  The number of missed deadlines and a histogram of the update execution times are collected. They can be read
+  from any thread while the scheduler is running.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PeriodicScheduler
+{
+public:
+  enum CatchUpPolicy
+  {
+    CATCH_UP_SKIP,
+    CATCH_UP_BURST
+  };
+
+  /*! Number of execution time histogram bins. Bin i contains execution times in [2^(i-1), 2^i) microseconds, the last bin contains all longer times. */
+  static const int NUMBER_OF_HISTOGRAM_BINS = 24;
+  /*! Maximum number of missed ticks that are executed back-to-back with the BURST policy */
+  static const int MAXIMUM_BURST_TICKS = 10;
+
+  PeriodicScheduler();
+
+  /*! Set the time between deadlines. Takes effect at the next deadline. */
+  void SetPeriodSec(double periodSec);
+  double GetPeriodSec() const;
+
+  void SetCatchUpPolicy(CatchUpPolicy policy) { this->Policy = policy; }
+  CatchUpPolicy GetCatchUpPolicy() const { return this->Policy; }
+
+  /*! Start the schedule, the first deadline is one period from now. Statistics are not reset. */
+  void Start();
+
+  /*! Call before the periodic update */
+  void BeginUpdate();
+
+  /*! Call after the periodic update, the execution time is added to the histogram */
+  void EndUpdate();
+
+  /*!
+    Sleep until the next deadline, then advance to the following deadline. If the deadline has already passed
+    then the overrun is counted and the catch-up policy is applied.
+  */
+  void WaitForNextDeadline();
+
+  /*! Get the time until the next deadline in seconds. Negative if the deadline has passed. */
+  double GetTimeToNextDeadlineSec() const;
+
+  /*!
+    Advance to the following deadline if the next deadline has been reached. Used by event-driven updates,
+    which also run between deadlines. Returns true if the deadline has been reached.
+  */
+  bool AdvanceIfDeadlineReached();
+
+  /*! Number of updates since the statistics were reset */
+  unsigned long long GetNumberOfUpdates() const { return this->NumberOfUpdates; }
+
+  /*! Number of deadlines that passed while an update was running */
+  unsigned long long GetNumberOfMissedDeadlines() const { return this->NumberOfMissedDeadlines; }
+
+  /*! Get the number of updates in each execution time histogram bin */
+  void GetExecutionTimeHistogram(std::vector<unsigned long long>& binCounts) const;
+
+  /*! Get the upper limit of an execution time histogram bin in seconds, the last bin has no upper limit */
+  static double GetHistogramBinUpperLimitSec(int binIndex);
+
+  /*! Set all counters and the histogram to zero */
+  void ResetStatistics();
+
+private:
+  PeriodicScheduler(const PeriodicScheduler&);
+  PeriodicScheduler& operator=(const PeriodicScheduler&);
+
+  typedef std::chrono::steady_clock Clock;
+
+  /*! Sleep until the specified absolute time */
+  static void SleepUntil(const Clock::time_point& deadline);
+
+  Clock::duration Period;
+  CatchUpPolicy Policy;
+  Clock::time_point NextDeadline;
+  Clock::time_point UpdateStartTime;
+  /*! Latest deadline that has been counted as missed, so that it is not counted again by the next BURST tick */
+  Clock::time_point LastMissedDeadline;
+
+  std::atomic<unsigned long long> NumberOfUpdates;
+  std::atomic<unsigned long long> NumberOfMissedDeadlines;
+  std::array<std::atomic<unsigned long long>, NUMBER_OF_HISTOGRAM_BINS> ExecutionTimeHistogram;
+};
+
+#endif
@@ -0,0 +1,273 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusPoseInterpolator.h"
+
+// VTK includes
+#include <vtkMath.h>
+
+// STL includes
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+  // If the orientations are closer than this (1 - cos(angle/2)) then linear interpolation is used instead of SLERP
+  const double SLERP_LINEAR_THRESHOLD = 0.0001;
+
+  const size_t MINIMUM_CAPACITY = 16;
+
+  //----------------------------------------------------------------------------
+  void Reserve(std::vector<double>* components, int numberOfComponents, size_t capacity)
+  {
+    for (int i = 0; i < numberOfComponents; ++i)
+    {
+      if (components[i].size() < capacity)
+      {
+        components[i].resize(capacity);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+PoseInterpolator::PoseInterpolator()
+  : NumberOfPoses(0)
+{
+}
+
+//----------------------------------------------------------------------------
+void PoseInterpolator::Clear()
+{
+  this->NumberOfPoses = 0;
+}
+
+//----------------------------------------------------------------------------
+int PoseInterpolator::GetNumberOfPoses() const
+{
+  return this->NumberOfPoses;
+}
+
+//----------------------------------------------------------------------------
+int PoseInterpolator::AddPosePair(const double matrixA[16], const double matrixB[16], double weightB)
+{
+  const size_t poseIndex = static_cast<size_t>(this->NumberOfPoses);
+  if (poseIndex >= this->WeightB.size())
+  {
+    const size_t capacity = std::max(MINIMUM_CAPACITY, 2 * poseIndex);
+    Reserve(this->RotationA, 9, capacity);
+    Reserve(this->RotationB, 9, capacity);
+    Reserve(this->TranslationA, 3, capacity);
+    Reserve(this->TranslationB, 3, capacity);
+    Reserve(&this->WeightB, 1, capacity);
+  }
+
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 3; ++column)
+    {
+      this->RotationA[row * 3 + column][poseIndex] = matrixA[row * 4 + column];
+      this->RotationB[row * 3 + column][poseIndex] = matrixB[row * 4 + column];
+    }
+    this->TranslationA[row][poseIndex] = matrixA[row * 4 + 3];
+    this->TranslationB[row][poseIndex] = matrixB[row * 4 + 3];
+  }
+  this->WeightB[poseIndex] = weightB;
+
+  return this->NumberOfPoses++;
+}
+
+//----------------------------------------------------------------------------
+void PoseInterpolator::RotationsToQuaternions(int numberOfPoses, const std::vector<double> rotation[9], std::vector<double> quaternion[4])
+{
+  const double* m00 = rotation[0].data();
+  const double* m01 = rotation[1].data();
+  const double* m02 = rotation[2].data();
+  const double* m10 = rotation[3].data();
+  const double* m11 = rotation[4].data();
+  const double* m12 = rotation[5].data();
+  const double* m20 = rotation[6].data();
+  const double* m21 = rotation[7].data();
+  const double* m22 = rotation[8].data();
+  double* qw = quaternion[0].data();
+  double* qx = quaternion[1].data();
+  double* qy = quaternion[2].data();
+  double* qz = quaternion[3].data();
+
+  // Shepperd's method: the component with the largest magnitude is computed from the diagonal, the others
+  // from the off-diagonal elements. All four cases are computed and the result is selected without branching.
+  for (int i = 0; i < numberOfPoses; ++i)
+  {
+    const double tw = 1.0 + m00[i] + m11[i] + m22[i];
+    const double tx = 1.0 + m00[i] - m11[i] - m22[i];
+    const double ty = 1.0 - m00[i] + m11[i] - m22[i];
+    const double tz = 1.0 - m00[i] - m11[i] + m22[i];
+
+    const bool useW = (tw >= tx && tw >= ty && tw >= tz);
+    const bool useX = (!useW && tx >= ty && tx >= tz);
+    const bool useY = (!useW && !useX && ty >= tz);
+    const bool useZ = (!useW && !useX && !useY);
+
+    // The largest of the four terms is at least 1, as their sum is 4
+    const double t = useW ? tw : (useX ? tx : (useY ? ty : tz));
+    const double s = 0.5 / sqrt(t);
+
+    const double diff21 = (m21[i] - m12[i]) * s;
+    const double diff02 = (m02[i] - m20[i]) * s;
+    const double diff10 = (m10[i] - m01[i]) * s;
+    const double sum01 = (m01[i] + m10[i]) * s;
+    const double sum02 = (m02[i] + m20[i]) * s;
+    const double sum12 = (m12[i] + m21[i]) * s;
+    const double largest = t * s;
+
+    qw[i] = useW ? largest : (useX ? diff21 : (useY ? diff02 : diff10));
+    qx[i] = useX ? largest : (useW ? diff21 : (useY ? sum01 : sum02));
+    qy[i] = useY ? largest : (useW ? diff02 : (useX ? sum01 : sum12));
+    qz[i] = useZ ? largest : (useW ? diff10 : (useX ? sum02 : sum12));
+  }
+}
+
+//----------------------------------------------------------------------------
+void PoseInterpolator::Interpolate()
+{
+  const int n = this->NumberOfPoses;
+  const size_t capacity = this->WeightB.size();
+  Reserve(this->QuaternionA, 4, capacity);
+  Reserve(this->QuaternionB, 4, capacity);
+  Reserve(this->InterpolatedRotation, 9, capacity);
+  Reserve(this->InterpolatedTranslation, 3, capacity);
+  Reserve(&this->SlerpScaleA, 1, capacity);
+  Reserve(&this->SlerpScaleB, 1, capacity);
+  Reserve(&this->CosHalfAngleFromA, 1, capacity);
+  Reserve(&this->CosHalfAngleFromB, 1, capacity);
+
+  RotationsToQuaternions(n, this->RotationA, this->QuaternionA);
+  RotationsToQuaternions(n, this->RotationB, this->QuaternionB);
+
+  const double* aw = this->QuaternionA[0].data();
+  const double* ax = this->QuaternionA[1].data();
+  const double* ay = this->QuaternionA[2].data();
+  const double* az = this->QuaternionA[3].data();
+  double* bw = this->QuaternionB[0].data();
+  double* bx = this->QuaternionB[1].data();
+  double* by = this->QuaternionB[2].data();
+  double* bz = this->QuaternionB[3].data();
+  const double* weightB = this->WeightB.data();
+
+  double* scaleA = this->SlerpScaleA.data();
+  double* scaleB = this->SlerpScaleB.data();
+
+  //============== SLERP coefficients ==================
+  for (int i = 0; i < n; ++i)
+  {
+    double cosom = aw[i] * bw[i] + ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+
+    // Interpolate along the shorter path
+    const double sign = (cosom < 0.0) ? -1.0 : 1.0;
+    cosom *= sign;
+    bw[i] *= sign;
+    bx[i] *= sign;
+    by[i] *= sign;
+    bz[i] *= sign;
+
+    // Very close orientations are interpolated linearly
+    const bool linear = (1.0 - cosom) <= SLERP_LINEAR_THRESHOLD;
+    const double omega = acos(std::min(cosom, 1.0));
+    const double sinom = linear ? 1.0 : sin(omega);
+    const double t = weightB[i];
+    scaleA[i] = linear ? (1.0 - t) : sin((1.0 - t) * omega) / sinom;
+    scaleB[i] = linear ? t : sin(t * omega) / sinom;
+  }
+
+  //============== Interpolated rotation and translation ==================
+  double* r00 = this->InterpolatedRotation[0].data();
+  double* r01 = this->InterpolatedRotation[1].data();
+  double* r02 = this->InterpolatedRotation[2].data();
+  double* r10 = this->InterpolatedRotation[3].data();
+  double* r11 = this->InterpolatedRotation[4].data();
+  double* r12 = this->InterpolatedRotation[5].data();
+  double* r20 = this->InterpolatedRotation[6].data();
+  double* r21 = this->InterpolatedRotation[7].data();
+  double* r22 = this->InterpolatedRotation[8].data();
+  double* cosHalfAngleFromA = this->CosHalfAngleFromA.data();
+  double* cosHalfAngleFromB = this->CosHalfAngleFromB.data();
+  for (int i = 0; i < n; ++i)
+  {
+    const double w = scaleA[i] * aw[i] + scaleB[i] * bw[i];
+    const double x = scaleA[i] * ax[i] + scaleB[i] * bx[i];
+    const double y = scaleA[i] * ay[i] + scaleB[i] * by[i];
+    const double z = scaleA[i] * az[i] + scaleB[i] * bz[i];
+
+    // Linear interpolation does not keep unit length, so the quaternion is normalized here
+    const double ww = w * w;
+    const double xx = x * x;
+    const double yy = y * y;
+    const double zz = z * z;
+    const double squaredNorm = ww + xx + yy + zz;
+    const double s = 1.0 / squaredNorm;
+    r00[i] = (ww + xx - yy - zz) * s;
+    r11[i] = (ww - xx + yy - zz) * s;
+    r22[i] = (ww - xx - yy + zz) * s;
+    r10[i] = 2.0 * (w * z + x * y) * s;
+    r01[i] = 2.0 * (x * y - w * z) * s;
+    r20[i] = 2.0 * (x * z - w * y) * s;
+    r02[i] = 2.0 * (w * y + x * z) * s;
+    r21[i] = 2.0 * (w * x + y * z) * s;
+    r12[i] = 2.0 * (y * z - w * x) * s;
+
+    // Orientation differences from the input poses
+    const double norm = sqrt(squaredNorm);
+    cosHalfAngleFromA[i] = fabs(w * aw[i] + x * ax[i] + y * ay[i] + z * az[i]) / norm;
+    cosHalfAngleFromB[i] = fabs(w * bw[i] + x * bx[i] + y * by[i] + z * bz[i]) / norm;
+  }
+
+  for (int component = 0; component < 3; ++component)
+  {
+    const double* translationA = this->TranslationA[component].data();
+    const double* translationB = this->TranslationB[component].data();
+    double* translation = this->InterpolatedTranslation[component].data();
+    for (int i = 0; i < n; ++i)
+    {
+      translation[i] = translationA[i] * (1.0 - weightB[i]) + translationB[i] * weightB[i];
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void PoseInterpolator::GetInterpolatedMatrix(int poseIndex, double matrix[16]) const
+{
+  for (int row = 0; row < 3; ++row)
+  {
+    for (int column = 0; column < 3; ++column)
+    {
+      matrix[row * 4 + column] = this->InterpolatedRotation[row * 3 + column][poseIndex];
+    }
+    matrix[row * 4 + 3] = this->InterpolatedTranslation[row][poseIndex];
+  }
+  matrix[12] = 0.0;
+  matrix[13] = 0.0;
+  matrix[14] = 0.0;
+  matrix[15] = 1.0;
+}
+
+//----------------------------------------------------------------------------
+double PoseInterpolator::GetAngleDegFromCosHalfAngle(double cosHalfAngle)
+{
+  return vtkMath::DegreesFromRadians(2.0 * acos(std::min(cosHalfAngle, 1.0)));
+}
+
+//----------------------------------------------------------------------------
+double PoseInterpolator::GetOrientationDifferenceFromA(int poseIndex) const
+{
+  return GetAngleDegFromCosHalfAngle(this->CosHalfAngleFromA[poseIndex]);
+}
+
+//----------------------------------------------------------------------------
+double PoseInterpolator::GetOrientationDifferenceFromB(int poseIndex) const
+{
+  return GetAngleDegFromCosHalfAngle(this->CosHalfAngleFromB[poseIndex]);
+}
@@ -0,0 +1,95 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PoseInterpolator_h
+#define __PoseInterpolator_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+// STL includes
+#include <vector>
+
+/*!
+  \class PoseInterpolator
+  \brief Interpolates a batch of poses between pairs of rigid transforms
+
+  The rotation is interpolated with SLERP interpolation and the position is interpolated with
+  linear interpolation, the same way as vtkPlusBuffer interpolates a single tool. The poses of all the tools
+  of a channel are collected first and then interpolated together. The pose components are stored
+  in a structure-of-arrays layout and the interpolation is computed in branch-free loops over the
+  components, which the compiler can vectorize. No heap allocation is made once the capacity of the batch
+  is reached, so the same interpolator should be reused for subsequent batches.
+
+  Usage: Clear, AddPosePair for each tool, Interpolate, then GetInterpolatedMatrix for each pose index.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport PoseInterpolator
+{
+public:
+  PoseInterpolator();
+
+  /*! Remove all poses from the batch. The allocated memory is kept. */
+  void Clear();
+
+  /*!
+    Add a pair of poses to the batch.
+    \param matrixA First pose, 4x4 homogeneous transformation matrix in row-major order
+    \param matrixB Second pose, 4x4 homogeneous transformation matrix in row-major order
+    \param weightB Weight of the second pose (0 = matrixA, 1 = matrixB)
+    \return Index of the interpolated pose
+  */
+  int AddPosePair(const double matrixA[16], const double matrixB[16], double weightB);
+
+  /*! Get the number of poses in the batch */
+  int GetNumberOfPoses() const;
+
+  /*! Interpolate all poses of the batch */
+  void Interpolate();
+
+  /*! Get an interpolated pose as a 4x4 homogeneous transformation matrix in row-major order. Interpolate must be called before. */
+  void GetInterpolatedMatrix(int poseIndex, double matrix[16]) const;
+
+  /*! Get the rotation angle between the interpolated pose and the first pose of the pair (in degrees) */
+  double GetOrientationDifferenceFromA(int poseIndex) const;
+
+  /*! Get the rotation angle between the interpolated pose and the second pose of the pair (in degrees) */
+  double GetOrientationDifferenceFromB(int poseIndex) const;
+
+protected:
+  /*! Convert rotation matrices to unit quaternions (w, x, y, z) */
+  static void RotationsToQuaternions(int numberOfPoses, const std::vector<double> rotation[9], std::vector<double> quaternion[4]);
+
+  /*! Rotation angle in degrees corresponding to the cosine of the half angle */
+  static double GetAngleDegFromCosHalfAngle(double cosHalfAngle);
+
+  int NumberOfPoses;
+
+  // Inputs: rotation matrix elements (row-major), translation and weight of each pose pair
+  std::vector<double> RotationA[9];
+  std::vector<double> RotationB[9];
+  std::vector<double> TranslationA[3];
+  std::vector<double> TranslationB[3];
+  std::vector<double> WeightB;
+
+  // Intermediate results
+  std::vector<double> QuaternionA[4];
+  std::vector<double> QuaternionB[4];
+  std::vector<double> SlerpScaleA;
+  std::vector<double> SlerpScaleB;
+
+  // Outputs
+  std::vector<double> InterpolatedRotation[9];
+  std::vector<double> InterpolatedTranslation[3];
+  std::vector<double> CosHalfAngleFromA;
+  std::vector<double> CosHalfAngleFromB;
+
+private:
+  PoseInterpolator(const PoseInterpolator&);
+  PoseInterpolator& operator=(const PoseInterpolator&);
+};
+
+#endif
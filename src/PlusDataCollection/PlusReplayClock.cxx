@@ -0,0 +1,113 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusReplayClock.h"
+
+// IGSIO includes
+#include <vtkIGSIOAccurateTimer.h>
+
+//----------------------------------------------------------------------------
+std::string ReplayClock::GetClockModeAsString(ClockMode mode)
+{
+  switch (mode)
+  {
+    case REPLAY_CLOCK_REAL_TIME:
+      return "REAL_TIME";
+    case REPLAY_CLOCK_FIXED_SPEED:
+      return "FIXED_SPEED";
+    case REPLAY_CLOCK_AS_FAST_AS_POSSIBLE:
+      return "AS_FAST_AS_POSSIBLE";
+  }
+  return "UNKNOWN";
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ReplayClock::GetClockModeFromString(const std::string& modeString, ClockMode& mode)
+{
+  if (igsioCommon::IsEqualInsensitive(modeString, "REAL_TIME"))
+  {
+    mode = REPLAY_CLOCK_REAL_TIME;
+  }
+  else if (igsioCommon::IsEqualInsensitive(modeString, "FIXED_SPEED"))
+  {
+    mode = REPLAY_CLOCK_FIXED_SPEED;
+  }
+  else if (igsioCommon::IsEqualInsensitive(modeString, "AS_FAST_AS_POSSIBLE"))
+  {
+    mode = REPLAY_CLOCK_AS_FAST_AS_POSSIBLE;
+  }
+  else
+  {
+    LOG_ERROR("Unknown replay clock mode: " << modeString << ". Valid modes: REAL_TIME, FIXED_SPEED, AS_FAST_AS_POSSIBLE");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+ReplayClock::ReplayClock()
+  : Mode(REPLAY_CLOCK_REAL_TIME)
+  , Speed(1.0)
+  , Time(0.0)
+{
+}
+
+//----------------------------------------------------------------------------
+void ReplayClock::SetMode(ClockMode mode)
+{
+  this->Mode = mode;
+}
+
+//----------------------------------------------------------------------------
+ReplayClock::ClockMode ReplayClock::GetMode() const
+{
+  return this->Mode;
+}
+
+//----------------------------------------------------------------------------
+bool ReplayClock::IsVirtual() const
+{
+  return this->Mode != REPLAY_CLOCK_REAL_TIME;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ReplayClock::SetSpeed(double speed)
+{
+  if (speed <= 0)
+  {
+    LOG_ERROR("Replay speed must be positive, requested: " << speed);
+    return PLUS_FAIL;
+  }
+  this->Speed = speed;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+double ReplayClock::GetSpeed() const
+{
+  return this->Speed;
+}
+
+//----------------------------------------------------------------------------
+void ReplayClock::SetTime(double timeSec)
+{
+  if (!this->IsVirtual())
+  {
+    return;
+  }
+  this->Time = timeSec;
+}
+
+//----------------------------------------------------------------------------
+double ReplayClock::GetTime() const
+{
+  if (!this->IsVirtual())
+  {
+    return vtkIGSIOAccurateTimer::GetSystemTime();
+  }
+  return this->Time;
+}
@@ -0,0 +1,73 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __ReplayClock_h
+#define __ReplayClock_h
+
+#include "PlusConfigure.h"
+#include "vtkPlusDataCollectionExport.h"
+
+// STL includes
+#include <atomic>
+#include <string>
+
+/*!
+  \class ReplayClock
+  \brief Time source of the devices when recorded data is replayed
+
+  In REAL_TIME mode the clock returns the system time. In the virtual modes the time is advanced in
+  fixed steps by the data collector, which updates the saved data sources and the virtual devices on
+  a single thread after each step. All of these devices see the same timeline, so a replay produces
+  the same frames and timestamps (relative to the start time) on every run, independently of the load
+  of the computer.
+
+  - FIXED_SPEED: the timeline runs Speed times faster than the system time (slower if Speed < 1)
+  - AS_FAST_AS_POSSIBLE: the next step is taken as soon as all devices have processed the current one
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport ReplayClock
+{
+public:
+  enum ClockMode
+  {
+    REPLAY_CLOCK_REAL_TIME,
+    REPLAY_CLOCK_FIXED_SPEED,
+    REPLAY_CLOCK_AS_FAST_AS_POSSIBLE
+  };
+
+  static std::string GetClockModeAsString(ClockMode mode);
+  static PlusStatus GetClockModeFromString(const std::string& modeString, ClockMode& mode);
+
+  ReplayClock();
+
+  /*! Must be set before the data collector is started */
+  void SetMode(ClockMode mode);
+  ClockMode GetMode() const;
+
+  /*! Returns true if the time is advanced by the data collector instead of following the system time */
+  bool IsVirtual() const;
+
+  /*! Ratio of the replay time to the system time in FIXED_SPEED mode. Must be positive. */
+  PlusStatus SetSpeed(double speed);
+  double GetSpeed() const;
+
+  /*! Set the current time of a virtual clock. Ignored in REAL_TIME mode. */
+  void SetTime(double timeSec);
+
+  /*! Get the current time. Returns the system time in REAL_TIME mode. May be called from any thread. */
+  double GetTime() const;
+
+private:
+  ReplayClock(const ReplayClock&);
+  ReplayClock& operator=(const ReplayClock&);
+
+  ClockMode Mode;
+  double Speed;
+  std::atomic<double> Time;
+};
+
+#endif
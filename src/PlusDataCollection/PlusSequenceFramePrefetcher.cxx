@@ -0,0 +1,337 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusSequenceFramePrefetcher.h"
+#include "vtkPlusSequenceIO.h"
+
+// STL includes
+#include <algorithm>
+
+namespace
+{
+  const unsigned int DEFAULT_READ_AHEAD_FRAMES = 30;
+}
+
+//----------------------------------------------------------------------------
+SequenceFramePrefetcher::SequenceFramePrefetcher()
+  : NumberOfFrames(0)
+  , Opened(false)
+  , ReadAheadFrames(DEFAULT_READ_AHEAD_FRAMES)
+  , FirstFrameIndex(0)
+  , LastFrameIndex(0)
+  , Repeat(false)
+  , CursorFrameIndex(0)
+  , StopRequested(false)
+{
+}
+
+//----------------------------------------------------------------------------
+SequenceFramePrefetcher::~SequenceFramePrefetcher()
+{
+  this->Close();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFramePrefetcher::Open(const std::string& sequenceFilename)
+{
+  this->Close();
+
+  if (vtkPlusSequenceIO::OpenFrameIndexes(sequenceFilename, this->SegmentFrameIndexes) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  this->NumberOfFrames = 0;
+  for (std::vector<SequenceFrameIndex>::const_iterator it = this->SegmentFrameIndexes.begin(); it != this->SegmentFrameIndexes.end(); ++it)
+  {
+    this->SegmentFirstFrameIndexes.push_back(this->NumberOfFrames);
+    this->NumberOfFrames += it->GetNumberOfFrames();
+  }
+  if (this->NumberOfFrames == 0)
+  {
+    LOG_DEBUG("Frame index of " << sequenceFilename << " is empty");
+    this->SegmentFrameIndexes.clear();
+    this->SegmentFirstFrameIndexes.clear();
+    return PLUS_FAIL;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->Opened = true;
+    this->StopRequested = false;
+    this->FirstFrameIndex = 0;
+    this->LastFrameIndex = this->NumberOfFrames - 1;
+    this->Repeat = false;
+    this->CursorFrameIndex = 0;
+    this->UpdateWindow();
+  }
+  this->PrefetchThread = std::thread(&SequenceFramePrefetcher::PrefetchThreadMain, this);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void SequenceFramePrefetcher::Close()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->StopRequested = true;
+    this->WindowChangedCondition.notify_all();
+    this->FrameReadCondition.notify_all();
+  }
+  if (this->PrefetchThread.joinable())
+  {
+    this->PrefetchThread.join();
+  }
+
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->Opened = false;
+  this->Window.clear();
+  this->Frames.clear();
+  this->SegmentFrameIndexes.clear();
+  this->SegmentFirstFrameIndexes.clear();
+  this->NumberOfFrames = 0;
+}
+
+//----------------------------------------------------------------------------
+bool SequenceFramePrefetcher::IsOpen() const
+{
+  return this->Opened;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SequenceFramePrefetcher::GetNumberOfFrames() const
+{
+  return this->NumberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+double SequenceFramePrefetcher::GetTimestamp(unsigned int frameIndex) const
+{
+  unsigned int segmentIndex = 0;
+  unsigned int segmentFrameIndex = 0;
+  this->GetSegmentFrameIndex(frameIndex, segmentIndex, segmentFrameIndex);
+  return this->SegmentFrameIndexes[segmentIndex].GetTimestamp(segmentFrameIndex);
+}
+
+//----------------------------------------------------------------------------
+const igsioFieldMapType& SequenceFramePrefetcher::GetFrameFields(unsigned int frameIndex) const
+{
+  unsigned int segmentIndex = 0;
+  unsigned int segmentFrameIndex = 0;
+  this->GetSegmentFrameIndex(frameIndex, segmentIndex, segmentFrameIndex);
+  return this->SegmentFrameIndexes[segmentIndex].GetFrameFields(segmentFrameIndex);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFramePrefetcher::FindFrameIndex(double timestamp, unsigned int& frameIndex) const
+{
+  if (this->NumberOfFrames == 0)
+  {
+    return PLUS_FAIL;
+  }
+  // Segments are in recording order, the closest frame is in the first segment that ends after the timestamp, or it is the last frame before it
+  std::vector<SequenceFrameIndex>::size_type segmentIndex = 0;
+  while (segmentIndex + 1 < this->SegmentFrameIndexes.size()
+         && (this->SegmentFrameIndexes[segmentIndex].GetNumberOfFrames() == 0
+             || this->SegmentFrameIndexes[segmentIndex].GetTimestamp(this->SegmentFrameIndexes[segmentIndex].GetNumberOfFrames() - 1) < timestamp))
+  {
+    segmentIndex++;
+  }
+  unsigned int segmentFrameIndex = 0;
+  if (this->SegmentFrameIndexes[segmentIndex].FindFrameIndex(timestamp, segmentFrameIndex) != PLUS_SUCCESS)
+  {
+    // Only the last segment may be empty here, the closest frame is the last frame of the sequence
+    frameIndex = this->NumberOfFrames - 1;
+    return PLUS_SUCCESS;
+  }
+  frameIndex = this->SegmentFirstFrameIndexes[segmentIndex] + segmentFrameIndex;
+  if (frameIndex > 0 && segmentFrameIndex == 0 && timestamp - this->GetTimestamp(frameIndex - 1) < this->GetTimestamp(frameIndex) - timestamp)
+  {
+    frameIndex--;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void SequenceFramePrefetcher::GetSegmentFrameIndex(unsigned int frameIndex, unsigned int& segmentIndex, unsigned int& segmentFrameIndex) const
+{
+  // Last segment that starts at or before the frame. Empty segments start at the same frame as the next segment, so they are skipped.
+  std::vector<unsigned int>::const_iterator segmentStart = std::upper_bound(this->SegmentFirstFrameIndexes.begin(), this->SegmentFirstFrameIndexes.end(), frameIndex) - 1;
+  segmentIndex = static_cast<unsigned int>(segmentStart - this->SegmentFirstFrameIndexes.begin());
+  segmentFrameIndex = frameIndex - *segmentStart;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFramePrefetcher::SetReadAheadFrames(unsigned int numberOfFrames)
+{
+  if (numberOfFrames < 1)
+  {
+    LOG_ERROR("SequenceFramePrefetcher: number of read-ahead frames must be at least 1");
+    return PLUS_FAIL;
+  }
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  this->ReadAheadFrames = numberOfFrames;
+  if (this->Opened)
+  {
+    this->UpdateWindow();
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SequenceFramePrefetcher::GetReadAheadFrames() const
+{
+  return this->ReadAheadFrames;
+}
+
+//----------------------------------------------------------------------------
+void SequenceFramePrefetcher::SetReplayRange(unsigned int firstFrameIndex, unsigned int lastFrameIndex, bool repeat)
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  if (!this->Opened)
+  {
+    return;
+  }
+  const unsigned int maxFrameIndex = this->NumberOfFrames - 1;
+  this->FirstFrameIndex = std::min(firstFrameIndex, maxFrameIndex);
+  this->LastFrameIndex = std::max(this->FirstFrameIndex, std::min(lastFrameIndex, maxFrameIndex));
+  this->Repeat = repeat;
+  this->UpdateWindow();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus SequenceFramePrefetcher::GetFrame(unsigned int frameIndex, std::shared_ptr<igsioTrackedFrame>& frame)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  if (!this->Opened || frameIndex >= this->NumberOfFrames)
+  {
+    LOG_ERROR("SequenceFramePrefetcher: frame " << frameIndex << " is not available");
+    return PLUS_FAIL;
+  }
+  if (frameIndex != this->CursorFrameIndex)
+  {
+    this->CursorFrameIndex = frameIndex;
+    this->UpdateWindow();
+  }
+
+  // The requested frame is at the beginning of the window, so it is the next one that is read
+  this->FrameReadCondition.wait(lock, [this, frameIndex]
+  {
+    return this->StopRequested || this->Frames.find(frameIndex) != this->Frames.end();
+  });
+  if (this->StopRequested)
+  {
+    LOG_ERROR("SequenceFramePrefetcher: prefetching is stopped, frame " << frameIndex << " is not available");
+    return PLUS_FAIL;
+  }
+  frame = this->Frames[frameIndex];
+  if (!frame)
+  {
+    LOG_ERROR("SequenceFramePrefetcher: frame " << frameIndex << " could not be read");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+unsigned int SequenceFramePrefetcher::GetNumberOfPrefetchedFrames()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return static_cast<unsigned int>(this->Frames.size());
+}
+
+//----------------------------------------------------------------------------
+void SequenceFramePrefetcher::UpdateWindow()
+{
+  this->Window.clear();
+  const unsigned int numberOfFrames = this->NumberOfFrames;
+  unsigned int frameIndex = this->CursorFrameIndex;
+  while (this->Window.size() < this->ReadAheadFrames && frameIndex < numberOfFrames)
+  {
+    this->Window.push_back(frameIndex);
+    if (frameIndex == this->LastFrameIndex || frameIndex + 1 == numberOfFrames)
+    {
+      if (!this->Repeat)
+      {
+        break;
+      }
+      frameIndex = this->FirstFrameIndex;
+    }
+    else
+    {
+      frameIndex++;
+    }
+    if (frameIndex == this->CursorFrameIndex)
+    {
+      // The whole replay range fits in the window
+      break;
+    }
+  }
+
+  for (std::map<unsigned int, std::shared_ptr<igsioTrackedFrame> >::iterator it = this->Frames.begin(); it != this->Frames.end();)
+  {
+    if (std::find(this->Window.begin(), this->Window.end(), it->first) == this->Window.end())
+    {
+      this->Frames.erase(it++);
+    }
+    else
+    {
+      ++it;
+    }
+  }
+  this->WindowChangedCondition.notify_all();
+}
+
+//----------------------------------------------------------------------------
+void SequenceFramePrefetcher::PrefetchThreadMain()
+{
+  // The pixel data file of the segment that is read is kept open, it is only reopened when the next frame is in another segment
+  std::ifstream pixelDataFile;
+  unsigned int openedSegmentIndex = static_cast<unsigned int>(this->SegmentFrameIndexes.size());
+
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  while (!this->StopRequested)
+  {
+    // Read the first frame of the window that is not read yet
+    std::vector<unsigned int>::const_iterator nextFrame = this->Window.begin();
+    while (nextFrame != this->Window.end() && this->Frames.find(*nextFrame) != this->Frames.end())
+    {
+      ++nextFrame;
+    }
+    if (nextFrame == this->Window.end())
+    {
+      this->WindowChangedCondition.wait(lock);
+      continue;
+    }
+    const unsigned int frameIndex = *nextFrame;
+
+    // The frame indexes are not modified while the thread runs, so the file is read without holding the lock
+    lock.unlock();
+    unsigned int segmentIndex = 0;
+    unsigned int segmentFrameIndex = 0;
+    this->GetSegmentFrameIndex(frameIndex, segmentIndex, segmentFrameIndex);
+    const SequenceFrameIndex& segment = this->SegmentFrameIndexes[segmentIndex];
+    std::shared_ptr<igsioTrackedFrame> frame = std::make_shared<igsioTrackedFrame>();
+    if (segmentIndex != openedSegmentIndex)
+    {
+      pixelDataFile.close();
+      pixelDataFile.clear();
+      openedSegmentIndex = (segment.OpenPixelDataFile(pixelDataFile) == PLUS_SUCCESS ? segmentIndex : static_cast<unsigned int>(this->SegmentFrameIndexes.size()));
+    }
+    if (segmentIndex != openedSegmentIndex || segment.ReadFrame(pixelDataFile, segmentFrameIndex, *frame) != PLUS_SUCCESS)
+    {
+      frame.reset();
+    }
+    lock.lock();
+
+    // The cursor may have moved while the frame was read
+    if (std::find(this->Window.begin(), this->Window.end(), frameIndex) != this->Window.end())
+    {
+      this->Frames[frameIndex] = frame;
+    }
+    this->FrameReadCondition.notify_all();
+  }
+}
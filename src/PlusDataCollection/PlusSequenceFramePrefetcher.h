@@ -0,0 +1,117 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __SequenceFramePrefetcher_h
+#define __SequenceFramePrefetcher_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusSequenceFrameIndex.h"
+
+// STL includes
+#include <condition_variable>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/*!
+  \class SequenceFramePrefetcher
+  \brief Reads the frames of a sequence file on a background thread, ahead of a replay cursor
+
+  Frames are read through the frame index of the sequence file (see SequenceFrameIndex), so the sequence
+  file is never loaded completely. A segmented sequence (see SequenceSegmentIndex) is read through the frame
+  indexes of its segment files, as a single sequence. The prefetching thread keeps the pixel data file of the
+  segment that it reads open. Only the frames in the read-ahead window are kept in memory: the frame at
+  the replay cursor and the ReadAheadFrames-1 frames that are replayed after it. When the end of the replay
+  range is reached and repeat is enabled then the window continues at the beginning of the range.
+
+  Requesting a frame moves the replay cursor to it, frames that fall out of the window are released.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport SequenceFramePrefetcher
+{
+public:
+  SequenceFramePrefetcher();
+  ~SequenceFramePrefetcher();
+
+  /*!
+    Read the frame index of the sequence file (or of each segment file) and start prefetching from the first frame.
+    Fails if the sequence file has no up-to-date frame index that locates the pixel data of the frames.
+  */
+  PlusStatus Open(const std::string& sequenceFilename);
+
+  /*! Stop prefetching and release all frames */
+  void Close();
+
+  bool IsOpen() const;
+
+  /*! Number of frames of the sequence, in all segments */
+  unsigned int GetNumberOfFrames() const;
+
+  /*! Timestamp of a frame of the sequence, read from the frame index */
+  double GetTimestamp(unsigned int frameIndex) const;
+
+  /*! Frame fields of a frame of the sequence, read from the frame index */
+  const igsioFieldMapType& GetFrameFields(unsigned int frameIndex) const;
+
+  /*! Index of the frame that has the closest timestamp to the requested one */
+  PlusStatus FindFrameIndex(double timestamp, unsigned int& frameIndex) const;
+
+  /*! Number of frames kept in memory, including the frame at the replay cursor */
+  PlusStatus SetReadAheadFrames(unsigned int numberOfFrames);
+  unsigned int GetReadAheadFrames() const;
+
+  /*! Range of frames that are replayed. If repeat is enabled then the first frame is replayed after the last one. */
+  void SetReplayRange(unsigned int firstFrameIndex, unsigned int lastFrameIndex, bool repeat);
+
+  /*! Get a frame and move the replay cursor to it. Waits until the frame is read from the file. */
+  PlusStatus GetFrame(unsigned int frameIndex, std::shared_ptr<igsioTrackedFrame>& frame);
+
+  /*! Number of frames that are currently held in memory */
+  unsigned int GetNumberOfPrefetchedFrames();
+
+private:
+  SequenceFramePrefetcher(const SequenceFramePrefetcher&);
+  SequenceFramePrefetcher& operator=(const SequenceFramePrefetcher&);
+
+  void PrefetchThreadMain();
+
+  /*! Find the segment that contains the frame and the index of the frame in the segment */
+  void GetSegmentFrameIndex(unsigned int frameIndex, unsigned int& segmentIndex, unsigned int& segmentFrameIndex) const;
+
+  /*! Compute the frames of the read-ahead window and release frames outside of it. Must be called with Mutex locked. */
+  void UpdateWindow();
+
+  /*! Frame index of each segment file, or of the sequence file if it is not segmented */
+  std::vector<SequenceFrameIndex> SegmentFrameIndexes;
+  /*! Index of the first frame of each segment in the sequence */
+  std::vector<unsigned int> SegmentFirstFrameIndexes;
+  unsigned int NumberOfFrames;
+  bool Opened;
+  unsigned int ReadAheadFrames;
+  unsigned int FirstFrameIndex;
+  unsigned int LastFrameIndex;
+  bool Repeat;
+  unsigned int CursorFrameIndex;
+
+  /*! Frames that are replayed next, in replay order, starting at the cursor */
+  std::vector<unsigned int> Window;
+  /*! Frames that are read. A null pointer marks a frame that could not be read. */
+  std::map<unsigned int, std::shared_ptr<igsioTrackedFrame> > Frames;
+
+  bool StopRequested;
+  std::mutex Mutex;
+  /*! Notified when the window changes or prefetching has to stop */
+  std::condition_variable WindowChangedCondition;
+  /*! Notified when a frame is read */
+  std::condition_variable FrameReadCondition;
+  std::thread PrefetchThread;
+};
+
+#endif
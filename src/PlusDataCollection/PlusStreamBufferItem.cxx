@@ -17,6 +17,8 @@ StreamBufferItem::StreamBufferItem()
   , Index(0)
   , Uid(0)
   , ValidTransformData(false)
+  , NativeFrameFourCC(0)
+  , NativeFrameConverted(false)
   , Matrix(vtkSmartPointer<vtkMatrix4x4>::New())
   , Status(TOOL_OK)
 {
@@ -32,6 +34,8 @@ StreamBufferItem::StreamBufferItem(const StreamBufferItem& dataItem)
 {
   this->Matrix = vtkSmartPointer<vtkMatrix4x4>::New();
   this->Status = TOOL_OK;
+  this->NativeFrameFourCC = 0;
+  this->NativeFrameConverted = false;
   *this = dataItem;
 }
 
@@ -54,14 +58,61 @@ StreamBufferItem& StreamBufferItem::operator=(StreamBufferItem const& dataItem)
   this->Matrix->DeepCopy(dataItem.Matrix);
   this->ValidTransformData = dataItem.ValidTransformData;
 
+  // The native pixel data is only needed until it is converted
+  this->NativeFrameFourCC = dataItem.NativeFrameFourCC;
+  this->NativeFrameConverted = dataItem.NativeFrameConverted;
+  if (dataItem.HasUnconvertedNativeFrame())
+  {
+    this->NativeFrameData = dataItem.NativeFrameData;
+  }
+  else
+  {
+    this->NativeFrameData.clear();
+  }
+
   return *this;
 }
 
 //----------------------------------------------------------------------------
-void StreamBufferItem::SetFrameField(std::string fieldName, std::string fieldValue, igsioFrameFieldFlags flags)
+void StreamBufferItem::SetNativeFrame(const void* data, unsigned int sizeInBytes, unsigned int fourCC)
+{
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  this->NativeFrameData.assign(bytes, bytes + sizeInBytes);
+  this->NativeFrameFourCC = fourCC;
+  this->NativeFrameConverted = false;
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::ClearNativeFrame()
+{
+  this->NativeFrameData.clear();
+  this->NativeFrameFourCC = 0;
+  this->NativeFrameConverted = false;
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::SetFrameField(const std::string& fieldName, const std::string& fieldValue, igsioFrameFieldFlags flags)
 {
-  this->FrameFields[fieldName].first = flags;
-  this->FrameFields[fieldName].second = fieldValue;
+  this->SetFrameField(FrameFieldSchema::GetFieldId(fieldName), fieldValue, flags);
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItem::SetFrameField(FrameFieldId fieldId, const std::string& fieldValue, igsioFrameFieldFlags flags)
+{
+  for (FrameFieldContainer::iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); ++it)
+  {
+    if (it->Id == fieldId)
+    {
+      it->Flags = flags;
+      it->Value = fieldValue;
+      return;
+    }
+  }
+  FrameField field;
+  field.Id = fieldId;
+  field.Flags = flags;
+  field.Value = fieldValue;
+  this->FrameFields.push_back(field);
 }
 
 //----------------------------------------------------------------------------
@@ -73,15 +124,30 @@ std::string StreamBufferItem::GetFrameField(const std::string& fieldName) const
     return "";
   }
 
-  igsioFieldMapType::const_iterator fieldIterator;
-  fieldIterator = this->FrameFields.find(fieldName);
-  if (fieldIterator != this->FrameFields.end())
+  FrameFieldId fieldId = FrameFieldSchema::FindFieldId(fieldName);
+  for (FrameFieldContainer::const_iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); ++it)
   {
-    return fieldIterator->second.second;
+    if (it->Id == fieldId)
+    {
+      return it->Value;
+    }
   }
   return "";
 }
 
+//----------------------------------------------------------------------------
+igsioFieldMapType StreamBufferItem::GetFrameFieldMap() const
+{
+  igsioFieldMapType fieldMap;
+  for (FrameFieldContainer::const_iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); ++it)
+  {
+    igsioFieldMapType::mapped_type& field = fieldMap[FrameFieldSchema::GetFieldName(it->Id)];
+    field.first = it->Flags;
+    field.second = it->Value;
+  }
+  return fieldMap;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus StreamBufferItem::DeleteFrameField(const char* fieldName)
 {
@@ -91,11 +157,14 @@ PlusStatus StreamBufferItem::DeleteFrameField(const char* fieldName)
     return PLUS_FAIL;
   }
 
-  igsioFieldMapType::iterator field = this->FrameFields.find(fieldName);
-  if (field != this->FrameFields.end())
+  FrameFieldId fieldId = FrameFieldSchema::FindFieldId(fieldName);
+  for (FrameFieldContainer::iterator it = this->FrameFields.begin(); it != this->FrameFields.end(); ++it)
   {
-    this->FrameFields.erase(field);
-    return PLUS_SUCCESS;
+    if (it->Id == fieldId)
+    {
+      this->FrameFields.erase(it);
+      return PLUS_SUCCESS;
+    }
   }
   LOG_DEBUG("Failed to delete frame field - could find field " << fieldName);
   return PLUS_FAIL;
@@ -151,6 +220,36 @@ PlusStatus StreamBufferItem::GetMatrix(vtkMatrix4x4* outputMatrix)
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus StreamBufferItem::SetMatrix(const double matrixElements[16])
+{
+  if (matrixElements == NULL)
+  {
+    LOG_ERROR("Failed to set matrix - input matrix is NULL!");
+    return PLUS_FAIL;
+  }
+
+  ValidTransformData = true;
+
+  this->Matrix->DeepCopy(matrixElements);
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus StreamBufferItem::GetMatrix(double matrixElements[16])
+{
+  if (matrixElements == NULL)
+  {
+    LOG_ERROR("Failed to copy matrix - output matrix is NULL!");
+    return PLUS_FAIL;
+  }
+
+  vtkMatrix4x4::DeepCopy(matrixElements, this->Matrix);
+
+  return PLUS_SUCCESS;
+}
+
 //----------------------------------------------------------------------------
 void StreamBufferItem::SetStatus(ToolStatus status)
 {
@@ -166,5 +265,5 @@ ToolStatus StreamBufferItem::GetStatus() const
 //----------------------------------------------------------------------------
 bool StreamBufferItem::HasValidFieldData() const
 {
-  return this->FrameFields.size() > 0;
+  return !this->FrameFields.empty();
 }
\ No newline at end of file
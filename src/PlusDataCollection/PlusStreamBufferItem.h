@@ -8,6 +8,7 @@ See License.txt for details.
 #define __StreamBufferItem_h
 
 #include "vtkPlusDataCollectionExport.h"
+#include "PlusFrameFieldSchema.h"
 
 // IGSIO includes
 #include <igsioCommon.h>
@@ -38,6 +39,15 @@ class vtkPlusVirtualMixer;
 class vtkPlusDataCollectionExport StreamBufferItem
 {
 public:
+  /*! Frame field stored in a buffer item, the name is interned in FrameFieldSchema */
+  struct FrameField
+  {
+    FrameFieldId Id;
+    igsioFrameFieldFlags Flags;
+    std::string Value;
+  };
+  typedef std::vector<FrameField> FrameFieldContainer;
+
   StreamBufferItem();
   virtual ~StreamBufferItem();
 
@@ -72,12 +82,16 @@ public:
   void SetUid(BufferItemUidType uid) { this->Uid = uid; };
 
   /*! Set frame field */
-  void SetFrameField(std::string fieldName, std::string fieldValue, igsioFrameFieldFlags flags = FRAMEFIELD_NONE);
+  void SetFrameField(const std::string& fieldName, const std::string& fieldValue, igsioFrameFieldFlags flags = FRAMEFIELD_NONE);
+  /*! Set frame field by interned name, avoids the name lookup in hot paths */
+  void SetFrameField(FrameFieldId fieldId, const std::string& fieldValue, igsioFrameFieldFlags flags = FRAMEFIELD_NONE);
 
   /*! Get frame field value */
   std::string GetFrameField(const std::string& fieldName) const;
-  /*! Get frame field map */
-  igsioFieldMapType GetFrameFieldMap() {return this->FrameFields;}
+  /*! Get frame field map. The map is built from the stored fields, prefer GetFrameFields in performance-critical code. */
+  igsioFieldMapType GetFrameFieldMap() const;
+  /*! Get the stored frame fields, in the order they were added */
+  const FrameFieldContainer& GetFrameFields() const { return this->FrameFields; }
   /*! Delete frame field */
   PlusStatus DeleteFrameField(const char* fieldName);
   PlusStatus DeleteFrameField(const std::string& fieldName);
@@ -87,10 +101,32 @@ public:
 
   igsioVideoFrame& GetFrame() { return this->Frame; };
 
+  /*!
+    Store the pixel data in the native encoding of the device, identified by a FourCC code.
+    The frame image is not valid until the native frame is converted (see vtkPlusBuffer).
+  */
+  void SetNativeFrame(const void* data, unsigned int sizeInBytes, unsigned int fourCC);
+  /*! Returns true if the item stores a native frame that has not been converted to the frame image yet */
+  bool HasUnconvertedNativeFrame() const { return this->NativeFrameFourCC != 0 && !this->NativeFrameConverted; }
+  /*! Get the FourCC code of the native frame, 0 if the item does not store a native frame */
+  unsigned int GetNativeFrameFourCC() const { return this->NativeFrameFourCC; }
+  /*! Get the pixel data of the native frame */
+  unsigned char* GetNativeFrameData() { return this->NativeFrameData.empty() ? NULL : &this->NativeFrameData[0]; }
+  /*! Get the size of the native frame in bytes */
+  unsigned int GetNativeFrameSizeInBytes() const { return static_cast<unsigned int>(this->NativeFrameData.size()); }
+  /*! Indicate that the native frame has been converted to the frame image */
+  void SetNativeFrameConverted() { this->NativeFrameConverted = true; }
+  /*! Remove the native frame. The allocated memory is kept for the next native frame. */
+  void ClearNativeFrame();
+
   /*! Set tracker matrix */
   PlusStatus SetMatrix(vtkMatrix4x4* matrix);
   /*! Get tracker matrix */
   PlusStatus GetMatrix(vtkMatrix4x4* outputMatrix);
+  /*! Set tracker matrix from 16 elements in row-major order */
+  PlusStatus SetMatrix(const double matrixElements[16]);
+  /*! Get tracker matrix as 16 elements in row-major order */
+  PlusStatus GetMatrix(double matrixElements[16]);
 
   /*! Set tracker item status */
   void SetStatus(ToolStatus status);
@@ -115,11 +151,20 @@ protected:
   /*! unique identifier assigned by the storage buffer, it is guaranteed to increase monotonously, by one for each frame that is added to the buffer*/
   BufferItemUidType Uid;
 
-  /*! Custom frame fields */
-  igsioFieldMapType FrameFields;
+  /*!
+    Custom frame fields. A flat vector is used instead of a map, so that assigning an item to a recycled
+    item of the circular buffer reuses the already allocated memory of the fields.
+  */
+  FrameFieldContainer FrameFields;
 
   bool ValidTransformData;
   igsioVideoFrame Frame;
+
+  /*! Pixel data in the native encoding of the device, converted to Frame on first read */
+  std::vector<unsigned char> NativeFrameData;
+  /*! FourCC code of the native frame encoding, 0 if the item does not store a native frame */
+  unsigned int NativeFrameFourCC;
+  bool NativeFrameConverted;
   vtkSmartPointer<vtkMatrix4x4> Matrix;
   ToolStatus Status;
 };
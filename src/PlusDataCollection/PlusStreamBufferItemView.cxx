@@ -0,0 +1,114 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusStreamBufferItemView.h"
+
+//----------------------------------------------------------------------------
+StreamBufferItemView::StreamBufferItemView()
+  : Item(NULL)
+  , BufferIndex(-1)
+{
+}
+
+//----------------------------------------------------------------------------
+StreamBufferItemView::~StreamBufferItemView()
+{
+  this->Release();
+}
+
+//----------------------------------------------------------------------------
+StreamBufferItemView::StreamBufferItemView(const StreamBufferItemView& view)
+  : Item(NULL)
+  , BufferIndex(-1)
+{
+  *this = view;
+}
+
+//----------------------------------------------------------------------------
+StreamBufferItemView& StreamBufferItemView::operator=(const StreamBufferItemView& view)
+{
+  // Handle self-assignment
+  if (this == &view)
+  {
+    return *this;
+  }
+
+  // Pin first, so that the slot remains pinned if both views refer to the same item
+  if (view.Item != NULL)
+  {
+    view.Buffer->PinBufferIndex(view.BufferIndex);
+  }
+  this->Release();
+  this->Buffer = view.Buffer;
+  this->Item = view.Item;
+  this->BufferIndex = view.BufferIndex;
+
+  return *this;
+}
+
+//----------------------------------------------------------------------------
+void StreamBufferItemView::Release()
+{
+  if (this->Item != NULL)
+  {
+    this->Buffer->UnpinBufferIndex(this->BufferIndex);
+  }
+  this->Buffer = NULL;
+  this->Item = NULL;
+  this->BufferIndex = -1;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus StreamBufferItemView::Pin(vtkPlusTimestampedCircularBuffer* buffer, BufferItemUidType uid)
+{
+  this->Release();
+  if (buffer == NULL)
+  {
+    LOG_ERROR("Failed to pin buffer item - buffer is NULL!");
+    return ITEM_UNKNOWN_ERROR;
+  }
+
+  StreamBufferItem* itemPtr = NULL;
+  int bufferIndex = -1;
+  ItemStatus status = buffer->PinBufferItem(uid, itemPtr, bufferIndex);
+  if (status != ITEM_OK)
+  {
+    return status;
+  }
+
+  this->Buffer = buffer;
+  this->Item = itemPtr;
+  this->BufferIndex = bufferIndex;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+double StreamBufferItemView::GetTimestamp() const
+{
+  if (this->Item == NULL)
+  {
+    LOG_ERROR("Failed to get timestamp - view does not refer to any buffer item!");
+    return 0;
+  }
+  return this->Item->GetFilteredTimestamp(this->Buffer->GetLocalTimeOffsetSec());
+}
+
+//----------------------------------------------------------------------------
+PlusStatus StreamBufferItemView::DeepCopyTo(StreamBufferItem* bufferItem) const
+{
+  if (this->Item == NULL)
+  {
+    LOG_ERROR("Failed to copy buffer item - view does not refer to any buffer item!");
+    return PLUS_FAIL;
+  }
+  if (bufferItem == NULL)
+  {
+    LOG_ERROR("Failed to copy buffer item - output buffer item is NULL!");
+    return PLUS_FAIL;
+  }
+  return bufferItem->DeepCopy(this->Item);
+}
@@ -0,0 +1,67 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __StreamBufferItemView_h
+#define __StreamBufferItemView_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusStreamBufferItem.h"
+#include "vtkPlusTimestampedCircularBuffer.h"
+
+// VTK includes
+#include <vtkSmartPointer.h>
+
+/*!
+  \class StreamBufferItemView
+  \brief Read-only, zero-copy access to an item that is stored in a timestamped circular buffer.
+
+  While a view refers to an item, the buffer slot of the item is pinned: the buffer does not
+  overwrite it with new data (new items are skipped if the buffer wraps around to a pinned slot).
+  Copying a view adds one more pin to the same slot, the slot is released when the last view that
+  refers to it is released or destroyed. Views are meant to be held only while the item is being
+  processed; use DeepCopyTo to keep the data for a longer time.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport StreamBufferItemView
+{
+public:
+  StreamBufferItemView();
+  ~StreamBufferItemView();
+
+  StreamBufferItemView(const StreamBufferItemView& view);
+  StreamBufferItemView& operator=(const StreamBufferItemView& view);
+
+  /*! Returns true if the view refers to a buffer item */
+  bool IsValid() const { return this->Item != NULL; }
+
+  /*! Unpin the referenced buffer item. The view is invalid afterwards. */
+  void Release();
+
+  /*!
+    Get the referenced buffer item. Returns NULL if the view is invalid.
+    The item is owned by the buffer and must not be modified.
+  */
+  StreamBufferItem* GetItem() const { return this->Item; }
+
+  /*! Get the (filtered) timestamp of the referenced item in global time */
+  double GetTimestamp() const;
+
+  /*! Copy the referenced item, for consumers that need to keep the data after the view is released */
+  PlusStatus DeepCopyTo(StreamBufferItem* bufferItem) const;
+
+protected:
+  friend class vtkPlusBuffer;
+
+  /*! Release the current item and pin the item with the specified UID in the buffer */
+  ItemStatus Pin(vtkPlusTimestampedCircularBuffer* buffer, BufferItemUidType uid);
+
+  vtkSmartPointer<vtkPlusTimestampedCircularBuffer> Buffer;
+  StreamBufferItem* Item;
+  int BufferIndex;
+};
+
+#endif
@@ -0,0 +1,186 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "PlusThreadScheduling.h"
+
+#if defined(__linux__)
+  #include <pthread.h>
+  #include <sched.h>
+  #include <sys/mman.h>
+  #include <cerrno>
+  #include <cstring>
+#endif
+
+// STL includes
+#include <algorithm>
+#include <sstream>
+
+//----------------------------------------------------------------------------
+PlusStatus ThreadScheduling::ApplyToCurrentThread(const std::vector<int>& cpuAffinity, SchedulingPolicy policy, int priority)
+{
+  PlusStatus status = PLUS_SUCCESS;
+
+#if defined(__linux__)
+  if (!cpuAffinity.empty())
+  {
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    for (std::vector<int>::const_iterator it = cpuAffinity.begin(); it != cpuAffinity.end(); ++it)
+    {
+      if (*it < 0 || *it >= CPU_SETSIZE)
+      {
+        LOG_WARNING("CPU ID " << *it << " is out of range, it is ignored in the thread CPU affinity");
+        continue;
+      }
+      CPU_SET(*it, &cpuSet);
+    }
+    int result = pthread_setaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet);
+    if (result != 0)
+    {
+      LOG_WARNING("Failed to set thread CPU affinity to " << CpuListToString(cpuAffinity) << ": " << strerror(result));
+      status = PLUS_FAIL;
+    }
+  }
+
+  if (policy != SCHEDULING_POLICY_DEFAULT)
+  {
+    int schedulingPolicy = (policy == SCHEDULING_POLICY_FIFO ? SCHED_FIFO : SCHED_RR);
+    sched_param schedulingParameters;
+    memset(&schedulingParameters, 0, sizeof(schedulingParameters));
+    schedulingParameters.sched_priority = std::max(sched_get_priority_min(schedulingPolicy), std::min(priority, sched_get_priority_max(schedulingPolicy)));
+    int result = pthread_setschedparam(pthread_self(), schedulingPolicy, &schedulingParameters);
+    if (result != 0)
+    {
+      LOG_WARNING("Failed to set real-time thread scheduling (" << (policy == SCHEDULING_POLICY_FIFO ? "SCHED_FIFO" : "SCHED_RR")
+                  << ", priority " << schedulingParameters.sched_priority << "): " << strerror(result)
+                  << ". CAP_SYS_NICE capability or RLIMIT_RTPRIO limit may be required.");
+      status = PLUS_FAIL;
+    }
+  }
+#else
+  if (!cpuAffinity.empty() || policy != SCHEDULING_POLICY_DEFAULT)
+  {
+    LOG_WARNING("Thread CPU affinity and real-time scheduling are only supported on Linux");
+    status = PLUS_FAIL;
+  }
+#endif
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ThreadScheduling::LockProcessMemory()
+{
+#if defined(__linux__)
+  if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+  {
+    LOG_WARNING("Failed to lock process memory: " << strerror(errno) << ". CAP_IPC_LOCK capability or RLIMIT_MEMLOCK limit may be required.");
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+#else
+  LOG_WARNING("Memory locking is only supported on Linux");
+  return PLUS_FAIL;
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ThreadScheduling::UnlockProcessMemory()
+{
+#if defined(__linux__)
+  if (munlockall() != 0)
+  {
+    LOG_WARNING("Failed to unlock process memory: " << strerror(errno));
+    return PLUS_FAIL;
+  }
+#endif
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::string ThreadScheduling::GetCurrentThreadScheduling()
+{
+#if defined(__linux__)
+  std::ostringstream description;
+
+  int schedulingPolicy(0);
+  sched_param schedulingParameters;
+  memset(&schedulingParameters, 0, sizeof(schedulingParameters));
+  if (pthread_getschedparam(pthread_self(), &schedulingPolicy, &schedulingParameters) == 0)
+  {
+    switch (schedulingPolicy)
+    {
+      case SCHED_FIFO:
+        description << "SCHED_FIFO, priority " << schedulingParameters.sched_priority;
+        break;
+      case SCHED_RR:
+        description << "SCHED_RR, priority " << schedulingParameters.sched_priority;
+        break;
+      default:
+        description << "SCHED_OTHER";
+        break;
+    }
+  }
+  else
+  {
+    description << "unknown policy";
+  }
+
+  cpu_set_t cpuSet;
+  CPU_ZERO(&cpuSet);
+  if (pthread_getaffinity_np(pthread_self(), sizeof(cpuSet), &cpuSet) == 0)
+  {
+    std::vector<int> cpuIds;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+      if (CPU_ISSET(cpu, &cpuSet))
+      {
+        cpuIds.push_back(cpu);
+      }
+    }
+    description << ", CPUs: " << CpuListToString(cpuIds);
+  }
+
+  return description.str();
+#else
+  return "default";
+#endif
+}
+
+//----------------------------------------------------------------------------
+PlusStatus ThreadScheduling::ParseCpuList(const std::string& cpuList, std::vector<int>& cpuIds)
+{
+  cpuIds.clear();
+  std::string separatedBySpaces(cpuList);
+  std::replace(separatedBySpaces.begin(), separatedBySpaces.end(), ',', ' ');
+  std::istringstream cpuListStream(separatedBySpaces);
+  std::string token;
+  while (cpuListStream >> token)
+  {
+    std::istringstream tokenStream(token);
+    int cpuId(-1);
+    if (!(tokenStream >> cpuId) || !tokenStream.eof() || cpuId < 0)
+    {
+      LOG_ERROR("Invalid CPU ID '" << token << "' in CPU list: " << cpuList);
+      cpuIds.clear();
+      return PLUS_FAIL;
+    }
+    cpuIds.push_back(cpuId);
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+std::string ThreadScheduling::CpuListToString(const std::vector<int>& cpuIds)
+{
+  std::ostringstream cpuList;
+  for (std::vector<int>::const_iterator it = cpuIds.begin(); it != cpuIds.end(); ++it)
+  {
+    cpuList << (it == cpuIds.begin() ? "" : " ") << *it;
+  }
+  return cpuList.str();
+}
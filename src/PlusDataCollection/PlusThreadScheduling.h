@@ -0,0 +1,65 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __ThreadScheduling_h
+#define __ThreadScheduling_h
+
+#include "vtkPlusDataCollectionExport.h"
+#include "PlusCommon.h"
+
+// STL includes
+#include <string>
+#include <vector>
+
+/*!
+  \class ThreadScheduling
+  \brief Sets the CPU affinity and the real-time scheduling policy of the calling thread
+
+  Pinning the acquisition threads to dedicated CPUs and running them with a real-time policy
+  prevents other threads (e.g., video processing) from delaying the acquisition, which would
+  add jitter to the timestamps. Real-time scheduling and memory locking are only available on
+  Linux, and they usually require the CAP_SYS_NICE and CAP_IPC_LOCK capabilities or suitable
+  RLIMIT_RTPRIO and RLIMIT_MEMLOCK limits. Memory locking applies to the whole process, therefore
+  it is controlled by the data collector instead of the individual devices.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport ThreadScheduling
+{
+public:
+  enum SchedulingPolicy
+  {
+    SCHEDULING_POLICY_DEFAULT, ///< The scheduling policy of the thread is not changed
+    SCHEDULING_POLICY_FIFO,    ///< SCHED_FIFO: runs until it blocks or a higher priority thread is ready
+    SCHEDULING_POLICY_RR       ///< SCHED_RR: like SCHED_FIFO, but threads of equal priority share the CPU in time slices
+  };
+
+  /*!
+    Apply the scheduling settings to the calling thread. Each setting is applied independently, so if
+    one of them fails then the others are still applied.
+    \param cpuAffinity IDs of the CPUs that the thread may run on, empty if the affinity is not changed
+    \param policy Scheduling policy
+    \param priority Real-time priority, it is clamped to the range that the policy allows
+  */
+  static PlusStatus ApplyToCurrentThread(const std::vector<int>& cpuAffinity, SchedulingPolicy policy, int priority);
+
+  /*! Lock all current and future pages of the process in memory, so that no thread is delayed by paging */
+  static PlusStatus LockProcessMemory();
+
+  /*! Release the memory lock of the process */
+  static PlusStatus UnlockProcessMemory();
+
+  /*! Get a human-readable description of the scheduling policy, priority and CPU affinity of the calling thread */
+  static std::string GetCurrentThreadScheduling();
+
+  /*! Parse a list of CPU IDs separated by spaces or commas */
+  static PlusStatus ParseCpuList(const std::string& cpuList, std::vector<int>& cpuIds);
+
+  /*! Convert a list of CPU IDs to a string of space separated IDs */
+  static std::string CpuListToString(const std::vector<int>& cpuIds);
+};
+
+#endif
@@ -13,11 +13,37 @@ See License.txt for details.
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
 #include "vtkPlusSavedDataSource.h"
+#include "vtkPlusSequenceIO.h"
 #include "vtkIGSIOTrackedFrameList.h"
 #include "vtksys/SystemTools.hxx"
 
 vtkStandardNewMacro(vtkPlusSavedDataSource);
 
+namespace
+{
+  /*! UID of the first frame of the file in streaming mode (UIDs of items in a vtkPlusBuffer start at 1, too) */
+  const BufferItemUidType STREAMING_FIRST_FRAME_UID = 1;
+  const int DEFAULT_STREAMING_READ_AHEAD_FRAMES = 30;
+
+  //----------------------------------------------------------------------------
+  /*! Get the frame fields that are replayed. Timestamps and frame number are set when the frame is added to the output. */
+  igsioFieldMapType GetReplayedFrameFields(const igsioFieldMapType& frameFields)
+  {
+    igsioFieldMapType replayedFields;
+    for (igsioFieldMapType::const_iterator fieldIterator = frameFields.begin(); fieldIterator != frameFields.end(); ++fieldIterator)
+    {
+      if (igsioCommon::IsEqualInsensitive(fieldIterator->first, "TimeStamp")
+          || igsioCommon::IsEqualInsensitive(fieldIterator->first, "UnfilteredTimestamp")
+          || igsioCommon::IsEqualInsensitive(fieldIterator->first, "FrameNumber"))
+      {
+        continue;
+      }
+      replayedFields[fieldIterator->first] = fieldIterator->second;
+    }
+    return replayedFields;
+  }
+}
+
 //----------------------------------------------------------------------------
 vtkPlusSavedDataSource::vtkPlusSavedDataSource()
   : FrameBufferRowAlignment(1)
@@ -28,6 +54,9 @@ vtkPlusSavedDataSource::vtkPlusSavedDataSource()
   , LocalVideoBuffer(NULL)
   , UseAllFrameFields(false)
   , UseOriginalTimestamps(false)
+  , StreamingEnabled(false)
+  , StreamingReadAheadFrames(DEFAULT_STREAMING_READ_AHEAD_FRAMES)
+  , Streaming(false)
   , LastAddedFrameUid(0)
   , LastAddedLoopIndex(0)
   , SimulatedStream(VIDEO_STREAM)
@@ -51,6 +80,9 @@ vtkPlusSavedDataSource::~vtkPlusSavedDataSource()
 void vtkPlusSavedDataSource::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "StreamingEnabled: " << (this->StreamingEnabled ? "TRUE" : "FALSE") << std::endl;
+  os << indent << "StreamingReadAheadFrames: " << this->StreamingReadAheadFrames << std::endl;
+  os << indent << "Streaming: " << (this->Streaming ? "TRUE" : "FALSE") << std::endl;
 }
 
 //----------------------------------------------------------------------------
@@ -85,7 +117,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdate()
 PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUidType frameToBeAddedUid, int frameToBeAddedLoopIndex)
 {
   // Compute elapsed time since we started the acquisition
-  double elapsedTime = vtkIGSIOAccurateTimer::GetSystemTime() - this->GetOutputDataSource()->GetStartTime();
+  double elapsedTime = this->GetClockTime() - this->GetOutputDataSource()->GetStartTime();
   double loopTime = this->LoopStopTime_Local - this->LoopStartTime_Local;
 
   const int numberOfFramesInTheLoop = this->LoopLastFrameUid - this->LoopFirstFrameUid + 1;
@@ -107,8 +139,9 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
     {
       currentLoopIndex = floor(elapsedTime / loopTime);
       currentFrameTime_Local = this->LoopStartTime_Local + elapsedTime - loopTime * currentLoopIndex;
+      double oldestTimestamp_Local = 0;
       double latestTimestamp_Local = 0;
-      GetLocalBuffer()->GetLatestTimeStamp(latestTimestamp_Local);
+      this->GetReplayTimeRange(oldestTimestamp_Local, latestTimestamp_Local);
       if (currentFrameTime_Local > latestTimestamp_Local)
       {
         // hold the last frame after the end of the buffer
@@ -119,9 +152,9 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
 
     // Get the uid of the frame that has been most recently acquired
     BufferItemUidType closestFrameUid = 0;
-    GetLocalBuffer()->GetItemUidFromTime(currentFrameTime_Local, closestFrameUid);
+    this->GetReplayItemUidFromTime(currentFrameTime_Local, closestFrameUid);
     double closestFrameTime_Local = 0;
-    GetLocalBuffer()->GetTimeStamp(closestFrameUid, closestFrameTime_Local);
+    this->GetReplayTimeStamp(closestFrameUid, closestFrameTime_Local);
     if (closestFrameTime_Local > currentFrameTime_Local)
     {
       // the closest frame is newer than the current time, so don't use this item but the one before
@@ -155,8 +188,8 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
     // TODO: use the UID difference as increment
     this->FrameNumber++;
 
-    StreamBufferItem dataBufferItemToBeAdded;
-    if (GetLocalBuffer()->GetStreamBufferItem(frameToBeAddedUid, &dataBufferItemToBeAdded) != ITEM_OK)
+    double frameToBeAddedTimestamp_Local = 0;
+    if (this->GetReplayTimeStamp(frameToBeAddedUid, frameToBeAddedTimestamp_Local) != ITEM_OK)
     {
       LOG_ERROR("vtkPlusSavedDataSource: Failed to retrieve item from the buffer, UID=" << frameToBeAddedUid);
       status = PLUS_FAIL;
@@ -164,8 +197,8 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
     }
 
     // Compute the system time corresponding to this frame
-    // Get the filtered timestamp from the buffer without any local time offset. Offset will be applied when it is copied to the output stream's buffer.
-    double filteredTimestamp = dataBufferItemToBeAdded.GetFilteredTimestamp(0.0) + frameToBeAddedLoopIndex * loopTime -
+    // The local buffer has no local time offset. Offset will be applied when it is copied to the output stream's buffer.
+    double filteredTimestamp = frameToBeAddedTimestamp_Local + frameToBeAddedLoopIndex * loopTime -
                                this->LoopStartTime_Local + this->GetOutputDataSource()->GetStartTime();
     double unfilteredTimestamp = filteredTimestamp; // we ignore unfiltered timestamps
 
@@ -173,12 +206,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
     {
       case VIDEO_STREAM:
         {
-          igsioFieldMapType fieldMap;
-          if (this->UseAllFrameFields)
-          {
-            fieldMap = dataBufferItemToBeAdded.GetFrameFieldMap();
-          }
-          if (this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap) != PLUS_SUCCESS)
+          if (this->AddReplayedVideoItem(frameToBeAddedUid, unfilteredTimestamp, filteredTimestamp) != PLUS_SUCCESS)
           {
             status = PLUS_FAIL;
           }
@@ -187,7 +215,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateOriginalTimestamp(BufferItemUid
       case TRACKER_STREAM:
         {
           // retrieve timestamp from the first active tool and add all the tool matrices corresponding to that timestamp
-          double nextFrameTimestamp = dataBufferItemToBeAdded.GetFilteredTimestamp(0.0);
+          double nextFrameTimestamp = frameToBeAddedTimestamp_Local;
 
           for (DataSourceContainerConstIterator it = this->GetToolIteratorBegin(); it != this->GetToolIteratorEnd(); ++it)
           {
@@ -262,26 +290,23 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
   }
 
   this->FrameNumber++;
-  StreamBufferItem dataBufferItemToBeAdded;
-  if (GetLocalBuffer()->GetStreamBufferItem(frameToBeAddedUid, &dataBufferItemToBeAdded) != ITEM_OK)
+  double frameToBeAddedTimestamp_Local = 0;
+  if (this->GetReplayTimeStamp(frameToBeAddedUid, frameToBeAddedTimestamp_Local) != ITEM_OK)
   {
     LOG_ERROR("vtkPlusSavedDataSource: Failed to retrieve item from the buffer, UID=" << frameToBeAddedUid);
     return PLUS_FAIL;
   }
 
+  // Current time of the device (time of the replay clock, if the device is driven by one), filtered timestamps are computed from it
+  const double unfilteredTimestamp = this->GetClockTime();
+
   PlusStatus status = PLUS_SUCCESS;
   switch (this->SimulatedStream)
   {
     case VIDEO_STREAM:
       {
-        igsioFieldMapType fieldMap;
-        if (this->UseAllFrameFields)
-        {
-          fieldMap = dataBufferItemToBeAdded.GetFrameFieldMap();
-        }
-        if (this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, UNDEFINED_TIMESTAMP, UNDEFINED_TIMESTAMP, &fieldMap) != PLUS_SUCCESS)
+        if (this->AddReplayedVideoItem(frameToBeAddedUid, unfilteredTimestamp, UNDEFINED_TIMESTAMP) != PLUS_SUCCESS)
         {
-          // UNDEFINED_TIMESTAMP => use current timestamp
           status = PLUS_FAIL;
         }
         break;
@@ -289,7 +314,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
     case TRACKER_STREAM:
       {
         // retrieve timestamp from the first active tool and add all the tool matrices corresponding to that timestamp
-        double nextFrameTimestamp = dataBufferItemToBeAdded.GetTimestamp(0);
+        double nextFrameTimestamp = frameToBeAddedTimestamp_Local;
 
         for (DataSourceContainerConstIterator it = this->GetToolIteratorBegin(); it != this->GetToolIteratorEnd(); ++it)
         {
@@ -331,7 +356,7 @@ PlusStatus vtkPlusSavedDataSource::InternalUpdateCurrentTimestamp(BufferItemUidT
           // This device has no frame numbering, just auto increment tool frame number if new frame received
           unsigned long frameNumber = tool->GetFrameNumber() + 1 ;
           // send the transformation matrix and flags to the tool
-          if (this->ToolTimeStampedUpdate(tool->GetId(), toolTransMatrix, toolStatus, frameNumber, UNDEFINED_TIMESTAMP) != PLUS_SUCCESS)
+          if (this->ToolTimeStampedUpdate(tool->GetId(), toolTransMatrix, toolStatus, frameNumber, unfilteredTimestamp) != PLUS_SUCCESS)
           {
             status = PLUS_FAIL;
           }
@@ -381,8 +406,12 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
 
   vtkSmartPointer<vtkIGSIOTrackedFrameList> savedDataBuffer = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
 
-  // Read sequence file into tracked frame list
-  vtkIGSIOSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer);
+  this->Streaming = false;
+  if (!this->StreamingEnabled || this->OpenStreaming(foundAbsoluteImagePath, savedDataBuffer) != PLUS_SUCCESS)
+  {
+    // Read sequence file into tracked frame list
+    vtkPlusSequenceIO::Read(foundAbsoluteImagePath, savedDataBuffer);
+  }
 
   if (savedDataBuffer->GetNumberOfTrackedFrames() < 1)
   {
@@ -415,21 +444,28 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
   }
 
   double oldestTimestamp_Local = 0;
-  GetLocalBuffer()->GetOldestTimeStamp(oldestTimestamp_Local);
   double latestTimestamp_Local = 0;
-  GetLocalBuffer()->GetLatestTimeStamp(latestTimestamp_Local);
+  this->GetReplayTimeRange(oldestTimestamp_Local, latestTimestamp_Local);
 
   // Set the default loop start time and length to match the video buffer start time and length
 
-  this->LoopFirstFrameUid = GetLocalBuffer()->GetOldestItemUidInBuffer();
-  this->LoopLastFrameUid = GetLocalBuffer()->GetLatestItemUidInBuffer();
+  if (this->Streaming)
+  {
+    this->LoopFirstFrameUid = STREAMING_FIRST_FRAME_UID;
+    this->LoopLastFrameUid = STREAMING_FIRST_FRAME_UID + this->Prefetcher.GetNumberOfFrames() - 1;
+  }
+  else
+  {
+    this->LoopFirstFrameUid = GetLocalBuffer()->GetOldestItemUidInBuffer();
+    this->LoopLastFrameUid = GetLocalBuffer()->GetLatestItemUidInBuffer();
+  }
 
   this->LoopStartTime_Local = oldestTimestamp_Local;
 
   // When we reach the last frame we have to wait one frame period before
   // playing the first frame, so we have to add one frame period to the loop length (loopTime)
   double framePeriodSec = 0;
-  double frameRate = GetLocalBuffer()->GetFrameRate();
+  double frameRate = this->GetReplayFrameRate();
   if (frameRate != 0.0)
   {
     framePeriodSec = 1.0 / frameRate;
@@ -453,6 +489,8 @@ PlusStatus vtkPlusSavedDataSource::InternalConnect()
   this->LastAddedFrameUid = this->LoopFirstFrameUid - 1;
   this->LastAddedLoopIndex = 0;
 
+  this->UpdateStreamingReplayRange();
+
   return PLUS_SUCCESS;
 }
 
@@ -613,6 +651,8 @@ PlusStatus vtkPlusSavedDataSource::InternalConnectTracker(vtkIGSIOTrackedFrameLi
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusSavedDataSource::InternalDisconnect()
 {
+  this->Prefetcher.Close();
+  this->Streaming = false;
   DeleteLocalBuffers();
   return PLUS_SUCCESS;
 }
@@ -670,6 +710,13 @@ PlusStatus vtkPlusSavedDataSource::ReadConfiguration(vtkXMLDataElement* rootConf
 
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(RepeatEnabled, deviceConfig);
   XML_READ_BOOL_ATTRIBUTE_OPTIONAL(UseOriginalTimestamps, deviceConfig);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(StreamingEnabled, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, StreamingReadAheadFrames, deviceConfig);
+  if (this->StreamingReadAheadFrames < 1)
+  {
+    LOG_ERROR("Invalid StreamingReadAheadFrames: " << this->StreamingReadAheadFrames << ". It must be at least 1.");
+    return PLUS_FAIL;
+  }
 
   const char* useData = deviceConfig->GetAttribute("UseData");
   if (useData != NULL)
@@ -707,6 +754,11 @@ PlusStatus vtkPlusSavedDataSource::WriteConfiguration(vtkXMLDataElement* rootCon
   XML_WRITE_CSTRING_ATTRIBUTE_IF_NOT_NULL(SequenceFile, imageAcquisitionConfig);
   XML_WRITE_BOOL_ATTRIBUTE(RepeatEnabled, imageAcquisitionConfig);
   XML_WRITE_BOOL_ATTRIBUTE(UseOriginalTimestamps, imageAcquisitionConfig);
+  XML_WRITE_BOOL_ATTRIBUTE(StreamingEnabled, imageAcquisitionConfig);
+  if (this->StreamingEnabled)
+  {
+    imageAcquisitionConfig->SetIntAttribute("StreamingReadAheadFrames", this->StreamingReadAheadFrames);
+  }
 
   if (this->UseAllFrameFields)
   {
@@ -776,6 +828,8 @@ void vtkPlusSavedDataSource::SetLoopTimeRange(double loopStartTime, double loopS
 
   this->LastAddedFrameUid = this->LoopFirstFrameUid - 1;
   this->LastAddedLoopIndex = 0;
+
+  this->UpdateStreamingReplayRange();
 }
 
 //----------------------------------------------------------------------------
@@ -792,9 +846,8 @@ BufferItemUidType vtkPlusSavedDataSource::GetClosestFrameUidWithinTimeRange(doub
   }
   // time_Local should be also within the local buffer time range
   double oldestTimestamp_Local = 0;
-  GetLocalBuffer()->GetOldestTimeStamp(oldestTimestamp_Local);
   double latestTimestamp_Local = 0;
-  GetLocalBuffer()->GetLatestTimeStamp(latestTimestamp_Local);
+  this->GetReplayTimeRange(oldestTimestamp_Local, latestTimestamp_Local);
 
   // if the asked time is outside of the loop range then return the closest element in the range
   if (time_Local < oldestTimestamp_Local)
@@ -808,9 +861,9 @@ BufferItemUidType vtkPlusSavedDataSource::GetClosestFrameUidWithinTimeRange(doub
 
   // Get the uid of the frame that has been most recently acquired
   BufferItemUidType closestFrameUid = 0;
-  GetLocalBuffer()->GetItemUidFromTime(time_Local, closestFrameUid);
+  this->GetReplayItemUidFromTime(time_Local, closestFrameUid);
   double closestFrameTime_Local = 0;
-  GetLocalBuffer()->GetTimeStamp(closestFrameUid, closestFrameTime_Local);
+  this->GetReplayTimeStamp(closestFrameUid, closestFrameTime_Local);
 
   // The closest frame is at the boundary, but it may be just outside the range:
   // use the next/previous frame if the closest frame is on the wrong side of the boundary
@@ -829,6 +882,185 @@ BufferItemUidType vtkPlusSavedDataSource::GetClosestFrameUidWithinTimeRange(doub
   }
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::OpenStreaming(const std::string& sequenceFilePath, vtkIGSIOTrackedFrameList* savedDataBuffer)
+{
+  if (this->SimulatedStream == TRACKER_STREAM)
+  {
+    // Only the transforms are replayed, they are stored in the frame index, so no image data has to be read.
+    // A segmented sequence is read from the frame indexes of its segment files.
+    std::vector<SequenceFrameIndex> frameIndexes;
+    if (vtkPlusSequenceIO::OpenFrameIndexes(sequenceFilePath, frameIndexes, false) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Sequence file " << sequenceFilePath << " has no up-to-date frame index, it is loaded completely. "
+                  << "The index can be created by EditSequenceFile --operation=BUILD_FRAME_INDEX.");
+      return PLUS_FAIL;
+    }
+    for (std::vector<SequenceFrameIndex>::const_iterator frameIndex = frameIndexes.begin(); frameIndex != frameIndexes.end(); ++frameIndex)
+    {
+      for (unsigned int i = 0; i < frameIndex->GetNumberOfFrames(); ++i)
+      {
+        igsioTrackedFrame trackedFrame;
+        const igsioFieldMapType& frameFields = frameIndex->GetFrameFields(i);
+        for (igsioFieldMapType::const_iterator fieldIterator = frameFields.begin(); fieldIterator != frameFields.end(); ++fieldIterator)
+        {
+          trackedFrame.SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
+        }
+        trackedFrame.SetTimestamp(frameIndex->GetTimestamp(i));
+        if (savedDataBuffer->AddTrackedFrame(&trackedFrame) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Failed to add frame " << i << " of the frame index of " << sequenceFilePath);
+          savedDataBuffer->Clear();
+          return PLUS_FAIL;
+        }
+      }
+    }
+    if (savedDataBuffer->GetNumberOfTrackedFrames() == 0)
+    {
+      LOG_WARNING("Frame index of sequence file " << sequenceFilePath << " is empty, the file is loaded completely.");
+      return PLUS_FAIL;
+    }
+    LOG_DEBUG("Transforms of " << savedDataBuffer->GetNumberOfTrackedFrames() << " frames are read from the frame index of " << sequenceFilePath);
+    return PLUS_SUCCESS;
+  }
+
+  if (this->Prefetcher.SetReadAheadFrames(this->StreamingReadAheadFrames) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (this->Prefetcher.Open(sequenceFilePath) != PLUS_SUCCESS)
+  {
+    LOG_WARNING("Sequence file " << sequenceFilePath << " cannot be streamed, it is loaded completely. "
+                << "Streaming requires uncompressed image data (also in the chunks of a chunked sequence file) and an up-to-date frame index of the sequence file "
+                << "(or of each segment file of a segmented sequence), which can be created by EditSequenceFile --operation=BUILD_FRAME_INDEX.");
+    return PLUS_FAIL;
+  }
+
+  // The first frame initializes the local buffer and the image properties of the output video sources
+  std::shared_ptr<igsioTrackedFrame> firstFrame;
+  if (this->Prefetcher.GetFrame(0, firstFrame) != PLUS_SUCCESS || savedDataBuffer->AddTrackedFrame(firstFrame.get()) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read the first frame of " << sequenceFilePath);
+    this->Prefetcher.Close();
+    savedDataBuffer->Clear();
+    return PLUS_FAIL;
+  }
+  // Frames are read in the orientation they are stored in the file
+  savedDataBuffer->SetCustomString("UltrasoundImageOrientation", "MF");
+  savedDataBuffer->SetCustomString("UltrasoundImageType", igsioVideoFrame::GetStringFromUsImageType(firstFrame->GetImageData()->GetImageType()));
+
+  this->Streaming = true;
+  LOG_INFO("Streaming " << this->Prefetcher.GetNumberOfFrames() << " frames from " << sequenceFilePath);
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::GetReplayTimeRange(double& oldestTimestamp_Local, double& latestTimestamp_Local)
+{
+  if (this->Streaming)
+  {
+    oldestTimestamp_Local = this->Prefetcher.GetTimestamp(0);
+    latestTimestamp_Local = this->Prefetcher.GetTimestamp(this->Prefetcher.GetNumberOfFrames() - 1);
+    return;
+  }
+  GetLocalBuffer()->GetOldestTimeStamp(oldestTimestamp_Local);
+  GetLocalBuffer()->GetLatestTimeStamp(latestTimestamp_Local);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusSavedDataSource::GetReplayItemUidFromTime(double time_Local, BufferItemUidType& uid)
+{
+  if (!this->Streaming)
+  {
+    return GetLocalBuffer()->GetItemUidFromTime(time_Local, uid);
+  }
+  unsigned int frameIndex = 0;
+  if (this->Prefetcher.FindFrameIndex(time_Local, frameIndex) != PLUS_SUCCESS)
+  {
+    return ITEM_UNKNOWN_ERROR;
+  }
+  uid = STREAMING_FIRST_FRAME_UID + frameIndex;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusSavedDataSource::GetReplayTimeStamp(BufferItemUidType uid, double& timestamp_Local)
+{
+  if (!this->Streaming)
+  {
+    return GetLocalBuffer()->GetTimeStamp(uid, timestamp_Local);
+  }
+  if (uid < STREAMING_FIRST_FRAME_UID)
+  {
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  if (uid - STREAMING_FIRST_FRAME_UID >= this->Prefetcher.GetNumberOfFrames())
+  {
+    return ITEM_NOT_AVAILABLE_YET;
+  }
+  timestamp_Local = this->Prefetcher.GetTimestamp(static_cast<unsigned int>(uid - STREAMING_FIRST_FRAME_UID));
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusSavedDataSource::GetReplayFrameRate()
+{
+  if (!this->Streaming)
+  {
+    return GetLocalBuffer()->GetFrameRate();
+  }
+  const unsigned int numberOfFrames = this->Prefetcher.GetNumberOfFrames();
+  if (numberOfFrames < 2)
+  {
+    return 0.0;
+  }
+  const double recordingTimeSec = this->Prefetcher.GetTimestamp(numberOfFrames - 1) - this->Prefetcher.GetTimestamp(0);
+  return recordingTimeSec > 0 ? (numberOfFrames - 1) / recordingTimeSec : 0.0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusSavedDataSource::AddReplayedVideoItem(BufferItemUidType uid, double unfilteredTimestamp, double filteredTimestamp)
+{
+  igsioFieldMapType fieldMap;
+  if (this->Streaming)
+  {
+    std::shared_ptr<igsioTrackedFrame> frame;
+    if (this->Prefetcher.GetFrame(static_cast<unsigned int>(uid - STREAMING_FIRST_FRAME_UID), frame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("vtkPlusSavedDataSource: Failed to read frame from the sequence file, UID=" << uid);
+      return PLUS_FAIL;
+    }
+    if (this->UseAllFrameFields)
+    {
+      fieldMap = GetReplayedFrameFields(frame->GetFrameFields());
+    }
+    return this->AddVideoItemToVideoSources(this->GetVideoSources(), *frame->GetImageData(), this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap);
+  }
+
+  StreamBufferItem dataBufferItemToBeAdded;
+  if (GetLocalBuffer()->GetStreamBufferItem(uid, &dataBufferItemToBeAdded) != ITEM_OK)
+  {
+    LOG_ERROR("vtkPlusSavedDataSource: Failed to retrieve item from the buffer, UID=" << uid);
+    return PLUS_FAIL;
+  }
+  if (this->UseAllFrameFields)
+  {
+    fieldMap = dataBufferItemToBeAdded.GetFrameFieldMap();
+  }
+  return this->AddVideoItemToVideoSources(this->GetVideoSources(), dataBufferItemToBeAdded.GetFrame(), this->FrameNumber, unfilteredTimestamp, filteredTimestamp, &fieldMap);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusSavedDataSource::UpdateStreamingReplayRange()
+{
+  if (!this->Streaming)
+  {
+    return;
+  }
+  this->Prefetcher.SetReplayRange(static_cast<unsigned int>(this->LoopFirstFrameUid - STREAMING_FIRST_FRAME_UID),
+                                  static_cast<unsigned int>(this->LoopLastFrameUid - STREAMING_FIRST_FRAME_UID), this->RepeatEnabled);
+}
+
 //----------------------------------------------------------------------------
 vtkPlusBuffer* vtkPlusSavedDataSource::GetLocalTrackerBuffer()
 {
@@ -10,6 +10,7 @@ See License.txt for details.
 #include "vtkPlusDataCollectionExport.h"
 
 #include "vtkPlusDevice.h"
+#include "PlusSequenceFramePrefetcher.h"
 
 class vtkPlusBuffer;
 
@@ -27,6 +28,11 @@ Attributes:
 \li UseOriginalTimestamps: if true then the original timestamps (recorded originally in the source file)
   will be replayed exactly, otherwise only the timestamp difference will be replayed exactly,
   starting from the current time (TRUE|FALSE)
+\li StreamingEnabled: if true then image frames are read from the file during replay instead of loading
+  the whole file on connect (TRUE|FALSE). Requires an up-to-date frame index of an uncompressed sequence file
+  (see SequenceFrameIndex), otherwise the whole file is loaded. A segmented sequence (.seqindex) is streamed through
+  the frame indexes of its segment files, a chunked sequence (.seqchunks) is streamed if its chunks are uncompressed.
+\li StreamingReadAheadFrames: number of frames that are read ahead of the replayed frame and kept in memory in streaming mode
 
 */
 class vtkPlusDataCollectionExport vtkPlusSavedDataSource : public vtkPlusDevice
@@ -73,7 +79,22 @@ public:
   /*! Read the timestamps from the file and use provide them in the output (instead of the current time) */
   vtkBooleanMacro( UseOriginalTimestamps, bool );
 
-  /*! Get local video buffer */
+  /*! Read image frames from the file during replay, instead of loading the whole file on connect */
+  vtkGetMacro( StreamingEnabled, bool );
+  /*! Read image frames from the file during replay, instead of loading the whole file on connect */
+  vtkSetMacro( StreamingEnabled, bool );
+  /*! Read image frames from the file during replay, instead of loading the whole file on connect */
+  vtkBooleanMacro( StreamingEnabled, bool );
+
+  /*! Number of frames that are read ahead of the replayed frame in streaming mode */
+  vtkGetMacro( StreamingReadAheadFrames, int );
+  /*! Number of frames that are read ahead of the replayed frame in streaming mode */
+  vtkSetMacro( StreamingReadAheadFrames, int );
+
+  /*! Returns true if frames are currently read from the file during replay */
+  bool IsStreaming() const { return this->Streaming; }
+
+  /*! Get local video buffer. In streaming mode it contains only the first frame. */
   vtkGetObjectMacro( LocalVideoBuffer, vtkPlusBuffer );
 
   virtual bool IsTracker() const;
@@ -115,6 +136,30 @@ protected:
 
   BufferItemUidType GetClosestFrameUidWithinTimeRange( double time_Local, double startTime_Local, double stopTime_Local );
 
+  /*!
+    Open the sequence file for streaming. For a video stream only the first frame is read into savedDataBuffer,
+    for a tracker stream the frames are read without image data. Returns PLUS_FAIL if the file has no usable frame index.
+  */
+  PlusStatus OpenStreaming( const std::string& sequenceFilePath, vtkIGSIOTrackedFrameList* savedDataBuffer );
+
+  /*! Time range of the replayed frames, in local buffer time */
+  void GetReplayTimeRange( double& oldestTimestamp_Local, double& latestTimestamp_Local );
+
+  /*! Get the UID of the replayed frame that is the closest to the specified time */
+  ItemStatus GetReplayItemUidFromTime( double time_Local, BufferItemUidType& uid );
+
+  /*! Get the timestamp of a replayed frame */
+  ItemStatus GetReplayTimeStamp( BufferItemUidType uid, double& timestamp_Local );
+
+  /*! Get the frame rate of the replayed frames */
+  double GetReplayFrameRate();
+
+  /*! Add a replayed frame to the video sources */
+  PlusStatus AddReplayedVideoItem( BufferItemUidType uid, double unfilteredTimestamp, double filteredTimestamp );
+
+  /*! Tell the prefetcher which frames are replayed next */
+  void UpdateStreamingReplayRange();
+
   /*! Get local tracker buffer */
   vtkPlusBuffer* GetLocalTrackerBuffer();
 
@@ -161,6 +206,21 @@ protected:
   /*! Read the timestamps from the file and use provide them in the output (instead of the current time) */
   bool UseOriginalTimestamps;
 
+  /*! Read image frames from the file during replay, instead of loading the whole file on connect */
+  bool StreamingEnabled;
+
+  /*! Number of frames that are read ahead of the replayed frame in streaming mode */
+  int StreamingReadAheadFrames;
+
+  /*!
+    True if the frames of a video stream are read from the file during replay. Buffer item UIDs of replayed
+    frames are then frame indices in the file, offset by STREAMING_FIRST_FRAME_UID.
+  */
+  bool Streaming;
+
+  /*! Reads the replayed frames ahead of the replay cursor in streaming mode */
+  SequenceFramePrefetcher Prefetcher;
+
   /*! Buffer item UID of the last added frame in the local buffer */
   BufferItemUidType LastAddedFrameUid;
 
@@ -0,0 +1,172 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PixelCodecBenchmark.cxx
+  \brief Measure the throughput of the pixel conversions with each instruction set that the processor supports
+
+  Random frames of 640x480 to 3840x2160 pixels are converted with the scalar and the vectorized implementations,
+  which must produce the same output. Use --number-of-threads for measuring the multithreaded conversion of the
+  frames in row bands.
+*/
+
+#include "PlusConfigure.h"
+#include "PixelCodec.h"
+#include "PixelCodecKernels.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  enum Conversion
+  {
+    Conversion_Rgb24ToGray,
+    Conversion_Rgba32ToGray,
+    Conversion_Yuv422pToGray,
+    Conversion_Yuv422pToRgb24,
+    Conversion_Count
+  };
+
+  const char* CONVERSION_NAMES[Conversion_Count] = { "Rgb24ToGray", "Rgba32ToGray", "Yuv422pToGray", "Yuv422pToRgb24" };
+
+  //----------------------------------------------------------------------------
+  void Convert(Conversion conversion, int width, int height, unsigned char* input, unsigned char* output)
+  {
+    switch (conversion)
+    {
+      case Conversion_Rgb24ToGray:
+        PixelCodec::Rgb24ToGray(width, height, input, output);
+        break;
+      case Conversion_Rgba32ToGray:
+        PixelCodec::Rgba32ToGray(width, height, input, output);
+        break;
+      case Conversion_Yuv422pToGray:
+        PixelCodec::Yuv422pToGray(width, height, input, output);
+        break;
+      case Conversion_Yuv422pToRgb24:
+        PixelCodec::Yuv422pToBmp24(PixelCodec::ComponentOrder_RGB, width, height, input, output);
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfIterations(100);
+  int numberOfThreads(1);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-iterations", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfIterations, "Number of conversions for each frame size, conversion and instruction set (Default: 100).");
+  args.AddArgument("--number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads that convert a frame (Default: 1).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (numberOfIterations < 1)
+  {
+    LOG_ERROR("Number of iterations must be positive");
+    return EXIT_FAILURE;
+  }
+
+  if (PixelCodecKernels::SetNumberOfThreads(numberOfThreads) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  srand(0);
+  const PixelCodecKernels::InstructionSet defaultInstructionSet = PixelCodecKernels::GetInstructionSet();
+  const PixelCodecKernels::InstructionSet instructionSets[] =
+  {
+    PixelCodecKernels::InstructionSet_Scalar,
+    PixelCodecKernels::InstructionSet_SSE2,
+    PixelCodecKernels::InstructionSet_AVX2,
+    PixelCodecKernels::InstructionSet_NEON
+  };
+  const int frameSizes[][2] = { { 640, 480 }, { 1280, 720 }, { 1920, 1080 }, { 3840, 2160 } };
+
+  int numberOfErrors(0);
+  for (size_t sizeIndex = 0; sizeIndex < sizeof(frameSizes) / sizeof(frameSizes[0]); ++sizeIndex)
+  {
+    const int width = frameSizes[sizeIndex][0];
+    const int height = frameSizes[sizeIndex][1];
+    const double numberOfMegapixels = width * height * 1e-6;
+    // Large enough for all input and output encodings
+    std::vector<unsigned char> input(width * height * 4);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+      input[i] = static_cast<unsigned char>(rand() % 256);
+    }
+    std::vector<unsigned char> scalarOutput(width * height * 3);
+    std::vector<unsigned char> output(width * height * 3);
+
+    for (int conversion = 0; conversion < Conversion_Count; ++conversion)
+    {
+      std::ostringstream results;
+      for (size_t i = 0; i < sizeof(instructionSets) / sizeof(instructionSets[0]); ++i)
+      {
+        const PixelCodecKernels::InstructionSet instructionSet = instructionSets[i];
+        if (!PixelCodecKernels::IsInstructionSetSupported(instructionSet))
+        {
+          continue;
+        }
+        PixelCodecKernels::SetInstructionSet(instructionSet);
+        std::vector<unsigned char>& currentOutput = (instructionSet == PixelCodecKernels::InstructionSet_Scalar ? scalarOutput : output);
+        const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+        for (int iteration = 0; iteration < numberOfIterations; ++iteration)
+        {
+          Convert(static_cast<Conversion>(conversion), width, height, &input[0], &currentOutput[0]);
+        }
+        const double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+        results << " " << PixelCodecKernels::GetInstructionSetAsString(instructionSet) << ": " << std::fixed << std::setprecision(1)
+                << (elapsedTimeSec > 0 ? numberOfMegapixels * numberOfIterations / elapsedTimeSec : 0.0) << " MPixel/s";
+
+        if (instructionSet != PixelCodecKernels::InstructionSet_Scalar && output != scalarOutput)
+        {
+          LOG_ERROR(CONVERSION_NAMES[conversion] << " of " << width << "x" << height << " frames: "
+                    << PixelCodecKernels::GetInstructionSetAsString(instructionSet) << " output is different from the scalar output");
+          numberOfErrors++;
+        }
+      }
+      LOG_INFO(CONVERSION_NAMES[conversion] << " " << width << "x" << height << " on " << numberOfThreads << " threads:" << results.str());
+    }
+  }
+  PixelCodecKernels::SetInstructionSet(defaultInstructionSet);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,276 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PixelCodecKernelsTest.cxx
+  \brief Test that the vectorized and multithreaded pixel conversions produce exactly the same output as the scalar reference implementations
+
+  All instruction sets that the processor supports are tested with random frames of various sizes (including sizes
+  that are not multiples of the vector length) and with all possible YUY2 luma and chroma values. Large frames are
+  also converted in row bands on multiple threads.
+*/
+
+#include "PlusConfigure.h"
+#include "PixelCodec.h"
+#include "PixelCodecKernels.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+  enum Conversion
+  {
+    Conversion_Rgb24ToGray,
+    Conversion_Rgba32ToGray,
+    Conversion_Yuv422pToGray,
+    Conversion_Yuv422pToRgb24,
+    Conversion_Yuv422pToBgr24,
+    Conversion_Count
+  };
+
+  const char* CONVERSION_NAMES[Conversion_Count] = { "Rgb24ToGray", "Rgba32ToGray", "Yuv422pToGray", "Yuv422pToRgb24", "Yuv422pToBgr24" };
+
+  // Guard bytes after the output, for detecting writes beyond the end of the frame
+  const int NUMBER_OF_GUARD_BYTES = 64;
+  const unsigned char GUARD_VALUE = 0xA5;
+
+  //----------------------------------------------------------------------------
+  int GetNumberOfOutputBytes(Conversion conversion, int width, int height)
+  {
+    const int numberOfComponents = (conversion == Conversion_Yuv422pToRgb24 || conversion == Conversion_Yuv422pToBgr24) ? 3 : 1;
+    return width * height * numberOfComponents;
+  }
+
+  //----------------------------------------------------------------------------
+  void Convert(Conversion conversion, int width, int height, std::vector<unsigned char>& input, std::vector<unsigned char>& output)
+  {
+    output.assign(GetNumberOfOutputBytes(conversion, width, height) + NUMBER_OF_GUARD_BYTES, GUARD_VALUE);
+    switch (conversion)
+    {
+      case Conversion_Rgb24ToGray:
+        PixelCodec::Rgb24ToGray(width, height, &input[0], &output[0]);
+        break;
+      case Conversion_Rgba32ToGray:
+        PixelCodec::Rgba32ToGray(width, height, &input[0], &output[0]);
+        break;
+      case Conversion_Yuv422pToGray:
+        PixelCodec::Yuv422pToGray(width, height, &input[0], &output[0]);
+        break;
+      case Conversion_Yuv422pToRgb24:
+        PixelCodec::Yuv422pToBmp24(PixelCodec::ComponentOrder_RGB, width, height, &input[0], &output[0]);
+        break;
+      case Conversion_Yuv422pToBgr24:
+        PixelCodec::Yuv422pToBmp24(PixelCodec::ComponentOrder_BGR, width, height, &input[0], &output[0]);
+        break;
+      default:
+        break;
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Compare the output of the instruction set with the output of the single-threaded scalar implementation */
+  PlusStatus CompareWithScalar(PixelCodecKernels::InstructionSet instructionSet, int numberOfThreads, Conversion conversion, int width, int height, std::vector<unsigned char>& input)
+  {
+    std::vector<unsigned char> expectedOutput;
+    PixelCodecKernels::SetInstructionSet(PixelCodecKernels::InstructionSet_Scalar);
+    PixelCodecKernels::SetNumberOfThreads(1);
+    Convert(conversion, width, height, input, expectedOutput);
+
+    std::vector<unsigned char> output;
+    PixelCodecKernels::SetInstructionSet(instructionSet);
+    PixelCodecKernels::SetNumberOfThreads(numberOfThreads);
+    Convert(conversion, width, height, input, output);
+    PixelCodecKernels::SetNumberOfThreads(1);
+
+    for (size_t i = 0; i < output.size(); ++i)
+    {
+      if (output[i] != expectedOutput[i])
+      {
+        LOG_ERROR(PixelCodecKernels::GetInstructionSetAsString(instructionSet) << " " << CONVERSION_NAMES[conversion] << " of a " << width << "x" << height
+                  << " frame on " << numberOfThreads << " threads: byte " << i << " is " << static_cast<int>(output[i]) << ", expected " << static_cast<int>(expectedOutput[i]));
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  void CreateRandomFrame(int width, int height, std::vector<unsigned char>& input)
+  {
+    // Large enough for all input encodings
+    input.resize(width * height * 4);
+    for (size_t i = 0; i < input.size(); ++i)
+    {
+      input[i] = static_cast<unsigned char>(rand() % 256);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestRandomFrames(PixelCodecKernels::InstructionSet instructionSet)
+  {
+    const int frameSizes[][2] = { { 1, 1 }, { 2, 1 }, { 3, 5 }, { 17, 3 }, { 31, 7 }, { 64, 2 }, { 65, 33 }, { 640, 480 }, { 1919, 3 } };
+    PlusStatus status = PLUS_SUCCESS;
+    for (size_t sizeIndex = 0; sizeIndex < sizeof(frameSizes) / sizeof(frameSizes[0]); ++sizeIndex)
+    {
+      const int width = frameSizes[sizeIndex][0];
+      const int height = frameSizes[sizeIndex][1];
+      std::vector<unsigned char> input;
+      CreateRandomFrame(width, height, input);
+      for (int conversion = 0; conversion < Conversion_Count; ++conversion)
+      {
+        if (CompareWithScalar(instructionSet, 1, static_cast<Conversion>(conversion), width, height, input) != PLUS_SUCCESS)
+        {
+          status = PLUS_FAIL;
+        }
+      }
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestAllYuy2Values(PixelCodecKernels::InstructionSet instructionSet)
+  {
+    // Each (U, V) pair is combined with all luma values
+    std::vector<unsigned char> input;
+    input.reserve(256 * 256 * 128 * 4);
+    for (int u = 0; u < 256; ++u)
+    {
+      for (int v = 0; v < 256; ++v)
+      {
+        for (int y = 0; y < 256; y += 2)
+        {
+          input.push_back(static_cast<unsigned char>(y));
+          input.push_back(static_cast<unsigned char>(u));
+          input.push_back(static_cast<unsigned char>(255 - y));
+          input.push_back(static_cast<unsigned char>(v));
+        }
+      }
+    }
+    const int width = 256;
+    const int height = static_cast<int>(input.size() / 4 / (width / 2));
+
+    PlusStatus status = PLUS_SUCCESS;
+    const Conversion conversions[] = { Conversion_Yuv422pToGray, Conversion_Yuv422pToRgb24, Conversion_Yuv422pToBgr24 };
+    for (size_t i = 0; i < sizeof(conversions) / sizeof(conversions[0]); ++i)
+    {
+      if (CompareWithScalar(instructionSet, 1, conversions[i], width, height, input) != PLUS_SUCCESS)
+      {
+        status = PLUS_FAIL;
+      }
+    }
+    return status;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Frames are split into row bands only if they are large enough, odd sizes check the band boundaries */
+  PlusStatus TestMultithreadedConversion(PixelCodecKernels::InstructionSet instructionSet)
+  {
+    const int frameSizes[][2] = { { 1920, 1080 }, { 1023, 777 } };
+    const int numberOfThreads[] = { 2, 3, 8 };
+    PlusStatus status = PLUS_SUCCESS;
+    for (size_t sizeIndex = 0; sizeIndex < sizeof(frameSizes) / sizeof(frameSizes[0]); ++sizeIndex)
+    {
+      const int width = frameSizes[sizeIndex][0];
+      const int height = frameSizes[sizeIndex][1];
+      std::vector<unsigned char> input;
+      CreateRandomFrame(width, height, input);
+      for (size_t threadsIndex = 0; threadsIndex < sizeof(numberOfThreads) / sizeof(numberOfThreads[0]); ++threadsIndex)
+      {
+        for (int conversion = 0; conversion < Conversion_Count; ++conversion)
+        {
+          if (CompareWithScalar(instructionSet, numberOfThreads[threadsIndex], static_cast<Conversion>(conversion), width, height, input) != PLUS_SUCCESS)
+          {
+            status = PLUS_FAIL;
+          }
+        }
+      }
+    }
+    return status;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  srand(0);
+  const PixelCodecKernels::InstructionSet defaultInstructionSet = PixelCodecKernels::GetInstructionSet();
+  LOG_INFO("Default instruction set: " << PixelCodecKernels::GetInstructionSetAsString(defaultInstructionSet));
+
+  int numberOfErrors(0);
+  const PixelCodecKernels::InstructionSet instructionSets[] =
+  {
+    PixelCodecKernels::InstructionSet_Scalar,
+    PixelCodecKernels::InstructionSet_SSE2,
+    PixelCodecKernels::InstructionSet_AVX2,
+    PixelCodecKernels::InstructionSet_NEON
+  };
+  for (size_t i = 0; i < sizeof(instructionSets) / sizeof(instructionSets[0]); ++i)
+  {
+    const PixelCodecKernels::InstructionSet instructionSet = instructionSets[i];
+    if (!PixelCodecKernels::IsInstructionSetSupported(instructionSet))
+    {
+      LOG_INFO(PixelCodecKernels::GetInstructionSetAsString(instructionSet) << " is not supported on this processor, skipped");
+      continue;
+    }
+    if (TestMultithreadedConversion(instructionSet) != PLUS_SUCCESS)
+    {
+      LOG_ERROR(PixelCodecKernels::GetInstructionSetAsString(instructionSet) << " multithreaded conversion test failed");
+      numberOfErrors++;
+    }
+    if (instructionSet == PixelCodecKernels::InstructionSet_Scalar)
+    {
+      // The single-threaded scalar implementation is the reference
+      continue;
+    }
+    if (TestRandomFrames(instructionSet) != PLUS_SUCCESS)
+    {
+      LOG_ERROR(PixelCodecKernels::GetInstructionSetAsString(instructionSet) << " conversion of random frames test failed");
+      numberOfErrors++;
+    }
+    if (TestAllYuy2Values(instructionSet) != PLUS_SUCCESS)
+    {
+      LOG_ERROR(PixelCodecKernels::GetInstructionSetAsString(instructionSet) << " conversion of all YUY2 values test failed");
+      numberOfErrors++;
+    }
+  }
+  PixelCodecKernels::SetInstructionSet(defaultInstructionSet);
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
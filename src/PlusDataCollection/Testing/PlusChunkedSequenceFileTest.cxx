@@ -0,0 +1,198 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusChunkedSequenceFileTest.cxx
+  \brief Test that frames written to a chunked sequence file are read back completely and in order
+
+  Frame lists are collected into chunks of a minimum number of frames, the chunks are compressed in parallel
+  and appended to the file. Reading the file through
+  vtkPlusSequenceIO must return all frames with their original timestamps and pixel data, in the order
+  the chunks were written. If the file is truncated then the frames of the complete chunks must be read.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusChunkedSequenceFile.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// STL includes
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 64, 48, 1 };
+  const unsigned int NUMBER_OF_FRAMES_PER_LIST = 3;
+  const unsigned int MINIMUM_NUMBER_OF_FRAMES_PER_CHUNK = 2 * NUMBER_OF_FRAMES_PER_LIST;
+  const double FRAME_PERIOD_SEC = 0.05;
+
+  //----------------------------------------------------------------------------
+  /*! Write the first numberOfBytes bytes of the file, followed by the appended text, to a new file and read it */
+  PlusStatus ReadTruncatedFile(const std::string& filename, size_t numberOfBytes, const std::string& appendedText, unsigned int expectedNumberOfFrames)
+  {
+    std::string contents;
+    {
+      std::ifstream file(filename.c_str(), std::ios::binary);
+      contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    const std::string truncatedFilename = vtkPlusConfig::GetInstance()->GetOutputPath("PlusChunkedSequenceFileTest_Truncated" + ChunkedSequenceFile::GetFileExtension());
+    {
+      std::ofstream truncatedFile(truncatedFilename.c_str(), std::ios::binary | std::ios::trunc);
+      truncatedFile.write(contents.data(), std::min(numberOfBytes, contents.size()));
+      truncatedFile << appendedText;
+    }
+
+    // Truncation is reported as a warning, which is expected here
+    const int logLevel = vtkPlusLogger::Instance()->GetLogLevel();
+    vtkPlusLogger::Instance()->SetLogLevel(vtkPlusLogger::LOG_LEVEL_ERROR);
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    PlusStatus status = vtkPlusSequenceIO::Read(truncatedFilename, frameList);
+    vtkPlusLogger::Instance()->SetLogLevel(logLevel);
+    vtksys::SystemTools::RemoveFile(truncatedFilename);
+
+    if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read truncated chunked sequence file: " << truncatedFilename);
+      return PLUS_FAIL;
+    }
+    return PlusTestFrames::CheckFrames(frameList, 0, expectedNumberOfFrames, FRAME_SIZE, FRAME_PERIOD_SEC);
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+  int numberOfThreads = 3;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+  args.AddArgument("--number-of-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfThreads, "Number of threads that compress the chunks (default: 3)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  // The first write fills two chunks that are compressed in parallel, the frames of the second write are
+  // written as the last chunk when the file is closed
+  const unsigned int numberOfListsPerWrite[] = { 4, 1 };
+  const unsigned long expectedNumberOfChunksAfterWrite[] = { 2, 2 };
+  const unsigned long expectedNumberOfChunks = 3;
+  const unsigned int numberOfFramesInLastChunk = NUMBER_OF_FRAMES_PER_LIST;
+
+  const std::string filename = vtkPlusConfig::GetInstance()->GetOutputPath("PlusChunkedSequenceFileTest" + ChunkedSequenceFile::GetFileExtension());
+  ChunkedSequenceFile chunkedFile;
+  if (chunkedFile.SetNumberOfThreads(numberOfThreads) != PLUS_SUCCESS
+      || chunkedFile.SetMinimumNumberOfFramesPerChunk(MINIMUM_NUMBER_OF_FRAMES_PER_CHUNK) != PLUS_SUCCESS
+      || chunkedFile.Open(filename, true) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to create chunked sequence file: " << filename);
+    return EXIT_FAILURE;
+  }
+
+  unsigned int numberOfFrames = 0;
+  for (unsigned int writeIndex = 0; writeIndex < sizeof(numberOfListsPerWrite) / sizeof(numberOfListsPerWrite[0]); ++writeIndex)
+  {
+    std::vector<vtkSmartPointer<vtkIGSIOTrackedFrameList> > frameLists;
+    std::vector<vtkIGSIOTrackedFrameList*> writtenFrameLists;
+    for (unsigned int listIndex = 0; listIndex < numberOfListsPerWrite[writeIndex]; ++listIndex)
+    {
+      vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+      if (PlusTestFrames::AddFrames(frameList, numberOfFrames, NUMBER_OF_FRAMES_PER_LIST, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+      {
+        return EXIT_FAILURE;
+      }
+      numberOfFrames += NUMBER_OF_FRAMES_PER_LIST;
+      frameLists.push_back(frameList);
+      writtenFrameLists.push_back(frameList);
+    }
+    if (chunkedFile.WriteFrames(writtenFrameLists) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write frames");
+      return EXIT_FAILURE;
+    }
+    // Frames that are not written yet are copied, so the frame lists can be reused
+    for (std::vector<vtkIGSIOTrackedFrameList*>::iterator it = writtenFrameLists.begin(); it != writtenFrameLists.end(); ++it)
+    {
+      (*it)->Clear();
+    }
+    if (chunkedFile.GetNumberOfChunks() != expectedNumberOfChunksAfterWrite[writeIndex])
+    {
+      LOG_ERROR("Number of chunks after write " << writeIndex << " is " << chunkedFile.GetNumberOfChunks() << " instead of " << expectedNumberOfChunksAfterWrite[writeIndex]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (chunkedFile.Close() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to close chunked sequence file: " << filename);
+    return EXIT_FAILURE;
+  }
+  if (chunkedFile.GetNumberOfChunks() != expectedNumberOfChunks)
+  {
+    LOG_ERROR("Number of chunks is " << chunkedFile.GetNumberOfChunks() << " instead of " << expectedNumberOfChunks);
+    return EXIT_FAILURE;
+  }
+
+  if (!ChunkedSequenceFile::IsChunkedSequenceFile(filename))
+  {
+    LOG_ERROR(filename << " is not recognized as a chunked sequence file");
+    return EXIT_FAILURE;
+  }
+
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> readFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (vtkPlusSequenceIO::Read(filename, readFrameList) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to read chunked sequence file: " << filename);
+    return EXIT_FAILURE;
+  }
+  if (PlusTestFrames::CheckFrames(readFrameList, 0, numberOfFrames, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Frames read from the chunked sequence file do not match the written frames");
+    return EXIT_FAILURE;
+  }
+
+  // An interrupted recording ends in the middle of the last chunk or of a chunk description line
+  const size_t fileSize = static_cast<size_t>(vtksys::SystemTools::FileLength(filename));
+  if (ReadTruncatedFile(filename, fileSize - 10, "", numberOfFrames - numberOfFramesInLastChunk) != PLUS_SUCCESS
+      || ReadTruncatedFile(filename, fileSize, "Chunk = 3", numberOfFrames) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Frames read from the truncated chunked sequence file do not match the complete chunks");
+    return EXIT_FAILURE;
+  }
+
+  // Chunks are extracted to files named from the extension, so only single-file sequence formats are accepted
+  if (!ChunkedSequenceFile::IsValidChunkFileExtension(".nrrd") || !ChunkedSequenceFile::IsValidChunkFileExtension(".mha")
+      || ChunkedSequenceFile::IsValidChunkFileExtension(".mhd") || ChunkedSequenceFile::IsValidChunkFileExtension("/../x.nrrd"))
+  {
+    LOG_ERROR("Chunk file extensions are not validated");
+    return EXIT_FAILURE;
+  }
+
+  vtksys::SystemTools::RemoveFile(filename);
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,193 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusFrameFieldSchemaTest.cxx
+  \brief Test interning of frame field names and the frame field storage of stream buffer items
+*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameFieldSchema.h"
+#include "PlusStreamBufferItem.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  PlusStatus TestInterning()
+  {
+    FrameFieldId probeStatusId = FrameFieldSchema::GetFieldId("ProbeToTrackerTransformStatus");
+    FrameFieldId stylusStatusId = FrameFieldSchema::GetFieldId("StylusToTrackerTransformStatus");
+    if (probeStatusId == stylusStatusId || FrameFieldSchema::GetFieldId("ProbeToTrackerTransformStatus") != probeStatusId)
+    {
+      LOG_ERROR("Field names are not interned to unique IDs");
+      return PLUS_FAIL;
+    }
+    if (FrameFieldSchema::GetFieldName(probeStatusId) != "ProbeToTrackerTransformStatus")
+    {
+      LOG_ERROR("Wrong name for field ID " << probeStatusId << ": " << FrameFieldSchema::GetFieldName(probeStatusId));
+      return PLUS_FAIL;
+    }
+    if (FrameFieldSchema::FindFieldId("NotInternedFieldName") != FrameFieldSchema::INVALID_FIELD_ID)
+    {
+      LOG_ERROR("FindFieldId interned a new field name");
+      return PLUS_FAIL;
+    }
+
+    // A name that was not found must be found after another thread interned it
+    FrameFieldId laterInternedId = FrameFieldSchema::INVALID_FIELD_ID;
+    if (FrameFieldSchema::FindFieldId("LaterInternedFieldName") != FrameFieldSchema::INVALID_FIELD_ID)
+    {
+      LOG_ERROR("FindFieldId found a field name that is not interned yet");
+      return PLUS_FAIL;
+    }
+    std::thread internThread([&laterInternedId]()
+    {
+      laterInternedId = FrameFieldSchema::GetFieldId("LaterInternedFieldName");
+    });
+    internThread.join();
+    if (laterInternedId == FrameFieldSchema::INVALID_FIELD_ID || FrameFieldSchema::FindFieldId("LaterInternedFieldName") != laterInternedId)
+    {
+      LOG_ERROR("Field name interned by another thread is not found");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Names are looked up by ID while another thread interns many new names
+  PlusStatus TestConcurrentLookup()
+  {
+    const int numberOfNewNames = 2000;
+    const FrameFieldId probeStatusId = FrameFieldSchema::GetFieldId("ProbeToTrackerTransformStatus");
+    std::atomic<bool> internDone(false);
+    std::thread internThread([&internDone, numberOfNewNames]()
+    {
+      for (int i = 0; i < numberOfNewNames; ++i)
+      {
+        std::ostringstream fieldName;
+        fieldName << "ConcurrentLookupTestField" << i;
+        FrameFieldSchema::GetFieldId(fieldName.str());
+      }
+      internDone = true;
+    });
+
+    PlusStatus status = PLUS_SUCCESS;
+    while (!internDone && status == PLUS_SUCCESS)
+    {
+      const unsigned int numberOfFields = FrameFieldSchema::GetNumberOfFields();
+      if (FrameFieldSchema::GetFieldName(probeStatusId) != "ProbeToTrackerTransformStatus"
+          || FrameFieldSchema::GetFieldName(numberOfFields - 1).empty())
+      {
+        status = PLUS_FAIL;
+      }
+    }
+    internThread.join();
+    if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Field name lookup failed while new names were interned");
+      return PLUS_FAIL;
+    }
+
+    for (int i = 0; i < numberOfNewNames; ++i)
+    {
+      std::ostringstream fieldName;
+      fieldName << "ConcurrentLookupTestField" << i;
+      FrameFieldId fieldId = FrameFieldSchema::FindFieldId(fieldName.str());
+      if (fieldId == FrameFieldSchema::INVALID_FIELD_ID || FrameFieldSchema::GetFieldName(fieldId) != fieldName.str())
+      {
+        LOG_ERROR("Field name " << fieldName.str() << " is not interned correctly");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestItemFrameFields()
+  {
+    StreamBufferItem item;
+    item.SetFrameField("ProbeToTrackerTransformStatus", "INVALID");
+    item.SetFrameField("ProbeToTrackerTransformStatus", "OK", FRAMEFIELD_FORCE_SERVER_SEND);
+    item.SetFrameField(FrameFieldSchema::GetFieldId("FrameSizeInBytes"), "1024");
+    if (item.GetFrameFields().size() != 2 || item.GetFrameField("ProbeToTrackerTransformStatus") != "OK"
+        || item.GetFrameField("FrameSizeInBytes") != "1024" || !item.GetFrameField("NotInternedFieldName").empty())
+    {
+      LOG_ERROR("Frame fields are not stored correctly");
+      return PLUS_FAIL;
+    }
+
+    igsioFieldMapType fieldMap = item.GetFrameFieldMap();
+    if (fieldMap.size() != 2 || fieldMap["ProbeToTrackerTransformStatus"].second != "OK"
+        || fieldMap["ProbeToTrackerTransformStatus"].first != FRAMEFIELD_FORCE_SERVER_SEND)
+    {
+      LOG_ERROR("Frame field map does not match the stored frame fields");
+      return PLUS_FAIL;
+    }
+
+    // Copies must not share the field values
+    StreamBufferItem copiedItem;
+    copiedItem.SetFrameField("StylusToTrackerTransformStatus", "OK");
+    copiedItem.DeepCopy(&item);
+    item.SetFrameField("FrameSizeInBytes", "2048");
+    if (copiedItem.GetFrameFields().size() != 2 || copiedItem.GetFrameField("FrameSizeInBytes") != "1024"
+        || !copiedItem.GetFrameField("StylusToTrackerTransformStatus").empty())
+    {
+      LOG_ERROR("Frame fields are not copied correctly");
+      return PLUS_FAIL;
+    }
+
+    if (item.DeleteFrameField("ProbeToTrackerTransformStatus") != PLUS_SUCCESS || item.GetFrameFields().size() != 1
+        || item.DeleteFrameField("ProbeToTrackerTransformStatus") != PLUS_FAIL)
+    {
+      LOG_ERROR("Frame field is not deleted correctly");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestInterning() != PLUS_SUCCESS || TestConcurrentLookup() != PLUS_SUCCESS || TestItemFrameFields() != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusPeriodicSchedulerTest.cxx
+  \brief Test that the periodic scheduler keeps the rate without drift and accounts for overruns
+
+  Updates with a non-negligible execution time must not make the schedule drift, and long updates
+  must be counted as missed deadlines and handled according to the catch-up policy.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusPeriodicScheduler.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <chrono>
+#include <thread>
+
+namespace
+{
+  const double PERIOD_SEC = 0.01;
+  const int NUMBER_OF_TICKS = 50;
+  // Longer period for the overrun test, so that the number of missed deadlines does not depend on sleep inaccuracy
+  const double OVERRUN_PERIOD_SEC = 0.05;
+  // The overrunning update takes this many periods, the deadlines at 1, 2 and 3 periods are missed
+  const double OVERRUN_PERIODS = 3.5;
+  const unsigned long long EXPECTED_MISSED_DEADLINES = 3;
+
+  //----------------------------------------------------------------------------
+  void RunUpdate(PeriodicScheduler& scheduler, double executionTimeSec)
+  {
+    scheduler.BeginUpdate();
+    std::this_thread::sleep_for(std::chrono::duration<double>(executionTimeSec));
+    scheduler.EndUpdate();
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestNoDrift()
+  {
+    PeriodicScheduler scheduler;
+    scheduler.SetPeriodSec(PERIOD_SEC);
+    const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    scheduler.Start();
+    for (int i = 0; i < NUMBER_OF_TICKS; ++i)
+    {
+      RunUpdate(scheduler, PERIOD_SEC * 0.3);
+      scheduler.WaitForNextDeadline();
+    }
+    const double elapsedSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+    // With relative delays the execution time would be added to each period
+    const double expectedSec = (NUMBER_OF_TICKS + 1) * PERIOD_SEC;
+    if (elapsedSec < expectedSec - PERIOD_SEC || elapsedSec > expectedSec + 2 * PERIOD_SEC)
+    {
+      LOG_ERROR("Schedule drifted: " << NUMBER_OF_TICKS << " ticks took " << elapsedSec << " sec, expected " << expectedSec << " sec");
+      return PLUS_FAIL;
+    }
+    if (scheduler.GetNumberOfUpdates() != NUMBER_OF_TICKS)
+    {
+      LOG_ERROR("Number of updates is " << scheduler.GetNumberOfUpdates() << ", expected " << NUMBER_OF_TICKS);
+      return PLUS_FAIL;
+    }
+
+    std::vector<unsigned long long> histogram;
+    scheduler.GetExecutionTimeHistogram(histogram);
+    unsigned long long numberOfHistogramUpdates(0);
+    for (size_t i = 0; i < histogram.size(); ++i)
+    {
+      numberOfHistogramUpdates += histogram[i];
+      if (histogram[i] > 0 && PeriodicScheduler::GetHistogramBinUpperLimitSec(static_cast<int>(i)) >= 0
+          && PeriodicScheduler::GetHistogramBinUpperLimitSec(static_cast<int>(i)) < PERIOD_SEC * 0.3)
+      {
+        LOG_ERROR("Execution time histogram contains updates shorter than the actual execution time");
+        return PLUS_FAIL;
+      }
+    }
+    if (numberOfHistogramUpdates != NUMBER_OF_TICKS)
+    {
+      LOG_ERROR("Execution time histogram contains " << numberOfHistogramUpdates << " updates, expected " << NUMBER_OF_TICKS);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestOverrun(PeriodicScheduler::CatchUpPolicy policy)
+  {
+    PeriodicScheduler scheduler;
+    scheduler.SetPeriodSec(OVERRUN_PERIOD_SEC);
+    scheduler.SetCatchUpPolicy(policy);
+    scheduler.Start();
+
+    RunUpdate(scheduler, OVERRUN_PERIOD_SEC * OVERRUN_PERIODS);
+    const double waitStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    if (policy == PeriodicScheduler::CATCH_UP_BURST)
+    {
+      // All missed ticks are executed back-to-back, each of them must return immediately.
+      // The deadlines that are passed again by the later ticks must not be counted again.
+      for (unsigned long long i = 0; i < EXPECTED_MISSED_DEADLINES; ++i)
+      {
+        scheduler.WaitForNextDeadline();
+      }
+    }
+    else
+    {
+      scheduler.WaitForNextDeadline();
+    }
+    const double waitSec = vtkIGSIOAccurateTimer::GetSystemTime() - waitStartTime;
+
+    if (scheduler.GetNumberOfMissedDeadlines() != EXPECTED_MISSED_DEADLINES)
+    {
+      LOG_ERROR("Number of missed deadlines is " << scheduler.GetNumberOfMissedDeadlines() << ", expected " << EXPECTED_MISSED_DEADLINES);
+      return PLUS_FAIL;
+    }
+    if (policy == PeriodicScheduler::CATCH_UP_BURST)
+    {
+      if (waitSec > OVERRUN_PERIOD_SEC / 2)
+      {
+        LOG_ERROR("Missed ticks are not executed immediately with the burst policy (wait: " << waitSec << " sec)");
+        return PLUS_FAIL;
+      }
+    }
+    else
+    {
+      // The missed ticks are dropped, the next tick is at the next deadline of the grid
+      if (waitSec > OVERRUN_PERIOD_SEC * 1.5)
+      {
+        LOG_ERROR("Missed ticks are not skipped with the skip policy (wait: " << waitSec << " sec)");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestNoDrift() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Drift test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestOverrun(PeriodicScheduler::CATCH_UP_SKIP) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Overrun test with skip policy failed");
+    return EXIT_FAILURE;
+  }
+  if (TestOverrun(PeriodicScheduler::CATCH_UP_BURST) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Overrun test with burst policy failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,327 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusPoseInterpolatorTest.cxx
+  \brief Test that batched pose interpolation gives the same results as interpolating the poses one by one
+
+  Random pose pairs (including nearly identical and nearly opposite orientations) are interpolated in one batch
+  and compared to the quaternion conversion and SLERP functions of VTK and IGSIO. Then a channel with many tools
+  is queried to check that the batched interpolation assigns the interpolated pose to the right tool.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusPoseInterpolator.h"
+#include "igsioMath.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataSource.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+
+// STL includes
+#include <random>
+#include <sstream>
+
+namespace
+{
+  const double MAX_ROTATION_ELEMENT_DIFFERENCE = 1e-6;
+  const double MAX_TRANSLATION_DIFFERENCE = 1e-6;
+  const double MAX_ANGLE_DIFFERENCE_DEG = 1e-3;
+  const int NUMBER_OF_POSE_PAIRS = 200;
+  const int NUMBER_OF_TOOLS = 25;
+
+  //----------------------------------------------------------------------------
+  void GetRandomPose(std::mt19937& generator, double matrix[16])
+  {
+    std::normal_distribution<double> normal(0.0, 1.0);
+    std::uniform_real_distribution<double> translation(-500.0, 500.0);
+    double quaternion[4] = { normal(generator), normal(generator), normal(generator), normal(generator) };
+    vtkMath::Normalize4D(quaternion);
+    double rotation[3][3];
+    vtkMath::QuaternionToMatrix3x3(quaternion, rotation);
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 3; ++column)
+      {
+        matrix[row * 4 + column] = rotation[row][column];
+      }
+      matrix[row * 4 + 3] = translation(generator);
+    }
+    matrix[12] = 0.0;
+    matrix[13] = 0.0;
+    matrix[14] = 0.0;
+    matrix[15] = 1.0;
+  }
+
+  //----------------------------------------------------------------------------
+  // Rotate a pose around an arbitrary axis by the specified angle
+  void GetRotatedPose(const double matrix[16], double angleDeg, double rotatedMatrix[16])
+  {
+    vtkSmartPointer<vtkMatrix4x4> input = vtkSmartPointer<vtkMatrix4x4>::New();
+    input->DeepCopy(matrix);
+    double axis[3] = { 0.3, -0.5, 0.8 };
+    vtkMath::Normalize(axis);
+    const double halfAngle = vtkMath::RadiansFromDegrees(angleDeg) / 2.0;
+    double quaternion[4] = { cos(halfAngle), sin(halfAngle) * axis[0], sin(halfAngle) * axis[1], sin(halfAngle) * axis[2] };
+    double rotation[3][3];
+    vtkMath::QuaternionToMatrix3x3(quaternion, rotation);
+    vtkSmartPointer<vtkMatrix4x4> rotationMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 3; ++column)
+      {
+        rotationMatrix->SetElement(row, column, rotation[row][column]);
+      }
+    }
+    vtkSmartPointer<vtkMatrix4x4> output = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkMatrix4x4::Multiply4x4(input, rotationMatrix, output);
+    vtkMatrix4x4::DeepCopy(rotatedMatrix, output);
+  }
+
+  //----------------------------------------------------------------------------
+  // Interpolation of a single pose, the way vtkPlusBuffer interpolated poses before batching
+  void InterpolateReference(const double matrixA[16], const double matrixB[16], double weightB, vtkMatrix4x4* interpolatedMatrix)
+  {
+    double rotationA[3][3];
+    double rotationB[3][3];
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 3; ++column)
+      {
+        rotationA[row][column] = matrixA[row * 4 + column];
+        rotationB[row][column] = matrixB[row * 4 + column];
+      }
+    }
+    double quaternionA[4] = { 0, 0, 0, 0 };
+    vtkMath::Matrix3x3ToQuaternion(rotationA, quaternionA);
+    double quaternionB[4] = { 0, 0, 0, 0 };
+    vtkMath::Matrix3x3ToQuaternion(rotationB, quaternionB);
+    double interpolatedQuaternion[4] = { 0, 0, 0, 0 };
+    igsioMath::Slerp(interpolatedQuaternion, weightB, quaternionA, quaternionB);
+    double interpolatedRotation[3][3];
+    vtkMath::QuaternionToMatrix3x3(interpolatedQuaternion, interpolatedRotation);
+
+    interpolatedMatrix->Identity();
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 3; ++column)
+      {
+        interpolatedMatrix->SetElement(row, column, interpolatedRotation[row][column]);
+      }
+      interpolatedMatrix->SetElement(row, 3, matrixA[row * 4 + 3] * (1.0 - weightB) + matrixB[row * 4 + 3] * weightB);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CompareMatrices(vtkMatrix4x4* expected, vtkMatrix4x4* actual, const std::string& description)
+  {
+    for (int row = 0; row < 3; ++row)
+    {
+      for (int column = 0; column < 3; ++column)
+      {
+        if (fabs(expected->GetElement(row, column) - actual->GetElement(row, column)) > MAX_ROTATION_ELEMENT_DIFFERENCE)
+        {
+          LOG_ERROR(description << ": rotation element (" << row << ", " << column << ") is " << actual->GetElement(row, column) << ", expected " << expected->GetElement(row, column));
+          return PLUS_FAIL;
+        }
+      }
+      if (fabs(expected->GetElement(row, 3) - actual->GetElement(row, 3)) > MAX_TRANSLATION_DIFFERENCE)
+      {
+        LOG_ERROR(description << ": translation element " << row << " is " << actual->GetElement(row, 3) << ", expected " << expected->GetElement(row, 3));
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestBatchInterpolation()
+  {
+    std::mt19937 generator(12345);
+    std::uniform_real_distribution<double> weight(0.0, 1.0);
+    std::vector< std::vector<double> > matricesA(NUMBER_OF_POSE_PAIRS, std::vector<double>(16));
+    std::vector< std::vector<double> > matricesB(NUMBER_OF_POSE_PAIRS, std::vector<double>(16));
+    std::vector<double> weightsB(NUMBER_OF_POSE_PAIRS);
+
+    PoseInterpolator interpolator;
+    for (int i = 0; i < NUMBER_OF_POSE_PAIRS; ++i)
+    {
+      GetRandomPose(generator, &matricesA[i][0]);
+      switch (i % 4)
+      {
+        case 0:
+          // Nearly identical orientations, interpolated linearly
+          GetRotatedPose(&matricesA[i][0], 0.01, &matricesB[i][0]);
+          break;
+        case 1:
+          // Nearly opposite orientations, the shorter path is on the other side
+          GetRotatedPose(&matricesA[i][0], 179.0, &matricesB[i][0]);
+          break;
+        default:
+          GetRandomPose(generator, &matricesB[i][0]);
+      }
+      weightsB[i] = weight(generator);
+      int poseIndex = interpolator.AddPosePair(&matricesA[i][0], &matricesB[i][0], weightsB[i]);
+      if (poseIndex != i)
+      {
+        LOG_ERROR("Pose index is " << poseIndex << ", expected " << i);
+        return PLUS_FAIL;
+      }
+    }
+    interpolator.Interpolate();
+
+    vtkSmartPointer<vtkMatrix4x4> expectedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> actualMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> matrixA = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> matrixB = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int i = 0; i < NUMBER_OF_POSE_PAIRS; ++i)
+    {
+      InterpolateReference(&matricesA[i][0], &matricesB[i][0], weightsB[i], expectedMatrix);
+      double actualElements[16];
+      interpolator.GetInterpolatedMatrix(i, actualElements);
+      actualMatrix->DeepCopy(actualElements);
+      std::ostringstream description;
+      description << "Pose " << i;
+      if (CompareMatrices(expectedMatrix, actualMatrix, description.str()) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+
+      matrixA->DeepCopy(&matricesA[i][0]);
+      matrixB->DeepCopy(&matricesB[i][0]);
+      double expectedAngleFromA = igsioMath::GetOrientationDifference(actualMatrix, matrixA);
+      double expectedAngleFromB = igsioMath::GetOrientationDifference(actualMatrix, matrixB);
+      if (fabs(fabs(expectedAngleFromA) - interpolator.GetOrientationDifferenceFromA(i)) > MAX_ANGLE_DIFFERENCE_DEG
+          || fabs(fabs(expectedAngleFromB) - interpolator.GetOrientationDifferenceFromB(i)) > MAX_ANGLE_DIFFERENCE_DEG)
+      {
+        LOG_ERROR(description.str() << ": orientation differences are " << interpolator.GetOrientationDifferenceFromA(i) << " and " << interpolator.GetOrientationDifferenceFromB(i)
+                  << " deg, expected " << fabs(expectedAngleFromA) << " and " << fabs(expectedAngleFromB) << " deg");
+        return PLUS_FAIL;
+      }
+    }
+
+    // The interpolator is reused without reallocation
+    interpolator.Clear();
+    if (interpolator.GetNumberOfPoses() != 0 || interpolator.AddPosePair(&matricesA[0][0], &matricesB[0][0], weightsB[0]) != 0)
+    {
+      LOG_ERROR("Cleared interpolator does not start a new batch");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestChannelInterpolation()
+  {
+    std::mt19937 generator(54321);
+    const double timestampA = 10.0;
+    const double timestampB = 10.01;
+    const double requestedTimestamp = 10.003;
+    const double weightB = (requestedTimestamp - timestampA) / (timestampB - timestampA);
+
+    vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+    channel->SetChannelId("TrackerStream");
+    std::vector< vtkSmartPointer<vtkPlusDataSource> > tools;
+    std::vector< std::vector<double> > matricesA(NUMBER_OF_TOOLS, std::vector<double>(16));
+    std::vector< std::vector<double> > matricesB(NUMBER_OF_TOOLS, std::vector<double>(16));
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int i = 0; i < NUMBER_OF_TOOLS; ++i)
+    {
+      std::ostringstream toolId;
+      toolId << "Tool" << i << "ToTracker";
+      vtkSmartPointer<vtkPlusDataSource> tool = vtkSmartPointer<vtkPlusDataSource>::New();
+      tool->SetId(toolId.str());
+      tool->SetType(DATA_SOURCE_TYPE_TOOL);
+      tool->SetBufferSize(10);
+      channel->AddTool(tool);
+      tools.push_back(tool);
+
+      GetRandomPose(generator, &matricesA[i][0]);
+      GetRotatedPose(&matricesA[i][0], 5.0 + i, &matricesB[i][0]);
+      matrix->DeepCopy(&matricesA[i][0]);
+      if (tool->AddTimeStampedItem(matrix, TOOL_OK, 1, timestampA, timestampA) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add item to tool " << toolId.str());
+        return PLUS_FAIL;
+      }
+      matrix->DeepCopy(&matricesB[i][0]);
+      if (tool->AddTimeStampedItem(matrix, TOOL_OK, 2, timestampB, timestampB) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add item to tool " << toolId.str());
+        return PLUS_FAIL;
+      }
+    }
+
+    igsioTrackedFrame trackedFrame;
+    if (channel->GetTrackedFrame(requestedTimestamp, trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get tracked frame");
+      return PLUS_FAIL;
+    }
+
+    vtkSmartPointer<vtkMatrix4x4> expectedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int i = 0; i < NUMBER_OF_TOOLS; ++i)
+    {
+      igsioTransformName transformName(tools[i]->GetId());
+      if (trackedFrame.GetFrameTransform(transformName, matrix) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Tracked frame does not contain transform " << tools[i]->GetId());
+        return PLUS_FAIL;
+      }
+      InterpolateReference(&matricesA[i][0], &matricesB[i][0], weightB, expectedMatrix);
+      if (CompareMatrices(expectedMatrix, matrix, tools[i]->GetId()) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestBatchInterpolation() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Batch interpolation test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestChannelInterpolation() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Channel interpolation test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,238 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusSequenceFrameIndexTest.cxx
+  \brief Test that frames are read through a frame index without loading the whole sequence file
+
+  A frame index is built for uncompressed NRRD and MetaImage sequence files, and a range of frames is
+  read through it. The frames must match the written pixel data, timestamps and frame fields. For a
+  compressed file the pixel data cannot be located, so reading a range of frames must fail instead of
+  reading the whole file. A missing index is built by the first read of a range of frames. An index must not be used after the header of the sequence file is changed, even if
+  the size of the file remains the same.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSequenceFrameIndex.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// STL includes
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 40, 30, 1 };
+  const unsigned int NUMBER_OF_FRAMES = 8;
+  const double FRAME_PERIOD_SEC = 0.1;
+  const unsigned int FIRST_FRAME_TO_READ = 2;
+  const unsigned int NUMBER_OF_FRAMES_TO_READ = 3;
+  const char FIELD_NAME[] = "TestFrameNumber";
+
+  //----------------------------------------------------------------------------
+  std::string GetFieldValue(unsigned int frameIndex)
+  {
+    std::ostringstream value;
+    value << "Frame" << frameIndex;
+    return value.str();
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus WriteSequence(const std::string& filename, bool useCompression)
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (PlusTestFrames::AddFrames(frameList, 0, NUMBER_OF_FRAMES, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    for (unsigned int frameIndex = 0; frameIndex < NUMBER_OF_FRAMES; ++frameIndex)
+    {
+      frameList->GetTrackedFrame(frameIndex)->SetFrameField(FIELD_NAME, GetFieldValue(frameIndex));
+    }
+    if (vtkPlusSequenceIO::Write(filename, frameList, US_IMG_ORIENT_MF, useCompression) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write sequence file: " << filename);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check that the frame list contains the written frames starting at firstFrameIndex */
+  PlusStatus CheckFrames(vtkIGSIOTrackedFrameList* frameList, unsigned int firstFrameIndex, unsigned int numberOfFrames)
+  {
+    if (PlusTestFrames::CheckFrames(frameList, firstFrameIndex, numberOfFrames, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    for (unsigned int i = 0; i < numberOfFrames; ++i)
+    {
+      if (frameList->GetTrackedFrame(i)->GetFrameField(FIELD_NAME) != GetFieldValue(firstFrameIndex + i))
+      {
+        LOG_ERROR("Frame " << firstFrameIndex + i << " does not have the expected " << FIELD_NAME << " field value");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestSequenceFile(const std::string& filename, bool useCompression)
+  {
+    if (WriteSequence(filename, useCompression) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (SequenceFrameIndex::Build(filename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to build frame index of " << filename);
+      return PLUS_FAIL;
+    }
+
+    SequenceFrameIndex index;
+    if (index.Read(SequenceFrameIndex::GetIndexFileName(filename)) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame index of " << filename);
+      return PLUS_FAIL;
+    }
+    if (!index.IsValidFor(filename) || index.GetNumberOfFrames() != NUMBER_OF_FRAMES)
+    {
+      LOG_ERROR("Frame index of " << filename << " does not match the sequence file");
+      return PLUS_FAIL;
+    }
+    // Only uncompressed pixel data can be read directly
+    if (index.IsPixelDataLocated() == useCompression)
+    {
+      LOG_ERROR("Pixel data of " << filename << " is " << (useCompression ? "" : "not ") << "located by the frame index");
+      return PLUS_FAIL;
+    }
+
+    // Closest frame is found for timestamps between frames and outside of the recorded time range
+    unsigned int frameIndex = 0;
+    if (index.FindFrameIndex(3.4 * FRAME_PERIOD_SEC, frameIndex) != PLUS_SUCCESS || frameIndex != 3
+        || index.FindFrameIndex(3.6 * FRAME_PERIOD_SEC, frameIndex) != PLUS_SUCCESS || frameIndex != 4
+        || index.FindFrameIndex(-1.0, frameIndex) != PLUS_SUCCESS || frameIndex != 0
+        || index.FindFrameIndex(NUMBER_OF_FRAMES * FRAME_PERIOD_SEC * 2, frameIndex) != PLUS_SUCCESS || frameIndex != NUMBER_OF_FRAMES - 1)
+    {
+      LOG_ERROR("Frame lookup by timestamp failed in the frame index of " << filename);
+      return PLUS_FAIL;
+    }
+    igsioFieldMapType::const_iterator field = index.GetFrameFields(5).find(FIELD_NAME);
+    if (field == index.GetFrameFields(5).end() || field->second.second != GetFieldValue(5))
+    {
+      LOG_ERROR("Frame field of frame 5 is not stored in the frame index of " << filename);
+      return PLUS_FAIL;
+    }
+
+    // Frames of a compressed file cannot be read without reading the whole file, so the read is expected to fail with an error
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    PlusStatus readStatus = vtkPlusSequenceIO::ReadFrames(filename, FIRST_FRAME_TO_READ, NUMBER_OF_FRAMES_TO_READ, frameList);
+    if ((readStatus == PLUS_SUCCESS) == useCompression)
+    {
+      LOG_ERROR("Reading frames from " << filename << (useCompression ? " did not fail" : " failed"));
+      return PLUS_FAIL;
+    }
+    if (!useCompression && CheckFrames(frameList, FIRST_FRAME_TO_READ, NUMBER_OF_FRAMES_TO_READ) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Frames read from " << filename << " do not match the written frames");
+      return PLUS_FAIL;
+    }
+
+    // Several ranges are read through an index that is opened once
+    SequenceFrameIndex openedIndex;
+    if ((vtkPlusSequenceIO::OpenFrameIndex(filename, openedIndex) == PLUS_SUCCESS) == useCompression)
+    {
+      LOG_ERROR("Frame index of " << filename << " is " << (useCompression ? "" : "not ") << "opened for reading frames");
+      return PLUS_FAIL;
+    }
+    if (!useCompression)
+    {
+      for (unsigned int firstFrameIndex = 0; firstFrameIndex + NUMBER_OF_FRAMES_TO_READ <= NUMBER_OF_FRAMES; firstFrameIndex += NUMBER_OF_FRAMES_TO_READ)
+      {
+        frameList->Clear();
+        if (openedIndex.ReadFrames(firstFrameIndex, NUMBER_OF_FRAMES_TO_READ, frameList) != PLUS_SUCCESS
+            || CheckFrames(frameList, firstFrameIndex, NUMBER_OF_FRAMES_TO_READ) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Failed to read frames " << firstFrameIndex << "-" << firstFrameIndex + NUMBER_OF_FRAMES_TO_READ << " through the opened frame index of " << filename);
+          return PLUS_FAIL;
+        }
+      }
+
+      // The first read of a range of frames builds the missing index
+      vtksys::SystemTools::RemoveFile(SequenceFrameIndex::GetIndexFileName(filename));
+      frameList->Clear();
+      if (vtkPlusSequenceIO::ReadFrames(filename, FIRST_FRAME_TO_READ, NUMBER_OF_FRAMES_TO_READ, frameList) != PLUS_SUCCESS
+          || CheckFrames(frameList, FIRST_FRAME_TO_READ, NUMBER_OF_FRAMES_TO_READ) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to read frames from " << filename << " without a frame index");
+        return PLUS_FAIL;
+      }
+      if (vtkPlusSequenceIO::OpenFrameIndex(filename, openedIndex) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Frame index of " << filename << " is not built by reading a range of frames");
+        return PLUS_FAIL;
+      }
+    }
+
+    // Change the first byte of the header, the size of the file remains the same
+    {
+      std::fstream file(filename.c_str(), std::ios::in | std::ios::out | std::ios::binary);
+      file.seekp(0);
+      file.put('#');
+    }
+    if (index.IsValidFor(filename) || vtkPlusSequenceIO::OpenFrameIndex(filename, openedIndex) == PLUS_SUCCESS)
+    {
+      LOG_ERROR("Frame index of " << filename << " is used after the header of the sequence file is changed");
+      return PLUS_FAIL;
+    }
+
+    vtksys::SystemTools::RemoveFile(SequenceFrameIndex::GetIndexFileName(filename));
+    vtksys::SystemTools::RemoveFile(filename);
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  const std::string filenameRoot = vtkPlusConfig::GetInstance()->GetOutputPath("PlusSequenceFrameIndexTest");
+  if (TestSequenceFile(filenameRoot + ".nrrd", false) != PLUS_SUCCESS
+      || TestSequenceFile(filenameRoot + ".mha", false) != PLUS_SUCCESS
+      || TestSequenceFile(filenameRoot + "_Compressed.nrrd", true) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
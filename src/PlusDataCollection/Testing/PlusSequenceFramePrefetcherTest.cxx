@@ -0,0 +1,243 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusSequenceFramePrefetcherTest.cxx
+  \brief Test that frames of a sequence file are replayed through the prefetcher with a bounded number of frames in memory
+
+  An uncompressed sequence file is written and indexed, then a part of it is replayed twice in a loop.
+  Every replayed frame must match the written pixel data and timestamp, and the prefetcher must never
+  hold more frames than its read-ahead window. The same frames are also replayed from a segmented
+  sequence, whose segment files are indexed separately, and from a chunked sequence file with
+  uncompressed chunks.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusChunkedSequenceFile.h"
+#include "PlusSequenceFramePrefetcher.h"
+#include "PlusSequenceSegmentIndex.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// STL includes
+#include <sstream>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 32, 24, 1 };
+  const unsigned int NUMBER_OF_FRAMES = 20;
+  const double FRAME_PERIOD_SEC = 0.05;
+  const unsigned int READ_AHEAD_FRAMES = 4;
+  const unsigned int FIRST_REPLAYED_FRAME = 5;
+  const unsigned int LAST_REPLAYED_FRAME = 14;
+  const unsigned int NUMBER_OF_LOOPS = 2;
+
+  /*! Frames of the segment files of the segmented sequence and the chunks of the chunked sequence */
+  const unsigned int NUMBER_OF_FRAMES_PER_PART[] = { 7, 7, 6 };
+  const unsigned int NUMBER_OF_PARTS = sizeof(NUMBER_OF_FRAMES_PER_PART) / sizeof(NUMBER_OF_FRAMES_PER_PART[0]);
+
+  //----------------------------------------------------------------------------
+  PlusStatus WriteSequence(const std::string& filename, unsigned int firstFrameIndex, unsigned int numberOfFrames)
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (PlusTestFrames::AddFrames(frameList, firstFrameIndex, numberOfFrames, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (vtkPlusSequenceIO::Write(filename, frameList, US_IMG_ORIENT_MF, false) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write sequence file: " << filename);
+      return PLUS_FAIL;
+    }
+    if (SequenceFrameIndex::Build(filename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to build frame index of " << filename);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Write the frames into segment files, each of them indexed, and list them in a segment index file */
+  PlusStatus WriteSegmentedSequence(const std::string& filenameRoot, SequenceSegmentIndex& segmentIndex)
+  {
+    segmentIndex.Initialize(filenameRoot + SequenceSegmentIndex::GetFileExtension());
+    unsigned int firstFrameIndex = 0;
+    for (unsigned int segment = 0; segment < NUMBER_OF_PARTS; ++segment)
+    {
+      std::ostringstream segmentFilename;
+      segmentFilename << filenameRoot << "_seg" << segment << ".nrrd";
+      if (WriteSequence(segmentFilename.str(), firstFrameIndex, NUMBER_OF_FRAMES_PER_PART[segment]) != PLUS_SUCCESS
+          || segmentIndex.AddSegment(segmentFilename.str(), NUMBER_OF_FRAMES_PER_PART[segment]) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to write segment " << segmentFilename.str());
+        return PLUS_FAIL;
+      }
+      firstFrameIndex += NUMBER_OF_FRAMES_PER_PART[segment];
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Write the frames into a chunked sequence file with uncompressed chunks and index it */
+  PlusStatus WriteChunkedSequence(const std::string& filename)
+  {
+    // Each part is a chunk, so that the frames are read from more than one chunk
+    ChunkedSequenceFile chunkedFile;
+    if (chunkedFile.SetMinimumNumberOfFramesPerChunk(1) != PLUS_SUCCESS || chunkedFile.Open(filename, false) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to create chunked sequence file: " << filename);
+      return PLUS_FAIL;
+    }
+    std::vector<vtkSmartPointer<vtkIGSIOTrackedFrameList> > frameLists;
+    std::vector<vtkIGSIOTrackedFrameList*> chunkFrameLists;
+    unsigned int firstFrameIndex = 0;
+    for (unsigned int chunk = 0; chunk < NUMBER_OF_PARTS; ++chunk)
+    {
+      vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+      if (PlusTestFrames::AddFrames(frameList, firstFrameIndex, NUMBER_OF_FRAMES_PER_PART[chunk], FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+      frameLists.push_back(frameList);
+      chunkFrameLists.push_back(frameList);
+      firstFrameIndex += NUMBER_OF_FRAMES_PER_PART[chunk];
+    }
+    if (chunkedFile.WriteFrames(chunkFrameLists) != PLUS_SUCCESS || chunkedFile.Close() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write chunked sequence file: " << filename);
+      return PLUS_FAIL;
+    }
+    if (SequenceFrameIndex::Build(filename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to build frame index of " << filename);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Replay a range of the sequence in a loop through the prefetcher and check each frame */
+  PlusStatus TestPrefetcher(const std::string& filename)
+  {
+    SequenceFramePrefetcher prefetcher;
+    if (prefetcher.SetReadAheadFrames(READ_AHEAD_FRAMES) != PLUS_SUCCESS || prefetcher.Open(filename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open " << filename << " for prefetching");
+      return PLUS_FAIL;
+    }
+    if (prefetcher.GetNumberOfFrames() != NUMBER_OF_FRAMES)
+    {
+      LOG_ERROR("Prefetcher found " << prefetcher.GetNumberOfFrames() << " frames instead of " << NUMBER_OF_FRAMES << " in " << filename);
+      return PLUS_FAIL;
+    }
+
+    // Closest frames are found on both sides of the boundary of the first part
+    const unsigned int boundaryFrameIndex = NUMBER_OF_FRAMES_PER_PART[0];
+    unsigned int frameIndex = 0;
+    if (prefetcher.FindFrameIndex((boundaryFrameIndex - 0.6) * FRAME_PERIOD_SEC, frameIndex) != PLUS_SUCCESS || frameIndex != boundaryFrameIndex - 1
+        || prefetcher.FindFrameIndex((boundaryFrameIndex - 0.4) * FRAME_PERIOD_SEC, frameIndex) != PLUS_SUCCESS || frameIndex != boundaryFrameIndex
+        || prefetcher.FindFrameIndex(NUMBER_OF_FRAMES * FRAME_PERIOD_SEC * 2, frameIndex) != PLUS_SUCCESS || frameIndex != NUMBER_OF_FRAMES - 1
+        || fabs(prefetcher.GetTimestamp(boundaryFrameIndex) - boundaryFrameIndex * FRAME_PERIOD_SEC) > 1e-6)
+    {
+      LOG_ERROR("Frame lookup by timestamp failed in " << filename);
+      return PLUS_FAIL;
+    }
+
+    prefetcher.SetReplayRange(FIRST_REPLAYED_FRAME, LAST_REPLAYED_FRAME, true);
+
+    // Replay the range in a loop, the frames after the end of the range are read from the beginning of the range
+    for (unsigned int loopIndex = 0; loopIndex < NUMBER_OF_LOOPS; ++loopIndex)
+    {
+      for (frameIndex = FIRST_REPLAYED_FRAME; frameIndex <= LAST_REPLAYED_FRAME; ++frameIndex)
+      {
+        std::shared_ptr<igsioTrackedFrame> frame;
+        if (prefetcher.GetFrame(frameIndex, frame) != PLUS_SUCCESS || PlusTestFrames::CheckFrame(*frame, frameIndex, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Failed to replay frame " << frameIndex << " of " << filename << " in loop " << loopIndex);
+          return PLUS_FAIL;
+        }
+        if (prefetcher.GetNumberOfPrefetchedFrames() > READ_AHEAD_FRAMES)
+        {
+          LOG_ERROR("Prefetcher holds " << prefetcher.GetNumberOfPrefetchedFrames() << " frames, more than the " << READ_AHEAD_FRAMES << " read-ahead frames");
+          return PLUS_FAIL;
+        }
+      }
+    }
+
+    // Jumping to a frame out of replay order must also work
+    std::shared_ptr<igsioTrackedFrame> frame;
+    if (prefetcher.GetFrame(LAST_REPLAYED_FRAME - 2, frame) != PLUS_SUCCESS || PlusTestFrames::CheckFrame(*frame, LAST_REPLAYED_FRAME - 2, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read frame of " << filename << " after seeking");
+      return PLUS_FAIL;
+    }
+
+    prefetcher.Close();
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  const std::string filenameRoot = vtkPlusConfig::GetInstance()->GetOutputPath("PlusSequenceFramePrefetcherTest");
+  const std::string filename = filenameRoot + ".nrrd";
+  if (WriteSequence(filename, 0, NUMBER_OF_FRAMES) != PLUS_SUCCESS || TestPrefetcher(filename) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::RemoveFile(SequenceFrameIndex::GetIndexFileName(filename));
+  vtksys::SystemTools::RemoveFile(filename);
+
+  SequenceSegmentIndex segmentIndex;
+  if (WriteSegmentedSequence(filenameRoot + "_Segmented", segmentIndex) != PLUS_SUCCESS || TestPrefetcher(segmentIndex.GetFileName()) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  for (unsigned int segment = 0; segment < segmentIndex.GetNumberOfSegments(); ++segment)
+  {
+    vtksys::SystemTools::RemoveFile(SequenceFrameIndex::GetIndexFileName(segmentIndex.GetSegmentFileName(segment)));
+  }
+  segmentIndex.Discard();
+
+  const std::string chunkedFilename = filenameRoot + "_Chunked" + ChunkedSequenceFile::GetFileExtension();
+  if (WriteChunkedSequence(chunkedFilename) != PLUS_SUCCESS || TestPrefetcher(chunkedFilename) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  vtksys::SystemTools::RemoveFile(SequenceFrameIndex::GetIndexFileName(chunkedFilename));
+  vtksys::SystemTools::RemoveFile(chunkedFilename);
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
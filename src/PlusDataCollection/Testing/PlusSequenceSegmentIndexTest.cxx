@@ -0,0 +1,138 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusSequenceSegmentIndexTest.cxx
+  \brief Test that the segment files listed in a segment index are read as one sequence
+
+  Segment files are written one after the other and added to the index when they are complete. The index
+  must be readable after each added segment (as it would be after a crash), must contain the frames of
+  all listed segments in order, and must remain valid when it is renamed.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSequenceSegmentIndex.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// STL includes
+#include <sstream>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 32, 16, 1 };
+  const unsigned int NUMBER_OF_SEGMENTS = 3;
+  const unsigned int NUMBER_OF_FRAMES_PER_SEGMENT = 4;
+  const double FRAME_PERIOD_SEC = 0.1;
+
+  //----------------------------------------------------------------------------
+  /*! Read the index as a sequence and check that it contains the first numberOfSegments segments */
+  PlusStatus CheckIndex(const std::string& indexFilename, unsigned int numberOfSegments)
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (vtkPlusSequenceIO::Read(indexFilename, frameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read segment index file: " << indexFilename);
+      return PLUS_FAIL;
+    }
+    if (PlusTestFrames::CheckFrames(frameList, 0, numberOfSegments * NUMBER_OF_FRAMES_PER_SEGMENT, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Frames read from " << indexFilename << " do not match the written frames");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  const std::string filenameRoot = vtkPlusConfig::GetInstance()->GetOutputPath("PlusSequenceSegmentIndexTest");
+  SequenceSegmentIndex index;
+  index.Initialize(filenameRoot + SequenceSegmentIndex::GetFileExtension());
+
+  for (unsigned int segmentIndex = 0; segmentIndex < NUMBER_OF_SEGMENTS; ++segmentIndex)
+  {
+    std::ostringstream segmentFilename;
+    segmentFilename << filenameRoot << "_seg" << segmentIndex << ".nrrd";
+
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (PlusTestFrames::AddFrames(frameList, segmentIndex * NUMBER_OF_FRAMES_PER_SEGMENT, NUMBER_OF_FRAMES_PER_SEGMENT, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      return EXIT_FAILURE;
+    }
+    if (vtkPlusSequenceIO::Write(segmentFilename.str(), frameList, US_IMG_ORIENT_MF, false) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write segment file: " << segmentFilename.str());
+      return EXIT_FAILURE;
+    }
+    if (index.AddSegment(segmentFilename.str(), frameList->GetNumberOfTrackedFrames()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add segment file to the index: " << segmentFilename.str());
+      return EXIT_FAILURE;
+    }
+
+    // The index is complete after each segment, a recording that stops here is not lost
+    if (CheckIndex(index.GetFileName(), segmentIndex + 1) != PLUS_SUCCESS)
+    {
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (index.GetNumberOfSegments() != NUMBER_OF_SEGMENTS || index.GetNumberOfFrames() != NUMBER_OF_SEGMENTS * NUMBER_OF_FRAMES_PER_SEGMENT)
+  {
+    LOG_ERROR("Index contains " << index.GetNumberOfSegments() << " segments with " << index.GetNumberOfFrames() << " frames");
+    return EXIT_FAILURE;
+  }
+
+  // Segment files are referenced relative to the index file, so they are found after renaming the index
+  const std::string renamedIndexFilename = filenameRoot + "_Renamed" + SequenceSegmentIndex::GetFileExtension();
+  if (index.Rename(renamedIndexFilename) != PLUS_SUCCESS || vtksys::SystemTools::FileExists(filenameRoot + SequenceSegmentIndex::GetFileExtension()))
+  {
+    LOG_ERROR("Failed to rename the segment index file to " << renamedIndexFilename);
+    return EXIT_FAILURE;
+  }
+  if (CheckIndex(renamedIndexFilename, NUMBER_OF_SEGMENTS) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  index.Discard();
+  if (vtksys::SystemTools::FileExists(renamedIndexFilename) || vtksys::SystemTools::FileExists(filenameRoot + "_seg0.nrrd"))
+  {
+    LOG_ERROR("Discarded segment index or segment files still exist");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,108 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __PlusTestFrames_h
+#define __PlusTestFrames_h
+
+#include "PlusConfigure.h"
+#include "igsioTrackedFrame.h"
+#include "vtkIGSIOTrackedFrameList.h"
+
+/*!
+  \file PlusTestFrames.h
+  \brief Synthetic tracked frames for the sequence file and recording tests
+
+  Each pixel value and the timestamp are computed from the frame index, so that a frame that is read back
+  can be checked against the written frame without keeping the written frames in memory.
+*/
+namespace PlusTestFrames
+{
+  //----------------------------------------------------------------------------
+  inline unsigned char GetPixelValue(unsigned int frameIndex, unsigned int pixelIndex)
+  {
+    return static_cast<unsigned char>((frameIndex * 7 + pixelIndex) & 0xFF);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Append 8-bit brightness frames to the frame list, with timestamp frameIndex * framePeriodSec */
+  inline PlusStatus AddFrames(vtkIGSIOTrackedFrameList* frameList, unsigned int firstFrameIndex, unsigned int numberOfFrames, const FrameSizeType& frameSize, double framePeriodSec)
+  {
+    const unsigned int numberOfPixels = frameSize[0] * frameSize[1] * frameSize[2];
+    for (unsigned int frameIndex = firstFrameIndex; frameIndex < firstFrameIndex + numberOfFrames; ++frameIndex)
+    {
+      igsioTrackedFrame frame;
+      if (frame.GetImageData()->AllocateFrame(frameSize, VTK_UNSIGNED_CHAR, 1) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to allocate frame " << frameIndex);
+        return PLUS_FAIL;
+      }
+      frame.GetImageData()->SetImageOrientation(US_IMG_ORIENT_MF);
+      frame.GetImageData()->SetImageType(US_IMG_BRIGHTNESS);
+      unsigned char* pixels = static_cast<unsigned char*>(frame.GetImageData()->GetScalarPointer());
+      for (unsigned int pixelIndex = 0; pixelIndex < numberOfPixels; ++pixelIndex)
+      {
+        pixels[pixelIndex] = GetPixelValue(frameIndex, pixelIndex);
+      }
+      frame.SetTimestamp(frameIndex * framePeriodSec);
+      if (frameList->AddTrackedFrame(&frame) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add frame " << frameIndex);
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check that the frame is the frame created by AddFrames with the given frame index */
+  inline PlusStatus CheckFrame(igsioTrackedFrame& frame, unsigned int frameIndex, const FrameSizeType& frameSize, double framePeriodSec)
+  {
+    if (fabs(frame.GetTimestamp() - frameIndex * framePeriodSec) > 1e-6)
+    {
+      LOG_ERROR("Frame " << frameIndex << " has timestamp " << frame.GetTimestamp() << " instead of " << frameIndex * framePeriodSec);
+      return PLUS_FAIL;
+    }
+    FrameSizeType readFrameSize = frame.GetFrameSize();
+    if (readFrameSize[0] != frameSize[0] || readFrameSize[1] != frameSize[1] || readFrameSize[2] != frameSize[2])
+    {
+      LOG_ERROR("Frame " << frameIndex << " has size " << readFrameSize[0] << "x" << readFrameSize[1] << "x" << readFrameSize[2]
+                << " instead of " << frameSize[0] << "x" << frameSize[1] << "x" << frameSize[2]);
+      return PLUS_FAIL;
+    }
+    const unsigned char* pixels = static_cast<unsigned char*>(frame.GetImageData()->GetScalarPointer());
+    const unsigned int numberOfPixels = frameSize[0] * frameSize[1] * frameSize[2];
+    for (unsigned int pixelIndex = 0; pixelIndex < numberOfPixels; ++pixelIndex)
+    {
+      if (pixels[pixelIndex] != GetPixelValue(frameIndex, pixelIndex))
+      {
+        LOG_ERROR("Pixel " << pixelIndex << " of frame " << frameIndex << " does not match the written value");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Check that the frame list contains exactly the frames created by AddFrames, starting at firstFrameIndex */
+  inline PlusStatus CheckFrames(vtkIGSIOTrackedFrameList* frameList, unsigned int firstFrameIndex, unsigned int numberOfFrames, const FrameSizeType& frameSize, double framePeriodSec)
+  {
+    if (frameList->GetNumberOfTrackedFrames() != numberOfFrames)
+    {
+      LOG_ERROR("Read " << frameList->GetNumberOfTrackedFrames() << " frames instead of " << numberOfFrames);
+      return PLUS_FAIL;
+    }
+    for (unsigned int i = 0; i < numberOfFrames; ++i)
+    {
+      if (CheckFrame(*frameList->GetTrackedFrame(i), firstFrameIndex + i, frameSize, framePeriodSec) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+#endif  //__PlusTestFrames_h
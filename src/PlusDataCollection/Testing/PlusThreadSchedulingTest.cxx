@@ -0,0 +1,117 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusThreadSchedulingTest.cxx
+  \brief Test parsing of CPU lists and setting the CPU affinity of the data capture threads
+
+  Real-time scheduling policies require privileges that are usually not available on test machines,
+  they can be tested by the --scheduling-policy argument.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusThreadScheduling.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <thread>
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  PlusStatus TestParseCpuList()
+  {
+    std::vector<int> cpuIds;
+    if (ThreadScheduling::ParseCpuList(" 0, 2 3,5 ", cpuIds) != PLUS_SUCCESS || ThreadScheduling::CpuListToString(cpuIds) != "0 2 3 5")
+    {
+      LOG_ERROR("Failed to parse valid CPU list");
+      return PLUS_FAIL;
+    }
+    if (ThreadScheduling::ParseCpuList("", cpuIds) != PLUS_SUCCESS || !cpuIds.empty())
+    {
+      LOG_ERROR("Failed to parse empty CPU list");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  std::string schedulingPolicy;
+  int priority(50);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--scheduling-policy", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &schedulingPolicy, "Real-time scheduling policy to test (FIFO or RR).");
+  args.AddArgument("--priority", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &priority, "Real-time priority to test (default: 50).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestParseCpuList() != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+#if defined(__linux__)
+  ThreadScheduling::SchedulingPolicy policy = ThreadScheduling::SCHEDULING_POLICY_DEFAULT;
+  if (STRCASECMP(schedulingPolicy.c_str(), "FIFO") == 0)
+  {
+    policy = ThreadScheduling::SCHEDULING_POLICY_FIFO;
+  }
+  else if (STRCASECMP(schedulingPolicy.c_str(), "RR") == 0)
+  {
+    policy = ThreadScheduling::SCHEDULING_POLICY_RR;
+  }
+
+  // Scheduling is applied to a separate thread, as in the data capture threads of the devices
+  PlusStatus status = PLUS_FAIL;
+  std::string achievedScheduling;
+  std::thread thread([&]()
+  {
+    std::vector<int> cpuAffinity(1, 0);
+    status = ThreadScheduling::ApplyToCurrentThread(cpuAffinity, policy, priority, false);
+    achievedScheduling = ThreadScheduling::GetCurrentThreadScheduling();
+  });
+  thread.join();
+
+  LOG_INFO("Achieved scheduling: " << achievedScheduling);
+  if (status != PLUS_SUCCESS || achievedScheduling.find("CPUs: 0") == std::string::npos
+      || achievedScheduling.find("CPUs: 0 ") != std::string::npos)
+  {
+    LOG_ERROR("Thread is not pinned to CPU 0");
+    return EXIT_FAILURE;
+  }
+  if (policy != ThreadScheduling::SCHEDULING_POLICY_DEFAULT
+      && achievedScheduling.find(policy == ThreadScheduling::SCHEDULING_POLICY_FIFO ? "SCHED_FIFO" : "SCHED_RR") == std::string::npos)
+  {
+    LOG_ERROR("Real-time scheduling policy is not applied");
+    return EXIT_FAILURE;
+  }
+#endif
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
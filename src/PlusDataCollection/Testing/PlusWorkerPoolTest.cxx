@@ -0,0 +1,185 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file PlusWorkerPoolTest.cxx
+  \brief Test that the worker pool executes each task of a job exactly once
+
+  Jobs are run from multiple threads at the same time (only one of them can use the workers, the others
+  run their tasks on the calling thread) while the number of threads of the pool is changed.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusWorkerPool.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <atomic>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const int NUMBER_OF_TASKS = 37;
+
+  //----------------------------------------------------------------------------
+  /*! Run a job and check that all tasks are completed exactly once when Run returns */
+  PlusStatus RunJob(WorkerPool& pool, std::set<std::thread::id>* taskThreadIds = NULL)
+  {
+    std::vector<std::atomic<int> > executionCounts(NUMBER_OF_TASKS);
+    for (int i = 0; i < NUMBER_OF_TASKS; ++i)
+    {
+      executionCounts[i] = 0;
+    }
+    std::vector<std::thread::id> threadIds(NUMBER_OF_TASKS);
+    pool.Run(NUMBER_OF_TASKS, [&](int task)
+    {
+      executionCounts[task]++;
+      threadIds[task] = std::this_thread::get_id();
+      // Give the other threads a chance to pick up tasks
+      std::this_thread::yield();
+    });
+    for (int i = 0; i < NUMBER_OF_TASKS; ++i)
+    {
+      if (executionCounts[i] != 1)
+      {
+        LOG_ERROR("Task " << i << " is executed " << executionCounts[i] << " times, expected once");
+        return PLUS_FAIL;
+      }
+    }
+    if (taskThreadIds != NULL)
+    {
+      taskThreadIds->insert(threadIds.begin(), threadIds.end());
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestSingleCaller()
+  {
+    WorkerPool pool;
+    if (pool.GetNumberOfThreads() != 1)
+    {
+      LOG_ERROR("Number of threads is " << pool.GetNumberOfThreads() << ", expected 1");
+      return PLUS_FAIL;
+    }
+
+    // Without workers all tasks run on the calling thread
+    std::set<std::thread::id> taskThreadIds;
+    if (RunJob(pool, &taskThreadIds) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (taskThreadIds.size() != 1 || *taskThreadIds.begin() != std::this_thread::get_id())
+    {
+      LOG_ERROR("Tasks of a pool without workers are not executed on the calling thread");
+      return PLUS_FAIL;
+    }
+
+    const int numberOfThreads[] = { 4, 2, 4, 1, 3 };
+    for (size_t i = 0; i < sizeof(numberOfThreads) / sizeof(numberOfThreads[0]); ++i)
+    {
+      if (pool.SetNumberOfThreads(numberOfThreads[i]) != PLUS_SUCCESS || pool.GetNumberOfThreads() != numberOfThreads[i])
+      {
+        LOG_ERROR("Failed to set the number of threads to " << numberOfThreads[i]);
+        return PLUS_FAIL;
+      }
+      for (int job = 0; job < 100; ++job)
+      {
+        if (RunJob(pool) != PLUS_SUCCESS)
+        {
+          LOG_ERROR("Job " << job << " failed with " << numberOfThreads[i] << " threads");
+          return PLUS_FAIL;
+        }
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestConcurrentCallers()
+  {
+    const int NUMBER_OF_CALLERS = 4;
+    const int NUMBER_OF_JOBS = 200;
+    WorkerPool pool;
+    pool.SetNumberOfThreads(3);
+
+    std::atomic<int> numberOfFailedJobs(0);
+    std::vector<std::thread> callers;
+    for (int i = 0; i < NUMBER_OF_CALLERS; ++i)
+    {
+      callers.push_back(std::thread([&]()
+      {
+        for (int job = 0; job < NUMBER_OF_JOBS; ++job)
+        {
+          if (RunJob(pool) != PLUS_SUCCESS)
+          {
+            numberOfFailedJobs++;
+          }
+        }
+      }));
+    }
+    // Resize the pool while the callers are running jobs
+    for (int i = 0; i < 20; ++i)
+    {
+      pool.SetNumberOfThreads(2 + i % 3);
+    }
+    for (size_t i = 0; i < callers.size(); ++i)
+    {
+      callers[i].join();
+    }
+
+    if (numberOfFailedJobs > 0)
+    {
+      LOG_ERROR(numberOfFailedJobs << " jobs failed with concurrent callers");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestSingleCaller() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Single caller test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestConcurrentCallers() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Concurrent callers test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -33,6 +33,7 @@ int main(int argc, char** argv)
   int inputAveragedItemsForFiltering(20);
   double inputMaxTimestampDifference(0.080);
   double inputMinStdevReductionFactor(3.0);
+  double inputMaxIncrementalFilteringDifference(1e-6);
   std::string inputTransformName;
 
   int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
@@ -46,6 +47,7 @@ int main(int argc, char** argv)
   args.AddArgument("--averaged-items-for-filtering", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputAveragedItemsForFiltering, "Number of averaged items used for filtering (Default: 20).");
   args.AddArgument("--max-timestamp-difference", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputMaxTimestampDifference, "The maximum difference between the filtered and nonfiltered timestamps for each frame (Default: 0.08s).");
   args.AddArgument("--min-stdev-reduction-factor", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputMinStdevReductionFactor, "Minimum factor that the filtering should reduces the standard deviation of the frame periods on filtered data (Default: 3.0 ).");
+  args.AddArgument("--max-incremental-filtering-difference", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &inputMaxIncrementalFilteringDifference, "The maximum difference between the filtered timestamps computed by incremental and by full line fitting (Default: 1e-6s).");
   args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
 
   if (!args.Parse())
@@ -95,6 +97,15 @@ int main(int argc, char** argv)
     numberOfErrors++;
   }
 
+  LOG_INFO("Copy buffer to reference tracker buffer (without incremental filtering)...");
+  vtkSmartPointer<vtkPlusBuffer> referenceTrackerBuffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  referenceTrackerBuffer->SetIncrementalTimestampFiltering(false);
+  if (referenceTrackerBuffer->CopyTransformFromTrackedFrameList(trackerFrameList, vtkPlusBuffer::READ_UNFILTERED_COMPUTE_FILTERED_TIMESTAMPS, transformName) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("CopyDefaultTrackerDataToBuffer failed for the reference buffer");
+    numberOfErrors++;
+  }
+
   // Check filtering results
   //************************
 
@@ -177,6 +188,41 @@ int main(int argc, char** argv)
     numberOfErrors++;
   }
 
+  // 3. The filtered timestamps computed by the incremental line fitting shall be the same as the ones computed by full line fitting (within numerical precision)
+  if (referenceTrackerBuffer->GetNumberOfItems() != trackerBuffer->GetNumberOfItems())
+  {
+    LOG_ERROR("Number of items in the reference buffer (" << referenceTrackerBuffer->GetNumberOfItems() << ") does not match the number of items in the buffer (" << trackerBuffer->GetNumberOfItems() << ")");
+    numberOfErrors++;
+  }
+  double maxIncrementalFilteringDifference(0);
+  for (BufferItemUidType item = trackerBuffer->GetOldestItemUidInBuffer(); item <= trackerBuffer->GetLatestItemUidInBuffer(); ++item)
+  {
+    double filteredTimestamp(0);
+    double referenceFilteredTimestamp(0);
+    if (trackerBuffer->GetTimeStamp(item, filteredTimestamp) != ITEM_OK
+        || referenceTrackerBuffer->GetTimeStamp(item, referenceFilteredTimestamp) != ITEM_OK)
+    {
+      LOG_ERROR("Failed to get filtered timestamps of buffer item with UID: " << item);
+      numberOfErrors++;
+      continue;
+    }
+    double incrementalFilteringDifference = fabs(filteredTimestamp - referenceFilteredTimestamp);
+    if (incrementalFilteringDifference > maxIncrementalFilteringDifference)
+    {
+      maxIncrementalFilteringDifference = incrementalFilteringDifference;
+    }
+    if (incrementalFilteringDifference > inputMaxIncrementalFilteringDifference)
+    {
+      LOG_ERROR("Difference between the incrementally and fully filtered timestamps is higher than the threshold (UID: " << item
+                << ", filteredTimestamp: " << std::fixed << filteredTimestamp
+                << ", referenceFilteredTimestamp: " << std::fixed << referenceFilteredTimestamp
+                << ", timestamp diference: " << incrementalFilteringDifference << ", threshold: " << inputMaxIncrementalFilteringDifference << ")");
+      numberOfErrors++;
+    }
+  }
+
+  LOG_INFO("Maximum incrementally and fully filtered timestamp difference: " << maxIncrementalFilteringDifference * 1000 << "ms");
+
 
   vtkSmartPointer<vtkTable> timestampReportTable = vtkSmartPointer<vtkTable>::New();
   if (trackerBuffer->GetTimeStampReportTable(timestampReportTable) != PLUS_SUCCESS)
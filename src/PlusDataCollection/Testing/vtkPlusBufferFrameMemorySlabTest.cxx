@@ -0,0 +1,193 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferFrameMemorySlabTest.cxx
+  \brief Test that buffer frames can be stored in one contiguous, page-aligned memory block
+
+  The pixel data of all frames must be stored in the slab, frame contents must be preserved
+  when the buffer is resized, and the buffer must keep working after the slab is disabled.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusFrameMemorySlab.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+  const int BUFFER_SIZE = 8;
+  const unsigned int FRAME_WIDTH = 30;
+  const unsigned int FRAME_HEIGHT = 20;
+  const size_t FRAME_SIZE_IN_BYTES = FRAME_WIDTH * FRAME_HEIGHT;
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddFrame(vtkPlusBuffer* buffer, int frameNumber)
+  {
+    std::vector<unsigned char> pixels(FRAME_SIZE_IN_BYTES, static_cast<unsigned char>(frameNumber));
+    FrameSizeType frameSize = { FRAME_WIDTH, FRAME_HEIGHT, 1 };
+    std::array<int, 3> clipRectangleOrigin = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    std::array<int, 3> clipRectangleSize = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    return buffer->AddItem(&pixels[0], US_IMG_ORIENT_MF, frameSize, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber,
+                           clipRectangleOrigin, clipRectangleSize, frameNumber, frameNumber);
+  }
+
+  //----------------------------------------------------------------------------
+  // Checks that each item in the buffer contains the pixel values that were added, returns the pixel data pointers
+  PlusStatus CheckFrames(vtkPlusBuffer* buffer, std::vector<unsigned char*>& pixelPointers)
+  {
+    pixelPointers.clear();
+    for (BufferItemUidType uid = buffer->GetOldestItemUidInBuffer(); uid <= buffer->GetLatestItemUidInBuffer(); ++uid)
+    {
+      StreamBufferItemView view;
+      if (buffer->GetStreamBufferItemView(uid, view) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid);
+        return PLUS_FAIL;
+      }
+      unsigned char* pixels = static_cast<unsigned char*>(view.GetItem()->GetFrame().GetScalarPointer());
+      const unsigned char expectedValue = static_cast<unsigned char>(view.GetItem()->GetIndex());
+      for (size_t i = 0; i < FRAME_SIZE_IN_BYTES; ++i)
+      {
+        if (pixels[i] != expectedValue)
+        {
+          LOG_ERROR("Item " << uid << " pixel " << i << " value is " << static_cast<int>(pixels[i]) << ", expected " << static_cast<int>(expectedValue));
+          return PLUS_FAIL;
+        }
+      }
+      pixelPointers.push_back(pixels);
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  // Checks that all frames are stored in one contiguous, page-aligned block
+  PlusStatus CheckContiguous(const std::vector<unsigned char*>& pixelPointers)
+  {
+    unsigned char* slabStart = pixelPointers[0];
+    for (size_t i = 1; i < pixelPointers.size(); ++i)
+    {
+      slabStart = std::min(slabStart, pixelPointers[i]);
+    }
+    if (reinterpret_cast<size_t>(slabStart) % FrameMemorySlab::GetPageSize() != 0)
+    {
+      LOG_ERROR("Frame memory is not page-aligned");
+      return PLUS_FAIL;
+    }
+    const size_t maxSlabSize = (FRAME_SIZE_IN_BYTES + 63) / 64 * 64 * pixelPointers.size();
+    for (size_t i = 0; i < pixelPointers.size(); ++i)
+    {
+      if (pixelPointers[i] + FRAME_SIZE_IN_BYTES > slabStart + maxSlabSize)
+      {
+        LOG_ERROR("Frame " << i << " is not stored in the contiguous frame memory");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  bool useHugePages(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--huge-pages", vtksys::CommandLineArguments::NO_ARGUMENT, &useHugePages, "Request huge pages for the frame memory.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  buffer->SetBufferSize(BUFFER_SIZE);
+  buffer->SetFrameMemoryHugePages(useHugePages);
+  if (buffer->SetContiguousFrameMemory(true) != PLUS_SUCCESS
+      || buffer->SetFrameSize(FRAME_WIDTH, FRAME_HEIGHT, 1) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to allocate contiguous frame memory");
+    return EXIT_FAILURE;
+  }
+
+  // Fill the buffer and wrap around
+  int frameNumber = 1;
+  for (; frameNumber <= BUFFER_SIZE + BUFFER_SIZE / 2; ++frameNumber)
+  {
+    if (AddFrame(buffer, frameNumber) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameNumber);
+      return EXIT_FAILURE;
+    }
+  }
+  std::vector<unsigned char*> pixelPointers;
+  if (CheckFrames(buffer, pixelPointers) != PLUS_SUCCESS || CheckContiguous(pixelPointers) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Frame contents must be kept when the slab is reallocated
+  if (buffer->SetBufferSize(BUFFER_SIZE * 2) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to resize the buffer");
+    return EXIT_FAILURE;
+  }
+  for (; frameNumber <= BUFFER_SIZE * 3; ++frameNumber)
+  {
+    if (AddFrame(buffer, frameNumber) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameNumber << " after resizing the buffer");
+      return EXIT_FAILURE;
+    }
+  }
+  if (CheckFrames(buffer, pixelPointers) != PLUS_SUCCESS || CheckContiguous(pixelPointers) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  // Frames are allocated individually again when the slab is disabled
+  if (buffer->SetContiguousFrameMemory(false) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to disable contiguous frame memory");
+    return EXIT_FAILURE;
+  }
+  buffer->Clear();
+  for (int i = 0; i < BUFFER_SIZE; ++i, ++frameNumber)
+  {
+    if (AddFrame(buffer, frameNumber) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add frame " << frameNumber << " after disabling contiguous frame memory");
+      return EXIT_FAILURE;
+    }
+  }
+  if (CheckFrames(buffer, pixelPointers) != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,155 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferItemViewTest.cxx
+  \brief Test that buffer item views pin their slots in the circular buffer
+
+  Items referred to by a view must not be overwritten by new items, copying a view must keep the item pinned,
+  and the buffer must accept new items again once all views are released.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+namespace
+{
+  const int BUFFER_SIZE = 5;
+  const char VALUE_FIELD_NAME[] = "Value";
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddFieldItem(vtkPlusBuffer* buffer, int value)
+  {
+    igsioFieldMapType fields;
+    std::ostringstream valueStr;
+    valueStr << value;
+    fields[VALUE_FIELD_NAME].first = FRAMEFIELD_NONE;
+    fields[VALUE_FIELD_NAME].second = valueStr.str();
+    return buffer->AddItem(fields, value, value, value);
+  }
+
+  //----------------------------------------------------------------------------
+  bool ViewHasValue(const StreamBufferItemView& view, int value)
+  {
+    if (!view.IsValid())
+    {
+      return false;
+    }
+    std::ostringstream valueStr;
+    valueStr << value;
+    return view.GetItem()->GetFrameField(VALUE_FIELD_NAME) == valueStr.str();
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  buffer->SetBufferSize(BUFFER_SIZE);
+
+  int value = 1;
+  for (; value <= BUFFER_SIZE; ++value)
+  {
+    if (AddFieldItem(buffer, value) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add item " << value << " to the buffer");
+      return EXIT_FAILURE;
+    }
+  }
+
+  // Pin the oldest item, twice
+  StreamBufferItemView oldestView;
+  if (buffer->GetStreamBufferItemView(buffer->GetOldestItemUidInBuffer(), oldestView) != ITEM_OK || !ViewHasValue(oldestView, 1))
+  {
+    LOG_ERROR("Failed to get a view of the oldest item");
+    return EXIT_FAILURE;
+  }
+  StreamBufferItemView oldestViewCopy(oldestView);
+
+  // The buffer is full and the next slot is pinned, so no new item can be added
+  if (AddFieldItem(buffer, value) == PLUS_SUCCESS)
+  {
+    LOG_ERROR("An item was added to the buffer while the slot to be overwritten is pinned");
+    return EXIT_FAILURE;
+  }
+  oldestView.Release();
+  if (AddFieldItem(buffer, value) == PLUS_SUCCESS)
+  {
+    LOG_ERROR("An item was added to the buffer while the copy of a view still pins the slot to be overwritten");
+    return EXIT_FAILURE;
+  }
+  if (!ViewHasValue(oldestViewCopy, 1))
+  {
+    LOG_ERROR("Pinned item was modified");
+    return EXIT_FAILURE;
+  }
+  oldestViewCopy.Release();
+  if (AddFieldItem(buffer, value) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to add item " << value << " to the buffer after all views are released");
+    return EXIT_FAILURE;
+  }
+
+  // Copy on demand: the copy must be kept intact after its slot is recycled
+  StreamBufferItem copiedItem;
+  {
+    StreamBufferItemView latestView;
+    if (buffer->GetStreamBufferItemViewFromTime(value, latestView) != ITEM_OK || !ViewHasValue(latestView, value))
+    {
+      LOG_ERROR("Failed to get a view of the item at time " << value);
+      return EXIT_FAILURE;
+    }
+    if (latestView.DeepCopyTo(&copiedItem) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to copy the item referred by the view");
+      return EXIT_FAILURE;
+    }
+  }
+  const int copiedValue = value;
+  for (++value; value <= copiedValue + BUFFER_SIZE; ++value)
+  {
+    if (AddFieldItem(buffer, value) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add item " << value << " to the buffer");
+      return EXIT_FAILURE;
+    }
+  }
+  std::ostringstream copiedValueStr;
+  copiedValueStr << copiedValue;
+  if (copiedItem.GetFrameField(VALUE_FIELD_NAME) != copiedValueStr.str())
+  {
+    LOG_ERROR("Copied item changed after its slot was recycled");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
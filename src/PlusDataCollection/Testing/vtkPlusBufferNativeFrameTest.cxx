@@ -0,0 +1,231 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferNativeFrameTest.cxx
+  \brief Test that frames added in their native pixel encoding are converted on first read
+
+  Frames must not be converted when they are added, the converted pixels must be the same as
+  the result of the immediate conversion, and each frame must be converted only once.
+*/
+
+#include "PlusConfigure.h"
+#include "PixelCodec.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <vector>
+
+namespace
+{
+  const int BUFFER_SIZE = 5;
+  const unsigned int FRAME_WIDTH = 32;
+  const unsigned int FRAME_HEIGHT = 16;
+  const int NUMBER_OF_FRAMES = 3;
+
+  //----------------------------------------------------------------------------
+  void CreateYuy2Frame(int frameNumber, std::vector<unsigned char>& yuy2Frame)
+  {
+    yuy2Frame.resize(FRAME_WIDTH * FRAME_HEIGHT * 2);
+    for (size_t i = 0; i < yuy2Frame.size(); ++i)
+    {
+      yuy2Frame[i] = static_cast<unsigned char>((i * 7 + frameNumber * 31) % 256);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddNativeFrame(vtkPlusBuffer* buffer, int frameNumber, US_IMAGE_ORIENTATION orientation, US_IMAGE_TYPE imageType)
+  {
+    std::vector<unsigned char> yuy2Frame;
+    CreateYuy2Frame(frameNumber, yuy2Frame);
+    FrameSizeType frameSize = { FRAME_WIDTH, FRAME_HEIGHT, 1 };
+    std::array<int, 3> clipRectangleOrigin = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    std::array<int, 3> clipRectangleSize = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    return buffer->AddNativeItem(&yuy2Frame[0], static_cast<unsigned int>(yuy2Frame.size()), PixelCodec::GetFourCC(PixelCodec::PixelEncoding_YUY2),
+                                 orientation, frameSize, imageType, frameNumber, clipRectangleOrigin, clipRectangleSize, frameNumber, frameNumber);
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CheckFramePixels(StreamBufferItem* item, unsigned int numberOfScalarComponents)
+  {
+    std::vector<unsigned char> yuy2Frame;
+    CreateYuy2Frame(item->GetIndex(), yuy2Frame);
+    std::vector<unsigned char> expectedPixels(FRAME_WIDTH * FRAME_HEIGHT * numberOfScalarComponents);
+    if (numberOfScalarComponents == 1)
+    {
+      PixelCodec::ConvertToGray(PixelCodec::PixelEncoding_YUY2, FRAME_WIDTH, FRAME_HEIGHT, &yuy2Frame[0], &expectedPixels[0]);
+    }
+    else
+    {
+      PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, PixelCodec::PixelEncoding_YUY2, FRAME_WIDTH, FRAME_HEIGHT, &yuy2Frame[0], &expectedPixels[0]);
+    }
+
+    const unsigned char* pixels = static_cast<unsigned char*>(item->GetFrame().GetScalarPointer());
+    for (size_t i = 0; i < expectedPixels.size(); ++i)
+    {
+      if (pixels[i] != expectedPixels[i])
+      {
+        LOG_ERROR("Pixel " << i << " of frame " << item->GetIndex() << " is " << static_cast<int>(pixels[i]) << ", expected " << static_cast<int>(expectedPixels[i]));
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestLazyConversion(unsigned int numberOfScalarComponents)
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    const US_IMAGE_TYPE imageType = (numberOfScalarComponents == 1 ? US_IMG_BRIGHTNESS : US_IMG_RGB_COLOR);
+    buffer->SetBufferSize(BUFFER_SIZE);
+    buffer->SetImageOrientation(US_IMG_ORIENT_MF);
+    buffer->SetImageType(imageType);
+    buffer->SetPixelType(VTK_UNSIGNED_CHAR);
+    buffer->SetNumberOfScalarComponents(numberOfScalarComponents);
+    if (buffer->SetFrameSize(FRAME_WIDTH, FRAME_HEIGHT, 1) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set up the buffer");
+      return PLUS_FAIL;
+    }
+
+    for (int frameNumber = 1; frameNumber <= NUMBER_OF_FRAMES; ++frameNumber)
+    {
+      if (AddNativeFrame(buffer, frameNumber, US_IMG_ORIENT_MF, imageType) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add native frame " << frameNumber);
+        return PLUS_FAIL;
+      }
+    }
+    if (buffer->GetNumberOfNativeFrameConversions() != 0)
+    {
+      LOG_ERROR("Native frames are converted when they are added to the buffer");
+      return PLUS_FAIL;
+    }
+
+    // Copying an item converts only that item
+    StreamBufferItem item;
+    if (buffer->GetLatestStreamBufferItem(&item) != ITEM_OK || CheckFramePixels(&item, numberOfScalarComponents) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read the latest frame");
+      return PLUS_FAIL;
+    }
+    if (buffer->GetNumberOfNativeFrameConversions() != 1)
+    {
+      LOG_ERROR("Number of conversions after the first read is " << buffer->GetNumberOfNativeFrameConversions() << ", expected 1");
+      return PLUS_FAIL;
+    }
+
+    // Reading the same item again uses the converted pixels
+    StreamBufferItemView view;
+    if (buffer->GetLatestStreamBufferItemView(view) != ITEM_OK || CheckFramePixels(view.GetItem(), numberOfScalarComponents) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read the latest frame again");
+      return PLUS_FAIL;
+    }
+    view.Release();
+    if (buffer->GetNumberOfNativeFrameConversions() != 1)
+    {
+      LOG_ERROR("Number of conversions after reading the same frame again is " << buffer->GetNumberOfNativeFrameConversions() << ", expected 1");
+      return PLUS_FAIL;
+    }
+
+    // Views convert the referenced item, too
+    if (buffer->GetStreamBufferItemView(buffer->GetOldestItemUidInBuffer(), view) != ITEM_OK || CheckFramePixels(view.GetItem(), numberOfScalarComponents) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read the oldest frame");
+      return PLUS_FAIL;
+    }
+    view.Release();
+    if (buffer->GetNumberOfNativeFrameConversions() != 2)
+    {
+      LOG_ERROR("Number of conversions after reading two frames is " << buffer->GetNumberOfNativeFrameConversions() << ", expected 2");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestImmediateConversionOfReorientedFrames()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetBufferSize(BUFFER_SIZE);
+    buffer->SetImageOrientation(US_IMG_ORIENT_MF);
+    buffer->SetImageType(US_IMG_BRIGHTNESS);
+    buffer->SetPixelType(VTK_UNSIGNED_CHAR);
+    buffer->SetNumberOfScalarComponents(1);
+    if (buffer->SetFrameSize(FRAME_WIDTH, FRAME_HEIGHT, 1) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set up the buffer");
+      return PLUS_FAIL;
+    }
+
+    if (AddNativeFrame(buffer, 1, US_IMG_ORIENT_MN, US_IMG_BRIGHTNESS) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to add native frame that has to be reoriented");
+      return PLUS_FAIL;
+    }
+    StreamBufferItem item;
+    if (buffer->GetLatestStreamBufferItem(&item) != ITEM_OK || item.HasUnconvertedNativeFrame())
+    {
+      LOG_ERROR("Frame that has to be reoriented is not converted when it is added");
+      return PLUS_FAIL;
+    }
+    if (buffer->GetNumberOfNativeFrameConversions() != 0)
+    {
+      LOG_ERROR("Frame that has to be reoriented is converted on read");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestLazyConversion(1) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Lazy conversion to grayscale test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestLazyConversion(3) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Lazy conversion to RGB test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestImmediateConversionOfReorientedFrames() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Immediate conversion of reoriented frames test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
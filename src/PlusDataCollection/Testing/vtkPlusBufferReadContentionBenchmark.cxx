@@ -0,0 +1,179 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferReadContentionBenchmark.cxx
+  \brief Measure UID and timestamp query throughput of a buffer while a writer thread keeps adding items
+
+  The measurement is performed with locked and with lock-free reading, for 1 to the specified maximum number of reader threads.
+  Each query is validated: the UID that is found from the timestamp of an item must be the UID of the item.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+
+// STL includes
+#include <atomic>
+#include <iomanip>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const double ITEM_PERIOD_SEC = 0.001;
+
+  //----------------------------------------------------------------------------
+  void WriterThread(vtkPlusBuffer* buffer, std::atomic<bool>* stopRequested, double writerPeriodSec)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    unsigned long frameNumber = 0;
+    while (!stopRequested->load())
+    {
+      ++frameNumber;
+      // Timestamps are generated so that they are strictly increasing, independently from the writer speed
+      double timestamp = frameNumber * ITEM_PERIOD_SEC;
+      buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp);
+      if (writerPeriodSec > 0)
+      {
+        vtkIGSIOAccurateTimer::Delay(writerPeriodSec);
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  void ReaderThread(vtkPlusBuffer* buffer, std::atomic<bool>* stopRequested, unsigned long long* numberOfQueries, unsigned long long* numberOfMismatches)
+  {
+    unsigned long long queries = 0;
+    unsigned long long mismatches = 0;
+    while (!stopRequested->load())
+    {
+      BufferItemUidType latestUid = buffer->GetLatestItemUidInBuffer();
+      BufferItemUidType oldestUid = buffer->GetOldestItemUidInBuffer();
+      BufferItemUidType uid = oldestUid + (latestUid - oldestUid) * (queries % 8) / 8;
+      double timestamp(0);
+      BufferItemUidType foundUid(0);
+      queries += 3;
+      if (buffer->GetTimeStamp(uid, timestamp) != ITEM_OK)
+      {
+        // the item was overwritten since the UID query
+        continue;
+      }
+      ++queries;
+      if (buffer->GetItemUidFromTime(timestamp, foundUid) == ITEM_OK && foundUid != uid)
+      {
+        ++mismatches;
+      }
+    }
+    *numberOfQueries = queries;
+    *numberOfMismatches = mismatches;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int maxNumberOfReaderThreads(16);
+  double durationSec(1.0);
+  double writerPeriodSec(0.001);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--max-reader-threads", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maxNumberOfReaderThreads, "Maximum number of reader threads. Measurements are performed with 1, 2, 4, ... threads up to this number (Default: 16).");
+  args.AddArgument("--duration-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &durationSec, "Duration of each measurement in seconds (Default: 1.0).");
+  args.AddArgument("--writer-period-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &writerPeriodSec, "Time between adding items to the buffer in seconds, 0 means as fast as possible (Default: 0.001).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  for (int lockFree = 0; lockFree <= 1; ++lockFree)
+  {
+    for (int numberOfReaderThreads = 1; numberOfReaderThreads <= maxNumberOfReaderThreads; numberOfReaderThreads *= 2)
+    {
+      vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+      buffer->SetLockFreeReading(lockFree != 0);
+
+      std::atomic<bool> stopRequested(false);
+      std::thread writer(WriterThread, buffer.GetPointer(), &stopRequested, writerPeriodSec);
+      // Wait for the first item, so that readers always find items in the buffer
+      while (buffer->GetNumberOfItems() < 1)
+      {
+        vtkIGSIOAccurateTimer::Delay(0.001);
+      }
+
+      std::vector<unsigned long long> numberOfQueries(numberOfReaderThreads, 0);
+      std::vector<unsigned long long> numberOfMismatches(numberOfReaderThreads, 0);
+      std::vector<std::thread> readers;
+      // Items added while waiting for the first item and while the threads are stopped are not counted
+      const BufferItemUidType startUid = buffer->GetLatestItemUidInBuffer();
+      double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      for (int i = 0; i < numberOfReaderThreads; ++i)
+      {
+        readers.push_back(std::thread(ReaderThread, buffer.GetPointer(), &stopRequested, &numberOfQueries[i], &numberOfMismatches[i]));
+      }
+      vtkIGSIOAccurateTimer::Delay(durationSec);
+      const BufferItemUidType stopUid = buffer->GetLatestItemUidInBuffer();
+      const double writingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+      stopRequested = true;
+      for (int i = 0; i < numberOfReaderThreads; ++i)
+      {
+        readers[i].join();
+      }
+      double elapsedTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+      writer.join();
+
+      unsigned long long totalQueries = 0;
+      unsigned long long totalMismatches = 0;
+      for (int i = 0; i < numberOfReaderThreads; ++i)
+      {
+        totalQueries += numberOfQueries[i];
+        totalMismatches += numberOfMismatches[i];
+      }
+
+      LOG_INFO((lockFree ? "Lock-free" : "Locked") << " reading, " << numberOfReaderThreads << " reader threads: "
+               << std::fixed << std::setprecision(0) << totalQueries / elapsedTimeSec << " queries/sec, "
+               << totalQueries / elapsedTimeSec / numberOfReaderThreads << " queries/sec/thread, "
+               << (stopUid - startUid) / writingTimeSec << " items added/sec");
+
+      if (totalMismatches > 0)
+      {
+        LOG_ERROR((lockFree ? "Lock-free" : "Locked") << " reading, " << numberOfReaderThreads << " reader threads: "
+                  << totalMismatches << " queries returned an inconsistent item UID");
+        numberOfErrors++;
+      }
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
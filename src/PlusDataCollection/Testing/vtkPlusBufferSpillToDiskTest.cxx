@@ -0,0 +1,415 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferSpillToDiskTest.cxx
+  \brief Test that items removed from a buffer can be retrieved from the spill files on disk
+
+  Tracker items must be retrievable by UID and timestamp (including interpolation) after they are
+  removed from the buffer, video frames must keep their pixel data, and the oldest spilled items
+  must be deleted when the maximum spill size is reached. Native frames must be converted when a
+  spilled frame is read and encoded frames must keep their encoded data and the frames they depend on.
+*/
+
+#include "PlusConfigure.h"
+#include "PixelCodec.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkStreamingVolumeFrame.h>
+#include <vtkUnsignedCharArray.h>
+
+// STL includes
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+  const int BUFFER_SIZE = 10;
+  const int NUMBER_OF_TRACKER_ITEMS = 200;
+  const unsigned int FRAME_WIDTH = 512;
+  const unsigned int FRAME_HEIGHT = 512;
+  const size_t FRAME_SIZE_IN_BYTES = FRAME_WIDTH * FRAME_HEIGHT;
+  const int SPILL_SEGMENT_SIZE_MB = 1;
+  const int SPILL_MAX_SIZE_MB = 2;
+  const double TIME_TOLERANCE = 1e-6;
+  const unsigned int SMALL_FRAME_WIDTH = 32;
+  const unsigned int SMALL_FRAME_HEIGHT = 16;
+  const int NUMBER_OF_SMALL_FRAMES = 3 * BUFFER_SIZE;
+  const int KEY_FRAME_INTERVAL = 4;
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddFrame(vtkPlusBuffer* buffer, int frameNumber)
+  {
+    std::vector<unsigned char> pixels(FRAME_SIZE_IN_BYTES, static_cast<unsigned char>(frameNumber));
+    FrameSizeType frameSize = { FRAME_WIDTH, FRAME_HEIGHT, 1 };
+    std::array<int, 3> clipRectangleOrigin = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    std::array<int, 3> clipRectangleSize = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    return buffer->AddItem(&pixels[0], US_IMG_ORIENT_MF, frameSize, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber,
+                           clipRectangleOrigin, clipRectangleSize, frameNumber, frameNumber);
+  }
+
+  //----------------------------------------------------------------------------
+  void CreateYuy2Frame(int frameNumber, std::vector<unsigned char>& yuy2Frame)
+  {
+    yuy2Frame.resize(SMALL_FRAME_WIDTH * SMALL_FRAME_HEIGHT * 2);
+    for (size_t i = 0; i < yuy2Frame.size(); ++i)
+    {
+      yuy2Frame[i] = static_cast<unsigned char>((i * 7 + frameNumber * 31) % 256);
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Every KEY_FRAME_INTERVAL-th frame is a key frame, the encoded data is filled with the frame number
+  vtkSmartPointer<vtkStreamingVolumeFrame> CreateEncodedFrame(int frameNumber)
+  {
+    vtkSmartPointer<vtkUnsignedCharArray> frameData = vtkSmartPointer<vtkUnsignedCharArray>::New();
+    frameData->SetNumberOfValues(100 + frameNumber);
+    for (vtkIdType i = 0; i < frameData->GetNumberOfValues(); ++i)
+    {
+      frameData->SetValue(i, static_cast<unsigned char>(frameNumber));
+    }
+    vtkSmartPointer<vtkStreamingVolumeFrame> encodedFrame = vtkSmartPointer<vtkStreamingVolumeFrame>::New();
+    encodedFrame->SetFrameData(frameData);
+    encodedFrame->SetFrameType(frameNumber % KEY_FRAME_INTERVAL == 1 ? vtkStreamingVolumeFrame::IFrame : vtkStreamingVolumeFrame::PFrame);
+    encodedFrame->SetCodecFourCC("VP90");
+    int dimensions[3] = { static_cast<int>(SMALL_FRAME_WIDTH), static_cast<int>(SMALL_FRAME_HEIGHT), 1 };
+    encodedFrame->SetDimensions(dimensions);
+    encodedFrame->SetNumberOfComponents(1);
+    return encodedFrame;
+  }
+
+  //----------------------------------------------------------------------------
+  // Tracker items are translated along the X axis by their frame number
+  PlusStatus TestTrackerItems()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetBufferSize(BUFFER_SIZE);
+    // Items are added 1 second apart
+    buffer->SetMaxAllowedTimeDifference(1.0);
+    buffer->SetSpillSegmentSizeMB(SPILL_SEGMENT_SIZE_MB);
+    buffer->SetSpillMaxSizeMB(SPILL_MAX_SIZE_MB);
+    if (buffer->SetSpillToDisk(true) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to enable spilling to disk");
+      return PLUS_FAIL;
+    }
+
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int frameNumber = 1; frameNumber <= NUMBER_OF_TRACKER_ITEMS; ++frameNumber)
+    {
+      matrix->SetElement(0, 3, frameNumber);
+      if (buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, frameNumber, frameNumber) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add tracker item " << frameNumber);
+        return PLUS_FAIL;
+      }
+    }
+
+    if (buffer->GetNumberOfSpilledItems() != NUMBER_OF_TRACKER_ITEMS - BUFFER_SIZE)
+    {
+      LOG_ERROR("Number of spilled items is " << buffer->GetNumberOfSpilledItems() << ", expected " << NUMBER_OF_TRACKER_ITEMS - BUFFER_SIZE);
+      return PLUS_FAIL;
+    }
+
+    // Spilled items by UID
+    for (BufferItemUidType uid = 1; uid <= static_cast<BufferItemUidType>(NUMBER_OF_TRACKER_ITEMS); ++uid)
+    {
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(uid, &item) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get item " << uid);
+        return PLUS_FAIL;
+      }
+      double timestamp(0);
+      if (buffer->GetTimeStamp(uid, timestamp) != ITEM_OK || fabs(timestamp - uid) > TIME_TOLERANCE)
+      {
+        LOG_ERROR("Item " << uid << " timestamp is " << timestamp << ", expected " << uid);
+        return PLUS_FAIL;
+      }
+      item.GetMatrix(matrix);
+      if (item.GetUid() != uid || item.GetIndex() != uid || fabs(matrix->GetElement(0, 3) - uid) > TIME_TOLERANCE)
+      {
+        LOG_ERROR("Item " << uid << " content is not preserved (uid: " << item.GetUid() << ", index: " << item.GetIndex() << ", translation: " << matrix->GetElement(0, 3) << ")");
+        return PLUS_FAIL;
+      }
+    }
+
+    // Spilled items by timestamp, including interpolation between a spilled item and the oldest item in the buffer
+    const double requestedTimes[] = { 5.0, 42.3, 190.7 };
+    for (size_t i = 0; i < sizeof(requestedTimes) / sizeof(requestedTimes[0]); ++i)
+    {
+      StreamBufferItem closestItem;
+      if (buffer->GetStreamBufferItemFromTime(requestedTimes[i], &closestItem, vtkPlusBuffer::CLOSEST_TIME) != ITEM_OK
+          || closestItem.GetUid() != static_cast<BufferItemUidType>(floor(requestedTimes[i] + 0.5)))
+      {
+        LOG_ERROR("Failed to get the closest item at time " << requestedTimes[i]);
+        return PLUS_FAIL;
+      }
+      StreamBufferItem interpolatedItem;
+      if (buffer->GetStreamBufferItemFromTime(requestedTimes[i], &interpolatedItem, vtkPlusBuffer::INTERPOLATED) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get the interpolated item at time " << requestedTimes[i]);
+        return PLUS_FAIL;
+      }
+      interpolatedItem.GetMatrix(matrix);
+      if (fabs(matrix->GetElement(0, 3) - requestedTimes[i]) > TIME_TOLERANCE)
+      {
+        LOG_ERROR("Interpolated translation at time " << requestedTimes[i] << " is " << matrix->GetElement(0, 3));
+        return PLUS_FAIL;
+      }
+    }
+
+    // Spilled items are removed when the buffer is cleared
+    buffer->Clear();
+    if (buffer->GetNumberOfSpilledItems() != 0)
+    {
+      LOG_ERROR("Spilled items are not removed when the buffer is cleared");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestVideoFrames()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetBufferSize(BUFFER_SIZE);
+    buffer->SetSpillSegmentSizeMB(SPILL_SEGMENT_SIZE_MB);
+    buffer->SetSpillMaxSizeMB(SPILL_MAX_SIZE_MB);
+    if (buffer->SetFrameSize(FRAME_WIDTH, FRAME_HEIGHT, 1) != PLUS_SUCCESS || buffer->SetSpillToDisk(true) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set up video buffer");
+      return PLUS_FAIL;
+    }
+
+    // Many more frames than fit in the maximum spill size
+    const int numberOfFrames = BUFFER_SIZE + 4 * SPILL_MAX_SIZE_MB * 1024 * 1024 / static_cast<int>(FRAME_SIZE_IN_BYTES);
+    for (int frameNumber = 1; frameNumber <= numberOfFrames; ++frameNumber)
+    {
+      if (AddFrame(buffer, frameNumber) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add frame " << frameNumber);
+        return PLUS_FAIL;
+      }
+    }
+
+    const int numberOfSpilledItems = buffer->GetNumberOfSpilledItems();
+    if (numberOfSpilledItems <= 0 || static_cast<size_t>(numberOfSpilledItems) * FRAME_SIZE_IN_BYTES > static_cast<size_t>(SPILL_MAX_SIZE_MB) * 1024 * 1024)
+    {
+      LOG_ERROR("Number of spilled frames is " << numberOfSpilledItems << ", maximum spill size is not respected");
+      return PLUS_FAIL;
+    }
+
+    // The oldest frames are not available anymore
+    BufferItemUidType uid(0);
+    if (buffer->GetItemUidFromTime(1.0, uid) != ITEM_NOT_AVAILABLE_ANYMORE)
+    {
+      LOG_ERROR("The first frame is still available, the oldest spilled frames are not deleted");
+      return PLUS_FAIL;
+    }
+
+    // The newest spilled frames keep their pixel data
+    const BufferItemUidType oldestUidInBuffer = buffer->GetOldestItemUidInBuffer();
+    for (BufferItemUidType spilledUid = oldestUidInBuffer - numberOfSpilledItems; spilledUid < oldestUidInBuffer; ++spilledUid)
+    {
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(spilledUid, &item) != ITEM_OK)
+      {
+        LOG_ERROR("Failed to get spilled frame " << spilledUid);
+        return PLUS_FAIL;
+      }
+      const unsigned char* pixels = static_cast<const unsigned char*>(item.GetFrame().GetScalarPointer());
+      const unsigned char expectedValue = static_cast<unsigned char>(item.GetIndex());
+      if (pixels == NULL || item.GetFrame().GetFrameSizeInBytes() != FRAME_SIZE_IN_BYTES)
+      {
+        LOG_ERROR("Spilled frame " << spilledUid << " has no pixel data");
+        return PLUS_FAIL;
+      }
+      for (size_t i = 0; i < FRAME_SIZE_IN_BYTES; ++i)
+      {
+        if (pixels[i] != expectedValue)
+        {
+          LOG_ERROR("Spilled frame " << spilledUid << " pixel " << i << " value is " << static_cast<int>(pixels[i]) << ", expected " << static_cast<int>(expectedValue));
+          return PLUS_FAIL;
+        }
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestNativeFrames()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetBufferSize(BUFFER_SIZE);
+    buffer->SetSpillSegmentSizeMB(SPILL_SEGMENT_SIZE_MB);
+    buffer->SetSpillMaxSizeMB(SPILL_MAX_SIZE_MB);
+    if (buffer->SetFrameSize(SMALL_FRAME_WIDTH, SMALL_FRAME_HEIGHT, 1) != PLUS_SUCCESS || buffer->SetSpillToDisk(true) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set up native frame buffer");
+      return PLUS_FAIL;
+    }
+
+    FrameSizeType frameSize = { SMALL_FRAME_WIDTH, SMALL_FRAME_HEIGHT, 1 };
+    std::array<int, 3> clipRectangleOrigin = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    std::array<int, 3> clipRectangleSize = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    for (int frameNumber = 1; frameNumber <= NUMBER_OF_SMALL_FRAMES; ++frameNumber)
+    {
+      std::vector<unsigned char> yuy2Frame;
+      CreateYuy2Frame(frameNumber, yuy2Frame);
+      if (buffer->AddNativeItem(&yuy2Frame[0], static_cast<unsigned int>(yuy2Frame.size()), PixelCodec::GetFourCC(PixelCodec::PixelEncoding_YUY2),
+                                US_IMG_ORIENT_MF, frameSize, US_IMG_BRIGHTNESS, frameNumber, clipRectangleOrigin, clipRectangleSize, frameNumber, frameNumber) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add native frame " << frameNumber);
+        return PLUS_FAIL;
+      }
+    }
+    if (buffer->GetNumberOfNativeFrameConversions() != 0)
+    {
+      LOG_ERROR("Native frames are converted when they are spilled");
+      return PLUS_FAIL;
+    }
+
+    const BufferItemUidType oldestUidInBuffer = buffer->GetOldestItemUidInBuffer();
+    for (BufferItemUidType spilledUid = 1; spilledUid < oldestUidInBuffer; ++spilledUid)
+    {
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(spilledUid, &item) != ITEM_OK || item.HasUnconvertedNativeFrame())
+      {
+        LOG_ERROR("Failed to get converted spilled native frame " << spilledUid);
+        return PLUS_FAIL;
+      }
+      std::vector<unsigned char> yuy2Frame;
+      CreateYuy2Frame(item.GetIndex(), yuy2Frame);
+      std::vector<unsigned char> expectedPixels(SMALL_FRAME_WIDTH * SMALL_FRAME_HEIGHT);
+      PixelCodec::ConvertToGray(PixelCodec::PixelEncoding_YUY2, SMALL_FRAME_WIDTH, SMALL_FRAME_HEIGHT, &yuy2Frame[0], &expectedPixels[0]);
+      const unsigned char* pixels = static_cast<const unsigned char*>(item.GetFrame().GetScalarPointer());
+      if (pixels == NULL || memcmp(pixels, &expectedPixels[0], expectedPixels.size()) != 0)
+      {
+        LOG_ERROR("Spilled native frame " << spilledUid << " is not converted correctly");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestEncodedFrames()
+  {
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    buffer->SetBufferSize(BUFFER_SIZE);
+    buffer->SetSpillSegmentSizeMB(SPILL_SEGMENT_SIZE_MB);
+    buffer->SetSpillMaxSizeMB(SPILL_MAX_SIZE_MB);
+    if (buffer->SetFrameSize(SMALL_FRAME_WIDTH, SMALL_FRAME_HEIGHT, 1) != PLUS_SUCCESS || buffer->SetSpillToDisk(true) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set up encoded frame buffer");
+      return PLUS_FAIL;
+    }
+
+    FrameSizeType frameSize = { SMALL_FRAME_WIDTH, SMALL_FRAME_HEIGHT, 1 };
+    std::array<int, 3> clipRectangleOrigin = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    std::array<int, 3> clipRectangleSize = { igsioCommon::NO_CLIP, igsioCommon::NO_CLIP, igsioCommon::NO_CLIP };
+    for (int frameNumber = 1; frameNumber <= NUMBER_OF_SMALL_FRAMES; ++frameNumber)
+    {
+      if (buffer->AddItem(NULL, US_IMG_ORIENT_MF, frameSize, VTK_UNSIGNED_CHAR, 1, US_IMG_BRIGHTNESS, 0, frameNumber,
+                          clipRectangleOrigin, clipRectangleSize, frameNumber, frameNumber, NULL, CreateEncodedFrame(frameNumber)) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add encoded frame " << frameNumber);
+        return PLUS_FAIL;
+      }
+    }
+
+    const BufferItemUidType oldestUidInBuffer = buffer->GetOldestItemUidInBuffer();
+    for (BufferItemUidType spilledUid = 1; spilledUid < oldestUidInBuffer; ++spilledUid)
+    {
+      StreamBufferItem item;
+      if (buffer->GetStreamBufferItem(spilledUid, &item) != ITEM_OK || !item.GetFrame().IsFrameEncoded())
+      {
+        LOG_ERROR("Failed to get encoded spilled frame " << spilledUid);
+        return PLUS_FAIL;
+      }
+      // The frame must be linked to the previous frames back to the key frame
+      int frameNumber = static_cast<int>(item.GetIndex());
+      for (vtkStreamingVolumeFrame* encodedFrame = item.GetFrame().GetEncodedFrame(); encodedFrame != NULL; encodedFrame = encodedFrame->GetPreviousFrame())
+      {
+        vtkUnsignedCharArray* frameData = encodedFrame->GetFrameData();
+        if (frameData == NULL || frameData->GetNumberOfValues() != 100 + frameNumber || frameData->GetValue(0) != static_cast<unsigned char>(frameNumber)
+            || encodedFrame->GetCodecFourCC() != "VP90" || encodedFrame->GetDimensions()[0] != static_cast<int>(SMALL_FRAME_WIDTH))
+        {
+          LOG_ERROR("Spilled encoded frame " << frameNumber << " (read for item " << spilledUid << ") does not match the added frame");
+          return PLUS_FAIL;
+        }
+        if (encodedFrame->IsKeyFrame() != (frameNumber % KEY_FRAME_INTERVAL == 1)
+            || (!encodedFrame->IsKeyFrame() && encodedFrame->GetPreviousFrame() == NULL))
+        {
+          LOG_ERROR("Spilled encoded frame " << frameNumber << " is not linked to its key frame");
+          return PLUS_FAIL;
+        }
+        --frameNumber;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestTrackerItems() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Tracker item spilling test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestVideoFrames() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Video frame spilling test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestNativeFrames() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Native frame spilling test failed");
+    return EXIT_FAILURE;
+  }
+
+  if (TestEncodedFrames() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Encoded frame spilling test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,169 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusBufferTimestampSearchBenchmark.cxx
+  \brief Measure the time of finding item UIDs from timestamps with interpolation search and bisection
+
+  Buffers of 50 to 50000 items are filled with items that have jittered timestamps and some dropped items.
+  For each buffer size the same random timestamps are looked up with both search methods, which must return the same UIDs.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+
+// STL includes
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+
+namespace
+{
+  const double ITEM_PERIOD_SEC = 0.01;
+  const double ITEM_PERIOD_JITTER_SEC = 0.002;
+  const int DROPPED_ITEM_FREQUENCY = 97; // one item in every DROPPED_ITEM_FREQUENCY items is dropped
+
+  //----------------------------------------------------------------------------
+  double GetRandomNumber(double minValue, double maxValue)
+  {
+    return minValue + (maxValue - minValue) * rand() / RAND_MAX;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus FillBuffer(vtkPlusBuffer* buffer, int numberOfItems)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (buffer->SetBufferSize(numberOfItems) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    unsigned long frameNumber = 0;
+    while (buffer->GetNumberOfItems() < numberOfItems)
+    {
+      ++frameNumber;
+      if (frameNumber % DROPPED_ITEM_FREQUENCY == 0)
+      {
+        continue;
+      }
+      double timestamp = frameNumber * ITEM_PERIOD_SEC + GetRandomNumber(-ITEM_PERIOD_JITTER_SEC, ITEM_PERIOD_JITTER_SEC);
+      if (buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  double LookupItems(vtkPlusBuffer* buffer, const std::vector<double>& timestamps, std::vector<BufferItemUidType>& uids, int& numberOfErrors)
+  {
+    uids.resize(timestamps.size());
+    double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    for (size_t i = 0; i < timestamps.size(); ++i)
+    {
+      if (buffer->GetItemUidFromTime(timestamps[i], uids[i]) != ITEM_OK)
+      {
+        numberOfErrors++;
+      }
+    }
+    return vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfLookups(1000000);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-lookups", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfLookups, "Number of lookups for each buffer size and search method (Default: 1000000).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  srand(0);
+  int numberOfErrors(0);
+  const int bufferSizes[] = { 50, 500, 5000, 50000 };
+  for (size_t bufferSizeIndex = 0; bufferSizeIndex < sizeof(bufferSizes) / sizeof(bufferSizes[0]); ++bufferSizeIndex)
+  {
+    const int bufferSize = bufferSizes[bufferSizeIndex];
+    vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+    if (FillBuffer(buffer, bufferSize) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to fill buffer of " << bufferSize << " items");
+      return EXIT_FAILURE;
+    }
+
+    double oldestTimestamp(0);
+    double latestTimestamp(0);
+    buffer->GetOldestTimeStamp(oldestTimestamp);
+    buffer->GetLatestTimeStamp(latestTimestamp);
+    std::vector<double> timestamps(numberOfLookups);
+    for (int i = 0; i < numberOfLookups; ++i)
+    {
+      timestamps[i] = GetRandomNumber(oldestTimestamp, latestTimestamp);
+    }
+
+    int numberOfLookupErrors(0);
+    std::vector<BufferItemUidType> bisectionUids;
+    buffer->SetInterpolationSearch(false);
+    double bisectionTimeSec = LookupItems(buffer, timestamps, bisectionUids, numberOfLookupErrors);
+    std::vector<BufferItemUidType> interpolationUids;
+    buffer->SetInterpolationSearch(true);
+    double interpolationTimeSec = LookupItems(buffer, timestamps, interpolationUids, numberOfLookupErrors);
+
+    int numberOfMismatches(0);
+    for (int i = 0; i < numberOfLookups; ++i)
+    {
+      if (bisectionUids[i] != interpolationUids[i])
+      {
+        numberOfMismatches++;
+      }
+    }
+
+    LOG_INFO("Buffer size " << bufferSize << ": "
+             << std::fixed << std::setprecision(1) << bisectionTimeSec * 1e9 / numberOfLookups << " ns/lookup with bisection, "
+             << interpolationTimeSec * 1e9 / numberOfLookups << " ns/lookup with interpolation search");
+
+    if (numberOfLookupErrors > 0 || numberOfMismatches > 0)
+    {
+      LOG_ERROR("Buffer size " << bufferSize << ": " << numberOfLookupErrors << " lookups failed, "
+                << numberOfMismatches << " lookups returned different UIDs with bisection and interpolation search");
+      numberOfErrors++;
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
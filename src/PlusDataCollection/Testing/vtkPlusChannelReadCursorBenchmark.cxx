@@ -0,0 +1,163 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusChannelReadCursorBenchmark.cxx
+  \brief Measure the cost of getting the new frames of a channel with timestamps and with read cursors
+
+  Tool buffers of 50 to 50000 items are filled, then a few items are added before each call and
+  all new frames are read. Both methods must return the same frames. Reading with a read cursor
+  steps through the item UIDs, so its cost per call should not depend on the buffer size.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataSource.h"
+#include "vtkIGSIOTrackedFrameList.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+
+// STL includes
+#include <iomanip>
+
+namespace
+{
+  const double ITEM_PERIOD_SEC = 0.01;
+  const int NUMBER_OF_NEW_ITEMS_PER_CALL = 5;
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddItems(vtkPlusDataSource* tool, vtkMatrix4x4* matrix, unsigned long& frameNumber, int numberOfItems)
+  {
+    for (int i = 0; i < numberOfItems; ++i)
+    {
+      ++frameNumber;
+      double timestamp = frameNumber * ITEM_PERIOD_SEC;
+      if (tool->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfCalls(10000);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-calls", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfCalls, "Number of calls for each buffer size and read method (Default: 10000).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  int numberOfErrors(0);
+  const int bufferSizes[] = { 50, 500, 5000, 50000 };
+  for (size_t bufferSizeIndex = 0; bufferSizeIndex < sizeof(bufferSizes) / sizeof(bufferSizes[0]); ++bufferSizeIndex)
+  {
+    const int bufferSize = bufferSizes[bufferSizeIndex];
+
+    vtkSmartPointer<vtkPlusDataSource> tool = vtkSmartPointer<vtkPlusDataSource>::New();
+    tool->SetId("ProbeToTracker");
+    tool->SetType(DATA_SOURCE_TYPE_TOOL);
+    tool->SetBufferSize(bufferSize);
+    vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+    channel->SetChannelId("TrackerStream");
+    channel->AddTool(tool);
+
+    unsigned long frameNumber(0);
+    if (AddItems(tool, matrix, frameNumber, bufferSize) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to fill buffer of " << bufferSize << " items");
+      return EXIT_FAILURE;
+    }
+
+    // Both methods start with the most recent frame
+    double timestampOfLastFrameAlreadyGot(UNDEFINED_TIMESTAMP);
+    vtkPlusChannel::ReadCursor cursor;
+    channel->Subscribe(cursor);
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> timestampFrames = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> cursorFrames = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    channel->GetTrackedFrameList(timestampOfLastFrameAlreadyGot, timestampFrames, 0);
+    channel->GetTrackedFrameList(cursor, cursorFrames, 0);
+
+    double timestampReadTimeSec(0);
+    double cursorReadTimeSec(0);
+    int numberOfMismatches(0);
+    for (int i = 0; i < numberOfCalls; ++i)
+    {
+      if (AddItems(tool, matrix, frameNumber, NUMBER_OF_NEW_ITEMS_PER_CALL) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to add items to buffer of " << bufferSize << " items");
+        return EXIT_FAILURE;
+      }
+
+      timestampFrames->Clear();
+      double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      if (channel->GetTrackedFrameList(timestampOfLastFrameAlreadyGot, timestampFrames, 0) != PLUS_SUCCESS)
+      {
+        numberOfErrors++;
+      }
+      timestampReadTimeSec += vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+      cursorFrames->Clear();
+      startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      if (channel->GetTrackedFrameList(cursor, cursorFrames, 0) != PLUS_SUCCESS)
+      {
+        numberOfErrors++;
+      }
+      cursorReadTimeSec += vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+      if (cursorFrames->GetNumberOfTrackedFrames() != NUMBER_OF_NEW_ITEMS_PER_CALL
+          || timestampFrames->GetNumberOfTrackedFrames() != cursorFrames->GetNumberOfTrackedFrames()
+          || timestampOfLastFrameAlreadyGot != cursor.LastConsumedTimestamp)
+      {
+        numberOfMismatches++;
+      }
+    }
+
+    LOG_INFO("Buffer size " << bufferSize << ": "
+             << std::fixed << std::setprecision(1) << timestampReadTimeSec * 1e6 / numberOfCalls << " us/call with timestamps, "
+             << cursorReadTimeSec * 1e6 / numberOfCalls << " us/call with read cursor");
+
+    if (numberOfMismatches > 0)
+    {
+      LOG_ERROR("Buffer size " << bufferSize << ": " << numberOfMismatches << " calls returned different frames with timestamps and read cursor");
+      numberOfErrors++;
+    }
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,213 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusChannelTrackedFrameCacheTest.cxx
+  \brief Test that repeated tracked frame requests for the same timestamp are served from the channel cache
+
+  Consumers requesting the same timestamp must get identical frames, but only the first request
+  may assemble the frame from the buffers. Items added after the requested timestamp must not
+  invalidate the cached frame, a change of the time offset of a source must invalidate it,
+  and a zero cache size must disable caching.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataSource.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+
+namespace
+{
+  const double ITEM_PERIOD_SEC = 0.01;
+
+  //----------------------------------------------------------------------------
+  PlusStatus AddItems(vtkPlusDataSource* tool, unsigned long& frameNumber, int numberOfItems)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int i = 0; i < numberOfItems; ++i)
+    {
+      ++frameNumber;
+      double timestamp = frameNumber * ITEM_PERIOD_SEC;
+      matrix->SetElement(0, 3, frameNumber);
+      if (tool->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CheckCacheCounters(vtkPlusChannel* channel, unsigned long long expectedHits, unsigned long long expectedMisses)
+  {
+    if (channel->GetNumberOfTrackedFrameCacheHits() != expectedHits || channel->GetNumberOfTrackedFrameCacheMisses() != expectedMisses)
+    {
+      LOG_ERROR("Cache hits: " << channel->GetNumberOfTrackedFrameCacheHits() << " (expected " << expectedHits << "), "
+                << "cache misses: " << channel->GetNumberOfTrackedFrameCacheMisses() << " (expected " << expectedMisses << ")");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CheckSameFrame(igsioTrackedFrame& frame1, igsioTrackedFrame& frame2)
+  {
+    igsioTransformName transformName("Probe", "Tracker");
+    vtkSmartPointer<vtkMatrix4x4> matrix1 = vtkSmartPointer<vtkMatrix4x4>::New();
+    vtkSmartPointer<vtkMatrix4x4> matrix2 = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (frame1.GetFrameTransform(transformName, matrix1) != PLUS_SUCCESS || frame2.GetFrameTransform(transformName, matrix2) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Tracked frame does not contain the ProbeToTracker transform");
+      return PLUS_FAIL;
+    }
+    if (frame1.GetTimestamp() != frame2.GetTimestamp() || matrix1->GetElement(0, 3) != matrix2->GetElement(0, 3))
+    {
+      LOG_ERROR("Cached tracked frame differs from the assembled tracked frame");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusDataSource> tool = vtkSmartPointer<vtkPlusDataSource>::New();
+  tool->SetId("ProbeToTracker");
+  tool->SetType(DATA_SOURCE_TYPE_TOOL);
+  tool->SetBufferSize(500);
+  vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+  channel->SetChannelId("TrackerStream");
+  channel->AddTool(tool);
+  channel->SetTrackedFrameCacheSize(4);
+
+  unsigned long frameNumber(0);
+  if (AddItems(tool, frameNumber, 100) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to fill the tool buffer");
+    return EXIT_FAILURE;
+  }
+
+  // Same timestamp requested by two consumers: only the first one assembles the frame
+  const double requestedTimestamp = 50.5 * ITEM_PERIOD_SEC;
+  igsioTrackedFrame assembledFrame;
+  igsioTrackedFrame cachedFrame;
+  if (channel->GetTrackedFrame(requestedTimestamp, assembledFrame) != PLUS_SUCCESS
+      || channel->GetTrackedFrame(requestedTimestamp, cachedFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get tracked frame");
+    return EXIT_FAILURE;
+  }
+  if (CheckCacheCounters(channel, 1, 1) != PLUS_SUCCESS || CheckSameFrame(assembledFrame, cachedFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Repeated request was not served from the cache");
+    return EXIT_FAILURE;
+  }
+
+  // New items after the requested timestamp do not change the frame
+  if (AddItems(tool, frameNumber, 10) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to add items to the tool buffer");
+    return EXIT_FAILURE;
+  }
+  if (channel->GetTrackedFrame(requestedTimestamp, cachedFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to get tracked frame");
+    return EXIT_FAILURE;
+  }
+  if (CheckCacheCounters(channel, 2, 1) != PLUS_SUCCESS || CheckSameFrame(assembledFrame, cachedFrame) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cached frame was invalidated by newly acquired items");
+    return EXIT_FAILURE;
+  }
+
+  // Requests for image data are cached separately
+  if (channel->GetTrackedFrame(requestedTimestamp, cachedFrame, false) != PLUS_SUCCESS || CheckCacheCounters(channel, 2, 2) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Request without image data was served from the cache of requests with image data");
+    return EXIT_FAILURE;
+  }
+
+  // Clearing the channel discards the cached frames
+  channel->Clear();
+  frameNumber = 0;
+  if (AddItems(tool, frameNumber, 100) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to fill the tool buffer");
+    return EXIT_FAILURE;
+  }
+  if (channel->GetTrackedFrame(requestedTimestamp, cachedFrame) != PLUS_SUCCESS || CheckCacheCounters(channel, 2, 3) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cached frame was not discarded when the channel was cleared");
+    return EXIT_FAILURE;
+  }
+
+  // Changing the time offset shifts the items in time, so the frame is assembled again from other items
+  igsioTrackedFrame offsetFrame;
+  tool->SetLocalTimeOffsetSec(10 * ITEM_PERIOD_SEC);
+  if (channel->GetTrackedFrame(requestedTimestamp, offsetFrame) != PLUS_SUCCESS || CheckCacheCounters(channel, 2, 4) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Cached frame was not discarded when the time offset of the tool changed");
+    return EXIT_FAILURE;
+  }
+  igsioTransformName transformName("Probe", "Tracker");
+  vtkSmartPointer<vtkMatrix4x4> cachedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  vtkSmartPointer<vtkMatrix4x4> offsetMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  if (cachedFrame.GetFrameTransform(transformName, cachedMatrix) != PLUS_SUCCESS
+      || offsetFrame.GetFrameTransform(transformName, offsetMatrix) != PLUS_SUCCESS
+      || cachedMatrix->GetElement(0, 3) == offsetMatrix->GetElement(0, 3))
+  {
+    LOG_ERROR("Tracked frame is not assembled from the time shifted items");
+    return EXIT_FAILURE;
+  }
+  tool->SetLocalTimeOffsetSec(0.0);
+
+  // Disabled cache
+  channel->SetTrackedFrameCacheSize(0);
+  for (int i = 0; i < 3; ++i)
+  {
+    if (channel->GetTrackedFrame(requestedTimestamp, cachedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get tracked frame");
+      return EXIT_FAILURE;
+    }
+  }
+  if (CheckCacheCounters(channel, 2, 4) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Tracked frames were cached with zero cache size");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,119 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusDataCollectorMemoryBudgetTest.cxx
+  \brief Test that the data collector distributes its memory budget across the buffers of all data sources
+
+  The total estimated buffer memory must stay within the budget, each source must get the same history
+  duration, and sources that are shared between devices must be counted only once.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusDevice.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <cmath>
+
+namespace
+{
+  const double MEMORY_BUDGET_MB = 64.0;
+  const unsigned int FRAME_WIDTH = 640;
+  const unsigned int FRAME_HEIGHT = 480;
+  const double VIDEO_ACQUISITION_RATE = 30.0;
+  const double TRACKER_ACQUISITION_RATE = 150.0;
+
+  //----------------------------------------------------------------------------
+  vtkPlusDevice* CreateDevice(const std::string& deviceId, double acquisitionRate)
+  {
+    vtkPlusDevice* device = vtkPlusDevice::New();
+    device->SetDeviceId(deviceId);
+    device->SetAcquisitionRate(acquisitionRate);
+    return device;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+
+  // Video device
+  vtkPlusDevice* videoDevice = CreateDevice("VideoDevice", VIDEO_ACQUISITION_RATE);
+  vtkSmartPointer<vtkPlusDataSource> videoSource = vtkSmartPointer<vtkPlusDataSource>::New();
+  videoSource->SetId("Video");
+  videoSource->SetType(DATA_SOURCE_TYPE_VIDEO);
+  videoSource->GetBuffer()->SetFrameSize(FRAME_WIDTH, FRAME_HEIGHT, 1);
+  videoDevice->AddVideoSource(videoSource);
+  dataCollector->AddDevice(videoDevice);
+
+  // Tracker device
+  vtkPlusDevice* trackerDevice = CreateDevice("TrackerDevice", TRACKER_ACQUISITION_RATE);
+  vtkSmartPointer<vtkPlusDataSource> toolSource = vtkSmartPointer<vtkPlusDataSource>::New();
+  toolSource->SetId("Probe");
+  toolSource->SetType(DATA_SOURCE_TYPE_TOOL);
+  trackerDevice->AddTool(toolSource);
+  dataCollector->AddDevice(trackerDevice);
+
+  // A device that shares the video source, it must not be counted twice
+  vtkPlusDevice* sharingDevice = CreateDevice("SharingDevice", VIDEO_ACQUISITION_RATE);
+  sharingDevice->AddVideoSource(videoSource);
+  dataCollector->AddDevice(sharingDevice);
+
+  dataCollector->SetMemoryBudgetMB(MEMORY_BUDGET_MB);
+  if (dataCollector->ApplyMemoryBudget() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to apply memory budget");
+    return EXIT_FAILURE;
+  }
+
+  const double videoFrameSizeMB = FRAME_WIDTH * FRAME_HEIGHT / (1024.0 * 1024.0);
+  const double videoBufferSizeMB = videoSource->GetBufferSize() * videoFrameSizeMB;
+  if (videoBufferSizeMB > MEMORY_BUDGET_MB || videoBufferSizeMB < MEMORY_BUDGET_MB * 0.9)
+  {
+    LOG_ERROR("Video buffer size is " << videoBufferSizeMB << " MB, expected slightly less than the " << MEMORY_BUDGET_MB << " MB budget");
+    return EXIT_FAILURE;
+  }
+
+  const double videoHistorySec = videoSource->GetBufferSize() / VIDEO_ACQUISITION_RATE;
+  const double toolHistorySec = toolSource->GetBufferSize() / TRACKER_ACQUISITION_RATE;
+  if (fabs(videoHistorySec - toolHistorySec) > 1.0 / VIDEO_ACQUISITION_RATE)
+  {
+    LOG_ERROR("History durations differ: video: " << videoHistorySec << " sec, tool: " << toolHistorySec << " sec");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
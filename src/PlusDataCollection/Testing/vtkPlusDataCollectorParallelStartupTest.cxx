@@ -0,0 +1,152 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusDataCollectorParallelStartupTest.cxx
+  \brief Test that the data collector connects devices concurrently and respects channel dependencies
+
+  Several devices that take a long time to connect must be connected in about the time of a single
+  connection, and a device that uses the output channel of another device must be connected after it.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDevice.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const double CONNECT_DURATION_SEC = 0.5;
+  const int NUMBER_OF_INDEPENDENT_DEVICES = 4;
+}
+
+//----------------------------------------------------------------------------
+/*! Device that takes a long time to connect and records when the connection started and finished */
+class vtkPlusSlowConnectDevice : public vtkPlusDevice
+{
+public:
+  static vtkPlusSlowConnectDevice* New();
+  vtkTypeMacro(vtkPlusSlowConnectDevice, vtkPlusDevice);
+
+  double ConnectStartTime;
+  double ConnectEndTime;
+
+protected:
+  vtkPlusSlowConnectDevice()
+    : ConnectStartTime(0)
+    , ConnectEndTime(0)
+  {
+  }
+
+  virtual PlusStatus InternalConnect() VTK_OVERRIDE
+  {
+    this->ConnectStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(CONNECT_DURATION_SEC * 1000)));
+    this->ConnectEndTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    return PLUS_SUCCESS;
+  }
+};
+
+vtkStandardNewMacro(vtkPlusSlowConnectDevice);
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+  dataCollector->ParallelStartupOn();
+
+  // Independent devices, the data collector deletes them
+  std::vector<vtkPlusSlowConnectDevice*> devices;
+  for (int i = 0; i < NUMBER_OF_INDEPENDENT_DEVICES; ++i)
+  {
+    vtkPlusSlowConnectDevice* device = vtkPlusSlowConnectDevice::New();
+    std::ostringstream deviceId;
+    deviceId << "Device" << i;
+    device->SetDeviceId(deviceId.str());
+    dataCollector->AddDevice(device);
+    devices.push_back(device);
+  }
+
+  // The consumer device uses the output channel of the first device
+  vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+  channel->SetChannelId("Device0Channel");
+  devices[0]->AddOutputChannel(channel);
+  vtkPlusSlowConnectDevice* consumerDevice = vtkPlusSlowConnectDevice::New();
+  consumerDevice->SetDeviceId("ConsumerDevice");
+  consumerDevice->AddInputChannel(channel);
+  dataCollector->AddDevice(consumerDevice);
+
+  const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (dataCollector->Connect() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to connect devices");
+    return EXIT_FAILURE;
+  }
+  const double connectDurationSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+  // Independent devices are connected concurrently, then the consumer device
+  if (connectDurationSec > 3 * CONNECT_DURATION_SEC)
+  {
+    LOG_ERROR("Connecting took " << connectDurationSec << " sec, devices are not connected concurrently");
+    return EXIT_FAILURE;
+  }
+  if (consumerDevice->ConnectStartTime < devices[0]->ConnectEndTime)
+  {
+    LOG_ERROR("Consumer device connection started before its input device was connected");
+    return EXIT_FAILURE;
+  }
+
+  // Connecting one by one
+  dataCollector->Disconnect();
+  dataCollector->ParallelStartupOff();
+  if (dataCollector->Connect() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to connect devices one by one");
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 1; i < devices.size(); ++i)
+  {
+    if (devices[i]->ConnectStartTime < devices[i - 1]->ConnectEndTime)
+    {
+      LOG_ERROR("Devices are connected concurrently while parallel startup is disabled");
+      return EXIT_FAILURE;
+    }
+  }
+  dataCollector->Disconnect();
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,239 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusDataCollectorReplayClockTest.cxx
+  \brief Test that the data collector updates the devices on a virtual replay clock
+
+  A producer device and a consumer device that uses the output channel of the producer are updated on
+  the replay clock. Each device must be updated at its own acquisition rate on the replay timeline, the
+  producer before the consumer in the same step, in AS_FAST_AS_POSSIBLE and in FIXED_SPEED mode. When
+  the data collection is restarted, the replay timeline must continue from where it was stopped.
+  The speed of the replay compared to real time is only logged, as it depends on the load of the computer.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusReplayClock.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDevice.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// STL includes
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const double PRODUCER_ACQUISITION_RATE = 20.0;
+  const double CONSUMER_ACQUISITION_RATE = 10.0;
+  const double REPLAY_DURATION_SEC = 0.5;
+  const double FIXED_REPLAY_SPEED = 4.0;
+  const double TIME_TOLERANCE_SEC = 1e-6;
+}
+
+//----------------------------------------------------------------------------
+/*! Virtual device that records the clock time of its updates */
+class vtkPlusReplayClockTestDevice : public vtkPlusDevice
+{
+public:
+  static vtkPlusReplayClockTestDevice* New();
+  vtkTypeMacro(vtkPlusReplayClockTestDevice, vtkPlusDevice);
+
+  virtual bool IsVirtual() const VTK_OVERRIDE { return true; }
+
+  std::vector<double> GetUpdateTimes()
+  {
+    std::lock_guard<std::mutex> lock(this->UpdateTimesMutex);
+    return this->UpdateTimes;
+  }
+
+  void ClearUpdateTimes()
+  {
+    std::lock_guard<std::mutex> lock(this->UpdateTimesMutex);
+    this->UpdateTimes.clear();
+  }
+
+protected:
+  vtkPlusReplayClockTestDevice()
+  {
+    this->StartThreadForInternalUpdates = true;
+  }
+
+  virtual PlusStatus InternalUpdate() VTK_OVERRIDE
+  {
+    std::lock_guard<std::mutex> lock(this->UpdateTimesMutex);
+    this->UpdateTimes.push_back(this->GetClockTime());
+    return PLUS_SUCCESS;
+  }
+
+  std::mutex UpdateTimesMutex;
+  std::vector<double> UpdateTimes;
+};
+
+vtkStandardNewMacro(vtkPlusReplayClockTestDevice);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /*! Check that the device was updated exactly at its acquisition period on the replay timeline */
+  PlusStatus CheckUpdateTimes(const std::vector<double>& updateTimes, double startTime, double acquisitionRate, const std::string& deviceName)
+  {
+    if (updateTimes.size() < 2)
+    {
+      LOG_ERROR(deviceName << " was updated " << updateTimes.size() << " times on the replay clock");
+      return PLUS_FAIL;
+    }
+    for (size_t i = 0; i < updateTimes.size(); ++i)
+    {
+      const double expectedTime = startTime + i / acquisitionRate;
+      if (fabs(updateTimes[i] - expectedTime) > TIME_TOLERANCE_SEC)
+      {
+        LOG_ERROR(deviceName << " update " << i << " is at replay time " << std::fixed << updateTimes[i] - startTime << " sec instead of " << expectedTime - startTime << " sec");
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Replay for REPLAY_DURATION_SEC real time and return the replay time of the first and last producer updates */
+  PlusStatus Replay(vtkPlusDataCollector* dataCollector, vtkPlusReplayClockTestDevice* producer, vtkPlusReplayClockTestDevice* consumer, double& replayStartTime, double& replayStopTime)
+  {
+    producer->ClearUpdateTimes();
+    consumer->ClearUpdateTimes();
+
+    const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    if (dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start data collection");
+      return PLUS_FAIL;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(REPLAY_DURATION_SEC * 1000)));
+    dataCollector->Stop();
+    const double realTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTime;
+
+    std::vector<double> producerUpdateTimes = producer->GetUpdateTimes();
+    std::vector<double> consumerUpdateTimes = consumer->GetUpdateTimes();
+    if (producerUpdateTimes.empty())
+    {
+      LOG_ERROR("Producer device was not updated on the replay clock");
+      return PLUS_FAIL;
+    }
+    replayStartTime = producerUpdateTimes.front();
+    replayStopTime = producerUpdateTimes.back();
+    if (CheckUpdateTimes(producerUpdateTimes, replayStartTime, PRODUCER_ACQUISITION_RATE, "Producer") != PLUS_SUCCESS
+        || CheckUpdateTimes(consumerUpdateTimes, replayStartTime, CONSUMER_ACQUISITION_RATE, "Consumer") != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    // The consumer is updated after the producer in the same step, so the producer is never behind
+    if (producerUpdateTimes.back() + TIME_TOLERANCE_SEC < consumerUpdateTimes.back())
+    {
+      LOG_ERROR("Consumer device was updated before the producer device");
+      return PLUS_FAIL;
+    }
+
+    LOG_INFO("Replayed " << std::fixed << replayStopTime - replayStartTime << " sec in " << realTimeSec << " sec");
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+  dataCollector->SetStartupTimeoutSec(0.0);
+
+  // The data collector deletes the devices
+  vtkPlusReplayClockTestDevice* producer = vtkPlusReplayClockTestDevice::New();
+  producer->SetDeviceId("Producer");
+  producer->SetAcquisitionRate(PRODUCER_ACQUISITION_RATE);
+  vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+  channel->SetChannelId("ProducerChannel");
+  producer->AddOutputChannel(channel);
+
+  // The consumer is added first, the update order must still follow the channel dependency
+  vtkPlusReplayClockTestDevice* consumer = vtkPlusReplayClockTestDevice::New();
+  consumer->SetDeviceId("Consumer");
+  consumer->SetAcquisitionRate(CONSUMER_ACQUISITION_RATE);
+  consumer->AddInputChannel(channel);
+  dataCollector->AddDevice(consumer);
+  dataCollector->AddDevice(producer);
+
+  if (dataCollector->Connect() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to connect devices");
+    return EXIT_FAILURE;
+  }
+
+  // Updates of trivial devices take much less time than the acquisition period
+  dataCollector->GetReplayClock().SetMode(ReplayClock::REPLAY_CLOCK_AS_FAST_AS_POSSIBLE);
+  double replayStartTime(0.0);
+  double replayStopTime(0.0);
+  if (Replay(dataCollector, producer, consumer, replayStartTime, replayStopTime) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Replay as fast as possible failed");
+    return EXIT_FAILURE;
+  }
+
+  // The restarted replay must not move the timeline backwards, that would add older items after newer ones to the buffers
+  const double previousReplayStopTime = replayStopTime;
+  if (Replay(dataCollector, producer, consumer, replayStartTime, replayStopTime) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Restarted replay as fast as possible failed");
+    return EXIT_FAILURE;
+  }
+  if (replayStartTime <= previousReplayStopTime + TIME_TOLERANCE_SEC)
+  {
+    LOG_ERROR("Restarted replay started at " << std::fixed << replayStartTime << " sec, not after the previous replay stopped at " << previousReplayStopTime << " sec");
+    return EXIT_FAILURE;
+  }
+
+  dataCollector->Disconnect();
+  if (dataCollector->Connect() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to reconnect devices");
+    return EXIT_FAILURE;
+  }
+  dataCollector->GetReplayClock().SetMode(ReplayClock::REPLAY_CLOCK_FIXED_SPEED);
+  dataCollector->GetReplayClock().SetSpeed(FIXED_REPLAY_SPEED);
+  if (Replay(dataCollector, producer, consumer, replayStartTime, replayStopTime) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Replay at fixed speed failed");
+    return EXIT_FAILURE;
+  }
+  dataCollector->Disconnect();
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
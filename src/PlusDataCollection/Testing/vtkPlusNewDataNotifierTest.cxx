@@ -0,0 +1,137 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusNewDataNotifierTest.cxx
+  \brief Test that consumers waiting for new data are woken up when an item is added to a buffer
+
+  A writer thread adds items to a buffer while the main thread waits for them using a notifier.
+  The time between adding an item and the waiting thread waking up is measured.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusBuffer.h"
+#include "vtkPlusNewDataNotifier.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+
+// STL includes
+#include <atomic>
+#include <thread>
+
+namespace
+{
+  const double WRITER_DELAY_SEC = 0.05;
+  const double WAIT_TIMEOUT_SEC = 1.0;
+
+  //----------------------------------------------------------------------------
+  void WriterThread(vtkPlusBuffer* buffer, int numberOfItems, std::atomic<double>* lastItemAddedTime)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int frameNumber = 1; frameNumber <= numberOfItems; ++frameNumber)
+    {
+      vtkIGSIOAccurateTimer::Delay(WRITER_DELAY_SEC);
+      *lastItemAddedTime = vtkIGSIOAccurateTimer::GetSystemTime();
+      buffer->AddTimeStampedItem(matrix, TOOL_OK, frameNumber, frameNumber, frameNumber);
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int numberOfItems(10);
+  double maxLatencySec(0.02);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--number-of-items", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &numberOfItems, "Number of items added by the writer thread (Default: 10).");
+  args.AddArgument("--max-latency-sec", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &maxLatencySec, "Maximum allowed time between adding an item and waking up the waiting thread (Default: 0.02).");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  int numberOfErrors(0);
+  vtkSmartPointer<vtkPlusBuffer> buffer = vtkSmartPointer<vtkPlusBuffer>::New();
+  vtkSmartPointer<vtkPlusNewDataNotifier> notifier = vtkSmartPointer<vtkPlusNewDataNotifier>::New();
+  buffer->AddNewDataNotifier(notifier);
+
+  // No data is added, the wait must time out
+  unsigned long long sequenceNumber = notifier->GetSequenceNumber();
+  if (notifier->WaitForNewData(sequenceNumber, WRITER_DELAY_SEC))
+  {
+    LOG_ERROR("New data was reported, but no item was added to the buffer");
+    numberOfErrors++;
+  }
+
+  // Wake up on each new item
+  std::atomic<double> lastItemAddedTime(0);
+  std::thread writer(WriterThread, buffer.GetPointer(), numberOfItems, &lastItemAddedTime);
+  int numberOfWakeUps(0);
+  double maxMeasuredLatencySec(0);
+  while (buffer->GetNumberOfItems() < numberOfItems)
+  {
+    if (!notifier->WaitForNewData(sequenceNumber, WAIT_TIMEOUT_SEC))
+    {
+      LOG_ERROR("Waiting for new data timed out");
+      numberOfErrors++;
+      break;
+    }
+    double latencySec = vtkIGSIOAccurateTimer::GetSystemTime() - lastItemAddedTime;
+    if (latencySec > maxMeasuredLatencySec)
+    {
+      maxMeasuredLatencySec = latencySec;
+    }
+    numberOfWakeUps++;
+  }
+  writer.join();
+
+  LOG_INFO("Woken up " << numberOfWakeUps << " times for " << numberOfItems << " items, maximum latency: " << maxMeasuredLatencySec * 1000 << "ms");
+  if (maxMeasuredLatencySec > maxLatencySec)
+  {
+    LOG_ERROR("Latency of new data notification (" << maxMeasuredLatencySec << "sec) is larger than the threshold (" << maxLatencySec << "sec)");
+    numberOfErrors++;
+  }
+
+  // Removed notifiers must not be notified
+  buffer->RemoveNewDataNotifier(notifier);
+  sequenceNumber = notifier->GetSequenceNumber();
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  buffer->AddTimeStampedItem(matrix, TOOL_OK, numberOfItems + 1, numberOfItems + 1, numberOfItems + 1);
+  if (notifier->GetSequenceNumber() != sequenceNumber)
+  {
+    LOG_ERROR("Notifier was notified after it had been removed from the buffer");
+    numberOfErrors++;
+  }
+
+  if (numberOfErrors > 0)
+  {
+    LOG_ERROR("Test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
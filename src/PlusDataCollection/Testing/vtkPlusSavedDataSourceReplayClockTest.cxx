@@ -0,0 +1,199 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusSavedDataSourceReplayClockTest.cxx
+  \brief Test that a saved data source replayed on a virtual replay clock produces the same data on every run
+
+  A sequence file is replayed twice by a data collector with a FIXED_SPEED replay clock. The number of replayed
+  frames depends on the real time that the replay runs for, but the frames that both runs replayed must be
+  the same and must have the same timestamps relative to the first replayed frame.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusDevice.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// VTK includes
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 16, 12, 1 };
+  const unsigned int NUMBER_OF_FRAMES = 20;
+  const double FRAME_PERIOD_SEC = 0.05;
+  const double REPLAY_SPEED = 10.0;
+  const double REPLAY_DURATION_SEC = 0.5;
+  /*! Much more than the number of frames that are replayed in REPLAY_DURATION_SEC, so that the first frames are kept */
+  const int BUFFER_SIZE = 2000;
+  const unsigned int MINIMUM_NUMBER_OF_COMPARED_FRAMES = 2 * NUMBER_OF_FRAMES;
+  const double TIMESTAMP_TOLERANCE_SEC = 1e-6;
+
+  struct ReplayedFrame
+  {
+    double Timestamp;
+    std::vector<unsigned char> Pixels;
+  };
+
+  //----------------------------------------------------------------------------
+  /*! Replay the sequence file for REPLAY_DURATION_SEC real time and collect the frames of the output buffer of the saved data source */
+  PlusStatus Replay(const std::string& sequenceFilename, std::vector<ReplayedFrame>& replayedFrames)
+  {
+    replayedFrames.clear();
+
+    std::ostringstream config;
+    config << "<PlusConfiguration version=\"2.1\"><DataCollection StartupDelaySec=\"0\" ReplayClock=\"FIXED_SPEED\" ReplaySpeed=\"" << REPLAY_SPEED << "\">"
+           << "<Device Id=\"SavedVideo\" Type=\"SavedDataSource\" SequenceFile=\"" << sequenceFilename << "\""
+           << " AcquisitionRate=\"" << 1.0 / FRAME_PERIOD_SEC << "\" UseData=\"IMAGE\" RepeatEnabled=\"TRUE\">"
+           << "<DataSources><DataSource Type=\"Video\" Id=\"Video\" PortUsImageOrientation=\"MF\" BufferSize=\"" << BUFFER_SIZE << "\" /></DataSources>"
+           << "<OutputChannels><OutputChannel Id=\"VideoStream\" VideoDataSourceId=\"Video\" /></OutputChannels>"
+           << "</Device></DataCollection></PlusConfiguration>";
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(config.str().c_str()));
+    vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS || dataCollector->Connect() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to connect to the saved data source");
+      return PLUS_FAIL;
+    }
+    vtkPlusDevice* device = NULL;
+    vtkPlusDataSource* videoSource = NULL;
+    if (dataCollector->GetDevice(device, "SavedVideo") != PLUS_SUCCESS || device->GetFirstVideoSource(videoSource) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Saved data source video is not found");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+
+    if (dataCollector->Start() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to start data collection");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(static_cast<int>(REPLAY_DURATION_SEC * 1000)));
+    dataCollector->Stop();
+
+    if (videoSource->GetNumberOfItems() > 0)
+    {
+      for (BufferItemUidType uid = videoSource->GetOldestItemUidInBuffer(); uid <= videoSource->GetLatestItemUidInBuffer(); ++uid)
+      {
+        StreamBufferItem item;
+        if (videoSource->GetStreamBufferItem(uid, &item) != ITEM_OK)
+        {
+          LOG_ERROR("Failed to get replayed item " << uid);
+          dataCollector->Disconnect();
+          return PLUS_FAIL;
+        }
+        ReplayedFrame frame;
+        frame.Timestamp = item.GetFilteredTimestamp(0);
+        const unsigned char* pixels = static_cast<const unsigned char*>(item.GetFrame().GetScalarPointer());
+        frame.Pixels.assign(pixels, pixels + item.GetFrame().GetFrameSizeInBytes());
+        replayedFrames.push_back(frame);
+      }
+    }
+    dataCollector->Disconnect();
+
+    if (replayedFrames.empty())
+    {
+      LOG_ERROR("No frames were replayed");
+      return PLUS_FAIL;
+    }
+    LOG_INFO("Replayed " << replayedFrames.size() << " frames");
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  const std::string filename = vtkPlusConfig::GetInstance()->GetOutputPath("vtkPlusSavedDataSourceReplayClockTest.nrrd");
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (PlusTestFrames::AddFrames(frameList, 0, NUMBER_OF_FRAMES, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS
+      || vtkPlusSequenceIO::Write(filename, frameList, US_IMG_ORIENT_MF, false) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write sequence file: " << filename);
+    return EXIT_FAILURE;
+  }
+
+  std::vector<ReplayedFrame> firstRunFrames;
+  std::vector<ReplayedFrame> secondRunFrames;
+  PlusStatus status = Replay(filename, firstRunFrames);
+  if (status == PLUS_SUCCESS)
+  {
+    status = Replay(filename, secondRunFrames);
+  }
+  vtksys::SystemTools::RemoveFile(filename);
+  if (status != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Replay failed");
+    return EXIT_FAILURE;
+  }
+
+  // Only the frames that both runs replayed are compared, their number depends on the real time of the replay
+  const size_t numberOfComparedFrames = std::min(firstRunFrames.size(), secondRunFrames.size());
+  if (numberOfComparedFrames < MINIMUM_NUMBER_OF_COMPARED_FRAMES)
+  {
+    LOG_ERROR("Only " << numberOfComparedFrames << " frames were replayed in both runs, at least " << MINIMUM_NUMBER_OF_COMPARED_FRAMES << " are needed to compare looped replays");
+    return EXIT_FAILURE;
+  }
+  for (size_t i = 0; i < numberOfComparedFrames; ++i)
+  {
+    const double firstRunTime = firstRunFrames[i].Timestamp - firstRunFrames[0].Timestamp;
+    const double secondRunTime = secondRunFrames[i].Timestamp - secondRunFrames[0].Timestamp;
+    if (fabs(firstRunTime - secondRunTime) > TIMESTAMP_TOLERANCE_SEC)
+    {
+      LOG_ERROR("Frame " << i << " is replayed at " << std::fixed << firstRunTime << " sec in the first run and at " << secondRunTime << " sec in the second run");
+      return EXIT_FAILURE;
+    }
+    if (firstRunFrames[i].Pixels != secondRunFrames[i].Pixels)
+    {
+      LOG_ERROR("Frame " << i << " has different pixels in the two runs");
+      return EXIT_FAILURE;
+    }
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,313 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusSavedDataSourceStreamingTest.cxx
+  \brief Test that a saved data source replays the same frames with and without streaming
+
+  An indexed, uncompressed sequence file is replayed by a saved data source that is stepped on a virtual
+  replay clock, once with the whole file loaded at connect and once streamed from the file. Looping,
+  replay of a part of the file (SetLoopTimeRange) and replay with the original timestamps are covered.
+  The output buffers of the two replays must contain the same frames with the same timestamps.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusReplayClock.h"
+#include "PlusSequenceFrameIndex.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusDataCollector.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusSavedDataSource.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// VTK includes
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// STL includes
+#include <cstring>
+#include <sstream>
+#include <vector>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 16, 12, 1 };
+  const unsigned int NUMBER_OF_FRAMES = 20;
+  const double FRAME_PERIOD_SEC = 0.05;
+  const double REPLAY_START_TIME = 1000.0;
+  /*! More steps than frames, so that the whole file is replayed more than 3 times in a loop */
+  const unsigned int NUMBER_OF_REPLAY_STEPS = 70;
+  const double TIMESTAMP_TOLERANCE_SEC = 1e-6;
+
+  struct ReplayOptions
+  {
+    bool RepeatEnabled;
+    bool UseOriginalTimestamps;
+    /*! Replayed time range of the file. The whole file is replayed if the stop time is not after the start time. */
+    double LoopStartTime;
+    double LoopStopTime;
+  };
+
+  const ReplayOptions REPLAY_OPTIONS[] =
+  {
+    { true, false, 0.0, 0.0 },
+    { true, false, 0.25, 0.75 },
+    { false, false, 0.25, 0.75 },
+    { true, true, 0.25, 0.75 },
+    { false, true, 0.0, 0.0 }
+  };
+
+  struct ReplayedFrame
+  {
+    double Timestamp;
+    std::vector<unsigned char> Pixels;
+  };
+
+  //----------------------------------------------------------------------------
+  std::string GetOptionsAsString(const ReplayOptions& options)
+  {
+    std::ostringstream description;
+    description << "RepeatEnabled=" << (options.RepeatEnabled ? "TRUE" : "FALSE")
+                << ", UseOriginalTimestamps=" << (options.UseOriginalTimestamps ? "TRUE" : "FALSE");
+    if (options.LoopStopTime > options.LoopStartTime)
+    {
+      description << ", loop time range " << options.LoopStartTime << "-" << options.LoopStopTime;
+    }
+    return description.str();
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Replay the sequence file by stepping the saved data source on a replay clock and collect the frames of its output buffer */
+  PlusStatus Replay(const std::string& sequenceFilename, const ReplayOptions& options, bool streamingEnabled, std::vector<ReplayedFrame>& replayedFrames)
+  {
+    replayedFrames.clear();
+
+    std::ostringstream config;
+    config << "<PlusConfiguration version=\"2.1\"><DataCollection StartupDelaySec=\"0\">"
+           << "<Device Id=\"SavedVideo\" Type=\"SavedDataSource\" SequenceFile=\"" << sequenceFilename << "\""
+           << " AcquisitionRate=\"" << 1.0 / FRAME_PERIOD_SEC << "\" UseData=\"IMAGE\""
+           << " RepeatEnabled=\"" << (options.RepeatEnabled ? "TRUE" : "FALSE") << "\""
+           << " UseOriginalTimestamps=\"" << (options.UseOriginalTimestamps ? "TRUE" : "FALSE") << "\""
+           << " StreamingEnabled=\"" << (streamingEnabled ? "TRUE" : "FALSE") << "\" StreamingReadAheadFrames=\"4\">"
+           << "<DataSources><DataSource Type=\"Video\" Id=\"Video\" PortUsImageOrientation=\"MF\" BufferSize=\"" << 2 * NUMBER_OF_REPLAY_STEPS << "\" /></DataSources>"
+           << "<OutputChannels><OutputChannel Id=\"VideoStream\" VideoDataSourceId=\"Video\" /></OutputChannels>"
+           << "</Device></DataCollection></PlusConfiguration>";
+    vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(config.str().c_str()));
+    vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+    vtkSmartPointer<vtkPlusDataCollector> dataCollector = vtkSmartPointer<vtkPlusDataCollector>::New();
+    if (dataCollector->ReadConfiguration(configRootElement) != PLUS_SUCCESS || dataCollector->Connect() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to connect to the saved data source");
+      return PLUS_FAIL;
+    }
+    vtkPlusDevice* device = NULL;
+    vtkPlusSavedDataSource* savedDataSource = NULL;
+    if (dataCollector->GetDevice(device, "SavedVideo") != PLUS_SUCCESS || (savedDataSource = dynamic_cast<vtkPlusSavedDataSource*>(device)) == NULL)
+    {
+      LOG_ERROR("Saved data source is not found");
+      return PLUS_FAIL;
+    }
+    if (savedDataSource->IsStreaming() != streamingEnabled)
+    {
+      LOG_ERROR("Saved data source is " << (streamingEnabled ? "not " : "") << "streaming");
+      return PLUS_FAIL;
+    }
+    if (options.LoopStopTime > options.LoopStartTime)
+    {
+      savedDataSource->SetLoopTimeRange(options.LoopStartTime, options.LoopStopTime);
+    }
+
+    // The clock is stepped here instead of by the data collector, so each replay has exactly the same steps
+    ReplayClock clock;
+    clock.SetMode(ReplayClock::REPLAY_CLOCK_AS_FAST_AS_POSSIBLE);
+    clock.SetTime(REPLAY_START_TIME);
+    savedDataSource->SetReplayClock(&clock);
+    PlusStatus status = savedDataSource->StartRecording();
+    savedDataSource->SetStartTime(REPLAY_START_TIME);
+    for (unsigned int step = 1; status == PLUS_SUCCESS && step <= NUMBER_OF_REPLAY_STEPS; ++step)
+    {
+      // Halfway between frames, so that the frame that is due is not sensitive to rounding
+      clock.SetTime(REPLAY_START_TIME + (step - 0.5) * FRAME_PERIOD_SEC);
+      status = savedDataSource->UpdateOnReplayClock();
+    }
+    savedDataSource->StopRecording();
+    savedDataSource->SetReplayClock(NULL);
+    if (status != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Replay failed");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+
+    vtkPlusDataSource* videoSource = NULL;
+    if (savedDataSource->GetFirstVideoSource(videoSource) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Saved data source has no video source");
+      dataCollector->Disconnect();
+      return PLUS_FAIL;
+    }
+    if (videoSource->GetNumberOfItems() > 0)
+    {
+      for (BufferItemUidType uid = videoSource->GetOldestItemUidInBuffer(); uid <= videoSource->GetLatestItemUidInBuffer(); ++uid)
+      {
+        StreamBufferItem item;
+        if (videoSource->GetStreamBufferItem(uid, &item) != ITEM_OK)
+        {
+          LOG_ERROR("Failed to get replayed item " << uid);
+          dataCollector->Disconnect();
+          return PLUS_FAIL;
+        }
+        ReplayedFrame frame;
+        frame.Timestamp = item.GetFilteredTimestamp(0);
+        const unsigned char* pixels = static_cast<const unsigned char*>(item.GetFrame().GetScalarPointer());
+        frame.Pixels.assign(pixels, pixels + item.GetFrame().GetFrameSizeInBytes());
+        replayedFrames.push_back(frame);
+      }
+    }
+    dataCollector->Disconnect();
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Index of the frame of the sequence file that was replayed, identified by its pixel values */
+  unsigned int GetReplayedFrameIndex(const ReplayedFrame& frame)
+  {
+    for (unsigned int frameIndex = 0; frameIndex < NUMBER_OF_FRAMES; ++frameIndex)
+    {
+      if (frame.Pixels[0] == PlusTestFrames::GetPixelValue(frameIndex, 0) && frame.Pixels[1] == PlusTestFrames::GetPixelValue(frameIndex, 1))
+      {
+        return frameIndex;
+      }
+    }
+    return NUMBER_OF_FRAMES;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestReplay(const std::string& sequenceFilename, const ReplayOptions& options)
+  {
+    std::vector<ReplayedFrame> loadedFrames;
+    std::vector<ReplayedFrame> streamedFrames;
+    if (Replay(sequenceFilename, options, false, loadedFrames) != PLUS_SUCCESS
+        || Replay(sequenceFilename, options, true, streamedFrames) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Replay with " << GetOptionsAsString(options) << " failed");
+      return PLUS_FAIL;
+    }
+
+    if (loadedFrames.empty() || streamedFrames.size() != loadedFrames.size())
+    {
+      LOG_ERROR("Replay with " << GetOptionsAsString(options) << " produced " << streamedFrames.size() << " frames with streaming and "
+                << loadedFrames.size() << " frames without streaming");
+      return PLUS_FAIL;
+    }
+    for (std::vector<ReplayedFrame>::size_type i = 0; i < loadedFrames.size(); ++i)
+    {
+      if (fabs(streamedFrames[i].Timestamp - loadedFrames[i].Timestamp) > TIMESTAMP_TOLERANCE_SEC || streamedFrames[i].Pixels != loadedFrames[i].Pixels)
+      {
+        LOG_ERROR("Replay with " << GetOptionsAsString(options) << ": streamed frame " << i << " (frame " << GetReplayedFrameIndex(streamedFrames[i])
+                  << ", timestamp " << std::fixed << streamedFrames[i].Timestamp << ") differs from the loaded frame (frame "
+                  << GetReplayedFrameIndex(loadedFrames[i]) << ", timestamp " << loadedFrames[i].Timestamp << ")");
+        return PLUS_FAIL;
+      }
+    }
+
+    // The frames must be replayed in file order within the loop range, starting over only if repeat is enabled
+    unsigned int firstLoopFrameIndex = 0;
+    unsigned int lastLoopFrameIndex = NUMBER_OF_FRAMES - 1;
+    if (options.LoopStopTime > options.LoopStartTime)
+    {
+      firstLoopFrameIndex = static_cast<unsigned int>(floor(options.LoopStartTime / FRAME_PERIOD_SEC + 0.5));
+      lastLoopFrameIndex = static_cast<unsigned int>(floor(options.LoopStopTime / FRAME_PERIOD_SEC + 0.5));
+    }
+    unsigned int numberOfLoops = 1;
+    for (std::vector<ReplayedFrame>::size_type i = 0; i < loadedFrames.size(); ++i)
+    {
+      const unsigned int frameIndex = GetReplayedFrameIndex(loadedFrames[i]);
+      if (frameIndex < firstLoopFrameIndex || frameIndex > lastLoopFrameIndex)
+      {
+        LOG_ERROR("Replay with " << GetOptionsAsString(options) << ": frame " << frameIndex << " is replayed, it is outside of the loop range");
+        return PLUS_FAIL;
+      }
+      if (i > 0 && frameIndex < GetReplayedFrameIndex(loadedFrames[i - 1]))
+      {
+        numberOfLoops++;
+      }
+      if (options.UseOriginalTimestamps && i > 0 && frameIndex > GetReplayedFrameIndex(loadedFrames[i - 1])
+          && fabs(loadedFrames[i].Timestamp - loadedFrames[i - 1].Timestamp - (frameIndex - GetReplayedFrameIndex(loadedFrames[i - 1])) * FRAME_PERIOD_SEC) > TIMESTAMP_TOLERANCE_SEC)
+      {
+        LOG_ERROR("Replay with " << GetOptionsAsString(options) << ": original time difference between frames is not kept at frame " << frameIndex);
+        return PLUS_FAIL;
+      }
+    }
+    if ((numberOfLoops > 1) != options.RepeatEnabled)
+    {
+      LOG_ERROR("Replay with " << GetOptionsAsString(options) << " looped " << numberOfLoops << " times");
+      return PLUS_FAIL;
+    }
+
+    LOG_INFO("Replay with " << GetOptionsAsString(options) << ": " << loadedFrames.size() << " frames in " << numberOfLoops << " loops");
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  const std::string filename = vtkPlusConfig::GetInstance()->GetOutputPath("vtkPlusSavedDataSourceStreamingTest.nrrd");
+  vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+  if (PlusTestFrames::AddFrames(frameList, 0, NUMBER_OF_FRAMES, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS
+      || vtkPlusSequenceIO::Write(filename, frameList, US_IMG_ORIENT_MF, false) != PLUS_SUCCESS
+      || SequenceFrameIndex::Build(filename) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to write indexed sequence file: " << filename);
+    return EXIT_FAILURE;
+  }
+
+  int exitCode = EXIT_SUCCESS;
+  for (unsigned int i = 0; i < sizeof(REPLAY_OPTIONS) / sizeof(REPLAY_OPTIONS[0]); ++i)
+  {
+    if (TestReplay(filename, REPLAY_OPTIONS[i]) != PLUS_SUCCESS)
+    {
+      exitCode = EXIT_FAILURE;
+    }
+  }
+
+  vtksys::SystemTools::RemoveFile(SequenceFrameIndex::GetIndexFileName(filename));
+  vtksys::SystemTools::RemoveFile(filename);
+
+  if (exitCode == EXIT_SUCCESS)
+  {
+    LOG_INFO("Test completed successfully");
+  }
+  return exitCode;
+}
@@ -0,0 +1,510 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusVirtualCaptureWriteQueueTest.cxx
+  \brief Test that the capture device records through the writer thread
+
+  Frames are handed over to the writer thread while the writer is held back, so that they pile up in
+  the write queue. Without a queue limit all frames must be written when the file is closed. With a
+  queue limit the frames that do not fit in the queue must be dropped and counted, and the written file
+  must contain only the queued frames. Reset must discard the queued frames.
+
+  If segment files are written then the capture thread only queues the end of each segment, and the writer
+  thread finalizes the segments. Each segment file must contain the frames recorded until its duration or
+  size limit was reached. Closing the recording renames the segment index, and Reset deletes the segments.
+*/
+
+#include "PlusConfigure.h"
+#include "PlusSequenceSegmentIndex.h"
+#include "PlusTestFrames.h"
+#include "vtkPlusSequenceIO.h"
+#include "vtkPlusVirtualCapture.h"
+#include "vtksys/CommandLineArguments.hxx"
+#include "vtksys/SystemTools.hxx"
+
+// VTK includes
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// STL includes
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+namespace
+{
+  const FrameSizeType FRAME_SIZE = { 16, 12, 1 };
+  const unsigned int FRAMES_PER_BATCH = 5;
+  const unsigned int NUMBER_OF_BATCHES = 6;
+  const double FRAME_PERIOD_SEC = 0.1;
+  // A segment is full after the third batch: the time span of its frames reaches the limit
+  const double SEGMENT_FILE_DURATION_SEC = 1.0;
+  const unsigned int BATCHES_PER_SEGMENT_BY_DURATION = 3;
+  // A segment is full after each batch: the size of the batch exceeds the limit
+  const double SEGMENT_FILE_MAX_SIZE_MB = 3.0 * 16 * 12 / (1024.0 * 1024.0);
+  const unsigned int NUMBER_OF_SEGMENT_BATCHES = 7;
+}
+
+//----------------------------------------------------------------------------
+/*! Capture device with a writer thread that can be held back, to fill the write queue */
+class vtkPlusVirtualCaptureWriteQueueTestDevice : public vtkPlusVirtualCapture
+{
+public:
+  static vtkPlusVirtualCaptureWriteQueueTestDevice* New();
+  vtkTypeMacro(vtkPlusVirtualCaptureWriteQueueTestDevice, vtkPlusVirtualCapture);
+
+  void StartWriter()
+  {
+    this->StartWriterThread();
+  }
+
+  void StopWriter()
+  {
+    this->StopWriterThread();
+  }
+
+  /*! Frames are not written until the writer is released */
+  void HoldWriter()
+  {
+    std::lock_guard<std::mutex> lock(this->WriterGateMutex);
+    this->WriterHeld = true;
+  }
+
+  void ReleaseWriter()
+  {
+    {
+      std::lock_guard<std::mutex> lock(this->WriterGateMutex);
+      this->WriterHeld = false;
+    }
+    this->WriterGateCondition.notify_all();
+  }
+
+  /*! Add a batch of frames to the recording and hand it over to the writer thread, as the capture thread does */
+  PlusStatus RecordBatch(unsigned int firstFrameIndex)
+  {
+    const int firstNewFrameIndex = this->RecordedFrames->GetNumberOfTrackedFrames();
+    if (PlusTestFrames::AddFrames(this->RecordedFrames, firstFrameIndex, FRAMES_PER_BATCH, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    return this->WriteRecordedFrames(firstNewFrameIndex);
+  }
+
+protected:
+  vtkPlusVirtualCaptureWriteQueueTestDevice()
+    : WriterHeld(false)
+  {
+    // Every batch is handed over to the writer thread
+    this->SetFrameBufferSize(0);
+  }
+
+  virtual PlusStatus WriteFrameList(vtkIGSIOTrackedFrameList* frameList) VTK_OVERRIDE
+  {
+    {
+      std::unique_lock<std::mutex> lock(this->WriterGateMutex);
+      while (this->WriterHeld)
+      {
+        this->WriterGateCondition.wait(lock);
+      }
+    }
+    return Superclass::WriteFrameList(frameList);
+  }
+
+  std::mutex WriterGateMutex;
+  std::condition_variable WriterGateCondition;
+  bool WriterHeld;
+};
+
+vtkStandardNewMacro(vtkPlusVirtualCaptureWriteQueueTestDevice);
+
+namespace
+{
+  //----------------------------------------------------------------------------
+  /*! Check that the file contains the given number of frames, recorded in order from the first frame index */
+  PlusStatus CheckWrittenFile(const std::string& filename, unsigned int firstFrameIndex, unsigned int numberOfFrames)
+  {
+    vtkSmartPointer<vtkIGSIOTrackedFrameList> frameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
+    if (vtkPlusSequenceIO::Read(filename, frameList) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to read recorded file: " << filename);
+      return PLUS_FAIL;
+    }
+    if (PlusTestFrames::CheckFrames(frameList, firstFrameIndex, numberOfFrames, FRAME_SIZE, FRAME_PERIOD_SEC) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Frames of " << filename << " do not match the recorded frames");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  std::string GetSegmentFileName(const std::string& filename, unsigned int segmentNumber)
+  {
+    std::ostringstream segmentFilename;
+    segmentFilename << igsioCommon::GetSequenceFilenameWithoutExtension(filename) << "_seg" << std::setfill('0') << std::setw(4) << segmentNumber << ".nrrd";
+    return vtkPlusConfig::GetInstance()->GetOutputPath(segmentFilename.str());
+  }
+
+  //----------------------------------------------------------------------------
+  std::string GetSegmentIndexFileName(const std::string& filename)
+  {
+    return vtkPlusConfig::GetInstance()->GetOutputPath(igsioCommon::GetSequenceFilenameWithoutExtension(filename) + SequenceSegmentIndex::GetFileExtension());
+  }
+
+  //----------------------------------------------------------------------------
+  /*!
+    Record NUMBER_OF_SEGMENT_BATCHES batches into segment files while the writer is held back, then close the recording
+    with a new name. The segment files must contain batchesPerSegment batches each and the index must be renamed.
+  */
+  PlusStatus TestSegmentFiles(vtkPlusVirtualCaptureWriteQueueTestDevice* capture, const std::string& filename, const std::string& closedFilename, unsigned int batchesPerSegment)
+  {
+    if (capture->OpenFile(filename.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open " << filename);
+      return PLUS_FAIL;
+    }
+
+    // Segment files are finalized by the writer thread, so recording continues while the writer is held back
+    capture->HoldWriter();
+    for (unsigned int batch = 0; batch < NUMBER_OF_SEGMENT_BATCHES; ++batch)
+    {
+      if (capture->RecordBatch(batch * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to record batch " << batch);
+        return PLUS_FAIL;
+      }
+    }
+    if (capture->GetWriteQueueDepth() != NUMBER_OF_SEGMENT_BATCHES * FRAMES_PER_BATCH || vtksys::SystemTools::FileExists(GetSegmentIndexFileName(filename)))
+    {
+      LOG_ERROR("Segment files are finalized on the capture thread");
+      return PLUS_FAIL;
+    }
+    capture->ReleaseWriter();
+
+    std::string resultFilename;
+    if (capture->CloseFile(closedFilename.c_str(), &resultFilename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to close " << filename);
+      return PLUS_FAIL;
+    }
+    if (resultFilename != GetSegmentIndexFileName(closedFilename) || vtksys::SystemTools::FileExists(GetSegmentIndexFileName(filename)))
+    {
+      LOG_ERROR("Segment index is written to " << resultFilename << " instead of " << GetSegmentIndexFileName(closedFilename));
+      return PLUS_FAIL;
+    }
+    if (CheckWrittenFile(resultFilename, 0, NUMBER_OF_SEGMENT_BATCHES * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    // Each segment starts with the first frame that was recorded after the previous segment was full
+    const unsigned int numberOfSegments = (NUMBER_OF_SEGMENT_BATCHES + batchesPerSegment - 1) / batchesPerSegment;
+    for (unsigned int segment = 0; segment < numberOfSegments; ++segment)
+    {
+      const unsigned int firstBatch = segment * batchesPerSegment;
+      const unsigned int numberOfBatches = std::min(batchesPerSegment, NUMBER_OF_SEGMENT_BATCHES - firstBatch);
+      if (CheckWrittenFile(GetSegmentFileName(filename, segment), firstBatch * FRAMES_PER_BATCH, numberOfBatches * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Segment " << segment << " does not contain the expected frames");
+        return PLUS_FAIL;
+      }
+    }
+    if (vtksys::SystemTools::FileExists(GetSegmentFileName(filename, numberOfSegments)))
+    {
+      LOG_ERROR("More than " << numberOfSegments << " segment files are written");
+      return PLUS_FAIL;
+    }
+
+    for (unsigned int segment = 0; segment < numberOfSegments; ++segment)
+    {
+      vtksys::SystemTools::RemoveFile(GetSegmentFileName(filename, segment));
+    }
+    vtksys::SystemTools::RemoveFile(resultFilename);
+    vtksys::SystemTools::RemoveFile(vtkPlusConfig::GetInstance()->GetOutputPath(igsioCommon::GetSequenceFilenameWithoutExtension(closedFilename) + "_config.xml"));
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Reset deletes the finalized segment files and the segment index */
+  PlusStatus TestResetSegmentFiles(vtkPlusVirtualCaptureWriteQueueTestDevice* capture, const std::string& filename)
+  {
+    if (capture->OpenFile(filename.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open " << filename);
+      return PLUS_FAIL;
+    }
+    for (unsigned int batch = 0; batch < NUMBER_OF_SEGMENT_BATCHES; ++batch)
+    {
+      if (capture->RecordBatch(batch * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to record batch " << batch);
+        return PLUS_FAIL;
+      }
+    }
+    if (capture->Reset() != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to reset the capture device");
+      return PLUS_FAIL;
+    }
+    for (unsigned int segment = 0; segment < NUMBER_OF_SEGMENT_BATCHES; ++segment)
+    {
+      if (vtksys::SystemTools::FileExists(GetSegmentFileName(filename, segment)))
+      {
+        LOG_ERROR("Segment file " << GetSegmentFileName(filename, segment) << " is not deleted by reset");
+        return PLUS_FAIL;
+      }
+    }
+    if (vtksys::SystemTools::FileExists(GetSegmentIndexFileName(filename)) || capture->HasUnsavedData())
+    {
+      LOG_ERROR("Segment index is not deleted by reset");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Without a queue limit the writer thread may fall behind, but all frames are written when the file is closed */
+  PlusStatus TestUnlimitedQueue(vtkPlusVirtualCaptureWriteQueueTestDevice* capture, const std::string& filename)
+  {
+    // The queue is limited by default, so that the memory use is bounded
+    if (capture->GetWriteQueueMaxNumberOfFrames() == 0)
+    {
+      LOG_ERROR("Write queue is not limited by default");
+      return PLUS_FAIL;
+    }
+    capture->SetWriteQueueMaxNumberOfFrames(0);
+    if (capture->OpenFile(filename.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open " << filename);
+      return PLUS_FAIL;
+    }
+
+    capture->HoldWriter();
+    for (unsigned int batch = 0; batch < NUMBER_OF_BATCHES; ++batch)
+    {
+      if (capture->RecordBatch(batch * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to record batch " << batch);
+        return PLUS_FAIL;
+      }
+    }
+    if (capture->GetWriteQueueDepth() != NUMBER_OF_BATCHES * FRAMES_PER_BATCH || capture->GetNumberOfDroppedFrames() != 0)
+    {
+      LOG_ERROR("Write queue has " << capture->GetWriteQueueDepth() << " frames and " << capture->GetNumberOfDroppedFrames()
+                << " dropped frames instead of " << NUMBER_OF_BATCHES * FRAMES_PER_BATCH << " frames and no dropped frames");
+      return PLUS_FAIL;
+    }
+    if (capture->GetMaximumWriteQueueDepth() != NUMBER_OF_BATCHES * FRAMES_PER_BATCH)
+    {
+      LOG_ERROR("Maximum write queue depth is " << capture->GetMaximumWriteQueueDepth() << " instead of " << NUMBER_OF_BATCHES * FRAMES_PER_BATCH);
+      return PLUS_FAIL;
+    }
+    capture->ReleaseWriter();
+
+    // Closing the file waits for the writer thread
+    std::string resultFilename;
+    if (capture->CloseFile(filename.c_str(), &resultFilename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to close " << filename);
+      return PLUS_FAIL;
+    }
+    if (capture->GetWriteQueueDepth() != 0)
+    {
+      LOG_ERROR("Write queue has " << capture->GetWriteQueueDepth() << " frames after closing the file");
+      return PLUS_FAIL;
+    }
+    return CheckWrittenFile(resultFilename, 0, NUMBER_OF_BATCHES * FRAMES_PER_BATCH);
+  }
+
+  //----------------------------------------------------------------------------
+  /*! With a queue limit the frames that do not fit in the queue are dropped */
+  PlusStatus TestLimitedQueue(vtkPlusVirtualCaptureWriteQueueTestDevice* capture, const std::string& filename)
+  {
+    const unsigned int queuedBatches = 2;
+    capture->SetWriteQueueMaxNumberOfFrames(queuedBatches * FRAMES_PER_BATCH);
+    if (capture->OpenFile(filename.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open " << filename);
+      return PLUS_FAIL;
+    }
+
+    capture->HoldWriter();
+    // Every drop is reported as a warning, which is expected here
+    const int logLevel = vtkPlusLogger::Instance()->GetLogLevel();
+    vtkPlusLogger::Instance()->SetLogLevel(vtkPlusLogger::LOG_LEVEL_ERROR);
+    for (unsigned int batch = 0; batch < NUMBER_OF_BATCHES; ++batch)
+    {
+      if (capture->RecordBatch(batch * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to record batch " << batch);
+        return PLUS_FAIL;
+      }
+    }
+    vtkPlusLogger::Instance()->SetLogLevel(logLevel);
+
+    const unsigned long expectedDroppedFrames = (NUMBER_OF_BATCHES - queuedBatches) * FRAMES_PER_BATCH;
+    if (capture->GetNumberOfDroppedFrames() != expectedDroppedFrames || capture->GetTotalFramesRecorded() != static_cast<long>(queuedBatches * FRAMES_PER_BATCH))
+    {
+      LOG_ERROR("Dropped " << capture->GetNumberOfDroppedFrames() << " frames and recorded " << capture->GetTotalFramesRecorded()
+                << " frames instead of " << expectedDroppedFrames << " and " << queuedBatches * FRAMES_PER_BATCH);
+      return PLUS_FAIL;
+    }
+    capture->ReleaseWriter();
+
+    std::string resultFilename;
+    if (capture->CloseFile(filename.c_str(), &resultFilename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to close " << filename);
+      return PLUS_FAIL;
+    }
+    if (CheckWrittenFile(resultFilename, 0, queuedBatches * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    // The count is restarted for the next file
+    if (capture->GetNumberOfDroppedFrames() != 0)
+    {
+      LOG_ERROR("Dropped frame count is not reset when the next file is opened");
+      return PLUS_FAIL;
+    }
+    capture->SetWriteQueueMaxNumberOfFrames(0);
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  /*! Reset discards the queued frames, and only the frames recorded afterwards are written */
+  PlusStatus TestReset(vtkPlusVirtualCaptureWriteQueueTestDevice* capture, const std::string& filename)
+  {
+    if (capture->OpenFile(filename.c_str()) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to open " << filename);
+      return PLUS_FAIL;
+    }
+
+    capture->HoldWriter();
+    for (unsigned int batch = 0; batch < NUMBER_OF_BATCHES; ++batch)
+    {
+      if (capture->RecordBatch(batch * FRAMES_PER_BATCH) != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to record batch " << batch);
+        return PLUS_FAIL;
+      }
+    }
+    // Reset waits for the frame list that is being written, so the writer is released while reset is in progress
+    std::thread releaseThread([capture]()
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      capture->ReleaseWriter();
+    });
+    PlusStatus resetStatus = capture->Reset();
+    releaseThread.join();
+    if (resetStatus != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to reset the capture device");
+      return PLUS_FAIL;
+    }
+    if (capture->GetWriteQueueDepth() != 0 || capture->HasUnsavedData())
+    {
+      LOG_ERROR("Write queue has " << capture->GetWriteQueueDepth() << " frames after reset");
+      return PLUS_FAIL;
+    }
+
+    const unsigned int firstFrameIndexAfterReset = NUMBER_OF_BATCHES * FRAMES_PER_BATCH;
+    if (capture->RecordBatch(firstFrameIndexAfterReset) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to record after reset");
+      return PLUS_FAIL;
+    }
+    std::string resultFilename;
+    if (capture->CloseFile(filename.c_str(), &resultFilename) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to close " << filename);
+      return PLUS_FAIL;
+    }
+    return CheckWrittenFile(resultFilename, firstFrameIndexAfterReset, FRAMES_PER_BATCH);
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  // The device set configuration is saved next to the recorded files
+  vtkSmartPointer<vtkXMLDataElement> configRootElement = vtkSmartPointer<vtkXMLDataElement>::Take(
+        vtkXMLUtilities::ReadElementFromString("<PlusConfiguration><DataCollection /></PlusConfiguration>"));
+  vtkPlusConfig::GetInstance()->SetDeviceSetConfigurationData(configRootElement);
+
+  vtkSmartPointer<vtkPlusVirtualCaptureWriteQueueTestDevice> capture = vtkSmartPointer<vtkPlusVirtualCaptureWriteQueueTestDevice>::New();
+  capture->SetDeviceId("CaptureDevice");
+  capture->StartWriter();
+
+  const std::string filenameRoot = "vtkPlusVirtualCaptureWriteQueueTest";
+  PlusStatus status = PLUS_SUCCESS;
+  if (TestUnlimitedQueue(capture, filenameRoot + "_Unlimited.nrrd") != PLUS_SUCCESS
+      || TestLimitedQueue(capture, filenameRoot + "_Limited.nrrd") != PLUS_SUCCESS
+      || TestReset(capture, filenameRoot + "_Reset.nrrd") != PLUS_SUCCESS)
+  {
+    status = PLUS_FAIL;
+  }
+
+  capture->SetSegmentFileDurationSec(SEGMENT_FILE_DURATION_SEC);
+  if (status == PLUS_SUCCESS
+      && (TestSegmentFiles(capture, filenameRoot + "_Duration.nrrd", filenameRoot + "_DurationClosed.nrrd", BATCHES_PER_SEGMENT_BY_DURATION) != PLUS_SUCCESS
+          || TestResetSegmentFiles(capture, filenameRoot + "_DurationReset.nrrd") != PLUS_SUCCESS))
+  {
+    status = PLUS_FAIL;
+  }
+  capture->SetSegmentFileDurationSec(0.0);
+  capture->SetSegmentFileMaxSizeMB(SEGMENT_FILE_MAX_SIZE_MB);
+  if (status == PLUS_SUCCESS && TestSegmentFiles(capture, filenameRoot + "_Size.nrrd", filenameRoot + "_SizeClosed.nrrd", 1) != PLUS_SUCCESS)
+  {
+    status = PLUS_FAIL;
+  }
+  capture->ReleaseWriter();
+  capture->StopWriter();
+
+  const char* suffixes[] = { "_Unlimited", "_Limited", "_Reset" };
+  for (unsigned int i = 0; i < sizeof(suffixes) / sizeof(suffixes[0]); ++i)
+  {
+    vtksys::SystemTools::RemoveFile(vtkPlusConfig::GetInstance()->GetOutputPath(filenameRoot + suffixes[i] + ".nrrd"));
+    vtksys::SystemTools::RemoveFile(vtkPlusConfig::GetInstance()->GetOutputPath(filenameRoot + suffixes[i] + "_config.xml"));
+  }
+
+  if (status != PLUS_SUCCESS)
+  {
+    return EXIT_FAILURE;
+  }
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,322 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+/*!
+  \file vtkPlusVirtualMixerActiveModeTest.cxx
+  \brief Test that the mixer resamples the input tools to one output timeline in active mixing mode
+
+  Two trackers are mixed: the first one defines the timeline, the second one is sampled with a constant
+  time offset. The output poses and the skew statistics are checked for all sync policies, and the
+  WAIT_FOR_ALL policy is checked to hold back items until the late input catches up or the deadline is reached.
+  The mixing settings must be written to the device configuration.
+*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusChannel.h"
+#include "vtkPlusDataSource.h"
+#include "vtkPlusVirtualMixer.h"
+#include "vtksys/CommandLineArguments.hxx"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkXMLDataElement.h>
+#include <vtkXMLUtilities.h>
+
+// STL includes
+#include <cmath>
+
+namespace
+{
+  const double ITEM_PERIOD_SEC = 0.01;
+  const double PROBE_TIME_OFFSET_SEC = 0.004;
+  const double TIMESTAMP_TOLERANCE_SEC = 1e-6;
+
+  //----------------------------------------------------------------------------
+  /*! Add items for k = firstItem..lastItem at k * ITEM_PERIOD_SEC + timeOffsetSec, the x translation is the timestamp in ms */
+  PlusStatus AddItems(vtkPlusDataSource* tool, int firstItem, int lastItem, double timeOffsetSec)
+  {
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    for (int k = firstItem; k <= lastItem; ++k)
+    {
+      double timestamp = k * ITEM_PERIOD_SEC + timeOffsetSec;
+      matrix->SetElement(0, 3, timestamp * 1000.0);
+      if (tool->AddTimeStampedItem(matrix, TOOL_OK, k, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  vtkSmartPointer<vtkPlusChannel> CreateTrackerChannel(const std::string& channelId, const std::string& toolId)
+  {
+    vtkSmartPointer<vtkPlusDataSource> tool = vtkSmartPointer<vtkPlusDataSource>::New();
+    tool->SetId(toolId);
+    tool->SetType(DATA_SOURCE_TYPE_TOOL);
+    tool->SetReferenceCoordinateFrameName("Tracker");
+    tool->SetBufferSize(500);
+    vtkSmartPointer<vtkPlusChannel> channel = vtkSmartPointer<vtkPlusChannel>::New();
+    channel->SetChannelId(channelId.c_str());
+    channel->AddTool(tool);
+    return channel;
+  }
+
+  //----------------------------------------------------------------------------
+  class MixerTestSetup
+  {
+  public:
+    MixerTestSetup(vtkPlusVirtualMixer::SyncPolicyType syncPolicy)
+    {
+      this->ReferenceChannel = CreateTrackerChannel("ReferenceStream", "ReferenceToTracker");
+      this->ProbeChannel = CreateTrackerChannel("ProbeStream", "ProbeToTracker");
+      this->ReferenceChannel->GetTool(this->ReferenceTool, "ReferenceToTracker");
+      this->ProbeChannel->GetTool(this->ProbeTool, "ProbeToTracker");
+
+      this->OutputChannel = vtkSmartPointer<vtkPlusChannel>::New();
+      this->OutputChannel->SetChannelId("MixedStream");
+
+      this->Mixer = vtkSmartPointer<vtkPlusVirtualMixer>::New();
+      this->Mixer->SetDeviceId("Mixer");
+      this->Mixer->SetMixingMode(vtkPlusVirtualMixer::MIXING_MODE_ACTIVE);
+      this->Mixer->SetSyncPolicy(syncPolicy);
+      this->Mixer->SetSyncDeadlineSec(0.1);
+      this->Mixer->AddInputChannel(this->ReferenceChannel);
+      this->Mixer->AddInputChannel(this->ProbeChannel);
+      this->Mixer->AddOutputChannel(this->OutputChannel);
+    }
+
+    vtkSmartPointer<vtkPlusChannel> ReferenceChannel;
+    vtkSmartPointer<vtkPlusChannel> ProbeChannel;
+    vtkSmartPointer<vtkPlusChannel> OutputChannel;
+    vtkPlusDataSource* ReferenceTool;
+    vtkPlusDataSource* ProbeTool;
+    vtkSmartPointer<vtkPlusVirtualMixer> Mixer;
+  };
+
+  //----------------------------------------------------------------------------
+  /*! Check the probe x translation in the mixed frame at the timestamp */
+  PlusStatus CheckMixedProbePosition(vtkPlusChannel* outputChannel, double timestamp, double expectedX)
+  {
+    igsioTrackedFrame trackedFrame;
+    if (outputChannel->GetTrackedFrame(timestamp, trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get mixed frame at " << timestamp);
+      return PLUS_FAIL;
+    }
+    vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    if (trackedFrame.GetFrameTransform(igsioTransformName("Probe", "Tracker"), matrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Mixed frame does not contain the ProbeToTracker transform");
+      return PLUS_FAIL;
+    }
+    if (std::fabs(matrix->GetElement(0, 3) - expectedX) > 1e-3)
+    {
+      LOG_ERROR("Mixed probe position at " << timestamp << " is " << matrix->GetElement(0, 3) << ", expected " << expectedX);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus CheckSkewStatistics(vtkPlusVirtualMixer* mixer, unsigned long expectedNumberOfMixedItems, double expectedMaximumAbsoluteSkewSec, unsigned long expectedNumberOfMissedDeadlines)
+  {
+    vtkPlusVirtualMixer::SkewStatistics statistics;
+    if (mixer->GetInputSkewStatistics("ProbeToTracker", statistics) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    if (statistics.NumberOfMixedItems != expectedNumberOfMixedItems
+        || std::fabs(statistics.MaximumAbsoluteSkewSec - expectedMaximumAbsoluteSkewSec) > TIMESTAMP_TOLERANCE_SEC
+        || statistics.NumberOfMissedDeadlines != expectedNumberOfMissedDeadlines)
+    {
+      LOG_ERROR("Probe skew statistics: mixed items " << statistics.NumberOfMixedItems << " (expected " << expectedNumberOfMixedItems << "), "
+                << "maximum absolute skew " << statistics.MaximumAbsoluteSkewSec << " (expected " << expectedMaximumAbsoluteSkewSec << "), "
+                << "missed deadlines " << statistics.NumberOfMissedDeadlines << " (expected " << expectedNumberOfMissedDeadlines << ")");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestNearest()
+  {
+    MixerTestSetup setup(vtkPlusVirtualMixer::SYNC_POLICY_NEAREST);
+    if (setup.Mixer->NotifyConfigured() != PLUS_SUCCESS
+        || AddItems(setup.ReferenceTool, 1, 100, 0) != PLUS_SUCCESS
+        || AddItems(setup.ProbeTool, 1, 100, PROBE_TIME_OFFSET_SEC) != PLUS_SUCCESS
+        || setup.Mixer->MixNewItems(10.0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to mix the inputs");
+      return PLUS_FAIL;
+    }
+    // The probe item acquired 4ms later is the nearest one
+    if (CheckMixedProbePosition(setup.OutputChannel, 50 * ITEM_PERIOD_SEC, (50 * ITEM_PERIOD_SEC + PROBE_TIME_OFFSET_SEC) * 1000.0) != PLUS_SUCCESS
+        || CheckSkewStatistics(setup.Mixer, 100, PROBE_TIME_OFFSET_SEC, 0) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    vtkPlusVirtualMixer::SkewStatistics statistics;
+    setup.Mixer->GetInputSkewStatistics("ProbeToTracker", statistics);
+    if (std::fabs(statistics.GetMeanSkewSec() - PROBE_TIME_OFFSET_SEC) > TIMESTAMP_TOLERANCE_SEC)
+    {
+      LOG_ERROR("Mean probe skew is " << statistics.GetMeanSkewSec() << ", expected " << PROBE_TIME_OFFSET_SEC);
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestInterpolate()
+  {
+    MixerTestSetup setup(vtkPlusVirtualMixer::SYNC_POLICY_INTERPOLATE);
+    if (setup.Mixer->NotifyConfigured() != PLUS_SUCCESS
+        || AddItems(setup.ReferenceTool, 1, 100, 0) != PLUS_SUCCESS
+        || AddItems(setup.ProbeTool, 1, 100, PROBE_TIME_OFFSET_SEC) != PLUS_SUCCESS
+        || setup.Mixer->MixNewItems(10.0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to mix the inputs");
+      return PLUS_FAIL;
+    }
+    // Mixing the same items again has no effect
+    if (setup.Mixer->MixNewItems(10.0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to mix the inputs again");
+      return PLUS_FAIL;
+    }
+    // The probe moves linearly, so the interpolated position matches the timestamp
+    if (CheckMixedProbePosition(setup.OutputChannel, 50 * ITEM_PERIOD_SEC, 50 * ITEM_PERIOD_SEC * 1000.0) != PLUS_SUCCESS
+        || CheckMixedProbePosition(setup.OutputChannel, 73 * ITEM_PERIOD_SEC, 73 * ITEM_PERIOD_SEC * 1000.0) != PLUS_SUCCESS
+        || CheckSkewStatistics(setup.Mixer, 100, PROBE_TIME_OFFSET_SEC, 0) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestWaitForAll()
+  {
+    MixerTestSetup setup(vtkPlusVirtualMixer::SYNC_POLICY_WAIT_FOR_ALL);
+    if (setup.Mixer->NotifyConfigured() != PLUS_SUCCESS
+        || AddItems(setup.ReferenceTool, 1, 100, 0) != PLUS_SUCCESS
+        || AddItems(setup.ProbeTool, 1, 50, PROBE_TIME_OFFSET_SEC) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set up the inputs");
+      return PLUS_FAIL;
+    }
+
+    // Items after the latest probe item are held back until the deadline
+    if (setup.Mixer->MixNewItems(0.6) != PLUS_SUCCESS || CheckSkewStatistics(setup.Mixer, 50, PROBE_TIME_OFFSET_SEC, 0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Items are not held back for the late input");
+      return PLUS_FAIL;
+    }
+
+    // The late input catches up
+    if (AddItems(setup.ProbeTool, 51, 100, PROBE_TIME_OFFSET_SEC) != PLUS_SUCCESS
+        || setup.Mixer->MixNewItems(0.6) != PLUS_SUCCESS
+        || CheckSkewStatistics(setup.Mixer, 100, PROBE_TIME_OFFSET_SEC, 0) != PLUS_SUCCESS
+        || CheckMixedProbePosition(setup.OutputChannel, 80 * ITEM_PERIOD_SEC, 80 * ITEM_PERIOD_SEC * 1000.0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Held back items are not mixed after the late input caught up");
+      return PLUS_FAIL;
+    }
+
+    // The probe stops, the items are mixed with the latest probe pose when the deadline is reached
+    if (AddItems(setup.ReferenceTool, 101, 110, 0) != PLUS_SUCCESS
+        || setup.Mixer->MixNewItems(1.1) != PLUS_SUCCESS
+        || CheckSkewStatistics(setup.Mixer, 100, PROBE_TIME_OFFSET_SEC, 0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Items are mixed before the deadline");
+      return PLUS_FAIL;
+    }
+    if (setup.Mixer->MixNewItems(10.0) != PLUS_SUCCESS
+        || CheckSkewStatistics(setup.Mixer, 110, 110 * ITEM_PERIOD_SEC - (100 * ITEM_PERIOD_SEC + PROBE_TIME_OFFSET_SEC), 10) != PLUS_SUCCESS
+        || CheckMixedProbePosition(setup.OutputChannel, 105 * ITEM_PERIOD_SEC, (100 * ITEM_PERIOD_SEC + PROBE_TIME_OFFSET_SEC) * 1000.0) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Items are not mixed after the deadline");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+
+  //----------------------------------------------------------------------------
+  PlusStatus TestWriteConfiguration()
+  {
+    MixerTestSetup setup(vtkPlusVirtualMixer::SYNC_POLICY_WAIT_FOR_ALL);
+    setup.Mixer->SetSyncDeadlineSec(0.25);
+    vtkSmartPointer<vtkXMLDataElement> config = vtkSmartPointer<vtkXMLDataElement>::Take(vtkXMLUtilities::ReadElementFromString(
+          "<PlusConfiguration><DataCollection><Device Id=\"Mixer\" Type=\"VirtualMixer\" /></DataCollection></PlusConfiguration>"));
+    if (config == NULL || setup.Mixer->WriteConfiguration(config) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to write mixer configuration");
+      return PLUS_FAIL;
+    }
+    vtkXMLDataElement* deviceElement = config->FindNestedElementWithName("DataCollection")->FindNestedElementWithName("Device");
+    double syncDeadlineSec(0);
+    if (deviceElement->GetAttribute("MixingMode") == NULL || std::string(deviceElement->GetAttribute("MixingMode")) != "ACTIVE"
+        || deviceElement->GetAttribute("SyncPolicy") == NULL || std::string(deviceElement->GetAttribute("SyncPolicy")) != "WAIT_FOR_ALL"
+        || !deviceElement->GetScalarAttribute("SyncDeadlineSec", syncDeadlineSec) || std::fabs(syncDeadlineSec - 0.25) > 1e-9)
+    {
+      LOG_ERROR("Mixing settings are not written to the device configuration");
+      return PLUS_FAIL;
+    }
+    return PLUS_SUCCESS;
+  }
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+  bool printHelp(false);
+  int verboseLevel = vtkPlusLogger::LOG_LEVEL_UNDEFINED;
+
+  vtksys::CommandLineArguments args;
+  args.Initialize(argc, argv);
+
+  args.AddArgument("--help", vtksys::CommandLineArguments::NO_ARGUMENT, &printHelp, "Print this help.");
+  args.AddArgument("--verbose", vtksys::CommandLineArguments::EQUAL_ARGUMENT, &verboseLevel, "Verbose level (1=error only, 2=warning, 3=info, 4=debug, 5=trace)");
+
+  if (!args.Parse())
+  {
+    std::cerr << "Problem parsing arguments" << std::endl;
+    std::cout << "Help: " << args.GetHelp() << std::endl;
+    exit(EXIT_FAILURE);
+  }
+
+  if (printHelp)
+  {
+    std::cout << args.GetHelp() << std::endl;
+    exit(EXIT_SUCCESS);
+  }
+
+  vtkPlusLogger::Instance()->SetLogLevel(verboseLevel);
+
+  if (TestNearest() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("NEAREST sync policy test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestInterpolate() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("INTERPOLATE sync policy test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestWaitForAll() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("WAIT_FOR_ALL sync policy test failed");
+    return EXIT_FAILURE;
+  }
+  if (TestWriteConfiguration() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Configuration writing test failed");
+    return EXIT_FAILURE;
+  }
+
+  LOG_INFO("Test completed successfully");
+  return EXIT_SUCCESS;
+}
@@ -5,6 +5,7 @@ See License.txt for details.
 =========================================================Plus=header=end*/
 
 #include "PlusConfigure.h"
+#include "PlusSequenceFrameIndex.h"
 #include "igsioTrackedFrame.h"
 #include "vtkActorCollection.h"
 #include "vtkCallbackCommand.h"
@@ -21,7 +22,7 @@ See License.txt for details.
 #include "vtkRenderWindowInteractor.h"
 #include "vtkRenderer.h"
 #include "vtkRenderer.h"
-#include "vtkIGSIOSequenceIO.h"
+#include "vtkPlusSequenceIO.h"
 #include "vtkSmartPointer.h"
 #include "vtkTextActor.h"
 #include "vtkTextActor3D.h"
@@ -190,16 +191,22 @@ int main(int argc, char** argv)
   renderWindowInteractor->SetRenderWindow(renWin);
 
   // Read input tracked ultrasound data.
+  // If the sequence file has an up-to-date frame index then the frames are read one by one when they are added to the actors,
+  // so that the images are not kept in memory twice
   LOG_DEBUG("Reading input... ");
   vtkSmartPointer< vtkIGSIOTrackedFrameList > trackedFrameList = vtkSmartPointer< vtkIGSIOTrackedFrameList >::New();
-  // Orientation is XX so that the orientation of the trackedFrameList will match the orientation defined in the file
-  if (vtkIGSIOSequenceIO::Read(inputSequenceFilename, trackedFrameList) != PLUS_SUCCESS)
+  SequenceFrameIndex sequenceFrameIndex;
+  std::ifstream pixelDataFile;
+  const bool readThroughFrameIndex = vtkPlusSequenceIO::OpenFrameIndex(inputSequenceFilename, sequenceFrameIndex) == PLUS_SUCCESS
+                                     && sequenceFrameIndex.OpenPixelDataFile(pixelDataFile) == PLUS_SUCCESS;
+  if (!readThroughFrameIndex && vtkPlusSequenceIO::Read(inputSequenceFilename, trackedFrameList) != PLUS_SUCCESS)
   {
     LOG_ERROR("Unable to load input sequences file.");
     return EXIT_FAILURE;
   }
   LOG_DEBUG("Reading input done.");
-  LOG_DEBUG("Number of frames: " << trackedFrameList->GetNumberOfTrackedFrames());
+  const int numberOfFrames = readThroughFrameIndex ? sequenceFrameIndex.GetNumberOfFrames() : trackedFrameList->GetNumberOfTrackedFrames();
+  LOG_DEBUG("Number of frames: " << numberOfFrames);
 
   // Read calibration matrices from the config file
   vtkSmartPointer<vtkIGSIOTransformRepository> transformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
@@ -238,11 +245,20 @@ int main(int argc, char** argv)
     }
   }
 
-  int numberOfFrames = trackedFrameList->GetNumberOfTrackedFrames();
   for (int frameIndex = 0; frameIndex < numberOfFrames; frameIndex++)
   {
     vtkPlusLogger::PrintProgressbar((100.0 * frameIndex) / numberOfFrames);
-    igsioTrackedFrame* frame = trackedFrameList->GetTrackedFrame(frameIndex);
+    igsioTrackedFrame indexedFrame;
+    igsioTrackedFrame* frame = &indexedFrame;
+    if (!readThroughFrameIndex)
+    {
+      frame = trackedFrameList->GetTrackedFrame(frameIndex);
+    }
+    else if (sequenceFrameIndex.ReadFrame(pixelDataFile, frameIndex, indexedFrame) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to read frame " << frameIndex << " of the input sequence file.");
+      return EXIT_FAILURE;
+    }
 
     // Update transform repository
     if (transformRepository->SetTransforms(*frame) != PLUS_SUCCESS)
@@ -15,6 +15,11 @@ See License.txt for details.
 #include "vtkPlusVirtualCapture.h"
 #include "vtksys/SystemTools.hxx"
 
+// STL includes
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 #ifdef PLUS_USE_VTKVIDEOIO_MKV
 //  #include "vtkPlusMkvSequenceIO.h"
 #endif
@@ -30,14 +35,21 @@ namespace
   static const double WARNING_RECORDING_LAG_SEC = 1.0; // if the recording lags more than this then a warning message will be displayed
   static const double MAX_ALLOWED_RECORDING_LAG_SEC = 3.0; // if the recording lags more than this then it'll skip frames to catch up
   static const unsigned int DISABLE_FRAME_BUFFER = std::numeric_limits<unsigned int>::max();
+  static const unsigned int DEFAULT_WRITE_QUEUE_MAX_NUMBER_OF_FRAMES = 300; // about 10 seconds of recording at the default frame rate
+  static const int DEFAULT_NUMBER_OF_COMPRESSION_THREADS = 1;
 }
 
 //----------------------------------------------------------------------------
 vtkPlusVirtualCapture::vtkPlusVirtualCapture()
   : vtkPlusDevice()
   , RecordedFrames(vtkIGSIOTrackedFrameList::New())
-  , LastAlreadyRecordedFrameTimestamp(UNDEFINED_TIMESTAMP)
-  , NextFrameToBeRecordedTimestamp(0.0)
+  , WriterThreadStopRequested(false)
+  , WritingFrameList(false)
+  , WriteQueueMaxNumberOfFrames(DEFAULT_WRITE_QUEUE_MAX_NUMBER_OF_FRAMES)
+  , WriteQueueDepth(0)
+  , MaximumWriteQueueDepth(0)
+  , NumberOfDroppedFrames(0)
+  , WriteFailed(false)
   , RequestedFrameRate(15.0)
   , ActualFrameRate(0.0)
   , FirstFrameIndexInThisSegment(0)
@@ -46,6 +58,18 @@ vtkPlusVirtualCapture::vtkPlusVirtualCapture()
   , CurrentFilename("")
   , BaseFilename("TrackedImageSequence.nrrd")
   , Writer(NULL)
+  , WriteChunkedFile(false)
+  , NumberOfCompressionThreads(DEFAULT_NUMBER_OF_COMPRESSION_THREADS)
+  , SegmentFileDurationSec(0.0)
+  , SegmentFileMaxSizeMB(0.0)
+  , WriteSegmentFiles(false)
+  , SegmentFileNumber(0)
+  , FramesRecordedBeforeSegmentFile(0)
+  , NumberOfWrittenFrames(0)
+  , SegmentFileFirstTimestamp(UNDEFINED_TIMESTAMP)
+  , SegmentFileLastTimestamp(UNDEFINED_TIMESTAMP)
+  , SegmentFileSizeBytes(0)
+  , EnableFrameIndex(false)
   , EnableFileCompression(false)
   , IsHeaderPrepared(false)
   , TotalFramesRecorded(0)
@@ -63,21 +87,37 @@ vtkPlusVirtualCapture::vtkPlusVirtualCapture()
 
   // The data capture thread will be used to regularly read the frames and write to disk
   this->StartThreadForInternalUpdates = true;
+  // Frames are sampled when new input data arrives instead of polling the inputs
+  this->WakeOnInputData = true;
 }
 
 //----------------------------------------------------------------------------
 vtkPlusVirtualCapture::~vtkPlusVirtualCapture()
 {
-  if (IsHeaderPrepared)
+  if (this->HasUnsavedData())
   {
     this->CloseFile();
   }
+  this->StopWriterThread();
 
   if (RecordedFrames != NULL)
   {
     this->RecordedFrames->Delete();
     this->RecordedFrames = NULL;
   }
+  for (std::deque<vtkIGSIOTrackedFrameList*>::iterator it = this->WriteQueue.begin(); it != this->WriteQueue.end(); ++it)
+  {
+    if (*it != NULL)
+    {
+      (*it)->Delete();
+    }
+  }
+  this->WriteQueue.clear();
+  for (std::vector<vtkIGSIOTrackedFrameList*>::iterator it = this->FreeFrameLists.begin(); it != this->FreeFrameLists.end(); ++it)
+  {
+    (*it)->Delete();
+  }
+  this->FreeFrameLists.clear();
 
   if (Writer != NULL)
   {
@@ -90,6 +130,22 @@ vtkPlusVirtualCapture::~vtkPlusVirtualCapture()
 void vtkPlusVirtualCapture::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "WriteQueueMaxNumberOfFrames: " << this->WriteQueueMaxNumberOfFrames << std::endl;
+  os << indent << "WriteQueueDepth: " << this->GetWriteQueueDepth() << std::endl;
+  os << indent << "MaximumWriteQueueDepth: " << this->GetMaximumWriteQueueDepth() << std::endl;
+  os << indent << "NumberOfDroppedFrames: " << this->GetNumberOfDroppedFrames() << std::endl;
+  os << indent << "NumberOfCompressionThreads: " << this->NumberOfCompressionThreads << std::endl;
+  os << indent << "WriteChunkedFile: " << (this->WriteChunkedFile ? "TRUE" : "FALSE") << std::endl;
+  os << indent << "SegmentFileDurationSec: " << this->SegmentFileDurationSec << std::endl;
+  os << indent << "SegmentFileMaxSizeMB: " << this->SegmentFileMaxSizeMB << std::endl;
+  if (this->WriteSegmentFiles)
+  {
+    std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+    os << indent << "SegmentIndexFile: " << this->SegmentIndex.GetFileName() << std::endl;
+    os << indent << "NumberOfCompletedSegmentFiles: " << this->SegmentIndex.GetNumberOfSegments() << std::endl;
+  }
+  os << indent << "EnableFrameIndex: " << (this->EnableFrameIndex ? "TRUE" : "FALSE") << std::endl;
 }
 
 //----------------------------------------------------------------------------
@@ -109,6 +165,21 @@ PlusStatus vtkPlusVirtualCapture::ReadConfiguration(vtkXMLDataElement* rootConfi
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, RequestedFrameRate, deviceConfig);
   XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, FrameBufferSize, deviceConfig);
   XML_READ_STRING_ATTRIBUTE_OPTIONAL(EncodingFourCC, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, WriteQueueMaxNumberOfFrames, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, NumberOfCompressionThreads, deviceConfig);
+  if (this->NumberOfCompressionThreads < 1)
+  {
+    LOG_ERROR("Invalid NumberOfCompressionThreads: " << this->NumberOfCompressionThreads << ". It must be at least 1.");
+    return PLUS_FAIL;
+  }
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, SegmentFileDurationSec, deviceConfig);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, SegmentFileMaxSizeMB, deviceConfig);
+  if (this->SegmentFileDurationSec < 0 || this->SegmentFileMaxSizeMB < 0)
+  {
+    LOG_ERROR("Invalid segment file limits: SegmentFileDurationSec=" << this->SegmentFileDurationSec << ", SegmentFileMaxSizeMB=" << this->SegmentFileMaxSizeMB << ". They must not be negative.");
+    return PLUS_FAIL;
+  }
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(EnableFrameIndex, deviceConfig);
 
   return PLUS_SUCCESS;
 }
@@ -121,6 +192,11 @@ PlusStatus vtkPlusVirtualCapture::WriteConfiguration(vtkXMLDataElement* rootConf
   deviceElement->SetAttribute("EnableFileCompression", this->EnableFileCompression ? "TRUE" : "FALSE");
   deviceElement->SetAttribute("EnableCaptureOnStart", this->EnableCapturingOnStart ? "TRUE" : "FALSE");
   deviceElement->SetDoubleAttribute("RequestedFrameRate", this->GetRequestedFrameRate());
+  deviceElement->SetIntAttribute("WriteQueueMaxNumberOfFrames", this->WriteQueueMaxNumberOfFrames);
+  deviceElement->SetIntAttribute("NumberOfCompressionThreads", this->NumberOfCompressionThreads);
+  deviceElement->SetDoubleAttribute("SegmentFileDurationSec", this->SegmentFileDurationSec);
+  deviceElement->SetDoubleAttribute("SegmentFileMaxSizeMB", this->SegmentFileMaxSizeMB);
+  deviceElement->SetAttribute("EnableFrameIndex", this->EnableFrameIndex ? "TRUE" : "FALSE");
 
   return PLUS_SUCCESS;
 }
@@ -134,12 +210,14 @@ PlusStatus vtkPlusVirtualCapture::InternalConnect()
     return PLUS_FAIL;
   }
 
+  this->StartWriterThread();
+
   if (this->GetEnableCapturingOnStart())
   {
     this->SetEnableCapturing(true);
   }
 
-  this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->LastUpdateTime = this->GetClockTime();
 
   return PLUS_SUCCESS;
 }
@@ -149,25 +227,9 @@ PlusStatus vtkPlusVirtualCapture::InternalDisconnect()
 {
   this->EnableCapturing = false;
 
-  // If outstanding frames to be written, deal with them
-  if (this->RecordedFrames->GetNumberOfTrackedFrames() != 0 && this->IsHeaderPrepared)
-  {
-    if (this->Writer->AppendImagesToHeader() != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Unable to append image data to header.");
-      this->Disconnect();
-      return PLUS_FAIL;
-    }
-    if (this->Writer->WriteImages() != PLUS_SUCCESS)
-    {
-      LOG_ERROR("Unable to append images. Stopping recording at timestamp: " << this->LastAlreadyRecordedFrameTimestamp);
-      this->Disconnect();
-      return PLUS_FAIL;
-    }
-
-    this->ClearRecordedFrames();
-  }
+  // Outstanding frames are written when the file is closed
   PlusStatus status = this->CloseFile();
+  this->StopWriterThread();
   return status;
 }
 
@@ -176,6 +238,7 @@ PlusStatus vtkPlusVirtualCapture::OpenFile(const char* aFilename)
 {
   igsioLockGuard<vtkIGSIORecursiveCriticalSection> writerLock(this->WriterAccessMutex);
 
+  std::string filename;
   if (aFilename == NULL || strlen(aFilename) == 0)
   {
     std::string filenameRoot = igsioCommon::GetSequenceFilenameWithoutExtension(this->BaseFilename);
@@ -191,8 +254,7 @@ PlusStatus vtkPlusVirtualCapture::OpenFile(const char* aFilename)
       LOG_WARNING("Compressed saving of metaimage file requested. This is not supported. Reverting to uncompressed metaimage file.");
       this->SetEnableFileCompression(false);
     }
-    this->CurrentFilename = filenameRoot + "_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ext;
-    aFilename = this->CurrentFilename.c_str();
+    filename = filenameRoot + "_" + vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") + ext;
   }
   else
   {
@@ -202,19 +264,77 @@ PlusStatus vtkPlusVirtualCapture::OpenFile(const char* aFilename)
       LOG_WARNING("Compressed saving of metaimage file requested. This is not supported. Reverting to uncompressed metaimage file.");
       this->SetEnableFileCompression(false);
     }
-    this->CurrentFilename = aFilename;
+    filename = aFilename;
+  }
+
+  // Compression on multiple threads requires the chunked file format, which is read by vtkPlusSequenceIO
+  this->WriteChunkedFile = this->EnableFileCompression && this->NumberOfCompressionThreads > 1;
+  if (this->WriteChunkedFile)
+  {
+    if (this->ChunkedFile.SetNumberOfThreads(this->NumberOfCompressionThreads) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+    this->MaximumWriteQueueDepth = this->WriteQueueDepth;
+    this->NumberOfDroppedFrames = 0;
+    this->WriteFailed = false;
+  }
+
+  this->NumberOfWrittenFrames = 0;
+  {
+    std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+    this->CurrentFilename = filename;
+    this->WriteSegmentFiles = this->SegmentFileDurationSec > 0 || this->SegmentFileMaxSizeMB > 0;
+  }
+  if (this->WriteSegmentFiles)
+  {
+    this->SegmentFilenameRoot = igsioCommon::GetSequenceFilenameWithoutExtension(filename);
+    this->SegmentFilenameExtension = igsioCommon::GetSequenceFilenameExtension(filename);
+    {
+      std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+      this->SegmentIndex.Initialize(vtkPlusConfig::GetInstance()->GetOutputPath(this->SegmentFilenameRoot + SequenceSegmentIndex::GetFileExtension()));
+      this->SegmentFileNumber = 0;
+    }
+    this->ResetSegmentFileStatistics();
+    return this->OpenSegmentFile();
   }
 
-  this->Writer = vtkIGSIOSequenceIO::CreateSequenceHandlerForFile(aFilename);
-  if (!this->Writer)
   {
-    LOG_ERROR("Could not create writer for file: " << aFilename);
+    std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+    this->FramesRecordedBeforeSegmentFile = 0;
+  }
+  return this->CreateWriter(filename);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::CreateWriter(const std::string& sequenceFilename)
+{
+  // The frame list of the writer is set by WriteFrameList, the recorded frame list belongs to the capture thread
+  vtkIGSIOSequenceIOBase* writer = vtkIGSIOSequenceIO::CreateSequenceHandlerForFile(sequenceFilename);
+  if (!writer)
+  {
+    LOG_ERROR("Could not create writer for file: " << sequenceFilename);
     return PLUS_FAIL;
   }
-  this->Writer->SetUseCompression(this->EnableFileCompression);
-  this->Writer->SetTrackedFrameList(this->RecordedFrames);
+  writer->SetUseCompression(this->EnableFileCompression);
   // Need to set the filename before finalizing header, because the pixel data file name depends on the file extension
-  this->Writer->SetFileName(vtkPlusConfig::GetInstance()->GetOutputPath(aFilename));
+  writer->SetFileName(vtkPlusConfig::GetInstance()->GetOutputPath(sequenceFilename));
+
+  std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+  if (this->Writer != NULL)
+  {
+    this->Writer->Delete();
+  }
+  this->Writer = writer;
+  this->CurrentFilename = sequenceFilename;
+  if (this->WriteChunkedFile)
+  {
+    this->CurrentFilename = igsioCommon::GetSequenceFilenameWithoutExtension(sequenceFilename) + ChunkedSequenceFile::GetFileExtension();
+  }
 
   return PLUS_SUCCESS;
 }
@@ -225,52 +345,255 @@ PlusStatus vtkPlusVirtualCapture::CloseFile(const char* aFilename /* = NULL */,
   // Fix the header to write the correct number of frames
   igsioLockGuard<vtkIGSIORecursiveCriticalSection> writerLock(this->WriterAccessMutex);
 
-  if (!this->IsHeaderPrepared)
+  // Write all outstanding data, the writer thread is idle afterwards
+  this->WriteFrames(true);
+
+  std::string fullPath;
+  if (this->WriteSegmentFiles)
   {
-    // nothing has been prepared, so nothing to finalize
-    return PLUS_SUCCESS;
+    // Previous segments are already finalized, only the current one is left
+    if (this->IsHeaderPrepared && this->FinalizeSegmentFile() != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+    if (this->SegmentIndex.GetNumberOfSegments() == 0)
+    {
+      // nothing has been written, so nothing to finalize
+      return PLUS_SUCCESS;
+    }
+    if (aFilename != NULL && strlen(aFilename) != 0)
+    {
+      std::string indexFilename = igsioCommon::GetSequenceFilenameWithoutExtension(aFilename) + SequenceSegmentIndex::GetFileExtension();
+      if (this->SegmentIndex.Rename(vtkPlusConfig::GetInstance()->GetOutputPath(indexFilename)) != PLUS_SUCCESS)
+      {
+        return PLUS_FAIL;
+      }
+    }
+    fullPath = this->SegmentIndex.GetFileName();
+    if (resultFilename != NULL)
+    {
+      (*resultFilename) = fullPath;
+    }
   }
+  else
+  {
+    if (!this->IsHeaderPrepared)
+    {
+      // nothing has been prepared, so nothing to finalize
+      return PLUS_SUCCESS;
+    }
+    if (this->FinalizeFile(aFilename, resultFilename) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    fullPath = vtkPlusConfig::GetInstance()->GetOutputPath(this->CurrentFilename);
+  }
+
+  std::string path = vtksys::SystemTools::GetFilenamePath(fullPath);
+  std::string filename = vtksys::SystemTools::GetFilenameWithoutExtension(fullPath);
+  std::string configFileName = path + "/" + filename + "_config.xml";
+  igsioCommon::XML::PrintXML(configFileName.c_str(), vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
 
-  if (aFilename != NULL && strlen(aFilename) != 0)
+  this->IsHeaderPrepared = false;
+  this->TotalFramesRecorded = 0;
+  this->ClearRecordedFrames();
+
+  if (this->OpenFile() != PLUS_SUCCESS)
   {
-    // Need to set the filename before finalizing header, because the pixel data file name depends on the file extension
-    this->Writer->SetFileName(vtkPlusConfig::GetInstance()->GetOutputPath(aFilename));
-    this->CurrentFilename = aFilename;
+    return PLUS_FAIL;
   }
 
-  // Do we have any outstanding unwritten data?
-  if (this->RecordedFrames->GetNumberOfTrackedFrames() != 0)
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::FinalizeFile(const char* aFilename, std::string* resultFilename)
+{
+  if (this->WriteChunkedFile)
   {
-    this->WriteFrames(true);
+    // Chunks are complete sequence files, only the file name may need to be changed
+    std::string chunkedFilename;
+    if (aFilename != NULL && strlen(aFilename) != 0)
+    {
+      std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+      this->CurrentFilename = igsioCommon::GetSequenceFilenameWithoutExtension(aFilename) + ChunkedSequenceFile::GetFileExtension();
+      chunkedFilename = vtkPlusConfig::GetInstance()->GetOutputPath(this->CurrentFilename);
+    }
+    if (this->ChunkedFile.Close(chunkedFilename) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+
+    if (resultFilename != NULL)
+    {
+      (*resultFilename) = this->ChunkedFile.GetFileName();
+    }
   }
+  else
+  {
+    if (aFilename != NULL && strlen(aFilename) != 0)
+    {
+      // Need to set the filename before finalizing header, because the pixel data file name depends on the file extension
+      this->Writer->SetFileName(vtkPlusConfig::GetInstance()->GetOutputPath(aFilename));
+      std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+      this->CurrentFilename = aFilename;
+    }
+
+    this->Writer->UpdateDimensionsCustomStrings(this->NumberOfWrittenFrames - this->FramesRecordedBeforeSegmentFile, this->GetIsData3D());
+    this->Writer->UpdateFieldInImageHeader(this->Writer->GetDimensionSizeString());
+    this->Writer->UpdateFieldInImageHeader(this->Writer->GetDimensionKindsString());
+    this->Writer->FinalizeHeader();
 
-  this->Writer->UpdateDimensionsCustomStrings(this->TotalFramesRecorded, this->GetIsData3D());
-  this->Writer->UpdateFieldInImageHeader(this->Writer->GetDimensionSizeString());
-  this->Writer->UpdateFieldInImageHeader(this->Writer->GetDimensionKindsString());
-  this->Writer->FinalizeHeader();
+    if (resultFilename != NULL)
+    {
+      (*resultFilename) = this->Writer->GetFileName();
+    }
+
+    this->Writer->Close();
+  }
 
-  if (resultFilename != NULL)
+  if (this->EnableFrameIndex && this->FrameIndex.GetNumberOfFrames() > 0)
   {
-    (*resultFilename) = this->Writer->GetFileName();
+    // The index is not essential for reading the file, so the recording is not failed if it cannot be written
+    const std::string sequenceFilename = this->WriteChunkedFile ? this->ChunkedFile.GetFileName() : std::string(this->Writer->GetFileName());
+    this->FrameIndex.LocatePixelData(sequenceFilename);
+    if (this->FrameIndex.Write(SequenceFrameIndex::GetIndexFileName(sequenceFilename)) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("Failed to write frame index of " << sequenceFilename);
+    }
+    this->FrameIndex.Clear();
   }
 
-  this->Writer->Close();
+  return PLUS_SUCCESS;
+}
 
-  std::string fullPath = vtkPlusConfig::GetInstance()->GetOutputPath(this->CurrentFilename);
-  std::string path = vtksys::SystemTools::GetFilenamePath(fullPath);
-  std::string filename = vtksys::SystemTools::GetFilenameWithoutExtension(fullPath);
-  std::string configFileName = path + "/" + filename + "_config.xml";
-  igsioCommon::XML::PrintXML(configFileName.c_str(), vtkPlusConfig::GetInstance()->GetDeviceSetConfigurationData());
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::OpenSegmentFile()
+{
+  std::ostringstream segmentFilename;
+  {
+    std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+    segmentFilename << this->SegmentFilenameRoot << "_seg" << std::setfill('0') << std::setw(4) << this->SegmentFileNumber << this->SegmentFilenameExtension;
+    this->FramesRecordedBeforeSegmentFile = this->NumberOfWrittenFrames;
+  }
+  return this->CreateWriter(segmentFilename.str());
+}
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::FinalizeSegmentFile()
+{
+  if (this->FinalizeFile(NULL, NULL) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to finalize segment file: " << this->CurrentFilename);
+    return PLUS_FAIL;
+  }
   this->IsHeaderPrepared = false;
-  this->TotalFramesRecorded = 0;
-  this->RecordedFrames->Clear();
 
-  if (this->OpenFile() != PLUS_SUCCESS)
+  // The segment is listed in the index only when it is complete
+  const unsigned int numberOfFrames = static_cast<unsigned int>(this->NumberOfWrittenFrames - this->FramesRecordedBeforeSegmentFile);
+  std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+  if (this->SegmentIndex.AddSegment(vtkPlusConfig::GetInstance()->GetOutputPath(this->CurrentFilename), numberOfFrames) != PLUS_SUCCESS)
   {
+    LOG_ERROR("Failed to add segment file " << this->CurrentFilename << " to the segment index");
     return PLUS_FAIL;
   }
+  LOG_DEBUG("Segment file " << this->CurrentFilename << " is completed with " << numberOfFrames << " frames");
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::StartNextSegmentFile()
+{
+  if (!this->IsHeaderPrepared)
+  {
+    // Nothing is written to the segment file yet
+    return PLUS_SUCCESS;
+  }
+  if (this->FinalizeSegmentFile() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  {
+    std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+    this->SegmentFileNumber++;
+  }
+  return this->OpenSegmentFile();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::RotateSegmentFile()
+{
+  std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+  // Frames kept in the frame buffer belong to the segment file as well
+  if (this->RecordedFrames->GetNumberOfTrackedFrames() > 0)
+  {
+    this->QueueRecordedFrames();
+  }
+  this->WriteQueue.push_back(NULL);
+  this->WriteQueueCondition.notify_one();
 
+  // Statistics of the next segment file start with the next recorded frame
+  this->ResetSegmentFileStatistics();
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusVirtualCapture::UpdateSegmentFileStatistics(int firstFrameIndex)
+{
+  for (int frameIndex = firstFrameIndex; frameIndex < static_cast<int>(this->RecordedFrames->GetNumberOfTrackedFrames()); ++frameIndex)
+  {
+    igsioTrackedFrame* frame = this->RecordedFrames->GetTrackedFrame(frameIndex);
+    if (this->SegmentFileFirstTimestamp == UNDEFINED_TIMESTAMP)
+    {
+      this->SegmentFileFirstTimestamp = frame->GetTimestamp();
+    }
+    this->SegmentFileLastTimestamp = frame->GetTimestamp();
+    if (frame->GetImageData()->IsImageValid())
+    {
+      this->SegmentFileSizeBytes += frame->GetImageData()->GetFrameSizeInBytes();
+    }
+  }
+
+  if (this->SegmentFileDurationSec > 0 && this->SegmentFileFirstTimestamp != UNDEFINED_TIMESTAMP
+      && this->SegmentFileLastTimestamp - this->SegmentFileFirstTimestamp >= this->SegmentFileDurationSec)
+  {
+    return true;
+  }
+  if (this->SegmentFileMaxSizeMB > 0 && this->SegmentFileSizeBytes >= this->SegmentFileMaxSizeMB * 1024.0 * 1024.0)
+  {
+    return true;
+  }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::ResetSegmentFileStatistics()
+{
+  this->SegmentFileFirstTimestamp = UNDEFINED_TIMESTAMP;
+  this->SegmentFileLastTimestamp = UNDEFINED_TIMESTAMP;
+  this->SegmentFileSizeBytes = 0;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::WriteRecordedFrames(int firstFrameIndex)
+{
+  const int numberOfNewFrames = this->RecordedFrames->GetNumberOfTrackedFrames() - firstFrameIndex;
+  this->TotalFramesRecorded += numberOfNewFrames;
+
+  // Check the segment file limits before the frames are handed over and removed from the recorded frame list
+  bool segmentFileFull = this->WriteSegmentFiles && this->UpdateSegmentFileStatistics(firstFrameIndex);
+
+  // Only hands over the frames to the writer thread, does not wait for the disk
+  if (this->WriteFrames() != PLUS_SUCCESS)
+  {
+    LOG_ERROR(this->GetDeviceId() << ": Unable to write " << numberOfNewFrames << " frames.");
+    return PLUS_FAIL;
+  }
+
+  if (segmentFileFull)
+  {
+    this->RotateSegmentFile();
+  }
   return PLUS_SUCCESS;
 }
 
@@ -296,15 +619,18 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
 
   if (this->LastUpdateTime == 0.0)
   {
-    this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    this->LastUpdateTime = this->GetClockTime();
   }
-  if (this->NextFrameToBeRecordedTimestamp == 0.0)
+  if (this->RecordingCursor.NextSampleTimestamp == UNDEFINED_TIMESTAMP)
   {
-    this->NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    this->RecordingCursor.NextSampleTimestamp = this->GetClockTime();
   }
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double startTimeSec = this->GetClockTime();
+  const double processingStartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
 
-  this->TimeWaited += startTimeSec - LastUpdateTime;
+  // The thread may wake up on every new input item, so the time since the previous call is accumulated
+  this->TimeWaited += startTimeSec - this->LastUpdateTime;
+  this->LastUpdateTime = startTimeSec;
 
   if (this->TimeWaited < samplingPeriodSec)
   {
@@ -315,6 +641,11 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
   this->TimeWaited = 0.0;
 
   double maxProcessingTimeSec = samplingPeriodSec * 2.0; // put a hard limit on the max processing time to make sure the application remains responsive during recording
+  if (this->IsDrivenByReplayClock())
+  {
+    // The replay timeline waits for the recording, so all frames are recorded and the recording is reproducible
+    maxProcessingTimeSec = 0.0;
+  }
   double requestedFramePeriodSec = 0.1;
   if (this->RequestedFrameRate > 0)
   {
@@ -338,9 +669,9 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
   }
 
   int nbFramesBefore = this->RecordedFrames->GetNumberOfTrackedFrames();
-  if (this->GetInputTrackedFrameListSampled(this->LastAlreadyRecordedFrameTimestamp, this->NextFrameToBeRecordedTimestamp, this->RecordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
+  if (this->GetInputTrackedFrameListSampled(this->RecordingCursor, this->RecordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Error while getting tracked frame list from data collector during capturing. Last recorded timestamp: " << std::fixed << this->NextFrameToBeRecordedTimestamp);
+    LOG_ERROR("Error while getting tracked frame list from data collector during capturing. Last recorded timestamp: " << std::fixed << this->RecordingCursor.NextSampleTimestamp);
   }
   int nbFramesAfter = this->RecordedFrames->GetNumberOfTrackedFrames();
 
@@ -370,14 +701,11 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
     }
   }
 
-  if (this->WriteFrames() != PLUS_SUCCESS)
+  if (this->WriteRecordedFrames(nbFramesBefore) != PLUS_SUCCESS)
   {
-    LOG_ERROR(this->GetDeviceId() << ": Unable to write " << nbFramesAfter - nbFramesBefore << " frames.");
     return PLUS_FAIL;
   }
 
-  this->TotalFramesRecorded += nbFramesAfter - nbFramesBefore;
-
   if (this->TotalFramesRecorded == 0)
   {
     // We haven't received any data so far
@@ -385,9 +713,9 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
   }
 
   // Check whether the recording needed more time than the sampling interval
-  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
-  double currentSystemTime = vtkIGSIOAccurateTimer::GetSystemTime();
-  double recordingLagSec =  currentSystemTime - this->NextFrameToBeRecordedTimestamp;
+  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - processingStartTimeSec;
+  double currentTime = this->GetClockTime();
+  double recordingLagSec =  currentTime - this->RecordingCursor.NextSampleTimestamp;
 
   if (recordingTimeSec > samplingPeriodSec)
   {
@@ -399,10 +727,10 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
   if (recordingLagSec > MAX_ALLOWED_RECORDING_LAG_SEC)
   {
     double acquisitionLagSec = recordingLagSec;
-    double latestInputTimestamp = this->NextFrameToBeRecordedTimestamp;
+    double latestInputTimestamp = this->RecordingCursor.NextSampleTimestamp;
     if (GetLatestInputItemTimestamp(latestInputTimestamp) == PLUS_SUCCESS)
     {
-      acquisitionLagSec = currentSystemTime - latestInputTimestamp;
+      acquisitionLagSec = currentTime - latestInputTimestamp;
     }
     if (acquisitionLagSec < MAX_ALLOWED_RECORDING_LAG_SEC)
     {
@@ -410,10 +738,10 @@ PlusStatus vtkPlusVirtualCapture::InternalUpdate()
       // (because acquisitionLagSec < MAX_ALLOWED_RECORDING_LAG_SEC)
       LOG_ERROR("Recording cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
     }
-    this->NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    this->RecordingCursor.NextSampleTimestamp = this->GetClockTime();
   }
 
-  this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->LastUpdateTime = this->GetClockTime();
 
   return PLUS_SUCCESS;
 }
@@ -450,7 +778,8 @@ PlusStatus vtkPlusVirtualCapture::NotifyConfigured()
 //-----------------------------------------------------------------------------
 bool vtkPlusVirtualCapture::HasUnsavedData() const
 {
-  return this->IsHeaderPrepared;
+  // Frames may be recorded or queued before the header is prepared by the writer thread
+  return this->IsHeaderPrepared || this->TotalFramesRecorded > 0;
 }
 
 //-----------------------------------------------------------------------------
@@ -470,6 +799,7 @@ void vtkPlusVirtualCapture::InternalWriteOutputChannels(vtkXMLDataElement* rootX
 //----------------------------------------------------------------------------
 void vtkPlusVirtualCapture::SetEnableFileCompression(bool aFileCompression)
 {
+  std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
   if (this->Writer != NULL)
   {
     this->Writer->SetUseCompression(aFileCompression);
@@ -487,10 +817,9 @@ void vtkPlusVirtualCapture::SetEnableCapturing(bool aValue)
   {
     this->LastUpdateTime = 0.0;
     this->TimeWaited = 0.0;
-    this->LastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP;
-    this->NextFrameToBeRecordedTimestamp = 0.0;
+    this->RecordingCursor = vtkPlusChannel::ReadCursor();
     this->FirstFrameIndexInThisSegment = this->RecordedFrames->GetNumberOfTrackedFrames();
-    this->RecordingStartTime = vtkIGSIOAccurateTimer::GetSystemTime(); // reset the starting time for the grace period
+    this->RecordingStartTime = this->GetClockTime(); // reset the starting time for the grace period
   }
 }
 
@@ -502,13 +831,28 @@ PlusStatus vtkPlusVirtualCapture::Reset()
 
     this->SetEnableCapturing(false);
 
+    this->DiscardWriteQueue();
+    if (this->WriteSegmentFiles)
+    {
+      // The recording is discarded, including the completed segments
+      std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+      this->SegmentIndex.Discard();
+    }
     if (this->IsHeaderPrepared)
     {
-      this->Writer->Discard();
+      if (this->WriteChunkedFile)
+      {
+        this->ChunkedFile.Discard();
+      }
+      else
+      {
+        this->Writer->Discard();
+      }
     }
 
     this->ClearRecordedFrames();
     this->Writer->GetTrackedFrameList()->Clear();
+    this->FrameIndex.Clear();
     this->IsHeaderPrepared = false;
     this->TotalFramesRecorded = 0;
   }
@@ -519,7 +863,7 @@ PlusStatus vtkPlusVirtualCapture::Reset()
     return PLUS_FAIL;
   }
 
-  this->LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->LastUpdateTime = this->GetClockTime();
 
   return PLUS_SUCCESS;
 }
@@ -576,6 +920,8 @@ PlusStatus vtkPlusVirtualCapture::TakeSnapshot()
     return PLUS_FAIL;
   }
 
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> writerLock(this->WriterAccessMutex);
+
   // Add tracked frame to the list
   // Snapshots are triggered manually, so the additional copying in AddTrackedFrame compared to TakeTrackedFrame is not relevant.
   if (this->RecordedFrames->AddTrackedFrame(&trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
@@ -584,58 +930,325 @@ PlusStatus vtkPlusVirtualCapture::TakeSnapshot()
     return PLUS_FAIL;
   }
 
+  this->TotalFramesRecorded += 1;
+
   if (this->WriteFrames() != PLUS_SUCCESS)
   {
     LOG_ERROR(this->GetDeviceId() << ": Failed to write snapshot frame");
     return PLUS_FAIL;
   }
 
-  this->TotalFramesRecorded += 1;
-
   return PLUS_SUCCESS;
 }
 
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusVirtualCapture::WriteFrames(bool force)
 {
-  if (!this->IsHeaderPrepared && this->RecordedFrames->GetNumberOfTrackedFrames() != 0)
+  if (this->WriteFailed && !force)
+  {
+    // Writing of a previous batch failed on the writer thread
+    this->StopRecording();
+    return PLUS_FAIL;
+  }
+
+  const unsigned int numberOfFrames = this->RecordedFrames->GetNumberOfTrackedFrames();
+  if (numberOfFrames > 0 && (force || !this->IsFrameBuffered() || numberOfFrames > this->GetFrameBufferSize()))
+  {
+    std::unique_lock<std::mutex> queueLock(this->WriteQueueMutex);
+    const bool queueLimited = !force && this->WriteQueueMaxNumberOfFrames > 0;
+    if (queueLimited && this->IsDrivenByReplayClock())
+    {
+      // The replay timeline waits for the writer thread instead of dropping frames
+      while (this->WriterThread.joinable() && this->WriteQueueDepth > 0 && this->WriteQueueDepth + numberOfFrames > this->WriteQueueMaxNumberOfFrames)
+      {
+        this->FrameListWrittenCondition.wait(queueLock);
+      }
+    }
+    if (queueLimited && this->WriteQueueDepth > 0 && this->WriteQueueDepth + numberOfFrames > this->WriteQueueMaxNumberOfFrames)
+    {
+      // Sampling must not wait for the disk, so the frames are dropped
+      this->NumberOfDroppedFrames += numberOfFrames;
+      LOG_WARNING(this->GetDeviceId() << ": Writing to disk cannot keep up with the recording, " << this->WriteQueueDepth << " frames are waiting to be written. Dropped "
+                  << numberOfFrames << " frames (" << this->NumberOfDroppedFrames << " frames since the file was opened).");
+      this->TotalFramesRecorded -= numberOfFrames;
+      this->RecordedFrames->Clear();
+    }
+    else
+    {
+      this->QueueRecordedFrames();
+      this->WriteQueueCondition.notify_one();
+    }
+  }
+
+  if (force)
+  {
+    return this->WaitForWriteQueue();
+  }
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::QueueRecordedFrames()
+{
+  // Double buffering: the writer thread gets the recorded frames and recording continues in an empty list
+  this->WriteQueueDepth += this->RecordedFrames->GetNumberOfTrackedFrames();
+  this->MaximumWriteQueueDepth = std::max(this->MaximumWriteQueueDepth, this->WriteQueueDepth);
+  this->WriteQueue.push_back(this->RecordedFrames);
+  this->RecordedFrames = this->AcquireFrameList();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::WriteFrameList(vtkIGSIOTrackedFrameList* frameList)
+{
+  this->Writer->SetTrackedFrameList(frameList);
+
+  if (!this->IsHeaderPrepared)
   {
     if (this->Writer->PrepareHeader() != PLUS_SUCCESS)
     {
       LOG_ERROR("Unable to prepare header");
-      this->StopRecording();
       return PLUS_FAIL;
     }
     this->IsHeaderPrepared = true;
   }
 
-  if (this->RecordedFrames->GetNumberOfTrackedFrames() == 0)
+  this->SetIsData3D(frameList->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+
+  if (this->Writer->AppendImagesToHeader() != PLUS_SUCCESS)
   {
-    return PLUS_SUCCESS;
+    LOG_ERROR("Unable to append image data to header.");
+    return PLUS_FAIL;
+  }
+  if (this->Writer->WriteImages() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to append images. Stopping recording at timestamp: " << std::fixed << frameList->GetTrackedFrame(0)->GetTimestamp());
+    return PLUS_FAIL;
   }
 
-  this->SetIsData3D(this->RecordedFrames->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+  return PLUS_SUCCESS;
+}
 
-  if (force || !this->IsFrameBuffered() ||
-      (this->IsFrameBuffered() && this->RecordedFrames->GetNumberOfTrackedFrames() > this->GetFrameBufferSize()))
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::WriteFrameListsInChunks(const std::vector<vtkIGSIOTrackedFrameList*>& frameLists)
+{
+  if (!this->ChunkedFile.IsOpen())
   {
-    if (this->Writer->AppendImagesToHeader() != PLUS_SUCCESS)
+    if (this->ChunkedFile.Open(vtkPlusConfig::GetInstance()->GetOutputPath(this->CurrentFilename), this->EnableFileCompression) != PLUS_SUCCESS)
     {
-      LOG_ERROR("Unable to append image data to header.");
-      this->StopRecording();
+      LOG_ERROR("Unable to create chunked sequence file: " << this->CurrentFilename);
       return PLUS_FAIL;
     }
-    if (this->Writer->WriteImages() != PLUS_SUCCESS)
+    this->IsHeaderPrepared = true;
+  }
+
+  this->SetIsData3D(frameLists.front()->GetTrackedFrame(0)->GetFrameSize()[2] > 1);
+
+  if (this->ChunkedFile.WriteFrames(frameLists) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Unable to write chunks. Stopping recording at timestamp: " << std::fixed << frameLists.front()->GetTrackedFrame(0)->GetTimestamp());
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::StartWriterThread()
+{
+  std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+  if (this->WriterThread.joinable())
+  {
+    return;
+  }
+  this->WriterThreadStopRequested = false;
+  this->WriterThread = std::thread(&vtkPlusVirtualCapture::WriterThreadMain, this);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::StopWriterThread()
+{
+  {
+    std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+    if (!this->WriterThread.joinable())
+    {
+      return;
+    }
+    this->WriterThreadStopRequested = true;
+  }
+  this->WriteQueueCondition.notify_all();
+  this->WriterThread.join();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::WriterThreadMain()
+{
+  std::unique_lock<std::mutex> queueLock(this->WriteQueueMutex);
+  while (true)
+  {
+    while (!this->WriterThreadStopRequested && this->WriteQueue.empty())
     {
-      LOG_ERROR("Unable to append images. Stopping recording at timestamp: " << LastAlreadyRecordedFrameTimestamp);
-      this->StopRecording();
-      return PLUS_FAIL;
+      this->WriteQueueCondition.wait(queueLock);
+    }
+    if (this->WriteQueue.empty())
+    {
+      // Stop is requested and all frames are written
+      return;
     }
+    this->WriteNextQueuedFrameList(queueLock);
+  }
+}
 
-    this->ClearRecordedFrames();
+//-----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::WriteNextQueuedFrameList(std::unique_lock<std::mutex>& queueLock)
+{
+  if (this->WriteQueue.front() == NULL)
+  {
+    // End of segment marker, all frames of the segment file are written already
+    this->WriteQueue.pop_front();
+    this->WritingFrameList = true;
+    queueLock.unlock();
+    // Finalizing a segment file takes time proportional to the segment size, not the length of the recording
+    if (!this->WriteFailed && this->StartNextSegmentFile() != PLUS_SUCCESS)
+    {
+      LOG_ERROR(this->GetDeviceId() << ": Unable to start a new segment file. Stopping recording.");
+      this->WriteFailed = true;
+    }
+    queueLock.lock();
+    this->WritingFrameList = false;
+    this->FrameListWrittenCondition.notify_all();
+    return;
   }
 
-  return PLUS_SUCCESS;
+  // Chunks are compressed in parallel, so each compression thread gets a frame list
+  const size_t maxNumberOfFrameLists = this->WriteChunkedFile ? static_cast<size_t>(this->NumberOfCompressionThreads) : 1;
+  std::vector<vtkIGSIOTrackedFrameList*> frameLists;
+  unsigned int numberOfFrames = 0;
+  while (!this->WriteQueue.empty() && this->WriteQueue.front() != NULL && frameLists.size() < maxNumberOfFrameLists)
+  {
+    frameLists.push_back(this->WriteQueue.front());
+    numberOfFrames += this->WriteQueue.front()->GetNumberOfTrackedFrames();
+    this->WriteQueue.pop_front();
+  }
+  this->WritingFrameList = true;
+  queueLock.unlock();
+
+  // Frames are not written after a failure, as the file is already inconsistent
+  if (!this->WriteFailed)
+  {
+    PlusStatus status = this->WriteChunkedFile ? this->WriteFrameListsInChunks(frameLists) : this->WriteFrameList(frameLists.front());
+    if (status != PLUS_SUCCESS)
+    {
+      this->WriteFailed = true;
+    }
+    else
+    {
+      this->NumberOfWrittenFrames += numberOfFrames;
+      if (this->EnableFrameIndex)
+      {
+        for (std::vector<vtkIGSIOTrackedFrameList*>::iterator it = frameLists.begin(); it != frameLists.end(); ++it)
+        {
+          this->FrameIndex.AddFrames(*it);
+        }
+      }
+    }
+  }
+  for (std::vector<vtkIGSIOTrackedFrameList*>::iterator it = frameLists.begin(); it != frameLists.end(); ++it)
+  {
+    (*it)->Clear();
+  }
+
+  queueLock.lock();
+  this->WriteQueueDepth -= numberOfFrames;
+  this->FreeFrameLists.insert(this->FreeFrameLists.end(), frameLists.begin(), frameLists.end());
+  this->WritingFrameList = false;
+  this->FrameListWrittenCondition.notify_all();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualCapture::WaitForWriteQueue()
+{
+  std::unique_lock<std::mutex> queueLock(this->WriteQueueMutex);
+  if (this->WriterThread.joinable())
+  {
+    while (!this->WriteQueue.empty() || this->WritingFrameList)
+    {
+      this->FrameListWrittenCondition.wait(queueLock);
+    }
+  }
+  else
+  {
+    // No writer thread (e.g., the device is not connected), write on the calling thread
+    while (!this->WriteQueue.empty())
+    {
+      this->WriteNextQueuedFrameList(queueLock);
+    }
+  }
+  return this->WriteFailed ? PLUS_FAIL : PLUS_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusVirtualCapture::DiscardWriteQueue()
+{
+  std::unique_lock<std::mutex> queueLock(this->WriteQueueMutex);
+  while (!this->WriteQueue.empty())
+  {
+    vtkIGSIOTrackedFrameList* frameList = this->WriteQueue.front();
+    this->WriteQueue.pop_front();
+    if (frameList == NULL)
+    {
+      // End of segment marker, the segment files are discarded anyway
+      continue;
+    }
+    this->WriteQueueDepth -= frameList->GetNumberOfTrackedFrames();
+    frameList->Clear();
+    this->FreeFrameLists.push_back(frameList);
+  }
+  while (this->WritingFrameList)
+  {
+    this->FrameListWrittenCondition.wait(queueLock);
+  }
+}
+
+//-----------------------------------------------------------------------------
+vtkIGSIOTrackedFrameList* vtkPlusVirtualCapture::AcquireFrameList()
+{
+  if (!this->FreeFrameLists.empty())
+  {
+    vtkIGSIOTrackedFrameList* frameList = this->FreeFrameLists.back();
+    this->FreeFrameLists.pop_back();
+    return frameList;
+  }
+  vtkIGSIOTrackedFrameList* frameList = vtkIGSIOTrackedFrameList::New();
+  frameList->SetValidationRequirements(REQUIRE_UNIQUE_TIMESTAMP);
+  return frameList;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int vtkPlusVirtualCapture::GetWriteQueueDepth()
+{
+  std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+  return this->WriteQueueDepth;
+}
+
+//-----------------------------------------------------------------------------
+unsigned int vtkPlusVirtualCapture::GetMaximumWriteQueueDepth()
+{
+  std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+  return this->MaximumWriteQueueDepth;
+}
+
+//-----------------------------------------------------------------------------
+unsigned long vtkPlusVirtualCapture::GetNumberOfDroppedFrames()
+{
+  std::lock_guard<std::mutex> queueLock(this->WriteQueueMutex);
+  return this->NumberOfDroppedFrames;
+}
+
+//-----------------------------------------------------------------------------
+std::string vtkPlusVirtualCapture::GetOutputFileName()
+{
+  std::lock_guard<std::mutex> outputFileLock(this->OutputFileMutex);
+  return this->WriteSegmentFiles ? this->SegmentIndex.GetFileName() : vtkPlusConfig::GetInstance()->GetOutputPath(this->CurrentFilename);
 }
 
 //-----------------------------------------------------------------------------
@@ -659,7 +1272,7 @@ PlusStatus vtkPlusVirtualCapture::GetInputTrackedFrame(igsioTrackedFrame& aFrame
 }
 
 //-----------------------------------------------------------------------------
-PlusStatus vtkPlusVirtualCapture::GetInputTrackedFrameListSampled(double& lastAlreadyRecordedFrameTimestamp, double& nextFrameToBeRecordedTimestamp, vtkIGSIOTrackedFrameList* recordedFrames, double requestedFramePeriodSec, double maxProcessingTimeSec)
+PlusStatus vtkPlusVirtualCapture::GetInputTrackedFrameListSampled(vtkPlusChannel::ReadCursor& cursor, vtkIGSIOTrackedFrameList* recordedFrames, double requestedFramePeriodSec, double maxProcessingTimeSec)
 {
   if (this->OutputChannels.empty())
   {
@@ -667,7 +1280,7 @@ PlusStatus vtkPlusVirtualCapture::GetInputTrackedFrameListSampled(double& lastAl
     return PLUS_FAIL;
   }
 
-  return this->OutputChannels[0]->GetTrackedFrameListSampled(lastAlreadyRecordedFrameTimestamp, nextFrameToBeRecordedTimestamp, recordedFrames, requestedFramePeriodSec, maxProcessingTimeSec);
+  return this->OutputChannels[0]->GetTrackedFrameListSampled(cursor, recordedFrames, requestedFramePeriodSec, maxProcessingTimeSec);
 }
 
 //-----------------------------------------------------------------------------
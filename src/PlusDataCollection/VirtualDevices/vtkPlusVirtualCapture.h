@@ -8,15 +8,45 @@ See License.txt for details.
 #define __vtkPlusVirtualCapture_h
 
 #include "vtkPlusDataCollectionExport.h"
+#include "PlusChunkedSequenceFile.h"
+#include "PlusSequenceFrameIndex.h"
+#include "PlusSequenceSegmentIndex.h"
 #include "vtkPlusDevice.h"
 #include "vtkIGSIOSequenceIOBase.h"
+
+// STL includes
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 //class vtkIGSIOTrackedFrameList;
 
 /*!
 \class vtkPlusVirtualCapture
-\brief
+\brief Records the tracked frames of the input channel to a sequence file
+
+Frames are sampled from the input channel on the data capture thread and handed over to a dedicated
+writer thread in batches, so sampling is never blocked by compression or disk I/O. The recorded frame
+list is double-buffered: while the writer thread writes a batch, the capture thread fills a new list.
+If more than WriteQueueMaxNumberOfFrames frames are waiting to be written, then the newly sampled frames
+are dropped and a warning is logged, so the memory use is bounded if the disk cannot keep up. Frames are
+never dropped if WriteQueueMaxNumberOfFrames is 0.
+
+If file compression is enabled and NumberOfCompressionThreads is larger than 1 then the frames are written
+to a ChunkedSequenceFile: the writer thread compresses several batches in parallel and appends them to the
+file in order.
+
+If SegmentFileDurationSec or SegmentFileMaxSizeMB is set then the recording is split into segment files.
+When a segment file is full, the capture thread queues an end of segment marker, and the writer thread
+finalizes the segment file and adds it to a SequenceSegmentIndex file, which is read as a single sequence. Finalizing a segment takes time proportional to the segment size only, and after a
+crash all but the last segment file are complete.
+
+If EnableFrameIndex is set then a SequenceFrameIndex file is written next to each finalized sequence
+file, so that frames can be read by index or timestamp without loading the whole recording.
 
 \ingroup PlusLibDataCollection
 */
@@ -87,12 +117,46 @@ public:
   vtkSetMacro(FrameBufferSize, unsigned int);
   vtkGetMacro(FrameBufferSize, unsigned int);
 
+  /*!
+    Maximum number of frames waiting for the writer thread. If the limit is reached then new frames are dropped.
+    If 0 then the queue is not limited and frames are never dropped, but the queue grows in memory if the disk
+    cannot keep up. Default is 300.
+  */
+  vtkSetMacro(WriteQueueMaxNumberOfFrames, unsigned int);
+  vtkGetMacro(WriteQueueMaxNumberOfFrames, unsigned int);
+
+  /*! Number of threads that compress the recorded frames. If larger than 1 then compressed recordings are written as chunked sequence files. */
+  vtkSetMacro(NumberOfCompressionThreads, int);
+  vtkGetMacro(NumberOfCompressionThreads, int);
+
+  /*! Maximum time span of the frames in a segment file. If 0 then the duration does not limit segment files. */
+  vtkSetMacro(SegmentFileDurationSec, double);
+  vtkGetMacro(SegmentFileDurationSec, double);
+
+  /*! Maximum size of the image data in a segment file, before compression. If 0 then the size does not limit segment files. */
+  vtkSetMacro(SegmentFileMaxSizeMB, double);
+  vtkGetMacro(SegmentFileMaxSizeMB, double);
+
+  /*! If enabled then a frame index file is written next to each finalized sequence file */
+  vtkSetMacro(EnableFrameIndex, bool);
+  vtkGetMacro(EnableFrameIndex, bool);
+
+  /*! Number of frames handed over to the writer thread that are not written to the file yet */
+  unsigned int GetWriteQueueDepth();
+
+  /*! Highest number of frames waiting for the writer thread since the file was opened */
+  unsigned int GetMaximumWriteQueueDepth();
+
+  /*! Number of frames dropped since the file was opened, because the write queue was full */
+  unsigned long GetNumberOfDroppedFrames();
+
   virtual vtkPlusDataCollector* GetDataCollector() { return this->DataCollector; }
 
   virtual bool IsTracker() const { return false; }
   virtual bool IsVirtual() const { return true; }
 
-  virtual std::string GetOutputFileName() { return vtkPlusConfig::GetInstance()->GetOutputPath(CurrentFilename); };
+  /*! Get the full path of the file that is being written, the segment index file if segment files are written */
+  virtual std::string GetOutputFileName();
 
 protected:
   vtkPlusVirtualCapture();
@@ -109,20 +173,101 @@ protected:
   virtual bool IsFrameBuffered() const;
 
   /*!
-    Copy frames to memory buffer or disk.
-    If force flag is true then data is written to disk immediately.
+    Hand over the recorded frames to the writer thread, if the frame buffer is full (or frame buffering is disabled).
+    If force flag is true then all frames are handed over and the method returns when they are written to disk.
   */
   virtual PlusStatus WriteFrames(bool force = false);
 
+  /*! Write a batch of frames to the file. Called on the writer thread (or on the calling thread if the writer thread is not running). */
+  virtual PlusStatus WriteFrameList(vtkIGSIOTrackedFrameList* frameList);
+
+  /*! Write batches of frames to the chunked sequence file, compressing them in parallel. Called on the writer thread (or on the calling thread if the writer thread is not running). */
+  virtual PlusStatus WriteFrameListsInChunks(const std::vector<vtkIGSIOTrackedFrameList*>& frameLists);
+
+  void StartWriterThread();
+  /*! Write all queued frames and stop the writer thread */
+  void StopWriterThread();
+  void WriterThreadMain();
+
+  /*! Hand over the recorded frames to the writer thread. WriteQueueMutex must be locked. */
+  void QueueRecordedFrames();
+
+  /*!
+    Write the first frame list of the queue, or one frame list per compression thread if a chunked file is written.
+    If the first entry is an end of segment marker then the next segment file is started instead.
+    WriteQueueMutex must be locked by queueLock and the queue must not be empty.
+  */
+  void WriteNextQueuedFrameList(std::unique_lock<std::mutex>& queueLock);
+
+  /*! Wait until all queued frames are written. Returns PLUS_FAIL if any of the frames could not be written. */
+  PlusStatus WaitForWriteQueue();
+
+  /*! Remove all queued frames without writing them and wait for the frames being written */
+  void DiscardWriteQueue();
+
+  /*! Get an empty frame list from the pool of unused lists. WriteQueueMutex must be locked. */
+  vtkIGSIOTrackedFrameList* AcquireFrameList();
+
+  /*! Create the sequence writer for the file. The written file name is different if a chunked file is written. */
+  PlusStatus CreateWriter(const std::string& sequenceFilename);
+
+  /*! Finalize the header and close the current file. All frames must be written already. */
+  PlusStatus FinalizeFile(const char* aFilename, std::string* resultFilename);
+
+  /*! Start writing the next segment file of the recording */
+  PlusStatus OpenSegmentFile();
+
+  /*! Finalize the current segment file and add it to the segment index */
+  PlusStatus FinalizeSegmentFile();
+
+  /*! Finalize the current segment file and start the next one. Called on the writer thread at an end of segment marker. */
+  PlusStatus StartNextSegmentFile();
+
+  /*!
+    Hand over all recorded frames to the writer thread, followed by an end of segment marker.
+    The writer thread finalizes the segment file, so the capture thread does not wait for the disk.
+  */
+  void RotateSegmentFile();
+
+  /*! Account for the recorded frames starting at firstFrameIndex and return true if the segment file reached its size or duration limit */
+  bool UpdateSegmentFileStatistics(int firstFrameIndex);
+
+  /*! Start the size and duration statistics of a new segment file */
+  void ResetSegmentFileStatistics();
+
+  /*!
+    Account for the frames recorded from firstFrameIndex, hand them over to the writer thread and
+    end the segment file if it is full. Called on the capture thread after frames are recorded.
+  */
+  PlusStatus WriteRecordedFrames(int firstFrameIndex);
+
 protected:
-  /*! Recorded tracked frame list */
+  /*! Recorded tracked frame list, filled by the capture thread. It is accessed only while WriterAccessMutex is locked. */
   vtkIGSIOTrackedFrameList* RecordedFrames;
 
-  /*! Timestamp of last recorded frame (only frames that have more recent timestamp will be added) */
-  double LastAlreadyRecordedFrameTimestamp;
-
-  /*! Desired timestamp of the next frame to be recorded */
-  double NextFrameToBeRecordedTimestamp;
+  /*! Frame lists handed over to the writer thread. A NULL entry marks the end of a segment file. */
+  std::deque<vtkIGSIOTrackedFrameList*> WriteQueue;
+  /*! Empty frame lists, reused for recording to avoid reallocations */
+  std::vector<vtkIGSIOTrackedFrameList*> FreeFrameLists;
+  /*! Protects the write queue, the frame list pool and the writer thread state */
+  std::mutex WriteQueueMutex;
+  /*! Signaled when frames are queued or the writer thread is requested to stop */
+  std::condition_variable WriteQueueCondition;
+  /*! Signaled when a frame list is written */
+  std::condition_variable FrameListWrittenCondition;
+  std::thread WriterThread;
+  bool WriterThreadStopRequested;
+  /*! True while frame lists that are already removed from the queue are being written */
+  bool WritingFrameList;
+  unsigned int WriteQueueMaxNumberOfFrames;
+  unsigned int WriteQueueDepth;
+  unsigned int MaximumWriteQueueDepth;
+  unsigned long NumberOfDroppedFrames;
+  /*! Set if writing to the file failed. Recording is stopped at the next update of the capture thread. */
+  std::atomic<bool> WriteFailed;
+
+  /*! Read position in the input channel: last recorded frame and desired timestamp of the next frame to be recorded */
+  vtkPlusChannel::ReadCursor RecordingCursor;
 
   /*!
     Requested frame rate (frames per second)
@@ -146,6 +291,14 @@ protected:
   double TimeWaited;
   double LastUpdateTime;
 
+  /*!
+    Protects Writer, CurrentFilename, WriteSegmentFiles, SegmentIndex, SegmentFileNumber and FramesRecordedBeforeSegmentFile.
+    The writer thread changes them when it starts a new segment file. Other threads only change them while
+    the writer thread is idle, so the writer thread reads them without locking. It is not locked during file I/O,
+    except for updating the segment index.
+  */
+  std::mutex OutputFileMutex;
+
   /*! File to write */
   std::string CurrentFilename;
   std::string BaseFilename;
@@ -153,14 +306,43 @@ protected:
   /*! Sequence writer to write to */
   vtkIGSIOSequenceIOBase* Writer;
 
+  /*! Output file if compression runs on multiple threads. It is created when the first batch of frames is written. */
+  ChunkedSequenceFile ChunkedFile;
+
+  /*! True if the current file is written to ChunkedFile instead of Writer */
+  bool WriteChunkedFile;
+
+  int NumberOfCompressionThreads;
+
+  double SegmentFileDurationSec;
+  double SegmentFileMaxSizeMB;
+  /*! True if the recording is written to segment files, listed in SegmentIndex */
+  bool WriteSegmentFiles;
+  SequenceSegmentIndex SegmentIndex;
+  /*! Segment file names are composed from the recording file name root, the segment number and the extension */
+  std::string SegmentFilenameRoot;
+  std::string SegmentFilenameExtension;
+  unsigned int SegmentFileNumber;
+  /*! Value of NumberOfWrittenFrames when the current segment file was started. Only accessed by the writer thread while recording. */
+  long int FramesRecordedBeforeSegmentFile;
+  /*! Frames written since the file was opened. Only accessed by the writer thread while recording. */
+  long int NumberOfWrittenFrames;
+  double SegmentFileFirstTimestamp;
+  double SegmentFileLastTimestamp;
+  unsigned long long SegmentFileSizeBytes;
+
+  bool EnableFrameIndex;
+  /*! Frames written to the current file. Only accessed by the writer thread while recording. */
+  SequenceFrameIndex FrameIndex;
+
   /*! When closing the file, re-read the data from file, and write it compressed */
   bool EnableFileCompression;
 
   /*! FourCC code represending the codec to use when writing the file*/
   std::string EncodingFourCC;
 
-  /*! Preparing the header requires image data already collected, this flag makes the header preparation wait until valid data is collected */
-  bool IsHeaderPrepared;
+  /*! Preparing the header requires image data already collected, this flag makes the header preparation wait until valid data is collected. For chunked files it is set when the first chunk is written. */
+  std::atomic<bool> IsHeaderPrepared;
 
   /*! Record the number of frames captured */
   long int TotalFramesRecorded;  // hard drive will probably fill up before a regular int is hit, but still...
@@ -181,7 +363,7 @@ protected:
   vtkPlusLogger::LogLevelType GracePeriodLogLevel;
 
   PlusStatus GetInputTrackedFrame(igsioTrackedFrame& aFrame);
-  PlusStatus GetInputTrackedFrameListSampled(double& lastAlreadyRecordedFrameTimestamp, double& nextFrameToBeRecordedTimestamp, vtkIGSIOTrackedFrameList* recordedFrames, double requestedFramePeriodSec, double maxProcessingTimeSec);
+  PlusStatus GetInputTrackedFrameListSampled(vtkPlusChannel::ReadCursor& cursor, vtkIGSIOTrackedFrameList* recordedFrames, double requestedFramePeriodSec, double maxProcessingTimeSec);
   PlusStatus GetLatestInputItemTimestamp(double& timestamp);
 
 private:
@@ -10,17 +10,52 @@ See License.txt for details.
 #include "vtkPlusDataSource.h"
 #include "vtkPlusVirtualMixer.h"
 
+// VTK includes
+#include <vtkMatrix4x4.h>
+
+// STL includes
+#include <cmath>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusVirtualMixer);
 
+//----------------------------------------------------------------------------
+vtkPlusVirtualMixer::SkewStatistics::SkewStatistics()
+  : NumberOfMixedItems(0)
+  , SumOfSkewsSec(0)
+  , SumOfAbsoluteSkewsSec(0)
+  , MaximumAbsoluteSkewSec(0)
+  , NumberOfMissedDeadlines(0)
+  , NumberOfMissingItems(0)
+{
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusVirtualMixer::SkewStatistics::GetMeanSkewSec() const
+{
+  return this->NumberOfMixedItems > 0 ? this->SumOfSkewsSec / this->NumberOfMixedItems : 0.0;
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusVirtualMixer::SkewStatistics::GetMeanAbsoluteSkewSec() const
+{
+  return this->NumberOfMixedItems > 0 ? this->SumOfAbsoluteSkewsSec / this->NumberOfMixedItems : 0.0;
+}
+
 //----------------------------------------------------------------------------
 vtkPlusVirtualMixer::vtkPlusVirtualMixer()
   : vtkPlusDevice()
+  , MixingMode(MIXING_MODE_PASSIVE)
+  , SyncPolicy(SYNC_POLICY_INTERPOLATE)
+  , SyncDeadlineSec(0.1)
+  , TimelineSource(NULL)
+  , NextTimelineItemUid(0)
+  , LastMixedTimestamp(UNDEFINED_TIMESTAMP)
 {
   this->AcquisitionRate = vtkPlusDevice::VIRTUAL_DEVICE_FRAME_RATE;
 
-  // No need for StartThreadForInternalUpdates, as capturing is performed in other devices, here we just collect references to buffers
+  // In PASSIVE mixing mode there is no need for StartThreadForInternalUpdates, as capturing is performed in other devices, here we just collect references to buffers
 }
 
 //----------------------------------------------------------------------------
@@ -46,6 +81,48 @@ vtkPlusVirtualMixer::~vtkPlusVirtualMixer()
 void vtkPlusVirtualMixer::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os, indent);
+
+  os << indent << "MixingMode: " << (this->MixingMode == MIXING_MODE_ACTIVE ? "ACTIVE" : "PASSIVE") << std::endl;
+  if (this->MixingMode != MIXING_MODE_ACTIVE)
+  {
+    return;
+  }
+  switch (this->SyncPolicy)
+  {
+    case SYNC_POLICY_NEAREST:
+      os << indent << "SyncPolicy: NEAREST" << std::endl;
+      break;
+    case SYNC_POLICY_INTERPOLATE:
+      os << indent << "SyncPolicy: INTERPOLATE" << std::endl;
+      break;
+    case SYNC_POLICY_WAIT_FOR_ALL:
+      os << indent << "SyncPolicy: WAIT_FOR_ALL" << std::endl;
+      break;
+  }
+  os << indent << "SyncDeadlineSec: " << this->SyncDeadlineSec << std::endl;
+  os << indent << "TimelineSource: " << (this->TimelineSource != NULL ? this->TimelineSource->GetId() : "(none)") << std::endl;
+
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  for (std::vector<AlignedTool>::const_iterator it = this->AlignedTools.begin(); it != this->AlignedTools.end(); ++it)
+  {
+    const SkewStatistics& statistics = it->Statistics;
+    os << indent << "Input " << it->InputTool->GetId() << ": MixedItems=" << statistics.NumberOfMixedItems
+       << " MeanSkewSec=" << statistics.GetMeanSkewSec()
+       << " MeanAbsoluteSkewSec=" << statistics.GetMeanAbsoluteSkewSec()
+       << " MaximumAbsoluteSkewSec=" << statistics.MaximumAbsoluteSkewSec
+       << " MissedDeadlines=" << statistics.NumberOfMissedDeadlines
+       << " MissingItems=" << statistics.NumberOfMissingItems << std::endl;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusVirtualMixer::SetMixingMode(MixingModeType mixingMode)
+{
+  this->MixingMode = mixingMode;
+  // In ACTIVE mode the output is generated on the data capture thread, as soon as new input data arrives
+  this->StartThreadForInternalUpdates = (mixingMode == MIXING_MODE_ACTIVE);
+  this->WakeOnInputData = (mixingMode == MIXING_MODE_ACTIVE);
+  this->Modified();
 }
 
 //----------------------------------------------------------------------------
@@ -63,6 +140,43 @@ PlusStatus vtkPlusVirtualMixer::ReadConfiguration(vtkXMLDataElement* rootConfigE
     this->AddOutputChannel(aChannel);
   }
 
+  XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(MixingMode, deviceConfig,
+                                    "PASSIVE", MIXING_MODE_PASSIVE,
+                                    "ACTIVE", MIXING_MODE_ACTIVE);
+  XML_READ_ENUM3_ATTRIBUTE_OPTIONAL(SyncPolicy, deviceConfig,
+                                    "NEAREST", SYNC_POLICY_NEAREST,
+                                    "INTERPOLATE", SYNC_POLICY_INTERPOLATE,
+                                    "WAIT_FOR_ALL", SYNC_POLICY_WAIT_FOR_ALL);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(double, SyncDeadlineSec, deviceConfig);
+  if (this->SyncDeadlineSec < 0)
+  {
+    LOG_ERROR("Invalid SyncDeadlineSec attribute: " << this->SyncDeadlineSec << ". It must not be negative.");
+    return PLUS_FAIL;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualMixer::WriteConfiguration(vtkXMLDataElement* rootConfigElement)
+{
+  XML_FIND_DEVICE_ELEMENT_REQUIRED_FOR_WRITING(deviceConfig, rootConfigElement);
+
+  deviceConfig->SetAttribute("MixingMode", this->MixingMode == MIXING_MODE_ACTIVE ? "ACTIVE" : "PASSIVE");
+  switch (this->SyncPolicy)
+  {
+    case SYNC_POLICY_NEAREST:
+      deviceConfig->SetAttribute("SyncPolicy", "NEAREST");
+      break;
+    case SYNC_POLICY_INTERPOLATE:
+      deviceConfig->SetAttribute("SyncPolicy", "INTERPOLATE");
+      break;
+    case SYNC_POLICY_WAIT_FOR_ALL:
+      deviceConfig->SetAttribute("SyncPolicy", "WAIT_FOR_ALL");
+      break;
+  }
+  deviceConfig->SetDoubleAttribute("SyncDeadlineSec", this->SyncDeadlineSec);
+
   return PLUS_SUCCESS;
 }
 
@@ -113,6 +227,7 @@ PlusStatus vtkPlusVirtualMixer::NotifyConfigured()
   outputChannel->RemoveTools();
   outputChannel->RemoveFieldDataSources();
   outputChannel->Clear();
+  this->TimelineSource = NULL;
 
   for (ChannelContainerIterator it = this->InputChannels.begin(); it != this->InputChannels.end(); ++it)
   {
@@ -123,6 +238,7 @@ PlusStatus vtkPlusVirtualMixer::NotifyConfigured()
     {
       outputChannel->SetVideoSource(aSource);
       this->AddVideoSource(aSource);
+      this->TimelineSource = aSource;
     }
 
     for (DataSourceContainerConstIterator fieldSourceIter = anInputChannel->GetToolsStartConstIterator(); fieldSourceIter != anInputChannel->GetToolsEndConstIterator(); ++fieldSourceIter)
@@ -148,7 +264,18 @@ PlusStatus vtkPlusVirtualMixer::NotifyConfigured()
         }
       }
 
-      if (!found)
+      if (!found && this->MixingMode == MIXING_MODE_ACTIVE)
+      {
+        // The output contains the poses resampled to the output timeline
+        vtkPlusDataSource* anOutputTool = this->GetAlignedOutputTool(anInputTool);
+        if (anOutputTool == NULL)
+        {
+          LOG_ERROR("Unable to add aligned tool " << anInputTool->GetId() << " to device " << this->GetDeviceId());
+          continue;
+        }
+        outputChannel->AddTool(anOutputTool);
+      }
+      else if (!found)
       {
         outputChannel->AddTool(anInputTool);
         if (this->AddTool(anInputTool, false) != PLUS_SUCCESS)
@@ -201,9 +328,248 @@ PlusStatus vtkPlusVirtualMixer::NotifyConfigured()
     }
   }
 
+  if (this->MixingMode == MIXING_MODE_ACTIVE)
+  {
+    if (this->TimelineSource == NULL && !this->AlignedTools.empty())
+    {
+      // No video input, the first tool defines the timeline
+      this->TimelineSource = this->AlignedTools[0].InputTool;
+    }
+    if (this->TimelineSource == NULL)
+    {
+      LOG_ERROR("Active mixing requires a video source or a tool in the input channels of mixer " << this->GetDeviceId());
+      return PLUS_FAIL;
+    }
+    this->NextTimelineItemUid = 0;
+    this->LastMixedTimestamp = UNDEFINED_TIMESTAMP;
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkPlusDataSource* vtkPlusVirtualMixer::GetAlignedOutputTool(vtkPlusDataSource* inputTool)
+{
+  for (std::vector<AlignedTool>::iterator it = this->AlignedTools.begin(); it != this->AlignedTools.end(); ++it)
+  {
+    if (it->InputTool == inputTool)
+    {
+      // Already created by a previous NotifyConfigured call
+      return it->OutputTool;
+    }
+  }
+
+  AlignedTool alignedTool;
+  alignedTool.InputTool = inputTool;
+  alignedTool.OutputTool = vtkSmartPointer<vtkPlusDataSource>::New();
+  alignedTool.OutputTool->SetId(inputTool->GetId());
+  alignedTool.OutputTool->SetType(DATA_SOURCE_TYPE_TOOL);
+  alignedTool.OutputTool->SetReferenceCoordinateFrameName(inputTool->GetReferenceCoordinateFrameName());
+  alignedTool.OutputTool->SetBufferSize(inputTool->GetBufferSize());
+  if (this->AddTool(alignedTool.OutputTool, false) != PLUS_SUCCESS)
+  {
+    return NULL;
+  }
+  this->AlignedTools.push_back(alignedTool);
+  return alignedTool.OutputTool;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualMixer::InternalStartRecording()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  for (std::vector<AlignedTool>::iterator it = this->AlignedTools.begin(); it != this->AlignedTools.end(); ++it)
+  {
+    it->Statistics = SkewStatistics();
+  }
+
+  // Items acquired before recording was started are not mixed
+  this->NextTimelineItemUid = 0;
+  this->LastMixedTimestamp = UNDEFINED_TIMESTAMP;
+  double latestTimestamp(0);
+  if (this->TimelineSource != NULL && this->TimelineSource->GetLatestTimeStamp(latestTimestamp) == ITEM_OK)
+  {
+    this->LastMixedTimestamp = latestTimestamp;
+  }
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualMixer::InternalUpdate()
+{
+  if (this->MixingMode != MIXING_MODE_ACTIVE)
+  {
+    return PLUS_SUCCESS;
+  }
+  return this->MixNewItems(this->GetClockTime());
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualMixer::MixNewItems(double currentSystemTime)
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  if (this->TimelineSource == NULL || this->TimelineSource->GetNumberOfItems() < 1)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  const BufferItemUidType oldestUid = this->TimelineSource->GetOldestItemUidInBuffer();
+  const BufferItemUidType latestUid = this->TimelineSource->GetLatestItemUidInBuffer();
+  BufferItemUidType uid = this->NextTimelineItemUid;
+  if (uid < oldestUid || uid > latestUid + 1)
+  {
+    // Items are overwritten before they could be mixed or the buffer has been cleared
+    uid = oldestUid;
+  }
+
+  PlusStatus status = PLUS_SUCCESS;
+  for (; uid <= latestUid; ++uid)
+  {
+    double timestamp(0);
+    if (this->TimelineSource->GetTimeStamp(uid, timestamp) != ITEM_OK)
+    {
+      continue;
+    }
+    if (this->LastMixedTimestamp != UNDEFINED_TIMESTAMP && timestamp <= this->LastMixedTimestamp)
+    {
+      continue;
+    }
+    const bool deadlineReached = currentSystemTime >= timestamp + this->SyncDeadlineSec;
+    if (this->SyncPolicy == SYNC_POLICY_WAIT_FOR_ALL && !deadlineReached && !this->AreAllInputsAvailable(timestamp))
+    {
+      // Continue with this item in the next update
+      break;
+    }
+    if (this->MixItem(timestamp, deadlineReached) != PLUS_SUCCESS)
+    {
+      status = PLUS_FAIL;
+    }
+    this->LastMixedTimestamp = timestamp;
+  }
+  this->NextTimelineItemUid = uid;
+
+  return status;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusVirtualMixer::AreAllInputsAvailable(double timestamp)
+{
+  for (std::vector<AlignedTool>::iterator it = this->AlignedTools.begin(); it != this->AlignedTools.end(); ++it)
+  {
+    double latestTimestamp(0);
+    if (it->InputTool->GetLatestTimeStamp(latestTimestamp) != ITEM_OK || latestTimestamp < timestamp)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualMixer::MixItem(double timestamp, bool deadlineReached)
+{
+  int numberOfErrors(0);
+  vtkSmartPointer<vtkMatrix4x4> matrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  StreamBufferItem inputItem;
+  for (std::vector<AlignedTool>::iterator it = this->AlignedTools.begin(); it != this->AlignedTools.end(); ++it)
+  {
+    vtkPlusDataSource* inputTool = it->InputTool;
+    SkewStatistics& statistics = it->Statistics;
+
+    double oldestTimestamp(0);
+    double latestTimestamp(0);
+    if (inputTool->GetOldestTimeStamp(oldestTimestamp) != ITEM_OK || inputTool->GetLatestTimeStamp(latestTimestamp) != ITEM_OK)
+    {
+      // No data from this input yet
+      statistics.NumberOfMissingItems++;
+      matrix->Identity();
+      if (it->OutputTool->AddTimeStampedItem(matrix, TOOL_MISSING, this->FrameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+      {
+        numberOfErrors++;
+      }
+      continue;
+    }
+
+    // Items outside of the buffer are not searched, to avoid warnings about items not available yet.
+    // Inside the buffer the item is searched only once: the interpolated item keeps the UID of the nearest input item.
+    ItemStatus itemStatus(ITEM_OK);
+    double nearestTimestamp(UNDEFINED_TIMESTAMP);
+    if (timestamp >= latestTimestamp)
+    {
+      itemStatus = inputTool->GetLatestStreamBufferItem(&inputItem);
+      if (timestamp > latestTimestamp && this->SyncPolicy == SYNC_POLICY_WAIT_FOR_ALL && deadlineReached)
+      {
+        statistics.NumberOfMissedDeadlines++;
+      }
+    }
+    else if (timestamp <= oldestTimestamp)
+    {
+      itemStatus = inputTool->GetOldestStreamBufferItem(&inputItem);
+    }
+    else if (this->SyncPolicy == SYNC_POLICY_NEAREST)
+    {
+      itemStatus = inputTool->GetStreamBufferItemFromTime(timestamp, &inputItem, vtkPlusBuffer::CLOSEST_TIME);
+    }
+    else
+    {
+      itemStatus = inputTool->GetStreamBufferItemFromTime(timestamp, &inputItem, vtkPlusBuffer::INTERPOLATED);
+      if (itemStatus == ITEM_OK)
+      {
+        itemStatus = inputTool->GetTimeStamp(inputItem.GetUid(), nearestTimestamp);
+      }
+    }
+    if (itemStatus != ITEM_OK)
+    {
+      LOG_ERROR("Failed to get item of input " << inputTool->GetId() << " for mixing at time " << std::fixed << timestamp);
+      numberOfErrors++;
+      continue;
+    }
+    if (nearestTimestamp == UNDEFINED_TIMESTAMP)
+    {
+      nearestTimestamp = inputItem.GetFilteredTimestamp(inputTool->GetLocalTimeOffsetSec());
+    }
+
+    const double skewSec = nearestTimestamp - timestamp;
+    statistics.NumberOfMixedItems++;
+    statistics.SumOfSkewsSec += skewSec;
+    statistics.SumOfAbsoluteSkewsSec += std::fabs(skewSec);
+    if (std::fabs(skewSec) > statistics.MaximumAbsoluteSkewSec)
+    {
+      statistics.MaximumAbsoluteSkewSec = std::fabs(skewSec);
+    }
+
+    if (inputItem.GetMatrix(matrix) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get matrix of input " << inputTool->GetId() << " for mixing at time " << std::fixed << timestamp);
+      numberOfErrors++;
+      continue;
+    }
+    if (it->OutputTool->AddTimeStampedItem(matrix, inputItem.GetStatus(), this->FrameNumber, timestamp, timestamp) != PLUS_SUCCESS)
+    {
+      numberOfErrors++;
+    }
+  }
+  this->FrameNumber++;
+
+  return numberOfErrors == 0 ? PLUS_SUCCESS : PLUS_FAIL;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusVirtualMixer::GetInputSkewStatistics(const std::string& inputSourceId, SkewStatistics& statistics)
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  for (std::vector<AlignedTool>::const_iterator it = this->AlignedTools.begin(); it != this->AlignedTools.end(); ++it)
+  {
+    if (it->InputTool->GetId() == inputSourceId)
+    {
+      statistics = it->Statistics;
+      return PLUS_SUCCESS;
+    }
+  }
+  LOG_ERROR("Input " << inputSourceId << " is not mixed by " << this->GetDeviceId() << " in active mixing mode");
+  return PLUS_FAIL;
+}
+
 //----------------------------------------------------------------------------
 bool vtkPlusVirtualMixer::IsTracker() const
 {
@@ -11,11 +11,31 @@ See License.txt for details.
 
 #include "vtkPlusDevice.h"
 
+// STL includes
+#include <vector>
+
 class vtkPlusChannel;
 
 /*!
 \class vtkPlusVirtualMixer 
-\brief 
+\brief Combines the video and tool data of multiple input channels into one output channel
+
+In PASSIVE mixing mode (default) the output channel references the data sources of the inputs and the
+temporal alignment is performed by vtkPlusChannel::GetTrackedFrame each time a frame is read.
+
+In ACTIVE mixing mode the mixer produces a pre-aligned output stream: the timeline is defined by the input
+video source (or the first input tool, if there is no video input), and for each new item on the timeline
+the poses of all input tools are resampled to the exact same timestamp and stored in tool buffers owned by
+the mixer. The video and field data sources are still referenced. How the input poses are resampled is
+selected by SyncPolicy:
+ - NEAREST: the pose acquired closest in time is used
+ - INTERPOLATE: the pose is interpolated from the two neighboring items (nearest, if the item is not acquired yet)
+ - WAIT_FOR_ALL: same as INTERPOLATE, but mixing waits until all inputs have data up to the timestamp or
+   SyncDeadlineSec has elapsed since the timestamp. Inputs that are late at the deadline get their latest
+   pose and a missed deadline is recorded for them.
+
+For each input tool the skew between the timestamp of the nearest input item and the output timestamp
+is recorded, see GetInputSkewStatistics.
 
 \ingroup PlusLibDataCollection
 */
@@ -39,6 +59,9 @@ public:
   /*! Read main configuration from xml data */
   virtual PlusStatus ReadConfiguration(vtkXMLDataElement*);
 
+  /*! Write main configuration to xml data */
+  virtual PlusStatus WriteConfiguration(vtkXMLDataElement*);
+
   // Virtual stream mixers output only one stream
   vtkPlusChannel* GetChannel() const;
 
@@ -49,10 +72,92 @@ public:
 
   virtual double GetAcquisitionRate() const;
 
+  enum MixingModeType
+  {
+    MIXING_MODE_PASSIVE,
+    MIXING_MODE_ACTIVE
+  };
+
+  enum SyncPolicyType
+  {
+    SYNC_POLICY_NEAREST,
+    SYNC_POLICY_INTERPOLATE,
+    SYNC_POLICY_WAIT_FOR_ALL
+  };
+
+  /*! Set the mixing mode. It must be set before NotifyConfigured is called. */
+  void SetMixingMode(MixingModeType mixingMode);
+  vtkGetMacro(MixingMode, MixingModeType);
+
+  vtkSetMacro(SyncPolicy, SyncPolicyType);
+  vtkGetMacro(SyncPolicy, SyncPolicyType);
+
+  /*! Maximum time to wait for late inputs in WAIT_FOR_ALL sync policy, measured from the timestamp of the output item */
+  vtkSetMacro(SyncDeadlineSec, double);
+  vtkGetMacro(SyncDeadlineSec, double);
+
+  /*! Temporal skew between an input tool and the output timeline in ACTIVE mixing mode */
+  struct SkewStatistics
+  {
+    SkewStatistics();
+    /*! Number of output items that the input contributed to */
+    unsigned long NumberOfMixedItems;
+    /*! Sum of (timestamp of the nearest input item - output timestamp) */
+    double SumOfSkewsSec;
+    double SumOfAbsoluteSkewsSec;
+    double MaximumAbsoluteSkewSec;
+    /*! Number of output items for which the input had no data at the deadline (WAIT_FOR_ALL sync policy) */
+    unsigned long NumberOfMissedDeadlines;
+    /*! Number of output items for which the input had no data at all */
+    unsigned long NumberOfMissingItems;
+
+    double GetMeanSkewSec() const;
+    double GetMeanAbsoluteSkewSec() const;
+  };
+
+  /*! Get the skew statistics of an input tool (identified by its source id) since recording was started */
+  PlusStatus GetInputSkewStatistics(const std::string& inputSourceId, SkewStatistics& statistics);
+
+  /*!
+    Mix all items of the timeline that are not mixed yet. Called by InternalUpdate with the current system time
+    in ACTIVE mixing mode. The time is used for checking the WAIT_FOR_ALL deadline.
+  */
+  PlusStatus MixNewItems(double currentSystemTime);
+
 protected:
   vtkPlusVirtualMixer();
   virtual ~vtkPlusVirtualMixer();
 
+  virtual PlusStatus InternalUpdate();
+  virtual PlusStatus InternalStartRecording();
+
+  /*! An input tool and the tool owned by the mixer that contains its poses resampled to the output timeline */
+  struct AlignedTool
+  {
+    vtkPlusDataSource* InputTool;
+    vtkSmartPointer<vtkPlusDataSource> OutputTool;
+    SkewStatistics Statistics;
+  };
+
+  /*! Create (or reuse) the output tool for an input tool in ACTIVE mixing mode */
+  vtkPlusDataSource* GetAlignedOutputTool(vtkPlusDataSource* inputTool);
+
+  /*! Returns true if all input tools have data up to the timestamp */
+  bool AreAllInputsAvailable(double timestamp);
+
+  /*! Resample the poses of all input tools to the timestamp and add them to the output tools */
+  PlusStatus MixItem(double timestamp, bool deadlineReached);
+
+  MixingModeType MixingMode;
+  SyncPolicyType SyncPolicy;
+  double SyncDeadlineSec;
+
+  /*! Source that defines the output timeline in ACTIVE mixing mode: the input video source or the first input tool */
+  vtkPlusDataSource* TimelineSource;
+  std::vector<AlignedTool> AlignedTools;
+  BufferItemUidType NextTimelineItemUid;
+  double LastMixedTimestamp;
+
 private:
   vtkPlusVirtualMixer(const vtkPlusVirtualMixer&);  // Not implemented.
   void operator=(const vtkPlusVirtualMixer&);  // Not implemented. 
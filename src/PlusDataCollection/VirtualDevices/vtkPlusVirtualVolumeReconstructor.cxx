@@ -25,8 +25,6 @@ static const int MAX_ALLOWED_RECONSTRUCTION_LAG_SEC = 3.0; // if the reconstruct
 //----------------------------------------------------------------------------
 vtkPlusVirtualVolumeReconstructor::vtkPlusVirtualVolumeReconstructor()
   : vtkPlusDevice()
-  , m_LastAlreadyRecordedFrameTimestamp(UNDEFINED_TIMESTAMP)
-  , m_NextFrameToBeRecordedTimestamp(0.0)
   , m_SamplingFrameRate(8)
   , RequestedFrameRate(0.0)
   , m_TimeWaited(0.0)
@@ -37,6 +35,8 @@ vtkPlusVirtualVolumeReconstructor::vtkPlusVirtualVolumeReconstructor()
 {
   // The data capture thread will be used to regularly read the frames and write to disk
   this->StartThreadForInternalUpdates = true;
+  // Frames are sampled when new input data arrives instead of polling the inputs
+  this->WakeOnInputData = true;
 
   this->VolumeReconstructor = vtkSmartPointer<vtkPlusVolumeReconstructor>::New();
   this->TransformRepository = vtkSmartPointer<vtkIGSIOTransformRepository>::New();
@@ -107,7 +107,7 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalConnect()
     LOG_WARNING("vtkPlusVirtualVolumeReconstructor acquisition rate is not known");
   }
 
-  m_LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_LastUpdateTime = this->GetClockTime();
 
   return PLUS_SUCCESS;
 }
@@ -130,15 +130,18 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
 
   if (m_LastUpdateTime == 0.0)
   {
-    m_LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_LastUpdateTime = this->GetClockTime();
   }
-  if (m_NextFrameToBeRecordedTimestamp == 0.0)
+  if (m_RecordingCursor.NextSampleTimestamp == UNDEFINED_TIMESTAMP)
   {
-    m_NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_RecordingCursor.NextSampleTimestamp = this->GetClockTime();
   }
-  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+  double startTimeSec = this->GetClockTime();
+  const double processingStartTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
 
+  // The thread may wake up on every new input item, so the time since the previous call is accumulated
   m_TimeWaited += startTimeSec - m_LastUpdateTime;
+  m_LastUpdateTime = startTimeSec;
 
   if (m_TimeWaited < GetSamplingPeriodSec())
   {
@@ -149,6 +152,11 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
   m_TimeWaited = 0.0;
 
   double maxProcessingTimeSec = GetSamplingPeriodSec() * 2.0; // put a hard limit on the max processing time to make sure the application remains responsive during reconstruction
+  if (this->IsDrivenByReplayClock())
+  {
+    // The replay timeline waits for the reconstruction, so all frames are added and the reconstruction is reproducible
+    maxProcessingTimeSec = 0.0;
+  }
   double requestedFramePeriodSec = 0.1;
   double requestedFrameRate = this->RequestedFrameRate;
   if (requestedFrameRate <= 0)
@@ -180,9 +188,9 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
   vtkPlusChannel* outputChannel = this->OutputChannels[0];
 
   vtkSmartPointer<vtkIGSIOTrackedFrameList> recordedFrames = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
-  if (outputChannel->GetTrackedFrameListSampled(m_LastAlreadyRecordedFrameTimestamp, m_NextFrameToBeRecordedTimestamp, recordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
+  if (outputChannel->GetTrackedFrameListSampled(m_RecordingCursor, recordedFrames, requestedFramePeriodSec, maxProcessingTimeSec) != PLUS_SUCCESS)
   {
-    LOG_ERROR("Error while getting tracked frame list from data collector during volume reconstruction. Last recorded timestamp: " << std::fixed << m_NextFrameToBeRecordedTimestamp);
+    LOG_ERROR("Error while getting tracked frame list from data collector during volume reconstruction. Last recorded timestamp: " << std::fixed << m_RecordingCursor.NextSampleTimestamp);
   }
   int nbFramesRecorded = recordedFrames->GetNumberOfTrackedFrames();
 
@@ -195,20 +203,20 @@ PlusStatus vtkPlusVirtualVolumeReconstructor::InternalUpdate()
   this->TotalFramesRecorded += nbFramesRecorded;
 
   // Check whether the reconstruction needed more time than the sampling interval
-  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
-  if (recordingTimeSec > GetSamplingPeriodSec())
+  double recordingTimeSec = vtkIGSIOAccurateTimer::GetSystemTime() - processingStartTimeSec;
+  if (recordingTimeSec > GetSamplingPeriodSec() && !this->IsDrivenByReplayClock())
   {
     LOG_WARNING("Volume reconstruction of the acquired " << nbFramesRecorded << " frames takes too long time (" << recordingTimeSec << "sec instead of the allocated " << GetSamplingPeriodSec() << "sec). This can cause slow-down of the application and non-uniform sampling. Reduce the image acquisition rate, output size, or image clip rectangle size to resolve the problem.");
   }
-  double recordingLagSec = vtkIGSIOAccurateTimer::GetSystemTime() - m_NextFrameToBeRecordedTimestamp;
+  double recordingLagSec = this->GetClockTime() - m_RecordingCursor.NextSampleTimestamp;
 
   if (recordingLagSec > MAX_ALLOWED_RECONSTRUCTION_LAG_SEC)
   {
     LOG_ERROR("Volume reconstruction cannot keep up with the acquisition. Skip " << recordingLagSec << " seconds of the data stream to catch up.");
-    m_NextFrameToBeRecordedTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
+    m_RecordingCursor.NextSampleTimestamp = this->GetClockTime();
   }
 
-  m_LastUpdateTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  m_LastUpdateTime = this->GetClockTime();
 
   return PLUS_SUCCESS;
 }
@@ -253,8 +261,7 @@ void vtkPlusVirtualVolumeReconstructor::SetEnableReconstruction(bool aValue)
     // set the recording start time to add frames from now on
     m_LastUpdateTime = 0.0;
     m_TimeWaited = 0.0;
-    m_LastAlreadyRecordedFrameTimestamp = UNDEFINED_TIMESTAMP;
-    m_NextFrameToBeRecordedTimestamp = 0.0;
+    m_RecordingCursor = vtkPlusChannel::ReadCursor();
     this->EnableReconstruction = true;
   }
   else
@@ -122,11 +122,8 @@ protected:
   virtual ~vtkPlusVirtualVolumeReconstructor();
 
 protected:
-  /*! Timestamp of last recorded frame (only frames that have more recent timestamp will be added) */
-  double m_LastAlreadyRecordedFrameTimestamp;
-
-  /*! Desired timestamp of the next frame to be recorded */
-  double m_NextFrameToBeRecordedTimestamp;
+  /*! Read position in the output channel: last recorded frame and desired timestamp of the next frame to be recorded */
+  vtkPlusChannel::ReadCursor m_RecordingCursor;
 
   /*! Frame rate of the sampling */
   const int m_SamplingFrameRate;
@@ -6,6 +6,10 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusBufferSpillFile.h"
+#include "PlusFrameMemorySlab.h"
+#include "PlusPoseInterpolator.h"
+#include "PixelCodec.h"
 #include "igsioMath.h"
 #include "igsioTrackedFrame.h"
 #include "vtkPlusBuffer.h"
@@ -14,19 +18,30 @@ See License.txt for details.
 #include "vtkIGSIOTrackedFrameList.h"
 
 // VTK includes
+#include <vtkDataArray.h>
 #include <vtkDoubleArray.h>
 #include <vtkImageData.h>
 #include <vtkIntArray.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkObjectFactory.h>
+#include <vtkPointData.h>
 #include <vtkUnsignedLongLongArray.h>
 
 // vtkAddon includes
 #include <vtkStreamingVolumeCodec.h>
 
+// VTKSYS includes
+#include <vtksys/SystemTools.hxx>
+
+// STL includes
+#include <algorithm>
+#include <cstring>
+
 static const double NEGLIGIBLE_TIME_DIFFERENCE = 0.00001; // in seconds, used for comparing between exact timestamps
 static const double ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG = 10; // if the interpolated orientation differs from both the interpolated orientation by more than this threshold then display a warning
+static const size_t FRAME_MEMORY_ALIGNMENT_BYTES = 64; // frames in the frame memory slab start at cache line boundaries
+static const double SPILL_THREAD_WAIT_TIMEOUT_SEC = 0.1; // the spill thread checks for a stop request at least this often
 
 vtkStandardNewMacro(vtkPlusBuffer);
 
@@ -84,6 +99,18 @@ vtkPlusBuffer::vtkPlusBuffer()
   , StreamBuffer(vtkPlusTimestampedCircularBuffer::New())
   , MaxAllowedTimeDifference(0.5)
   , DescriptiveName(NULL)
+  , ContiguousFrameMemory(false)
+  , FrameMemoryHugePages(false)
+  , FrameSlab(NULL)
+  , SpillToDisk(false)
+  , SpillSegmentSizeMB(64)
+  , SpillMaxSizeMB(1024)
+  , SpillFile(NULL)
+  , SpillFailed(false)
+  , SpillThreadStopRequested(false)
+  , SpillNotifier(vtkSmartPointer<vtkPlusNewDataNotifier>::New())
+  , ContainsNativeFrames(false)
+  , NumberOfNativeFrameConversions(0)
 {
   this->FrameSize[0] = 0;
   this->FrameSize[1] = 0;
@@ -98,8 +125,22 @@ vtkPlusBuffer::vtkPlusBuffer()
 //----------------------------------------------------------------------------
 vtkPlusBuffer::~vtkPlusBuffer()
 {
+  this->StopSpillThread();
   if (this->StreamBuffer != NULL)
   {
+    // Item views may keep the circular buffer alive, so its frames must not refer to the slab after it is released
+    {
+      igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+      if (this->FrameSlab != NULL && this->StreamBuffer->GetNumberOfPins() > 0)
+      {
+        // The pinned frames are still read, the slab is released together with the circular buffer
+        this->StreamBuffer->RetainUntilDeleted(std::shared_ptr<void>(this->FrameSlab));
+        this->FrameSlab = NULL;
+      }
+      this->ReleaseFrameMemorySlab();
+      delete this->SpillFile;
+      this->SpillFile = NULL;
+    }
     this->StreamBuffer->Delete();
     this->StreamBuffer = NULL;
   }
@@ -113,6 +154,15 @@ void vtkPlusBuffer::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Scalar pixel type: " << vtkImageScalarTypeNameMacro(this->GetPixelType()) << std::endl;
   os << indent << "Image type: " << igsioVideoFrame::GetStringFromUsImageType(this->GetImageType()) << std::endl;
   os << indent << "Image orientation: " << igsioVideoFrame::GetStringFromUsImageOrientation(this->GetImageOrientation()) << std::endl;
+  os << indent << "Contiguous frame memory: " << (this->ContiguousFrameMemory ? "ON" : "OFF") << std::endl;
+  os << indent << "Frame memory huge pages: " << (this->FrameMemoryHugePages ? "ON" : "OFF") << std::endl;
+  os << indent << "Spill to disk: " << (this->SpillToDisk ? "ON" : "OFF") << std::endl;
+  if (this->SpillToDisk)
+  {
+    os << indent << "Spill directory: " << this->SpillDirectory << std::endl;
+    os << indent << "Spill segment size: " << this->SpillSegmentSizeMB << " MB" << std::endl;
+    os << indent << "Spill maximum size: " << this->SpillMaxSizeMB << " MB" << std::endl;
+  }
 
   os << indent << "StreamBuffer: " << this->StreamBuffer << "\n";
   if (this->StreamBuffer)
@@ -125,6 +175,16 @@ void vtkPlusBuffer::PrintSelf(ostream& os, vtkIndent indent)
 PlusStatus vtkPlusBuffer::AllocateMemoryForFrames()
 {
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->ContiguousFrameMemory && this->StreamBuffer->GetBufferSize() > 0
+      && this->FrameSize[0] > 0 && this->FrameSize[1] > 0 && this->FrameSize[2] > 0)
+  {
+    return this->AllocateFrameMemorySlab();
+  }
+  if (this->ReleaseFrameMemorySlab() != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
   PlusStatus result = PLUS_SUCCESS;
 
   for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
@@ -141,6 +201,343 @@ PlusStatus vtkPlusBuffer::AllocateMemoryForFrames()
   return result;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AllocateFrameMemorySlab()
+{
+  if (this->StreamBuffer->GetNumberOfPins() > 0)
+  {
+    LOCAL_LOG_ERROR("Failed to allocate frame memory slab: " << this->StreamBuffer->GetNumberOfPins() << " item views refer to the frames of the buffer");
+    return PLUS_FAIL;
+  }
+
+  vtkSmartPointer<vtkDataArray> prototypeScalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(this->PixelType));
+  if (prototypeScalars.GetPointer() == NULL)
+  {
+    LOCAL_LOG_ERROR("Failed to allocate frame memory slab: unsupported pixel type " << this->PixelType);
+    return PLUS_FAIL;
+  }
+  const vtkIdType numberOfValues = static_cast<vtkIdType>(this->FrameSize[0]) * this->FrameSize[1] * this->FrameSize[2] * this->NumberOfScalarComponents;
+  const size_t frameSizeInBytes = static_cast<size_t>(numberOfValues) * prototypeScalars->GetDataTypeSize();
+  const size_t frameStrideInBytes = (frameSizeInBytes + FRAME_MEMORY_ALIGNMENT_BYTES - 1) / FRAME_MEMORY_ALIGNMENT_BYTES * FRAME_MEMORY_ALIGNMENT_BYTES;
+  const int bufferSize = this->StreamBuffer->GetBufferSize();
+
+  FrameMemorySlab* slab = new FrameMemorySlab;
+  if (slab->Allocate(frameStrideInBytes * bufferSize, this->FrameMemoryHugePages) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to allocate frame memory slab for " << bufferSize << " frames");
+    delete slab;
+    return PLUS_FAIL;
+  }
+  slab->Prefault();
+
+  for (int i = 0; i < bufferSize; ++i)
+  {
+    igsioVideoFrame& frame = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame();
+    vtkImageData* image = frame.GetImage();
+    if (image == NULL)
+    {
+      continue;
+    }
+    vtkDataArray* currentScalars = image->GetPointData()->GetScalars();
+    if (frame.IsFrameEncoded())
+    {
+      if (currentScalars != NULL && this->FrameSlab != NULL && this->FrameSlab->Contains(currentScalars->GetVoidPointer(0)))
+      {
+        image->Initialize();
+      }
+      continue;
+    }
+
+    unsigned char* frameMemory = slab->GetPointer() + i * frameStrideInBytes;
+    // Keep the content of frames that already have the buffer frame format (e.g., when the buffer is resized)
+    if (currentScalars != NULL && currentScalars->GetDataType() == this->PixelType
+        && currentScalars->GetNumberOfComponents() == static_cast<int>(this->NumberOfScalarComponents)
+        && currentScalars->GetNumberOfValues() == numberOfValues)
+    {
+      memcpy(frameMemory, currentScalars->GetVoidPointer(0), frameSizeInBytes);
+    }
+
+    vtkSmartPointer<vtkDataArray> frameScalars = vtkSmartPointer<vtkDataArray>::Take(vtkDataArray::CreateDataArray(this->PixelType));
+    frameScalars->SetNumberOfComponents(this->NumberOfScalarComponents);
+    // The memory is owned by the slab, the array must not free it
+    frameScalars->SetVoidArray(frameMemory, numberOfValues, 1);
+    image->SetExtent(0, this->FrameSize[0] - 1, 0, this->FrameSize[1] - 1, 0, this->FrameSize[2] - 1);
+    image->GetPointData()->SetScalars(frameScalars);
+  }
+
+  // No frame refers to the previous slab anymore
+  delete this->FrameSlab;
+  this->FrameSlab = slab;
+  LOCAL_LOG_DEBUG("Allocated frame memory slab of " << slab->GetSize() << " bytes for " << bufferSize << " frames"
+                  << (slab->IsHugePageBacked() ? " from the huge page pool" : ""));
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::ReleaseFrameMemorySlab()
+{
+  if (this->FrameSlab == NULL)
+  {
+    return PLUS_SUCCESS;
+  }
+  if (this->StreamBuffer->GetNumberOfPins() > 0)
+  {
+    LOCAL_LOG_ERROR("Failed to release frame memory slab: " << this->StreamBuffer->GetNumberOfPins() << " item views refer to the frames of the buffer");
+    return PLUS_FAIL;
+  }
+  for (int i = 0; i < this->StreamBuffer->GetBufferSize(); ++i)
+  {
+    vtkImageData* image = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(i)->GetFrame().GetImage();
+    if (image == NULL)
+    {
+      continue;
+    }
+    vtkDataArray* scalars = image->GetPointData()->GetScalars();
+    if (scalars != NULL && this->FrameSlab->Contains(scalars->GetVoidPointer(0)))
+    {
+      // The frame is allocated again from the heap by the next AllocateFrame call
+      image->Initialize();
+    }
+  }
+  delete this->FrameSlab;
+  this->FrameSlab = NULL;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetContiguousFrameMemory(bool enable)
+{
+  if (enable == this->ContiguousFrameMemory)
+  {
+    // no change
+    return PLUS_SUCCESS;
+  }
+  this->ContiguousFrameMemory = enable;
+  return this->AllocateMemoryForFrames();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetFrameMemoryHugePages(bool enable)
+{
+  if (enable == this->FrameMemoryHugePages)
+  {
+    // no change
+    return PLUS_SUCCESS;
+  }
+  this->FrameMemoryHugePages = enable;
+  if (!this->ContiguousFrameMemory)
+  {
+    return PLUS_SUCCESS;
+  }
+  return this->AllocateMemoryForFrames();
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::SetSpillToDisk(bool enable)
+{
+  if (enable == this->SpillToDisk)
+  {
+    // no change
+    return PLUS_SUCCESS;
+  }
+
+  this->StopSpillThread();
+  PlusStatus status(PLUS_SUCCESS);
+  {
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    this->SpillToDisk = enable;
+    if (enable)
+    {
+      status = this->OpenSpillFile();
+    }
+    else
+    {
+      delete this->SpillFile;
+      this->SpillFile = NULL;
+    }
+  }
+  this->StartSpillThread();
+  return status;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::OpenSpillFile()
+{
+  std::string directory = this->SpillDirectory;
+  if (directory.empty())
+  {
+    directory = vtkPlusConfig::GetInstance()->GetOutputDirectory();
+  }
+  std::ostringstream fileNamePrefix;
+  fileNamePrefix << "BufferSpill_" << (this->DescriptiveName != NULL ? this->DescriptiveName : "Buffer")
+                 << "_" << vtksys::SystemTools::GetCurrentDateTime("%Y%m%d_%H%M%S") << "_" << this;
+
+  if (this->SpillFile == NULL)
+  {
+    this->SpillFile = new BufferSpillFile;
+  }
+  const size_t bytesPerMegabyte = 1024 * 1024;
+  if (this->SpillFile->Open(directory, fileNamePrefix.str(), static_cast<size_t>(this->SpillSegmentSizeMB) * bytesPerMegabyte,
+                            static_cast<size_t>(this->SpillMaxSizeMB) * bytesPerMegabyte) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Failed to create spill files in " << directory << ", spilling to disk is disabled");
+    delete this->SpillFile;
+    this->SpillFile = NULL;
+    this->SpillToDisk = false;
+    return PLUS_FAIL;
+  }
+  this->SpillFailed = false;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::CopyUnspilledItem(bool evictedItemOnly, StreamBufferItem& itemCopy)
+{
+  // the caller must have locked the buffer
+  if (this->StreamBuffer->GetNumberOfItems() == 0)
+  {
+    return PLUS_FAIL;
+  }
+  const BufferItemUidType oldestUid = this->StreamBuffer->GetOldestItemUidInBuffer();
+  if (evictedItemOnly && this->StreamBuffer->GetNumberOfItems() < this->StreamBuffer->GetBufferSize())
+  {
+    // no item is removed when the next item is added
+    return PLUS_FAIL;
+  }
+  const BufferItemUidType uid = std::max(this->SpillFile->GetLatestItemUid() + 1, oldestUid);
+  if (uid > (evictedItemOnly ? oldestUid : this->StreamBuffer->GetLatestItemUidInBuffer()))
+  {
+    return PLUS_FAIL;
+  }
+  StreamBufferItem* item = NULL;
+  if (this->StreamBuffer->GetBufferItemPointerFromUid(uid, item) != ITEM_OK)
+  {
+    return PLUS_FAIL;
+  }
+  // The native frame is copied if it has not been converted yet, it is converted when the spilled item is read
+  std::unique_lock<std::mutex> conversionLock;
+  if (this->ContainsNativeFrames)
+  {
+    conversionLock = std::unique_lock<std::mutex>(this->GetNativeFrameConversionMutex(item));
+  }
+  itemCopy = *item;
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AppendToSpillFile(StreamBufferItem& itemCopy)
+{
+  if (this->SpillFailed)
+  {
+    return PLUS_FAIL;
+  }
+  if (this->SpillFile->AppendItem(&itemCopy, itemCopy.HasUnconvertedNativeFrame()) != PLUS_SUCCESS)
+  {
+    if (!this->SpillFailed.exchange(true))
+    {
+      LOCAL_LOG_ERROR("Failed to spill item " << itemCopy.GetUid() << " to disk, no more items are spilled");
+    }
+    return PLUS_FAIL;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SpillItemBeforeEviction()
+{
+  if (this->SpillFile == NULL || this->SpillFailed)
+  {
+    return;
+  }
+  StreamBufferItem itemCopy;
+  {
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->CopyUnspilledItem(true, itemCopy) != PLUS_SUCCESS)
+    {
+      // the spill thread has already stored the item that is removed next
+      return;
+    }
+  }
+  this->AppendToSpillFile(itemCopy);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::StartSpillThread()
+{
+  if (this->SpillFile == NULL || this->SpillThread.joinable())
+  {
+    return;
+  }
+  this->SpillThreadStopRequested = false;
+  this->AddNewDataNotifier(this->SpillNotifier);
+  this->SpillThread = std::thread(&vtkPlusBuffer::SpillThreadMain, this);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::StopSpillThread()
+{
+  if (!this->SpillThread.joinable())
+  {
+    return;
+  }
+  this->SpillThreadStopRequested = true;
+  this->SpillNotifier->Notify();
+  this->SpillThread.join();
+  this->RemoveNewDataNotifier(this->SpillNotifier);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SpillThreadMain()
+{
+  unsigned long long sequenceNumber = this->SpillNotifier->GetSequenceNumber();
+  while (!this->SpillThreadStopRequested)
+  {
+    // Store all items that have been added since the last wakeup
+    while (!this->SpillThreadStopRequested && !this->SpillFailed)
+    {
+      // The item is copied instead of pinned, so the slot can be overwritten while the copy is written
+      StreamBufferItem itemCopy;
+      {
+        igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+        if (this->CopyUnspilledItem(false, itemCopy) != PLUS_SUCCESS)
+        {
+          break;
+        }
+      }
+      if (this->AppendToSpillFile(itemCopy) != PLUS_SUCCESS)
+      {
+        break;
+      }
+    }
+    this->SpillNotifier->WaitForNewData(sequenceNumber, SPILL_THREAD_WAIT_TIMEOUT_SEC);
+  }
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusBuffer::GetNumberOfSpilledItems()
+{
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->SpillFile == NULL)
+  {
+    return 0;
+  }
+  // The spill thread also stores the items that are still in the buffer
+  return this->SpillFile->GetNumberOfItemsBefore(this->StreamBuffer->GetOldestItemUidInBuffer());
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::PrepareForNewItem(double filteredTimestamp, BufferItemUidType& itemUid, int& bufferIndex)
+{
+  if (this->SpillFile != NULL && !this->SpillFailed && this->StreamBuffer->GetBufferSize() > 0
+      && this->StreamBuffer->GetNumberOfItems() >= this->StreamBuffer->GetBufferSize()
+      && !this->SpillFile->ContainsItem(this->StreamBuffer->GetOldestItemUidInBuffer()))
+  {
+    // Only happens if another thread added an item after SpillItemBeforeEviction, the file is not written while the buffer is locked
+    LOCAL_LOG_DEBUG("Item " << this->StreamBuffer->GetOldestItemUidInBuffer() << " is removed from the buffer before it is spilled to disk");
+  }
+  return this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex);
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::SetLocalTimeOffsetSec(double offsetSec)
 {
@@ -352,34 +749,39 @@ PlusStatus vtkPlusBuffer::AddItem(const igsioFieldMapType& fields,
   int bufferIndex(0);
   BufferItemUidType itemUid;
 
-  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
-    // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
-    LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
-    return PLUS_FAIL;
-  }
+    this->SpillItemBeforeEviction();
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+    {
+      // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
+      return PLUS_FAIL;
+    }
 
-  // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
-  if (newObjectInBuffer == NULL)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
-    return PLUS_FAIL;
-  }
+    // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
+    StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+    if (newObjectInBuffer == NULL)
+    {
+      LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
+      return PLUS_FAIL;
+    }
 
-  newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
-  newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
-  newObjectInBuffer->SetIndex(frameNumber);
-  newObjectInBuffer->SetUid(itemUid);
+    newObjectInBuffer->ClearNativeFrame();
+    newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
+    newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
+    newObjectInBuffer->SetIndex(frameNumber);
+    newObjectInBuffer->SetUid(itemUid);
 
-  // Add custom fields
-  for (igsioFieldMapType::const_iterator it = fields.begin(); it != fields.end(); ++it)
-  {
-    newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
-    std::string name(it->first);
+    // Add custom fields
+    for (igsioFieldMapType::const_iterator it = fields.begin(); it != fields.end(); ++it)
+    {
+      newObjectInBuffer->SetFrameField(this->GetFrameFieldId(it->first), it->second.second, it->second.first);
+    }
   }
 
+  // Notify after the buffer is unlocked, so that the woken consumers do not have to wait for the lock
+  this->NotifyNewData();
   return PLUS_SUCCESS;
 }
 
@@ -399,29 +801,14 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
                                   const igsioFieldMapType* customFields /*= NULL */,
                                   vtkStreamingVolumeFrame* encodedFrame /*=NULL*/)
 {
-  if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
-  {
-    unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
-  }
-
-  if (filteredTimestamp == UNDEFINED_TIMESTAMP)
+  bool skipItem(false);
+  if (this->PrepareVideoItemTimestamps(frameNumber, unfilteredTimestamp, filteredTimestamp, skipItem) != PLUS_SUCCESS)
   {
-    bool filteredTimestampProbablyValid = true;
-    if (this->StreamBuffer->CreateFilteredTimeStampForItem(frameNumber, unfilteredTimestamp, filteredTimestamp, filteredTimestampProbablyValid) != PLUS_SUCCESS)
-    {
-      LOCAL_LOG_WARNING("Failed to create filtered timestamp for video buffer item with item index: " << frameNumber);
-      return PLUS_FAIL;
-    }
-    if (!filteredTimestampProbablyValid)
-    {
-      LOG_INFO("Filtered timestamp is probably invalid for video buffer item with item index=" << frameNumber << ", time=" <<
-               unfilteredTimestamp << ". The item may have been tagged with an inaccurate timestamp, therefore it will not be recorded.");
-      return PLUS_SUCCESS;
-    }
+    return PLUS_FAIL;
   }
-  else
+  if (skipItem)
   {
-    this->StreamBuffer->AddToTimeStampReport(frameNumber, unfilteredTimestamp, filteredTimestamp);
+    return PLUS_SUCCESS;
   }
 
   if (imageDataPtr == NULL && encodedFrame == NULL)
@@ -461,82 +848,218 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr,
     return PLUS_FAIL;
   }
 
-  int bufferIndex(0);
-  BufferItemUidType itemUid;
-  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
-    // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
-    LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to video buffer!");
+    this->SpillItemBeforeEviction();
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    StreamBufferItem* newObjectInBuffer = this->PrepareNewVideoItem(frameNumber, unfilteredTimestamp, filteredTimestamp);
+    if (newObjectInBuffer == NULL)
+    {
+      return PLUS_FAIL;
+    }
+
+    FrameSizeType receivedFrameSize = { 0, 0, 0 };
+    newObjectInBuffer->GetFrame().GetFrameSize(receivedFrameSize);
+
+    if (imageDataPtr && !encodedFrame &&
+        (outputFrameSizeInPx[0] != receivedFrameSize[0]
+         || outputFrameSizeInPx[1] != receivedFrameSize[1]
+         || outputFrameSizeInPx[2] != receivedFrameSize[2]))
+    {
+      LOCAL_LOG_ERROR("Input frame size is different from buffer frame size (input: " <<
+                      outputFrameSizeInPx[0] << "x" << outputFrameSizeInPx[1] << "x" << outputFrameSizeInPx[2] <<
+                      ",   buffer: " <<
+                      receivedFrameSize[0] << "x" << receivedFrameSize[1] << "x" << receivedFrameSize[2] << ")!");
+      return PLUS_FAIL;
+    }
+
+    // Skip the numberOfBytesToSkip bytes, e.g. header size
+    if (imageDataPtr != NULL)
+    {
+      unsigned char* byteImageDataPtr = reinterpret_cast<unsigned char*>(imageDataPtr);
+      byteImageDataPtr += numberOfBytesToSkip;
+
+      if (igsioVideoFrame::GetOrientedClippedImage(byteImageDataPtr, flipInfo, imageType, pixelType, numberOfScalarComponents, inputFrameSizeInPx, newObjectInBuffer->GetFrame(), clipRectangleOrigin, clipRectangleSize) != PLUS_SUCCESS)
+      {
+        LOCAL_LOG_ERROR("Failed to convert input US image to the requested orientation!");
+        return PLUS_FAIL;
+      }
+    }
+    else if (encodedFrame != NULL)
+    {
+      newObjectInBuffer->GetFrame().SetEncodedFrame(encodedFrame);
+    }
+
+    newObjectInBuffer->ClearNativeFrame();
+    newObjectInBuffer->GetFrame().SetImageType(imageType);
+    this->SetCustomFields(newObjectInBuffer, customFields);
+  }
+
+  // Notify after the buffer is unlocked, so that the woken consumers do not have to wait for the lock
+  this->NotifyNewData();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frameSize, unsigned int inputFrameSizeInBytes, US_IMAGE_TYPE imageType, long frameNumber, double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/, double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/, const igsioFieldMapType* customFields /*= NULL*/)
+{
+  bool skipItem(false);
+  if (this->PrepareVideoItemTimestamps(frameNumber, unfilteredTimestamp, filteredTimestamp, skipItem) != PLUS_SUCCESS)
+  {
     return PLUS_FAIL;
   }
+  if (skipItem)
+  {
+    return PLUS_SUCCESS;
+  }
 
-  // get the pointer to the correct location in the frame buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
-  if (newObjectInBuffer == NULL)
+  if (imageDataPtr == NULL)
   {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
+    LOG_ERROR("vtkPlusBuffer: Unable to add NULL frame to video buffer!");
+    return PLUS_FAIL;
+  }
+
+  if (frameSize[0] != this->GetFrameSize()[0] || frameSize[1] != this->GetFrameSize()[1] || frameSize[2] != this->GetFrameSize()[2])
+  {
+    LOG_ERROR("vtkPlusBuffer: Unable to add frame to video buffer - frame format doesn't match!");
     return PLUS_FAIL;
   }
 
-  FrameSizeType receivedFrameSize = { 0, 0, 0 };
-  newObjectInBuffer->GetFrame().GetFrameSize(receivedFrameSize);
+  {
+    this->SpillItemBeforeEviction();
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    StreamBufferItem* newObjectInBuffer = this->PrepareNewVideoItem(frameNumber, unfilteredTimestamp, filteredTimestamp);
+    if (newObjectInBuffer == NULL)
+    {
+      return PLUS_FAIL;
+    }
+
+    unsigned int bufferFrameSizeBytes = newObjectInBuffer->GetFrame().GetFrameSizeInBytes();
+    if (bufferFrameSizeBytes < inputFrameSizeInBytes)
+    {
+      LOCAL_LOG_ERROR("Input frame size is larger than buffer frame size (input: " << inputFrameSizeInBytes << ",   buffer: " << bufferFrameSizeBytes << ")!");
+      return PLUS_FAIL;
+    }
+
+    newObjectInBuffer->GetFrame().SetImageType(imageType);
+    newObjectInBuffer->ClearNativeFrame();
+    memcpy(newObjectInBuffer->GetFrame().GetImage()->GetScalarPointer(), imageDataPtr, inputFrameSizeInBytes);
+    this->SetCustomFields(newObjectInBuffer, customFields);
+
+    static const FrameFieldId frameSizeInBytesFieldId = FrameFieldSchema::GetFieldId("FrameSizeInBytes");
+    newObjectInBuffer->SetFrameField(frameSizeInBytesFieldId, igsioCommon::ToString<unsigned int>(inputFrameSizeInBytes));
+  }
 
-  if (imageDataPtr && !encodedFrame &&
-      (outputFrameSizeInPx[0] != receivedFrameSize[0]
-       || outputFrameSizeInPx[1] != receivedFrameSize[1]
-       || outputFrameSizeInPx[2] != receivedFrameSize[2]))
+  // Notify after the buffer is unlocked, so that the woken consumers do not have to wait for the lock
+  this->NotifyNewData();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::AddNativeItem(const void* nativeDataPtr,
+                                        unsigned int nativeDataSizeInBytes,
+                                        unsigned int nativeFourCC,
+                                        US_IMAGE_ORIENTATION usImageOrientation,
+                                        const FrameSizeType& frameSizeInPx,
+                                        US_IMAGE_TYPE imageType,
+                                        long frameNumber,
+                                        const std::array<int, 3>& clipRectangleOrigin,
+                                        const std::array<int, 3>& clipRectangleSize,
+                                        double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/,
+                                        double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/,
+                                        const igsioFieldMapType* customFields /*= NULL*/)
+{
+  if (nativeDataPtr == NULL)
   {
-    LOCAL_LOG_ERROR("Input frame size is different from buffer frame size (input: " <<
-                    outputFrameSizeInPx[0] << "x" << outputFrameSizeInPx[1] << "x" << outputFrameSizeInPx[2] <<
-                    ",   buffer: " <<
-                    receivedFrameSize[0] << "x" << receivedFrameSize[1] << "x" << receivedFrameSize[2] << ")!");
+    LOG_ERROR("vtkPlusBuffer: Unable to add NULL frame to video buffer!");
     return PLUS_FAIL;
   }
 
-  // Skip the numberOfBytesToSkip bytes, e.g. header size
-  if (imageDataPtr != NULL)
+  PixelCodec::PixelEncoding encoding = PixelCodec::GetPixelEncodingFromFourCC(nativeFourCC);
+  unsigned int bytesPerPixel = PixelCodec::GetNumberOfBytesPerPixel(encoding);
+  if (bytesPerPixel == 0)
   {
-    unsigned char* byteImageDataPtr = reinterpret_cast<unsigned char*>(imageDataPtr);
-    byteImageDataPtr += numberOfBytesToSkip;
+    LOCAL_LOG_ERROR("vtkPlusBuffer: Unable to add native frame to video buffer - unsupported pixel encoding " << PixelCodec::GetCompressionModeAsString(static_cast<int>(nativeFourCC)));
+    return PLUS_FAIL;
+  }
+  if (this->NumberOfScalarComponents != 1 && this->NumberOfScalarComponents != 3)
+  {
+    LOCAL_LOG_ERROR("vtkPlusBuffer: Unable to add native frame to video buffer - native frames can only be converted to 1 or 3 scalar components");
+    return PLUS_FAIL;
+  }
+  const unsigned int numberOfPixels = frameSizeInPx[0] * frameSizeInPx[1] * frameSizeInPx[2];
+  if (nativeDataSizeInBytes < numberOfPixels * bytesPerPixel)
+  {
+    LOCAL_LOG_ERROR("vtkPlusBuffer: Unable to add native frame to video buffer - frame data size is " << nativeDataSizeInBytes << " bytes, expected " << numberOfPixels * bytesPerPixel);
+    return PLUS_FAIL;
+  }
 
-    if (igsioVideoFrame::GetOrientedClippedImage(byteImageDataPtr, flipInfo, imageType, pixelType, numberOfScalarComponents, inputFrameSizeInPx, newObjectInBuffer->GetFrame(), clipRectangleOrigin, clipRectangleSize) != PLUS_SUCCESS)
+  igsioVideoFrame::FlipInfoType flipInfo;
+  if (igsioVideoFrame::GetFlipAxes(usImageOrientation, imageType, this->ImageOrientation, flipInfo) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to convert image data to the requested orientation, from " << igsioVideoFrame::GetStringFromUsImageOrientation(usImageOrientation) <<
+              " to " << igsioVideoFrame::GetStringFromUsImageOrientation(this->ImageOrientation));
+    return PLUS_FAIL;
+  }
+  if (flipInfo.hFlip || flipInfo.vFlip || flipInfo.eFlip || flipInfo.tranpose != igsioVideoFrame::TRANSPOSE_NONE
+      || igsioCommon::IsClippingRequested(clipRectangleOrigin, clipRectangleSize))
+  {
+    // Reorienting and clipping need decoded pixels, so the frame is converted now
+    static thread_local std::vector<unsigned char> convertedFrame;
+    convertedFrame.resize(numberOfPixels * this->NumberOfScalarComponents);
+    PlusStatus conversionStatus = (this->NumberOfScalarComponents == 1)
+                                  ? PixelCodec::ConvertToGray(encoding, frameSizeInPx[0], frameSizeInPx[1] * frameSizeInPx[2], (unsigned char*)nativeDataPtr, &convertedFrame[0])
+                                  : PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, encoding, frameSizeInPx[0], frameSizeInPx[1] * frameSizeInPx[2], (unsigned char*)nativeDataPtr, &convertedFrame[0]);
+    if (conversionStatus != PLUS_SUCCESS)
     {
-      LOCAL_LOG_ERROR("Failed to convert input US image to the requested orientation!");
+      LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to convert native frame to the pixel format of the buffer");
       return PLUS_FAIL;
     }
+    return this->AddItem(&convertedFrame[0], usImageOrientation, frameSizeInPx, VTK_UNSIGNED_CHAR, this->NumberOfScalarComponents, imageType, 0, frameNumber,
+                         clipRectangleOrigin, clipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields);
   }
-  else if (encodedFrame != NULL)
+
+  if (!this->CheckFrameFormat(frameSizeInPx, VTK_UNSIGNED_CHAR, imageType, this->NumberOfScalarComponents))
   {
-    newObjectInBuffer->GetFrame().SetEncodedFrame(encodedFrame);
+    LOG_ERROR("vtkPlusBuffer: Unable to add frame to video buffer - frame format doesn't match!");
+    return PLUS_FAIL;
   }
 
-  newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
-  newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
-  newObjectInBuffer->SetIndex(frameNumber);
-  newObjectInBuffer->SetUid(itemUid);
-  newObjectInBuffer->GetFrame().SetImageType(imageType);
+  bool skipItem(false);
+  if (this->PrepareVideoItemTimestamps(frameNumber, unfilteredTimestamp, filteredTimestamp, skipItem) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (skipItem)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  // Set before the item is added, so that readers never miss an unconverted frame
+  this->ContainsNativeFrames = true;
 
-  // Add custom fields
-  if (customFields != NULL)
   {
-    for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
+    this->SpillItemBeforeEviction();
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    StreamBufferItem* newObjectInBuffer = this->PrepareNewVideoItem(frameNumber, unfilteredTimestamp, filteredTimestamp);
+    if (newObjectInBuffer == NULL)
     {
-      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
-      std::string name(it->first);
-      if (name.find("Transform") != std::string::npos)
-      {
-        newObjectInBuffer->SetValidTransformData(true);
-      }
+      return PLUS_FAIL;
     }
+
+    newObjectInBuffer->SetNativeFrame(nativeDataPtr, numberOfPixels * bytesPerPixel, nativeFourCC);
+    newObjectInBuffer->GetFrame().SetImageType(imageType);
+    this->SetCustomFields(newObjectInBuffer, customFields);
   }
 
+  // Notify after the buffer is unlocked, so that the woken consumers do not have to wait for the lock
+  this->NotifyNewData();
   return PLUS_SUCCESS;
 }
 
 //----------------------------------------------------------------------------
-PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frameSize, unsigned int inputFrameSizeInBytes, US_IMAGE_TYPE imageType, long frameNumber, double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/, double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/, const igsioFieldMapType* customFields /*= NULL*/)
+PlusStatus vtkPlusBuffer::PrepareVideoItemTimestamps(long frameNumber, double& unfilteredTimestamp, double& filteredTimestamp, bool& skipItem)
 {
+  skipItem = false;
   if (unfilteredTimestamp == UNDEFINED_TIMESTAMP)
   {
     unfilteredTimestamp = vtkIGSIOAccurateTimer::GetSystemTime();
@@ -553,35 +1076,27 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frame
     if (!filteredTimestampProbablyValid)
     {
       LOG_INFO("Filtered timestamp is probably invalid for video buffer item with item index=" << frameNumber << ", time=" <<
-               unfilteredTimestamp << ". The item may have been tagged with an inaccurate timestamp, therefore it will not be recorded.");
-      return PLUS_SUCCESS;
-    }
-  }
-  else
-  {
-    this->StreamBuffer->AddToTimeStampReport(frameNumber, unfilteredTimestamp, filteredTimestamp);
-  }
-
-  if (imageDataPtr == NULL)
-  {
-    LOG_ERROR("vtkPlusBuffer: Unable to add NULL frame to video buffer!");
-    return PLUS_FAIL;
+               unfilteredTimestamp << ". The item may have been tagged with an inaccurate timestamp, therefore it will not be recorded.");
+      skipItem = true;
+    }
   }
-
-  if (frameSize[0] != this->GetFrameSize()[0] || frameSize[1] != this->GetFrameSize()[1] || frameSize[2] != this->GetFrameSize()[2])
+  else
   {
-    LOG_ERROR("vtkPlusBuffer: Unable to add frame to video buffer - frame format doesn't match!");
-    return PLUS_FAIL;
+    this->StreamBuffer->AddToTimeStampReport(frameNumber, unfilteredTimestamp, filteredTimestamp);
   }
+  return PLUS_SUCCESS;
+}
 
+//----------------------------------------------------------------------------
+StreamBufferItem* vtkPlusBuffer::PrepareNewVideoItem(long frameNumber, double unfilteredTimestamp, double filteredTimestamp)
+{
   int bufferIndex(0);
-  BufferItemUidType itemUid;
-  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+  BufferItemUidType itemUid(0);
+  if (this->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
   {
     // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
     LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to video buffer!");
-    return PLUS_FAIL;
+    return NULL;
   }
 
   // get the pointer to the correct location in the frame buffer, where this data needs to be copied
@@ -589,39 +1104,86 @@ PlusStatus vtkPlusBuffer::AddItem(void* imageDataPtr, const FrameSizeType& frame
   if (newObjectInBuffer == NULL)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to video buffer object from the video buffer for the new frame!");
-    return PLUS_FAIL;
-  }
-
-  unsigned int bufferFrameSizeBytes = newObjectInBuffer->GetFrame().GetFrameSizeInBytes();
-  if (bufferFrameSizeBytes < inputFrameSizeInBytes)
-  {
-    LOCAL_LOG_ERROR("Input frame size is larger than buffer frame size (input: " << inputFrameSizeInBytes << ",   buffer: " << bufferFrameSizeBytes << ")!");
-    return PLUS_FAIL;
+    return NULL;
   }
 
   newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
   newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
   newObjectInBuffer->SetIndex(frameNumber);
   newObjectInBuffer->SetUid(itemUid);
-  newObjectInBuffer->GetFrame().SetImageType(imageType);
-  memcpy(newObjectInBuffer->GetFrame().GetImage()->GetScalarPointer(), imageDataPtr, inputFrameSizeInBytes);
+  return newObjectInBuffer;
+}
 
-  // Add custom fields
-  if (customFields != NULL)
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetCustomFields(StreamBufferItem* item, const igsioFieldMapType* customFields)
+{
+  if (customFields == NULL)
   {
-    for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
+    return;
+  }
+  for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
+  {
+    item->SetFrameField(this->GetFrameFieldId(it->first), it->second.second, it->second.first);
+    if (it->first.find("Transform") != std::string::npos)
     {
-      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
-      std::string name(it->first);
-      if (name.find("Transform") != std::string::npos)
-      {
-        newObjectInBuffer->SetValidTransformData(true);
-      }
+      item->SetValidTransformData(true);
     }
   }
+}
+
+//----------------------------------------------------------------------------
+FrameFieldId vtkPlusBuffer::GetFrameFieldId(const std::string& fieldName)
+{
+  std::map<std::string, FrameFieldId>::const_iterator it = this->FrameFieldIds.find(fieldName);
+  if (it != this->FrameFieldIds.end())
+  {
+    return it->second;
+  }
+  const FrameFieldId fieldId = FrameFieldSchema::GetFieldId(fieldName);
+  if (fieldId != FrameFieldSchema::INVALID_FIELD_ID)
+  {
+    this->FrameFieldIds[fieldName] = fieldId;
+  }
+  return fieldId;
+}
+
+//----------------------------------------------------------------------------
+std::mutex& vtkPlusBuffer::GetNativeFrameConversionMutex(StreamBufferItem* item)
+{
+  return this->NativeFrameConversionMutexes[item->GetUid() % this->NativeFrameConversionMutexes.size()];
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusBuffer::ConvertNativeFrame(StreamBufferItem* item)
+{
+  std::lock_guard<std::mutex> conversionLock(this->GetNativeFrameConversionMutex(item));
+  if (!item->HasUnconvertedNativeFrame())
+  {
+    return PLUS_SUCCESS;
+  }
 
-  newObjectInBuffer->SetFrameField("FrameSizeInBytes", igsioCommon::ToString<unsigned int>(inputFrameSizeInBytes));
+  PixelCodec::PixelEncoding encoding = PixelCodec::GetPixelEncodingFromFourCC(item->GetNativeFrameFourCC());
+  igsioVideoFrame& frame = item->GetFrame();
+  FrameSizeType frameSize = { 0, 0, 0 };
+  frame.GetFrameSize(frameSize);
+  unsigned char* outputPtr = static_cast<unsigned char*>(frame.GetScalarPointer());
+  if (outputPtr == NULL)
+  {
+    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to convert native frame " << item->GetUid() << " - frame memory is not allocated");
+    return PLUS_FAIL;
+  }
 
+  PlusStatus conversionStatus = (this->NumberOfScalarComponents == 1)
+                                ? PixelCodec::ConvertToGray(encoding, frameSize[0], frameSize[1] * frameSize[2], item->GetNativeFrameData(), outputPtr)
+                                : PixelCodec::ConvertToBmp24(PixelCodec::ComponentOrder_RGB, encoding, frameSize[0], frameSize[1] * frameSize[2], item->GetNativeFrameData(), outputPtr);
+  if (conversionStatus != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to convert native frame " << item->GetUid() << " to the pixel format of the buffer");
+    return PLUS_FAIL;
+  }
+  frame.GetImage()->Modified();
+  item->SetNativeFrameConverted();
+  ++this->NumberOfNativeFrameConversions;
   return PLUS_SUCCESS;
 }
 
@@ -659,43 +1221,49 @@ PlusStatus vtkPlusBuffer::AddTimeStampedItem(vtkMatrix4x4* matrix, ToolStatus st
   int bufferIndex(0);
   BufferItemUidType itemUid;
 
-  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
-  if (this->StreamBuffer->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+  PlusStatus itemStatus(PLUS_SUCCESS);
   {
-    // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
-    LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
-    return PLUS_FAIL;
-  }
+    this->SpillItemBeforeEviction();
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->PrepareForNewItem(filteredTimestamp, itemUid, bufferIndex) != PLUS_SUCCESS)
+    {
+      // Just a debug message, because we want to avoid unnecessary warning messages if the timestamp is the same as last one
+      LOCAL_LOG_DEBUG("vtkPlusBuffer: Failed to prepare for adding new frame to tracker buffer!");
+      return PLUS_FAIL;
+    }
 
-  // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
-  StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
-  if (newObjectInBuffer == NULL)
-  {
-    LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
-    return PLUS_FAIL;
-  }
+    // get the pointer to the correct location in the tracker buffer, where this data needs to be copied
+    StreamBufferItem* newObjectInBuffer = this->StreamBuffer->GetBufferItemPointerFromBufferIndex(bufferIndex);
+    if (newObjectInBuffer == NULL)
+    {
+      LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get pointer to data buffer object from the tracker buffer for the new frame!");
+      return PLUS_FAIL;
+    }
 
-  PlusStatus itemStatus = newObjectInBuffer->SetMatrix(matrix);
-  newObjectInBuffer->SetStatus(status);
-  newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
-  newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
-  newObjectInBuffer->SetIndex(frameNumber);
-  newObjectInBuffer->SetUid(itemUid);
+    newObjectInBuffer->ClearNativeFrame();
+    itemStatus = newObjectInBuffer->SetMatrix(matrix);
+    newObjectInBuffer->SetStatus(status);
+    newObjectInBuffer->SetFilteredTimestamp(filteredTimestamp);
+    newObjectInBuffer->SetUnfilteredTimestamp(unfilteredTimestamp);
+    newObjectInBuffer->SetIndex(frameNumber);
+    newObjectInBuffer->SetUid(itemUid);
 
-  // Add custom fields
-  if (customFields != NULL)
-  {
-    for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
+    // Add custom fields
+    if (customFields != NULL)
     {
-      newObjectInBuffer->SetFrameField(it->first, it->second.second, it->second.first);
-      std::string name(it->first);
-      if (name.find("Transform") != std::string::npos)
+      for (igsioFieldMapType::const_iterator it = customFields->begin(); it != customFields->end(); ++it)
       {
-        newObjectInBuffer->SetValidTransformData(true);
+        newObjectInBuffer->SetFrameField(this->GetFrameFieldId(it->first), it->second.second, it->second.first);
+        if (it->first.find("Transform") != std::string::npos)
+        {
+          newObjectInBuffer->SetValidTransformData(true);
+        }
       }
     }
   }
 
+  // Notify after the buffer is unlocked, so that the woken consumers do not have to wait for the lock
+  this->NotifyNewData();
   return itemStatus;
 }
 
@@ -714,13 +1282,78 @@ ItemStatus vtkPlusBuffer::GetOldestTimeStamp(double& oldestTimestamp)
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetTimeStamp(BufferItemUidType uid, double& timestamp)
 {
-  return this->StreamBuffer->GetTimeStamp(uid, timestamp);
+  ItemStatus status = this->StreamBuffer->GetTimeStamp(uid, timestamp);
+  if (status != ITEM_NOT_AVAILABLE_ANYMORE || this->SpillFile == NULL)
+  {
+    return status;
+  }
+
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->SpillFile == NULL)
+  {
+    return status;
+  }
+  double localTimestamp(0);
+  status = this->SpillFile->GetTimeStamp(uid, localTimestamp);
+  if (status == ITEM_OK)
+  {
+    timestamp = localTimestamp + this->StreamBuffer->GetLocalTimeOffsetSec();
+  }
+  return status;
 }
 
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusBuffer::GetIndex(BufferItemUidType uid, unsigned long& index)
 {
-  return this->StreamBuffer->GetIndex(uid, index);
+  ItemStatus status = this->StreamBuffer->GetIndex(uid, index);
+  if (status != ITEM_NOT_AVAILABLE_ANYMORE || this->SpillFile == NULL)
+  {
+    return status;
+  }
+
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->SpillFile == NULL)
+  {
+    return status;
+  }
+  return this->SpillFile->GetIndex(uid, index);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetItemUidFromTime(double time, BufferItemUidType& uid)
+{
+  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, uid);
+  if (status != ITEM_NOT_AVAILABLE_ANYMORE || this->SpillFile == NULL)
+  {
+    return status;
+  }
+
+  // The item is not in the buffer anymore, but it may have been spilled to disk
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+  if (this->SpillFile == NULL)
+  {
+    return status;
+  }
+  const double localTimeOffsetSec = this->StreamBuffer->GetLocalTimeOffsetSec();
+  BufferItemUidType spilledUid(0);
+  status = this->SpillFile->GetItemUidFromTime(time - localTimeOffsetSec, spilledUid);
+  if (status != ITEM_OK)
+  {
+    return status;
+  }
+  uid = spilledUid;
+
+  // The requested time may be between the latest spilled item and the oldest item in the buffer
+  double spilledTimestamp(0);
+  double oldestTimestamp(0);
+  if (spilledUid == this->SpillFile->GetLatestItemUid()
+      && this->SpillFile->GetTimeStamp(spilledUid, spilledTimestamp) == ITEM_OK
+      && this->StreamBuffer->GetOldestTimeStamp(oldestTimestamp) == ITEM_OK
+      && oldestTimestamp - time < time - (spilledTimestamp + localTimeOffsetSec))
+  {
+    uid = this->StreamBuffer->GetOldestItemUidInBuffer();
+  }
+  return ITEM_OK;
 }
 
 
@@ -742,6 +1375,30 @@ int vtkPlusBuffer::GetAveragedItemsForFiltering()
   return this->StreamBuffer->GetAveragedItemsForFiltering();
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetIncrementalTimestampFiltering(bool enable)
+{
+  this->StreamBuffer->SetIncrementalTimestampFiltering(enable);
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetIncrementalTimestampFiltering()
+{
+  return this->StreamBuffer->GetIncrementalTimestampFiltering();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusBuffer::SetTimestampFilteringOutlierThresholdSec(double thresholdSec)
+{
+  this->StreamBuffer->SetTimestampFilteringOutlierThresholdSec(thresholdSec);
+}
+
+//----------------------------------------------------------------------------
+double vtkPlusBuffer::GetTimestampFilteringOutlierThresholdSec()
+{
+  return this->StreamBuffer->GetTimestampFilteringOutlierThresholdSec();
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::SetStartTime(double startTime)
 {
@@ -769,8 +1426,29 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBuffe
     return ITEM_UNKNOWN_ERROR;
   }
 
+  if (this->ContainsNativeFrames)
+  {
+    // Convert the frame while it is only pinned, so that the conversion does not block adding new items
+    StreamBufferItemView view;
+    if (view.Pin(this->StreamBuffer, uid) == ITEM_OK)
+    {
+      this->ConvertNativeFrame(view.GetItem());
+    }
+  }
+
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
 
+  if (this->SpillFile != NULL && uid < this->StreamBuffer->GetOldestItemUidInBuffer() && this->SpillFile->ContainsItem(uid))
+  {
+    // The item is not in the buffer anymore, but it has been spilled to disk
+    ItemStatus spilledItemStatus = this->SpillFile->ReadItem(uid, bufferItem);
+    if (spilledItemStatus == ITEM_OK && bufferItem->HasUnconvertedNativeFrame() && this->ConvertNativeFrame(bufferItem) != PLUS_SUCCESS)
+    {
+      return ITEM_UNKNOWN_ERROR;
+    }
+    return spilledItemStatus;
+  }
+
   StreamBufferItem* dataItem = NULL;
   ItemStatus itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, dataItem);
   if (itemStatus != ITEM_OK)
@@ -779,6 +1457,11 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBuffe
     return itemStatus;
   }
 
+  if (this->ContainsNativeFrames && this->ConvertNativeFrame(dataItem) != PLUS_SUCCESS)
+  {
+    return ITEM_UNKNOWN_ERROR;
+  }
+
   if (bufferItem->DeepCopy(dataItem) != PLUS_SUCCESS)
   {
     LOCAL_LOG_WARNING("Failed to copy data item");
@@ -788,6 +1471,51 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItem(BufferItemUidType uid, StreamBuffe
   return ITEM_OK;
 }
 
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& view)
+{
+  ItemStatus itemStatus = view.Pin(this->StreamBuffer, uid);
+  if (itemStatus != ITEM_OK)
+  {
+    LOCAL_LOG_WARNING("Failed to retrieve data item");
+    return itemStatus;
+  }
+  if (this->ContainsNativeFrames && this->ConvertNativeFrame(view.GetItem()) != PLUS_SUCCESS)
+  {
+    view.Release();
+    return ITEM_UNKNOWN_ERROR;
+  }
+  return itemStatus;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::GetStreamBufferItemViewFromTime(double time, StreamBufferItemView& view)
+{
+  // The item must not be removed between the time lookup and pinning
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+
+  BufferItemUidType itemUid(0);
+  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, itemUid);
+  if (status != ITEM_OK)
+  {
+    switch (status)
+    {
+      case ITEM_NOT_AVAILABLE_YET:
+        LOCAL_LOG_WARNING("vtkPlusBuffer: Cannot get any item from the buffer for time: " << std::fixed << time << ". Item is not available yet.");
+        break;
+      case ITEM_NOT_AVAILABLE_ANYMORE:
+        LOCAL_LOG_WARNING("vtkPlusBuffer: Cannot get any item from the buffer for time: " << std::fixed << time << ". Item is not available anymore.");
+        break;
+      default:
+        break;
+    }
+    view.Release();
+    return status;
+  }
+
+  return this->GetStreamBufferItemView(itemUid, view);
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::DeepCopy(vtkPlusBuffer* buffer)
 {
@@ -803,12 +1531,30 @@ void vtkPlusBuffer::DeepCopy(vtkPlusBuffer* buffer)
   this->SetNumberOfScalarComponents(buffer->GetNumberOfScalarComponents());
   this->SetImageOrientation(buffer->GetImageOrientation());
   this->SetBufferSize(buffer->GetBufferSize());
+  this->SetFrameMemoryHugePages(buffer->GetFrameMemoryHugePages());
+  this->SetContiguousFrameMemory(buffer->GetContiguousFrameMemory());
+  this->SetSpillDirectory(buffer->GetSpillDirectory());
+  this->SetSpillSegmentSizeMB(buffer->GetSpillSegmentSizeMB());
+  this->SetSpillMaxSizeMB(buffer->GetSpillMaxSizeMB());
+  this->SetSpillToDisk(buffer->GetSpillToDisk());
+  this->ContainsNativeFrames = buffer->ContainsNativeFrames.load();
 }
 
 //----------------------------------------------------------------------------
 void vtkPlusBuffer::Clear()
 {
+  this->StopSpillThread();
   this->StreamBuffer->Clear();
+
+  {
+    igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
+    if (this->SpillFile != NULL)
+    {
+      // Start new spill files
+      this->OpenSpillFile();
+    }
+  }
+  this->StartSpillThread();
 }
 
 //----------------------------------------------------------------------------
@@ -1120,10 +1866,10 @@ PlusStatus vtkPlusBuffer::WriteToSequenceFile(const char* filename, bool useComp
     trackedFrame->SetFrameField("FrameNumber", frameNumberFieldValue.str());
 
     // Add custom fields
-    const igsioFieldMapType& customFields = bufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator cf = customFields.begin(); cf != customFields.end(); ++cf)
+    const StreamBufferItem::FrameFieldContainer& customFields = bufferItem.GetFrameFields();
+    for (StreamBufferItem::FrameFieldContainer::const_iterator cf = customFields.begin(); cf != customFields.end(); ++cf)
     {
-      trackedFrame->SetFrameField(cf->first, cf->second.second, cf->second.first);
+      trackedFrame->SetFrameField(FrameFieldSchema::GetFieldName(cf->Id), cf->Value, cf->Flags);
     }
 
     // Add tracked frame to the list
@@ -1152,6 +1898,61 @@ bool vtkPlusBuffer::GetTimeStampReporting()
   return this->StreamBuffer->GetTimeStampReporting();
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusBuffer::AddNewDataNotifier(vtkPlusNewDataNotifier* notifier)
+{
+  if (notifier == NULL)
+  {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(this->NewDataNotifiersMutex);
+  if (std::find(this->NewDataNotifiers.begin(), this->NewDataNotifiers.end(), notifier) == this->NewDataNotifiers.end())
+  {
+    this->NewDataNotifiers.push_back(notifier);
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBuffer::RemoveNewDataNotifier(vtkPlusNewDataNotifier* notifier)
+{
+  std::lock_guard<std::mutex> lock(this->NewDataNotifiersMutex);
+  this->NewDataNotifiers.erase(std::remove(this->NewDataNotifiers.begin(), this->NewDataNotifiers.end(), notifier), this->NewDataNotifiers.end());
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBuffer::NotifyNewData()
+{
+  std::lock_guard<std::mutex> lock(this->NewDataNotifiersMutex);
+  for (std::vector< vtkSmartPointer<vtkPlusNewDataNotifier> >::iterator it = this->NewDataNotifiers.begin(); it != this->NewDataNotifiers.end(); ++it)
+  {
+    (*it)->Notify();
+  }
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBuffer::SetLockFreeReading(bool enable)
+{
+  this->StreamBuffer->SetLockFreeReading(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetLockFreeReading()
+{
+  return this->StreamBuffer->GetLockFreeReading();
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusBuffer::SetInterpolationSearch(bool enable)
+{
+  this->StreamBuffer->SetInterpolationSearch(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusBuffer::GetInterpolationSearch()
+{
+  return this->StreamBuffer->GetInterpolationSearch();
+}
+
 //----------------------------------------------------------------------------
 // Returns the two buffer items that are closest previous and next buffer items relative to the specified time.
 // itemA is the closest item
@@ -1168,7 +1969,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
 
   // itemA is the item that is the closest to the requested time, get its UID and time
   BufferItemUidType itemAuid(0);
-  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, itemAuid);
+  ItemStatus status = this->GetItemUidFromTime(time, itemAuid);
   if (status != ITEM_OK)
   {
     switch (status)
@@ -1200,7 +2001,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   }
 
   double itemAtime(0);
-  status = this->StreamBuffer->GetTimeStamp(itemAuid, itemAtime);
+  status = this->GetTimeStamp(itemAuid, itemAtime);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemAuid << ")");
@@ -1234,7 +2035,8 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
     // itemAtime < time <itemBtime
     itemBuid = itemAuid + 1;
   }
-  if (itemBuid < this->GetOldestItemUidInBuffer() || itemBuid > this->GetLatestItemUidInBuffer())
+  const bool itemBspilled = (this->SpillFile != NULL && this->SpillFile->ContainsItem(itemBuid));
+  if ((itemBuid < this->GetOldestItemUidInBuffer() && !itemBspilled) || itemBuid > this->GetLatestItemUidInBuffer())
   {
     // itemB is not available
     LOCAL_LOG_ERROR("vtkPlusBuffer: Cannot perform interpolation, itemB is not available " << std::fixed << " ( itemBuid: " << itemBuid << ", oldest UID: " << this->GetOldestItemUidInBuffer() << ", latest UID: " << this->GetLatestItemUidInBuffer());
@@ -1242,7 +2044,7 @@ PlusStatus vtkPlusBuffer::GetPrevNextBufferItemFromTime(double time, StreamBuffe
   }
   // Get item B details
   double itemBtime(0);
-  status = this->StreamBuffer->GetTimeStamp(itemBuid, itemBtime);
+  status = this->GetTimeStamp(itemBuid, itemBtime);
   if (status != ITEM_OK)
   {
     LOCAL_LOG_ERROR("Cannot do interpolation: Failed to get data buffer timestamp with Uid: " << itemBuid);
@@ -1291,11 +2093,12 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromTime(double time, StreamBufferI
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusBuffer::ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value)
 {
+  igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
   StreamBufferItem* item;
   auto itemStatus = this->StreamBuffer->GetBufferItemPointerFromUid(uid, item);
   if (itemStatus == ITEM_OK)
   {
-    item->SetFrameField(key, value);
+    item->SetFrameField(this->GetFrameFieldId(key), value);
   }
   return itemStatus == ITEM_OK ? PLUS_SUCCESS : PLUS_FAIL;
 }
@@ -1327,7 +2130,7 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromClosestTime(double time, Stream
   igsioLockGuard<StreamItemCircularBuffer> dataBufferGuardedLock(this->StreamBuffer);
 
   BufferItemUidType itemUid(0);
-  ItemStatus status = this->StreamBuffer->GetItemUidFromTime(time, itemUid);
+  ItemStatus status = this->GetItemUidFromTime(time, itemUid);
   if (status != ITEM_OK)
   {
     switch (status)
@@ -1362,8 +2165,29 @@ ItemStatus vtkPlusBuffer::GetStreamBufferItemFromClosestTime(double time, Stream
 // The flags correspond to the closest element.
 ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem)
 {
-  StreamBufferItem itemA;
-  StreamBufferItem itemB;
+  // The interpolator keeps its memory between calls, so no allocation is needed for interpolating a pose
+  static thread_local PoseInterpolator interpolator;
+  interpolator.Clear();
+
+  int poseIndex(-1);
+  ItemStatus status = this->PrepareInterpolatedStreamBufferItemFromTime(time, bufferItem, interpolator, poseIndex);
+  if (status != ITEM_OK || poseIndex < 0)
+  {
+    return status;
+  }
+
+  interpolator.Interpolate();
+  return this->CompleteInterpolatedStreamBufferItem(bufferItem, interpolator, poseIndex);
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::PrepareInterpolatedStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, PoseInterpolator& interpolator, int& poseIndex)
+{
+  poseIndex = -1;
+
+  // The neighbor items are reused between calls, so their matrices are not allocated for each interpolation
+  static thread_local StreamBufferItem itemA;
+  static thread_local StreamBufferItem itemB;
 
   if (GetPrevNextBufferItemFromTime(time, itemA, itemB) != PLUS_SUCCESS)
   {
@@ -1392,14 +2216,14 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
   //============== Get item weights ==================
 
   double itemAtime(0);
-  if (this->StreamBuffer->GetTimeStamp(itemA.GetUid(), itemAtime) != ITEM_OK)
+  if (this->GetTimeStamp(itemA.GetUid(), itemAtime) != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemA.GetUid() << ")");
     return ITEM_UNKNOWN_ERROR;
   }
 
   double itemBtime(0);
-  if (this->StreamBuffer->GetTimeStamp(itemB.GetUid(), itemBtime) != ITEM_OK)
+  if (this->GetTimeStamp(itemB.GetUid(), itemBtime) != ITEM_OK)
   {
     LOCAL_LOG_ERROR("vtkPlusBuffer: Failed to get data buffer timestamp (time: " << std::fixed << time << ", uid: " << itemB.GetUid() << ")");
     return ITEM_UNKNOWN_ERROR;
@@ -1419,57 +2243,22 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
 
   //============== Get transform matrices ==================
 
-  vtkSmartPointer<vtkMatrix4x4> itemAmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  if (itemA.GetMatrix(itemAmatrix) != PLUS_SUCCESS)
+  double matrixA[16] = {0};
+  if (itemA.GetMatrix(matrixA) != PLUS_SUCCESS)
   {
     LOCAL_LOG_ERROR("Failed to get item A matrix");
     return ITEM_UNKNOWN_ERROR;
   }
-  double matrixA[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  double xyzA[3] = {0, 0, 0};
-  for (int i = 0; i < 3; i++)
-  {
-    matrixA[i][0] = itemAmatrix->GetElement(i, 0);
-    matrixA[i][1] = itemAmatrix->GetElement(i, 1);
-    matrixA[i][2] = itemAmatrix->GetElement(i, 2);
-    xyzA[i] = itemAmatrix->GetElement(i, 3);
-  }
 
-  vtkSmartPointer<vtkMatrix4x4> itemBmatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  if (itemB.GetMatrix(itemBmatrix) != PLUS_SUCCESS)
+  double matrixB[16] = {0};
+  if (itemB.GetMatrix(matrixB) != PLUS_SUCCESS)
   {
     LOCAL_LOG_ERROR("Failed to get item B matrix");
     return ITEM_UNKNOWN_ERROR;
   }
-  double matrixB[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  double xyzB[3] = {0, 0, 0};
-  for (int i = 0; i < 3; i++)
-  {
-    matrixB[i][0] = itemBmatrix->GetElement(i, 0);
-    matrixB[i][1] = itemBmatrix->GetElement(i, 1);
-    matrixB[i][2] = itemBmatrix->GetElement(i, 2);
-    xyzB[i] = itemBmatrix->GetElement(i, 3);
-  }
-
-  //============== Interpolate rotation ==================
 
-  double matrixAquat[4] = {0, 0, 0, 0};
-  vtkMath::Matrix3x3ToQuaternion(matrixA, matrixAquat);
-  double matrixBquat[4] = {0, 0, 0, 0};
-  vtkMath::Matrix3x3ToQuaternion(matrixB, matrixBquat);
-  double interpolatedRotationQuat[4] = {0, 0, 0, 0};
-  igsioMath::Slerp(interpolatedRotationQuat, itemBweight, matrixAquat, matrixBquat);
-  double interpolatedRotation[3][3] = {{0, 0, 0}, {0, 0, 0}, {0, 0, 0}};
-  vtkMath::QuaternionToMatrix3x3(interpolatedRotationQuat, interpolatedRotation);
-
-  vtkSmartPointer<vtkMatrix4x4> interpolatedMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
-  for (int i = 0; i < 3; i++)
-  {
-    interpolatedMatrix->Element[i][0] = interpolatedRotation[i][0];
-    interpolatedMatrix->Element[i][1] = interpolatedRotation[i][1];
-    interpolatedMatrix->Element[i][2] = interpolatedRotation[i][2];
-    interpolatedMatrix->Element[i][3] = xyzA[i] * itemAweight + xyzB[i] * itemBweight;
-  }
+  // The rotation is interpolated with SLERP and the position linearly when the interpolator processes the batch
+  poseIndex = interpolator.AddPosePair(matrixA, matrixB, itemBweight);
 
   //============== Interpolate time ==================
 
@@ -1480,12 +2269,32 @@ ItemStatus vtkPlusBuffer::GetInterpolatedStreamBufferItemFromTime(double time, S
   //============== Write interpolated results into the bufferItem ==================
 
   bufferItem->DeepCopy(&itemA);
-  bufferItem->SetMatrix(interpolatedMatrix);
   bufferItem->SetFilteredTimestamp(time - this->StreamBuffer->GetLocalTimeOffsetSec());   // global = local + offset => local = global - offset
   bufferItem->SetUnfilteredTimestamp(interpolatedUnfilteredTimestamp);
 
-  double angleDiffA = igsioMath::GetOrientationDifference(interpolatedMatrix, itemAmatrix);
-  double angleDiffB = igsioMath::GetOrientationDifference(interpolatedMatrix, itemBmatrix);
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusBuffer::CompleteInterpolatedStreamBufferItem(StreamBufferItem* bufferItem, const PoseInterpolator& interpolator, int poseIndex)
+{
+  if (poseIndex < 0)
+  {
+    // The item did not need interpolation
+    return ITEM_OK;
+  }
+  if (poseIndex >= interpolator.GetNumberOfPoses())
+  {
+    LOCAL_LOG_ERROR("Invalid interpolated pose index: " << poseIndex);
+    return ITEM_UNKNOWN_ERROR;
+  }
+
+  double interpolatedMatrix[16] = {0};
+  interpolator.GetInterpolatedMatrix(poseIndex, interpolatedMatrix);
+  bufferItem->SetMatrix(interpolatedMatrix);
+
+  double angleDiffA = interpolator.GetOrientationDifferenceFromA(poseIndex);
+  double angleDiffB = interpolator.GetOrientationDifferenceFromB(poseIndex);
   if (fabs(angleDiffA) > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG && fabs(angleDiffB) > ANGLE_INTERPOLATION_WARNING_THRESHOLD_DEG)
   {
     static vtkIGSIOLogHelper helper(5.f, 5000, vtkPlusLogger::LOG_LEVEL_WARNING);
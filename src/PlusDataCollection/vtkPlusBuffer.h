@@ -19,6 +19,8 @@ See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
 #include "PlusConfigure.h"
 #include "vtkPlusDataCollectionExport.h"
 #include "PlusStreamBufferItem.h"
+#include "PlusStreamBufferItemView.h"
+#include "vtkPlusNewDataNotifier.h"
 #include "vtkPlusTimestampedCircularBuffer.h"
 
 //#include "igsioTrackedFrame.h"
@@ -26,6 +28,17 @@ See Copyright.txt or http://www.kitware.com/Copyright.htm for details.
 // VTK includes
 #include <vtkObject.h>
 
+// STL includes
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class BufferSpillFile;
+class FrameMemorySlab;
+class PoseInterpolator;
 class vtkPlusDevice;
 enum ToolStatus;
 
@@ -144,6 +157,28 @@ public:
                              double unfilteredTimestamp = UNDEFINED_TIMESTAMP,
                              double filteredTimestamp = UNDEFINED_TIMESTAMP);
 
+  /*!
+    Add a frame in the native pixel encoding of the device (identified by a FourCC code, see PixelCodec::GetFourCC).
+    The frame is stored as is and it is converted to the pixel format of the buffer when it is read first,
+    therefore the conversion cost is not paid in the acquisition thread and frames that are never read are not converted.
+    Frames that have to be reoriented or clipped are converted immediately.
+    If the timestamp is less than or equal to the previous timestamp,
+    or if the frame's format doesn't match the buffer's frame format,
+    then the frame is not added to the buffer.
+  */
+  virtual PlusStatus AddNativeItem(const void* nativeDataPtr,
+                                   unsigned int nativeDataSizeInBytes,
+                                   unsigned int nativeFourCC,
+                                   US_IMAGE_ORIENTATION usImageOrientation,
+                                   const FrameSizeType& frameSizeInPx,
+                                   US_IMAGE_TYPE imageType,
+                                   long frameNumber,
+                                   const std::array<int, 3>& clipRectangleOrigin,
+                                   const std::array<int, 3>& clipRectangleSize,
+                                   double unfilteredTimestamp = UNDEFINED_TIMESTAMP,
+                                   double filteredTimestamp = UNDEFINED_TIMESTAMP,
+                                   const igsioFieldMapType* customFields = NULL);
+
   /*!
     Add a matrix plus status to the list, with an exactly known timestamp value (e.g., provided by a high-precision hardware timer).
     If the timestamp is less than or equal to the previous timestamp, then nothing  will be done.
@@ -165,6 +200,32 @@ public:
   };
   /*! Get a frame that was acquired at the specified time from buffer */
   virtual ItemStatus GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, DataItemTemporalInterpolationType interpolation);
+
+  /*!
+    Get the item at the specified time with INTERPOLATED interpolation, without computing the interpolated pose.
+    This allows interpolating the poses of many tools in one batch.
+    If the pose has to be interpolated between two items then the two poses are added to the interpolator and poseIndex
+    is set to the index of the pose, otherwise poseIndex is set to -1 and the item is already complete.
+    After the poses are interpolated, CompleteInterpolatedStreamBufferItem sets the interpolated pose in the item.
+  */
+  virtual ItemStatus PrepareInterpolatedStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, PoseInterpolator& interpolator, int& poseIndex);
+
+  /*! Set the interpolated pose in an item that was prepared by PrepareInterpolatedStreamBufferItemFromTime */
+  virtual ItemStatus CompleteInterpolatedStreamBufferItem(StreamBufferItem* bufferItem, const PoseInterpolator& interpolator, int poseIndex);
+
+  /*!
+    Get a zero-copy view of the frame with the specified frame uid.
+    The buffer slot of the frame is not reused until the view is released.
+  */
+  virtual ItemStatus GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& view);
+  /*! Get a zero-copy view of the most recent frame */
+  virtual ItemStatus GetLatestStreamBufferItemView(StreamBufferItemView& view)
+  {
+    return this->GetStreamBufferItemView(this->GetLatestItemUidInBuffer(), view);
+  };
+  /*! Get a zero-copy view of the frame that was acquired closest to the specified time */
+  virtual ItemStatus GetStreamBufferItemViewFromTime(double time, StreamBufferItemView& view);
+
   virtual PlusStatus ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value);
 
   /*! Get latest timestamp in the buffer */
@@ -203,10 +264,8 @@ public:
   {
     return this->StreamBuffer->GetLatestItemUidInBuffer();
   }
-  virtual ItemStatus GetItemUidFromTime(double time, BufferItemUidType& uid)
-  {
-    return this->StreamBuffer->GetItemUidFromTime(time, uid);
-  }
+  /*! Get the UID of the item that is the closest to the specified time. Items that are spilled to disk are also considered. */
+  virtual ItemStatus GetItemUidFromTime(double time, BufferItemUidType& uid);
 
   /*! Set the local time offset in seconds (global = local + offset) */
   virtual void SetLocalTimeOffsetSec(double offsetSec);
@@ -258,6 +317,16 @@ public:
 
   virtual int GetAveragedItemsForFiltering();
 
+  /*! If IncrementalTimestampFiltering is enabled (default) then the timestamp filtering line is updated in constant time for each new item. */
+  void SetIncrementalTimestampFiltering(bool enable);
+  /*! If IncrementalTimestampFiltering is enabled (default) then the timestamp filtering line is updated in constant time for each new item. */
+  bool GetIncrementalTimestampFiltering();
+
+  /*! Items that are farther from the timestamp filtering line than this threshold (in seconds) are not used for fitting. 0 disables outlier rejection (default). */
+  void SetTimestampFilteringOutlierThresholdSec(double thresholdSec);
+  /*! Items that are farther from the timestamp filtering line than this threshold (in seconds) are not used for fitting. 0 disables outlier rejection (default). */
+  double GetTimestampFilteringOutlierThresholdSec();
+
   /*! Set recording start time */
   virtual void SetStartTime(double startTime);
   /*! Get recording start time */
@@ -271,6 +340,24 @@ public:
   /*! If TimeStampReporting is enabled then all filtered and unfiltered timestamp values will be saved in a table for diagnostic purposes. */
   bool GetTimeStampReporting();
 
+  /*!
+    Register a notifier that is notified each time a new item is added to the buffer.
+    The buffer keeps a reference to the notifier until it is removed.
+  */
+  void AddNewDataNotifier(vtkPlusNewDataNotifier* notifier);
+  /*! Unregister a notifier that was registered by AddNewDataNotifier */
+  void RemoveNewDataNotifier(vtkPlusNewDataNotifier* notifier);
+
+  /*! If LockFreeReading is enabled (default) then UID and timestamp queries do not lock the buffer. */
+  void SetLockFreeReading(bool enable);
+  /*! If LockFreeReading is enabled (default) then UID and timestamp queries do not lock the buffer. */
+  bool GetLockFreeReading();
+
+  /*! If InterpolationSearch is enabled (default) then item UIDs are found from timestamps by interpolation search instead of bisection. */
+  void SetInterpolationSearch(bool enable);
+  /*! If InterpolationSearch is enabled (default) then item UIDs are found from timestamps by interpolation search instead of bisection. */
+  bool GetInterpolationSearch();
+
   /*! Set the frame size in pixel  */
   PlusStatus SetFrameSize(unsigned int x, unsigned int y, unsigned int z, bool allocateFrames = true);
   /*! Set the frame size in pixel  */
@@ -299,6 +386,52 @@ public:
   /*! Get the image orientation (MF, MN, ...) */
   vtkGetMacro(ImageOrientation, US_IMAGE_ORIENTATION);
 
+  /*!
+    If ContiguousFrameMemory is enabled then the pixel data of all frames is stored in one contiguous, page-aligned
+    memory block, which is written once at allocation time, so that no page faults occur during acquisition.
+    The image data of the buffer items must not be shallow-copied to objects that outlive the buffer.
+  */
+  PlusStatus SetContiguousFrameMemory(bool enable);
+  /*! Get if the pixel data of all frames is stored in one contiguous memory block */
+  vtkGetMacro(ContiguousFrameMemory, bool);
+
+  /*! If FrameMemoryHugePages is enabled then the frame memory slab is backed by huge pages if the operating system provides them */
+  PlusStatus SetFrameMemoryHugePages(bool enable);
+  /*! Get if the frame memory slab is requested to be backed by huge pages */
+  vtkGetMacro(FrameMemoryHugePages, bool);
+
+  /*!
+    If SpillToDisk is enabled then items that are removed from the buffer are stored in memory-mapped
+    segment files in the SpillDirectory. Spilled items can be retrieved by UID and timestamp the same way
+    as items that are still in the buffer, but item views cannot refer to them.
+    New items are copied and written to the files by a background thread soon after they are added, so the acquisition
+    thread only writes an item if it would be removed from the buffer before the background thread could store it.
+    The files are never written while the buffer is locked.
+    Native frames are stored without conversion and encoded frames are stored with their encoded data.
+    The oldest spilled items are deleted when the total size of the files exceeds SpillMaxSizeMB.
+  */
+  PlusStatus SetSpillToDisk(bool enable);
+  /*! Get if items that are removed from the buffer are stored on disk */
+  vtkGetMacro(SpillToDisk, bool);
+
+  /*! Directory of the spill files. If empty (default) then the output directory is used. Takes effect when spilling is enabled. */
+  vtkSetStdStringMacro(SpillDirectory);
+  vtkGetStdStringMacro(SpillDirectory);
+
+  /*! Size of each spill file in megabytes (default: 64). Takes effect when spilling is enabled. */
+  vtkSetMacro(SpillSegmentSizeMB, int);
+  vtkGetMacro(SpillSegmentSizeMB, int);
+
+  /*! Maximum total size of the spill files in megabytes (default: 1024). Takes effect when spilling is enabled. */
+  vtkSetMacro(SpillMaxSizeMB, int);
+  vtkGetMacro(SpillMaxSizeMB, int);
+
+  /*! Get the number of items that have been removed from the buffer and are stored on disk */
+  int GetNumberOfSpilledItems();
+
+  /*! Get the number of native frames that have been converted to the pixel format of the buffer */
+  unsigned long GetNumberOfNativeFrameConversions() const { return this->NumberOfNativeFrameConversions; }
+
   /*! Get the number of bytes per scalar component */
   int GetNumberOfBytesPerScalar();
 
@@ -324,6 +457,82 @@ protected:
   /*! Update video buffer by setting the frame format for each frame  */
   virtual PlusStatus AllocateMemoryForFrames();
 
+  /*!
+    Allocate a new frame memory slab and set the pixel data of each frame to point into it. The buffer must be locked.
+    Fails if item views refer to the frames, as their pixel data would be moved.
+  */
+  PlusStatus AllocateFrameMemorySlab();
+
+  /*!
+    Detach the frames from the frame memory slab and release the slab. The buffer must be locked.
+    Fails if item views refer to the frames, as their pixel data would be freed.
+  */
+  PlusStatus ReleaseFrameMemorySlab();
+
+  /*!
+    Reserve a slot in the circular buffer for a new item. The item that is removed from the buffer must have been
+    spilled to disk by SpillItemBeforeEviction. The buffer must be locked.
+  */
+  PlusStatus PrepareForNewItem(double filteredTimestamp, BufferItemUidType& itemUid, int& bufferIndex);
+
+  /*!
+    Complete the timestamps of a new video item. The current time is used if the unfiltered timestamp is undefined,
+    and the filtered timestamp is computed if it is undefined.
+    \param skipItem Set to true if the filtered timestamp is probably invalid, the item must not be added then
+  */
+  PlusStatus PrepareVideoItemTimestamps(long frameNumber, double& unfilteredTimestamp, double& filteredTimestamp, bool& skipItem);
+
+  /*!
+    Reserve a slot for a new video item and set its timestamps, index and UID. The buffer must be locked.
+    Returns NULL if the item cannot be added.
+  */
+  StreamBufferItem* PrepareNewVideoItem(long frameNumber, double unfilteredTimestamp, double filteredTimestamp);
+
+  /*! Set the custom fields of a new item. Items with transform fields are marked as containing valid transform data. The buffer must be locked. */
+  void SetCustomFields(StreamBufferItem* item, const igsioFieldMapType* customFields);
+
+  /*! Get the ID of a frame field name from the IDs that this buffer has already resolved. The buffer must be locked. */
+  FrameFieldId GetFrameFieldId(const std::string& fieldName);
+
+  /*! Create the spill files for the current spill settings. The buffer must be locked and the spill thread must be stopped. */
+  PlusStatus OpenSpillFile();
+
+  /*!
+    Copy the oldest item that is not stored in the spill file yet. If evictedItemOnly is true then the item is only copied if
+    it is removed from the buffer when the next item is added. Returns PLUS_FAIL if there is no such item. The buffer must be locked.
+  */
+  PlusStatus CopyUnspilledItem(bool evictedItemOnly, StreamBufferItem& itemCopy);
+
+  /*!
+    Store a copy of an item in the spill file. The buffer must not be locked, so the acquisition is not blocked while writing.
+    If storing fails then no more items are spilled, the already spilled items remain available.
+  */
+  PlusStatus AppendToSpillFile(StreamBufferItem& itemCopy);
+
+  /*!
+    Store the item that the next added item replaces, if the spill thread has not stored it yet. Called by the adding
+    thread before it locks the buffer, so an item is never removed from the buffer before it is spilled and the file
+    is not written while the buffer is locked.
+  */
+  void SpillItemBeforeEviction();
+
+  /*! Start the thread that writes the new items to the spill file, if spilling is enabled. The buffer must not be locked. */
+  void StartSpillThread();
+  /*! Stop the spill thread. The buffer must not be locked, as the spill thread locks it. */
+  void StopSpillThread();
+  /*! Write the new items to the spill file until the thread is requested to stop */
+  void SpillThreadMain();
+
+  /*!
+    Convert the native frame of an item to the pixel format of the buffer, if it has not been converted yet.
+    The item must be locked or pinned, so that it is not overwritten during the conversion.
+    Different items are converted in parallel, concurrent requests for the same item convert it only once.
+  */
+  PlusStatus ConvertNativeFrame(StreamBufferItem* item);
+
+  /*! Get the mutex that serializes the conversion of the native frame of an item */
+  std::mutex& GetNativeFrameConversionMutex(StreamBufferItem* item);
+
   /*!
     Compares frame format with new frame imaging parameters.
     \return true if current buffer frame format matches the method arguments, otherwise false
@@ -346,6 +555,9 @@ protected:
   /*! Get tracker buffer item from the closest timestamp */
   virtual ItemStatus GetStreamBufferItemFromClosestTime(double time, StreamBufferItem* bufferItem);
 
+  /*! Notify all registered notifiers that a new item has been added */
+  void NotifyNewData();
+
 protected:
   /*! Image frame size in pixel */
   FrameSizeType FrameSize;
@@ -371,6 +583,47 @@ protected:
 
   char* DescriptiveName;
 
+  /*! Store the pixel data of all frames in one contiguous memory block */
+  bool ContiguousFrameMemory;
+  /*! Request huge pages for the frame memory slab */
+  bool FrameMemoryHugePages;
+  /*! Memory block that stores the pixel data of all frames, NULL if ContiguousFrameMemory is disabled */
+  FrameMemorySlab* FrameSlab;
+
+  /*! Store items that are removed from the buffer on disk */
+  bool SpillToDisk;
+  std::string SpillDirectory;
+  int SpillSegmentSizeMB;
+  int SpillMaxSizeMB;
+  /*!
+    IDs of the frame field names that have been added to the items of this buffer. Devices add the same fields
+    to every item, so the shared FrameFieldSchema table is only locked for new names. Guarded by the buffer lock.
+  */
+  std::map<std::string, FrameFieldId> FrameFieldIds;
+
+  /*! Items that are removed from the buffer, NULL if SpillToDisk is disabled */
+  BufferSpillFile* SpillFile;
+  /*! Set if an item could not be stored, no more items are spilled until spilling is enabled again */
+  std::atomic<bool> SpillFailed;
+  /*! Writes the new items to the spill file, so that the acquisition thread does not have to */
+  std::thread SpillThread;
+  std::atomic<bool> SpillThreadStopRequested;
+  /*! Wakes up the spill thread when a new item is added */
+  vtkSmartPointer<vtkPlusNewDataNotifier> SpillNotifier;
+
+  /*! True if native frames have been added to the buffer, which may have to be converted on read */
+  std::atomic<bool> ContainsNativeFrames;
+  /*!
+    Serialize the conversion of native frames, so that an item is converted only once.
+    Items are assigned to the mutexes by UID, so that neighboring items can be converted in parallel.
+  */
+  std::array<std::mutex, 16> NativeFrameConversionMutexes;
+  std::atomic<unsigned long> NumberOfNativeFrameConversions;
+
+  /*! Notifiers that are notified when a new item is added */
+  std::vector< vtkSmartPointer<vtkPlusNewDataNotifier> > NewDataNotifiers;
+  std::mutex NewDataNotifiersMutex;
+
 private:
   vtkPlusBuffer(const vtkPlusBuffer&);
   void operator=(const vtkPlusBuffer&);
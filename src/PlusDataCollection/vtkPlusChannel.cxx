@@ -7,6 +7,7 @@ See License.txt for details.
 // Local includes
 #include "PlusConfigure.h"
 #include "PlusPlotter.h"
+#include "PlusPoseInterpolator.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
@@ -19,6 +20,9 @@ See License.txt for details.
 #include <vtkObjectFactory.h>
 #include <vtkTable.h>
 
+// STL includes
+#include <cmath>
+
 //----------------------------------------------------------------------------
 
 vtkStandardNewMacro(vtkPlusChannel);
@@ -29,6 +33,24 @@ vtkStandardNewMacro(vtkPlusChannel);
 // This time should be long enough to comfortably retrieve a frame from the buffer.
 static const double SAMPLING_SKIPPING_MARGIN_SEC = 0.1;
 
+namespace
+{
+  /*! Buffer item of a tool, the pose is interpolated together with the other tools of the channel */
+  struct InterpolatedToolItem
+  {
+    InterpolatedToolItem()
+      : Tool(NULL)
+      , PoseIndex(-1)
+    {
+    }
+    vtkPlusDataSource* Tool;
+    igsioTransformName TransformName;
+    StreamBufferItem BufferItem;
+    /*! Index of the pose in the interpolator, -1 if the item did not need interpolation */
+    int PoseIndex;
+  };
+}
+
 //----------------------------------------------------------------------------
 vtkPlusChannel::vtkPlusChannel(void)
   : VideoSource(NULL)
@@ -37,6 +59,10 @@ vtkPlusChannel::vtkPlusChannel(void)
   , RfProcessor(NULL)
   , BlankImage(vtkImageData::New())
   , SaveRfProcessingParameters(false)
+  , TrackedFrameCacheSize(0)
+  , NumberOfTrackedFrameCacheHits(0)
+  , NumberOfTrackedFrameCacheMisses(0)
+  , TrackedFrameCacheMutex(vtkSmartPointer<vtkIGSIORecursiveCriticalSection>::New())
 {
   // Default size for brightness frame
   this->BrightnessFrameSize[0] = 640;
@@ -80,6 +106,8 @@ PlusStatus vtkPlusChannel::ReadConfiguration(vtkXMLDataElement* aChannelElement,
   }
   this->SetChannelId(id);
 
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, TrackedFrameCacheSize, aChannelElement);
+
   if (this->OwnerDevice == NULL)
   {
     LOG_ERROR("Channel does not know about its parent device. Unable to configure.");
@@ -427,6 +455,7 @@ PlusStatus vtkPlusChannel::Clear()
   {
     it->second->Clear();
   }
+  this->ClearTrackedFrameCache();
   return PLUS_SUCCESS;
 }
 
@@ -526,6 +555,189 @@ void vtkPlusChannel::SetVideoSource(vtkPlusDataSource* aSource)
 
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame& aTrackedFrame, bool enableImageData/*=true*/)
+{
+  return this->GetTrackedFrameAtItem(NULL, 0, timestamp, aTrackedFrame, enableImageData);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetTrackedFrameAtItem(vtkPlusDataSource* timingSource, BufferItemUidType timingItemUid, double timestamp, igsioTrackedFrame& aTrackedFrame, bool enableImageData/*=true*/)
+{
+  if (this->TrackedFrameCacheSize <= 0)
+  {
+    return this->AssembleTrackedFrame(timestamp, aTrackedFrame, enableImageData, timingSource, timingItemUid);
+  }
+
+  // The frame only depends on the buffer contents, which are identified by the latest item of each source
+  DataSourceLatestItemList latestItems;
+  bool complete = this->GetLatestItems(timestamp, latestItems);
+
+  std::shared_ptr<igsioTrackedFrame> cachedFrame;
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> cacheGuardedLock(this->TrackedFrameCacheMutex);
+    for (std::deque<TrackedFrameCacheEntry>::reverse_iterator entryIt = this->TrackedFrameCache.rbegin(); entryIt != this->TrackedFrameCache.rend(); ++entryIt)
+    {
+      if (entryIt->Timestamp == timestamp && entryIt->EnableImageData == enableImageData && this->IsTrackedFrameCacheEntryValid(*entryIt, latestItems))
+      {
+        cachedFrame = entryIt->Frame;
+        break;
+      }
+    }
+    if (cachedFrame)
+    {
+      this->NumberOfTrackedFrameCacheHits++;
+    }
+    else
+    {
+      this->NumberOfTrackedFrameCacheMisses++;
+    }
+  }
+
+  if (cachedFrame)
+  {
+    aTrackedFrame = *cachedFrame;
+    return PLUS_SUCCESS;
+  }
+
+  // The frame is assembled directly into the output, only the cache gets a copy
+  if (this->AssembleTrackedFrame(timestamp, aTrackedFrame, enableImageData, timingSource, timingItemUid) != PLUS_SUCCESS)
+  {
+    // Failed frames are not cached, the caller still gets the partially assembled frame
+    return PLUS_FAIL;
+  }
+
+  TrackedFrameCacheEntry entry;
+  entry.Timestamp = timestamp;
+  entry.EnableImageData = enableImageData;
+  entry.LatestItems.swap(latestItems);
+  entry.Complete = complete;
+  entry.Frame = std::make_shared<igsioTrackedFrame>(aTrackedFrame);
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> cacheGuardedLock(this->TrackedFrameCacheMutex);
+    this->TrackedFrameCache.push_back(entry);
+    while (this->TrackedFrameCache.size() > static_cast<size_t>(std::max(this->TrackedFrameCacheSize, 0)))
+    {
+      this->TrackedFrameCache.pop_front();
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusChannel::GetLatestItems(double timestamp, DataSourceLatestItemList& latestItems)
+{
+  latestItems.clear();
+
+  std::vector<vtkPlusDataSource*> sources;
+  if (this->HasVideoSource())
+  {
+    sources.push_back(this->VideoSource);
+  }
+  for (DataSourceContainerConstIterator it = this->GetToolsStartIterator(); it != this->GetToolsEndIterator(); ++it)
+  {
+    sources.push_back(it->second);
+  }
+  for (DataSourceContainerConstIterator it = this->GetFieldDataSourcesStartIterator(); it != this->GetFieldDataSourcesEndIterator(); ++it)
+  {
+    sources.push_back(it->second);
+  }
+
+  bool complete(true);
+  for (std::vector<vtkPlusDataSource*>::iterator sourceIt = sources.begin(); sourceIt != sources.end(); ++sourceIt)
+  {
+    DataSourceLatestItem latestItem;
+    latestItem.Source = *sourceIt;
+    latestItem.Uid = (*sourceIt)->GetLatestItemUidInBuffer();
+    latestItem.LocalTimeOffsetSec = (*sourceIt)->GetLocalTimeOffsetSec();
+    latestItem.Timestamp = UNDEFINED_TIMESTAMP;
+    if ((*sourceIt)->GetTimeStamp(latestItem.Uid, latestItem.Timestamp) != ITEM_OK || latestItem.Timestamp < timestamp)
+    {
+      // Interpolation or nearest neighbor search may use items that are not acquired yet
+      complete = false;
+    }
+    latestItems.push_back(latestItem);
+  }
+  return complete;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusChannel::IsTrackedFrameCacheEntryValid(const TrackedFrameCacheEntry& entry, const DataSourceLatestItemList& latestItems)
+{
+  if (entry.LatestItems.size() != latestItems.size())
+  {
+    return false;
+  }
+  for (size_t i = 0; i < latestItems.size(); ++i)
+  {
+    const DataSourceLatestItem& cachedItem = entry.LatestItems[i];
+    const DataSourceLatestItem& currentItem = latestItems[i];
+    if (cachedItem.Source != currentItem.Source || cachedItem.LocalTimeOffsetSec != currentItem.LocalTimeOffsetSec)
+    {
+      // The timestamps of all items change with the time offset, so the frame has to be assembled again
+      return false;
+    }
+    if (currentItem.Uid == cachedItem.Uid)
+    {
+      // UIDs restart when the buffer is cleared, the timestamp tells if it is still the same item
+      if (currentItem.Timestamp != cachedItem.Timestamp)
+      {
+        return false;
+      }
+      continue;
+    }
+    if (!entry.Complete || currentItem.Uid < cachedItem.Uid)
+    {
+      return false;
+    }
+    // Items added after the frame was assembled do not affect it, if the buffer was not cleared in the meantime
+    double cachedItemTimestamp(UNDEFINED_TIMESTAMP);
+    ItemStatus status = currentItem.Source->GetTimeStamp(cachedItem.Uid, cachedItemTimestamp);
+    if (status == ITEM_OK && cachedItemTimestamp != cachedItem.Timestamp)
+    {
+      return false;
+    }
+    if (status != ITEM_OK && status != ITEM_NOT_AVAILABLE_ANYMORE)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::SetTrackedFrameCacheSize(int cacheSize)
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> cacheGuardedLock(this->TrackedFrameCacheMutex);
+  this->TrackedFrameCacheSize = cacheSize;
+  while (this->TrackedFrameCache.size() > static_cast<size_t>(std::max(this->TrackedFrameCacheSize, 0)))
+  {
+    this->TrackedFrameCache.pop_front();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::ClearTrackedFrameCache()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> cacheGuardedLock(this->TrackedFrameCacheMutex);
+  this->TrackedFrameCache.clear();
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkPlusChannel::GetNumberOfTrackedFrameCacheHits() const
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> cacheGuardedLock(this->TrackedFrameCacheMutex);
+  return this->NumberOfTrackedFrameCacheHits;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkPlusChannel::GetNumberOfTrackedFrameCacheMisses() const
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> cacheGuardedLock(this->TrackedFrameCacheMutex);
+  return this->NumberOfTrackedFrameCacheMisses;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::AssembleTrackedFrame(double timestamp, igsioTrackedFrame& aTrackedFrame, bool enableImageData, vtkPlusDataSource* timingSource/*=NULL*/, BufferItemUidType timingItemUid/*=0*/)
 {
   int numberOfErrors(0);
   double synchronizedTimestamp(0);
@@ -539,7 +751,16 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       return PLUS_FAIL;
     }
     BufferItemUidType frameUID = 0;
-    ItemStatus status = this->VideoSource->GetItemUidFromTime(timestamp, frameUID);
+    ItemStatus status = ITEM_OK;
+    if (timingSource == this->VideoSource)
+    {
+      // The frame is already identified, no need to search it by time
+      frameUID = timingItemUid;
+    }
+    else
+    {
+      status = this->VideoSource->GetItemUidFromTime(timestamp, frameUID);
+    }
     if (status != ITEM_OK)
     {
       if (status == ITEM_NOT_AVAILABLE_ANYMORE)
@@ -560,25 +781,26 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       return PLUS_FAIL;
     }
 
-    StreamBufferItem CurrentStreamBufferItem;
-    if (this->VideoSource->GetStreamBufferItem(frameUID, &CurrentStreamBufferItem) != ITEM_OK)
+    // The view pins the buffer slot, so the frame is copied only once, directly into the tracked frame
+    StreamBufferItemView currentStreamBufferItemView;
+    if (this->VideoSource->GetStreamBufferItemView(frameUID, currentStreamBufferItemView) != ITEM_OK)
     {
       LOG_ERROR("Couldn't get video buffer item by frame UID: " << frameUID);
       return PLUS_FAIL;
     }
+    StreamBufferItem* currentStreamBufferItem = currentStreamBufferItemView.GetItem();
 
     // Copy frame
-    igsioVideoFrame frame = CurrentStreamBufferItem.GetFrame();
-    aTrackedFrame.SetImageData(frame);
+    aTrackedFrame.SetImageData(currentStreamBufferItem->GetFrame());
 
     // Copy all custom fields
-    igsioFieldMapType fieldMap = CurrentStreamBufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
+    const StreamBufferItem::FrameFieldContainer& frameFields = currentStreamBufferItem->GetFrameFields();
+    for (StreamBufferItem::FrameFieldContainer::const_iterator fieldIterator = frameFields.begin(); fieldIterator != frameFields.end(); ++fieldIterator)
     {
-      aTrackedFrame.SetFrameField((*fieldIterator).first, (*fieldIterator).second.second, fieldIterator->second.first);
+      aTrackedFrame.SetFrameField(FrameFieldSchema::GetFieldName(fieldIterator->Id), fieldIterator->Value, fieldIterator->Flags);
     }
 
-    synchronizedTimestamp = CurrentStreamBufferItem.GetTimestamp(this->VideoSource->GetLocalTimeOffsetSec());
+    synchronizedTimestamp = currentStreamBufferItemView.GetTimestamp();
   }
 
   if (synchronizedTimestamp == 0)
@@ -589,6 +811,20 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
   // Add main tool timestamp
   aTrackedFrame.SetTimestamp(synchronizedTimestamp);
 
+  // The poses of all tools are interpolated in one batch: first the buffer items are retrieved for all tools,
+  // then the poses are interpolated together, and finally the results are added to the tracked frame.
+  // The interpolator and the tool items keep their memory between calls, so no allocation is needed for
+  // interpolating the poses once the largest channel of the thread has been assembled.
+  static thread_local PoseInterpolator interpolator;
+  static thread_local std::vector<InterpolatedToolItem> toolItems;
+  static thread_local vtkSmartPointer<vtkMatrix4x4> dMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+  interpolator.Clear();
+  if (toolItems.size() < this->Tools.size())
+  {
+    toolItems.resize(this->Tools.size());
+  }
+  size_t numberOfToolItems(0);
+
   for (DataSourceContainerConstIterator it = this->GetToolsStartIterator(); it != this->GetToolsEndIterator(); ++it)
   {
     vtkPlusDataSource* aTool = it->second;
@@ -600,8 +836,19 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       continue;
     }
 
-    StreamBufferItem bufferItem;
-    ItemStatus result = aTool->GetStreamBufferItemFromTime(synchronizedTimestamp, &bufferItem, vtkPlusBuffer::INTERPOLATED);
+    InterpolatedToolItem& toolItem = toolItems[numberOfToolItems];
+    StreamBufferItem& bufferItem = toolItem.BufferItem;
+    ItemStatus result = ITEM_OK;
+    if (aTool == timingSource)
+    {
+      // The frame time is the time of this item, so it is used as is, without searching and interpolation
+      toolItem.PoseIndex = -1;
+      result = aTool->GetStreamBufferItem(timingItemUid, &bufferItem);
+    }
+    else
+    {
+      result = aTool->PrepareInterpolatedStreamBufferItemFromTime(synchronizedTimestamp, &bufferItem, interpolator, toolItem.PoseIndex);
+    }
     if (result != ITEM_OK)
     {
       double latestTimestamp(0);
@@ -623,7 +870,32 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
       continue;
     }
 
-    vtkSmartPointer<vtkMatrix4x4> dMatrix = vtkSmartPointer<vtkMatrix4x4>::New();
+    toolItem.Tool = aTool;
+    toolItem.TransformName = toolTransformName;
+    numberOfToolItems++;
+
+    synchronizedTimestamp = bufferItem.GetTimestamp(aTool->GetLocalTimeOffsetSec());
+  }
+
+  if (interpolator.GetNumberOfPoses() > 0)
+  {
+    interpolator.Interpolate();
+  }
+
+  for (size_t toolItemIndex = 0; toolItemIndex < numberOfToolItems; ++toolItemIndex)
+  {
+    InterpolatedToolItem& toolItem = toolItems[toolItemIndex];
+    vtkPlusDataSource* aTool = toolItem.Tool;
+    const igsioTransformName& toolTransformName = toolItem.TransformName;
+    StreamBufferItem& bufferItem = toolItem.BufferItem;
+
+    if (aTool->CompleteInterpolatedStreamBufferItem(&bufferItem, interpolator, toolItem.PoseIndex) != ITEM_OK)
+    {
+      LOG_ERROR("Failed to interpolate the pose of tool " << aTool->GetId());
+      numberOfErrors++;
+      continue;
+    }
+
     if (bufferItem.GetMatrix(dMatrix) != PLUS_SUCCESS)
     {
       LOG_ERROR("Failed to get matrix from buffer item for tool " << aTool->GetId());
@@ -646,22 +918,21 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
     }
 
     // Copy all custom fields
-    igsioFieldMapType fieldMap = bufferItem.GetFrameFieldMap();
-    igsioFieldMapType::iterator fieldIterator;
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
+    const StreamBufferItem::FrameFieldContainer& frameFields = bufferItem.GetFrameFields();
+    for (StreamBufferItem::FrameFieldContainer::const_iterator fieldIterator = frameFields.begin(); fieldIterator != frameFields.end(); ++fieldIterator)
     {
-      aTrackedFrame.SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
+      aTrackedFrame.SetFrameField(FrameFieldSchema::GetFieldName(fieldIterator->Id), fieldIterator->Value, fieldIterator->Flags);
     }
-
-    synchronizedTimestamp = bufferItem.GetTimestamp(aTool->GetLocalTimeOffsetSec());
   }
 
   for (DataSourceContainerConstIterator it = this->GetFieldDataSourcesStartIterator(); it != this->GetFieldDataSourcesEndIterator(); ++it)
   {
     vtkPlusDataSource* aSource = it->second;
 
-    StreamBufferItem bufferItem;
-    ItemStatus result = aSource->GetStreamBufferItemFromTime(synchronizedTimestamp, &bufferItem, vtkPlusBuffer::CLOSEST_TIME);
+    StreamBufferItemView bufferItemView;
+    ItemStatus result = (aSource == timingSource
+                         ? aSource->GetStreamBufferItemView(timingItemUid, bufferItemView)
+                         : aSource->GetStreamBufferItemViewFromTime(synchronizedTimestamp, bufferItemView));
     if (result != ITEM_OK)
     {
       double latestTimestamp(0);
@@ -684,13 +955,13 @@ PlusStatus vtkPlusChannel::GetTrackedFrame(double timestamp, igsioTrackedFrame&
     }
 
     // Copy all custom fields
-    igsioFieldMapType fieldMap = bufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
+    const StreamBufferItem::FrameFieldContainer& frameFields = bufferItemView.GetItem()->GetFrameFields();
+    for (StreamBufferItem::FrameFieldContainer::const_iterator fieldIterator = frameFields.begin(); fieldIterator != frameFields.end(); ++fieldIterator)
     {
-      aTrackedFrame.SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
+      aTrackedFrame.SetFrameField(FrameFieldSchema::GetFieldName(fieldIterator->Id), fieldIterator->Value, fieldIterator->Flags);
     }
 
-    synchronizedTimestamp = bufferItem.GetTimestamp(aSource->GetLocalTimeOffsetSec());
+    synchronizedTimestamp = bufferItemView.GetTimestamp();
   }
 
   // Copy frame timestamp
@@ -1122,6 +1393,263 @@ PlusStatus vtkPlusChannel::GetTrackedFrameListSampled(double& aTimestampOfLastFr
   return status;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusChannel::Subscribe(ReadCursor& cursor, double firstSampleTimestamp/*=UNDEFINED_TIMESTAMP*/)
+{
+  cursor.LastConsumedUids.clear();
+  cursor.LastConsumedTimestamp = UNDEFINED_TIMESTAMP;
+  cursor.NextSampleTimestamp = firstSampleTimestamp;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetFrameTimingSource(vtkPlusDataSource*& aSource)
+{
+  aSource = NULL;
+  if (this->GetVideoDataAvailable())
+  {
+    aSource = this->VideoSource;
+  }
+  else if (this->GetTrackingEnabled())
+  {
+    if (this->GetTimestampMasterTool(aSource) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to get timestamp master tool");
+      return PLUS_FAIL;
+    }
+  }
+  else if (this->GetFieldDataEnabled())
+  {
+    aSource = this->FieldDataSources.begin()->second;
+  }
+  return (aSource != NULL ? PLUS_SUCCESS : PLUS_FAIL);
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetReadableUidRange(vtkPlusDataSource* timingSource, BufferItemUidType& oldestUid, BufferItemUidType& latestUid, double& mostRecentTimestamp)
+{
+  static vtkIGSIOLogHelper logHelper(60.0, 500000);
+  CUSTOM_RETURN_WITH_FAIL_IF(this->GetMostRecentTimestamp(mostRecentTimestamp) != PLUS_SUCCESS,
+                             "Unable to get most recent timestamp!");
+
+  oldestUid = timingSource->GetOldestItemUidInBuffer();
+  latestUid = timingSource->GetLatestItemUidInBuffer();
+
+  // Items that are newer than the most recent synchronized timestamp cannot be returned yet (e.g., tracking data is not available for them yet).
+  // Usually only a few items have to be stepped back, as the sources are acquired at about the same time.
+  double timestamp(0);
+  while (latestUid >= oldestUid && timingSource->GetTimeStamp(latestUid, timestamp) == ITEM_OK && timestamp > mostRecentTimestamp)
+  {
+    --latestUid;
+  }
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetTrackedFrameList(ReadCursor& cursor, vtkIGSIOTrackedFrameList* aTrackedFrameList, int aMaxNumberOfFramesToAdd)
+{
+  if (aTrackedFrameList == NULL)
+  {
+    LOG_ERROR("Unable to get tracked frame list - output tracked frame list is NULL!");
+    return PLUS_FAIL;
+  }
+
+  // If no data is available then don't display an error just return without adding any items to the output tracked frame list
+  vtkPlusDataSource* timingSource = NULL;
+  if (this->GetFrameTimingSource(timingSource) != PLUS_SUCCESS || timingSource->GetNumberOfItems() == 0)
+  {
+    LOG_DEBUG("vtkPlusChannel::GetTrackedFrameList: no data is available, no items will be returned");
+    return PLUS_SUCCESS;
+  }
+
+  BufferItemUidType oldestUid(0);
+  BufferItemUidType latestUid(0);
+  double mostRecentTimestamp(0);
+  if (this->GetReadableUidRange(timingSource, oldestUid, latestUid, mostRecentTimestamp) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (latestUid < oldestUid)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  BufferItemUidType& lastConsumedUid = cursor.LastConsumedUids[timingSource->GetSourceId()];
+  if (lastConsumedUid == 0 || lastConsumedUid > timingSource->GetLatestItemUidInBuffer())
+  {
+    // First read from this source (or the buffer has been cleared since the last read), start from the most recent frame
+    lastConsumedUid = latestUid - 1;
+  }
+
+  BufferItemUidType firstUidToAdd = lastConsumedUid + 1;
+  if (firstUidToAdd < oldestUid)
+  {
+    LOG_WARNING("vtkPlusChannel::GetTrackedFrameList: " << oldestUid - firstUidToAdd << " frames have been removed from the buffer before they could be read. Increase the buffer size or read the frames more frequently.");
+    firstUidToAdd = oldestUid;
+  }
+  if (aMaxNumberOfFramesToAdd > 0 && latestUid >= firstUidToAdd && latestUid - firstUidToAdd + 1 > static_cast<BufferItemUidType>(aMaxNumberOfFramesToAdd))
+  {
+    // More frames are available than the maximum allowed frames to add, return the most recent ones
+    firstUidToAdd = latestUid - aMaxNumberOfFramesToAdd + 1;
+  }
+
+  for (BufferItemUidType uid = firstUidToAdd; uid <= latestUid; ++uid)
+  {
+    double timestamp(0);
+    if (timingSource->GetTimeStamp(uid, timestamp) != ITEM_OK)
+    {
+      LOG_ERROR("Unable to get timestamp from buffer by UID: " << uid);
+      return PLUS_FAIL;
+    }
+
+    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
+    if (this->GetTrackedFrameAtItem(timingSource, uid, timestamp, *trackedFrame) != PLUS_SUCCESS)
+    {
+      delete trackedFrame;
+      LOG_ERROR("Unable to get tracked frame by time: " << std::fixed << timestamp);
+      return PLUS_FAIL;
+    }
+
+    lastConsumedUid = uid;
+    cursor.LastConsumedTimestamp = trackedFrame->GetTimestamp();
+    if (aTrackedFrameList->TakeTrackedFrame(trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Unable to add tracked frame to the list!");
+      return PLUS_FAIL;
+    }
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusChannel::GetTrackedFrameListSampled(ReadCursor& cursor, vtkIGSIOTrackedFrameList* aTrackedFrameList, double aSamplingPeriodSec, double maxTimeLimitSec/*=-1*/)
+{
+  if (aTrackedFrameList == NULL)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled failed: unable to get tracked frame list. Output tracked frame list is NULL.");
+    return PLUS_FAIL;
+  }
+  if (aSamplingPeriodSec <= 0)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled failed: invalid sampling period " << aSamplingPeriodSec << " sec");
+    return PLUS_FAIL;
+  }
+
+  double startTimeSec = vtkIGSIOAccurateTimer::GetSystemTime();
+
+  vtkPlusDataSource* timingSource = NULL;
+  if (this->GetFrameTimingSource(timingSource) != PLUS_SUCCESS || timingSource->GetNumberOfItems() == 0)
+  {
+    LOG_DEBUG("vtkPlusChannel::GetTrackedFrameListSampled: no data is available, no items will be returned");
+    return PLUS_SUCCESS;
+  }
+
+  BufferItemUidType oldestUid(0);
+  BufferItemUidType latestUid(0);
+  double mostRecentTimestamp(0);
+  if (this->GetReadableUidRange(timingSource, oldestUid, latestUid, mostRecentTimestamp) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  if (latestUid < oldestUid)
+  {
+    return PLUS_SUCCESS;
+  }
+
+  double oldestTimestamp(0);
+  if (this->GetOldestTimestamp(oldestTimestamp) != PLUS_SUCCESS)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Failed to get oldest timestamp from buffer. Probably no frames have been acquired yet.");
+    return PLUS_FAIL;
+  }
+
+  if (cursor.NextSampleTimestamp == UNDEFINED_TIMESTAMP)
+  {
+    cursor.NextSampleTimestamp = mostRecentTimestamp;
+  }
+
+  BufferItemUidType& lastConsumedUid = cursor.LastConsumedUids[timingSource->GetSourceId()];
+  if (lastConsumedUid > timingSource->GetLatestItemUidInBuffer())
+  {
+    // The buffer has been cleared since the last read
+    lastConsumedUid = 0;
+  }
+
+  // Candidate is the item that is closest to the current sampling time, it only moves forward
+  BufferItemUidType candidateUid = std::max(lastConsumedUid, oldestUid);
+  if (lastConsumedUid == 0 && cursor.NextSampleTimestamp > oldestTimestamp && cursor.NextSampleTimestamp <= mostRecentTimestamp)
+  {
+    // First read from this source: find the starting position once, afterwards only UIDs are stepped
+    BufferItemUidType startUid(0);
+    if (timingSource->GetItemUidFromTime(cursor.NextSampleTimestamp, startUid) == ITEM_OK)
+    {
+      candidateUid = std::max(std::min(startUid, latestUid), oldestUid);
+    }
+  }
+  double candidateTimestamp(0);
+  if (candidateUid <= latestUid && timingSource->GetTimeStamp(candidateUid, candidateTimestamp) != ITEM_OK)
+  {
+    LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Unable to get timestamp from buffer by UID: " << candidateUid);
+    return PLUS_FAIL;
+  }
+
+  PlusStatus status = PLUS_SUCCESS;
+  for (; cursor.NextSampleTimestamp <= mostRecentTimestamp; cursor.NextSampleTimestamp += aSamplingPeriodSec)
+  {
+    // If the time that is allowed for adding of frames is expired then stop the processing now
+    if (maxTimeLimitSec > 0 && vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec > maxTimeLimitSec)
+    {
+      LOG_DEBUG("Reached maximum time that is allowed for sampling frames");
+      break;
+    }
+
+    // If the frame will be removed from the buffer really soon, then jump ahead in time (and skip some frames)
+    if (cursor.NextSampleTimestamp < oldestTimestamp + SAMPLING_SKIPPING_MARGIN_SEC)
+    {
+      double newNextSampleTimestamp = oldestTimestamp + SAMPLING_SKIPPING_MARGIN_SEC;
+      LOG_WARNING("vtkPlusChannel::GetTrackedFrameListSampled: Frames in the buffer are not available any more at time: " << std::fixed << cursor.NextSampleTimestamp << ". Skipping " << newNextSampleTimestamp - cursor.NextSampleTimestamp << " seconds from the recording to catch up. Increase the buffer size or decrease the acquisition rate to avoid this situation.");
+      cursor.NextSampleTimestamp = newNextSampleTimestamp;
+      continue;
+    }
+
+    // Step forward while the next item is closer to the sampling time
+    while (candidateUid < latestUid)
+    {
+      double nextTimestamp(0);
+      if (timingSource->GetTimeStamp(candidateUid + 1, nextTimestamp) != ITEM_OK
+          || fabs(nextTimestamp - cursor.NextSampleTimestamp) > fabs(candidateTimestamp - cursor.NextSampleTimestamp))
+      {
+        break;
+      }
+      ++candidateUid;
+      candidateTimestamp = nextTimestamp;
+    }
+    if (candidateUid > latestUid || candidateUid <= lastConsumedUid)
+    {
+      // This frame has been already added, jump to the next sampling time
+      continue;
+    }
+
+    // Get tracked frame from buffer (actually copies pixel and field data)
+    igsioTrackedFrame* trackedFrame = new igsioTrackedFrame;
+    if (this->GetTrackedFrameAtItem(timingSource, candidateUid, candidateTimestamp, *trackedFrame) != PLUS_SUCCESS)
+    {
+      LOG_WARNING("vtkPlusChannel::GetTrackedFrameListSampled: Unable retrieve frame from the devices for time: " << std::fixed << candidateTimestamp << ", probably the item is not available in the buffers anymore. Frames may be lost.");
+      delete trackedFrame;
+      continue;
+    }
+    lastConsumedUid = candidateUid;
+    cursor.LastConsumedTimestamp = trackedFrame->GetTimestamp();
+    if (aTrackedFrameList->TakeTrackedFrame(trackedFrame, vtkIGSIOTrackedFrameList::SKIP_INVALID_FRAME) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("vtkPlusChannel::GetTrackedFrameListSampled: Unable to add tracked frame to the list");
+      status = PLUS_FAIL;
+    }
+  }
+
+  return status;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusChannel::GetOldestTimestamp(double& ts)
 {
@@ -1544,6 +2072,40 @@ bool vtkPlusChannel::GetFieldDataAvailable()
   return false;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusChannel::AddNewDataNotifier(vtkPlusNewDataNotifier* notifier)
+{
+  if (this->VideoSource != NULL)
+  {
+    this->VideoSource->AddNewDataNotifier(notifier);
+  }
+  for (DataSourceContainerConstIterator it = this->GetToolsStartConstIterator(); it != this->GetToolsEndConstIterator(); ++it)
+  {
+    it->second->AddNewDataNotifier(notifier);
+  }
+  for (DataSourceContainerConstIterator it = this->GetFieldDataSourcesStartConstIterator(); it != this->GetFieldDataSourcesEndConstIterator(); ++it)
+  {
+    it->second->AddNewDataNotifier(notifier);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusChannel::RemoveNewDataNotifier(vtkPlusNewDataNotifier* notifier)
+{
+  if (this->VideoSource != NULL)
+  {
+    this->VideoSource->RemoveNewDataNotifier(notifier);
+  }
+  for (DataSourceContainerConstIterator it = this->GetToolsStartConstIterator(); it != this->GetToolsEndConstIterator(); ++it)
+  {
+    it->second->RemoveNewDataNotifier(notifier);
+  }
+  for (DataSourceContainerConstIterator it = this->GetFieldDataSourcesStartConstIterator(); it != this->GetFieldDataSourcesEndConstIterator(); ++it)
+  {
+    it->second->RemoveNewDataNotifier(notifier);
+  }
+}
+
 //----------------------------------------------------------------------------
 bool vtkPlusChannel::GetTrackingEnabled() const
 {
@@ -14,10 +14,15 @@
 #include "vtkDataObject.h"
 #include "vtkPlusRfProcessor.h"
 
+// STL includes
+#include <deque>
+#include <memory>
+
 //class igsioTrackedFrame; 
 class vtkPlusHTMLGenerator;
 class vtkPlusDataSource;
 class vtkPlusDevice;
+class vtkPlusNewDataNotifier;
 //class vtkIGSIOTrackedFrameList;
 
 typedef std::map<std::string, vtkPlusDataSource*> DataSourceContainer;
@@ -38,6 +43,29 @@ public:
   typedef CustomAttributeMap::iterator CustomAttributeMapIterator;
   typedef CustomAttributeMap::const_iterator CustomAttributeMapConstIterator;
 
+  /*!
+    \struct ReadCursor
+    \brief Read position of a consumer of the channel, see Subscribe
+
+    The cursor stores the UID of the last consumed item of the source that determines the frame times
+    (the video source, or the timestamp master tool if there is no video data, or the first field data source).
+    New frames are found by stepping through UIDs, so the cost of reading does not depend on the buffer size.
+  */
+  struct ReadCursor
+  {
+    ReadCursor()
+      : LastConsumedTimestamp(UNDEFINED_TIMESTAMP)
+      , NextSampleTimestamp(UNDEFINED_TIMESTAMP)
+    {
+    }
+    /*! UID of the last consumed item for each source ID, 0 if no items have been consumed from the source */
+    std::map<std::string, BufferItemUidType> LastConsumedUids;
+    /*! Timestamp of the last frame that was returned */
+    double LastConsumedTimestamp;
+    /*! Time of the next sample for sampled reading. May be moved forward by the consumer to skip data. */
+    double NextSampleTimestamp;
+  };
+
 public:
   static vtkPlusChannel* New();
   vtkTypeMacro(vtkPlusChannel, vtkObject);
@@ -89,6 +117,16 @@ public:
   bool GetVideoEnabled() const;
   bool GetFieldDataEnabled() const;
 
+  /*!
+    Register a notifier in the video, tool, and field data sources of the channel.
+    The notifier is notified each time a new item is added to any of these sources, therefore
+    consumers can wait for new data using vtkPlusNewDataNotifier::WaitForNewData instead of polling.
+    Sources that are added to the channel later are not observed.
+  */
+  void AddNewDataNotifier(vtkPlusNewDataNotifier* notifier);
+  /*! Unregister a notifier from all the data sources of the channel */
+  void RemoveNewDataNotifier(vtkPlusNewDataNotifier* notifier);
+
   /*! Make a request for the latest image frame */
   vtkImageData* GetBrightnessOutput();
 
@@ -104,7 +142,9 @@ public:
 
   /*!
     Get tracked frame containing the transform(s) or the
-    image(s) acquired from the device at a specific timestamp
+    image(s) acquired from the device at a specific timestamp.
+    Recently assembled frames are cached, so repeated requests for the same timestamp (e.g., from multiple
+    consumers of the channel) do not repeat the interpolation of the tracking data and the assembly of the fields.
     \param timestamp Timestamp of the requested tracked frame
     \param trackedFrame Target tracked frame
     \param enableImageData Enable returning of image data. Tracking data will be interpolated at the timestamp of the image data.
@@ -133,6 +173,30 @@ public:
   */
   PlusStatus GetTrackedFrameList(double& aTimestampOfLastFrameAlreadyGot, vtkIGSIOTrackedFrameList* aTrackedFrameList, int aMaxNumberOfFramesToAdd);
 
+  /*!
+    Reset a read cursor. The first GetTrackedFrameList call with the cursor returns the most recent frame,
+    the first GetTrackedFrameListSampled call samples the frames from firstSampleTimestamp
+    (from the most recent frame if it is UNDEFINED_TIMESTAMP).
+  */
+  void Subscribe(ReadCursor& cursor, double firstSampleTimestamp = UNDEFINED_TIMESTAMP);
+
+  /*!
+    Get all the tracked frames that have been acquired since the previous call with the same cursor
+    \param cursor Read position of the consumer, it is updated to the last returned frame
+    \param aTrackedFrameList Tracked frame list used to get the newly acquired frames into. The new frames are appended to the tracked frame.
+    \param aMaxNumberOfFramesToAdd Maximum this number of frames will be added, if more new frames are available then the most recent frames are returned
+  */
+  PlusStatus GetTrackedFrameList(ReadCursor& cursor, vtkIGSIOTrackedFrameList* aTrackedFrameList, int aMaxNumberOfFramesToAdd);
+
+  /*!
+    Get the tracked frames closest to the sampling times since the previous call with the same cursor
+    \param cursor Read position of the consumer, the next sampling time is increased by the multiple of aSamplingPeriodSec
+    \param aTrackedFrameList Tracked frame list used to get the newly acquired frames into. The new frames are appended to the tracked frame.
+    \param aSamplingPeriodSec Sampling period time for getting the frames in seconds
+    \param maxTimeLimitSec Maximum time spent in the function (in sec)
+  */
+  PlusStatus GetTrackedFrameListSampled(ReadCursor& cursor, vtkIGSIOTrackedFrameList* aTrackedFrameList, double aSamplingPeriodSec, double maxTimeLimitSec = -1);
+
   /*! Get the closest tracked frame timestamp to the specified time */
   virtual double GetClosestTrackedFrameTimestampByTime(double time);
 
@@ -164,6 +228,19 @@ public:
 
   vtkSetMacro(SaveRfProcessingParameters, bool);
 
+  /*!
+    Set the number of most recently assembled tracked frames that are kept for serving repeated requests.
+    The cache stores a copy of each assembled frame, including the image, and each hit copies the frame again,
+    so it only pays off if several consumers request the same timestamps. 0 (default) disables the cache.
+  */
+  void SetTrackedFrameCacheSize(int cacheSize);
+  vtkGetMacro(TrackedFrameCacheSize, int);
+
+  /*! Get the number of GetTrackedFrame requests that were served from the cache */
+  unsigned long long GetNumberOfTrackedFrameCacheHits() const;
+  /*! Get the number of GetTrackedFrame requests that required assembling the tracked frame from the buffers */
+  unsigned long long GetNumberOfTrackedFrameCacheMisses() const;
+
   /*!
     Add generated html report from data acquisition to the existing html report.
     htmlReport and plotter arguments has to be defined by the caller function
@@ -174,6 +251,66 @@ protected:
   /*! Get number of tracked frames between two given timestamps (inclusive) */
   virtual int GetNumberOfFramesBetweenTimestamps(double aTimestampFrom, double aTimestampTo);
 
+  /*!
+    Get a tracked frame at the specified item of the frame timing source.
+    The timing source item is taken by UID, only the other data sources are searched (and interpolated) by time.
+    If timingSource is NULL then all data sources are searched by time, the same way as GetTrackedFrame.
+    \param timingItemTimestamp Timestamp of the timing source item, it identifies the frame in the cache
+  */
+  PlusStatus GetTrackedFrameAtItem(vtkPlusDataSource* timingSource, BufferItemUidType timingItemUid, double timingItemTimestamp, igsioTrackedFrame& trackedFrame, bool enableImageData = true);
+
+  /*!
+    Assemble a tracked frame from the buffers of the data sources, see GetTrackedFrame.
+    If timingSource is not NULL then its item is taken by timingItemUid instead of searching it by time.
+  */
+  virtual PlusStatus AssembleTrackedFrame(double timestamp, igsioTrackedFrame& trackedFrame, bool enableImageData, vtkPlusDataSource* timingSource = NULL, BufferItemUidType timingItemUid = 0);
+
+  /*! Latest item of a data source, identifies the contents of its buffer */
+  struct DataSourceLatestItem
+  {
+    vtkPlusDataSource* Source;
+    BufferItemUidType Uid;
+    /*! Time offset of the source, the frame is assembled at a different item after it changes */
+    double LocalTimeOffsetSec;
+    /*! Timestamp of the latest item, distinguishes items that got the same UID after the buffer was cleared */
+    double Timestamp;
+  };
+  typedef std::vector<DataSourceLatestItem> DataSourceLatestItemList;
+
+  /*! Recently assembled tracked frame */
+  struct TrackedFrameCacheEntry
+  {
+    double Timestamp;
+    bool EnableImageData;
+    /*! Latest item of each data source when the frame was assembled */
+    DataSourceLatestItemList LatestItems;
+    /*! True if all sources had data after the timestamp, so newly added items do not change the frame */
+    bool Complete;
+    std::shared_ptr<igsioTrackedFrame> Frame;
+  };
+
+  /*!
+    Get the latest item of each data source of the channel (video, tools, field data).
+    Returns true if all sources contain items that are acquired at or after the specified timestamp.
+  */
+  bool GetLatestItems(double timestamp, DataSourceLatestItemList& latestItems);
+
+  /*! Check if the buffers still contain the same data that the cache entry was assembled from */
+  bool IsTrackedFrameCacheEntryValid(const TrackedFrameCacheEntry& entry, const DataSourceLatestItemList& latestItems);
+
+  /*! Remove all tracked frames from the cache */
+  void ClearTrackedFrameCache();
+
+  /*! Get the source that determines the frame times: the video source, the timestamp master tool, or the first field data source */
+  PlusStatus GetFrameTimingSource(vtkPlusDataSource*& aSource);
+
+  /*!
+    Get the UID range of the frame timing source items that can be returned as tracked frames.
+    Items that are newer than the most recent synchronized timestamp of the channel are excluded.
+    If no items can be returned then latestUid is less than oldestUid.
+  */
+  PlusStatus GetReadableUidRange(vtkPlusDataSource* timingSource, BufferItemUidType& oldestUid, BufferItemUidType& latestUid, double& mostRecentTimestamp);
+
 protected:
   DataSourceContainer       FieldDataSources;
   DataSourceContainer       Tools;
@@ -199,6 +336,13 @@ protected:
 
   CustomAttributeMap CustomAttributes;
 
+  /*! Most recently assembled tracked frames, the newest is at the back */
+  std::deque<TrackedFrameCacheEntry> TrackedFrameCache;
+  int TrackedFrameCacheSize;
+  unsigned long long NumberOfTrackedFrameCacheHits;
+  unsigned long long NumberOfTrackedFrameCacheMisses;
+  vtkSmartPointer<vtkIGSIORecursiveCriticalSection> TrackedFrameCacheMutex;
+
   vtkPlusChannel(void);
   virtual ~vtkPlusChannel(void);
 
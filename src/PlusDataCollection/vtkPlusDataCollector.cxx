@@ -6,12 +6,15 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusPeriodicScheduler.h"
+#include "PlusThreadScheduling.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataCollector.h"
 #include "vtkPlusDataSource.h"
 #include "vtkPlusDevice.h"
 #include "vtkPlusDeviceFactory.h"
+#include "vtkPlusNewDataNotifier.h"
 #include "vtkPlusSavedDataSource.h"
 
 // vtkAddon includes
@@ -25,7 +28,13 @@ See License.txt for details.
 #endif
 
 // STD includes
+#include <algorithm>
+#include <atomic>
+#include <iomanip>
+#include <map>
 #include <set>
+#include <thread>
+#include <vector>
 
 // VTK includes
 #include <vtkObjectFactory.h>
@@ -34,12 +43,53 @@ See License.txt for details.
 
 //----------------------------------------------------------------------------
 
+namespace
+{
+  const double BYTES_PER_MEGABYTE = 1024.0 * 1024.0;
+  // Estimated memory used by a buffer item in addition to the pixel data (item, transform matrix, image object)
+  const double ITEM_OVERHEAD_BYTES = 1024.0;
+  // Interpolation needs at least two items
+  const int MINIMUM_BUFFER_SIZE = 2;
+  // Maximum time that Start waits by default for the first items in the buffers
+  const double DEFAULT_STARTUP_TIMEOUT_SEC = 5.0;
+  // Connecting is mostly waiting for hardware, so the number of threads is not limited by the number of cores
+  const unsigned int MAXIMUM_STARTUP_THREADS = 16;
+  // Step of the virtual replay clock if none of the devices on the clock has an acquisition rate
+  const double DEFAULT_REPLAY_STEP_SEC = 0.01;
+  // Update times of the devices on the replay clock are compared with this tolerance to absorb rounding errors
+  const double REPLAY_TIME_TOLERANCE_SEC = 1e-9;
+
+  struct BudgetedSource
+  {
+    vtkPlusDataSource* Source;
+    double AcquisitionRate;
+    double ItemSizeBytes;
+    bool MinimumBufferSizeUsed;
+  };
+
+  //----------------------------------------------------------------------------
+  double GetEstimatedItemSizeBytes(vtkPlusBuffer* buffer)
+  {
+    FrameSizeType frameSize = buffer->GetFrameSize();
+    double pixelDataSizeBytes = static_cast<double>(frameSize[0]) * frameSize[1] * frameSize[2] * buffer->GetNumberOfBytesPerPixel();
+    return ITEM_OVERHEAD_BYTES + pixelDataSizeBytes;
+  }
+}
+
 vtkStandardNewMacro(vtkPlusDataCollector);
 
 //----------------------------------------------------------------------------
 vtkPlusDataCollector::vtkPlusDataCollector()
   : vtkObject()
+  , StartupTimeoutSec(DEFAULT_STARTUP_TIMEOUT_SEC)
   , StartupDelaySec(0.0)
+  , ParallelStartup(true)
+  , LockMemory(false)
+  , MemoryLocked(false)
+  , MemoryBudgetMB(0.0)
+  , ReplayStepSec(0.0)
+  , ReplayClockStopRequested(false)
+  , ReplayClockStopTime(0.0)
   , DeviceFactory(vtkSmartPointer<vtkPlusDeviceFactory>::New())
   , Connected(false)
   , Started(false)
@@ -63,9 +113,15 @@ vtkPlusDataCollector::~vtkPlusDataCollector()
   {
     this->Disconnect();
   }
+  this->StopReplayClock();
 
   for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
   {
+    if ((*it)->GetReplayClock() == &this->Clock)
+    {
+      // The device may outlive the data collector
+      (*it)->SetReplayClock(NULL);
+    }
     (*it)->Delete();
   }
   Devices.clear();
@@ -97,6 +153,14 @@ PlusStatus vtkPlusDataCollector::ReadConfiguration(vtkXMLDataElement* aConfig)
     return PLUS_FAIL;
   }
 
+  // Read StartupTimeoutSec
+  double startupTimeoutSec(0.0);
+  if (dataCollectionElement->GetScalarAttribute("StartupTimeoutSec", startupTimeoutSec))
+  {
+    this->SetStartupTimeoutSec(startupTimeoutSec);
+    LOG_DEBUG("StartupTimeoutSec: " << std::fixed << startupTimeoutSec);
+  }
+
   // Read StartupDelaySec
   double startupDelaySec(0.0);
   if (dataCollectionElement->GetScalarAttribute("StartupDelaySec", startupDelaySec))
@@ -105,6 +169,47 @@ PlusStatus vtkPlusDataCollector::ReadConfiguration(vtkXMLDataElement* aConfig)
     LOG_DEBUG("StartupDelaySec: " << std::fixed << startupDelaySec);
   }
 
+  // Read ParallelStartup
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(ParallelStartup, dataCollectionElement);
+
+  // Read LockMemory
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(LockMemory, dataCollectionElement);
+
+  // Read MemoryBudgetMB
+  double memoryBudgetMB(0.0);
+  if (dataCollectionElement->GetScalarAttribute("MemoryBudgetMB", memoryBudgetMB))
+  {
+    this->SetMemoryBudgetMB(memoryBudgetMB);
+    LOG_DEBUG("MemoryBudgetMB: " << std::fixed << memoryBudgetMB);
+  }
+
+  // Read replay clock settings
+  const char* replayClockMode = dataCollectionElement->GetAttribute("ReplayClock");
+  if (replayClockMode != NULL)
+  {
+    ReplayClock::ClockMode mode(ReplayClock::REPLAY_CLOCK_REAL_TIME);
+    if (ReplayClock::GetClockModeFromString(replayClockMode, mode) != PLUS_SUCCESS)
+    {
+      return PLUS_FAIL;
+    }
+    this->Clock.SetMode(mode);
+  }
+  double replaySpeed(1.0);
+  if (dataCollectionElement->GetScalarAttribute("ReplaySpeed", replaySpeed) && this->Clock.SetSpeed(replaySpeed) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+  double replayStepSec(0.0);
+  if (dataCollectionElement->GetScalarAttribute("ReplayStepSec", replayStepSec))
+  {
+    if (replayStepSec < 0)
+    {
+      LOG_ERROR("ReplayStepSec must not be negative: " << replayStepSec);
+      return PLUS_FAIL;
+    }
+    this->SetReplayStepSec(replayStepSec);
+  }
+
   std::set<std::string> existingDeviceIds;
 
   for (int i = 0; i < dataCollectionElement->GetNumberOfNestedElements(); ++i)
@@ -280,7 +385,38 @@ PlusStatus vtkPlusDataCollector::WriteConfiguration(vtkXMLDataElement* aConfig)
     return PLUS_FAIL;
   }
 
-  dataCollectionConfig->SetDoubleAttribute("StartupDelaySec", GetStartupDelaySec());
+  if (this->StartupTimeoutSec != DEFAULT_STARTUP_TIMEOUT_SEC || dataCollectionConfig->GetAttribute("StartupTimeoutSec") != NULL)
+  {
+    dataCollectionConfig->SetDoubleAttribute("StartupTimeoutSec", this->GetStartupTimeoutSec());
+  }
+  if (this->StartupDelaySec > 0 || dataCollectionConfig->GetAttribute("StartupDelaySec") != NULL)
+  {
+    dataCollectionConfig->SetDoubleAttribute("StartupDelaySec", this->GetStartupDelaySec());
+  }
+  if (!this->ParallelStartup || dataCollectionConfig->GetAttribute("ParallelStartup") != NULL)
+  {
+    XML_WRITE_BOOL_ATTRIBUTE(ParallelStartup, dataCollectionConfig);
+  }
+  if (this->LockMemory || dataCollectionConfig->GetAttribute("LockMemory") != NULL)
+  {
+    XML_WRITE_BOOL_ATTRIBUTE(LockMemory, dataCollectionConfig);
+  }
+  if (this->MemoryBudgetMB > 0 || dataCollectionConfig->GetAttribute("MemoryBudgetMB") != NULL)
+  {
+    dataCollectionConfig->SetDoubleAttribute("MemoryBudgetMB", this->GetMemoryBudgetMB());
+  }
+  if (this->Clock.IsVirtual() || dataCollectionConfig->GetAttribute("ReplayClock") != NULL)
+  {
+    dataCollectionConfig->SetAttribute("ReplayClock", ReplayClock::GetClockModeAsString(this->Clock.GetMode()).c_str());
+  }
+  if (this->Clock.GetSpeed() != 1.0 || dataCollectionConfig->GetAttribute("ReplaySpeed") != NULL)
+  {
+    dataCollectionConfig->SetDoubleAttribute("ReplaySpeed", this->Clock.GetSpeed());
+  }
+  if (this->ReplayStepSec > 0 || dataCollectionConfig->GetAttribute("ReplayStepSec") != NULL)
+  {
+    dataCollectionConfig->SetDoubleAttribute("ReplayStepSec", this->ReplayStepSec);
+  }
 
   PlusStatus status = PLUS_SUCCESS;
 
@@ -318,25 +454,60 @@ PlusStatus vtkPlusDataCollector::Start()
 {
   LOG_TRACE("vtkPlusDataCollector::Start()");
 
+  std::vector<DeviceCollection> startupGroups;
+  if (this->GetDeviceStartupGroups(startupGroups) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
   PlusStatus status = PLUS_SUCCESS;
 
-  const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  // Locked before the capture threads start, so that their memory is locked, too
+  if (this->LockMemory && !this->MemoryLocked)
+  {
+    this->MemoryLocked = (ThreadScheduling::LockProcessMemory() == PLUS_SUCCESS);
+  }
 
-  for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
+  // The replay timeline starts at the current time, so timestamps are comparable with the system time.
+  // After a restart a virtual clock continues from where it stopped, so the timestamps in the buffers do not go backwards.
+  double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  if (this->Clock.IsVirtual() && this->ReplayClockStopTime > 0)
   {
-    vtkPlusDevice* device = *it;
+    startTime = this->ReplayClockStopTime;
+  }
+  this->Clock.SetTime(startTime);
+  this->AttachReplayClock();
 
-    if (device->StartRecording() != PLUS_SUCCESS)
+  for (std::vector<DeviceCollection>::iterator groupIt = startupGroups.begin(); groupIt != startupGroups.end(); ++groupIt)
+  {
+    PlusStatus groupStatus = this->ExecuteOnDevices(*groupIt, [startTime](vtkPlusDevice * device)
+    {
+      PlusStatus deviceStatus = device->StartRecording();
+      if (deviceStatus != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Failed to start data acquisition for device " << device->GetDeviceId() << ".");
+      }
+      device->SetStartTime(startTime);
+      return deviceStatus;
+    });
+    if (groupStatus != PLUS_SUCCESS)
     {
-      LOG_ERROR("Failed to start data acquisition for device " << device->GetDeviceId() << ".");
       status = PLUS_FAIL;
     }
-    device->SetStartTime(startTime);
   }
 
-  LOG_DEBUG("vtkPlusDataCollector::Start -- wait " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
+  // Devices on a virtual replay clock only acquire data when the clock is advanced
+  this->StartReplayClock(startupGroups, startTime);
+
+  // The timestamp filtering needs the first items, so wait until all buffers have received data
+  this->WaitForFirstItems(this->StartupTimeoutSec);
 
-  vtkIGSIOAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+  // A fixed delay is only used if it is requested explicitly
+  if (this->StartupDelaySec > 0)
+  {
+    LOG_DEBUG("vtkPlusDataCollector::Start -- wait " << std::fixed << this->StartupDelaySec << " sec for buffer init...");
+    vtkIGSIOAccurateTimer::DelayWithEventProcessing(this->StartupDelaySec);
+  }
 
   this->Started = true;
 
@@ -348,8 +519,15 @@ PlusStatus vtkPlusDataCollector::Stop()
 {
   LOG_TRACE("vtkPlusDataCollector::Stop()");
 
+  this->StopReplayClock();
   this->Started = false;
 
+  if (this->MemoryLocked)
+  {
+    ThreadScheduling::UnlockProcessMemory();
+    this->MemoryLocked = false;
+  }
+
   return PLUS_SUCCESS;
 }
 
@@ -358,16 +536,29 @@ PlusStatus vtkPlusDataCollector::Connect()
 {
   LOG_TRACE("vtkPlusDataCollector::Connect()");
 
+  std::vector<DeviceCollection> startupGroups;
+  if (this->GetDeviceStartupGroups(startupGroups) != PLUS_SUCCESS)
+  {
+    return PLUS_FAIL;
+  }
+
   PlusStatus status = PLUS_SUCCESS;
 
-  for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
+  for (std::vector<DeviceCollection>::iterator groupIt = startupGroups.begin(); groupIt != startupGroups.end(); ++groupIt)
   {
-    vtkPlusDevice* device = *it;
-
-    if (device->Connect() != PLUS_SUCCESS)
+    status = this->ExecuteOnDevices(*groupIt, [](vtkPlusDevice * device)
     {
-      LOG_ERROR("Unable to connect device: " << device->GetDeviceId() << ".");
-      status = PLUS_FAIL;
+      PlusStatus deviceStatus = device->Connect();
+      if (deviceStatus != PLUS_SUCCESS)
+      {
+        LOG_ERROR("Unable to connect device: " << device->GetDeviceId() << ".");
+      }
+      return deviceStatus;
+    });
+    if (status != PLUS_SUCCESS)
+    {
+      // The devices of the next groups use the channels of the devices that failed to connect
+      break;
     }
   }
 
@@ -377,6 +568,14 @@ PlusStatus vtkPlusDataCollector::Connect()
     status = PLUS_FAIL;
   }
 
+  // Frame sizes are known after the devices are connected
+  if (status == PLUS_SUCCESS && this->MemoryBudgetMB > 0 && this->ApplyMemoryBudget() != PLUS_SUCCESS)
+  {
+    LOG_ERROR("Failed to resize buffers to the memory budget of " << this->MemoryBudgetMB << " MB");
+    this->Disconnect();
+    status = PLUS_FAIL;
+  }
+
   if (this->SetLoopTimes() != PLUS_SUCCESS)
   {
     LOG_WARNING("Failed to set loop times!");
@@ -392,6 +591,9 @@ PlusStatus vtkPlusDataCollector::Disconnect()
 {
   LOG_TRACE("vtkPlusDataCollector::Disconnect()");
 
+  // Devices must not be updated on the replay clock while they are disconnected
+  this->StopReplayClock();
+
   PlusStatus status = PLUS_SUCCESS;
 
   for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
@@ -411,12 +613,432 @@ PlusStatus vtkPlusDataCollector::Disconnect()
   return status;
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::GetDeviceStartupGroups(std::vector<DeviceCollection>& groups) const
+{
+  groups.clear();
+
+  // Collect the devices that own the input channels of each device
+  std::map<vtkPlusDevice*, std::set<vtkPlusDevice*> > dependencies;
+  for (DeviceCollectionConstIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    std::set<vtkPlusDevice*>& deviceDependencies = dependencies[*it];
+    for (ChannelContainerConstIterator channelIt = (*it)->GetInputChannelsStart(); channelIt != (*it)->GetInputChannelsEnd(); ++channelIt)
+    {
+      vtkPlusDevice* ownerDevice = (*channelIt)->GetOwnerDevice();
+      if (ownerDevice != NULL && ownerDevice != *it && std::find(this->Devices.begin(), this->Devices.end(), ownerDevice) != this->Devices.end())
+      {
+        deviceDependencies.insert(ownerDevice);
+      }
+    }
+  }
+
+  // Each group contains the devices whose dependencies are all in previous groups
+  std::set<vtkPlusDevice*> groupedDevices;
+  while (groupedDevices.size() < this->Devices.size())
+  {
+    DeviceCollection group;
+    for (DeviceCollectionConstIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+    {
+      if (groupedDevices.count(*it) > 0)
+      {
+        continue;
+      }
+      const std::set<vtkPlusDevice*>& deviceDependencies = dependencies[*it];
+      if (std::includes(groupedDevices.begin(), groupedDevices.end(), deviceDependencies.begin(), deviceDependencies.end()))
+      {
+        group.push_back(*it);
+      }
+    }
+    if (group.empty())
+    {
+      LOG_ERROR("Devices use each other's output channels in a cycle, the startup order cannot be determined");
+      return PLUS_FAIL;
+    }
+    groupedDevices.insert(group.begin(), group.end());
+    groups.push_back(group);
+  }
+
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::ExecuteOnDevices(const DeviceCollection& devices, const std::function<PlusStatus(vtkPlusDevice*)>& operation)
+{
+  if (!this->ParallelStartup || devices.size() < 2)
+  {
+    PlusStatus status = PLUS_SUCCESS;
+    for (DeviceCollectionConstIterator it = devices.begin(); it != devices.end(); ++it)
+    {
+      if (operation(*it) != PLUS_SUCCESS)
+      {
+        status = PLUS_FAIL;
+      }
+    }
+    return status;
+  }
+
+  // Worker threads take the next device until all devices are processed
+  std::atomic<size_t> nextDeviceIndex(0);
+  std::atomic<bool> failed(false);
+  auto worker = [&devices, &operation, &nextDeviceIndex, &failed]()
+  {
+    for (size_t i = nextDeviceIndex++; i < devices.size(); i = nextDeviceIndex++)
+    {
+      if (operation(devices[i]) != PLUS_SUCCESS)
+      {
+        failed = true;
+      }
+    }
+  };
+
+  const size_t numberOfThreads = std::min<size_t>(devices.size(), MAXIMUM_STARTUP_THREADS);
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < numberOfThreads; ++i)
+  {
+    threads.push_back(std::thread(worker));
+  }
+  for (std::vector<std::thread>::iterator it = threads.begin(); it != threads.end(); ++it)
+  {
+    it->join();
+  }
+
+  return failed ? PLUS_FAIL : PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::WaitForFirstItems(double timeoutSec)
+{
+  if (timeoutSec <= 0)
+  {
+    return;
+  }
+
+  // Virtual devices only produce data when their input devices do, so only the non-virtual devices are checked
+  std::set<vtkPlusDataSource*> sources;
+  for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    vtkPlusDevice* device = *it;
+    if (device->IsVirtual())
+    {
+      continue;
+    }
+    for (DataSourceContainerConstIterator sourceIt = device->GetVideoSourceIteratorBegin(); sourceIt != device->GetVideoSourceIteratorEnd(); ++sourceIt)
+    {
+      sources.insert(sourceIt->second);
+    }
+    for (DataSourceContainerConstIterator sourceIt = device->GetToolIteratorBegin(); sourceIt != device->GetToolIteratorEnd(); ++sourceIt)
+    {
+      sources.insert(sourceIt->second);
+    }
+    for (DataSourceContainerConstIterator sourceIt = device->GetFieldDataSourcessIteratorBegin(); sourceIt != device->GetFieldDataSourcessIteratorEnd(); ++sourceIt)
+    {
+      sources.insert(sourceIt->second);
+    }
+  }
+  if (sources.empty())
+  {
+    return;
+  }
+
+  vtkSmartPointer<vtkPlusNewDataNotifier> notifier = vtkSmartPointer<vtkPlusNewDataNotifier>::New();
+  for (std::set<vtkPlusDataSource*>::iterator it = sources.begin(); it != sources.end(); ++it)
+  {
+    (*it)->AddNewDataNotifier(notifier);
+  }
+
+  const double startTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  unsigned long long lastSequenceNumber = notifier->GetSequenceNumber();
+  std::set<vtkPlusDataSource*> waitingSources(sources);
+  while (true)
+  {
+    for (std::set<vtkPlusDataSource*>::iterator it = waitingSources.begin(); it != waitingSources.end();)
+    {
+      if ((*it)->GetNumberOfItems() > 0)
+      {
+        it = waitingSources.erase(it);
+      }
+      else
+      {
+        ++it;
+      }
+    }
+    const double remainingTimeSec = startTime + timeoutSec - vtkIGSIOAccurateTimer::GetSystemTime();
+    if (waitingSources.empty() || remainingTimeSec <= 0)
+    {
+      break;
+    }
+    notifier->WaitForNewData(lastSequenceNumber, remainingTimeSec);
+  }
+
+  for (std::set<vtkPlusDataSource*>::iterator it = sources.begin(); it != sources.end(); ++it)
+  {
+    (*it)->RemoveNewDataNotifier(notifier);
+  }
+
+  if (waitingSources.empty())
+  {
+    LOG_DEBUG("All buffers received data in " << std::fixed << std::setprecision(3) << vtkIGSIOAccurateTimer::GetSystemTime() - startTime << " sec");
+    return;
+  }
+  std::ostringstream waitingSourceIds;
+  for (std::set<vtkPlusDataSource*>::iterator it = waitingSources.begin(); it != waitingSources.end(); ++it)
+  {
+    waitingSourceIds << (it == waitingSources.begin() ? "" : ", ") << (*it)->GetId();
+  }
+  LOG_INFO("No data received within " << std::fixed << std::setprecision(1) << timeoutSec << " sec after start from: " << waitingSourceIds.str());
+}
+
+//----------------------------------------------------------------------------
+ReplayClock& vtkPlusDataCollector::GetReplayClock()
+{
+  return this->Clock;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::AttachReplayClock()
+{
+  if (!this->Clock.IsVirtual())
+  {
+    return;
+  }
+  for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    vtkPlusDevice* device = *it;
+    if (device->GetReplayClock() == &this->Clock)
+    {
+      continue;
+    }
+    if (!device->IsVirtual() && dynamic_cast<vtkPlusSavedDataSource*>(device) == NULL)
+    {
+      LOG_WARNING("Device " << device->GetDeviceId() << " acquires live data, its timestamps do not follow the "
+                  << ReplayClock::GetClockModeAsString(this->Clock.GetMode()) << " replay clock");
+      continue;
+    }
+    device->SetReplayClock(&this->Clock);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::StartReplayClock(const std::vector<DeviceCollection>& startupGroups, double startTime)
+{
+  if (!this->Clock.IsVirtual() || this->ReplayClockThread.joinable())
+  {
+    return;
+  }
+
+  // Devices are updated in startup order, so virtual devices process the data of their input devices in the same step
+  DeviceCollection devices;
+  double highestAcquisitionRate(0.0);
+  for (std::vector<DeviceCollection>::const_iterator groupIt = startupGroups.begin(); groupIt != startupGroups.end(); ++groupIt)
+  {
+    for (DeviceCollectionConstIterator it = groupIt->begin(); it != groupIt->end(); ++it)
+    {
+      if ((*it)->IsDrivenByReplayClock() && (*it)->GetStartThreadForInternalUpdates())
+      {
+        devices.push_back(*it);
+        highestAcquisitionRate = std::max(highestAcquisitionRate, (*it)->GetAcquisitionRate());
+      }
+    }
+  }
+
+  double stepSec = this->ReplayStepSec;
+  if (stepSec <= 0)
+  {
+    stepSec = (highestAcquisitionRate > 0 ? 1.0 / highestAcquisitionRate : DEFAULT_REPLAY_STEP_SEC);
+  }
+  std::ostringstream clockDescription;
+  clockDescription << ReplayClock::GetClockModeAsString(this->Clock.GetMode());
+  if (this->Clock.GetMode() == ReplayClock::REPLAY_CLOCK_FIXED_SPEED)
+  {
+    clockDescription << " (speed: " << this->Clock.GetSpeed() << "x)";
+  }
+  LOG_INFO("Replay clock: " << clockDescription.str() << ", step: " << std::fixed << std::setprecision(4) << stepSec
+           << " sec, devices updated on the clock: " << devices.size());
+
+  this->ReplayClockStopRequested = false;
+  this->ReplayClockThread = std::thread(&vtkPlusDataCollector::ReplayClockThreadMain, this, devices, startTime, stepSec);
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::StopReplayClock()
+{
+  if (!this->ReplayClockThread.joinable())
+  {
+    return;
+  }
+  this->ReplayClockStopRequested = true;
+  this->ReplayClockThread.join();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusDataCollector::ReplayClockThreadMain(DeviceCollection devices, double startTime, double stepSec)
+{
+  // Each device is updated at its own acquisition rate on the replay timeline, devices without a rate at each step
+  std::vector<double> nextUpdateTimes(devices.size(), startTime);
+
+  const bool fixedSpeed = (this->Clock.GetMode() == ReplayClock::REPLAY_CLOCK_FIXED_SPEED);
+  PeriodicScheduler scheduler;
+  if (fixedSpeed)
+  {
+    // Late steps are executed back-to-back, so that the replay keeps up with the requested speed on average
+    scheduler.SetPeriodSec(stepSec / this->Clock.GetSpeed());
+    scheduler.SetCatchUpPolicy(PeriodicScheduler::CATCH_UP_BURST);
+    scheduler.Start();
+  }
+
+  // The time is computed from the step index, so rounding errors do not accumulate
+  unsigned long long stepIndex = 0;
+  for (; !this->ReplayClockStopRequested; ++stepIndex)
+  {
+    const double time = startTime + stepIndex * stepSec;
+    this->Clock.SetTime(time);
+    for (size_t i = 0; i < devices.size(); ++i)
+    {
+      if (time + REPLAY_TIME_TOLERANCE_SEC < nextUpdateTimes[i])
+      {
+        continue;
+      }
+      devices[i]->UpdateOnReplayClock();
+      const double acquisitionRate = devices[i]->GetAcquisitionRate();
+      while (acquisitionRate > 0 && nextUpdateTimes[i] <= time + REPLAY_TIME_TOLERANCE_SEC)
+      {
+        nextUpdateTimes[i] += 1.0 / acquisitionRate;
+      }
+    }
+
+    if (fixedSpeed)
+    {
+      scheduler.WaitForNextDeadline();
+    }
+    else
+    {
+      // Let the threads that consume the data (e.g., servers) run between the steps
+      std::this_thread::yield();
+    }
+  }
+  this->ReplayClockStopTime = startTime + stepIndex * stepSec;
+}
+
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataCollector::ApplyMemoryBudget()
+{
+  LOG_TRACE("vtkPlusDataCollector::ApplyMemoryBudget()");
+
+  // Collect the sources of all devices. Virtual devices may share sources with other devices.
+  std::set<vtkPlusDataSource*> visitedSources;
+  std::vector<BudgetedSource> budgetedSources;
+  double fixedSizeBytes(0.0);
+  double bytesPerSec(0.0);
+  for (DeviceCollectionIterator it = this->Devices.begin(); it != this->Devices.end(); ++it)
+  {
+    vtkPlusDevice* device = *it;
+    std::vector<vtkPlusDataSource*> sources;
+    for (DataSourceContainerConstIterator sourceIt = device->GetVideoSourceIteratorBegin(); sourceIt != device->GetVideoSourceIteratorEnd(); ++sourceIt)
+    {
+      sources.push_back(sourceIt->second);
+    }
+    for (DataSourceContainerConstIterator sourceIt = device->GetToolIteratorBegin(); sourceIt != device->GetToolIteratorEnd(); ++sourceIt)
+    {
+      sources.push_back(sourceIt->second);
+    }
+    for (DataSourceContainerConstIterator sourceIt = device->GetFieldDataSourcessIteratorBegin(); sourceIt != device->GetFieldDataSourcessIteratorEnd(); ++sourceIt)
+    {
+      sources.push_back(sourceIt->second);
+    }
+
+    for (std::vector<vtkPlusDataSource*>::iterator sourceIt = sources.begin(); sourceIt != sources.end(); ++sourceIt)
+    {
+      vtkPlusDataSource* source = *sourceIt;
+      if (!visitedSources.insert(source).second)
+      {
+        continue;
+      }
+      BudgetedSource budgetedSource;
+      budgetedSource.Source = source;
+      budgetedSource.AcquisitionRate = (source->GetDevice() != NULL ? source->GetDevice()->GetAcquisitionRate() : device->GetAcquisitionRate());
+      budgetedSource.ItemSizeBytes = GetEstimatedItemSizeBytes(source->GetBuffer());
+      budgetedSource.MinimumBufferSizeUsed = false;
+      if (budgetedSource.AcquisitionRate <= 0)
+      {
+        LOG_DEBUG("Acquisition rate of source " << source->GetId() << " is unknown, its buffer size is not changed");
+        fixedSizeBytes += source->GetBuffer()->GetBufferSize() * budgetedSource.ItemSizeBytes;
+        continue;
+      }
+      bytesPerSec += budgetedSource.AcquisitionRate * budgetedSource.ItemSizeBytes;
+      budgetedSources.push_back(budgetedSource);
+    }
+  }
+
+  if (budgetedSources.empty())
+  {
+    LOG_WARNING("No data sources with known acquisition rate are found, memory budget is not applied");
+    return PLUS_SUCCESS;
+  }
+
+  // The memory of the sources that get the minimum buffer size is taken from the budget of the other sources,
+  // which may get shorter history then. Repeat until no more sources fall below the minimum.
+  const double budgetBytes = this->MemoryBudgetMB * BYTES_PER_MEGABYTE - fixedSizeBytes;
+  double minimumSizeBytes(0.0);
+  double historySec(0.0);
+  bool minimumBufferSizeApplied(true);
+  while (minimumBufferSizeApplied)
+  {
+    minimumBufferSizeApplied = false;
+    historySec = (bytesPerSec > 0 ? std::max(budgetBytes - minimumSizeBytes, 0.0) / bytesPerSec : 0.0);
+    for (std::vector<BudgetedSource>::iterator it = budgetedSources.begin(); it != budgetedSources.end(); ++it)
+    {
+      if (!it->MinimumBufferSizeUsed && historySec * it->AcquisitionRate < MINIMUM_BUFFER_SIZE)
+      {
+        LOG_WARNING("Memory budget of " << this->MemoryBudgetMB << " MB is too small for source " << it->Source->GetId() << ", minimum buffer size of " << MINIMUM_BUFFER_SIZE << " is used");
+        it->MinimumBufferSizeUsed = true;
+        minimumSizeBytes += MINIMUM_BUFFER_SIZE * it->ItemSizeBytes;
+        bytesPerSec -= it->AcquisitionRate * it->ItemSizeBytes;
+        minimumBufferSizeApplied = true;
+      }
+    }
+  }
+
+  PlusStatus status = PLUS_SUCCESS;
+  double totalSizeBytes(fixedSizeBytes);
+  for (std::vector<BudgetedSource>::iterator it = budgetedSources.begin(); it != budgetedSources.end(); ++it)
+  {
+    const int bufferSize = (it->MinimumBufferSizeUsed ? MINIMUM_BUFFER_SIZE : static_cast<int>(historySec * it->AcquisitionRate));
+    if (it->Source->SetBufferSize(bufferSize) != PLUS_SUCCESS)
+    {
+      LOG_ERROR("Failed to set buffer size of source " << it->Source->GetId() << " to " << bufferSize);
+      status = PLUS_FAIL;
+      continue;
+    }
+    const double bufferSizeBytes = bufferSize * it->ItemSizeBytes;
+    totalSizeBytes += bufferSizeBytes;
+    LOG_INFO("Buffer of source " << it->Source->GetId() << ": " << bufferSize << " items, " << std::fixed << std::setprecision(1)
+             << bufferSizeBytes / BYTES_PER_MEGABYTE << " MB, history: " << bufferSize / it->AcquisitionRate << " sec");
+  }
+  LOG_INFO("Total estimated buffer memory: " << std::fixed << std::setprecision(1) << totalSizeBytes / BYTES_PER_MEGABYTE << " MB (budget: " << this->MemoryBudgetMB << " MB)");
+  if (totalSizeBytes > this->MemoryBudgetMB * BYTES_PER_MEGABYTE)
+  {
+    LOG_WARNING("Total estimated buffer memory of " << std::fixed << std::setprecision(1) << totalSizeBytes / BYTES_PER_MEGABYTE << " MB exceeds the memory budget of " << this->MemoryBudgetMB
+                << " MB, because of the minimum buffer sizes and the buffers of sources with unknown acquisition rate");
+  }
+
+  return status;
+}
+
 //----------------------------------------------------------------------------
 void vtkPlusDataCollector::PrintSelf(ostream& os, vtkIndent indent)
 {
   LOG_TRACE("vtkPlusDataCollector::PrintSelf()");
 
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "StartupTimeoutSec: " << this->StartupTimeoutSec << std::endl;
+  os << indent << "StartupDelaySec: " << this->StartupDelaySec << std::endl;
+  os << indent << "ParallelStartup: " << (this->ParallelStartup ? "TRUE" : "FALSE") << std::endl;
+  os << indent << "LockMemory: " << (this->LockMemory ? "TRUE" : "FALSE") << std::endl;
+  os << indent << "MemoryBudgetMB: " << this->MemoryBudgetMB << std::endl;
+  os << indent << "ReplayClock: " << ReplayClock::GetClockModeAsString(this->Clock.GetMode()) << std::endl;
+  os << indent << "ReplaySpeed: " << this->Clock.GetSpeed() << std::endl;
+  os << indent << "ReplayStepSec: " << this->ReplayStepSec << std::endl;
 
   for (DeviceCollectionIterator it = Devices.begin(); it != Devices.end(); ++ it)
   {
@@ -631,10 +1253,10 @@ PlusStatus vtkPlusDataCollector::GetVideoData(vtkPlusChannel* aRequestedChannel,
     trackedFrame->SetTimestamp(itemTimestamp);
 
     // Copy all custom fields
-    igsioFieldMapType fieldMap = currentStreamBufferItem.GetFrameFieldMap();
-    for (igsioFieldMapType::const_iterator fieldIterator = fieldMap.begin(); fieldIterator != fieldMap.end(); fieldIterator++)
+    const StreamBufferItem::FrameFieldContainer& frameFields = currentStreamBufferItem.GetFrameFields();
+    for (StreamBufferItem::FrameFieldContainer::const_iterator fieldIterator = frameFields.begin(); fieldIterator != frameFields.end(); ++fieldIterator)
     {
-      trackedFrame->SetFrameField(fieldIterator->first, fieldIterator->second.second, fieldIterator->second.first);
+      trackedFrame->SetFrameField(FrameFieldSchema::GetFieldName(fieldIterator->Id), fieldIterator->Value, fieldIterator->Flags);
     }
 
     // Add tracked frame to the list
@@ -9,12 +9,19 @@ See License.txt for details.
 
 // Local includes
 #include "igsioCommon.h"
+#include "PlusReplayClock.h"
 #include "vtkPlusDataCollectionExport.h"
 #include "vtkPlusDevice.h"
 
 // VTK includes
 #include <vtkObject.h>
 
+// STL includes
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
 //class igsioTrackedFrame; 
 class vtkPlusChannel;
 class vtkPlusDeviceFactory;
@@ -149,18 +156,135 @@ public:
   */
   bool GetConnected() const;
 
-  /*! Set startup delay in sec to give some time to the buffers for proper initialization */
+  /*!
+    Set the maximum time in sec that Start waits for the first item in the buffers of the non-virtual devices.
+    Start continues as soon as all buffers contain data. Default is 5 sec, 0 means that Start does not wait for data.
+  */
+  vtkSetMacro(StartupTimeoutSec, double);
+  /*! Get the maximum time in sec that Start waits for the first item in the buffers */
+  vtkGetMacro(StartupTimeoutSec, double);
+
+  /*!
+    Set an additional fixed time in sec that Start waits after the first items are received (see StartupTimeoutSec),
+    for devices whose timestamp filtering needs more items to settle. Default is 0, no fixed delay.
+  */
   vtkSetMacro(StartupDelaySec, double);
-  /*! Get startup delay in sec to give some time to the buffers for proper initialization */
+  /*! Get the time in sec that Start waits after the devices are started */
   vtkGetMacro(StartupDelaySec, double);
 
+  /*!
+    If enabled then devices are connected and started concurrently. Devices that use the output channels
+    of other devices are connected and started after those devices. Enabled by default. Disable it if
+    a device SDK cannot be used from multiple threads at the same time.
+  */
+  vtkSetMacro(ParallelStartup, bool);
+  vtkGetMacro(ParallelStartup, bool);
+  vtkBooleanMacro(ParallelStartup, bool);
+
+  /*!
+    If enabled then all current and future memory pages of the process are locked when data collection is started,
+    so that the acquisition is not delayed by paging. The lock applies to the whole process and it is released when
+    data collection is stopped. Only supported on Linux. Disabled by default.
+  */
+  vtkSetMacro(LockMemory, bool);
+  vtkGetMacro(LockMemory, bool);
+  vtkBooleanMacro(LockMemory, bool);
+
+  /*!
+    Set the memory budget in MB for the buffers of all data sources. If the budget is positive then
+    the buffers are resized when the devices are connected, so that their total size stays within the budget.
+    0 means that the buffer sizes are not changed.
+  */
+  vtkSetMacro(MemoryBudgetMB, double);
+  /*! Get the memory budget in MB for the buffers of all data sources */
+  vtkGetMacro(MemoryBudgetMB, double);
+
+  /*!
+    Distribute the memory budget across the buffers of all data sources. Each source gets the same history
+    duration, so the number of items of a source is proportional to the acquisition rate of its device and
+    its share of the budget is proportional to the acquisition rate multiplied by the item size, which is
+    estimated from the frame size of the buffer. Sources whose device has no acquisition rate keep their buffer size.
+    Each buffer keeps at least 2 items, the memory of these buffers is taken from the other sources.
+    The resulting buffer sizes and history durations are logged, and a warning is logged if the total
+    estimated memory still exceeds the budget.
+  */
+  PlusStatus ApplyMemoryBudget();
+
+  /*!
+    Clock of the devices when recorded data is replayed. If it is virtual then the saved data sources and the virtual
+    devices are updated by the data collector on a single thread after each step of the clock, instead of by their own
+    data capture threads. Mode and speed must be set before the devices are started.
+  */
+  ReplayClock& GetReplayClock();
+
+  /*!
+    Set the time step of a virtual replay clock in seconds.
+    0 (default) means the acquisition period of the fastest device that is updated on the replay clock.
+  */
+  vtkSetMacro(ReplayStepSec, double);
+  /*! Get the time step of a virtual replay clock in seconds */
+  vtkGetMacro(ReplayStepSec, double);
+
 protected:
   vtkPlusDataCollector();
   virtual ~vtkPlusDataCollector();
 
-  /*! The timestamp filtering methods require some time to initialize. Synchronization will ignore data that are acquired during startup delay. */
+  /*!
+    Sort the devices into groups that can be connected and started concurrently.
+    The devices in a group only use output channels of devices in previous groups.
+  */
+  PlusStatus GetDeviceStartupGroups(std::vector<DeviceCollection>& groups) const;
+
+  /*!
+    Run an operation on each device of a group. The operation is run concurrently if ParallelStartup is enabled.
+    Returns PLUS_FAIL if the operation failed for any of the devices.
+  */
+  PlusStatus ExecuteOnDevices(const DeviceCollection& devices, const std::function<PlusStatus(vtkPlusDevice*)>& operation);
+
+  /*! Wait until the buffer of each data source of the non-virtual devices contains at least one item or the timeout expires */
+  void WaitForFirstItems(double timeoutSec);
+
+  /*! Set the replay clock of the saved data sources and virtual devices, if the replay clock is virtual */
+  void AttachReplayClock();
+
+  /*! Start the thread that advances the virtual replay clock and updates the devices on it */
+  void StartReplayClock(const std::vector<DeviceCollection>& startupGroups, double startTime);
+
+  /*! Stop advancing the replay clock, the devices on the replay clock are not updated anymore */
+  void StopReplayClock();
+
+  /*! Advance the replay clock in steps and update the devices whose update is due, in startup order */
+  void ReplayClockThreadMain(DeviceCollection devices, double startTime, double stepSec);
+
+  /*! Maximum time to wait for the first items in the buffers after the devices are started */
+  double StartupTimeoutSec;
+
+  /*! Time to wait after the devices are started for the timestamp filtering to settle */
   double StartupDelaySec;
 
+  /*! Connect and start devices concurrently */
+  bool ParallelStartup;
+
+  /*! Lock the process memory while data collection is started */
+  bool LockMemory;
+  /*! True if the process memory has been locked by Start */
+  bool MemoryLocked;
+
+  /*! Memory budget in MB for the buffers of all data sources, 0 if the buffer sizes are not managed */
+  double MemoryBudgetMB;
+
+  /*! Time source of the devices during replay */
+  ReplayClock Clock;
+
+  /*! Time step of a virtual replay clock, 0 if it is determined from the acquisition rates of the devices */
+  double ReplayStepSec;
+
+  std::thread ReplayClockThread;
+  std::atomic<bool> ReplayClockStopRequested;
+
+  /*! Time of the step after the last replayed step of a virtual clock, 0 if the clock has not run yet. The replay continues from here when restarted. */
+  double ReplayClockStopTime;
+
   vtkSmartPointer<vtkPlusDeviceFactory> DeviceFactory;
 
   DeviceCollection Devices;
@@ -401,6 +401,19 @@ PlusStatus vtkPlusDataSource::ReadConfiguration(vtkXMLDataElement* sourceElement
     LOG_DEBUG("AveragedItemsForFiltering is not defined in source element \"" << this->GetId() << "\". Using default value: " << this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  double timestampFilteringOutlierThresholdSec = 0;
+  if (sourceElement->GetScalarAttribute("TimestampFilteringOutlierThresholdSec", timestampFilteringOutlierThresholdSec))
+  {
+    this->GetBuffer()->SetTimestampFilteringOutlierThresholdSec(timestampFilteringOutlierThresholdSec);
+  }
+  else
+  {
+    LOG_DEBUG("TimestampFilteringOutlierThresholdSec is not defined in source element \"" << this->GetId() << "\". Using default value: " << this->GetBuffer()->GetTimestampFilteringOutlierThresholdSec());
+  }
+
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(FrameMemoryHugePages, sourceElement);
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(ContiguousFrameMemory, sourceElement);
+
   std::string descName;
   if (!aDescriptiveNameForBuffer.empty())
   {
@@ -414,6 +427,27 @@ PlusStatus vtkPlusDataSource::ReadConfiguration(vtkXMLDataElement* sourceElement
   }
   this->GetBuffer()->SetDescriptiveName(descName.c_str());
 
+  // Spill file names contain the descriptive name, so spilling is enabled after it is set
+  const char* spillDirectory = sourceElement->GetAttribute("SpillDirectory");
+  if (spillDirectory != NULL)
+  {
+    this->GetBuffer()->SetSpillDirectory(spillDirectory);
+  }
+
+  int spillSegmentSizeMB = 0;
+  if (sourceElement->GetScalarAttribute("SpillSegmentSizeMB", spillSegmentSizeMB))
+  {
+    this->GetBuffer()->SetSpillSegmentSizeMB(spillSegmentSizeMB);
+  }
+
+  int spillMaxSizeMB = 0;
+  if (sourceElement->GetScalarAttribute("SpillMaxSizeMB", spillMaxSizeMB))
+  {
+    this->GetBuffer()->SetSpillMaxSizeMB(spillMaxSizeMB);
+  }
+
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(SpillToDisk, sourceElement);
+
   // Read custom properties
   for (int i = 0; i < sourceElement->GetNumberOfNestedElements(); ++i)
   {
@@ -462,6 +496,41 @@ PlusStatus vtkPlusDataSource::WriteConfiguration(vtkXMLDataElement* aSourceEleme
     aSourceElement->SetIntAttribute("AveragedItemsForFiltering", this->GetBuffer()->GetAveragedItemsForFiltering());
   }
 
+  if (aSourceElement->GetAttribute("TimestampFilteringOutlierThresholdSec") != NULL)
+  {
+    aSourceElement->SetDoubleAttribute("TimestampFilteringOutlierThresholdSec", this->GetBuffer()->GetTimestampFilteringOutlierThresholdSec());
+  }
+
+  if (aSourceElement->GetAttribute("ContiguousFrameMemory") != NULL)
+  {
+    aSourceElement->SetAttribute("ContiguousFrameMemory", this->GetBuffer()->GetContiguousFrameMemory() ? "TRUE" : "FALSE");
+  }
+
+  if (aSourceElement->GetAttribute("FrameMemoryHugePages") != NULL)
+  {
+    aSourceElement->SetAttribute("FrameMemoryHugePages", this->GetBuffer()->GetFrameMemoryHugePages() ? "TRUE" : "FALSE");
+  }
+
+  if (aSourceElement->GetAttribute("SpillToDisk") != NULL)
+  {
+    aSourceElement->SetAttribute("SpillToDisk", this->GetBuffer()->GetSpillToDisk() ? "TRUE" : "FALSE");
+  }
+
+  if (aSourceElement->GetAttribute("SpillDirectory") != NULL)
+  {
+    aSourceElement->SetAttribute("SpillDirectory", this->GetBuffer()->GetSpillDirectory().c_str());
+  }
+
+  if (aSourceElement->GetAttribute("SpillSegmentSizeMB") != NULL)
+  {
+    aSourceElement->SetIntAttribute("SpillSegmentSizeMB", this->GetBuffer()->GetSpillSegmentSizeMB());
+  }
+
+  if (aSourceElement->GetAttribute("SpillMaxSizeMB") != NULL)
+  {
+    aSourceElement->SetIntAttribute("SpillMaxSizeMB", this->GetBuffer()->GetSpillMaxSizeMB());
+  }
+
   // Write custom properties
   if (this->CustomProperties.size() > 0)
   {
@@ -579,6 +648,15 @@ PlusStatus vtkPlusDataSource::AddItem(void* imageDataPtr, const FrameSizeType& f
   return this->GetBuffer()->AddItem(imageDataPtr, frameSize, frameSizeInBytes, imageType, frameNumber, unfilteredTimestamp, filteredTimestamp, customFields);
 }
 
+//----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::AddNativeItem(const void* nativeDataPtr, unsigned int nativeDataSizeInBytes, unsigned int nativeFourCC, US_IMAGE_ORIENTATION usImageOrientation,
+    const FrameSizeType& frameSizeInPx, US_IMAGE_TYPE imageType, long frameNumber, double unfilteredTimestamp /*= UNDEFINED_TIMESTAMP*/,
+    double filteredTimestamp /*= UNDEFINED_TIMESTAMP*/, const igsioFieldMapType* customFields /*= NULL*/)
+{
+  return this->GetBuffer()->AddNativeItem(nativeDataPtr, nativeDataSizeInBytes, nativeFourCC, usImageOrientation, frameSizeInPx, imageType, frameNumber,
+                                          this->ClipRectangleOrigin, this->ClipRectangleSize, unfilteredTimestamp, filteredTimestamp, customFields);
+}
+
 //-----------------------------------------------------------------------------
 US_IMAGE_TYPE vtkPlusDataSource::GetImageType()
 {
@@ -831,6 +909,36 @@ ItemStatus vtkPlusDataSource::GetStreamBufferItemFromTime(double time, StreamBuf
   return this->GetBuffer()->GetStreamBufferItemFromTime(time, bufferItem, interpolation);
 }
 
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::PrepareInterpolatedStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, PoseInterpolator& interpolator, int& poseIndex)
+{
+  return this->GetBuffer()->PrepareInterpolatedStreamBufferItemFromTime(time, bufferItem, interpolator, poseIndex);
+}
+
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::CompleteInterpolatedStreamBufferItem(StreamBufferItem* bufferItem, const PoseInterpolator& interpolator, int poseIndex)
+{
+  return this->GetBuffer()->CompleteInterpolatedStreamBufferItem(bufferItem, interpolator, poseIndex);
+}
+
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& view)
+{
+  return this->GetBuffer()->GetStreamBufferItemView(uid, view);
+}
+
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::GetLatestStreamBufferItemView(StreamBufferItemView& view)
+{
+  return this->GetBuffer()->GetLatestStreamBufferItemView(view);
+}
+
+//-----------------------------------------------------------------------------
+ItemStatus vtkPlusDataSource::GetStreamBufferItemViewFromTime(double time, StreamBufferItemView& view)
+{
+  return this->GetBuffer()->GetStreamBufferItemViewFromTime(time, view);
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDataSource::ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value)
 {
@@ -855,6 +963,42 @@ int vtkPlusDataSource::GetBufferSize()
   return this->GetBuffer()->GetBufferSize();
 }
 
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::SetContiguousFrameMemory(bool enable)
+{
+  return this->GetBuffer()->SetContiguousFrameMemory(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetContiguousFrameMemory()
+{
+  return this->GetBuffer()->GetContiguousFrameMemory();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::SetFrameMemoryHugePages(bool enable)
+{
+  return this->GetBuffer()->SetFrameMemoryHugePages(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetFrameMemoryHugePages()
+{
+  return this->GetBuffer()->GetFrameMemoryHugePages();
+}
+
+//-----------------------------------------------------------------------------
+PlusStatus vtkPlusDataSource::SetSpillToDisk(bool enable)
+{
+  return this->GetBuffer()->SetSpillToDisk(enable);
+}
+
+//-----------------------------------------------------------------------------
+bool vtkPlusDataSource::GetSpillToDisk()
+{
+  return this->GetBuffer()->GetSpillToDisk();
+}
+
 //-----------------------------------------------------------------------------
 ItemStatus vtkPlusDataSource::GetLatestTimeStamp(double& latestTimestamp)
 {
@@ -903,6 +1047,18 @@ bool vtkPlusDataSource::GetTimeStampReporting()
   return this->GetBuffer()->GetTimeStampReporting();
 }
 
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::AddNewDataNotifier(vtkPlusNewDataNotifier* notifier)
+{
+  this->GetBuffer()->AddNewDataNotifier(notifier);
+}
+
+//-----------------------------------------------------------------------------
+void vtkPlusDataSource::RemoveNewDataNotifier(vtkPlusNewDataNotifier* notifier)
+{
+  this->GetBuffer()->RemoveNewDataNotifier(notifier);
+}
+
 //-----------------------------------------------------------------------------
 PlusStatus vtkPlusDataSource::WriteToSequenceFile(const char* filename, bool useCompression /*= false */)
 {
@@ -30,6 +30,7 @@
 */
 
 class vtkPlusBuffer;
+class vtkPlusNewDataNotifier;
 
 enum DataSourceType
 {
@@ -140,6 +141,16 @@ public:
   virtual ItemStatus GetOldestStreamBufferItem(StreamBufferItem* bufferItem);
   /*! Get a frame that was acquired at the specified time from buffer */
   virtual ItemStatus GetStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, vtkPlusBuffer::DataItemTemporalInterpolationType interpolation);
+  /*! Get an interpolated frame without computing the interpolated pose, for batched interpolation of multiple tools (see vtkPlusBuffer) */
+  virtual ItemStatus PrepareInterpolatedStreamBufferItemFromTime(double time, StreamBufferItem* bufferItem, PoseInterpolator& interpolator, int& poseIndex);
+  /*! Set the interpolated pose in a frame that was prepared by PrepareInterpolatedStreamBufferItemFromTime */
+  virtual ItemStatus CompleteInterpolatedStreamBufferItem(StreamBufferItem* bufferItem, const PoseInterpolator& interpolator, int poseIndex);
+  /*! Get a zero-copy view of a frame with the specified frame uid from the buffer */
+  virtual ItemStatus GetStreamBufferItemView(BufferItemUidType uid, StreamBufferItemView& view);
+  /*! Get a zero-copy view of the most recent frame from the buffer */
+  virtual ItemStatus GetLatestStreamBufferItemView(StreamBufferItemView& view);
+  /*! Get a zero-copy view of the frame that is the closest to the specified time */
+  virtual ItemStatus GetStreamBufferItemViewFromTime(double time, StreamBufferItemView& view);
   /*! Update a field in the specified stream buffer item */
   virtual PlusStatus ModifyBufferItemFrameField(BufferItemUidType uid, const std::string& key, const std::string& value);
 
@@ -160,6 +171,11 @@ public:
   /*! If TimeStampReporting is enabled then all filtered and unfiltered timestamp values will be saved in a table for diagnostic purposes. */
   bool GetTimeStampReporting();
 
+  /*! Register a notifier that is notified each time a new item is added to the buffer of this data source */
+  void AddNewDataNotifier(vtkPlusNewDataNotifier* notifier);
+  /*! Unregister a notifier that was registered by AddNewDataNotifier */
+  void RemoveNewDataNotifier(vtkPlusNewDataNotifier* notifier);
+
   /*!
     Set the size of the buffer, i.e. the maximum number of
     video frames that it will hold.  The default is 30.
@@ -168,6 +184,18 @@ public:
   /*! Get the size of the buffer */
   virtual int GetBufferSize();
 
+  /*! Store the frames of the buffer in a single preallocated memory slab (see vtkPlusBuffer::SetContiguousFrameMemory) */
+  PlusStatus SetContiguousFrameMemory(bool enable);
+  bool GetContiguousFrameMemory();
+
+  /*! Back the frame memory slab by huge pages if available (see vtkPlusBuffer::SetFrameMemoryHugePages) */
+  PlusStatus SetFrameMemoryHugePages(bool enable);
+  bool GetFrameMemoryHugePages();
+
+  /*! Store the items that are removed from the buffer on disk (see vtkPlusBuffer::SetSpillToDisk) */
+  PlusStatus SetSpillToDisk(bool enable);
+  bool GetSpillToDisk();
+
   /*! Get latest timestamp in the buffer */
   virtual ItemStatus GetLatestTimeStamp(double& latestTimestamp);
 
@@ -253,6 +281,21 @@ public:
   */
   virtual PlusStatus AddItem(const igsioFieldMapType& customFields, long frameNumber, double unfilteredTimestamp = UNDEFINED_TIMESTAMP, double filteredTimestamp = UNDEFINED_TIMESTAMP);
 
+  /*!
+    Add a frame in the native pixel encoding of the device (identified by a FourCC code, see PixelCodec::GetFourCC).
+    The frame is converted to the pixel format of the source when it is read first.
+  */
+  virtual PlusStatus AddNativeItem(const void* nativeDataPtr,
+                                   unsigned int nativeDataSizeInBytes,
+                                   unsigned int nativeFourCC,
+                                   US_IMAGE_ORIENTATION usImageOrientation,
+                                   const FrameSizeType& frameSizeInPx,
+                                   US_IMAGE_TYPE imageType,
+                                   long frameNumber,
+                                   double unfilteredTimestamp = UNDEFINED_TIMESTAMP,
+                                   double filteredTimestamp = UNDEFINED_TIMESTAMP,
+                                   const igsioFieldMapType* customFields = NULL);
+
   /*!
   Add a matrix plus status to the list, with an exactly known timestamp value (e.g., provided by a high-precision hardware timer).
   If the timestamp is less than or equal to the previous timestamp, then nothing  will be done.
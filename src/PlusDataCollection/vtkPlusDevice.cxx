@@ -6,6 +6,7 @@ See License.txt for details.
 
 // Local includes
 #include "PlusConfigure.h"
+#include "PlusReplayClock.h"
 #include "vtkPlusBuffer.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataSource.h"
@@ -13,6 +14,7 @@ See License.txt for details.
 #include "vtkIGSIORecursiveCriticalSection.h"
 #include "vtkPlusSequenceIO.h"
 #include "vtkIGSIOTrackedFrameList.h"
+#include "PixelCodecKernels.h"
 
 // VTK includes
 #include <vtkImageData.h>
@@ -139,8 +141,15 @@ vtkPlusDevice::vtkPlusDevice()
   , OutputNeedsInitialization(1)
   , CorrectlyConfigured(true)
   , StartThreadForInternalUpdates(false)
+  , WakeOnInputData(false)
+  , InputDataNotifier(vtkSmartPointer<vtkPlusNewDataNotifier>::New())
+  , CaptureThreadSchedulingPolicy(ThreadScheduling::SCHEDULING_POLICY_DEFAULT)
+  , CaptureThreadPriority(50)
+  , CaptureThreadCatchUpPolicy(PeriodicScheduler::CATCH_UP_SKIP)
+  , PixelConversionNumberOfThreads(0)
   , LocalTimeOffsetSec(0.0)
   , MissingInputGracePeriodSec(0.0)
+  , Clock(NULL)
   , RequireImageOrientationInConfiguration(false)
   , RequirePortNameInDeviceSetConfiguration(false)
 {
@@ -200,6 +209,34 @@ void vtkPlusDevice::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "SDK version: " << this->GetSdkVersion() << std::endl;
   os << indent << "AcquisitionRate: " << this->AcquisitionRate << std::endl;
   os << indent << "Recording: " << (this->Recording ? "On\n" : "Off\n");
+  os << indent << "PixelConversionNumberOfThreads: " << this->PixelConversionNumberOfThreads << std::endl;
+  if (this->StartThreadForInternalUpdates)
+  {
+    std::string captureThreadScheduling = this->GetCaptureThreadScheduling();
+    os << indent << "CaptureThreadScheduling: " << (captureThreadScheduling.empty() ? "(not started)" : captureThreadScheduling) << std::endl;
+    os << indent << "CaptureThreadCatchUpPolicy: " << (this->CaptureThreadCatchUpPolicy == PeriodicScheduler::CATCH_UP_BURST ? "BURST" : "SKIP") << std::endl;
+    os << indent << "CaptureThreadUpdates: " << this->CaptureThreadScheduler.GetNumberOfUpdates() << std::endl;
+    os << indent << "CaptureThreadMissedDeadlines: " << this->CaptureThreadScheduler.GetNumberOfMissedDeadlines() << std::endl;
+    std::vector<unsigned long long> histogram;
+    this->CaptureThreadScheduler.GetExecutionTimeHistogram(histogram);
+    os << indent << "CaptureThreadExecutionTimeHistogram:" << std::endl;
+    for (int i = 0; i < static_cast<int>(histogram.size()); ++i)
+    {
+      if (histogram[i] == 0)
+      {
+        continue;
+      }
+      double upperLimitSec = PeriodicScheduler::GetHistogramBinUpperLimitSec(i);
+      if (upperLimitSec < 0)
+      {
+        os << indent << indent << ">= " << PeriodicScheduler::GetHistogramBinUpperLimitSec(i - 1) * 1000.0 << " ms: " << histogram[i] << std::endl;
+      }
+      else
+      {
+        os << indent << indent << "< " << upperLimitSec * 1000.0 << " ms: " << histogram[i] << std::endl;
+      }
+    }
+  }
 
   for (ChannelContainerConstIterator it = this->OutputChannels.begin(); it != this->OutputChannels.end(); ++it)
   {
@@ -964,6 +1001,33 @@ PlusStatus vtkPlusDevice::ReadConfiguration(vtkXMLDataElement* rootXMLElement)
     deviceXMLElement->GetScalarAttribute("MissingInputGracePeriodSec", this->MissingInputGracePeriodSec);
   }
 
+  XML_READ_BOOL_ATTRIBUTE_OPTIONAL(WakeOnInputData, deviceXMLElement);
+
+  const char* captureThreadCpuAffinity = deviceXMLElement->GetAttribute("CaptureThreadCpuAffinity");
+  if (captureThreadCpuAffinity != NULL && ThreadScheduling::ParseCpuList(captureThreadCpuAffinity, this->CaptureThreadCpuAffinity) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_ERROR("Invalid CaptureThreadCpuAffinity attribute: " << captureThreadCpuAffinity);
+    return PLUS_FAIL;
+  }
+  XML_READ_ENUM3_ATTRIBUTE_OPTIONAL(CaptureThreadSchedulingPolicy, deviceXMLElement,
+                                    "DEFAULT", ThreadScheduling::SCHEDULING_POLICY_DEFAULT,
+                                    "FIFO", ThreadScheduling::SCHEDULING_POLICY_FIFO,
+                                    "RR", ThreadScheduling::SCHEDULING_POLICY_RR);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, CaptureThreadPriority, deviceXMLElement);
+  if (deviceXMLElement->GetAttribute("LockMemory") != NULL)
+  {
+    LOCAL_LOG_WARNING("LockMemory attribute of the device is ignored, memory locking applies to the whole process and it is set in the DataCollection element");
+  }
+  XML_READ_ENUM2_ATTRIBUTE_OPTIONAL(CaptureThreadCatchUpPolicy, deviceXMLElement,
+                                    "SKIP", PeriodicScheduler::CATCH_UP_SKIP,
+                                    "BURST", PeriodicScheduler::CATCH_UP_BURST);
+  XML_READ_SCALAR_ATTRIBUTE_OPTIONAL(int, PixelConversionNumberOfThreads, deviceXMLElement);
+  if (this->PixelConversionNumberOfThreads < 0)
+  {
+    LOCAL_LOG_ERROR("Invalid PixelConversionNumberOfThreads attribute: " << this->PixelConversionNumberOfThreads << ". It must not be negative.");
+    return PLUS_FAIL;
+  }
+
   vtkXMLDataElement* dataSourcesElement = deviceXMLElement->FindNestedElementWithName("DataSources");
   if (dataSourcesElement != NULL)
   {
@@ -1201,6 +1265,15 @@ PlusStatus vtkPlusDevice::WriteConfiguration(vtkXMLDataElement* config)
     deviceDataElement->SetDoubleAttribute("LocalTimeOffsetSec", this->GetLocalTimeOffsetSec());
   }
 
+  if (this->PixelConversionNumberOfThreads > 0)
+  {
+    deviceDataElement->SetIntAttribute("PixelConversionNumberOfThreads", this->PixelConversionNumberOfThreads);
+  }
+  else
+  {
+    deviceDataElement->RemoveAttribute("PixelConversionNumberOfThreads");
+  }
+
   // Parameters writing
   XML_FIND_NESTED_ELEMENT_CREATE_IF_MISSING(parameterList, deviceDataElement, PARAMETERS_XML_ELEMENT_TAG.c_str());
 
@@ -1234,6 +1307,11 @@ PlusStatus vtkPlusDevice::Connect()
   // We will report unknown tools after each Connect
   this->ReportedUnknownTools.clear();
 
+  if (this->PixelConversionNumberOfThreads > 0 && PixelCodecKernels::RequestNumberOfThreads(this->PixelConversionNumberOfThreads) != PLUS_SUCCESS)
+  {
+    LOCAL_LOG_WARNING("Failed to start " << this->PixelConversionNumberOfThreads << " pixel conversion threads, frames are converted on fewer threads");
+  }
+
   if (this->InternalConnect() != PLUS_SUCCESS)
   {
     LOCAL_LOG_ERROR("Cannot connect to device, ConnectInternal failed");
@@ -1295,11 +1373,19 @@ PlusStatus vtkPlusDevice::StartRecording()
     return PLUS_FAIL;
   }
 
-  this->RecordingStartTime = vtkIGSIOAccurateTimer::GetSystemTime();
+  this->RecordingStartTime = this->GetClockTime();
   this->Recording = 1;
 
-  if (this->StartThreadForInternalUpdates)
+  // Devices on a virtual replay clock are updated by the data collector
+  if (this->StartThreadForInternalUpdates && !this->IsDrivenByReplayClock())
   {
+    if (this->WakeOnInputData)
+    {
+      for (ChannelContainerIterator it = this->InputChannels.begin(); it != this->InputChannels.end(); ++it)
+      {
+        (*it)->AddNewDataNotifier(this->InputDataNotifier);
+      }
+    }
     this->ThreadId =
       this->Threader->SpawnThread((vtkThreadFunctionType)\
                                   &vtkDataCaptureThread, this);
@@ -1326,9 +1412,11 @@ PlusStatus vtkPlusDevice::StopRecording()
   this->ThreadId = -1;
   this->Recording = 0;
 
-  if (this->GetStartThreadForInternalUpdates())
+  if (this->GetStartThreadForInternalUpdates() && !this->IsDrivenByReplayClock())
   {
     LOCAL_LOG_DEBUG("Wait for internal update thread to terminate");
+    // Wake up the thread if it is waiting for input data
+    this->InputDataNotifier->Notify();
     // Let's give a chance to the thread to stop before we kill the connection
     while (this->ThreadAlive)
     {
@@ -1336,6 +1424,10 @@ PlusStatus vtkPlusDevice::StopRecording()
     }
     this->ThreadId = -1;
     LOCAL_LOG_DEBUG("Internal update thread terminated");
+    for (ChannelContainerIterator it = this->InputChannels.begin(); it != this->InputChannels.end(); ++it)
+    {
+      (*it)->RemoveNewDataNotifier(this->InputDataNotifier);
+    }
   }
 
   if (this->InternalStopRecording() != PLUS_SUCCESS)
@@ -1358,6 +1450,35 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
   double rate = self->GetAcquisitionRate();
   double currtime[FRAME_RATE_AVERAGING] = {0};
   unsigned long updatecount = 0;
+  bool waitForInputData = self->WakeOnInputData && !self->InputChannels.empty();
+  unsigned long long inputDataSequenceNumber = self->InputDataNotifier->GetSequenceNumber();
+
+  // Scheduling must be applied by the thread itself
+  const bool customScheduling = !self->CaptureThreadCpuAffinity.empty()
+                                || self->CaptureThreadSchedulingPolicy != ThreadScheduling::SCHEDULING_POLICY_DEFAULT;
+  if (customScheduling)
+  {
+    ThreadScheduling::ApplyToCurrentThread(self->CaptureThreadCpuAffinity, self->CaptureThreadSchedulingPolicy, self->CaptureThreadPriority);
+  }
+  {
+    igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(self->UpdateMutex);
+    self->CaptureThreadScheduling = ThreadScheduling::GetCurrentThreadScheduling();
+  }
+  if (customScheduling)
+  {
+    LOG_INFO("Data capture thread of device " << self->GetDeviceId() << " runs with scheduling: " << self->GetCaptureThreadScheduling());
+  }
+
+  // Updates are scheduled at absolute deadlines, so the execution time of the updates does not make the rate drift
+  PeriodicScheduler& scheduler = self->CaptureThreadScheduler;
+  if (rate > 0)
+  {
+    scheduler.SetPeriodSec(1.0 / rate);
+  }
+  scheduler.SetCatchUpPolicy(self->CaptureThreadCatchUpPolicy);
+  scheduler.ResetStatistics();
+  scheduler.Start();
+
   self->ThreadAlive = true;
 
   while (self->IsRecording() && self->GetCorrectlyConfigured())
@@ -1379,14 +1500,21 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
         // recording has been stopped
         break;
       }
+      scheduler.BeginUpdate();
       self->InternalUpdate();
+      scheduler.EndUpdate();
       self->UpdateTime.Modified();
     }
 
-    double delay = (newtime + 1.0 / rate - vtkIGSIOAccurateTimer::GetSystemTime());
-    if (delay > 0)
+    if (waitForInputData)
+    {
+      // Returns immediately if input data has been added since the last update
+      self->InputDataNotifier->WaitForNewData(inputDataSequenceNumber, scheduler.GetTimeToNextDeadlineSec());
+      scheduler.AdvanceIfDeadlineReached();
+    }
+    else
     {
-      vtkIGSIOAccurateTimer::Delay(delay);
+      scheduler.WaitForNextDeadline();
     }
 
     updatecount++;
@@ -1396,6 +1524,13 @@ void* vtkPlusDevice::vtkDataCaptureThread(vtkMultiThreader::ThreadInfo* data)
   return NULL;
 }
 
+//----------------------------------------------------------------------------
+std::string vtkPlusDevice::GetCaptureThreadScheduling()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  return this->CaptureThreadScheduling;
+}
+
 //----------------------------------------------------------------------------
 PlusStatus vtkPlusDevice::InternalConnect()
 {
@@ -2288,6 +2423,18 @@ ChannelContainerIterator vtkPlusDevice::GetOutputChannelsEnd()
   return this->OutputChannels.end();
 }
 
+//----------------------------------------------------------------------------
+ChannelContainerConstIterator vtkPlusDevice::GetInputChannelsStart() const
+{
+  return this->InputChannels.begin();
+}
+
+//----------------------------------------------------------------------------
+ChannelContainerConstIterator vtkPlusDevice::GetInputChannelsEnd() const
+{
+  return this->InputChannels.end();
+}
+
 //------------------------------------------------------------------------------
 PlusStatus vtkPlusDevice::GetToolReferenceFrameFromTrackedFrame(igsioTrackedFrame& aFrame, std::string& aToolReferenceFrameName)
 {
@@ -2361,7 +2508,55 @@ void vtkPlusDevice::SetDataCollector(vtkPlusDataCollector* _arg)
 //------------------------------------------------------------------------------
 bool vtkPlusDevice::HasGracePeriodExpired()
 {
-  return (vtkIGSIOAccurateTimer::GetSystemTime() - this->RecordingStartTime) > this->MissingInputGracePeriodSec;
+  return (this->GetClockTime() - this->RecordingStartTime) > this->MissingInputGracePeriodSec;
+}
+
+//------------------------------------------------------------------------------
+void vtkPlusDevice::SetReplayClock(ReplayClock* clock)
+{
+  if (this->Recording)
+  {
+    LOG_ERROR("The replay clock of device " << this->GetDeviceId() << " cannot be changed while recording");
+    return;
+  }
+  this->Clock = clock;
+}
+
+//------------------------------------------------------------------------------
+ReplayClock* vtkPlusDevice::GetReplayClock() const
+{
+  return this->Clock;
+}
+
+//------------------------------------------------------------------------------
+bool vtkPlusDevice::IsDrivenByReplayClock() const
+{
+  return this->Clock != NULL && this->Clock->IsVirtual();
+}
+
+//------------------------------------------------------------------------------
+double vtkPlusDevice::GetClockTime() const
+{
+  if (this->Clock == NULL)
+  {
+    return vtkIGSIOAccurateTimer::GetSystemTime();
+  }
+  return this->Clock->GetTime();
+}
+
+//------------------------------------------------------------------------------
+PlusStatus vtkPlusDevice::UpdateOnReplayClock()
+{
+  igsioLockGuard<vtkIGSIORecursiveCriticalSection> updateMutexGuardedLock(this->UpdateMutex);
+  if (!this->Recording || !this->GetCorrectlyConfigured())
+  {
+    return PLUS_SUCCESS;
+  }
+  this->CaptureThreadScheduler.BeginUpdate();
+  PlusStatus status = this->InternalUpdate();
+  this->CaptureThreadScheduler.EndUpdate();
+  this->UpdateTime.Modified();
+  return status;
 }
 
 //----------------------------------------------------------------------------
@@ -10,9 +10,12 @@ See License.txt for details.
 // Local includes
 #include "igsioCommon.h"
 #include "PlusConfigure.h"
+#include "PlusPeriodicScheduler.h"
 #include "PlusStreamBufferItem.h"
+#include "PlusThreadScheduling.h"
 #include "vtkPlusChannel.h"
 #include "vtkPlusDataCollectionExport.h"
+#include "vtkPlusNewDataNotifier.h"
 
 // VTK includes
 #include <vtkImageAlgorithm.h>
@@ -30,6 +33,7 @@ class vtkPlusDataSource;
 class vtkPlusDevice;
 class vtkPlusHTMLGenerator;
 class vtkXMLDataElement;
+class ReplayClock;
 
 typedef std::vector<vtkPlusChannel*> ChannelContainer;
 typedef ChannelContainer::const_iterator ChannelContainerConstIterator;
@@ -243,6 +247,22 @@ public:
   /*! Set the parent data collector */
   virtual void SetDataCollector(vtkPlusDataCollector* _arg);
 
+  /*!
+    Set the clock that the device takes the current time from (not owned). If the clock is virtual then the device
+    does not start a data capture thread when recording is started, the data collector updates it on the replay clock instead.
+  */
+  void SetReplayClock(ReplayClock* clock);
+  ReplayClock* GetReplayClock() const;
+
+  /*! Returns true if the device is updated by the data collector on a virtual replay clock */
+  bool IsDrivenByReplayClock() const;
+
+  /*! Current time of the device: the time of the replay clock if it is set, otherwise the system time */
+  double GetClockTime() const;
+
+  /*! Run a single update of the device on the calling thread. Used by the data collector to update the devices on a virtual replay clock. */
+  PlusStatus UpdateOnReplayClock();
+
   /*! Set buffer size of all available tools */
   void SetToolsBufferSize(int aBufferSize);
 
@@ -394,6 +414,9 @@ public:
   /*! Add an input channel */
   PlusStatus AddInputChannel(vtkPlusChannel* aChannel);
 
+  ChannelContainerConstIterator GetInputChannelsStart() const;
+  ChannelContainerConstIterator GetInputChannelsEnd() const;
+
   /*!
   Perform any completion tasks once configured
   */
@@ -415,6 +438,59 @@ public:
   vtkSetMacro(MissingInputGracePeriodSec, double);
   double GetMissingInputGracePeriodSec() const;
 
+  /*!
+    If enabled, then the data capture thread calls InternalUpdate as soon as new data is added to any of the input channels
+    (and at least at the acquisition rate) instead of polling at the acquisition rate. Must be set before recording is started.
+    Enabled by default in virtual capture and volume reconstructor devices.
+  */
+  vtkSetMacro(WakeOnInputData, bool);
+  vtkGetMacro(WakeOnInputData, bool);
+  vtkBooleanMacro(WakeOnInputData, bool);
+
+  /*!
+    IDs of the CPUs that the data capture thread may run on. If empty then the thread may run on any CPU.
+    Must be set before recording is started. Only supported on Linux.
+  */
+  void SetCaptureThreadCpuAffinity(const std::vector<int>& cpuIds) { this->CaptureThreadCpuAffinity = cpuIds; }
+  const std::vector<int>& GetCaptureThreadCpuAffinity() const { return this->CaptureThreadCpuAffinity; }
+
+  /*! Scheduling policy of the data capture thread. Must be set before recording is started. Only supported on Linux. */
+  vtkSetMacro(CaptureThreadSchedulingPolicy, ThreadScheduling::SchedulingPolicy);
+  vtkGetMacro(CaptureThreadSchedulingPolicy, ThreadScheduling::SchedulingPolicy);
+
+  /*! Real-time priority of the data capture thread, used if the scheduling policy is FIFO or RR */
+  vtkSetMacro(CaptureThreadPriority, int);
+  vtkGetMacro(CaptureThreadPriority, int);
+
+  /*! Get the scheduling policy, priority and CPU affinity that the data capture thread actually runs with. Empty if the thread is not started. */
+  std::string GetCaptureThreadScheduling();
+
+  /*!
+    Catch-up policy of the data capture thread when an update takes longer than the acquisition period.
+    SKIP drops the missed updates, BURST runs them back-to-back. Must be set before recording is started.
+  */
+  vtkSetMacro(CaptureThreadCatchUpPolicy, PeriodicScheduler::CatchUpPolicy);
+  vtkGetMacro(CaptureThreadCatchUpPolicy, PeriodicScheduler::CatchUpPolicy);
+
+  /*!
+    Number of threads that the pixel conversions of large frames (e.g., YUY2 to grayscale) need at the acquisition rate of the device.
+    0 (default) does not request any threads, so frames are converted on the thread that adds them.
+    The setting has a process-wide effect: the worker pool that performs the conversions is shared by all devices (and all
+    data collectors) of the process, and it is grown to the largest number requested when a device is connected.
+    The pool never shrinks, disconnecting the device or decreasing this value does not stop the already started threads.
+  */
+  vtkSetMacro(PixelConversionNumberOfThreads, int);
+  vtkGetMacro(PixelConversionNumberOfThreads, int);
+
+  /*! Get the number of acquisition deadlines that the data capture thread missed since recording was started */
+  unsigned long long GetCaptureThreadMissedDeadlines() const { return this->CaptureThreadScheduler.GetNumberOfMissedDeadlines(); }
+
+  /*!
+    Get the histogram of the InternalUpdate execution times since recording was started.
+    The upper limits of the bins are provided by PeriodicScheduler::GetHistogramBinUpperLimitSec.
+  */
+  void GetCaptureThreadExecutionTimeHistogram(std::vector<unsigned long long>& binCounts) const { this->CaptureThreadScheduler.GetExecutionTimeHistogram(binCounts); }
+
   /*!
     Creates a default output channel for the device with the name channelId or "OutputChannel".
     \param addSource If true then for imaging devices a default 'Video' source is added to the output.
@@ -585,6 +661,27 @@ protected:
   */
   bool StartThreadForInternalUpdates;
 
+  /*! If enabled, then the data capture thread is woken up when new data is added to the input channels */
+  bool WakeOnInputData;
+
+  /*! Registered in the input channels if WakeOnInputData is enabled */
+  vtkSmartPointer<vtkPlusNewDataNotifier> InputDataNotifier;
+
+  /*! Requested scheduling of the data capture thread */
+  std::vector<int> CaptureThreadCpuAffinity;
+  ThreadScheduling::SchedulingPolicy CaptureThreadSchedulingPolicy;
+  int CaptureThreadPriority;
+
+  /*! Scheduling that the data capture thread actually runs with, set by the thread. Protected by UpdateMutex. */
+  std::string CaptureThreadScheduling;
+
+  /*! Schedules the updates of the data capture thread and collects timing statistics */
+  PeriodicScheduler CaptureThreadScheduler;
+  PeriodicScheduler::CatchUpPolicy CaptureThreadCatchUpPolicy;
+
+  /*! Number of threads requested from the shared pixel conversion worker pool when the device is connected */
+  int PixelConversionNumberOfThreads;
+
   /*! Value to use when mixing data with another temporally calibrated device*/
   double LocalTimeOffsetSec;
 
@@ -593,6 +690,9 @@ protected:
   /*! Adjust the device reporting behaviour depending on whether or not a grace period has expired */
   double RecordingStartTime;
 
+  /*! Clock that the current time is taken from, NULL if the system time is used */
+  ReplayClock* Clock;
+
   /*!
     The list contains the IDs of the tools that have been already reported to be unknown.
     This list is used to only report an unknown tool once (after the connection has been established), not at each
@@ -0,0 +1,68 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#include "PlusConfigure.h"
+#include "vtkPlusNewDataNotifier.h"
+
+// VTK includes
+#include <vtkObjectFactory.h>
+
+// STL includes
+#include <chrono>
+
+//----------------------------------------------------------------------------
+
+vtkStandardNewMacro(vtkPlusNewDataNotifier);
+
+//----------------------------------------------------------------------------
+vtkPlusNewDataNotifier::vtkPlusNewDataNotifier()
+  : SequenceNumber(0)
+{
+}
+
+//----------------------------------------------------------------------------
+vtkPlusNewDataNotifier::~vtkPlusNewDataNotifier()
+{
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusNewDataNotifier::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "SequenceNumber: " << this->GetSequenceNumber() << std::endl;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusNewDataNotifier::Notify()
+{
+  {
+    std::lock_guard<std::mutex> lock(this->Mutex);
+    this->SequenceNumber++;
+  }
+  this->NewDataCondition.notify_all();
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vtkPlusNewDataNotifier::GetSequenceNumber()
+{
+  std::lock_guard<std::mutex> lock(this->Mutex);
+  return this->SequenceNumber;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusNewDataNotifier::WaitForNewData(unsigned long long& lastSequenceNumber, double timeoutSec)
+{
+  std::unique_lock<std::mutex> lock(this->Mutex);
+  if (timeoutSec > 0)
+  {
+    unsigned long long waitedSequenceNumber = lastSequenceNumber;
+    this->NewDataCondition.wait_for(lock, std::chrono::duration<double>(timeoutSec),
+                                    [this, waitedSequenceNumber] { return this->SequenceNumber != waitedSequenceNumber; });
+  }
+  bool newDataAvailable = (this->SequenceNumber != lastSequenceNumber);
+  lastSequenceNumber = this->SequenceNumber;
+  return newDataAvailable;
+}
@@ -0,0 +1,62 @@
+/*=Plus=header=begin======================================================
+  Program: Plus
+  Copyright (c) Laboratory for Percutaneous Surgery. All rights reserved.
+  See License.txt for details.
+=========================================================Plus=header=end*/
+
+#ifndef __vtkPlusNewDataNotifier_h
+#define __vtkPlusNewDataNotifier_h
+
+#include "vtkPlusDataCollectionExport.h"
+
+#include <vtkObject.h>
+
+// STL includes
+#include <condition_variable>
+#include <mutex>
+
+/*!
+  \class vtkPlusNewDataNotifier
+  \brief Allows a data consumer to sleep until new data is added to any of the buffers that it observes
+
+  The notifier is registered in one or more buffers (directly or through vtkPlusDataSource and vtkPlusChannel).
+  Each time an item is added to any of these buffers, the sequence number of the notifier is incremented and
+  all threads that are waiting for new data are woken up. Consumers remember the last sequence number that they
+  have seen, therefore no notification is lost if data arrives while the consumer is busy processing.
+
+  \ingroup PlusLibDataCollection
+*/
+class vtkPlusDataCollectionExport vtkPlusNewDataNotifier : public vtkObject
+{
+public:
+  static vtkPlusNewDataNotifier* New();
+  vtkTypeMacro(vtkPlusNewDataNotifier, vtkObject);
+  virtual void PrintSelf(ostream& os, vtkIndent indent) VTK_OVERRIDE;
+
+  /*! Signal that new data is available, wake up all waiting threads. Called by the buffers when a new item is added. */
+  void Notify();
+
+  /*! Get the current sequence number. It is incremented each time Notify is called. */
+  unsigned long long GetSequenceNumber();
+
+  /*!
+    Wait until the sequence number differs from lastSequenceNumber or the timeout expires.
+    lastSequenceNumber is updated to the current sequence number.
+    \return true if new data has been notified since lastSequenceNumber, false on timeout
+  */
+  bool WaitForNewData(unsigned long long& lastSequenceNumber, double timeoutSec);
+
+protected:
+  vtkPlusNewDataNotifier();
+  virtual ~vtkPlusNewDataNotifier();
+
+  std::mutex Mutex;
+  std::condition_variable NewDataCondition;
+  unsigned long long SequenceNumber;
+
+private:
+  vtkPlusNewDataNotifier(const vtkPlusNewDataNotifier&);  // Not implemented.
+  void operator=(const vtkPlusNewDataNotifier&);  // Not implemented.
+};
+
+#endif
@@ -12,6 +12,10 @@ See License.txt for details.
 #include "vtkTable.h"
 #include "vtkVariantArray.h"
 
+#include <algorithm>
+
+static const int MAX_INTERPOLATION_SEARCH_PROBES = 8; // if the item is not found in this many probes by interpolation search then bisection is used
+
 vtkStandardNewMacro(vtkPlusTimestampedCircularBuffer);
 
 //----------------------------------------------------------------------------
@@ -22,7 +26,26 @@ vtkPlusTimestampedCircularBuffer::vtkPlusTimestampedCircularBuffer()
   , CurrentTimeStamp(0.0)
   , LocalTimeOffsetSec(0.0)
   , LatestItemUid(0)
+  , NumberOfPins(0)
+  , LockFreeReading(true)
+  , InterpolationSearch(true)
+  , PublishSequence(0)
+  , PublishedLatestItemUid(0)
+  , PublishedNumberOfItems(0)
+  , PublishedWritePointer(0)
+  , PublishedLocalTimeOffsetSec(0.0)
+  , PublishedTimestamps(NULL)
   , AveragedItemsForFiltering(20)
+  , IncrementalTimestampFiltering(true)
+  , FilterSumX(0.0)
+  , FilterSumY(0.0)
+  , FilterSumXX(0.0)
+  , FilterSumXY(0.0)
+  , FilterReferenceIndex(0.0)
+  , FilterReferenceTimestamp(0.0)
+  , FilterSamplesSinceRecompute(0)
+  , TimestampFilteringOutlierThresholdSec(0.0)
+  , FilterNumberOfConsecutiveOutliers(0)
   , MaxAllowedFilteringTimeDifference(0.5)
   , TimeStampReportTable(NULL)
   , TimeStampReporting(false)
@@ -35,12 +58,30 @@ vtkPlusTimestampedCircularBuffer::vtkPlusTimestampedCircularBuffer()
   this->FilterContainerTimestampVector.set_size(0);
   this->FilterContainersOldestIndex = 0;
   this->FilterContainersNumberOfValidElements = 0;
+  this->PublishState();
 }
 
 //----------------------------------------------------------------------------
 vtkPlusTimestampedCircularBuffer::~vtkPlusTimestampedCircularBuffer()
 {
   this->BufferItemContainer.clear();
+  this->PinCountContainer.clear();
+  // The items may refer to the retained memory, so it is released after the items
+  this->RetainedResources.clear();
+
+  for (std::vector<PublishedTimestampArray*>::iterator it = this->RetiredTimestampArrays.begin(); it != this->RetiredTimestampArrays.end(); ++it)
+  {
+    delete[](*it)->Timestamps;
+    delete *it;
+  }
+  this->RetiredTimestampArrays.clear();
+  PublishedTimestampArray* timestamps = this->PublishedTimestamps.load();
+  if (timestamps != NULL)
+  {
+    delete[] timestamps->Timestamps;
+    delete timestamps;
+  }
+  this->PublishedTimestamps = NULL;
 
   this->NumberOfItems = 0;
   if (this->Mutex != NULL)
@@ -80,6 +121,13 @@ PlusStatus vtkPlusTimestampedCircularBuffer::PrepareForNewItem(const double time
     return PLUS_FAIL;
   }
 
+  if (this->WritePointer < static_cast<int>(this->PinCountContainer.size()) && this->PinCountContainer[this->WritePointer] > 0)
+  {
+    // The slot holds the oldest item, which is still being read through a frame view
+    LOG_WARNING("Need to skip newly added frame - the oldest item in the buffer is still in use. Consider increasing the buffer size.");
+    return PLUS_FAIL;
+  }
+
   // Increase frame unique ID
   newFrameUid = ++this->LatestItemUid;
   bufferIndex = this->WritePointer;
@@ -96,9 +144,184 @@ PlusStatus vtkPlusTimestampedCircularBuffer::PrepareForNewItem(const double time
     this->WritePointer = 0;
   }
 
+  this->PublishNewItem(bufferIndex, timestamp);
+
   return PLUS_SUCCESS;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishState()
+{
+  // the caller must have locked the buffer
+  const int bufferSize = this->GetBufferSize();
+  PublishedTimestampArray* previousTimestamps = this->PublishedTimestamps.load(std::memory_order_relaxed);
+  PublishedTimestampArray* timestamps = previousTimestamps;
+  if (timestamps == NULL || timestamps->Size != bufferSize)
+  {
+    this->ReleaseRetiredTimestampArrays();
+    timestamps = new PublishedTimestampArray;
+    timestamps->Size = bufferSize;
+    timestamps->Timestamps = new std::atomic<double>[bufferSize];
+  }
+
+  unsigned int sequence = this->PublishSequence.load(std::memory_order_relaxed);
+  this->PublishSequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  for (int i = 0; i < bufferSize; ++i)
+  {
+    timestamps->Timestamps[i].store(this->BufferItemContainer[i].GetFilteredTimestamp(0), std::memory_order_relaxed);
+  }
+  this->PublishedTimestamps.store(timestamps, std::memory_order_release);
+  this->PublishedLatestItemUid.store(this->LatestItemUid, std::memory_order_relaxed);
+  this->PublishedNumberOfItems.store(this->NumberOfItems, std::memory_order_relaxed);
+  this->PublishedWritePointer.store(this->WritePointer, std::memory_order_relaxed);
+  this->PublishedLocalTimeOffsetSec.store(this->LocalTimeOffsetSec, std::memory_order_relaxed);
+
+  this->PublishSequence.store(sequence + 2, std::memory_order_release);
+
+  if (previousTimestamps != NULL && previousTimestamps != timestamps)
+  {
+    // Readers may still use the previous array, it is deleted at the next resize
+    this->RetiredTimestampArrays.push_back(previousTimestamps);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::ReleaseRetiredTimestampArrays()
+{
+  // the caller must have locked the buffer
+  // The arrays were retired by the previous resize. A lock-free read takes a few hundred nanoseconds and
+  // resizes happen at configuration time, so no reader can still use an array that was replaced two resizes ago.
+  // Readers do not have to register themselves, so they do not contend on a shared counter.
+  for (std::vector<PublishedTimestampArray*>::iterator it = this->RetiredTimestampArrays.begin(); it != this->RetiredTimestampArrays.end(); ++it)
+  {
+    delete[](*it)->Timestamps;
+    delete *it;
+  }
+  this->RetiredTimestampArrays.clear();
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PublishNewItem(int bufferIndex, double filteredTimestamp)
+{
+  // the caller must have locked the buffer
+  PublishedTimestampArray* timestamps = this->PublishedTimestamps.load(std::memory_order_relaxed);
+
+  unsigned int sequence = this->PublishSequence.load(std::memory_order_relaxed);
+  this->PublishSequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  if (bufferIndex >= 0 && bufferIndex < timestamps->Size)
+  {
+    timestamps->Timestamps[bufferIndex].store(filteredTimestamp, std::memory_order_relaxed);
+  }
+  this->PublishedLatestItemUid.store(this->LatestItemUid, std::memory_order_relaxed);
+  this->PublishedNumberOfItems.store(this->NumberOfItems, std::memory_order_relaxed);
+  this->PublishedWritePointer.store(this->WritePointer, std::memory_order_relaxed);
+
+  this->PublishSequence.store(sequence + 2, std::memory_order_release);
+}
+
+//----------------------------------------------------------------------------
+unsigned int vtkPlusTimestampedCircularBuffer::BeginRead()
+{
+  unsigned int sequence = this->PublishSequence.load(std::memory_order_acquire);
+  while (sequence & 1)
+  {
+    // a writer is updating the state, it only takes a few stores
+    sequence = this->PublishSequence.load(std::memory_order_acquire);
+  }
+  return sequence;
+}
+
+//----------------------------------------------------------------------------
+bool vtkPlusTimestampedCircularBuffer::EndRead(unsigned int sequence)
+{
+  std::atomic_thread_fence(std::memory_order_acquire);
+  return this->PublishSequence.load(std::memory_order_relaxed) == sequence;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusTimestampedCircularBuffer::GetNumberOfItems()
+{
+  if (!this->LockFreeReading)
+  {
+    igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+    return this->NumberOfItems;
+  }
+  return this->PublishedNumberOfItems.load(std::memory_order_acquire);
+}
+
+//----------------------------------------------------------------------------
+BufferItemUidType vtkPlusTimestampedCircularBuffer::GetLatestItemUidInBuffer()
+{
+  if (!this->LockFreeReading)
+  {
+    igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+    return this->LatestItemUid;
+  }
+  return this->PublishedLatestItemUid.load(std::memory_order_acquire);
+}
+
+//----------------------------------------------------------------------------
+BufferItemUidType vtkPlusTimestampedCircularBuffer::GetOldestItemUidInBuffer()
+{
+  if (!this->LockFreeReading)
+  {
+    igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+    // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
+    return this->LatestItemUid - (this->NumberOfItems - 1);
+  }
+  for (;;)
+  {
+    unsigned int sequence = this->BeginRead();
+    BufferItemUidType oldestUid = this->PublishedLatestItemUid.load(std::memory_order_relaxed) - (this->PublishedNumberOfItems.load(std::memory_order_relaxed) - 1);
+    if (this->EndRead(sequence))
+    {
+      return oldestUid;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetOldestTimeStamp(double& timestamp)
+{
+  if (!this->LockFreeReading)
+  {
+    // The oldest item may be removed from the buffer at any moment
+    // therefore we need to retrieve its UID and timestamp within a single lock
+    igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+    // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
+    BufferItemUidType oldestUid = (this->LatestItemUid - (this->NumberOfItems - 1));
+    return this->GetPublishedFilteredTimeStamp(oldestUid, timestamp);
+  }
+  for (;;)
+  {
+    // UID and timestamp are retrieved from the same state
+    unsigned int sequence = this->BeginRead();
+    BufferItemUidType oldestUid = this->PublishedLatestItemUid.load(std::memory_order_relaxed) - (this->PublishedNumberOfItems.load(std::memory_order_relaxed) - 1);
+    ItemStatus status = this->GetPublishedFilteredTimeStamp(oldestUid, timestamp);
+    if (this->EndRead(sequence))
+    {
+      return status;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::SetLocalTimeOffsetSec(double offsetSec)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (this->LocalTimeOffsetSec == offsetSec)
+  {
+    return;
+  }
+  this->LocalTimeOffsetSec = offsetSec;
+  this->PublishState();
+  this->Modified();
+}
+
 //----------------------------------------------------------------------------
 // Sets the buffer size, and copies the maximum number of the most current old
 // frames and timestamps
@@ -117,6 +340,13 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
     return PLUS_SUCCESS;
   }
 
+  if (this->NumberOfPins > 0)
+  {
+    // Resizing the container would invalidate the item pointers held by the views
+    LOG_ERROR("SetBufferSize: buffer cannot be resized while " << this->NumberOfPins << " item views refer to its items");
+    return PLUS_FAIL;
+  }
+
   if (this->GetBufferSize() == 0)
   {
     for (int i = 0; i < newBufferSize; i++)
@@ -161,6 +391,11 @@ PlusStatus vtkPlusTimestampedCircularBuffer::SetBufferSize(int newBufferSize)
     this->NumberOfItems = this->GetBufferSize();
   }
 
+  // there are no pinned items, so all the counters can be reset
+  this->PinCountContainer.assign(this->GetBufferSize(), 0);
+
+  this->PublishState();
+
   this->Modified();
 
   return PLUS_SUCCESS;
@@ -192,6 +427,66 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromUid(const B
   return ITEM_OK;
 }
 
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::PinBufferItem(const BufferItemUidType uid, StreamBufferItem*& itemPtr, int& bufferIndex)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  bufferIndex = -1;
+  ItemStatus status = this->GetBufferItemPointerFromUid(uid, itemPtr);
+  if (status != ITEM_OK)
+  {
+    return status;
+  }
+  bufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - uid);
+  if (bufferIndex < 0)
+  {
+    bufferIndex += this->BufferItemContainer.size();
+  }
+  this->PinCountContainer[bufferIndex]++;
+  this->NumberOfPins++;
+  return ITEM_OK;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::PinBufferIndex(const int bufferIndex)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (bufferIndex < 0 || bufferIndex >= static_cast<int>(this->PinCountContainer.size()) || this->PinCountContainer[bufferIndex] == 0)
+  {
+    LOG_ERROR("Failed to pin buffer item - slot is not pinned already (bufferIndex: " << bufferIndex << ").");
+    return;
+  }
+  this->PinCountContainer[bufferIndex]++;
+  this->NumberOfPins++;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::UnpinBufferIndex(const int bufferIndex)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (bufferIndex < 0 || bufferIndex >= static_cast<int>(this->PinCountContainer.size()) || this->PinCountContainer[bufferIndex] == 0)
+  {
+    LOG_ERROR("Failed to unpin buffer item - slot is not pinned (bufferIndex: " << bufferIndex << ").");
+    return;
+  }
+  this->PinCountContainer[bufferIndex]--;
+  this->NumberOfPins--;
+}
+
+//----------------------------------------------------------------------------
+int vtkPlusTimestampedCircularBuffer::GetNumberOfPins()
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  return this->NumberOfPins;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::RetainUntilDeleted(const std::shared_ptr<void>& resource)
+{
+  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  this->RetainedResources.push_back(resource);
+}
+
 //----------------------------------------------------------------------------
 StreamBufferItem* vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromBufferIndex(const int bufferIndex)
 {
@@ -209,16 +504,51 @@ StreamBufferItem* vtkPlusTimestampedCircularBuffer::GetBufferItemPointerFromBuff
 //----------------------------------------------------------------------------
 ItemStatus vtkPlusTimestampedCircularBuffer::GetFilteredTimeStamp(const BufferItemUidType uid, double& filteredTimestamp)
 {
-  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
-  StreamBufferItem* itemPtr = NULL;
-  ItemStatus status = GetBufferItemPointerFromUid(uid, itemPtr);
-  if (status != ITEM_OK)
+  if (!this->LockFreeReading)
   {
-    filteredTimestamp = 0;
-    return status;
+    igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+    return this->GetPublishedFilteredTimeStamp(uid, filteredTimestamp);
   }
-  filteredTimestamp = itemPtr->GetFilteredTimestamp(this->LocalTimeOffsetSec);
-  return status;
+  for (;;)
+  {
+    unsigned int sequence = this->BeginRead();
+    ItemStatus status = this->GetPublishedFilteredTimeStamp(uid, filteredTimestamp);
+    if (this->EndRead(sequence))
+    {
+      return status;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+ItemStatus vtkPlusTimestampedCircularBuffer::GetPublishedFilteredTimeStamp(const BufferItemUidType uid, double& filteredTimestamp)
+{
+  // The values may be inconsistent if the caller does not lock the buffer, but they must never be used for out of range access
+  filteredTimestamp = 0;
+  const BufferItemUidType latestUid = this->PublishedLatestItemUid.load(std::memory_order_relaxed);
+  const int numberOfItems = this->PublishedNumberOfItems.load(std::memory_order_relaxed);
+  const int writePointer = this->PublishedWritePointer.load(std::memory_order_relaxed);
+  PublishedTimestampArray* timestamps = this->PublishedTimestamps.load(std::memory_order_acquire);
+
+  if (numberOfItems < 1 || uid > latestUid)
+  {
+    return ITEM_NOT_AVAILABLE_YET;
+  }
+  if (latestUid - uid >= static_cast<BufferItemUidType>(numberOfItems))
+  {
+    return ITEM_NOT_AVAILABLE_ANYMORE;
+  }
+  int bufferIndex = (writePointer - 1) - static_cast<int>(latestUid - uid);
+  if (bufferIndex < 0)
+  {
+    bufferIndex += timestamps->Size;
+  }
+  if (bufferIndex < 0 || bufferIndex >= timestamps->Size)
+  {
+    return ITEM_UNKNOWN_ERROR;
+  }
+  filteredTimestamp = timestamps->Timestamps[bufferIndex].load(std::memory_order_relaxed) + this->PublishedLocalTimeOffsetSec.load(std::memory_order_relaxed);
+  return ITEM_OK;
 }
 
 //----------------------------------------------------------------------------
@@ -310,38 +640,78 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetBufferIndexFromTime(const double
 }
 
 //----------------------------------------------------------------------------
-// do a simple divide-and-conquer search for the transform
-// that best matches the given timestamp
 ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double time, BufferItemUidType& uid)
 {
-  igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+  if (!this->LockFreeReading)
+  {
+    igsioLockGuard< vtkPlusTimestampedCircularBuffer > bufferGuardedLock(this);
+    return this->FindPublishedItemUidFromTime(time, uid);
+  }
+  for (;;)
+  {
+    unsigned int sequence = this->BeginRead();
+    ItemStatus status = this->FindPublishedItemUidFromTime(time, uid);
+    if (this->EndRead(sequence))
+    {
+      return status;
+    }
+  }
+}
 
-  if (this->NumberOfItems == 1)
+//----------------------------------------------------------------------------
+// Items are acquired at a nearly constant rate (this is the same linear model that is used for timestamp filtering),
+// therefore the UID of the item can be predicted from the mean item period between the oldest and latest items
+// and usually only the predicted and a neighbor item has to be checked.
+// If the prediction is inaccurate (e.g., because of dropped items) then a simple divide-and-conquer search is
+// used for finding the item that best matches the given timestamp.
+ItemStatus vtkPlusTimestampedCircularBuffer::FindPublishedItemUidFromTime(const double time, BufferItemUidType& uid)
+{
+  // The values may be inconsistent if the caller does not lock the buffer, but they must never be used for out of range access
+  const BufferItemUidType latestUid = this->PublishedLatestItemUid.load(std::memory_order_relaxed);
+  const int numberOfItems = this->PublishedNumberOfItems.load(std::memory_order_relaxed);
+  const int writePointer = this->PublishedWritePointer.load(std::memory_order_relaxed);
+  const double localTimeOffsetSec = this->PublishedLocalTimeOffsetSec.load(std::memory_order_relaxed);
+  PublishedTimestampArray* timestamps = this->PublishedTimestamps.load(std::memory_order_acquire);
+
+  if (numberOfItems < 1 || numberOfItems > timestamps->Size)
+  {
+    return ITEM_NOT_AVAILABLE_YET;
+  }
+
+  if (numberOfItems == 1)
   {
     // There is only one item, it's the closest one to any timestamp
-    uid = this->LatestItemUid;
+    uid = latestUid;
     return ITEM_OK;
   }
 
-  BufferItemUidType lo = this->LatestItemUid - (this->NumberOfItems - 1);   // oldest item UID
-  BufferItemUidType hi = this->LatestItemUid; // latest item UID
+  BufferItemUidType lo = latestUid - (numberOfItems - 1);   // oldest item UID
+  BufferItemUidType hi = latestUid; // latest item UID
 
   // minimum time
   // This method is called often, therefore instead of calling this->GetTimeStamp(lo, tlo) we perform low-level operations to get the timestamp
-  int loBufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - lo);
+  int loBufferIndex = (writePointer - 1) - (numberOfItems - 1);
   if (loBufferIndex < 0)
   {
-    loBufferIndex += this->BufferItemContainer.size();
+    loBufferIndex += timestamps->Size;
+  }
+  if (loBufferIndex < 0 || loBufferIndex >= timestamps->Size)
+  {
+    return ITEM_UNKNOWN_ERROR;
   }
-  double tlo = this->BufferItemContainer[loBufferIndex].GetFilteredTimestamp(this->LocalTimeOffsetSec);
+  double tlo = timestamps->Timestamps[loBufferIndex].load(std::memory_order_relaxed) + localTimeOffsetSec;
 
   // This method is called often, therefore instead of calling this->GetTimeStamp(hi, thi) we perform low-level operations to get the timestamp
-  int hiBufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - hi);
+  int hiBufferIndex = (writePointer - 1);
   if (hiBufferIndex < 0)
   {
-    hiBufferIndex += this->BufferItemContainer.size();
+    hiBufferIndex += timestamps->Size;
   }
-  double thi = this->BufferItemContainer[hiBufferIndex].GetFilteredTimestamp(this->LocalTimeOffsetSec);
+  if (hiBufferIndex < 0 || hiBufferIndex >= timestamps->Size)
+  {
+    return ITEM_UNKNOWN_ERROR;
+  }
+  double thi = timestamps->Timestamps[hiBufferIndex].load(std::memory_order_relaxed) + localTimeOffsetSec;
 
   // If the timestamp is slightly out of range then still accept it
   // (due to errors in conversions there could be slight differences)
@@ -354,6 +724,8 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double tim
     return ITEM_NOT_AVAILABLE_YET;
   }
 
+  int remainingInterpolationProbes = (this->InterpolationSearch ? MAX_INTERPOLATION_SEARCH_PROBES : 0);
+  bool hiMoved = false;
   for (;;)
   {
     if (hi - lo <= 1)
@@ -370,28 +742,54 @@ ItemStatus vtkPlusTimestampedCircularBuffer::GetItemUidFromTime(const double tim
       }
     }
 
-    int mid = (lo + hi) / 2;
+    BufferItemUidType mid = (lo + hi) / 2;
+    if (remainingInterpolationProbes == MAX_INTERPOLATION_SEARCH_PROBES)
+    {
+      // first probe: predict the UID from the mean item period
+      if (thi > tlo)
+      {
+        double ratio = (time - tlo) / (thi - tlo);
+        ratio = std::max(0.0, std::min(1.0, ratio));
+        mid = lo + static_cast<BufferItemUidType>(ratio * (hi - lo) + 0.5);
+      }
+    }
+    else if (remainingInterpolationProbes > 0)
+    {
+      // step towards the item from the side where the previous probe was
+      mid = (hiMoved ? hi - 1 : lo + 1);
+    }
+    if (remainingInterpolationProbes > 0)
+    {
+      remainingInterpolationProbes--;
+      // lo and hi are already checked, the probe must be between them
+      mid = std::max(lo + 1, std::min(hi - 1, mid));
+    }
 
     // This is a hot loop, therefore instead of calling this->GetTimeStamp(mid, tmid) we perform low-level operations to get the timestamp
-    int midBufferIndex = (this->WritePointer - 1) - (this->LatestItemUid - mid);
+    int midBufferIndex = (writePointer - 1) - static_cast<int>(latestUid - mid);
     if (midBufferIndex < 0)
     {
-      midBufferIndex += this->BufferItemContainer.size();
+      midBufferIndex += timestamps->Size;
+    }
+    if (midBufferIndex < 0 || midBufferIndex >= timestamps->Size)
+    {
+      return ITEM_UNKNOWN_ERROR;
     }
-    double tmid = this->BufferItemContainer[midBufferIndex].GetFilteredTimestamp(this->LocalTimeOffsetSec);
+    double tmid = timestamps->Timestamps[midBufferIndex].load(std::memory_order_relaxed) + localTimeOffsetSec;
 
     if (time < tmid)
     {
       hi = mid;
       thi = tmid;
+      hiMoved = true;
     }
     else
     {
       lo = mid;
       tlo = tmid;
+      hiMoved = false;
     }
   }
-
 }
 
 //----------------------------------------------------------------------------
@@ -399,6 +797,13 @@ void vtkPlusTimestampedCircularBuffer::DeepCopy(vtkPlusTimestampedCircularBuffer
 {
   buffer->Lock();
   this->Lock();
+  if (this->NumberOfPins > 0)
+  {
+    LOG_ERROR("DeepCopy: buffer cannot be overwritten while " << this->NumberOfPins << " item views refer to its items");
+    this->Unlock();
+    buffer->Unlock();
+    return;
+  }
   this->WritePointer = buffer->WritePointer;
   this->NumberOfItems = buffer->NumberOfItems;
   this->CurrentTimeStamp = buffer->CurrentTimeStamp;
@@ -410,8 +815,21 @@ void vtkPlusTimestampedCircularBuffer::DeepCopy(vtkPlusTimestampedCircularBuffer
   this->FilterContainersOldestIndex = buffer->FilterContainersOldestIndex;
   this->FilterContainerTimestampVector = buffer->FilterContainerTimestampVector;
   this->FilterContainerIndexVector = buffer->FilterContainerIndexVector;
+  this->IncrementalTimestampFiltering = buffer->IncrementalTimestampFiltering;
+  this->FilterSumX = buffer->FilterSumX;
+  this->FilterSumY = buffer->FilterSumY;
+  this->FilterSumXX = buffer->FilterSumXX;
+  this->FilterSumXY = buffer->FilterSumXY;
+  this->FilterReferenceIndex = buffer->FilterReferenceIndex;
+  this->FilterReferenceTimestamp = buffer->FilterReferenceTimestamp;
+  this->FilterSamplesSinceRecompute = buffer->FilterSamplesSinceRecompute;
+  this->TimestampFilteringOutlierThresholdSec = buffer->TimestampFilteringOutlierThresholdSec;
+  this->FilterNumberOfConsecutiveOutliers = buffer->FilterNumberOfConsecutiveOutliers;
 
   this->BufferItemContainer = buffer->BufferItemContainer;
+  // pins are owned by the views of the source buffer, they are not copied
+  this->PinCountContainer.assign(this->BufferItemContainer.size(), 0);
+  this->PublishState();
   this->Unlock();
   buffer->Unlock();
 }
@@ -424,6 +842,7 @@ void vtkPlusTimestampedCircularBuffer::Clear()
   this->NumberOfItems = 0;
   this->CurrentTimeStamp = 0;
   this->LatestItemUid = 0;
+  this->PublishState();
   this->Unlock();
 }
 
@@ -523,6 +942,33 @@ double vtkPlusTimestampedCircularBuffer::GetFrameRate(bool ideal /*=false*/, dou
   return frameRate;
 }
 
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::ResetFilterSums()
+{
+  this->FilterSumX = 0;
+  this->FilterSumY = 0;
+  this->FilterSumXX = 0;
+  this->FilterSumXY = 0;
+  this->FilterSamplesSinceRecompute = 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::RecomputeFilterSums(unsigned int latestSampleIndex)
+{
+  this->ResetFilterSums();
+  this->FilterReferenceIndex = this->FilterContainerIndexVector(latestSampleIndex);
+  this->FilterReferenceTimestamp = this->FilterContainerTimestampVector(latestSampleIndex);
+  for (unsigned int i = 0; i < this->FilterContainersNumberOfValidElements; i++)
+  {
+    double x = this->FilterContainerIndexVector(i) - this->FilterReferenceIndex;
+    double y = this->FilterContainerTimestampVector(i) - this->FilterReferenceTimestamp;
+    this->FilterSumX += x;
+    this->FilterSumY += y;
+    this->FilterSumXX += x * x;
+    this->FilterSumXY += x * y;
+  }
+}
+
 //----------------------------------------------------------------------------
 // for accurate timing of the frame: an exponential moving average
 // is computed to smooth out the jitter in the times that are returned by the system clock:
@@ -539,11 +985,68 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     this->FilterContainerTimestampVector.set_size(this->AveragedItemsForFiltering);
     this->FilterContainersOldestIndex = 0;
     this->FilterContainersNumberOfValidElements = 0;
+    this->FilterNumberOfConsecutiveOutliers = 0;
+    this->ResetFilterSums();
+  }
+
+  // Optionally, items that are far from the line fitted to the previous items are not used for fitting,
+  // so that a single badly timed item does not distort the filtered timestamps of the following items.
+  bool outlier = false;
+  if (this->TimestampFilteringOutlierThresholdSec > 0 && this->AveragedItemsForFiltering > 1
+      && this->FilterContainersNumberOfValidElements >= this->AveragedItemsForFiltering)
+  {
+    double a = 0;
+    double b = 0;
+    this->GetFilterLineParameters(a, b);
+    if (fabs(a * itemIndex + b - inUnfilteredTimestamp) > this->TimestampFilteringOutlierThresholdSec)
+    {
+      outlier = true;
+      this->FilterNumberOfConsecutiveOutliers++;
+      if (this->FilterNumberOfConsecutiveOutliers > this->AveragedItemsForFiltering / 2)
+      {
+        // Most of the recent items do not fit the line, the acquisition timing probably changed: restart fitting
+        LOG_DEBUG("Timestamp filtering is restarted, as " << this->FilterNumberOfConsecutiveOutliers << " consecutive items did not fit the filtering line");
+        this->FilterContainersOldestIndex = 0;
+        this->FilterContainersNumberOfValidElements = 0;
+        this->FilterNumberOfConsecutiveOutliers = 0;
+        this->ResetFilterSums();
+        outlier = false;
+      }
+    }
+    else
+    {
+      this->FilterNumberOfConsecutiveOutliers = 0;
+    }
   }
 
   // We store the last AveragedItemsForFiltering unfiltered timestamp and item indexes, because these are used for computing the filtered timestamp.
-  if (this->AveragedItemsForFiltering > 1)
+  if (this->AveragedItemsForFiltering > 1 && !outlier)
   {
+    if (this->FilterContainersNumberOfValidElements == 0)
+    {
+      // Sums are computed relative to a reference sample to avoid loss of precision (timestamps and item indexes can be large numbers)
+      this->ResetFilterSums();
+      this->FilterReferenceIndex = itemIndex;
+      this->FilterReferenceTimestamp = inUnfilteredTimestamp;
+    }
+    else if (this->FilterContainersNumberOfValidElements >= this->AveragedItemsForFiltering)
+    {
+      // Remove the oldest sample from the sums
+      double oldestX = this->FilterContainerIndexVector(this->FilterContainersOldestIndex) - this->FilterReferenceIndex;
+      double oldestY = this->FilterContainerTimestampVector(this->FilterContainersOldestIndex) - this->FilterReferenceTimestamp;
+      this->FilterSumX -= oldestX;
+      this->FilterSumY -= oldestY;
+      this->FilterSumXX -= oldestX * oldestX;
+      this->FilterSumXY -= oldestX * oldestY;
+    }
+    double newX = itemIndex - this->FilterReferenceIndex;
+    double newY = inUnfilteredTimestamp - this->FilterReferenceTimestamp;
+    this->FilterSumX += newX;
+    this->FilterSumY += newY;
+    this->FilterSumXX += newX * newX;
+    this->FilterSumXY += newX * newY;
+
+    unsigned int newSampleIndex = this->FilterContainersOldestIndex;
     this->FilterContainerIndexVector(this->FilterContainersOldestIndex) = itemIndex;
     this->FilterContainerTimestampVector[this->FilterContainersOldestIndex] = inUnfilteredTimestamp;
     this->FilterContainersNumberOfValidElements++;
@@ -558,6 +1061,14 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     {
       this->FilterContainersOldestIndex = 0;
     }
+
+    // Rounding errors accumulate in the running sums, therefore they are recomputed from scratch
+    // after every AveragedItemsForFiltering samples (this keeps the amortized cost constant)
+    this->FilterSamplesSinceRecompute++;
+    if (this->FilterSamplesSinceRecompute >= this->AveragedItemsForFiltering)
+    {
+      this->RecomputeFilterSums(newSampleIndex);
+    }
   }
 
   // If we don't have enough unfiltered timestamps or we don't want to use afiltering then just use the unfiltered timestamps
@@ -569,6 +1080,36 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     return PLUS_SUCCESS;
   }
 
+  double a = 0;
+  double b = 0;
+  this->GetFilterLineParameters(a, b);
+  outFilteredTimestamp = a * itemIndex + b;
+
+  if (this->TimeStampLogging)
+  {
+    LOG_TRACE("timestamps = [" << std::fixed << this->FilterContainerTimestampVector << "];");
+    LOG_TRACE("frameindexes = [" << std::fixed << this->FilterContainerIndexVector << "];");
+  }
+
+  AddToTimeStampReport(itemIndex, inUnfilteredTimestamp, outFilteredTimestamp);
+
+  if (fabs(outFilteredTimestamp - inUnfilteredTimestamp) > this->MaxAllowedFilteringTimeDifference)
+  {
+    // Write current timestamps and frame indexes to the log to allow investigation of the problem
+    filteredTimestampProbablyValid = false;
+    LOG_DEBUG("Difference between unfiltered timestamp is larger than the threshold. The unfiltered timestamp may be incorrect."
+              << " Unfiltered timestamp: " << inUnfilteredTimestamp << ", filtered timestamp: " << outFilteredTimestamp << ", difference: " << fabs(outFilteredTimestamp - inUnfilteredTimestamp) << ", threshold: " << this->MaxAllowedFilteringTimeDifference << "."
+              << " timestamps = [" << std::fixed << this->FilterContainerTimestampVector << "];"
+              << " frameindexes = [" << std::fixed << this->FilterContainerIndexVector << "];");
+  }
+
+  this->Unlock();
+  return PLUS_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+void vtkPlusTimestampedCircularBuffer::GetFilterLineParameters(double& framePeriod, double& timeOffset)
+{
   // The items are acquired periodically, with quite accurate frame periods. The data is not timestamped
   // by the source, only Plus attaches a timestamp when it receives the data. The timestamp that Plus attaches
   // (the unfiltered timestamp) may be inaccurate, due to random delays in transferring the data.
@@ -590,6 +1131,22 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
   //   a = sum( (x(i)-xMean) * (y(i)-yMean) ) / sum( (x(i)-xMean) * (x(i)-xMean) )
   //   b = yMean - a*xMean
   //
+  // With incremental filtering the sums are computed from running sums of x, y, x*x, x*y (relative to a reference sample),
+  // which are updated in constant time when an item is added and the oldest one is removed:
+  //   sum( (x(i)-xMean) * (y(i)-yMean) ) = sumXY - sumX * sumY / n
+  //   sum( (x(i)-xMean) * (x(i)-xMean) ) = sumXX - sumX * sumX / n
+  //
+
+  if (this->IncrementalTimestampFiltering)
+  {
+    double n = this->FilterContainersNumberOfValidElements;
+    double covarianceXY = this->FilterSumXY - this->FilterSumX * this->FilterSumY / n;
+    double varianceX = this->FilterSumXX - this->FilterSumX * this->FilterSumX / n;
+    framePeriod = covarianceXY / varianceX;
+    // convert the offset from relative to absolute values
+    timeOffset = (this->FilterSumY - framePeriod * this->FilterSumX) / n + this->FilterReferenceTimestamp - framePeriod * this->FilterReferenceIndex;
+    return;
+  }
 
   double xMean = this->FilterContainerIndexVector.mean();
   double yMean = this->FilterContainerTimestampVector.mean();
@@ -601,31 +1158,8 @@ PlusStatus vtkPlusTimestampedCircularBuffer::CreateFilteredTimeStampForItem(unsi
     covarianceXY += xiMinusXmean * (this->FilterContainerTimestampVector(i) - yMean);
     varianceX += xiMinusXmean * xiMinusXmean;
   }
-  double a = covarianceXY / varianceX;
-  double b = yMean - a * xMean;
-
-  outFilteredTimestamp = a * itemIndex + b;
-
-  if (this->TimeStampLogging)
-  {
-    LOG_TRACE("timestamps = [" << std::fixed << this->FilterContainerTimestampVector << "];");
-    LOG_TRACE("frameindexes = [" << std::fixed << this->FilterContainerIndexVector << "];");
-  }
-
-  AddToTimeStampReport(itemIndex, inUnfilteredTimestamp, outFilteredTimestamp);
-
-  if (fabs(outFilteredTimestamp - inUnfilteredTimestamp) > this->MaxAllowedFilteringTimeDifference)
-  {
-    // Write current timestamps and frame indexes to the log to allow investigation of the problem
-    filteredTimestampProbablyValid = false;
-    LOG_DEBUG("Difference between unfiltered timestamp is larger than the threshold. The unfiltered timestamp may be incorrect."
-              << " Unfiltered timestamp: " << inUnfilteredTimestamp << ", filtered timestamp: " << outFilteredTimestamp << ", difference: " << fabs(outFilteredTimestamp - inUnfilteredTimestamp) << ", threshold: " << this->MaxAllowedFilteringTimeDifference << "."
-              << " timestamps = [" << std::fixed << this->FilterContainerTimestampVector << "];"
-              << " frameindexes = [" << std::fixed << this->FilterContainerIndexVector << "];");
-  }
-
-  this->Unlock();
-  return PLUS_SUCCESS;
+  framePeriod = covarianceXY / varianceX;
+  timeOffset = yMean - framePeriod * xMean;
 }
 
 //----------------------------------------------------------------------------
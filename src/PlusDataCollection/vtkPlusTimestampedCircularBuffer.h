@@ -10,7 +10,10 @@
 #include "PlusConfigure.h"
 #include "PlusStreamBufferItem.h"
 #include "vtkObject.h"
+#include <atomic>
 #include <deque>
+#include <memory>
+#include <vector>
 
 #include "vnl/vnl_matrix.h"
 #include "vnl/vnl_vector.h"
@@ -32,6 +35,10 @@ enum ItemStatus { ITEM_OK, ITEM_NOT_AVAILABLE_YET, ITEM_NOT_AVAILABLE_ANYMORE, I
   \class vtkPlusTimestampedCircularBuffer
   \brief This class stores an fixed number of timestamped items.
   It provides element retrieval based on timestamp, temporal filtering and interpolation, etc.
+
+  Items are added by a single writer at a time (writers lock the buffer). If LockFreeReading is enabled
+  then the UID and filtered timestamp queries do not lock the buffer: they read the state that the writer
+  publishes under a sequence counter (seqlock) and retry if a writer modified it during the read.
   \ingroup PlusLibCommon
 */
 class vtkPlusTimestampedCircularBuffer: public vtkObject
@@ -53,7 +60,7 @@ public:
     have been added to the list).  This will never be greater than
     the BufferSize.
   */
-  vtkGetMacro( NumberOfItems, int );
+  virtual int GetNumberOfItems();
 
   /*!
     Given a timestamp, compute the nearest frame UID
@@ -62,23 +69,10 @@ public:
   virtual ItemStatus GetItemUidFromTime( const double time, BufferItemUidType& uid );
 
   /*! Get the most recent frame UID that is already in the buffer */
-  virtual BufferItemUidType GetLatestItemUidInBuffer()
-  {
-    this->Lock();
-    BufferItemUidType latestUid = this->LatestItemUid;
-    this->Unlock();
-    return latestUid;
-  }
+  virtual BufferItemUidType GetLatestItemUidInBuffer();
 
   /*! Get the oldest frame UID in the buffer  */
-  virtual BufferItemUidType GetOldestItemUidInBuffer()
-  {
-    this->Lock();
-    // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
-    BufferItemUidType oldestUid = this->LatestItemUid - ( this->NumberOfItems - 1 );
-    this->Unlock();
-    return oldestUid;
-  }
+  virtual BufferItemUidType GetOldestItemUidInBuffer();
 
   /*! Get timestamp by frame UID associated with the buffer item  */
   virtual ItemStatus GetLatestTimeStamp( double& timestamp )
@@ -86,17 +80,7 @@ public:
     return this->GetTimeStamp( this->GetLatestItemUidInBuffer(), timestamp );
   }
 
-  virtual ItemStatus GetOldestTimeStamp( double& timestamp )
-  {
-    // The oldest item may be removed from the buffer at any moment
-    // therefore we need to retrieve its UID and timestamp within a single lock
-    this->Lock();
-    // LatestItemUid - ( NumberOfItems - 1 ) is the oldest element in the buffer
-    BufferItemUidType oldestUid = ( this->LatestItemUid - ( this->NumberOfItems - 1 ) );
-    ItemStatus status = this->GetTimeStamp( oldestUid, timestamp );
-    this->Unlock();
-    return status;
-  }
+  virtual ItemStatus GetOldestTimeStamp( double& timestamp );
 
   virtual ItemStatus GetTimeStamp( const BufferItemUidType uid, double& timestamp ) { return this->GetFilteredTimeStamp( uid, timestamp ); }
   virtual ItemStatus GetFilteredTimeStamp( const BufferItemUidType uid, double& filteredTimestamp );
@@ -123,7 +107,7 @@ public:
   virtual void DeepCopy( vtkPlusTimestampedCircularBuffer* buffer );
 
   /*!  Set the local time offset in seconds (global = local + offset) */
-  vtkSetMacro( LocalTimeOffsetSec, double );
+  virtual void SetLocalTimeOffsetSec( double offsetSec );
   /*!  Get the local time offset in seconds (global = local + offset) */
   vtkGetMacro( LocalTimeOffsetSec, double );
 
@@ -166,8 +150,34 @@ public:
   */
   virtual ItemStatus GetBufferItemPointerFromUid( const BufferItemUidType uid, StreamBufferItem*& itemPtr );
 
+  /*!
+    Reserve the next slot for a new item.
+    Fails if the timestamp is not newer than the latest one or if the slot is still pinned by a frame view.
+  */
   virtual PlusStatus PrepareForNewItem( const double timestamp, BufferItemUidType& newFrameUid, int& bufferIndex );
 
+  /*!
+    Pin the buffer item with the given UID: its slot is not recycled by PrepareForNewItem until
+    all pins are released by UnpinBufferIndex. Returns the item pointer and the slot index.
+    Used by StreamBufferItemView, use that class instead of calling this method directly.
+  */
+  virtual ItemStatus PinBufferItem( const BufferItemUidType uid, StreamBufferItem*& itemPtr, int& bufferIndex );
+
+  /*! Add one more pin to a slot that is already pinned (e.g., when a view is copied) */
+  virtual void PinBufferIndex( const int bufferIndex );
+
+  /*! Release one pin of a slot */
+  virtual void UnpinBufferIndex( const int bufferIndex );
+
+  /*! Get the total number of pins that are held on the items of the buffer */
+  virtual int GetNumberOfPins();
+
+  /*!
+    Keep a resource alive until the buffer is deleted. Used for memory that pinned items still refer to
+    when its owner is deleted (item views keep the buffer alive).
+  */
+  void RetainUntilDeleted( const std::shared_ptr<void>& resource );
+
   /*!
     Create filtered and unfiltered timestamp for accurate timing of the buffer item.
     The timing may be inaccurate because the timestamp is attached to the item when Plus receives it
@@ -201,15 +211,103 @@ public:
   /*! Get number of items used for timestamp filtering (with LSQR mimimizer) */
   vtkGetMacro( AveragedItemsForFiltering, int );
 
+  /*!
+    If enabled (default) then the line used for timestamp filtering is computed from running sums that are updated
+    with each new item in constant time. If disabled then the line is fitted to all the averaged items for each new item.
+    The two methods give the same result (up to numerical precision).
+  */
+  vtkSetMacro( IncrementalTimestampFiltering, bool );
+  vtkGetMacro( IncrementalTimestampFiltering, bool );
+  vtkBooleanMacro( IncrementalTimestampFiltering, bool );
+
+  /*!
+    If positive, then items whose unfiltered timestamp differs from the fitted line by more than this value (in seconds)
+    are not used for fitting the line. If most of the recent items are rejected then the fitting is restarted.
+    Default: 0 (outlier rejection is disabled).
+  */
+  vtkSetMacro( TimestampFilteringOutlierThresholdSec, double );
+  vtkGetMacro( TimestampFilteringOutlierThresholdSec, double );
+
   /*! Set recording start time */
   vtkSetMacro( StartTime, double );
   /*! Get recording start time */
   vtkGetMacro( StartTime, double );
 
+  /*!
+    If enabled then UID and filtered timestamp queries do not lock the buffer but validate their reads
+    with a sequence counter. Enabled by default. Disabling it is only useful for comparison.
+  */
+  vtkSetMacro( LockFreeReading, bool );
+  vtkGetMacro( LockFreeReading, bool );
+  vtkBooleanMacro( LockFreeReading, bool );
+
+  /*!
+    If enabled then GetItemUidFromTime predicts the UID from the mean item period and checks only a few items around it,
+    falling back to bisection if the prediction is inaccurate. If disabled then only bisection is used. Enabled by default.
+  */
+  vtkSetMacro( InterpolationSearch, bool );
+  vtkGetMacro( InterpolationSearch, bool );
+  vtkBooleanMacro( InterpolationSearch, bool );
+
 protected:
   vtkPlusTimestampedCircularBuffer();
   ~vtkPlusTimestampedCircularBuffer();
 
+  /*! Filtered timestamps of the buffer items (by buffer index) that can be read without locking the buffer */
+  struct PublishedTimestampArray
+  {
+    int Size;
+    std::atomic<double>* Timestamps;
+  };
+
+  /*!
+    Publish the complete buffer state for lock-free readers: UIDs, number of items, time offset and all timestamps.
+    The caller must have locked the buffer.
+  */
+  void PublishState();
+
+  /*!
+    Publish the state after an item is added at the specified buffer index.
+    The caller must have locked the buffer.
+  */
+  void PublishNewItem( int bufferIndex, double filteredTimestamp );
+
+  /*! Start reading the published state. Returns the sequence number that has to be passed to EndRead. */
+  unsigned int BeginRead();
+
+  /*! Returns true if the published state has not been changed since the corresponding BeginRead call */
+  bool EndRead( unsigned int sequence );
+
+  /*!
+    Delete the timestamp arrays that were replaced by the previous resize. Called before the next resize.
+    The caller must have locked the buffer.
+  */
+  void ReleaseRetiredTimestampArrays();
+
+  /*! Reset the running sums used for incremental timestamp filtering */
+  void ResetFilterSums();
+
+  /*!
+    Recompute the running sums from the samples in the filter containers, relative to the latest sample.
+    This prevents accumulation of rounding errors.
+  */
+  void RecomputeFilterSums( unsigned int latestSampleIndex );
+
+  /*! Compute the parameters of the line (timestamp = framePeriod * itemIndex + timeOffset) fitted to the samples in the filter containers */
+  void GetFilterLineParameters( double& framePeriod, double& timeOffset );
+
+  /*!
+    Compute the nearest item UID from the published state.
+    The caller must either lock the buffer or validate the result with BeginRead/EndRead.
+  */
+  ItemStatus FindPublishedItemUidFromTime( const double time, BufferItemUidType& uid );
+
+  /*!
+    Get the filtered timestamp of an item from the published state.
+    The caller must either lock the buffer or validate the result with BeginRead/EndRead.
+  */
+  ItemStatus GetPublishedFilteredTimeStamp( const BufferItemUidType uid, double& filteredTimestamp );
+
 protected:
   vtkIGSIORecursiveCriticalSection* Mutex;
 
@@ -231,6 +329,36 @@ protected:
 
   std::deque<StreamBufferItem> BufferItemContainer;
 
+  /*! Number of frame views that currently pin each slot of BufferItemContainer (same size as the container) */
+  std::vector<unsigned int> PinCountContainer;
+
+  /*! Sum of all the elements of PinCountContainer */
+  int NumberOfPins;
+
+  /*! Resources that are released after the items, when the buffer is deleted */
+  std::vector< std::shared_ptr<void> > RetainedResources;
+
+  /*! Enables reading UIDs and timestamps without locking the buffer */
+  bool LockFreeReading;
+
+  /*! Enables interpolation search in GetItemUidFromTime */
+  bool InterpolationSearch;
+
+  /*! Sequence counter of the published state, odd while the state is being modified */
+  std::atomic<unsigned int> PublishSequence;
+
+  /*! Copies of LatestItemUid, NumberOfItems, WritePointer and LocalTimeOffsetSec for lock-free readers */
+  std::atomic<BufferItemUidType> PublishedLatestItemUid;
+  std::atomic<int> PublishedNumberOfItems;
+  std::atomic<int> PublishedWritePointer;
+  std::atomic<double> PublishedLocalTimeOffsetSec;
+
+  /*! Current timestamp array for lock-free readers */
+  std::atomic<PublishedTimestampArray*> PublishedTimestamps;
+
+  /*! Timestamp arrays replaced by the last resize. Lock-free readers may still use them, they are deleted at the next resize. */
+  std::vector<PublishedTimestampArray*> RetiredTimestampArrays;
+
   /*! Matrix used for storing the last number of AveragedItemsForFiltering frame index */
   vnl_vector<double> FilterContainerIndexVector;
 
@@ -246,6 +374,29 @@ protected:
   /*! Number of averaged items used for filtering - read from config files */
   unsigned int AveragedItemsForFiltering;
 
+  /*! Use running sums for computing the filtered timestamps */
+  bool IncrementalTimestampFiltering;
+
+  /*!
+    Sums of x, y, x*x and x*y of the samples in the filter containers (x = frame index - FilterReferenceIndex,
+    y = timestamp - FilterReferenceTimestamp). Relative values are used for avoiding loss of precision.
+  */
+  double FilterSumX;
+  double FilterSumY;
+  double FilterSumXX;
+  double FilterSumXY;
+  double FilterReferenceIndex;
+  double FilterReferenceTimestamp;
+
+  /*! Number of samples added since the running sums were last recomputed */
+  unsigned int FilterSamplesSinceRecompute;
+
+  /*! Unfiltered timestamps that differ more than this value from the fitted line are not used for fitting (0 = disabled) */
+  double TimestampFilteringOutlierThresholdSec;
+
+  /*! Number of consecutive samples that were rejected as outliers */
+  unsigned int FilterNumberOfConsecutiveOutliers;
+
   /*!
     Maximum time difference that is allowed between filtered and the non-filtered timestamp (in seconds).
     If the filtered value differs too much from the non-filtered one, then it rejects the filtering result.
@@ -8,6 +8,7 @@ See License.txt for details.
 #include "igsioVideoFrame.h"
 #include "igsioTrackedFrame.h"
 #include "vtkPlusForoughiBoneSurfaceProbability.h"
+#include "vtkPlusSequenceIO.h"
 #include "vtkImageCast.h"
 #include "vtkImageData.h"
 #include "vtkMetaImageReader.h"
@@ -61,7 +62,7 @@ int main(int argc, char** argv)
 
   // Read the image sequence
   vtkSmartPointer<vtkIGSIOTrackedFrameList> trackedFrameList = vtkSmartPointer<vtkIGSIOTrackedFrameList>::New();
-  if( vtkIGSIOSequenceIO::Read(inputImgSeqFileName, trackedFrameList) != PLUS_SUCCESS )
+  if( vtkPlusSequenceIO::Read(inputImgSeqFileName, trackedFrameList) != PLUS_SUCCESS )
   {
     LOG_ERROR("Unable to read sequence file: " << inputImgSeqFileName);
     exit(EXIT_FAILURE);
@@ -57,17 +57,11 @@ See License.txt for details.
 namespace
 {
   const double DELAY_ON_SENDING_ERROR_SEC = 0.02;
-  const double DELAY_ON_NO_NEW_FRAMES_SEC = 0.005;
+  const double DELAY_ON_NO_NEW_FRAMES_SEC = 0.005; // maximum time to wait for new data, command responses and keep-alive messages are processed in between
   const int NUMBER_OF_RECENT_COMMAND_IDS_STORED = 10;
   const int IGTL_EMPTY_DATA_SIZE = -1;
   const double SERVER_START_CHECK_DELAY_SEC = 2.0;
   const double SERVER_START_CHECK_DELAY_INTERVAL_SEC = 0.05;
-
-  //----------------------------------------------------------------------------
-  // If a frame cannot be retrieved from the device buffers (because it was overwritten by new frames)
-  // then we skip a SAMPLING_SKIPPING_MARGIN_SEC long period to allow the application to catch up.
-  // This time should be long enough to comfortably retrieve a frame from the buffer.
-  const double SAMPLING_SKIPPING_MARGIN_SEC = 0.1;
 }
 
 //----------------------------------------------------------------------------
@@ -92,7 +86,6 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , DataSenderThreadId(-1)
   , IgtlMessageFactory(vtkSmartPointer<vtkPlusIgtlMessageFactory>::New())
   , IgtlClientsMutex(vtkSmartPointer<vtkIGSIORecursiveCriticalSection>::New())
-  , LastSentTrackedFrameTimestamp(0)
   , MaxTimeSpentWithProcessingMs(50)
   , LastProcessingTimePerFrameMs(-1)
   , SendValidTransformsOnly(true)
@@ -102,6 +95,8 @@ vtkPlusOpenIGTLinkServer::vtkPlusOpenIGTLinkServer()
   , PlusCommandProcessor(vtkSmartPointer<vtkPlusCommandProcessor>::New())
   , MessageResponseQueueMutex(vtkSmartPointer<vtkIGSIORecursiveCriticalSection>::New())
   , BroadcastChannel(NULL)
+  , BroadcastDataNotifier(vtkSmartPointer<vtkPlusNewDataNotifier>::New())
+  , LastBroadcastDataSequenceNumber(0)
   , LogWarningOnNoDataAvailable(true)
   , KeepAliveIntervalSec(CLIENT_SOCKET_TIMEOUT_SEC / 2.0)
   , GracePeriodLogLevel(vtkPlusLogger::LOG_LEVEL_DEBUG)
@@ -350,7 +345,10 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
   self->BroadcastChannel = aChannel;
   if (self->BroadcastChannel)
   {
-    self->BroadcastChannel->GetMostRecentTimestamp(self->LastSentTrackedFrameTimestamp);
+    self->BroadcastChannel->Subscribe(self->BroadcastCursor);
+    // Wake up as soon as new data is available instead of polling the channel
+    self->LastBroadcastDataSequenceNumber = self->BroadcastDataNotifier->GetSequenceNumber();
+    self->BroadcastChannel->AddNewDataNotifier(self->BroadcastDataNotifier);
   }
 
   double elapsedTimeSinceLastPacketSentSec = 0;
@@ -368,7 +366,7 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
     {
       // No client connected, wait for a while
       vtkIGSIOAccurateTimer::Delay(0.2);
-      self->LastSentTrackedFrameTimestamp = 0; // next time start sending from the most recent timestamp
+      self->BroadcastCursor = vtkPlusChannel::ReadCursor(); // next time start sending from the most recent frame
       continue;
     }
 
@@ -386,6 +384,10 @@ void* vtkPlusOpenIGTLinkServer::DataSenderThread(vtkMultiThreader::ThreadInfo* d
     SendLatestFramesToClients(*self, elapsedTimeSinceLastPacketSentSec);
   }
   // Close thread
+  if (self->BroadcastChannel)
+  {
+    self->BroadcastChannel->RemoveNewDataNotifier(self->BroadcastDataNotifier);
+  }
   self->DataSenderThreadId = -1;
   self->DataSenderActive.Respond = false;
   return NULL;
@@ -420,25 +422,25 @@ PlusStatus vtkPlusOpenIGTLinkServer::SendLatestFramesToClients(vtkPlusOpenIGTLin
     }
     else
     {
-      double oldestDataTimestamp = 0;
-      if (self.BroadcastChannel->GetOldestTimestamp(oldestDataTimestamp) == PLUS_SUCCESS)
-      {
-        if (self.LastSentTrackedFrameTimestamp < oldestDataTimestamp)
-        {
-          LOG_INFO("OpenIGTLink broadcasting started. No data was available between " << self.LastSentTrackedFrameTimestamp << "-" << oldestDataTimestamp << "sec, therefore no data were broadcasted during this time period.");
-          self.LastSentTrackedFrameTimestamp = oldestDataTimestamp + SAMPLING_SKIPPING_MARGIN_SEC;
-        }
-        static vtkIGSIOLogHelper logHelper(60.0, 500000);
-        CUSTOM_RETURN_WITH_FAIL_IF(self.BroadcastChannel->GetTrackedFrameList(self.LastSentTrackedFrameTimestamp, trackedFrameList, numberOfFramesToGet) != PLUS_SUCCESS,
-                                   "Failed to get tracked frame list from data collector (last recorded timestamp: " << std::fixed << self.LastSentTrackedFrameTimestamp);
-      }
+      // The cursor skips frames that have been removed from the buffers, so the broadcast always continues with available data
+      static vtkIGSIOLogHelper logHelper(60.0, 500000);
+      CUSTOM_RETURN_WITH_FAIL_IF(self.BroadcastChannel->GetTrackedFrameList(self.BroadcastCursor, trackedFrameList, numberOfFramesToGet) != PLUS_SUCCESS,
+                                 "Failed to get tracked frame list from data collector (last recorded timestamp: " << std::fixed << self.BroadcastCursor.LastConsumedTimestamp);
     }
   }
 
   // There is no new frame in the buffer
   if (trackedFrameList->GetNumberOfTrackedFrames() == 0)
   {
-    vtkIGSIOAccurateTimer::Delay(DELAY_ON_NO_NEW_FRAMES_SEC);
+    if (self.BroadcastChannel != NULL)
+    {
+      // Returns immediately if data has been added since the last check, otherwise sleeps until data is added
+      self.BroadcastDataNotifier->WaitForNewData(self.LastBroadcastDataSequenceNumber, DELAY_ON_NO_NEW_FRAMES_SEC);
+    }
+    else
+    {
+      vtkIGSIOAccurateTimer::Delay(DELAY_ON_NO_NEW_FRAMES_SEC);
+    }
     elapsedTimeSinceLastPacketSentSec += vtkIGSIOAccurateTimer::GetSystemTime() - startTimeSec;
 
     // Send keep alive packet to clients
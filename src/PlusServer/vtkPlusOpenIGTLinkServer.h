@@ -12,6 +12,7 @@
 #include "PlusIgtlClientInfo.h"
 #include "vtkPlusDataCollector.h"
 #include "vtkPlusIgtlMessageFactory.h"
+#include "vtkPlusNewDataNotifier.h"
 #include "vtkIGSIOTransformRepository.h"
 
 // VTK includes
@@ -279,8 +280,8 @@ private:
   /*! Mutex instance for accessing client data list */
   vtkSmartPointer<vtkIGSIORecursiveCriticalSection> IgtlClientsMutex;
 
-  /*! Last sent tracked frame timestamp */
-  double LastSentTrackedFrameTimestamp;
+  /*! Read position of the broadcasting in the broadcast channel */
+  vtkPlusChannel::ReadCursor BroadcastCursor;
 
   /*! Maximum time spent with processing (getting tracked frames, sending messages) per second (in milliseconds) */
   int MaxTimeSpentWithProcessingMs;
@@ -318,6 +319,12 @@ private:
   /*! Channel to use for broadcasting */
   vtkPlusChannel* BroadcastChannel;
 
+  /*! Notified when new data is added to the broadcast channel, allows the data sender thread to sleep until new data arrives */
+  vtkSmartPointer<vtkPlusNewDataNotifier> BroadcastDataNotifier;
+
+  /*! Sequence number of the broadcast data notifier when the data sender thread last checked for new data */
+  unsigned long long LastBroadcastDataSequenceNumber;
+
   bool LogWarningOnNoDataAvailable;
 
   double KeepAliveIntervalSec;
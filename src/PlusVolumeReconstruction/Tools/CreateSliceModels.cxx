@@ -27,9 +27,9 @@
 #include "vtkXMLUtilities.h"
 
 #include "igsioTrackedFrame.h"
-#include "vtkIGSIOSequenceIO.h"
 #include "vtkIGSIOTrackedFrameList.h"
 #include "vtkIGSIOTransformRepository.h"
+#include "vtkPlusSequenceIO.h"
 #include "vtkPlusVolumeReconstructor.h"
 
 
@@ -83,7 +83,7 @@ int main( int argc, char** argv )
   // Read input tracked ultrasound data.
   LOG_DEBUG( "Reading input... " );
   vtkSmartPointer< vtkIGSIOTrackedFrameList > trackedFrameList = vtkSmartPointer< vtkIGSIOTrackedFrameList >::New();
-  if( vtkIGSIOSequenceIO::Read( inputMetaFilename, trackedFrameList ) != PLUS_SUCCESS )
+  if( vtkPlusSequenceIO::Read( inputMetaFilename, trackedFrameList ) != PLUS_SUCCESS )
   {
     LOG_ERROR( "Unable to load input sequences file." );
     exit( EXIT_FAILURE );